@@ -24,11 +24,13 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
+
 #include <QApplication>
 
 #include "BrainModelAlgorithm.h"
 #include "BrainModelAlgorithmMultiThreadExecutor.h"
-#include "BrainModelAlgorithmRunAsThread.h"
+#include "BrainModelAlgorithmThreadPool.h"
 
 /**
  * constructor.
@@ -54,7 +56,9 @@ BrainModelAlgorithmMultiThreadExecutor::BrainModelAlgorithmMultiThreadExecutor()
 }
 
 /**
- * start executing the threads.
+ * start executing the algorithms.  The algorithms are run by the
+ * process-wide thread pool with at most "numberOfThreadsToRun" of them
+ * submitted at any time.
  */
 void 
 BrainModelAlgorithmMultiThreadExecutor::startExecution()
@@ -68,105 +72,76 @@ BrainModelAlgorithmMultiThreadExecutor::startExecution()
    }
    int nextAlgorithmToRun = 0;
    
-   //
-   // Pointers for algorithm threads
-   //
-   std::vector<BrainModelAlgorithmRunAsThread*> algorithmThreads(numberOfThreadsToRun);
-   for (int i = 0; i < numberOfThreadsToRun; i++) {
-      algorithmThreads[i] = NULL;
-   }
+   BrainModelAlgorithmThreadPool* threadPool =
+      BrainModelAlgorithmThreadPool::getThreadPool(numberOfThreadsToRun);
    
    //
-   // Time to wait for a thread
+   // Tasks submitted to the pool that have not been collected
    //
-   const unsigned long threadWaitTimeInMilliseconds = 5;
+   std::vector<BrainModelAlgorithmThreadPool::Task*> runningTasks;
    
    //
-   // Loop for creating and executing threads
+   // Longest time to go without processing events
    //
+   const int eventWaitTimeInMilliseconds = 50;
+   
    bool done = false;
    while (done == false) {
       //
-      // Loop through threads to see if any are done and create new threads
+      // Keep the pool supplied with algorithms
       //
-      for (int iThread = 0; iThread < numberOfThreadsToRun; iThread++) {
+      while ((nextAlgorithmToRun < numAlgorithmsToRun) &&
+             (static_cast<int>(runningTasks.size()) < numberOfThreadsToRun)) {
          //
-         // Is thread valid ?
+         // Task does not delete the algorithm
          //
-         if (algorithmThreads[iThread] != NULL) {
-            //
-            // Wait on the thread
-            //
-            algorithmThreads[iThread]->wait(threadWaitTimeInMilliseconds);
-            
-            //
-            // Is thread finished ?
-            //
-            if (algorithmThreads[iThread]->isFinished()) {
-               //
-               // Get any error message
-               //
-               if (algorithmThreads[iThread]->getAlgorithmThrewAnException()) {
-                  exceptionMessages.push_back(algorithmThreads[iThread]->getExceptionErrorMessage());
-                  
-                  //
-                  // Should execution stop ?
-                  //
-                  if (stopIfAlogorithmThrowsException) {
-                     nextAlgorithmToRun = numAlgorithmsToRun;
-                  }
-               }
-
-               //
-               // delete the thread (does not delete the algorithm)
-               //
-               delete algorithmThreads[iThread];
-               algorithmThreads[iThread] = NULL;
-            }
-         }
+         BrainModelAlgorithmThreadPool::Task* task =
+            new BrainModelAlgorithmThreadPool::Task(algorithms[nextAlgorithmToRun],
+                                                    false);
+         threadPool->submit(task);
+         runningTasks.push_back(task);
          
          //
-         // Is thread available
+         // Inform caller of algorithm description
          //
-         if (algorithmThreads[iThread] == NULL) {
-            //
-            // Are there algorithms that still need to run ?
-            //
-            if (nextAlgorithmToRun < numAlgorithmsToRun) {
-               //
-               // Create the new thread and start it
-               //
-               algorithmThreads[iThread] = 
-                  new BrainModelAlgorithmRunAsThread(algorithms[nextAlgorithmToRun],
-                                                     false);
-               algorithmThreads[iThread]->start(QThread::HighestPriority);
-               
-               //
-               // Inform caller of algorithm description
-               //
-               const QString s = algorithms[nextAlgorithmToRun]->getTextDescription();
-               if (s.isEmpty() == false) {
-                  emit algorithmStartedDescription(s);
-               }
-               
-               //
-               // Increment to next algorithm
-               //
-               nextAlgorithmToRun++;
-            }
+         const QString s = algorithms[nextAlgorithmToRun]->getTextDescription();
+         if (s.isEmpty() == false) {
+            emit algorithmStartedDescription(s);
          }
-      } // for (iThread
+         
+         //
+         // Increment to next algorithm
+         //
+         nextAlgorithmToRun++;
+      }
       
       //
-      // Loop through the threads to see if any are still valid and if time to stop
+      // Wakes as soon as any algorithm finishes
       //
-      done = true;
-      for (int iThread = 0; iThread < numberOfThreadsToRun; iThread++) {
-         if (algorithmThreads[iThread] != NULL) {
-            done = false;
+      BrainModelAlgorithmThreadPool::Task* finishedTask =
+         threadPool->waitForAnyTask(runningTasks, eventWaitTimeInMilliseconds);
+      if (finishedTask != NULL) {
+         //
+         // Get any error message
+         //
+         if (finishedTask->getAlgorithmThrewAnException()) {
+            exceptionMessages.push_back(finishedTask->getExceptionErrorMessage());
+            
+            //
+            // Should execution stop ?
+            //
+            if (stopIfAlogorithmThrowsException) {
+               nextAlgorithmToRun = numAlgorithmsToRun;
+            }
          }
+         
+         runningTasks.erase(std::find(runningTasks.begin(), runningTasks.end(), finishedTask));
+         delete finishedTask;
       }
-
+      
+      done = (runningTasks.empty() &&
+              (nextAlgorithmToRun >= numAlgorithmsToRun));
+      
       //
       // Allow other events to process
       //
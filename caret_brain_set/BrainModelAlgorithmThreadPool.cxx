@@ -0,0 +1,415 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+#include <exception>
+
+#include <QMutexLocker>
+#include <QReadLocker>
+#include <QTime>
+#include <QWriteLocker>
+
+#include "BrainModelAlgorithm.h"
+#define __BRAIN_MODEL_ALGORITHM_THREAD_POOL_MAIN__
+#include "BrainModelAlgorithmThreadPool.h"
+#undef __BRAIN_MODEL_ALGORITHM_THREAD_POOL_MAIN__
+#include "SystemUtilities.h"
+
+/**
+ * task constructor.
+ */
+BrainModelAlgorithmThreadPool::Task::Task(BrainModelAlgorithm* algorithmToRunIn,
+                                          const bool deleteBrainModelAlgorithmInDestructorFlagIn)
+{
+   algorithmToRun = algorithmToRunIn;
+   deleteBrainModelAlgorithmInDestructorFlag = deleteBrainModelAlgorithmInDestructorFlagIn;
+   exceptionThrownFlag = false;
+   exceptionMessage = "";
+   finishedFlag = false;
+}
+
+/**
+ * task destructor.
+ */
+BrainModelAlgorithmThreadPool::Task::~Task()
+{
+   if (deleteBrainModelAlgorithmInDestructorFlag) {
+      delete algorithmToRun;
+      algorithmToRun = NULL;
+   }
+}
+
+/**
+ * runs the task (default executes the algorithm).
+ */
+void 
+BrainModelAlgorithmThreadPool::Task::run()
+{
+   if (algorithmToRun == NULL) {
+      throw BrainModelAlgorithmException("PROGRAM ERROR: Algorithm passed to task was NULL");
+   }
+   algorithmToRun->execute();
+}
+
+/**
+ * constructor.
+ */
+BrainModelAlgorithmThreadPool::BrainModelAlgorithmThreadPool(const int numberOfThreads)
+{
+   numberOfQueuedTasks = 0;
+   nextQueueForSubmit = 0;
+   stopThreadsFlag = false;
+   
+   addThreads(std::max(numberOfThreads, 1));
+}
+
+/**
+ * destructor.
+ */
+BrainModelAlgorithmThreadPool::~BrainModelAlgorithmThreadPool()
+{
+   {
+      QMutexLocker locker(&stateMutex);
+      stopThreadsFlag = true;
+      taskSubmittedCondition.wakeAll();
+   }
+   for (unsigned int i = 0; i < workerThreads.size(); i++) {
+      workerThreads[i]->wait();
+      delete workerThreads[i];
+   }
+   for (unsigned int i = 0; i < taskQueueMutexes.size(); i++) {
+      delete taskQueueMutexes[i];
+   }
+}
+
+/**
+ * get the thread pool (created on first call).  The pool is never
+ * deleted, its threads sleep while there are no tasks.  If the pool has
+ * fewer than "minimumNumberOfThreads" threads, threads are added so that
+ * a caller asking for more threads than the pool was created with gets them.
+ */
+BrainModelAlgorithmThreadPool* 
+BrainModelAlgorithmThreadPool::getThreadPool(const int minimumNumberOfThreads)
+{
+   static QMutex createMutex;
+   QMutexLocker locker(&createMutex);
+   
+   if (threadPool == NULL) {
+      int num = numberOfThreadsForPool;
+      if (num <= 0) {
+         //
+         // Not set on command line or in preferences so one per processor
+         //
+         num = SystemUtilities::getNumberOfProcessors();
+      }
+      threadPool = new BrainModelAlgorithmThreadPool(num);
+   }
+   threadPool->addThreads(minimumNumberOfThreads);
+   return threadPool;
+}
+
+/**
+ * add threads until the pool has the number of threads.
+ */
+void 
+BrainModelAlgorithmThreadPool::addThreads(const int numberOfThreads)
+{
+   std::vector<WorkerThread*> newThreads;
+   {
+      QWriteLocker locker(&threadsLock);
+      const int oldNumberOfThreads = static_cast<int>(workerThreads.size());
+      if (numberOfThreads <= oldNumberOfThreads) {
+         return;
+      }
+      taskQueues.resize(numberOfThreads);
+      for (int i = oldNumberOfThreads; i < numberOfThreads; i++) {
+         taskQueueMutexes.push_back(new QMutex);
+         workerThreads.push_back(new WorkerThread(this, i));
+         newThreads.push_back(workerThreads[i]);
+      }
+   }
+   
+   for (unsigned int i = 0; i < newThreads.size(); i++) {
+      newThreads[i]->start();
+   }
+}
+
+/**
+ * get the number of threads in the pool.
+ */
+int 
+BrainModelAlgorithmThreadPool::getNumberOfThreads() const
+{
+   QReadLocker locker(&threadsLock);
+   return static_cast<int>(workerThreads.size());
+}
+
+/**
+ * set the number of threads (command line, overrides preferences).
+ * Has no effect once the pool has been created.
+ */
+void 
+BrainModelAlgorithmThreadPool::setNumberOfThreads(const int numberOfThreadsIn)
+{
+   numberOfThreadsForPool = numberOfThreadsIn;
+   numberOfThreadsSetOnCommandLine = true;
+}
+
+/**
+ * set the number of threads from the preferences file, zero uses one 
+ * thread per processor.
+ * Has no effect if set on the command line or once the pool has been created.
+ */
+void 
+BrainModelAlgorithmThreadPool::setNumberOfThreadsFromPreferences(const int numberOfThreadsIn)
+{
+   if (numberOfThreadsSetOnCommandLine == false) {
+      numberOfThreadsForPool = numberOfThreadsIn;
+   }
+}
+
+/**
+ * index of the calling thread if it is a worker, else -1.
+ */
+int 
+BrainModelAlgorithmThreadPool::getCurrentWorkerIndex() const
+{
+   const QThread* currentThread = QThread::currentThread();
+   QReadLocker locker(&threadsLock);
+   for (unsigned int i = 0; i < workerThreads.size(); i++) {
+      if (workerThreads[i] == currentThread) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+/**
+ * submit a task for execution.  A task submitted from a worker thread is
+ * placed in that thread's queue, others are distributed among the queues.
+ */
+void 
+BrainModelAlgorithmThreadPool::submit(Task* task)
+{
+   int queueIndex = getCurrentWorkerIndex();
+   QReadLocker threadsLocker(&threadsLock);
+   {
+      QMutexLocker locker(&stateMutex);
+      task->finishedFlag = false;
+      if (queueIndex < 0) {
+         queueIndex = nextQueueForSubmit;
+         nextQueueForSubmit = (nextQueueForSubmit + 1) % static_cast<int>(workerThreads.size());
+      }
+   }
+   
+   {
+      QMutexLocker locker(taskQueueMutexes[queueIndex]);
+      taskQueues[queueIndex].push_back(task);
+   }
+   
+   QMutexLocker locker(&stateMutex);
+   numberOfQueuedTasks++;
+   taskSubmittedCondition.wakeOne();
+}
+
+/**
+ * take a task from the front of a thread's queue, or if that queue is
+ * empty, steal one from the back of another thread's queue.
+ */
+BrainModelAlgorithmThreadPool::Task* 
+BrainModelAlgorithmThreadPool::takeTask(const int threadIndex)
+{
+   QReadLocker threadsLocker(&threadsLock);
+   const int numQueues = static_cast<int>(taskQueues.size());
+   const int firstQueue = std::max(threadIndex, 0);
+   
+   Task* task = NULL;
+   for (int i = 0; (i < numQueues) && (task == NULL); i++) {
+      const int queueIndex = (firstQueue + i) % numQueues;
+      QMutexLocker locker(taskQueueMutexes[queueIndex]);
+      std::deque<Task*>& queue = taskQueues[queueIndex];
+      if (queue.empty() == false) {
+         if (queueIndex == threadIndex) {
+            task = queue.front();
+            queue.pop_front();
+         }
+         else {
+            task = queue.back();
+            queue.pop_back();
+         }
+      }
+   }
+   threadsLocker.unlock();
+   
+   if (task != NULL) {
+      QMutexLocker locker(&stateMutex);
+      numberOfQueuedTasks--;
+   }
+   return task;
+}
+
+/**
+ * run a task and mark it finished.  Exceptions are saved in the task
+ * so that they may be passed on to the thread waiting for the task.
+ */
+void 
+BrainModelAlgorithmThreadPool::runTask(Task* task)
+{
+   bool exceptionFlag = false;
+   QString message;
+   try {
+      task->run();
+   }
+   catch (BrainModelAlgorithmException& e) {
+      exceptionFlag = true;
+      message = e.whatQString();
+   }
+   catch (std::exception& e) {
+      exceptionFlag = true;
+      message = e.what();
+   }
+   catch (...) {
+      exceptionFlag = true;
+      message = "Unknown exception thrown by algorithm running in thread pool.";
+   }
+   
+   //
+   // Once finished is set, the task may be deleted by its owner
+   //
+   QMutexLocker locker(&stateMutex);
+   task->exceptionThrownFlag = exceptionFlag;
+   task->exceptionMessage = message;
+   task->finishedFlag = true;
+   taskFinishedCondition.wakeAll();
+}
+
+/**
+ * loop run by each worker thread.
+ */
+void 
+BrainModelAlgorithmThreadPool::workerLoop(const int threadIndex)
+{
+   while (true) {
+      Task* task = takeTask(threadIndex);
+      if (task != NULL) {
+         runTask(task);
+         continue;
+      }
+      
+      QMutexLocker locker(&stateMutex);
+      if (stopThreadsFlag) {
+         break;
+      }
+      if (numberOfQueuedTasks <= 0) {
+         taskSubmittedCondition.wait(&stateMutex);
+      }
+   }
+}
+
+/**
+ * wait for a task to finish, returns false if timed out (negative timeout 
+ * waits forever).  If called from a worker thread, the worker runs other
+ * queued tasks while it waits so that tasks may wait on tasks they submit.
+ */
+bool 
+BrainModelAlgorithmThreadPool::waitForTask(Task* task,
+                                           const int timeoutInMilliseconds)
+{
+   std::vector<Task*> tasks(1, task);
+   return (waitForAnyTask(tasks, timeoutInMilliseconds) != NULL);
+}
+
+/**
+ * wait for a task and throw an exception if the task threw one.
+ */
+void 
+BrainModelAlgorithmThreadPool::waitForTaskAndRethrow(Task* task) throw (BrainModelAlgorithmException)
+{
+   waitForTask(task);
+   if (task->getAlgorithmThrewAnException()) {
+      throw BrainModelAlgorithmException(task->getExceptionErrorMessage());
+   }
+}
+
+/**
+ * wait for any of the tasks to finish, returns NULL if timed out
+ * (negative timeout waits forever).
+ */
+BrainModelAlgorithmThreadPool::Task* 
+BrainModelAlgorithmThreadPool::waitForAnyTask(const std::vector<Task*>& tasks,
+                                              const int timeoutInMilliseconds)
+{
+   const int workerIndex = getCurrentWorkerIndex();
+   QTime timer;
+   timer.start();
+   
+   while (true) {
+      {
+         QMutexLocker locker(&stateMutex);
+         for (unsigned int i = 0; i < tasks.size(); i++) {
+            if (tasks[i]->finishedFlag) {
+               return tasks[i];
+            }
+         }
+      }
+      
+      //
+      // A worker helps rather than blocking so the pool cannot deadlock
+      //
+      if (workerIndex >= 0) {
+         Task* otherTask = takeTask(workerIndex);
+         if (otherTask != NULL) {
+            runTask(otherTask);
+            continue;
+         }
+      }
+      
+      QMutexLocker locker(&stateMutex);
+      bool anyFinished = false;
+      for (unsigned int i = 0; i < tasks.size(); i++) {
+         if (tasks[i]->finishedFlag) {
+            anyFinished = true;
+         }
+      }
+      if (anyFinished) {
+         continue;
+      }
+      if ((workerIndex >= 0) && (numberOfQueuedTasks > 0)) {
+         continue;
+      }
+      
+      if (timeoutInMilliseconds < 0) {
+         taskFinishedCondition.wait(&stateMutex);
+      }
+      else {
+         const int remaining = timeoutInMilliseconds - timer.elapsed();
+         if (remaining <= 0) {
+            return NULL;
+         }
+         taskFinishedCondition.wait(&stateMutex, remaining);
+      }
+   }
+}
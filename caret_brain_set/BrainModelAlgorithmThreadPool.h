@@ -0,0 +1,213 @@
+#ifndef __BRAIN_MODEL_ALGORITHM_THREAD_POOL_H__
+#define __BRAIN_MODEL_ALGORITHM_THREAD_POOL_H__
+
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <deque>
+#include <vector>
+
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "BrainModelAlgorithmException.h"
+
+class BrainModelAlgorithm;
+
+/// Process-wide pool of persistent threads for running brain model algorithms.
+/// Each thread has its own queue of tasks, and a thread whose queue is empty 
+/// steals tasks from the other threads' queues.  The initial number of threads
+/// is set from the command line or the preferences file before the pool is
+/// first used, and the pool grows when a caller asks for more threads.
+class BrainModelAlgorithmThreadPool {
+   public:
+      /// A task that is run by the thread pool.  After submitting a task,
+      /// use the pool's wait methods to wait for it to finish (like a future),
+      /// then check for an exception.  The task is owned by the caller and 
+      /// must not be deleted until it has finished.
+      class Task {
+         public:
+            // constructor
+            Task(BrainModelAlgorithm* algorithmToRunIn,
+                 const bool deleteBrainModelAlgorithmInDestructorFlagIn);
+            
+            // destructor
+            virtual ~Task();
+            
+            /// call after task finishes to see if an exception occurred during execution
+            bool getAlgorithmThrewAnException() const { return exceptionThrownFlag; }
+            
+            /// get the exception error message
+            QString getExceptionErrorMessage() const { return exceptionMessage; }
+            
+            /// get the algorithm
+            BrainModelAlgorithm* getBrainModelAlgorithm() { return algorithmToRun; }
+            
+            /// get the algorithm (const method)
+            const BrainModelAlgorithm* getBrainModelAlgorithm() const { return algorithmToRun; }
+            
+         protected:
+            // runs the task (default executes the algorithm)
+            virtual void run();
+            
+            /// the algorithm that is to be run
+            BrainModelAlgorithm* algorithmToRun;
+            
+            /// delete the brain model algorithm in the destructor
+            bool deleteBrainModelAlgorithmInDestructorFlag;
+            
+         private:
+            /// will get set if task throws an exception
+            bool exceptionThrownFlag;
+            
+            /// will get set if task throws an exception
+            QString exceptionMessage;
+            
+            /// set when task is finished (protected by the pool's mutex)
+            bool finishedFlag;
+            
+         friend class BrainModelAlgorithmThreadPool;
+      };
+      
+      // get the thread pool (created on first call), grown to at least the number of threads
+      static BrainModelAlgorithmThreadPool* getThreadPool(const int minimumNumberOfThreads = 0);
+      
+      // set the number of threads (command line, overrides preferences)
+      static void setNumberOfThreads(const int numberOfThreadsIn);
+      
+      // set the number of threads from the preferences file
+      static void setNumberOfThreadsFromPreferences(const int numberOfThreadsIn);
+      
+      // get the number of threads in the pool
+      int getNumberOfThreads() const;
+      
+      // submit a task for execution
+      void submit(Task* task);
+      
+      // wait for a task to finish, returns false if timed out (negative timeout waits forever)
+      bool waitForTask(Task* task,
+                       const int timeoutInMilliseconds = -1);
+      
+      // wait for a task and throw an exception if the task threw one
+      void waitForTaskAndRethrow(Task* task) throw (BrainModelAlgorithmException);
+      
+      // wait for any of the tasks to finish, returns NULL if timed out
+      Task* waitForAnyTask(const std::vector<Task*>& tasks,
+                           const int timeoutInMilliseconds = -1);
+      
+   protected:
+      /// persistent thread of the pool
+      class WorkerThread : public QThread {
+         public:
+            /// constructor
+            WorkerThread(BrainModelAlgorithmThreadPool* poolIn,
+                         const int threadIndexIn) 
+               : pool(poolIn), threadIndex(threadIndexIn) { }
+            
+         protected:
+            /// take tasks until the pool is destroyed
+            void run() { pool->workerLoop(threadIndex); }
+            
+            /// the pool
+            BrainModelAlgorithmThreadPool* pool;
+            
+            /// index of this thread and its queue
+            int threadIndex;
+      };
+      
+      // constructor
+      BrainModelAlgorithmThreadPool(const int numberOfThreads);
+      
+      // destructor
+      ~BrainModelAlgorithmThreadPool();
+      
+      // add threads until the pool has the number of threads
+      void addThreads(const int numberOfThreads);
+      
+      // loop run by each worker thread
+      void workerLoop(const int threadIndex);
+      
+      // take a task from a queue, stealing from the other queues if empty
+      Task* takeTask(const int threadIndex);
+      
+      // run a task and mark it finished
+      void runTask(Task* task);
+      
+      // index of the calling thread if it is a worker, else -1
+      int getCurrentWorkerIndex() const;
+      
+      /// the worker threads
+      std::vector<WorkerThread*> workerThreads;
+      
+      /// one queue of tasks per thread
+      std::vector<std::deque<Task*> > taskQueues;
+      
+      /// one mutex per queue of tasks
+      std::vector<QMutex*> taskQueueMutexes;
+      
+      /// written while threads are added, read while using the threads and queues
+      mutable QReadWriteLock threadsLock;
+      
+      /// mutex for number of queued tasks, finished flags, and stop flag
+      QMutex stateMutex;
+      
+      /// signaled when a task is submitted
+      QWaitCondition taskSubmittedCondition;
+      
+      /// signaled when a task finishes
+      QWaitCondition taskFinishedCondition;
+      
+      /// number of tasks in all of the queues
+      int numberOfQueuedTasks;
+      
+      /// queue that receives the next task submitted by a non-worker thread
+      int nextQueueForSubmit;
+      
+      /// set when threads should exit
+      bool stopThreadsFlag;
+      
+      /// the pool
+      static BrainModelAlgorithmThreadPool* threadPool;
+      
+      /// number of threads for pool
+      static int numberOfThreadsForPool;
+      
+      /// number of threads was set on command line
+      static bool numberOfThreadsSetOnCommandLine;
+      
+   friend class WorkerThread;
+};
+
+#ifdef __BRAIN_MODEL_ALGORITHM_THREAD_POOL_MAIN__
+BrainModelAlgorithmThreadPool* BrainModelAlgorithmThreadPool::threadPool = NULL;
+int BrainModelAlgorithmThreadPool::numberOfThreadsForPool = 0;
+bool BrainModelAlgorithmThreadPool::numberOfThreadsSetOnCommandLine = false;
+#endif // __BRAIN_MODEL_ALGORITHM_THREAD_POOL_MAIN__
+
+#endif // __BRAIN_MODEL_ALGORITHM_THREAD_POOL_H__
@@ -26,6 +26,20 @@
 
 static const bool timingFlag = false;
 
+/**
+ * Apply the Fisher Z-Transform to a correlation coefficient.
+ */
+static inline float
+fisherZTransform(const float r)
+{
+   const double tinyValue = 1.0e-20;
+   float denom = (1.0 - r);
+   if (denom != 0.0) {
+      return 0.5 * std::log((1.0 + r) / denom);
+   }
+   return 0.5 * std::log((1.0 + r) / tinyValue);
+}
+
 /**
  * constructor.
  */ 
@@ -42,6 +56,30 @@ BrainModelCiftiCorrelationMatrix::BrainModelCiftiCorrelationMatrix(
    this->initialize();
 }
 
+/**
+ * constructor for streaming output.  Instead of holding the entire
+ * output matrix in memory, rows of the output matrix are computed
+ * "rowBlockSize" at a time and appended to the output file, so memory
+ * use depends upon the block size rather than the square of the number
+ * of rows.
+ */ 
+BrainModelCiftiCorrelationMatrix::BrainModelCiftiCorrelationMatrix(
+                                                BrainSet* bs,
+                                                CiftiFile* inputCiftiFile,
+                                                const QString& outputCiftiFileName,
+                                                const long rowBlockSize,
+                                                const bool applyFisherZTransformFlag,
+                                                const bool parallelFlag)
+   : BrainModelAlgorithm(bs),
+     m_inputCiftiFile(inputCiftiFile),
+     m_outputCiftiFileName(outputCiftiFileName),
+     m_applyFisherZTransformFlag(applyFisherZTransformFlag),
+     m_parallelFlag(parallelFlag)
+{
+   this->initialize();
+   this->m_rowBlockSize = std::max(rowBlockSize, 1L);
+}
+
 /**
  * destructor.
  */ 
@@ -61,6 +99,9 @@ BrainModelCiftiCorrelationMatrix::~BrainModelCiftiCorrelationMatrix()
    if (this->m_rowSumSquared != NULL) {
       delete[] this->m_rowSumSquared;
    }
+   if (this->m_normalizedDataValues != NULL) {
+      delete[] this->m_normalizedDataValues;
+   }
 }
 
 /**
@@ -75,6 +116,8 @@ BrainModelCiftiCorrelationMatrix::initialize()
    this->m_rowMeans = NULL;
    this->m_rowSumSquared = NULL;
    this->m_nextRowToProcess = -1;
+   this->m_rowBlockSize = 0;
+   this->m_normalizedDataValues = NULL;
 }
       
 /**
@@ -102,6 +145,29 @@ BrainModelCiftiCorrelationMatrix::execute() throw (BrainModelAlgorithmException)
             "Input Cifti file is empty: " );
       //+            this->m_inputCiftiFile->getFileName());
    }
+   
+   if (this->m_outputCiftiFileName.isEmpty() == false) {
+      this->m_outputDimension = this->m_inputNumRows;
+      this->loadNormalizedDataValues();
+      if (timingFlag) {
+         std::cout << "Loaded and normalized data values in "
+                   << (loadTimer.elapsed() * 0.001)
+                   << " seconds."
+                   << std::endl;
+      }
+      
+      QTime corrTimer;
+      corrTimer.start();
+      this->computeAndWriteCorrelationBlocks();
+      if (timingFlag) {
+         std::cout << "Computed and wrote correlations in "
+                   << (corrTimer.elapsed() * 0.001)
+                   << " seconds."
+                   << std::endl;
+      }
+      return;
+   }
+   
    this->loadDataValues();
 
    if (timingFlag) {
@@ -206,33 +272,9 @@ BrainModelCiftiCorrelationMatrix::getOutputCiftiFile()
       Nifti2Header header;
       CiftiXML xml;
       CiftiMatrix *matrix = new CiftiMatrix();
-      m_inputCiftiFile->getHeader(header);
-      m_inputCiftiFile->getCiftiXML(xml);
+      this->createOutputHeaderAndXML(header, xml);
       nifti_2_header head;
       header.getHeaderStruct(head);
-      head.dim[6]=head.dim[5];//dimensions are square now
-      head.intent_code = NIFTI_INTENT_CONNECTIVITY_DENSE;
-      memset(head.intent_name,0x00,16);
-      memcpy(head.intent_name,"ConnDense",9);      
-      header.setHeaderStuct(head);
-      CiftiRootElement root;
-      xml.getXMLRoot(root);
-      int mmCount = root.m_matrices.at(0).m_matrixIndicesMap.size();
-      
-      std::vector <CiftiMatrixIndicesMapElement> mmTemp;
-      std::vector <CiftiMatrixIndicesMapElement> *mm;
-      mm = &(root.m_matrices.at(0).m_matrixIndicesMap);
-      for(int i = 0;i<mmCount;i++)
-      {
-         if(mm->at(i).m_indicesMapToDataType != CIFTI_INDEX_TYPE_TIME_POINTS)
-            mmTemp.push_back(mm->at(i));
-      }
-      *mm = mmTemp;
-      std::vector <int> appliesToDim (2,0);
-      appliesToDim[0]=0;
-      appliesToDim[1]=1;
-      mm->at(0).m_appliesToMatrixDimension = appliesToDim;
-      xml.setXMLRoot(root);
       
       std::vector <int> dim (2,0);
       dim[0]=head.dim[5];
@@ -436,13 +478,7 @@ BrainModelCiftiCorrelationMatrix::computeCorrelationsForRows()
           * Apply the Fisher Z-Transform?
           */
          if (this->m_applyFisherZTransformFlag) {
-            float denom = (1.0 - r);
-            if (denom != 0.0) {
-               r = 0.5 * std::log((1.0 + r) / denom);
-            }
-            else {
-               r = 0.5 * std::log((1.0 + r) / tinyValue);
-            }
+            r = fisherZTransform(r);
          }
 
          //
@@ -482,3 +518,252 @@ BrainModelCiftiCorrelationMatrix::createOutputCiftiFile()
    }
 }
       
+
+/**
+ * create the output header and XML from the input file.  The output
+ * is square with the rows of the input mapped along both dimensions.
+ */
+void 
+BrainModelCiftiCorrelationMatrix::createOutputHeaderAndXML(Nifti2Header& header,
+                                                           CiftiXML& xml)
+{
+   m_inputCiftiFile->getHeader(header);
+   m_inputCiftiFile->getCiftiXML(xml);
+   nifti_2_header head;
+   header.getHeaderStruct(head);
+   head.dim[6]=head.dim[5];//dimensions are square now
+   head.intent_code = NIFTI_INTENT_CONNECTIVITY_DENSE;
+   memset(head.intent_name,0x00,16);
+   memcpy(head.intent_name,"ConnDense",9);      
+   header.setHeaderStuct(head);
+   CiftiRootElement root;
+   xml.getXMLRoot(root);
+   int mmCount = root.m_matrices.at(0).m_matrixIndicesMap.size();
+   
+   std::vector <CiftiMatrixIndicesMapElement> mmTemp;
+   std::vector <CiftiMatrixIndicesMapElement> *mm;
+   mm = &(root.m_matrices.at(0).m_matrixIndicesMap);
+   for(int i = 0;i<mmCount;i++)
+   {
+      if(mm->at(i).m_indicesMapToDataType != CIFTI_INDEX_TYPE_TIME_POINTS)
+         mmTemp.push_back(mm->at(i));
+   }
+   *mm = mmTemp;
+   std::vector <int> appliesToDim (2,0);
+   appliesToDim[0]=0;
+   appliesToDim[1]=1;
+   mm->at(0).m_appliesToMatrixDimension = appliesToDim;
+   xml.setXMLRoot(root);
+}
+
+/**
+ * Load the input rows, one at a time so that the input may be ON_DISK,
+ * and z-normalize them (subtract the mean and divide by the square root
+ * of the sum-squared) so that a correlation is just a dot product.
+ * The normalized values are stored transposed (timepoint major) so that
+ * the inner loop of the correlation is contiguous over output columns.
+ */
+void 
+BrainModelCiftiCorrelationMatrix::loadNormalizedDataValues() throw (BrainModelAlgorithmException)
+{
+   const long numRows = this->m_inputNumRows;
+   const long numCols = this->m_inputNumColumns;
+   
+   CiftiMatrix* matrix = m_inputCiftiFile->getCiftiMatrix();
+   this->m_normalizedDataValues = new float[numRows * numCols];
+   this->m_rowMeans = new float[numRows];
+   this->m_rowSumSquared = new double[numRows];
+   
+   bool readErrorFlag = false;
+   QString readErrorMessage;
+   
+   #pragma omp parallel if (this->m_parallelFlag)
+   {
+      std::vector<float> rowValues(numCols);
+      
+      #pragma omp for
+      for (long iRow = 0; iRow < numRows; iRow++) {
+         try {
+            matrix->getRow(&rowValues[0], iRow);
+         }
+         catch (CiftiFileException& e) {
+            #pragma omp critical
+            {
+               readErrorFlag = true;
+               readErrorMessage = e.whatQString();
+            }
+            continue;
+         }
+         
+         double sum = 0.0;
+         for (long j = 0; j < numCols; j++) {
+            sum += rowValues[j];
+         }
+         const double mean = sum / numCols;
+         
+         double ss = 0.0;
+         for (long j = 0; j < numCols; j++) {
+            const double f = rowValues[j] - mean;
+            ss += (f * f);
+         }
+         
+         //
+         // A constant row has a correlation of zero with all rows
+         //
+         const double scale = ((ss != 0.0) ? (1.0 / std::sqrt(ss)) : 0.0);
+         for (long j = 0; j < numCols; j++) {
+            this->m_normalizedDataValues[j * numRows + iRow] = (rowValues[j] - mean) * scale;
+         }
+         
+         this->m_rowMeans[iRow] = mean;
+         this->m_rowSumSquared[iRow] = ss;
+      }
+   }
+   
+   delete matrix;
+   
+   if (readErrorFlag) {
+      throw BrainModelAlgorithmException(readErrorMessage);
+   }
+}
+
+/**
+ * Compute the correlations one block of rows at a time, appending each
+ * block to the output file as soon as it is complete.
+ */
+void 
+BrainModelCiftiCorrelationMatrix::computeAndWriteCorrelationBlocks() throw (BrainModelAlgorithmException)
+{
+   const long numJ = this->m_outputDimension;
+   
+   Nifti2Header header;
+   CiftiXML xml;
+   this->createOutputHeaderAndXML(header, xml);
+   CiftiFile outputCiftiFile;
+   outputCiftiFile.setHeader(header);
+   outputCiftiFile.setCiftiXML(xml);
+   
+   QFile file(this->m_outputCiftiFileName);
+   if (file.open(QIODevice::WriteOnly) == false) {
+      throw BrainModelAlgorithmException("Unable to open for writing: "
+                                         + this->m_outputCiftiFileName);
+   }
+   try {
+      outputCiftiFile.writeHeaderAndExtension(file);
+   }
+   catch (CiftiFileException& e) {
+      throw BrainModelAlgorithmException(e.whatQString());
+   }
+   
+   const long blockSize = std::min(this->m_rowBlockSize, numJ);
+   if(DebugControl::getDebugOn()) std::cout << "Allocating output block of "<< blockSize << "x" << numJ << std::endl;
+   std::vector<float> block(blockSize * numJ);
+   
+   for (long firstRow = 0; firstRow < numJ; firstRow += blockSize) {
+      const long numRows = std::min(blockSize, numJ - firstRow);
+      this->computeCorrelationsForRowBlock(firstRow, numRows, &block[0]);
+      
+      const qint64 numBytes = (qint64)numRows * numJ * sizeof(float);
+      if (file.write((const char*)&block[0], numBytes) != numBytes) {
+         throw BrainModelAlgorithmException("Error writing to: "
+                                            + this->m_outputCiftiFileName);
+      }
+      
+      if (timingFlag) {
+         std::cout << "Wrote rows " << firstRow << " to "
+                   << (firstRow + numRows - 1) << std::endl;
+      }
+   }
+   
+   file.close();
+}
+
+/**
+ * Compute correlations of a block of rows with all rows.  This is the 
+ * product of the block's normalized rows and the transpose of all
+ * normalized rows, computed in tiles so that the normalized values for
+ * a tile stay in cache while the rows of the block are accumulated.
+ * Each thread owns a range of output columns, so no synchronization is
+ * needed, and the innermost loop is a contiguous multiply-add that the
+ * compiler vectorizes.
+ */
+void 
+BrainModelCiftiCorrelationMatrix::computeCorrelationsForRowBlock(const long firstRow,
+                                                                 const long numRows,
+                                                                 float* blockOut)
+{
+   const long numJ = this->m_outputDimension;
+   const long numK = this->m_inputNumColumns;
+   const long jTileSize = 512;
+   const long kTileSize = 128;
+   const float* z = this->m_normalizedDataValues;
+   const long numJTiles = (numJ + jTileSize - 1) / jTileSize;
+   
+   #pragma omp parallel for schedule(dynamic, 1) if (this->m_parallelFlag)
+   for (long jTile = 0; jTile < numJTiles; jTile++) {
+      const long jStart = jTile * jTileSize;
+      const long jLength = std::min(jTileSize, numJ - jStart);
+      
+      for (long i = 0; i < numRows; i++) {
+         float* out = blockOut + i * numJ + jStart;
+         for (long j = 0; j < jLength; j++) {
+            out[j] = 0.0f;
+         }
+      }
+      
+      for (long kStart = 0; kStart < numK; kStart += kTileSize) {
+         const long kEnd = std::min(kStart + kTileSize, numK);
+         
+         //
+         // Four rows at a time so each normalized value loaded is used four times
+         //
+         long i = 0;
+         for ( ; (i + 4) <= numRows; i += 4) {
+            float* out0 = blockOut + i * numJ + jStart;
+            float* out1 = out0 + numJ;
+            float* out2 = out1 + numJ;
+            float* out3 = out2 + numJ;
+            for (long k = kStart; k < kEnd; k++) {
+               const float* zk = z + k * numJ;
+               const float a0 = zk[firstRow + i];
+               const float a1 = zk[firstRow + i + 1];
+               const float a2 = zk[firstRow + i + 2];
+               const float a3 = zk[firstRow + i + 3];
+               const float* b = zk + jStart;
+               for (long j = 0; j < jLength; j++) {
+                  const float bj = b[j];
+                  out0[j] += a0 * bj;
+                  out1[j] += a1 * bj;
+                  out2[j] += a2 * bj;
+                  out3[j] += a3 * bj;
+               }
+            }
+         }
+         for ( ; i < numRows; i++) {
+            float* out = blockOut + i * numJ + jStart;
+            for (long k = kStart; k < kEnd; k++) {
+               const float* zk = z + k * numJ;
+               const float a = zk[firstRow + i];
+               const float* b = zk + jStart;
+               for (long j = 0; j < jLength; j++) {
+                  out[j] += a * b[j];
+               }
+            }
+         }
+      }
+      
+      //
+      // Accumulating in single precision may overshoot by an ulp or so
+      //
+      for (long i = 0; i < numRows; i++) {
+         float* out = blockOut + i * numJ + jStart;
+         for (long j = 0; j < jLength; j++) {
+            float r = std::max(-1.0f, std::min(1.0f, out[j]));
+            if (this->m_applyFisherZTransformFlag) {
+               r = fisherZTransform(r);
+            }
+            out[j] = r;
+         }
+      }
+   }
+}
@@ -19,6 +19,16 @@ class BrainModelCiftiCorrelationMatrix : public BrainModelAlgorithm {
            const bool applyFisherZTransformFlag,
            const bool parallelFlag);
       
+      // constructor for streaming output, rows of the output matrix are
+      // computed in blocks and written directly to the output file
+      BrainModelCiftiCorrelationMatrix(
+           BrainSet* bs,
+           CiftiFile * inputCiftiFile,
+           const QString& outputCiftiFileName,
+           const long rowBlockSize,
+           const bool applyFisherZTransformFlag,
+           const bool parallelFlag);
+      
       // destructor
       ~BrainModelCiftiCorrelationMatrix();
       
@@ -51,6 +61,22 @@ class BrainModelCiftiCorrelationMatrix : public BrainModelAlgorithm {
       // compute correlations for rows until there are no more rows to process
       void computeCorrelationsForRows();
 
+      // create the output header and XML from the input file
+      void createOutputHeaderAndXML(Nifti2Header& headerOut,
+                                    CiftiXML& xmlOut);
+      
+      // load the input rows as z-normalized, transposed values
+      void loadNormalizedDataValues() throw (BrainModelAlgorithmException);
+      
+      // compute and write the correlations one block of rows at a time
+      void computeAndWriteCorrelationBlocks() throw (BrainModelAlgorithmException);
+      
+      // compute correlations of a block of rows with all rows
+      void computeCorrelationsForRowBlock(const long firstRow,
+                                          const long numRows,
+                                          float* blockOut);
+      
+
       QString m_inputCiftiFileName;
 
       CiftiFile* m_inputCiftiFile;
@@ -82,6 +108,13 @@ class BrainModelCiftiCorrelationMatrix : public BrainModelAlgorithm {
       
       long m_nextRowToProcess;
       
+      // number of output rows held in memory at once when streaming
+      long m_rowBlockSize;
+      
+      // z-normalized input values, transposed so each column (timepoint) is
+      // contiguous across rows, used only when streaming
+      float* m_normalizedDataValues;
+      
       const bool m_parallelFlag;
       
 };
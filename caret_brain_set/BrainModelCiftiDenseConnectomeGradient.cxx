@@ -53,9 +53,7 @@ BrainModelCiftiDenseConnectomeGradient::execute() throw (BrainModelAlgorithmExce
 {
    CiftiMatrix* matrix=  m_inputCiftiFile->getCiftiMatrix();
    matrix->setCopyData(false);
-   vector <int> dimensions;
-   float* dataValues;
-   matrix->getMatrixData(dataValues,dimensions);
+   vector <int> dimensions;//rows are read a block at a time, so the input may be ON_DISK and larger than memory
    Nifti2Header header;
    nifti_2_header head;
    this->m_inputCiftiFile->getHeader(header);
@@ -168,33 +166,11 @@ BrainModelCiftiDenseConnectomeGradient::execute() throw (BrainModelAlgorithmExce
             }
          }
          const int indexSize = (int)myindices->size();
-         vector<double> means, stdevs;
-         means.resize(indexSize);
-         stdevs.resize(indexSize);
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-         for (int j = 0; j < indexSize; ++j)
-         {
-            double jAvg = 0.0, jStdev = 0.0;//first, lets precompute all row means and stdevs
-            float* rowReference = dataValues + cols * (mymodels[i].m_indexOffset + j);
-            for (int k = 0; k < cols; ++k)
-            {
-               jAvg += rowReference[k];
-            }
-            jAvg /= (double)indexSize;
-            for (int k = 0; k < cols; ++k)
-            {
-               double tempd = rowReference[k] - jAvg;
-               jStdev += tempd * tempd;
-            }
-            jStdev /= (double)indexSize;//maximum likelihood formula, as opposed to sample standard deviation
-            jStdev = sqrt(jStdev);
-            means[j] = jAvg;
-            stdevs[j] = jStdev;
-         }
+         const int blockRows = (int)min((long long)indexSize, getRowBlockSize(cols));
+         vector<double> means, stdevs;//first, lets precompute all row means and stdevs
+         computeRowMeansAndStdevs(matrix, mymodels[i].m_indexOffset, indexSize, cols, blockRows, means, stdevs);
          long long complete = 0;
-         long long total = indexSize * (indexSize - 1) >> 1;
+         long long total = (long long)indexSize * (indexSize - 1) >> 1;
          int lastdots = 0, thisdots;
          cout << "computing correlation for ";
          if (rightFlag)
@@ -205,34 +181,48 @@ BrainModelCiftiDenseConnectomeGradient::execute() throw (BrainModelAlgorithmExce
          }
          cout << " surface" << endl;
          cout << "|0%                 complete                 100%|" << endl;
-#ifdef _OPENMP
-#pragma omp parallel for schedule(dynamic, 1)
-#endif
          for (int j = 0; j < indexSize; ++j)
          {
             tempROI->setValue((*myindices)[j], 0, 1.0f);
             process.setValue((*myindices)[j], (*myindices)[j], 1.0f);
-            float* jRef = dataValues + cols * (mymodels[i].m_indexOffset + j);
-            double jAvg = means[j], jStdev = stdevs[j];
-            for (int k = j + 1; k < indexSize; ++k)
+         }
+         vector<float> jBlock, kBlock;
+         vector<double> blockCorrelations;
+         for (int firstJ = 0; firstJ < indexSize; firstJ += blockRows)
+         {//correlate each block of rows with itself and the blocks after it, so at most two blocks are in memory
+            const int numJ = min(blockRows, indexSize - firstJ);
+            readRows(matrix, mymodels[i].m_indexOffset + firstJ, numJ, cols, jBlock);
+            for (int firstK = firstJ; firstK < indexSize; firstK += blockRows)
             {
-               float* kRef = dataValues + cols * (mymodels[i].m_indexOffset + k);
-               double correlation = 0.0;
-               double kAvg = means[k];
-               for (int m = 0; m < cols; ++m)
+               const int numK = min(blockRows, indexSize - firstK);
+               const float* kValues = &(jBlock[0]);
+               if (firstK != firstJ)
                {
-                  correlation += (jRef[m] - jAvg) * (kRef[m] - kAvg);
+                  readRows(matrix, mymodels[i].m_indexOffset + firstK, numK, cols, kBlock);
+                  kValues = &(kBlock[0]);
                }
-               correlation /= (double)cols * jStdev * stdevs[k];
-               process.setValue((*myindices)[j], (*myindices)[k], correlation);
-               process.setValue((*myindices)[k], (*myindices)[j], correlation);
-            }
+               correlateRowBlocks(&(jBlock[0]), firstJ, numJ, kValues, firstK, numK, cols, means, stdevs, blockCorrelations);
 #ifdef _OPENMP
-#pragma omp critical
+#pragma omp parallel for
 #endif
-            {
-               complete += indexSize - j - 1;
-               thisdots = 50 * complete / total;
+               for (int jj = 0; jj < numJ; ++jj)
+               {
+                  const int j = firstJ + jj;
+                  for (int kk = max(0, j + 1 - firstK); kk < numK; ++kk)
+                  {
+                     const int k = firstK + kk;
+                     const double correlation = blockCorrelations[(long long)jj * numK + kk];
+                     process.setValue((*myindices)[j], (*myindices)[k], correlation);
+                     process.setValue((*myindices)[k], (*myindices)[j], correlation);
+                  }
+               }
+               if (firstK == firstJ)
+               {
+                  complete += (long long)numJ * (numJ - 1) >> 1;
+               } else {
+                  complete += (long long)numJ * numK;
+               }
+               thisdots = (int)(50 * complete / total);
                while (lastdots < thisdots)
                {
                   cout << '.';
@@ -332,9 +322,9 @@ BrainModelCiftiDenseConnectomeGradient::execute() throw (BrainModelAlgorithmExce
          vector<double> means, stdevs, output;
          vector<vector<double> > correlations;
          correlations.resize(numVoxels);
-         means.resize(numVoxels);
-         stdevs.resize(numVoxels);
          output.resize(numVoxels);
+         const long blockRows = (long)min((long long)numVoxels, getRowBlockSize(cols));
+         computeRowMeansAndStdevs(matrix, mymodels[i].m_indexOffset, numVoxels, cols, blockRows, means, stdevs);
          VolumeFile* tempROIVol;
          tempROIVol = new VolumeFile();
          tempROIVol->initialize(VolumeFile::VOXEL_DATA_TYPE_FLOAT, voxextent, orient, origin, spacing);
@@ -352,22 +342,39 @@ BrainModelCiftiDenseConnectomeGradient::execute() throw (BrainModelAlgorithmExce
             ijk[2] = myvoxels[base + 2] - voxoffset[2];
             tempROIVol->setVoxel(ijk, 0, 1.0f);
             output[j] = 0.0;
-            double jAvg = 0.0, jStdev = 0.0;
-            float* rowReference = dataValues + cols * (mymodels[i].m_indexOffset + j);
-            for (int k = 0; k < cols; ++k)
-            {
-               jAvg += rowReference[k];
-            }
-            jAvg /= (double)numVoxels;
-            for (int k = 0; k < cols; ++k)
+            correlations[j][j] = 1.0;
+         }
+         vector<float> jBlock, kBlock;
+         vector<double> blockCorrelations;
+         for (long firstJ = 0; firstJ < (long)numVoxels; firstJ += blockRows)
+         {//correlate each block of rows with itself and the blocks after it, so at most two blocks are in memory
+            const long numJ = min(blockRows, (long)numVoxels - firstJ);
+            readRows(matrix, mymodels[i].m_indexOffset + firstJ, numJ, cols, jBlock);
+            for (long firstK = firstJ; firstK < (long)numVoxels; firstK += blockRows)
             {
-               double tempd = rowReference[k] - jAvg;
-               jStdev += tempd * tempd;
+               const long numK = min(blockRows, (long)numVoxels - firstK);
+               const float* kValues = &(jBlock[0]);
+               if (firstK != firstJ)
+               {
+                  readRows(matrix, mymodels[i].m_indexOffset + firstK, numK, cols, kBlock);
+                  kValues = &(kBlock[0]);
+               }
+               correlateRowBlocks(&(jBlock[0]), firstJ, numJ, kValues, firstK, numK, cols, means, stdevs, blockCorrelations);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+               for (long jj = 0; jj < numJ; ++jj)
+               {
+                  const long j = firstJ + jj;
+                  for (long kk = max(0L, j + 1 - firstK); kk < numK; ++kk)
+                  {
+                     const long k = firstK + kk;
+                     const double correlation = blockCorrelations[(long long)jj * numK + kk];
+                     correlations[j][k] = correlation;
+                     correlations[k][j] = correlation;
+                  }
+               }
             }
-            jStdev /= (double)numVoxels;//maximum likelihood formula, as opposed to sample standard deviation
-            jStdev = sqrt(jStdev);
-            means[j] = jAvg;
-            stdevs[j] = jStdev;
          }
 #ifdef _OPENMP
 #pragma omp parallel
@@ -377,27 +384,6 @@ BrainModelCiftiDenseConnectomeGradient::execute() throw (BrainModelAlgorithmExce
             processVol = new VolumeFile(*tempROIVol);
             tempOutVol = new VolumeFile(*tempROIVol);
 #ifdef _OPENMP
-#pragma omp for schedule(dynamic, 1)
-#endif
-            for (unsigned long j = 0; j < numVoxels; ++j)
-            {
-               correlations[j][j] = 1.0;
-               float* jRef = dataValues + cols * (mymodels[i].m_indexOffset + j);
-               double jAvg = means[j], jStdev = stdevs[j];
-               for (unsigned long k = j + 1; k < numVoxels; ++k)
-               {
-                  float* kRef = dataValues + cols * (mymodels[i].m_indexOffset + k);
-                  double correlation = 0.0;
-                  for (int m = 0; m < cols; ++m)
-                  {
-                     correlation += (jRef[m] - jAvg) * (kRef[m] - means[k]);
-                  }
-                  correlation /= (double)cols * jStdev * stdevs[k];
-                  correlations[j][k] = correlation;
-                  correlations[k][j] = correlation;
-               }
-            }
-#ifdef _OPENMP
 #pragma omp for
 #endif
             for (unsigned long j = 0; j < numVoxels; ++j)
@@ -474,4 +460,119 @@ BrainModelCiftiDenseConnectomeGradient::execute() throw (BrainModelAlgorithmExce
    CiftiXML mycxml(myrootXML);
    m_inputCiftiFile->setCiftiXML(mycxml);
    m_inputCiftiFile->setCiftiMatrix(*matrix);//because getMatrix sets matrix to NULL for some reason
-}
\ No newline at end of file
+}
+
+/**
+ * number of rows read at a time, so that a block of rows is at most about 256MB
+ * and the correlations between two blocks are at most 8MB.
+ */
+long long 
+BrainModelCiftiDenseConnectomeGradient::getRowBlockSize(const long long cols)
+{
+   return max(1LL, min(1024LL, 67108864LL / max(cols, 1LL)));
+}
+
+/**
+ * read rows of the input matrix, which may be ON_DISK.
+ */
+void 
+BrainModelCiftiDenseConnectomeGradient::readRows(CiftiMatrix* matrix,
+                                                 const long long firstRow,
+                                                 const long long numRows,
+                                                 const long long cols,
+                                                 vector<float>& rowsOut) throw (BrainModelAlgorithmException)
+{
+   rowsOut.resize(numRows * cols);
+   try
+   {
+      matrix->getRowRange(&(rowsOut[0]), firstRow, numRows);
+   } catch (CiftiFileException& e) {
+      throw BrainModelAlgorithmException(e.whatQString());
+   }
+}
+
+/**
+ * compute the mean and standard deviation of each of a model's rows, reading
+ * one block of rows at a time.
+ */
+void 
+BrainModelCiftiDenseConnectomeGradient::computeRowMeansAndStdevs(CiftiMatrix* matrix,
+                                                                 const long long firstRow,
+                                                                 const long long numRows,
+                                                                 const long long cols,
+                                                                 const long long blockRows,
+                                                                 vector<double>& means,
+                                                                 vector<double>& stdevs) throw (BrainModelAlgorithmException)
+{
+   means.resize(numRows);
+   stdevs.resize(numRows);
+   vector<float> block;
+   for (long long firstJ = 0; firstJ < numRows; firstJ += blockRows)
+   {
+      const long long numJ = min(blockRows, numRows - firstJ);
+      readRows(matrix, firstRow + firstJ, numJ, cols, block);
+      const float* blockValues = &(block[0]);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (long long jj = 0; jj < numJ; ++jj)
+      {
+         double jAvg = 0.0, jStdev = 0.0;
+         const float* rowReference = blockValues + cols * jj;
+         for (long long k = 0; k < cols; ++k)
+         {
+            jAvg += rowReference[k];
+         }
+         jAvg /= (double)numRows;
+         for (long long k = 0; k < cols; ++k)
+         {
+            double tempd = rowReference[k] - jAvg;
+            jStdev += tempd * tempd;
+         }
+         jStdev /= (double)numRows;//maximum likelihood formula, as opposed to sample standard deviation
+         jStdev = sqrt(jStdev);
+         means[firstJ + jj] = jAvg;
+         stdevs[firstJ + jj] = jStdev;
+      }
+   }
+}
+
+/**
+ * correlate the rows of one block with the later rows of another block,
+ * "correlationsOut" is numJ by numK and only elements whose row in the
+ * second block follows the row in the first block are set.
+ */
+void 
+BrainModelCiftiDenseConnectomeGradient::correlateRowBlocks(const float* jValues,
+                                                           const long long firstJ,
+                                                           const long long numJ,
+                                                           const float* kValues,
+                                                           const long long firstK,
+                                                           const long long numK,
+                                                           const long long cols,
+                                                           const vector<double>& means,
+                                                           const vector<double>& stdevs,
+                                                           vector<double>& correlationsOut)
+{
+   correlationsOut.resize(numJ * numK);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+   for (long long jj = 0; jj < numJ; ++jj)
+   {
+      const float* jRef = jValues + cols * jj;
+      const double jAvg = means[firstJ + jj], jStdev = stdevs[firstJ + jj];
+      for (long long kk = max(0LL, firstJ + jj + 1 - firstK); kk < numK; ++kk)
+      {
+         const float* kRef = kValues + cols * kk;
+         const double kAvg = means[firstK + kk];
+         double correlation = 0.0;
+         for (long long m = 0; m < cols; ++m)
+         {
+            correlation += (jRef[m] - jAvg) * (kRef[m] - kAvg);
+         }
+         correlation /= (double)cols * jStdev * stdevs[firstK + kk];
+         correlationsOut[jj * numK + kk] = correlation;
+      }
+   }
+}
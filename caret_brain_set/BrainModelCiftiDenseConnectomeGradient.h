@@ -2,8 +2,11 @@
 #ifndef __BRAIN_MODEL_CIFTI_DENSE_CONNECTOME_GRADIENT_H__
 #define __BRAIN_MODEL_CIFTI_DENSE_CONNECTOME_GRADIENT_H__
 
+#include <vector>
+
 class BrainModelSurface;
 class CiftiFile;
+class CiftiMatrix;
 
 #include "BrainModelAlgorithm.h"
 
@@ -28,6 +31,37 @@ public:
    
 private:
    
+   // number of rows read at a time
+   static long long getRowBlockSize(const long long cols);
+   
+   // read rows of the input matrix
+   void readRows(CiftiMatrix* matrix,
+                 const long long firstRow,
+                 const long long numRows,
+                 const long long cols,
+                 std::vector<float>& rowsOut) throw (BrainModelAlgorithmException);
+   
+   // compute the mean and standard deviation of each of a model's rows, one block of rows at a time
+   void computeRowMeansAndStdevs(CiftiMatrix* matrix,
+                                 const long long firstRow,
+                                 const long long numRows,
+                                 const long long cols,
+                                 const long long blockRows,
+                                 std::vector<double>& means,
+                                 std::vector<double>& stdevs) throw (BrainModelAlgorithmException);
+   
+   // correlate the rows of one block with the later rows of another block
+   void correlateRowBlocks(const float* jValues,
+                           const long long firstJ,
+                           const long long numJ,
+                           const float* kValues,
+                           const long long firstK,
+                           const long long numK,
+                           const long long cols,
+                           const std::vector<double>& means,
+                           const std::vector<double>& stdevs,
+                           std::vector<double>& correlationsOut);
+   
    BrainModelSurface* m_leftSurf, *m_rightSurf;
    
    CiftiFile* m_inputCiftiFile;
@@ -33,6 +33,8 @@
 #define NOMINMAX
 #endif
 
+#include <QTime>
+
 #include "AreaColorFile.h"
 #include "BorderColorFile.h"
 #include "BrainModel.h"
@@ -41,6 +43,7 @@
 #define __BRAIN_MODEL_OPENGL_MAIN__
 #include "BrainModelOpenGL.h"
 #undef __BRAIN_MODEL_OPENGL_MAIN__
+#include "BrainModelOpenGLSurfaceBuffers.h"
 #include "BrainModelSurface.h"
 #include "BrainModelSurfaceAndVolume.h"
 #include "BrainModelSurfaceNodeColoring.h"
@@ -103,6 +106,7 @@ BrainModelOpenGL::BrainModelOpenGL()
    initializationCompletedFlag = false;
    offScreenRenderingFlag = false;
    useDisplayListsForShapes = true;
+   drawSurfaceWithVertexBuffersFlag = false;
    
    disableClearingFlag = false;
    brainSet = NULL;
@@ -387,6 +391,9 @@ BrainModelOpenGL::drawBrainModelPrivate(BrainModel* bm,
                                  const int viewportIn[4],
                                  QGLWidget* glWidgetIn)
 {
+   QTime drawTimer;
+   drawTimer.start();
+   
    if (DebugControl::getOpenGLDebugOn()) {
       checkForOpenGLError(bm, "At beginning of drawBrainModelPrivate()");
    }
@@ -574,9 +581,26 @@ BrainModelOpenGL::drawBrainModelPrivate(BrainModel* bm,
    
    glFlush();
    
+   //
+   // Wait for the drawing to complete so that the draw time is meaningful
+   //
+   if (DebugControl::getOpenGLDebugOn()) {
+      glFinish();
+   }
+   const int drawTime = drawTimer.elapsed();
+   
    paintMutex.unlock();   
 
    checkForOpenGLError(bm, "At end of drawBrainModelPrivate().");
+   
+   if (DebugControl::getOpenGLDebugOn()) {
+      std::cout << "Draw time in window " << viewingWindowNumber
+                << ": " << drawTime << " ms";
+      if (bm != NULL) {
+         std::cout << " (" << bm->getDescriptiveName().toAscii().constData() << ")";
+      }
+      std::cout << std::endl;
+   }
 }
 
 /**
@@ -1430,9 +1454,18 @@ BrainModelOpenGL::drawBrainModelSurface(BrainModelSurface* bms,
    // Get display list number for this surface
    //  
    PreferencesFile* pf = brainSet->getPreferencesFile();
-   const bool displayListsEnabled = pf->getDisplayListsEnabled();
    unsigned long displayListNumber = bms->getDisplayListNumber();
    
+   //
+   // Tiles drawn from vertex buffers must not be compiled into a display list
+   // so that a change in node coloring only replaces the color buffer.
+   //
+   drawSurfaceWithVertexBuffersFlag = ((idMode == false) &&
+                                       drawTheSurface &&
+                                       getSurfaceVertexBuffersUsable(bms));
+   const bool displayListsEnabled = (pf->getDisplayListsEnabled() &&
+                                     (drawSurfaceWithVertexBuffersFlag == false));
+   
    //
    // If need to redraw surface
    //
@@ -1576,6 +1609,7 @@ BrainModelOpenGL::drawBrainModelSurface(BrainModelSurface* bms,
          glEndList();
       }
    }   
+   drawSurfaceWithVertexBuffersFlag = false;
    
    //
    // If display lists enabled, execute it
@@ -7873,6 +7907,64 @@ BrainModelOpenGL::drawSurfaceLinksNoBackside(const BrainModelSurfaceNodeColoring
 }
 */
 
+/**
+ * Determine if the surface's tiles can be drawn from vertex buffers.  Only
+ * the common case of all nodes displayed with the tiles lit uniformly is
+ * handled; node selection and partial lighting still draw tile by tile.
+ */
+bool 
+BrainModelOpenGL::getSurfaceVertexBuffersUsable(const BrainModelSurface* bms) const
+{
+#ifdef GL_VERSION_1_1
+   if (offScreenRenderingFlag) {
+      return false;
+   }
+   if (brainSet->getDisplayAllNodes() == false) {
+      return false;
+   }
+   if (bms->getTopologyFile() == NULL) {
+      return false;
+   }
+   
+   const DisplaySettingsSurface* dss = brainSet->getDisplaySettingsSurface();
+   switch (dss->getDrawMode()) {
+      case DisplaySettingsSurface::DRAW_MODE_TILES:
+      case DisplaySettingsSurface::DRAW_MODE_TILES_WITH_LIGHT:
+      case DisplaySettingsSurface::DRAW_MODE_TILES_WITH_LIGHT_NO_BACK:
+         break;
+      case DisplaySettingsSurface::DRAW_MODE_NODES:
+      case DisplaySettingsSurface::DRAW_MODE_LINKS:
+      case DisplaySettingsSurface::DRAW_MODE_LINK_HIDDEN_LINE_REMOVAL:
+      case DisplaySettingsSurface::DRAW_MODE_LINKS_EDGES_ONLY:
+      case DisplaySettingsSurface::DRAW_MODE_NODES_AND_LINKS:
+      case DisplaySettingsSurface::DRAW_MODE_TILES_LINKS_NODES:
+      case DisplaySettingsSurface::DRAW_MODE_NONE:
+         return false;
+   }
+   
+   //
+   // Lighting on some overlays but not others requires drawing tile by tile
+   //
+   if ((bms->getSurfaceType() != BrainModelSurface::SURFACE_TYPE_FLAT) &&
+       (bms->getSurfaceType() != BrainModelSurface::SURFACE_TYPE_FLAT_LOBAR)) {
+      int numLightsOn = 0;
+      for (int i = 0; i < brainSet->getNumberOfSurfaceOverlays(); i++) {
+         if (brainSet->getSurfaceOverlay(i)->getLightingEnabled()) {
+            numLightsOn++;
+         }
+      }
+      if ((numLightsOn > 0) &&
+          (numLightsOn < brainSet->getNumberOfSurfaceOverlays())) {
+         return false;
+      }
+   }
+   
+   return BrainModelOpenGLSurfaceBuffers::getVertexBuffersSupported();
+#else  // GL_VERSION_1_1
+   return false;
+#endif  // GL_VERSION_1_1
+}
+
 /**
  * Draw the surface as tiles, possibly with lighting.
  */
@@ -8016,18 +8108,33 @@ BrainModelOpenGL::drawSurfaceTiles(const BrainModelSurfaceNodeColoring* bs,
    }
    else {
 #ifdef GL_VERSION_1_1
-      if (brainSet->getDisplayAllNodes()) {
-         glDrawElements(GL_TRIANGLES, (3 * numTiles), GL_UNSIGNED_INT, 
-                        static_cast<const GLvoid*>(tf->getTile(0)));
+      //
+      // Vertex buffers only need updating when the surface or coloring changes
+      //
+      bool drawnFromVertexBuffers = false;
+      if (drawSurfaceWithVertexBuffersFlag && 
+          brainSet->getDisplayAllNodes()) {
+         BrainModelSurface* bms = const_cast<BrainModelSurface*>(s);
+         if (bms->getVertexBuffers() == NULL) {
+            bms->setVertexBuffers(new BrainModelOpenGLSurfaceBuffers);
+         }
+         drawnFromVertexBuffers = bms->getVertexBuffers()->drawTiles(bs, s);
       }
-      else {
-         for (int i = 0; i < numTiles; i++) {
-            const int* theTile = tf->getTile(i);
-            if (attributes[theTile[0]].getDisplayFlag() ||
-                attributes[theTile[1]].getDisplayFlag() ||
-                attributes[theTile[2]].getDisplayFlag()) {
-               glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, 
-                              static_cast<const GLvoid*>(theTile));
+      
+      if (drawnFromVertexBuffers == false) {
+         if (brainSet->getDisplayAllNodes()) {
+            glDrawElements(GL_TRIANGLES, (3 * numTiles), GL_UNSIGNED_INT, 
+                           static_cast<const GLvoid*>(tf->getTile(0)));
+         }
+         else {
+            for (int i = 0; i < numTiles; i++) {
+               const int* theTile = tf->getTile(i);
+               if (attributes[theTile[0]].getDisplayFlag() ||
+                   attributes[theTile[1]].getDisplayFlag() ||
+                   attributes[theTile[2]].getDisplayFlag()) {
+                  glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, 
+                                 static_cast<const GLvoid*>(theTile));
+               }
             }
          }
       }
@@ -459,6 +459,9 @@ class BrainModelOpenGL {
                                       const CoordinateFile* cf,
                                       const TopologyFile* tf, const int numTiles);
                                       
+      /// can the surface's tiles be drawn from vertex buffers
+      bool getSurfaceVertexBuffersUsable(const BrainModelSurface* bms) const;
+      
       /// Draw the surface as tiles, possibly with lighting.
       void drawSurfaceTiles(const BrainModelSurfaceNodeColoring* bs,
                                    const BrainModelSurface* s,
@@ -917,6 +920,9 @@ class BrainModelOpenGL {
       /// use display lists for shapes (spheres, boxes, rings, etc)
       bool useDisplayListsForShapes;
       
+      /// draw the surface being drawn from vertex buffers instead of a display list
+      bool drawSurfaceWithVertexBuffersFlag;
+      
       /// surface edit drawing color
       static unsigned char surfaceEditDrawColor[3];
       
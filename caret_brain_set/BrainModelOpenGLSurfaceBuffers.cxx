@@ -0,0 +1,280 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <cstddef>
+
+#include <QGLContext>
+
+#ifdef CARET_OS_WINDOWS
+#include <Windows.h>
+#endif
+#ifdef CARET_OS_MACOSX
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include "BrainModelOpenGLSurfaceBuffers.h"
+#include "BrainModelSurface.h"
+#include "BrainModelSurfaceNodeColoring.h"
+#include "CoordinateFile.h"
+#include "TopologyFile.h"
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER         0x8892
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW          0x88E4
+#endif
+#ifndef GL_DYNAMIC_DRAW
+#define GL_DYNAMIC_DRAW         0x88E8
+#endif
+
+//
+// Buffer object functions are OpenGL 1.5 so they must be obtained from the
+// context since the system's OpenGL library may only export OpenGL 1.1.
+//
+typedef void (APIENTRY *CaretGLGenBuffers)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRY *CaretGLDeleteBuffers)(GLsizei n, const GLuint* buffers);
+typedef void (APIENTRY *CaretGLBindBuffer)(GLenum target, GLuint buffer);
+typedef void (APIENTRY *CaretGLBufferData)(GLenum target, std::ptrdiff_t size,
+                                           const GLvoid* data, GLenum usage);
+typedef void (APIENTRY *CaretGLBufferSubData)(GLenum target, std::ptrdiff_t offset,
+                                              std::ptrdiff_t size, const GLvoid* data);
+
+static bool buffersFunctionsResolvedFlag = false;
+static CaretGLGenBuffers caretGLGenBuffers = NULL;
+static CaretGLDeleteBuffers caretGLDeleteBuffers = NULL;
+static CaretGLBindBuffer caretGLBindBuffer = NULL;
+static CaretGLBufferData caretGLBufferData = NULL;
+static CaretGLBufferSubData caretGLBufferSubData = NULL;
+
+/**
+ * Get a buffer function from the current context trying the core name
+ * and then the ARB extension name.
+ */
+static void*
+getBufferFunction(const QGLContext* context,
+                  const char* name)
+{
+   void* f = context->getProcAddress(name);
+   if (f == NULL) {
+      f = context->getProcAddress(QString(name) + "ARB");
+   }
+   return f;
+}
+
+/**
+ * Constructor.
+ */
+BrainModelOpenGLSurfaceBuffers::BrainModelOpenGLSurfaceBuffers()
+{
+   vertexBuffer = 0;
+   colorBuffer  = 0;
+   tileBuffer   = 0;
+   numberOfNodes = 0;
+   numberOfTileIndices = 0;
+   coordinateModificationNumber = 0;
+   normalsModificationNumber = 0;
+   topologyFile = NULL;
+   topologyModificationNumber = 0;
+   nodeColoring = NULL;
+   nodeColoringModelNumber = -1;
+   nodeColoringModificationNumber = 0;
+}
+
+/**
+ * Destructor.
+ */
+BrainModelOpenGLSurfaceBuffers::~BrainModelOpenGLSurfaceBuffers()
+{
+   deleteBuffers();
+}
+
+/**
+ * Are vertex buffer objects supported by the current OpenGL context.
+ */
+bool 
+BrainModelOpenGLSurfaceBuffers::getVertexBuffersSupported()
+{
+   if (buffersFunctionsResolvedFlag == false) {
+      const QGLContext* context = QGLContext::currentContext();
+      if (context == NULL) {
+         return false;
+      }
+      caretGLGenBuffers = (CaretGLGenBuffers)getBufferFunction(context, "glGenBuffers");
+      caretGLDeleteBuffers = (CaretGLDeleteBuffers)getBufferFunction(context, "glDeleteBuffers");
+      caretGLBindBuffer = (CaretGLBindBuffer)getBufferFunction(context, "glBindBuffer");
+      caretGLBufferData = (CaretGLBufferData)getBufferFunction(context, "glBufferData");
+      caretGLBufferSubData = (CaretGLBufferSubData)getBufferFunction(context, "glBufferSubData");
+      buffersFunctionsResolvedFlag = true;
+   }
+   
+   return ((caretGLGenBuffers != NULL) &&
+           (caretGLDeleteBuffers != NULL) &&
+           (caretGLBindBuffer != NULL) &&
+           (caretGLBufferData != NULL) &&
+           (caretGLBufferSubData != NULL));
+}
+
+/**
+ * Delete the OpenGL buffers.
+ */
+void 
+BrainModelOpenGLSurfaceBuffers::deleteBuffers()
+{
+   if ((vertexBuffer != 0) &&
+       (QGLContext::currentContext() != NULL)) {
+      if (getVertexBuffersSupported()) {
+         const GLuint buffers[3] = { vertexBuffer, colorBuffer, tileBuffer };
+         caretGLDeleteBuffers(3, buffers);
+      }
+   }
+   vertexBuffer = 0;
+   colorBuffer  = 0;
+   tileBuffer   = 0;
+   numberOfNodes = 0;
+   numberOfTileIndices = 0;
+   topologyFile = NULL;
+   nodeColoring = NULL;
+   nodeColoringModelNumber = -1;
+}
+
+/**
+ * Draw the surface's tiles updating any buffers that are out of date.
+ * The vertex, normal, and color arrays must be enabled by the caller.
+ * Returns false if the buffers could not be used in which case nothing
+ * was drawn.
+ */
+bool 
+BrainModelOpenGLSurfaceBuffers::drawTiles(const BrainModelSurfaceNodeColoring* bsnc,
+                                          const BrainModelSurface* bms)
+{
+   if (getVertexBuffersSupported() == false) {
+      return false;
+   }
+   
+   const CoordinateFile* cf = bms->getCoordinateFile();
+   const TopologyFile* tf = bms->getTopologyFile();
+   const int numNodes = cf->getNumberOfCoordinates();
+   if ((tf == NULL) || 
+       (numNodes <= 0) ||
+       (tf->getNumberOfTiles() <= 0)) {
+      return false;
+   }
+   const int modelNumber = bms->getBrainModelIndex();
+   
+   if (vertexBuffer == 0) {
+      GLuint buffers[3];
+      caretGLGenBuffers(3, buffers);
+      vertexBuffer = buffers[0];
+      colorBuffer  = buffers[1];
+      tileBuffer   = buffers[2];
+   }
+   
+   const std::ptrdiff_t coordinateBytes = numNodes * 3 * sizeof(float);
+   const std::ptrdiff_t colorBytes = numNodes * 4 * sizeof(unsigned char);
+   
+   //
+   // Coordinates and normals only change when the surface is modified
+   //
+   if ((numNodes != numberOfNodes) ||
+       (cf->getModificationSerialNumber() != coordinateModificationNumber) ||
+       (bms->getNormalsModificationNumber() != normalsModificationNumber)) {
+      caretGLBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+      caretGLBufferData(GL_ARRAY_BUFFER, coordinateBytes * 2, NULL, GL_STATIC_DRAW);
+      caretGLBufferSubData(GL_ARRAY_BUFFER, 0, coordinateBytes,
+                           cf->getCoordinate(0));
+      caretGLBufferSubData(GL_ARRAY_BUFFER, coordinateBytes, coordinateBytes,
+                           bms->getNormal(0));
+      coordinateModificationNumber = cf->getModificationSerialNumber();
+      normalsModificationNumber = bms->getNormalsModificationNumber();
+   }
+   
+   //
+   // Only the color buffer needs replacing when the node coloring changes
+   //
+   if ((numNodes != numberOfNodes) ||
+       (bsnc != nodeColoring) ||
+       (modelNumber != nodeColoringModelNumber) ||
+       (bsnc->getModificationNumber() != nodeColoringModificationNumber)) {
+      caretGLBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+      if (numNodes != numberOfNodes) {
+         caretGLBufferData(GL_ARRAY_BUFFER, colorBytes, 
+                           bsnc->getNodeColor(modelNumber, 0), GL_DYNAMIC_DRAW);
+      }
+      else {
+         caretGLBufferSubData(GL_ARRAY_BUFFER, 0, colorBytes,
+                              bsnc->getNodeColor(modelNumber, 0));
+      }
+      nodeColoring = bsnc;
+      nodeColoringModelNumber = modelNumber;
+      nodeColoringModificationNumber = bsnc->getModificationNumber();
+   }
+   numberOfNodes = numNodes;
+   
+   //
+   // Tiles only change when the topology is modified
+   //
+   if ((tf != topologyFile) ||
+       (tf->getModificationSerialNumber() != topologyModificationNumber) ||
+       ((tf->getNumberOfTiles() * 3) != numberOfTileIndices)) {
+      numberOfTileIndices = tf->getNumberOfTiles() * 3;
+      caretGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tileBuffer);
+      caretGLBufferData(GL_ELEMENT_ARRAY_BUFFER, numberOfTileIndices * sizeof(int),
+                        tf->getTile(0), GL_STATIC_DRAW);
+      topologyFile = tf;
+      topologyModificationNumber = tf->getModificationSerialNumber();
+   }
+   
+   //
+   // With a buffer bound, the array "pointers" are offsets into the buffer
+   //
+   caretGLBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+   glVertexPointer(3, GL_FLOAT, 0, static_cast<const char*>(NULL));
+   glNormalPointer(GL_FLOAT, 0, static_cast<const char*>(NULL) + coordinateBytes);
+   caretGLBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+   glColorPointer(4, GL_UNSIGNED_BYTE, 0, static_cast<const char*>(NULL));
+   caretGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tileBuffer);
+   glDrawElements(GL_TRIANGLES, numberOfTileIndices, GL_UNSIGNED_INT, 
+                  static_cast<const char*>(NULL));
+   
+   //
+   // Unbind so that client side arrays work for other drawing
+   //
+   caretGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+   caretGLBindBuffer(GL_ARRAY_BUFFER, 0);
+   
+   return true;
+}
+
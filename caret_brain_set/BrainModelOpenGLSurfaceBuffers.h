@@ -0,0 +1,102 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+
+#ifndef __BRAIN_MODEL_OPENGL_SURFACE_BUFFERS_H__
+#define __BRAIN_MODEL_OPENGL_SURFACE_BUFFERS_H__
+
+class BrainModelSurface;
+class BrainModelSurfaceNodeColoring;
+class TopologyFile;
+
+/// OpenGL vertex buffer objects holding a surface's coordinates, normals,
+/// tiles, and node colors.  The coordinates, normals, and tiles are only
+/// uploaded when they are modified so that a change in the node coloring
+/// only replaces the color buffer.
+class BrainModelOpenGLSurfaceBuffers {
+   public:
+      /// Constructor
+      BrainModelOpenGLSurfaceBuffers();
+      
+      /// Destructor (an OpenGL context sharing the buffers should be current)
+      ~BrainModelOpenGLSurfaceBuffers();
+      
+      /// are vertex buffer objects supported by the current OpenGL context
+      static bool getVertexBuffersSupported();
+      
+      /// draw the surface's tiles updating any buffers that are out of date
+      /// (vertex, normal, and color arrays must be enabled by the caller)
+      bool drawTiles(const BrainModelSurfaceNodeColoring* bsnc,
+                     const BrainModelSurface* bms);
+      
+   protected:
+      /// copy constructor not allowed
+      BrainModelOpenGLSurfaceBuffers(const BrainModelOpenGLSurfaceBuffers&);
+      
+      /// assignment operator not allowed
+      BrainModelOpenGLSurfaceBuffers& operator=(const BrainModelOpenGLSurfaceBuffers&);
+      
+      /// delete the OpenGL buffers
+      void deleteBuffers();
+      
+      /// buffer containing coordinates followed by normals
+      unsigned int vertexBuffer;
+      
+      /// buffer containing RGBA node colors
+      unsigned int colorBuffer;
+      
+      /// buffer containing the tiles' node indices
+      unsigned int tileBuffer;
+      
+      /// number of nodes in the vertex and color buffers
+      int numberOfNodes;
+      
+      /// number of node indices in the tile buffer
+      int numberOfTileIndices;
+      
+      /// coordinate file modification serial number when vertex buffer loaded
+      unsigned long coordinateModificationNumber;
+      
+      /// normals modification number when vertex buffer loaded
+      unsigned long normalsModificationNumber;
+      
+      /// topology file that was loaded into the tile buffer
+      const TopologyFile* topologyFile;
+      
+      /// topology file modification serial number when tile buffer loaded
+      unsigned long topologyModificationNumber;
+      
+      /// node coloring that was loaded into the color buffer
+      const BrainModelSurfaceNodeColoring* nodeColoring;
+      
+      /// brain model number whose colors were loaded into the color buffer
+      int nodeColoringModelNumber;
+      
+      /// node coloring modification number when color buffer loaded
+      unsigned long nodeColoringModificationNumber;
+};
+
+#endif
+
@@ -55,6 +55,7 @@
 
 #include "BorderFile.h"
 #include "BorderProjectionFile.h"
+#include "BrainModelOpenGLSurfaceBuffers.h"
 #include "BrainModelSurface.h"
 #include "BrainModelSurfaceCurvature.h"
 #include "BrainModelSurfaceROINodeSelection.h"
@@ -87,6 +88,8 @@ BrainModelSurface::BrainModelSurface(BrainSet* bs,
                                      const BrainModel::BRAIN_MODEL_TYPE bmt) 
    : BrainModel(bs, bmt)
 {
+   normalsModificationNumber = 0;
+   vertexBuffers = NULL;
    reset();
 }
 
@@ -96,6 +99,8 @@ BrainModelSurface::BrainModelSurface(BrainSet* bs,
 BrainModelSurface::BrainModelSurface(const BrainModelSurface& bms)
    : BrainModel(bms)
 {
+   normalsModificationNumber = 0;
+   vertexBuffers = NULL;
    reset();
 
    coordinates = bms.coordinates;
@@ -119,6 +124,7 @@ BrainModelSurface::BrainModelSurface(const BrainModelSurface& bms)
 BrainModelSurface::~BrainModelSurface()
 {
    reset();
+   setVertexBuffers(NULL);
 }
 
 /**
@@ -246,6 +252,7 @@ BrainModelSurface::addNode(const float xyz[3])
    normals.push_back(0.0);
    normals.push_back(0.0);
    normals.push_back(1.0);
+   normalsModificationNumber++;
    if (topology != NULL) {
       topology->setNumberOfNodes(coordinates.getNumberOfCoordinates());
    }
@@ -1122,6 +1129,7 @@ BrainModelSurface::setNormal(const int coordinateNumber,
    normals[i3]   = normalVector[0];
    normals[i3+1] = normalVector[1];
    normals[i3+2] = normalVector[2];
+   normalsModificationNumber++;
 }                     
 
 /**
@@ -1142,6 +1150,7 @@ BrainModelSurface::initializeNormals(const int numCoordsIn)
          normals.push_back(1.0);
       }
    }
+   normalsModificationNumber++;
 }
 
 /**
@@ -1172,6 +1181,19 @@ BrainModelSurface::setDisplayListNumber(unsigned int num)
 {
    coordinates.setDisplayListNumber(num);
 }
+
+/**
+ * set the vertex buffers for drawing this brain model (takes ownership).
+ */
+void 
+BrainModelSurface::setVertexBuffers(BrainModelOpenGLSurfaceBuffers* vb)
+{
+   if ((vertexBuffers != NULL) &&
+       (vertexBuffers != vb)) {
+      delete vertexBuffers;
+   }
+   vertexBuffers = vb;
+}
       
 /**
  * Reset the surface - clear everything in it, usually called prior to 
@@ -1184,6 +1206,7 @@ BrainModelSurface::reset()
    structure.setType(Structure::STRUCTURE_TYPE_INVALID);
    coordinates.clear();
    normals.clear();
+   normalsModificationNumber++;
    topology = NULL;
    defaultScaling = 1.0;
    defaultPerspectiveZooming = 200.0;
@@ -1711,6 +1734,7 @@ BrainModelSurface::computeNormals(const float* coordsIn, bool averageNormals)
          }
       }
    }
+   normalsModificationNumber++;
    coordinates.clearDisplayList();
 }
 
@@ -2927,6 +2951,7 @@ BrainModelSurface::createLatitudeLongitude(LatLonFile* llf,
    if (sphereInDorsalViewFlag) {
       popCoordinates();
       normals = savedNormals;
+      normalsModificationNumber++;
    }   
 }
 
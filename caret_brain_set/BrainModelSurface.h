@@ -36,6 +36,7 @@
 
 class BorderFile;
 class BorderProjection;
+class BrainModelOpenGLSurfaceBuffers;
 class BrainModelSurfaceROINodeSelection;
 class BrainVoyagerFile;
 class CellProjectionFile;
@@ -265,6 +266,9 @@ class BrainModelSurface : public BrainModel {
       /// set a normal
       void setNormal(const int coordinateNumber,
                      const float normalVector[3]);
+      
+      /// get the normals modification number (incremented each time normals change)
+      unsigned long getNormalsModificationNumber() const { return normalsModificationNumber; }
                      
       /// get the radius of a spherical surface (assumes spherical surface with center at origin)
       float getSphericalSurfaceRadius() const;
@@ -286,6 +290,12 @@ class BrainModelSurface : public BrainModel {
       /// set the display list for this brain model 
       void setDisplayListNumber(unsigned int num);
       
+      /// get the vertex buffers for drawing this brain model (NULL if none)
+      BrainModelOpenGLSurfaceBuffers* getVertexBuffers() const { return vertexBuffers; }
+      
+      /// set the vertex buffers for drawing this brain model (takes ownership)
+      void setVertexBuffers(BrainModelOpenGLSurfaceBuffers* vb);
+      
       /// import from a brain voyager file
       void importFromBrainVoyagerFile(const BrainVoyagerFile& bvf) throw (FileException);
       
@@ -586,6 +596,12 @@ class BrainModelSurface : public BrainModel {
       /// last topology modification status
       unsigned long lastTopologyModificationNumber;
       
+      /// normals modification number
+      unsigned long normalsModificationNumber;
+      
+      /// vertex buffers for drawing (not copied by copy constructor)
+      BrainModelOpenGLSurfaceBuffers* vertexBuffers;
+      
       //
       // NOTE NOTE NOTE NOTE NOTE NOTE NOTE    !!!!!!!!!!!!!!!!!!!!!!!!!!!
       //
@@ -156,9 +156,8 @@ BrainModelSurfaceCurvature::execute() throw (BrainModelAlgorithmException)
       float kmax = 0.0;
       float kmin = 0.0;
 
-      std::vector<int> neighbors;
-      th->getNodeNeighbors(i, neighbors);
-      const int numNeighbors = static_cast<int>(neighbors.size());
+      int numNeighbors = 0;
+      const int* neighbors = th->getNodeNeighbors(i, numNeighbors);
       if (numNeighbors > 0) {
          //
          // Position and normal for node
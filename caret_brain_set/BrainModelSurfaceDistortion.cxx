@@ -199,9 +199,8 @@ BrainModelSurfaceDistortion::execute() throw (BrainModelAlgorithmException)
       //
       for (int i = 0; i < numNodes; i++) {
          float distortion = 0.0;
-         std::vector<int> neighbors;
-         th.getNodeNeighbors(i, neighbors);
-         const int numberOfNeighbors = neighbors.size();
+         int numberOfNeighbors = 0;
+         const int* neighbors = th.getNodeNeighbors(i, numberOfNeighbors);
          
          if (numberOfNeighbors >= 1) {
             const float* me = coords->getCoordinate(i); 
@@ -0,0 +1,429 @@
+
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QTime>
+
+#include "BinaryCacheFile.h"
+#include "BrainModelSurface.h"
+#define __BRAIN_MODEL_SURFACE_GEODESIC_GAUSSIAN_OPERATOR_MAIN__
+#include "BrainModelSurfaceGeodesicGaussianOperator.h"
+#undef __BRAIN_MODEL_SURFACE_GEODESIC_GAUSSIAN_OPERATOR_MAIN__
+#include "CoordinateFile.h"
+#include "DebugControl.h"
+#include "FileUtilities.h"
+#include "GeodesicHelper.h"
+#include "TopologyFile.h"
+#include "TopologyHelper.h"
+
+#ifdef _OPENMP
+#include "omp.h"
+#endif
+
+/// identifies a cache file
+static const char cacheFileMagic[8] = { 'C', 'a', 'r', 'e', 't', 'G', 'G', 'O' };
+
+/// version of the cache file (and of the key, change if the operator changes)
+static const int cacheFileVersion = 1;
+
+/**
+ * Constructor.
+ */
+BrainModelSurfaceGeodesicGaussianOperator::BrainModelSurfaceGeodesicGaussianOperator()
+{
+   numberOfNodes = 0;
+   readFromCacheFlag = false;
+}
+
+/**
+ * Destructor.
+ */
+BrainModelSurfaceGeodesicGaussianOperator::~BrainModelSurfaceGeodesicGaussianOperator()
+{
+}
+
+/**
+ * get the operator for a surface.  If the cache directory contains the
+ * operator for this surface and kernel it is read, otherwise it is computed
+ * and saved in the cache directory.  Caller must delete the operator.
+ */
+BrainModelSurfaceGeodesicGaussianOperator* 
+BrainModelSurfaceGeodesicGaussianOperator::getOperator(const BrainModelSurface* surface,
+                                                       const float sigma,
+                                                       const int minimumNumberOfNeighbors,
+                                                       const bool parallelFlag)
+{
+   BrainModelSurfaceGeodesicGaussianOperator* op = 
+      new BrainModelSurfaceGeodesicGaussianOperator;
+   
+   QTime timer;
+   timer.start();
+   
+   const QByteArray key = computeKey(surface, sigma, minimumNumberOfNeighbors);
+   QString cacheFileName;
+   const QString dirName = getCacheDirectory();
+   if (dirName.isEmpty() == false) {
+      cacheFileName = QDir(dirName).filePath("geodesic_gaussian_" 
+                                             + QString(key.toHex())
+                                             + ".csr");
+      if (QFile::exists(cacheFileName)) {
+         if (op->readCacheFile(cacheFileName, key)) {
+            op->readFromCacheFlag = true;
+            if (DebugControl::getDebugOn()) {
+               std::cout << "Read geodesic gaussian operator from "
+                         << cacheFileName.toAscii().constData()
+                         << " in " << (timer.elapsed() * 0.001) << " seconds."
+                         << std::endl;
+            }
+            return op;
+         }
+      }
+   }
+   
+   op->computeOperator(surface, sigma, minimumNumberOfNeighbors, parallelFlag);
+   if (DebugControl::getDebugOn()) {
+      std::cout << "Time to compute geodesic gaussian operator: " 
+                << (timer.elapsed() * 0.001) << " seconds." << std::endl;
+   }
+   
+   if (cacheFileName.isEmpty() == false) {
+      op->writeCacheFile(cacheFileName, key);
+   }
+   
+   return op;
+}
+
+/**
+ * compute the operator from the surface.
+ */
+void 
+BrainModelSurfaceGeodesicGaussianOperator::computeOperator(const BrainModelSurface* surface,
+                                                           const float sigma,
+                                                           const int minimumNumberOfNeighbors,
+                                                           const bool parallelFlag)
+{
+   numberOfNodes = surface->getNumberOfNodes();
+   const CoordinateFile* cf = surface->getCoordinateFile();
+   const TopologyFile* topologyFile = surface->getTopologyFile();
+   const float geoCutoff = 4.0f * sigma;
+   
+   //
+   // Geodesic distances from all nodes, the roots are run in parallel
+   //
+   GeodesicHelper gh(cf, topologyFile);
+   std::vector<int> roots(numberOfNodes);
+   for (int i = 0; i < numberOfNodes; i++) {
+      roots[i] = i;
+   }
+   std::vector<std::vector<int> > rowNodes;
+   std::vector<std::vector<float> > rowWeights;
+   gh.getNodesToGeoDistBatch(roots, geoCutoff, rowNodes, rowWeights, true);
+   
+   //
+   // in case a really small kernel is specified
+   // for geogauss, we want the center node in the list
+   //
+   const TopologyHelper* topologyHelper = topologyFile->getTopologyHelper(false, true, false);
+   for (int i = 0; i < numberOfNodes; i++) {
+      if (static_cast<int>(rowNodes[i].size()) < minimumNumberOfNeighbors) {
+         topologyHelper->getNodeNeighbors(i, rowNodes[i]);
+         rowNodes[i].push_back(i);
+         gh.getGeoToTheseNodes(i, rowNodes[i], rowWeights[i], true);
+      }
+   }
+   
+   //
+   // Convert distances to weights in place, rows are then packed into CSR
+   //
+#ifdef _OPENMP
+#pragma omp parallel if (parallelFlag)
+#endif
+   {
+      std::vector<std::pair<int, float> > sortedNeighbors;
+      
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+      for (int i = 0; i < numberOfNodes; i++) {
+         std::vector<int>& rn = rowNodes[i];
+         std::vector<float>& rw = rowWeights[i];
+         
+         //
+         // Gaussian of geodesic distance, normalized so weights sum to one
+         //
+         const int numNeigh = static_cast<int>(rn.size());
+         sortedNeighbors.resize(numNeigh);
+         double totalWeight = 0.0;
+         for (int j = 0; j < numNeigh; j++) {
+            const double d = rw[j] / sigma;
+            const float weight = static_cast<float>(std::exp(-d * d * 0.5));
+            sortedNeighbors[j] = std::make_pair(rn[j], weight);
+            totalWeight += weight;
+         }
+         if (totalWeight <= 0.0) {
+            totalWeight = 1.0;
+         }
+         
+         //
+         // Sort by node so that neighbors' values are read in memory order
+         //
+         std::sort(sortedNeighbors.begin(), sortedNeighbors.end());
+         
+         for (int j = 0; j < numNeigh; j++) {
+            rn[j] = sortedNeighbors[j].first;
+            rw[j] = static_cast<float>(sortedNeighbors[j].second / totalWeight);
+         }
+      }
+   } // omp parallel
+   
+   //
+   // Pack the rows
+   //
+   rowOffsets.resize(numberOfNodes + 1);
+   rowOffsets[0] = 0;
+   for (int i = 0; i < numberOfNodes; i++) {
+      rowOffsets[i + 1] = rowOffsets[i] + static_cast<long long>(rowNodes[i].size());
+   }
+   neighborNodes.resize(rowOffsets[numberOfNodes]);
+   weights.resize(rowOffsets[numberOfNodes]);
+   for (int i = 0; i < numberOfNodes; i++) {
+      std::copy(rowNodes[i].begin(), rowNodes[i].end(), neighborNodes.begin() + rowOffsets[i]);
+      std::copy(rowWeights[i].begin(), rowWeights[i].end(), weights.begin() + rowOffsets[i]);
+      std::vector<int>().swap(rowNodes[i]);
+      std::vector<float>().swap(rowWeights[i]);
+   }
+}
+
+/**
+ * apply the operator to a block of columns.  Values are stored with all of a 
+ * node's columns adjacent so that each weight is applied to all columns at once.
+ * "input" and "output" must not be the same array.
+ */
+void 
+BrainModelSurfaceGeodesicGaussianOperator::apply(const float* input,
+                                                 float* output,
+                                                 const int numberOfColumns,
+                                                 const bool parallelFlag) const
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 256) if (parallelFlag)
+#endif
+   for (int i = 0; i < numberOfNodes; i++) {
+      float* out = output + static_cast<long long>(i) * numberOfColumns;
+      for (int k = 0; k < numberOfColumns; k++) {
+         out[k] = 0.0f;
+      }
+      const long long rowEnd = rowOffsets[i + 1];
+      for (long long j = rowOffsets[i]; j < rowEnd; j++) {
+         const float w = weights[j];
+         const float* in = input + static_cast<long long>(neighborNodes[j]) * numberOfColumns;
+         for (int k = 0; k < numberOfColumns; k++) {
+            out[k] += w * in[k];
+         }
+      }
+   }
+}
+
+/**
+ * get the neighbors and weights of a node (returns number of neighbors).
+ */
+int 
+BrainModelSurfaceGeodesicGaussianOperator::getNodeWeights(const int nodeNumber,
+                                                          const int*& neighborsOut,
+                                                          const float*& weightsOut) const
+{
+   const long long first = rowOffsets[nodeNumber];
+   const int num = static_cast<int>(rowOffsets[nodeNumber + 1] - first);
+   neighborsOut = NULL;
+   weightsOut   = NULL;
+   if (num > 0) {
+      neighborsOut = &neighborNodes[first];
+      weightsOut   = &weights[first];
+   }
+   return num;
+}
+
+/**
+ * compute the key for the surface and kernel (hash of coordinates, 
+ * topology, and kernel parameters).
+ */
+QByteArray 
+BrainModelSurfaceGeodesicGaussianOperator::computeKey(const BrainModelSurface* surface,
+                                                      const float sigma,
+                                                      const int minimumNumberOfNeighbors)
+{
+   QCryptographicHash hash(QCryptographicHash::Md5);
+   
+   BinaryCacheFile(cacheFileMagic, cacheFileVersion).addFormatToHash(hash);
+   
+   const CoordinateFile* cf = surface->getCoordinateFile();
+   const int numNodes = cf->getNumberOfCoordinates();
+   hash.addData(reinterpret_cast<const char*>(&numNodes), sizeof(int));
+   if (numNodes > 0) {
+      std::vector<float> xyz;
+      cf->getAllCoordinates(xyz);
+      hash.addData(reinterpret_cast<const char*>(&xyz[0]), 
+                   static_cast<int>(xyz.size() * sizeof(float)));
+   }
+   
+   const TopologyFile* tf = surface->getTopologyFile();
+   const int numTiles = ((tf != NULL) ? tf->getNumberOfTiles() : 0);
+   hash.addData(reinterpret_cast<const char*>(&numTiles), sizeof(int));
+   for (int i = 0; i < numTiles; i++) {
+      hash.addData(reinterpret_cast<const char*>(tf->getTile(i)), 3 * sizeof(int));
+   }
+   
+   hash.addData(reinterpret_cast<const char*>(&sigma), sizeof(float));
+   hash.addData(reinterpret_cast<const char*>(&minimumNumberOfNeighbors), sizeof(int));
+   
+   return hash.result();
+}
+
+/**
+ * read the operator from a cache file (returns true if successful).
+ */
+bool 
+BrainModelSurfaceGeodesicGaussianOperator::readCacheFile(const QString& fileName,
+                                                         const QByteArray& key)
+{
+   BinaryCacheFile file(cacheFileMagic, cacheFileVersion);
+   QByteArray fileKey;
+   int numNodes = 0;
+   long long numWeights = 0;
+   if ((file.openForReading(fileName, key.size(), fileKey) == false) ||
+       (fileKey != key) ||
+       (file.readData(&numNodes, sizeof(int)) == false) ||
+       (file.readData(&numWeights, sizeof(long long)) == false) ||
+       (numNodes < 0) || 
+       (numWeights < 0)) {
+      return false;
+   }
+   
+   const qint64 offsetsSize = static_cast<qint64>(numNodes + 1) * sizeof(long long);
+   const qint64 nodesSize   = static_cast<qint64>(numWeights) * sizeof(int);
+   const qint64 weightsSize = static_cast<qint64>(numWeights) * sizeof(float);
+   if (file.getNumberOfBytesRemaining() != (offsetsSize + nodesSize + weightsSize)) {
+      return false;
+   }
+   
+   rowOffsets.resize(numNodes + 1);
+   neighborNodes.resize(numWeights);
+   weights.resize(numWeights);
+   if ((file.readData(&rowOffsets[0], offsetsSize) == false) ||
+       ((numWeights > 0) &&
+        ((file.readData(&neighborNodes[0], nodesSize) == false) ||
+         (file.readData(&weights[0], weightsSize) == false)))) {
+      return false;
+   }
+   file.closeForReading();
+   
+   //
+   // Verify the structure so that a damaged file cannot cause invalid memory access
+   //
+   bool validFlag = ((rowOffsets[0] == 0) && (rowOffsets[numNodes] == numWeights));
+   for (int i = 0; (i < numNodes) && validFlag; i++) {
+      if (rowOffsets[i + 1] < rowOffsets[i]) {
+         validFlag = false;
+      }
+   }
+   for (long long j = 0; (j < numWeights) && validFlag; j++) {
+      if ((neighborNodes[j] < 0) || (neighborNodes[j] >= numNodes)) {
+         validFlag = false;
+      }
+   }
+   if (validFlag == false) {
+      rowOffsets.clear();
+      neighborNodes.clear();
+      weights.clear();
+      return false;
+   }
+   
+   numberOfNodes = numNodes;
+   return true;
+}
+
+/**
+ * write the operator to a cache file.  Other processes never see a 
+ * partial file (see BinaryCacheFile).
+ * Failure is not an error, the operator is simply not cached.
+ */
+void 
+BrainModelSurfaceGeodesicGaussianOperator::writeCacheFile(const QString& fileName,
+                                                          const QByteArray& key) const
+{
+   BinaryCacheFile file(cacheFileMagic, cacheFileVersion);
+   const long long numWeights = getNumberOfWeights();
+   const bool okFlag = 
+      file.openForWriting(fileName, key) &&
+      file.writeData(&numberOfNodes, sizeof(int)) &&
+      file.writeData(&numWeights, sizeof(long long)) &&
+      file.writeData(&rowOffsets[0], static_cast<qint64>(rowOffsets.size()) * sizeof(long long)) &&
+      ((numWeights <= 0) ||
+       (file.writeData(&neighborNodes[0], static_cast<qint64>(numWeights) * sizeof(int)) &&
+        file.writeData(&weights[0], static_cast<qint64>(numWeights) * sizeof(float)))) &&
+      file.closeForWriting();
+   if (okFlag == false) {
+      if (DebugControl::getDebugOn()) {
+         std::cout << "Unable to write geodesic gaussian operator cache file "
+                   << fileName.toAscii().constData() << ": "
+                   << file.getErrorMessage().toAscii().constData() << std::endl;
+      }
+   }
+}
+
+/**
+ * get the directory in which operators are cached.  Unless set, this is
+ * a subdirectory of the system's temporary directory.
+ */
+QString 
+BrainModelSurfaceGeodesicGaussianOperator::getCacheDirectory()
+{
+   if (cacheDirectorySet == false) {
+      const QString tempDir = FileUtilities::temporaryDirectory();
+      if (tempDir.isEmpty() == false) {
+         return QDir(tempDir).filePath("caret_geodesic_gaussian_cache");
+      }
+   }
+   return cacheDirectory;
+}
+
+/**
+ * set the directory in which operators are cached (empty disables the cache).
+ */
+void 
+BrainModelSurfaceGeodesicGaussianOperator::setCacheDirectory(const QString& dirName)
+{
+   cacheDirectory = dirName;
+   cacheDirectorySet = true;
+}
@@ -0,0 +1,134 @@
+#ifndef __BRAIN_MODEL_SURFACE_GEODESIC_GAUSSIAN_OPERATOR_H__
+#define __BRAIN_MODEL_SURFACE_GEODESIC_GAUSSIAN_OPERATOR_H__
+
+
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+class BrainModelSurface;
+
+/// Sparse operator that applies one iteration of geodesic gaussian smoothing.
+/// Row "i" of the operator holds the normalized gaussian weights of the nodes
+/// within a geodesic distance of the node "i", stored in compressed sparse row
+/// (CSR) format.  Computing the geodesic distances is by far the most expensive
+/// part of geodesic gaussian smoothing, so operators are saved in a cache
+/// directory keyed by a hash of the coordinates, topology, and kernel.  Later
+/// uses of the same surface and kernel read the operator from the cache.
+class BrainModelSurfaceGeodesicGaussianOperator {
+   public:
+      // get the operator for a surface (cached if possible, delete when done)
+      static BrainModelSurfaceGeodesicGaussianOperator* getOperator(
+                                             const BrainModelSurface* surface,
+                                             const float sigma,
+                                             const int minimumNumberOfNeighbors,
+                                             const bool parallelFlag);
+      
+      // destructor
+      ~BrainModelSurfaceGeodesicGaussianOperator();
+      
+      // apply the operator to a block of columns stored with all of a node's columns
+      // adjacent ("input" and "output" contain numberOfNodes * numberOfColumns values)
+      void apply(const float* input,
+                 float* output,
+                 const int numberOfColumns,
+                 const bool parallelFlag) const;
+      
+      /// get the number of nodes (rows and columns of the operator)
+      int getNumberOfNodes() const { return numberOfNodes; }
+      
+      /// get the number of non-zero weights in the operator
+      long long getNumberOfWeights() const { return static_cast<long long>(weights.size()); }
+      
+      /// get the neighbors and weights of a node (returns number of neighbors)
+      int getNodeWeights(const int nodeNumber,
+                         const int*& neighborsOut,
+                         const float*& weightsOut) const;
+      
+      /// was the operator read from the cache
+      bool getReadFromCache() const { return readFromCacheFlag; }
+      
+      // get the directory in which operators are cached
+      static QString getCacheDirectory();
+      
+      // set the directory in which operators are cached (empty disables the cache)
+      static void setCacheDirectory(const QString& dirName);
+      
+   protected:
+      // constructor
+      BrainModelSurfaceGeodesicGaussianOperator();
+      
+      // compute the operator from the surface
+      void computeOperator(const BrainModelSurface* surface,
+                           const float sigma,
+                           const int minimumNumberOfNeighbors,
+                           const bool parallelFlag);
+      
+      // compute the key for the surface and kernel
+      static QByteArray computeKey(const BrainModelSurface* surface,
+                                   const float sigma,
+                                   const int minimumNumberOfNeighbors);
+      
+      // read the operator from a cache file (returns true if successful)
+      bool readCacheFile(const QString& fileName,
+                         const QByteArray& key);
+      
+      // write the operator to a cache file
+      void writeCacheFile(const QString& fileName,
+                          const QByteArray& key) const;
+      
+      /// number of nodes
+      int numberOfNodes;
+      
+      /// offset of each node's first weight (numberOfNodes + 1 elements)
+      std::vector<long long> rowOffsets;
+      
+      /// node of each weight
+      std::vector<int> neighborNodes;
+      
+      /// the normalized weights
+      std::vector<float> weights;
+      
+      /// operator was read from the cache
+      bool readFromCacheFlag;
+      
+      /// directory for cached operators
+      static QString cacheDirectory;
+      
+      /// cache directory has been set
+      static bool cacheDirectorySet;
+};
+
+#ifdef __BRAIN_MODEL_SURFACE_GEODESIC_GAUSSIAN_OPERATOR_MAIN__
+QString BrainModelSurfaceGeodesicGaussianOperator::cacheDirectory;
+bool BrainModelSurfaceGeodesicGaussianOperator::cacheDirectorySet = false;
+#endif // __BRAIN_MODEL_SURFACE_GEODESIC_GAUSSIAN_OPERATOR_MAIN__
+
+#endif // __BRAIN_MODEL_SURFACE_GEODESIC_GAUSSIAN_OPERATOR_H__
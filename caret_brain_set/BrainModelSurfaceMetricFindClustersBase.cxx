@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <deque>
 #include <limits>
 #include <sstream>
 
@@ -32,7 +33,7 @@
 #include <QFile>
 #include <QTextStream>
 
-#include "BrainModelAlgorithmRunAsThread.h"
+#include "BrainModelAlgorithmThreadPool.h"
 #include "BrainModelSurface.h"
 #include "BrainModelSurfaceMetricClustering.h"
 #include "BrainModelSurfaceMetricFindClustersBase.h"
@@ -49,6 +50,27 @@
 #include "SurfaceShapeFile.h"
 #include "TextFile.h"
 #include "TopologyFile.h"
+#include "TopologyHelper.h"
+
+/// permutation generator whose permutations are the columns of a metric file
+class MetricColumnPermutationGenerator 
+   : public BrainModelSurfaceMetricFindClustersBase::PermutationGenerator {
+   public:
+      /// constructor
+      MetricColumnPermutationGenerator(const MetricFile* metricFileIn) {
+         metricFile = metricFileIn;
+      }
+      
+      /// copy the column for the permutation
+      void computePermutation(const int permutationIndex,
+                              float* statisticalMapOut) const {
+         metricFile->getColumnForAllNodes(permutationIndex, statisticalMapOut);
+      }
+      
+   protected:
+      /// the metric file
+      const MetricFile* metricFile;
+};
 
 /**
  * constructor.
@@ -226,7 +248,18 @@ BrainModelSurfaceMetricFindClustersBase::findClusters(MetricFile* mf,
    QTime timer;
    timer.start();
    
-   if(numberOfThreads <= 1) {
+   if (useLargestClusterPerColumnFlag &&
+       (limitToColumn < 0)) {
+      //
+      // Each column is reduced straight to its largest cluster
+      //
+      MetricColumnPermutationGenerator columnGenerator(mf);
+      findLargestClusterInPermutations(columnGenerator,
+                                       mf->getNumberOfColumns(),
+                                       clustersOut,
+                                       progressMessage);
+   }
+   else if (numberOfThreads <= 1) {
       findClustersSingleThread(mf,
                                clustersOut,
                                progressMessage,
@@ -529,33 +562,14 @@ BrainModelSurfaceMetricFindClustersBase::findClustersMultiThread(MetricFile* mf,
    }
    
    //
-   // Next column that is to be processed
-   //
-   int nextColumnToProcess = startColumn;
-   
-   //
-   // Time to wait for threads in milliseconds
+   // Tasks for columns in order, at most two per thread are submitted at
+   // a time so that the copies of the column data stay small
    //
-   const unsigned long totalWaitTime = 1000;  // 1000 milliseconds == 1 second
-   const unsigned long threadWaitTime = totalWaitTime / numberOfThreads;
-   
-   //
-   // Pointers for algorithm threads
-   //
-   std::vector<BrainModelAlgorithmRunAsThread*> algorithmThreads(numberOfThreads);
-   for (int i = 0; i < numberOfThreads; i++) {
-      algorithmThreads[i] = NULL;
-   }
-   
-   //
-   // Column number on which thread is operating
-   //
-   std::vector<int> threadColumnNumber(numberOfThreads, -1);
-   
-   //
-   // One metric column per thread
-   //
-   std::vector<MetricFile> metricFilesForThreads(numberOfThreads);
+   BrainModelAlgorithmThreadPool* threadPool =
+      BrainModelAlgorithmThreadPool::getThreadPool(numberOfThreads);
+   const int maximumTasksSubmitted = numberOfThreads * 2;
+   std::deque<BrainModelAlgorithmThreadPool::Task*> tasks;
+   std::deque<MetricFile*> metricFilesForTasks;
    
    //
    // Progress data
@@ -566,135 +580,124 @@ BrainModelSurfaceMetricFindClustersBase::findClustersMultiThread(MetricFile* mf,
    //
    // Find clusters in all selected columns
    //
-   bool done = false;
-   while (done == false) {
+   int nextColumnToProcess = startColumn;
+   int nextColumnToSave = startColumn;
+   QString errorMessage;
+   while (true) {
       //
-      // Loop through the threads to see if any are done and create new threads
+      // Submit columns until enough are waiting, stop submitting after an error
       //
-      for (int iThread = 0; iThread < numberOfThreads; iThread++) {
+      while ((nextColumnToProcess <= endColumn) &&
+             (static_cast<int>(tasks.size()) < maximumTasksSubmitted) &&
+             errorMessage.isEmpty()) {
          //
-         // Is thread valid
+         // Update progress
          //
-         if (algorithmThreads[iThread] != NULL) {
-            //
-            // Wait on the thread
-            //
-            algorithmThreads[iThread]->wait(threadWaitTime);
-            
-            //
-            // Is the thread finished
-            //
-            if (algorithmThreads[iThread]->isFinished()) {
-               //
-               // Get the algorithm
-               //
-               BrainModelSurfaceMetricClustering* bmsmc = 
-                  dynamic_cast<BrainModelSurfaceMetricClustering*>(algorithmThreads[iThread]->getBrainModelAlgorithm());
-                  
-               //
-               // Save the clusters
-               //
-               saveClusters(bmsmc,
-                            clustersOut,
-                            threadColumnNumber[iThread],
-                            useLargestClusterPerColumnFlag);
-               
-               //
-               // delete the thread (which also deletes the algorithm)
-               //
-               delete algorithmThreads[iThread];
-               algorithmThreads[iThread] = NULL;
-            }
+         progressCounter++;
+         if (progressMessage.isEmpty() == false) {
+            std::ostringstream str;
+            str << progressMessage.toAscii().constData()
+                << ": "
+                << progressCounter
+                << " of "
+                << numProgress;
+            updateProgressDialog(str.str().c_str(), -1, -1);
          }
+
+         //
+         // Copy data to the task's metric file
+         //
+         MetricFile* metricFile = new MetricFile;
+         metricFile->setNumberOfNodesAndColumns(mf->getNumberOfNodes(), 1);
+         std::vector<float> nodeValues;
+         mf->getColumnForAllNodes(nextColumnToProcess, nodeValues);
+         metricFile->setColumnForAllNodes(0, nodeValues);
          
          //
-         // Is the thread available ?
+         // Create a new cluster finding algorithm
          //
-         if (algorithmThreads[iThread] == NULL) {
-            //
-            // Are there still columns of data to process
-            //
-            if (nextColumnToProcess <= endColumn) {
-               //
-               // Update progress
-               //
-               progressCounter++;
-               if (progressMessage.isEmpty() == false) {
-                  std::ostringstream str;
-                  str << progressMessage.toAscii().constData()
-                      << ": "
-                      << progressCounter
-                      << " of "
-                      << numProgress;
-                  updateProgressDialog(str.str().c_str(), -1, -1);
-               }
-
-               //
-               // Set column being processed by thread (columns in report start at one)
-               //
-               threadColumnNumber[iThread] = nextColumnToProcess + 1;
-               
-               //
-               // Copy data to the thread's metric file
-               //
-               metricFilesForThreads[iThread].setNumberOfNodesAndColumns(mf->getNumberOfNodes(), 1);
-               std::vector<float> nodeValues;
-               mf->getColumnForAllNodes(nextColumnToProcess, nodeValues);
-               metricFilesForThreads[iThread].setColumnForAllNodes(0, nodeValues);
-               
-               //
-               // Create a new cluster finding algorithm
-               //
-               BrainModelSurfaceMetricClustering* clusterAlgorithm =
-                  new BrainModelSurfaceMetricClustering (brain,
-                                                    bms,
-                                                    &metricFilesForThreads[iThread],
-                                                    BrainModelSurfaceMetricClustering::CLUSTER_ALGORITHM_MINIMUM_SURFACE_AREA,
-                                                    0,
-                                                    0,
-                                                    "cluster",
-                                                    1,
-                                                    0.1,
-                                                    negMin,
-                                                    negMax,
-                                                    posMin,
-                                                    posMax,
-                                                    true);
-               
-               //
-               // Create a new thread to run the algorithm and take ownership of cluster algorithm
-               //
-               algorithmThreads[iThread] = 
-                  new BrainModelAlgorithmRunAsThread(clusterAlgorithm, true);
-               algorithmThreads[iThread]->start(QThread::HighestPriority);
-               //if (DebugControl::getDebugOn()) {
-                  std::cout << "Started thread " << iThread << " for column " << nextColumnToProcess << std::endl;
-               //}
-               
-               //
-               // Move on to next metric column
-               //
-               nextColumnToProcess++;
-            } // if (nextColumnToProcess <= endColumn)
-         } // if (algorithmThreads[iThread] == NULL) 
-      } // for (int iThread
+         BrainModelSurfaceMetricClustering* clusterAlgorithm =
+            new BrainModelSurfaceMetricClustering (brain,
+                                              bms,
+                                              metricFile,
+                                              BrainModelSurfaceMetricClustering::CLUSTER_ALGORITHM_MINIMUM_SURFACE_AREA,
+                                              0,
+                                              0,
+                                              "cluster",
+                                              1,
+                                              0.1,
+                                              negMin,
+                                              negMax,
+                                              posMin,
+                                              posMax,
+                                              true);
+         
+         //
+         // Task takes ownership of cluster algorithm
+         //
+         BrainModelAlgorithmThreadPool::Task* task =
+            new BrainModelAlgorithmThreadPool::Task(clusterAlgorithm, true);
+         threadPool->submit(task);
+         tasks.push_back(task);
+         metricFilesForTasks.push_back(metricFile);
+         if (DebugControl::getDebugOn()) {
+            std::cout << "Submitted task for column " << nextColumnToProcess << std::endl;
+         }
+         
+         //
+         // Move on to next metric column
+         //
+         nextColumnToProcess++;
+      }
+      if (tasks.empty()) {
+         break;
+      }
       
       //
-      // Loop through the threads to see if any are still valid and if time to stop
+      // Save clusters in column order so results do not depend upon timing
       //
-      done = true;
-      for (int iThread = 0; iThread < numberOfThreads; iThread++) {
-         if (algorithmThreads[iThread] != NULL) {
-            done = false;
+      BrainModelAlgorithmThreadPool::Task* task = tasks.front();
+      threadPool->waitForTask(task);
+      if (task->getAlgorithmThrewAnException()) {
+         if (errorMessage.isEmpty()) {
+            errorMessage = task->getExceptionErrorMessage();
          }
       }
+      else if (errorMessage.isEmpty()) {
+         BrainModelSurfaceMetricClustering* bmsmc = 
+            dynamic_cast<BrainModelSurfaceMetricClustering*>(task->getBrainModelAlgorithm());
+            
+         //
+         // Save the clusters (columns in report start at one)
+         //
+         saveClusters(bmsmc,
+                      clustersOut,
+                      nextColumnToSave + 1,
+                      useLargestClusterPerColumnFlag);
+      }
+      
+      //
+      // delete the task (which also deletes the algorithm)
+      //
+      delete task;
+      delete metricFilesForTasks.front();
+      tasks.pop_front();
+      metricFilesForTasks.pop_front();
+      nextColumnToSave++;
 
       //
       // Allow other events to process
       //
       allowEventsToProcess();
 
-   } // while (done == false)
+   } // while (true)
+   
+   //
+   // All submitted tasks have finished, so safe to report the error
+   //
+   if (errorMessage.isEmpty() == false) {
+      throw BrainModelAlgorithmException(errorMessage);
+   }
       
    //
    // Sort clusters so biggest elements first
@@ -935,6 +938,197 @@ BrainModelSurfaceMetricFindClustersBase::findClustersMultiThread(MetricFile* mf,
 }
 */
 
+/**
+ * find the largest cluster in the statistical map of each permutation.
+ *
+ * Permutations are divided among threads.  Each map is reduced to its
+ * largest cluster (by corrected area) as soon as it is computed, so only
+ * the null distribution is kept.  If "sampleMapsOut" is not NULL, the maps
+ * of the first permutations are saved in its columns.  Results do not
+ * depend upon the number of threads.  Output is sorted with the biggest
+ * clusters first.
+ */
+void 
+BrainModelSurfaceMetricFindClustersBase::findLargestClusterInPermutations(
+                                      const PermutationGenerator& generator,
+                                      const int numberOfPermutations,
+                                      std::vector<Cluster>& clustersOut,
+                                      const QString& progressMessage,
+                                      MetricFile* sampleMapsOut) throw (BrainModelAlgorithmException)
+{
+   const int numNodes = bms->getNumberOfNodes();
+   if (numberOfPermutations <= 0) {
+      return;
+   }
+   
+   //
+   // Data shared (read only) by all threads.  The topology helper is
+   // created before the threads start so it is never rebuilt while in use.
+   //
+   const TopologyHelper* th = bms->getTopologyFile()->getTopologyHelper(false, true, false);
+   const CoordinateFile* cf = bms->getCoordinateFile();
+   std::vector<float> nodeAreas;
+   bms->getAreaOfAllNodes(nodeAreas);
+   std::vector<float> correctedNodeAreas(numNodes, 0.0);
+   if (areaCorrectionShapeFile != NULL) {
+      for (int i = 0; i < numNodes; i++) {
+         const double metric = areaCorrectionShapeFile->getValue(i, areaCorrectionShapeFileColumn);
+         correctedNodeAreas[i] = nodeAreas[i] * std::pow(2.0, metric);
+      }
+   }
+   
+   const int numSampleMaps = ((sampleMapsOut != NULL) 
+                              ? std::min(sampleMapsOut->getNumberOfColumns(),
+                                         numberOfPermutations)
+                              : 0);
+   
+   //
+   // Storage for the largest cluster of each permutation
+   //
+   std::vector<Cluster> largestClusters(numberOfPermutations);
+   std::vector<char> clusterFoundFlags(numberOfPermutations, 0);
+   
+   //
+   // Permutations are done in batches so progress can be updated
+   //
+   const int numThreads = std::max(numberOfThreads, 1);
+   const int batchSize = numThreads * 16;
+   for (int batchStart = 0; batchStart < numberOfPermutations; batchStart += batchSize) {
+      const int batchEnd = std::min(batchStart + batchSize, numberOfPermutations);
+      if (progressMessage.isEmpty() == false) {
+         std::ostringstream str;
+         str << progressMessage.toAscii().constData()
+             << ": "
+             << batchEnd
+             << " of "
+             << numberOfPermutations;
+         updateProgressDialog(str.str().c_str(), -1, -1);
+      }
+      allowEventsToProcess();
+      
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads)
+#endif
+      {
+         std::vector<float> statisticalMap(numNodes, 0.0);
+         std::vector<int> clusterNumbers(numNodes, -1);
+         std::vector<int> nodeStack;
+         std::vector<int> clusterNodes;
+         
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+         for (int p = batchStart; p < batchEnd; p++) {
+            generator.computePermutation(p, &statisticalMap[0]);
+            if (p < numSampleMaps) {
+#ifdef _OPENMP
+#pragma omp critical (FindClustersBaseSampleMaps)
+#endif
+               sampleMapsOut->setColumnForAllNodes(p, &statisticalMap[0]);
+            }
+            
+            //
+            // Find connected positive (or negative) nodes within the thresholds
+            //
+            std::fill(clusterNumbers.begin(), clusterNumbers.end(), -1);
+            Cluster& largest = largestClusters[p];
+            for (int i = 0; i < numNodes; i++) {
+               if (clusterNumbers[i] >= 0) {
+                  continue;
+               }
+               if (th->getNodeHasNeighbors(i) == false) {
+                  continue;
+               }
+               //
+               // As in BrainModelSurfaceMetricClustering, positive is
+               // tested first and a cluster is all positive or all negative
+               //
+               const float v = statisticalMap[i];
+               const bool positiveFlag = (v >= positiveThresh);
+               if ((positiveFlag == false) && 
+                   (v > negativeThresh)) {
+                  continue;
+               }
+               
+               //
+               // Grow the cluster
+               //
+               clusterNodes.clear();
+               nodeStack.clear();
+               nodeStack.push_back(i);
+               clusterNumbers[i] = i;
+               double correctedArea = 0.0;
+               while (nodeStack.empty() == false) {
+                  const int node = nodeStack.back();
+                  nodeStack.pop_back();
+                  clusterNodes.push_back(node);
+                  correctedArea += correctedNodeAreas[node];
+                  
+                  int numNeighbors = 0;
+                  const int* neighbors = th->getNodeNeighbors(node, numNeighbors);
+                  for (int k = 0; k < numNeighbors; k++) {
+                     const int n = neighbors[k];
+                     if (clusterNumbers[n] < 0) {
+                        const float nv = statisticalMap[n];
+                        if (positiveFlag ? (nv >= positiveThresh)
+                                         : (nv <= negativeThresh)) {
+                           clusterNumbers[n] = i;
+                           nodeStack.push_back(n);
+                        }
+                     }
+                  }
+               }
+               
+               //
+               // Keep the cluster if it is the largest so far
+               //
+               if ((clusterFoundFlags[p] == 0) ||
+                   (correctedArea > largest.areaCorrected)) {
+                  clusterFoundFlags[p] = 1;
+                  double area = 0.0;
+                  double cogSum[3] = { 0.0, 0.0, 0.0 };
+                  const int numInCluster = static_cast<int>(clusterNodes.size());
+                  for (int k = 0; k < numInCluster; k++) {
+                     const int node = clusterNodes[k];
+                     area += nodeAreas[node];
+                     const float* xyz = cf->getCoordinate(node);
+                     cogSum[0] += xyz[0];
+                     cogSum[1] += xyz[1];
+                     cogSum[2] += xyz[2];
+                  }
+                  largest.column = p + 1;
+                  largest.numberOfNodes = numInCluster;
+                  largest.area = area;
+                  largest.areaCorrected = correctedArea;
+                  largest.cogX = cogSum[0] / numInCluster;
+                  largest.cogY = cogSum[1] / numInCluster;
+                  largest.cogZ = cogSum[2] / numInCluster;
+                  if (positiveFlag) {
+                     largest.threshMin = positiveThresh;
+                     largest.threshMax = std::numeric_limits<float>::max();
+                  }
+                  else {
+                     largest.threshMin = -std::numeric_limits<float>::max();
+                     largest.threshMax = negativeThresh;
+                  }
+               }
+            }
+         }
+      }
+   }
+   
+   //
+   // Null distribution of largest clusters, biggest first
+   //
+   for (int p = 0; p < numberOfPermutations; p++) {
+      if (clusterFoundFlags[p] != 0) {
+         clustersOut.push_back(largestClusters[p]);
+      }
+   }
+   std::sort(clustersOut.begin(), clustersOut.end());
+   std::reverse(clustersOut.begin(), clustersOut.end());
+}
+
 /**
  * Set randomized cluster p-values.
  */
@@ -943,7 +1137,19 @@ BrainModelSurfaceMetricFindClustersBase::setRandomizedClusterPValues(
                                                  const MetricFile& randomFile, 
                                                  std::vector<Cluster>& randomClusters)
 {
-   const float numberOfIterations = randomFile.getNumberOfColumns();
+   setRandomizedClusterPValues(randomFile.getNumberOfColumns(),
+                               randomClusters);
+}
+
+/**
+ * Set randomized cluster p-values.
+ */
+void 
+BrainModelSurfaceMetricFindClustersBase::setRandomizedClusterPValues(
+                                                 const int numberOfIterationsIn, 
+                                                 std::vector<Cluster>& randomClusters)
+{
+   const float numberOfIterations = numberOfIterationsIn;
    if (numberOfIterations <= 0.0) {
        return;
    }
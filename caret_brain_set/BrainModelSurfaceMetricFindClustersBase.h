@@ -65,6 +65,19 @@ class BrainModelSurfaceMetricFindClustersBase : public BrainModelAlgorithm {
       // execute the algorithm
       void execute() throw (BrainModelAlgorithmException);
       
+      /// interface for computing the statistical map of one permutation
+      class PermutationGenerator {
+         public:
+            /// destructor
+            virtual ~PermutationGenerator() { }
+            
+            /// compute the statistical map of a permutation.  Called from
+            /// several threads at once so the map must depend only upon
+            /// the permutation index.
+            virtual void computePermutation(const int permutationIndex,
+                                            float* statisticalMapOut) const = 0;
+      };
+      
    protected:
       /// class for cluster thresholding
       class Cluster {
@@ -153,10 +166,21 @@ class BrainModelSurfaceMetricFindClustersBase : public BrainModelAlgorithm {
                         const int columnNumber,
                         const bool useLargestClusterPerColumnFlag);
       
+      // find the largest cluster in the statistical map of each permutation
+      void findLargestClusterInPermutations(const PermutationGenerator& generator,
+                                            const int numberOfPermutations,
+                                            std::vector<Cluster>& clustersOut,
+                                            const QString& progressMessage,
+                                            MetricFile* sampleMapsOut = NULL) throw (BrainModelAlgorithmException);
+      
       // set randomized cluster p-values
       void setRandomizedClusterPValues(const MetricFile& randomFile, 
                                 std::vector<Cluster>& randomClusters);
                                 
+      // set randomized cluster p-values
+      void setRandomizedClusterPValues(const int numberOfIterations, 
+                                std::vector<Cluster>& randomClusters);
+                                
       // print the clusters
       void printClusters(QTextStream& stream, const std::vector<Cluster>& clusters,
                          const float sigArea = -1.0);
@@ -38,6 +38,7 @@
 #include "FileUtilities.h"
 #include "MetricFile.h"
 #include "StatisticRandomNumber.h"
+#include "StatisticRandomNumberStream.h"
 
 /**
  * constructor.
@@ -476,9 +477,11 @@ BrainModelSurfaceMetricInterHemClusters::executeClusterSearch() throw (BrainMode
    stMapCom.append(" and ");
    stMapCom.append(FileUtilities::basename(rightShuffledTMapFileName));
    statisticalMapShapeFile->setFileComment(stMapCom);
+   const unsigned int streamKey = StatisticRandomNumber::getStreamKey();
    for (int j = 0; j < iterationsShuffledTMap; j++) {
-      const int leftCol = StatisticRandomNumber::randomInteger(0, leftShuffledTMapShapeFile->getNumberOfColumns() - 1);
-      const int rightCol = StatisticRandomNumber::randomInteger(0, rightShuffledTMapShapeFile->getNumberOfColumns() - 1);
+      StatisticRandomNumberStream randomStream(streamKey, j);
+      const int leftCol = randomStream.randomInteger(0, leftShuffledTMapShapeFile->getNumberOfColumns() - 1);
+      const int rightCol = randomStream.randomInteger(0, rightShuffledTMapShapeFile->getNumberOfColumns() - 1);
       std::ostringstream str;
       str << "Left=" << leftCol
           << "   "
@@ -30,11 +30,11 @@
 #include <cmath>
 
 #include "BrainModelSurface.h"
+#include "BrainModelSurfaceGeodesicGaussianOperator.h"
 #include "BrainModelSurfaceMetricFullWidthHalfMaximum.h"
 #include "BrainModelSurfaceMetricSmoothing.h"
 #include "DebugControl.h"
 #include "GaussianComputation.h"
-#include "GeodesicHelper.h"
 #include "MetricFile.h"
 #include "StringUtilities.h"
 #include "TopologyFile.h"
@@ -542,24 +542,52 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
 
     QTime timer;
     timer.start();
+    
+    //
+    // Geodesic gaussian weights come from the sparse operator that is cached per surface
+    // (at least 7 neighbors, 5 neighbor nodes may fail this unneccesarily, 
+    //  but better than letting 6 neighbor nodes slip through with 5)
+    //
+    if (algorithm == SMOOTH_ALGORITHM_GEODESIC_GAUSSIAN) {
+        BrainModelSurfaceGeodesicGaussianOperator* geodesicOperator =
+            BrainModelSurfaceGeodesicGaussianOperator::getOperator(fiducialSurface,
+                                                                   geodesicGaussSigma,
+                                                                   7,
+                                                                   true);
+        for (int i = 0; i < numberOfNodes; i++) {
+            const int* neighbors;
+            const float* weights;
+            const int numNeigh = geodesicOperator->getNodeWeights(i, neighbors, weights);
+            NeighborInfo& neighInfo = nodeNeighbors[i];
+            neighInfo.neighbors.assign(neighbors, neighbors + numNeigh);
+            neighInfo.geoGaussWeight.assign(weights, weights + numNeigh);
+            neighInfo.numNeighbors = numNeigh;
+        }
+        delete geodesicOperator;
+        
+        const float elapsedTime = timer.elapsed() * 0.001;
+        if (DebugControl::getDebugOn()) {
+            std::cout << "Time to determine neighbors: " << elapsedTime << " seconds." << std::endl;
+        }
+        return;
+    }
+    
+    //
+    // Get the topology helper, searches to depth do not lock so it is
+    // shared by all threads
+    //
+    const TopologyFile* topologyFile = fiducialSurface->getTopologyFile();
+    const TopologyHelper topologyHelper(topologyFile, false, true, false);
+
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
     {
-        //
-        // Get the topology helper
-        //
-        const TopologyFile* topologyFile = fiducialSurface->getTopologyFile();
-        const TopologyHelper topologyHelper(topologyFile, false, true, false);//each thread gets its own, due to locks slowing it down otherwise
-
         //
         // Coordinate file and maximum distance cutoff
         //
         CoordinateFile* cf = fiducialSurface->getCoordinateFile();
-        GeodesicHelper* gh = NULL;
         float maxDistanceCutoff = std::numeric_limits<float>::max();
-        float geoCutoff = 4.0f * geodesicGaussSigma;
-        std::vector<float>* geoGaussWeight = NULL, distance;
         switch (algorithm) {
         case SMOOTH_ALGORITHM_AVERAGE_NEIGHBORS:
             break;
@@ -576,9 +604,6 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
                                          gaussTangentCutoff);
             break;
         case SMOOTH_ALGORITHM_GEODESIC_GAUSSIAN:
-            cf = fiducialSurface->getCoordinateFile();
-            gh = new GeodesicHelper(cf, topologyFile);//each thread gets its own
-            geoGaussWeight = new std::vector<float>;
             break;
         case SMOOTH_ALGORITHM_NONE:
             break;
@@ -592,8 +617,6 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
 #endif
         for (int i = 0; i < numberOfNodes; i++) {
             std::vector<int> neighbors;
-            int numNeigh;
-            float tempf;
 
             switch (algorithm) {
             case SMOOTH_ALGORITHM_AVERAGE_NEIGHBORS:
@@ -616,20 +639,6 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
             }
             break;
             case SMOOTH_ALGORITHM_GEODESIC_GAUSSIAN:
-                gh->getNodesToGeoDist(i, geoCutoff, neighbors, distance, true);
-                if (neighbors.size() < 7)//5 neighbor nodes may fail this unneccesarily, but better than letting 6 neighbor nodes slip through with 5
-                {//in case a really small kernel is specified
-                    topologyHelper.getNodeNeighbors(i, neighbors);
-                    neighbors.push_back(i);//for geogauss, we want the center node in the list
-                    gh->getGeoToTheseNodes(i, neighbors, distance, true);
-                }
-                numNeigh = (int)neighbors.size();
-                geoGaussWeight->resize(numNeigh);
-                for (int j = 0; j < numNeigh; ++j)
-                {
-                   tempf = distance[j] / geodesicGaussSigma;
-                   (*geoGaussWeight)[j] = std::exp(-tempf * tempf * 0.5f);//the gaussian function
-                }
                 break;
             case SMOOTH_ALGORITHM_NONE:
                 break;
@@ -638,10 +647,8 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
             //
             // add to all neighbors
             //
-            nodeNeighbors[i] = NeighborInfo(cf, i, neighbors, maxDistanceCutoff, geoGaussWeight);
+            nodeNeighbors[i] = NeighborInfo(cf, i, neighbors, maxDistanceCutoff);
         }
-        if (gh) delete gh;
-        if (geoGaussWeight) delete geoGaussWeight;
     }//omp parallel
     const float elapsedTime = timer.elapsed() * 0.001;
     if (DebugControl::getDebugOn()) {
@@ -24,6 +24,7 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <limits>
 #include <set>
 #include <QDateTime>
@@ -31,6 +32,7 @@
 #include <cmath>
 
 #include "BrainModelSurface.h"
+#include "BrainModelSurfaceGeodesicGaussianOperator.h"
 #include "BrainModelSurfaceMetricFullWidthHalfMaximum.h"
 #include "BrainModelSurfaceMetricSmoothingAll.h"
 #include "DebugControl.h"
@@ -195,9 +197,20 @@ BrainModelSurfaceMetricSmoothingAll::execute() throw (BrainModelAlgorithmExcepti
                              gaussTangentCutoff);
    
    //
-   // Determine the neighbors for each node
+   // Geodesic gaussian uses a precomputed sparse operator that is cached 
+   // per surface, all other algorithms determine the neighbors for each node
    //
-   determineNeighbors();
+   BrainModelSurfaceGeodesicGaussianOperator* geodesicOperator = NULL;
+   if (algorithm == SMOOTH_ALGORITHM_GEODESIC_GAUSSIAN) {
+      geodesicOperator = 
+         BrainModelSurfaceGeodesicGaussianOperator::getOperator(fiducialSurface,
+                                                                geodesicGaussSigma,
+                                                                6,
+                                                                runParallelFlag);
+   }
+   else {
+      determineNeighbors();
+   }
    
    //
    // Add comments describing smoothing
@@ -263,7 +276,25 @@ BrainModelSurfaceMetricSmoothingAll::execute() throw (BrainModelAlgorithmExcepti
    this->runParallelFlag = false;
 #endif 
 
-   if (this->smoothAllColumnsFlag) {
+   if (geodesicOperator != NULL) {
+      std::vector<int> inputColumns, outputColumns;
+      if (this->smoothAllColumnsFlag) {
+         for (int i = 0; i < this->metricFile->getNumberOfColumns(); i++) {
+            inputColumns.push_back(i);
+            outputColumns.push_back(i);
+         }
+      }
+      else {
+         inputColumns.push_back(column);
+         outputColumns.push_back(outputColumn);
+      }
+      this->smoothColumnsWithGeodesicOperator(*geodesicOperator,
+                                              smoothComment,
+                                              inputColumns,
+                                              outputColumns);
+      delete geodesicOperator;
+   }
+   else if (this->smoothAllColumnsFlag) {
       int numColumns = this->metricFile->getNumberOfColumns();
       
       if (this->runParallelFlag) {
@@ -296,6 +327,67 @@ BrainModelSurfaceMetricSmoothingAll::execute() throw (BrainModelAlgorithmExcepti
    }
 }
 
+/**
+ * smooth columns with the geodesic gaussian operator.  Columns are smoothed in
+ * blocks so that each operator weight is applied to many columns at once.
+ */
+void 
+BrainModelSurfaceMetricSmoothingAll::smoothColumnsWithGeodesicOperator(
+                         const BrainModelSurfaceGeodesicGaussianOperator& geodesicOperator,
+                         const QString& columnDescription,
+                         const std::vector<int>& inputColumns,
+                         const std::vector<int>& outputColumns)
+{
+   const int numColumns = static_cast<int>(inputColumns.size());
+   const int maximumColumnsPerBlock = 16;
+   
+   std::vector<float> columnValues(numberOfNodes);
+   for (int firstColumn = 0; firstColumn < numColumns; firstColumn += maximumColumnsPerBlock) {
+      const int blockColumns = std::min(maximumColumnsPerBlock, numColumns - firstColumn);
+      
+      //
+      // Load the block with all of a node's columns adjacent
+      //
+      std::vector<float> blockValues(numberOfNodes * blockColumns);
+      std::vector<float> smoothedValues(numberOfNodes * blockColumns);
+      for (int k = 0; k < blockColumns; k++) {
+         metricFile->getColumnForAllNodes(inputColumns[firstColumn + k], columnValues);
+         for (int i = 0; i < numberOfNodes; i++) {
+            blockValues[i * blockColumns + k] = columnValues[i];
+         }
+      }
+      
+      //
+      // Geodesic gaussian ignores strength, each iteration applies the operator
+      //
+      for (int iter = 0; iter < iterations; iter++) {
+         geodesicOperator.apply(&blockValues[0], 
+                                &smoothedValues[0], 
+                                blockColumns, 
+                                runParallelFlag);
+         blockValues.swap(smoothedValues);
+      }
+      
+      //
+      // Copy the smoothed values to the output columns
+      //
+      for (int k = 0; k < blockColumns; k++) {
+         const int smoothColumn = outputColumns[firstColumn + k];
+         for (int i = 0; i < numberOfNodes; i++) {
+            columnValues[i] = blockValues[i * blockColumns + k];
+         }
+         metricFile->setColumnForAllNodes(smoothColumn, columnValues);
+         
+         QString smoothComment(metricFile->getColumnComment(smoothColumn));
+         if (smoothComment.isEmpty() == false) {
+            smoothComment.append("\n");
+         }
+         smoothComment.append(columnDescription);
+         metricFile->setColumnComment(smoothColumn, smoothComment);
+      }
+   }
+}
+
 /**
  * smooth a column in the metric file.
  */
@@ -32,6 +32,7 @@
 #include "BrainModelAlgorithm.h"
 
 class BrainModelSurface;
+class BrainModelSurfaceGeodesicGaussianOperator;
 class CoordinateFile;
 class GaussianComputation;
 class MetricFile;
@@ -103,6 +104,13 @@ class BrainModelSurfaceMetricSmoothingAll : public BrainModelAlgorithm {
                                const int outputColumn,
                                const GaussianComputation& gauss);
                                
+      // smooth columns with the geodesic gaussian operator
+      void smoothColumnsWithGeodesicOperator(
+                       const BrainModelSurfaceGeodesicGaussianOperator& geodesicOperator,
+                       const QString& columnDescription,
+                       const std::vector<int>& inputColumns,
+                       const std::vector<int>& outputColumns);
+                               
       /// determine neighbors for each node
       void determineNeighbors();
       
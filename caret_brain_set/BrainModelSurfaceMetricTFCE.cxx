@@ -0,0 +1,197 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include "BrainModelSurface.h"
+#include "BrainModelSurfaceMetricTFCE.h"
+#include "MetricFile.h"
+#include "TFCEUnionFind.h"
+#include "TopologyFile.h"
+#include "TopologyHelper.h"
+
+/**
+ * Constructor.
+ */
+BrainModelSurfaceMetricTFCE::BrainModelSurfaceMetricTFCE(BrainSet* bs,
+                                                         BrainModelSurface* surfaceIn,
+                                                         MetricFile* inputMetricIn,
+                                                         MetricFile* outputMetricIn,
+                                                         const int numStepsIn,
+                                                         const float EIn,
+                                                         const float HIn)
+   : BrainModelAlgorithm(bs)
+{
+   surface = surfaceIn;
+   inputMetric = inputMetricIn;
+   outputMetric = outputMetricIn;
+   numSteps = numStepsIn;
+   E = EIn;
+   H = HIn;
+}
+                                      
+/**
+ * Destructor.
+ */
+BrainModelSurfaceMetricTFCE::~BrainModelSurfaceMetricTFCE()
+{
+}
+
+/**
+ * execute the algorithm.  Every column of the input metric is enhanced
+ * into the same column of the output metric.  Cluster extent is the sum
+ * of the surface's node areas.
+ */
+void 
+BrainModelSurfaceMetricTFCE::execute() throw (BrainModelAlgorithmException)
+{
+   //
+   // Verify files exist, are valid, etc.
+   //
+   if (surface == NULL) {
+      throw BrainModelAlgorithmException("Invalid surface.");
+   }
+   const TopologyFile* tf = surface->getTopologyFile();
+   if (tf == NULL) {
+      throw BrainModelAlgorithmException("Surface has no topology.");
+   }
+   if (inputMetric == NULL) {
+      throw BrainModelAlgorithmException("Invalid input metric file.");
+   }
+   if (outputMetric == NULL) {
+      throw BrainModelAlgorithmException("Invalid output metric file.");
+   }
+   const int numNodes = surface->getNumberOfNodes();
+   if (numNodes < 1) {
+      throw BrainModelAlgorithmException("Surface has no nodes.");
+   }
+   if (numNodes != inputMetric->getNumberOfNodes()) {
+      throw BrainModelAlgorithmException("Node numbers do not match.");
+   }
+   const int numColumns = inputMetric->getNumberOfColumns();
+   if (numColumns <= 0) {
+      throw BrainModelAlgorithmException("Input metric file has no columns.");
+   }
+   
+   if (outputMetric != inputMetric) {
+      outputMetric->setNumberOfNodesAndColumns(numNodes, numColumns);
+      for (int j = 0; j < numColumns; j++) {
+         outputMetric->setColumnName(j, "TFCE " + inputMetric->getColumnName(j));
+      }
+   }
+   
+   //
+   // Build the topology helper before threads use it
+   //
+   const TopologyHelper* th = tf->getTopologyHelper(false, true, false);
+   std::vector<float> nodeAreas;
+   surface->getAreaOfAllNodes(nodeAreas);
+   
+   //
+   // Columns are independent so they are divided among threads
+   //
+   std::vector<std::vector<float> > enhanced(numColumns);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+   for (int j = 0; j < numColumns; j++) {
+      std::vector<float> values(numNodes, 0.0f);
+      inputMetric->getColumnForAllNodes(j, &values[0]);
+      enhanced[j].resize(numNodes, 0.0f);
+      computeTFCE(&values[0],
+                  numNodes,
+                  th,
+                  &nodeAreas[0],
+                  numSteps,
+                  E,
+                  H,
+                  &enhanced[j][0]);
+   }
+   
+   for (int j = 0; j < numColumns; j++) {
+      outputMetric->setColumnForAllNodes(j, enhanced[j]);
+   }
+}
+
+/**
+ * compute TFCE of one column of node values.  Thresholds are at the
+ * center of each of "numSteps" equal steps from zero to the maximum value.
+ * Nodes are sorted once and thresholds are swept from high to low, adding
+ * nodes to a union-find forest and merging them with their topological
+ * neighbors.  If "nodeAreas" is NULL, cluster extent is the node count.
+ */
+void 
+BrainModelSurfaceMetricTFCE::computeTFCE(const float* values,
+                                         const int numNodes,
+                                         const TopologyHelper* topologyHelper,
+                                         const float* nodeAreas,
+                                         const int numSteps,
+                                         const float E,
+                                         const float H,
+                                         float* enhancedOut)
+{
+   float fmax = 0.0f;
+   for (int i = 0; i < numNodes; i++) {
+      if (values[i] > fmax) fmax = values[i];
+      enhancedOut[i] = 0.0f;
+   }
+   if ((fmax <= 0.0f) || (numSteps < 1)) {
+      return;
+   }
+   
+   std::vector<int> sortedNodes;
+   TFCEUnionFind::getElementsSortedByDecreasingValue(values, numNodes, sortedNodes);
+   const int numSorted = static_cast<int>(sortedNodes.size());
+   
+   const float dh = fmax / numSteps;
+   TFCEUnionFind clusters(numNodes, nodeAreas);
+   int nextSorted = 0;
+   for (int step = numSteps - 1; step >= 0; step--) {
+      const float thresh = dh * (step + 0.5f);
+      
+      //
+      // Add nodes at or above this threshold and join their neighbors
+      //
+      while ((nextSorted < numSorted) &&
+             (values[sortedNodes[nextSorted]] >= thresh)) {
+         const int node = sortedNodes[nextSorted];
+         nextSorted++;
+         clusters.addElement(node);
+         
+         int numNeighbors = 0;
+         const int* neighbors = topologyHelper->getNodeNeighbors(node, numNeighbors);
+         for (int k = 0; k < numNeighbors; k++) {
+            if (clusters.isElementAdded(neighbors[k])) {
+               clusters.mergeElements(node, neighbors[k]);
+            }
+         }
+      }
+      
+      clusters.addEnhancementForThreshold(thresh, dh, E, H);
+   }
+   
+   for (int m = 0; m < nextSorted; m++) {
+      const int node = sortedNodes[m];
+      enhancedOut[node] = clusters.getElementEnhancement(node);
+   }
+}
@@ -0,0 +1,84 @@
+#ifndef __BRAIN_MODEL_SURFACE_METRIC_TFCE_H__
+#define __BRAIN_MODEL_SURFACE_METRIC_TFCE_H__
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+#include "BrainModelAlgorithm.h"
+
+class BrainModelSurface;
+class MetricFile;
+class TopologyHelper;
+
+/// class for threshold free cluster enhancement of metric columns on a surface
+class BrainModelSurfaceMetricTFCE : public BrainModelAlgorithm {
+   public:
+      /// Constructor
+      BrainModelSurfaceMetricTFCE(BrainSet* bs,
+                                  BrainModelSurface* surfaceIn,
+                                  MetricFile* inputMetricIn,
+                                  MetricFile* outputMetricIn,
+                                  const int numStepsIn = 50,
+                                  const float EIn = 0.5f,
+                                  const float HIn = 2.0f);
+                                            
+      /// Destructor
+      ~BrainModelSurfaceMetricTFCE();
+      
+      /// execute the algorithm
+      void execute() throw (BrainModelAlgorithmException);
+      
+      /// compute TFCE of one column of node values
+      static void computeTFCE(const float* values,
+                              const int numNodes,
+                              const TopologyHelper* topologyHelper,
+                              const float* nodeAreas,
+                              const int numSteps,
+                              const float E,
+                              const float H,
+                              float* enhancedOut);
+      
+      ///default parameters
+      static inline const int defaultNumSteps() { return 50; };
+      static inline const float defaultE() { return 0.5f; };
+      static inline const float defaultH() { return 2.0f; };
+      
+   protected:
+      /// surface whose topology and node areas define clusters
+      BrainModelSurface* surface;
+      
+      /// input metric file (all columns are enhanced)
+      MetricFile* inputMetric;
+      
+      /// output metric file
+      MetricFile* outputMetric;
+      
+      /// parameter storage
+      float H, E;
+      int numSteps;
+};
+
+#endif // __BRAIN_MODEL_SURFACE_METRIC_TFCE_H__
@@ -24,6 +24,7 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <sstream>
@@ -43,7 +44,229 @@
 #include "StatisticDataGroup.h"
 #include "StatisticMeanAndDeviation.h"
 #include "StatisticRankTransformation.h"
+#include "StatisticRandomNumber.h"
+#include "StatisticRandomNumberStream.h"
 #include "TopologyFile.h"
+#include "TopologyHelper.h"
+
+/// Computes the T-Map of one shuffle of the columns of the two groups.
+/// Column data is stored contiguously so the per-node loops vectorize.
+class TwoSampleTTestPermutationGenerator 
+   : public BrainModelSurfaceMetricFindClustersBase::PermutationGenerator {
+   public:
+      /// constructor
+      TwoSampleTTestPermutationGenerator(const MetricFile& mfA,
+                                         const MetricFile& mfB,
+                                         const TopologyFile* topologyFile,
+                                         const int varianceSmoothingIterationsIn,
+                                         const float varianceSmoothingStrengthIn,
+                                         const bool pooledVarianceFlagIn);
+      
+      /// compute the T-Map of a shuffle
+      void computePermutation(const int permutationIndex,
+                              float* statisticalMapOut) const;
+      
+   protected:
+      /// compute mean and variance of shuffled columns
+      void computeMeanAndVariance(const std::vector<int>& columns,
+                                  const int firstColumn,
+                                  const int numberOfColumnsInGroup,
+                                  float* meanOut,
+                                  float* varianceOut) const;
+      
+      /// smooth variance by averaging with neighbors
+      void smoothVariance(std::vector<float>& variance,
+                          std::vector<float>& workspace) const;
+      
+      /// column data (one column after another)
+      std::vector<float> columnData;
+      
+      /// number of nodes
+      int numberOfNodes;
+      
+      /// number of columns in both groups
+      int numberOfColumns;
+      
+      /// number of columns in group A
+      int numberOfColumnsA;
+      
+      /// topology helper for variance smoothing
+      const TopologyHelper* topologyHelper;
+      
+      /// variance smoothing iterations
+      int varianceSmoothingIterations;
+      
+      /// variance smoothing strength
+      float varianceSmoothingStrength;
+      
+      /// pool the variance
+      bool pooledVarianceFlag;
+      
+      /// key for the random number streams of the shuffles
+      unsigned int streamKey;
+};
+
+/**
+ * constructor.
+ */
+TwoSampleTTestPermutationGenerator::TwoSampleTTestPermutationGenerator(
+                                         const MetricFile& mfA,
+                                         const MetricFile& mfB,
+                                         const TopologyFile* topologyFile,
+                                         const int varianceSmoothingIterationsIn,
+                                         const float varianceSmoothingStrengthIn,
+                                         const bool pooledVarianceFlagIn)
+{
+   numberOfNodes = mfA.getNumberOfNodes();
+   numberOfColumnsA = mfA.getNumberOfColumns();
+   numberOfColumns = numberOfColumnsA + mfB.getNumberOfColumns();
+   columnData.resize(static_cast<long>(numberOfColumns) * numberOfNodes);
+   for (int j = 0; j < numberOfColumns; j++) {
+      float* column = &columnData[static_cast<long>(j) * numberOfNodes];
+      if (j < numberOfColumnsA) {
+         mfA.getColumnForAllNodes(j, column);
+      }
+      else {
+         mfB.getColumnForAllNodes(j - numberOfColumnsA, column);
+      }
+   }
+   
+   //
+   // Build the topology helper now so it is not built while threads use it
+   //
+   topologyHelper = NULL;
+   varianceSmoothingIterations = varianceSmoothingIterationsIn;
+   varianceSmoothingStrength = varianceSmoothingStrengthIn;
+   if (varianceSmoothingIterations > 0) {
+      topologyHelper = topologyFile->getTopologyHelper(false, true, false);
+   }
+   pooledVarianceFlag = pooledVarianceFlagIn;
+   
+   streamKey = StatisticRandomNumber::getStreamKey();
+}
+
+/**
+ * compute mean and variance of shuffled columns.
+ */
+void 
+TwoSampleTTestPermutationGenerator::computeMeanAndVariance(const std::vector<int>& columns,
+                                                           const int firstColumn,
+                                                           const int numberOfColumnsInGroup,
+                                                           float* meanOut,
+                                                           float* varianceOut) const
+{
+   for (int i = 0; i < numberOfNodes; i++) {
+      meanOut[i] = 0.0;
+      varianceOut[i] = 0.0;
+   }
+   if (numberOfColumnsInGroup <= 0) {
+      return;
+   }
+   
+   for (int j = 0; j < numberOfColumnsInGroup; j++) {
+      const float* column = &columnData[static_cast<long>(columns[firstColumn + j]) * numberOfNodes];
+      for (int i = 0; i < numberOfNodes; i++) {
+         meanOut[i] += column[i];
+      }
+   }
+   const float oneOverNumber = 1.0 / numberOfColumnsInGroup;
+   for (int i = 0; i < numberOfNodes; i++) {
+      meanOut[i] *= oneOverNumber;
+   }
+   
+   if (numberOfColumnsInGroup <= 1) {
+      return;
+   }
+   for (int j = 0; j < numberOfColumnsInGroup; j++) {
+      const float* column = &columnData[static_cast<long>(columns[firstColumn + j]) * numberOfNodes];
+      for (int i = 0; i < numberOfNodes; i++) {
+         const float d = column[i] - meanOut[i];
+         varianceOut[i] += d * d;
+      }
+   }
+   const float oneOverNumberMinusOne = 1.0 / (numberOfColumnsInGroup - 1);
+   for (int i = 0; i < numberOfNodes; i++) {
+      varianceOut[i] *= oneOverNumberMinusOne;
+   }
+}
+
+/**
+ * smooth variance by averaging with neighbors (same as
+ * MetricFile::smoothAverageNeighbors()).
+ */
+void 
+TwoSampleTTestPermutationGenerator::smoothVariance(std::vector<float>& variance,
+                                                   std::vector<float>& workspace) const
+{
+   const float oneMinusStrength = 1.0 - varianceSmoothingStrength;
+   for (int iter = 0; iter < varianceSmoothingIterations; iter++) {
+      for (int i = 0; i < numberOfNodes; i++) {
+         workspace[i] = variance[i];
+         int numNeighbors = 0;
+         const int* neighbors = topologyHelper->getNodeNeighbors(i, numNeighbors);
+         if (numNeighbors > 0) {
+            float neighborSum = 0.0;
+            for (int j = 0; j < numNeighbors; j++) {
+               neighborSum += variance[neighbors[j]];
+            }
+            const float neighborAverage = neighborSum / static_cast<float>(numNeighbors);
+            workspace[i] = (variance[i] * oneMinusStrength)
+                         + (neighborAverage * varianceSmoothingStrength);
+         }
+      }
+      variance.swap(workspace);
+   }
+}
+
+/**
+ * compute the T-Map of a shuffle.  The shuffle is the same one that 
+ * MetricFile::computeStatisticalShuffledTMap() makes for this repetition.
+ */
+void 
+TwoSampleTTestPermutationGenerator::computePermutation(const int permutationIndex,
+                                                       float* statisticalMapOut) const
+{
+   std::vector<int> columns(numberOfColumns);
+   for (int j = 0; j < numberOfColumns; j++) {
+      columns[j] = j;
+   }
+   StatisticRandomNumberStream randomStream(streamKey, permutationIndex);
+   std::random_shuffle(columns.begin(), columns.end(), randomStream);
+   
+   const int numberOfColumnsB = numberOfColumns - numberOfColumnsA;
+   std::vector<float> mean1(numberOfNodes), var1(numberOfNodes);
+   std::vector<float> mean2(numberOfNodes), var2(numberOfNodes);
+   computeMeanAndVariance(columns, 0, numberOfColumnsA, &mean1[0], &var1[0]);
+   computeMeanAndVariance(columns, numberOfColumnsA, numberOfColumnsB, &mean2[0], &var2[0]);
+   
+   if (varianceSmoothingIterations > 0) {
+      std::vector<float> workspace(numberOfNodes);
+      smoothVariance(var1, workspace);
+      smoothVariance(var2, workspace);
+   }
+   
+   //
+   // Same t-statistic as MetricFile::computeStatisticalTMap()
+   //
+   const float n1 = numberOfColumnsA;
+   const float n2 = numberOfColumnsB;
+   const float pooledOneOverSqrtN1N2 = std::sqrt((1.0 / n1) + (1.0 / n2));
+   for (int i = 0; i < numberOfNodes; i++) {
+      float denom = 1.0;
+      if (pooledVarianceFlag) {
+         const float s2Pooled = ((n1 - 1.0f) * var1[i] + (n2 - 1.0f) * var2[i])
+                              / (n1 + n2 - 2.0f);
+         denom = std::sqrt(s2Pooled) * pooledOneOverSqrtN1N2;
+      }
+      else {
+         denom = std::sqrt((var1[i] / n1) + (var2[i] / n2));
+      }
+      if (denom == 0.0) {
+         denom = 1.0;
+      }
+      statisticalMapOut[i] = (mean1[i] - mean2[i]) / denom;
+   }
+}
 
 /**
  * constructor.
@@ -96,6 +319,7 @@ BrainModelSurfaceMetricTwoSampleTTest::BrainModelSurfaceMetricTwoSampleTTest(
    shapeFileAName = shapeFileANameIn;
    shapeFileBName = shapeFileBNameIn;
    iterations = iterationsIn;
+   numberOfShuffledTMapsToSave = 10;
 }
       
 /**
@@ -289,6 +513,8 @@ BrainModelSurfaceMetricTwoSampleTTest::executeClusterSearch() throw (BrainModelA
                         ALG_STEP_SHUFFLED_TMAP,
                         ALG_NUM_STEPS);
                         
+   std::vector<Cluster> shuffleTMapClusters;
+   bool shuffleTMapClustersFoundFlag = false;
    switch (varianceMode) {
       case VARIANCE_MODE_SIGMA:
          tMapColumn = 0;
@@ -320,29 +546,34 @@ BrainModelSurfaceMetricTwoSampleTTest::executeClusterSearch() throw (BrainModelA
       case VARIANCE_MODE_UNPOOLED:
          {
             //
-            // Combine input shape for shuffled T-Map
-            //
-            MetricFile allShape = ssfA;
-            allShape.append(ssfB);
-            
-            //
-            // Do shuffled T-Map
+            // Shuffled T-Maps are reduced to their largest cluster as they
+            // are computed, only a few are kept for the shuffled T-Map file
             //
-            try {
-               shuffleStatisticalMapShapeFile = allShape.computeStatisticalShuffledTMap(iterations,
-                                                                         ssfA.getNumberOfColumns(),
-                                                                         brain->getTopologyFile(0),
-                                                                         tVarianceSmoothingIterations,
-                                                                         tVarianceSmoothingStrength,
-                                                                         pooledVarianceFlag);
-            }
-            catch (FileException& e) {
-               std::ostringstream str;
-               str << "Shuffled T-Map failure: "
-                   << e.whatQString().toAscii().constData();
-               cleanUp();
-               throw BrainModelAlgorithmException(str.str().c_str());
+            const int numMapsToSave = std::max(0, std::min(numberOfShuffledTMapsToSave, 
+                                                           iterations));
+            shuffleStatisticalMapShapeFile = new MetricFile;
+            shuffleStatisticalMapShapeFile->setNumberOfNodesAndColumns(numberOfNodes, 
+                                                                      numMapsToSave);
+            shuffleStatisticalMapShapeFile->appendToFileComment("Shuffled Columns T-Map from ");
+            shuffleStatisticalMapShapeFile->appendToFileComment(FileUtilities::basename(shapeFileAName));
+            shuffleStatisticalMapShapeFile->appendToFileComment(" and ");
+            shuffleStatisticalMapShapeFile->appendToFileComment(FileUtilities::basename(shapeFileBName));
+            for (int j = 0; j < numMapsToSave; j++) {
+               shuffleStatisticalMapShapeFile->setColumnName(j, "Shuffled T-Map " + QString::number(j + 1));
             }
+            
+            TwoSampleTTestPermutationGenerator generator(ssfA,
+                                                         ssfB,
+                                                         brain->getTopologyFile(0),
+                                                         tVarianceSmoothingIterations,
+                                                         tVarianceSmoothingStrength,
+                                                         pooledVarianceFlag);
+            findLargestClusterInPermutations(generator,
+                                             iterations,
+                                             shuffleTMapClusters,
+                                             "Finding Clusters in Shuffled T-Map",
+                                             shuffleStatisticalMapShapeFile);
+            shuffleTMapClustersFoundFlag = true;
          };
          break;
    }
@@ -385,13 +616,15 @@ BrainModelSurfaceMetricTwoSampleTTest::executeClusterSearch() throw (BrainModelA
    // find the clusters in Shuffled T-Map
    // Note: Only use largest cluster from each column
    //
-   std::vector<Cluster> shuffleTMapClusters;
-   findClusters(shuffleStatisticalMapShapeFile, shuffleTMapClusters, "Finding Clusters in Shuffled T-Map", -1, true);
+   if (shuffleTMapClustersFoundFlag == false) {
+      findClusters(shuffleStatisticalMapShapeFile, shuffleTMapClusters, "Finding Clusters in Shuffled T-Map", -1, true);
+   }
+   setNamesForClusters(shuffleTMapClusters);
    
    //
    // Set pValue for shuffled T-Map
    // 
-   setRandomizedClusterPValues(*shuffleStatisticalMapShapeFile,
+   setRandomizedClusterPValues(iterations,
                                shuffleTMapClusters);
                                
    //
@@ -85,6 +85,10 @@ class BrainModelSurfaceMetricTwoSampleTTest : public BrainModelSurfaceMetricFind
       // destructor
       ~BrainModelSurfaceMetricTwoSampleTTest();
       
+      /// set number of shuffled T-Maps saved in the shuffled T-Map file
+      /// (pooled and unpooled variance only)
+      void setNumberOfShuffledTMapsToSave(const int num) { numberOfShuffledTMapsToSave = num; }
+      
    protected:
       /// must be implemented by subclasses
       void executeClusterSearch() throw (BrainModelAlgorithmException);
@@ -123,6 +127,9 @@ class BrainModelSurfaceMetricTwoSampleTTest : public BrainModelSurfaceMetricFind
       
       /// the variance mode
       VARIANCE_MODE varianceMode;
+      
+      /// number of shuffled T-Maps saved in the shuffled T-Map file
+      int numberOfShuffledTMapsToSave;
 };
 
 #endif // __BRAIN_MODEL_SURFACE_SHAPE_TWO_SAMPLE_H__
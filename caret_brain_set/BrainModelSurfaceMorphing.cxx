@@ -45,14 +45,12 @@
 #include "DebugControl.h"
 #include "FileUtilities.h"
 #include "MathUtilities.h"
+#include "SpaceFillingCurve.h"
 #include "StatisticsUtilities.h"
 #include "StringUtilities.h"
 #include "SurfaceShapeFile.h"
 #include "TopologyHelper.h"
 
-#include "vtkMath.h"
-#include "vtkTriangle.h"
-
 /**
  * Constructor
  */
@@ -88,34 +86,6 @@ BrainModelSurfaceMorphing::BrainModelSurfaceMorphing(BrainSet* brainSetIn,
    setNumberOfThreadsToRun(numThreads);
 }
 
-/**
- * Constructor for a thread instance.
- */
-BrainModelSurfaceMorphing::BrainModelSurfaceMorphing(BrainSet* brainSetIn,
-                                           BrainModelSurface* referenceSurfaceIn,
-                                           BrainModelSurface* morphingSurfaceIn,
-                                           const MORPHING_SURFACE_TYPE morphingSurfaceTypeIn,
-                                           NeighborInformation* morphNodeInfoIn,
-                                           int* nodeShouldBeMorphedIn,
-                                           const float noMorphStepSizeIn,
-                                           const int startNodeIndexIn,
-                                           const int endNodeIndexIn,
-                                           const float sphericalSurfaceRadiusIn,
-                                           BrainModelSurfaceMorphing* parentOfThisThreadIn,
-                                           const int threadNumberIn)
-   : BrainModelAlgorithmMultiThreaded(brainSetIn, parentOfThisThreadIn, threadNumberIn, true)
-{
-   referenceSurface    = referenceSurfaceIn;
-   morphingSurface     = morphingSurfaceIn;
-   morphingSurfaceType = morphingSurfaceTypeIn;
-   morphNodeInfo       = morphNodeInfoIn;
-   nodeShouldBeMorphed = nodeShouldBeMorphedIn;
-   noMorphNeighborStepSize = noMorphStepSizeIn;
-   startNodeIndex = startNodeIndexIn;
-   endNodeIndex   = endNodeIndexIn;
-   sphericalSurfaceRadius = sphericalSurfaceRadiusIn;
-}                                           
-                                           
 /**
  * Initialize variables for this instance.
  */
@@ -124,9 +94,6 @@ BrainModelSurfaceMorphing::initialize()
 {
    doStatisticsEachPass = false;
    
-   coordsArray1 = NULL;
-   coordsArray2 = NULL;
-   morphNodeInfo = NULL;
    referenceSurface = NULL;
    morphingSurface  = NULL;
    iterations      = 1;
@@ -134,10 +101,13 @@ BrainModelSurfaceMorphing::initialize()
    angularForce = 0.30;
    stepSize     = 0.5;
    noMorphNeighborStepSize = 0.5;
+   sphereFiducialDistortionFraction = 0.0;
+   sphericalSurfaceRadius = 0.0;
    
    nodeShouldBeMorphed = NULL;
    numberOfNodes = 0;
    allNodesBeingMorphed = true;
+   inputBufferIndex = 0;
 
    setNumberOfThreadsToRun(1);
 }
@@ -147,24 +117,8 @@ BrainModelSurfaceMorphing::initialize()
  */
 BrainModelSurfaceMorphing::~BrainModelSurfaceMorphing()
 {
-   if (getImAThread() == false) {
-      if (coordsArray1 != NULL) {
-         delete[] coordsArray1;
-      }
-      if (coordsArray2 != NULL) {
-         delete[] coordsArray2;
-      }
-      if (morphNodeInfo != NULL) {
-         delete[] morphNodeInfo;
-      }
-      if (nodeShouldBeMorphed != NULL) {
-         delete[] nodeShouldBeMorphed;
-      }
-      for (unsigned int i = 0; i < threads.size(); i++) {
-         if (threads[i] != NULL) {
-            delete threads[i];
-         }
-      }
+   if (nodeShouldBeMorphed != NULL) {
+      delete[] nodeShouldBeMorphed;
    }
 }
 
@@ -198,6 +152,7 @@ BrainModelSurfaceMorphing::setMorphingParameters(const int iterationsIn,
    stepSize     = stepSizeIn;
 }
                            
+                           
 /**
  * execute the morphing
  */
@@ -229,23 +184,9 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
    //
    CoordinateFile* morphCoordFile = morphingSurface->getCoordinateFile();
    
-   //
-   // Get the coordinates and load them into arrays
-   //
-   float* coordsArray1 = new float[numberOfNodes * 3];
-   float* coordsArray2 = new float[numberOfNodes * 3];
-   for (int i = 0; i < numberOfNodes; i++) {
-      morphCoordFile->getCoordinate(i, &coordsArray1[i*3]);
-   }
-   
-   //
-   // Set the input and output coord pointers
-   //
-   inputCoords  = coordsArray1;
-   outputCoords = coordsArray2;
-   
    //
    // Generate neighbors, lengths, and angles for reference surface
+   // and load the morphing surface's coordinates
    //
    generateNeighborInformation();
    
@@ -279,56 +220,6 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
    //
    SurfaceShapeFile measurementsShapeFile;
    
-   //
-   // See if threads are being used, and if so, create them.
-   //
-   const int numberOfThreads = getNumberOfThreadsToRun();
-   if (numberOfThreads > 1) {
-      //
-      // Number of nodes each thread should smooth
-      //
-      const int numNodesPerThread = numberOfNodes / numberOfThreads;
-      int startNode = 0;
-      int endNode   = numNodesPerThread;
-      for (int i = 0; i < numberOfThreads; i++) {
-         //
-         // Limit ending node for last thread
-         //
-         if (i == (numberOfThreads - 1)) {
-            endNode = numberOfNodes - 1;
-         }
-         if (DebugControl::getDebugOn()) {
-            std::cout << "Morphing thread " << i << " nodes " 
-                      << startNode << " " << endNode << std::endl;
-         }
-         
-         //
-         // Create the threads
-         //
-         BrainModelSurfaceMorphing* bmsm = new BrainModelSurfaceMorphing(
-                                                            brainSet,
-                                                            referenceSurface,
-                                                            morphingSurface,
-                                                            morphingSurfaceType,
-                                                            morphNodeInfo,
-                                                            nodeShouldBeMorphed,
-                                                            noMorphNeighborStepSize,
-                                                            startNode,
-                                                            endNode,
-                                                            sphericalSurfaceRadius,
-                                                            this,
-                                                            i);
-         bmsm->setMorphingParameters(iterations, linearForce, angularForce, stepSize);
-         threads.push_back(bmsm);  
-         
-         //
-         // Determine node indices which each thread should smooth
-         //
-         startNode = endNode + 1;
-         endNode   += numNodesPerThread;
-      }
-   }
-   
    //
    // morph for the surface
    //
@@ -336,104 +227,18 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
       const bool firstIterationFlag = (i == 1);
       const bool lastIterationFlag = (i == iterations);
       
-      //
-      // Update surface normals
-      //
-      //for (int j = 0; j < numberOfNodes; j++) {
-      //   morphCoordFile->setCoordinate(j, &inputCoords[j*3]);
-      //}
-      //morphingSurface->computeNormals();
-      morphingSurface->computeNormals(inputCoords);
-      //
-      // Set the forces on nodes that are NOT being morphed
-      //
-      if (allNodesBeingMorphed == false) {
-         setForcesOnNoMorphNodes();
-      }
-      
-      //
-      // If running threads
-      //
-      if (numberOfThreads > 1) {
-         for (int j = 0; j < numberOfThreads; j++) {
-            //
-            // Run each thread for an iteration of smoothing
-            //
-            threads[j]->setInputAndOutputCoords(inputCoords, outputCoords);
-            
-            //
-            // Clear the number of child threads done
-            //
-            resetNumChildThreadDone();
-            
-            //
-            // Start the threads if this is the first iteration
-            //
-            if (firstIterationFlag) {
-               threads[j]->setThreadKeepLoopingFlag(true);
-               threads[j]->setThreadedIterationDoneFlag(true);
-               threads[j]->start(QThread::TimeCriticalPriority);
-            }
-         }
-         
-         //
-         // Wait until all threads have started and in their loop.
-         // This is need for the case that there is only one iteration.
-         //
-         while (getNumChildThreadStarted() < numberOfThreads) {
-            msleep(1);
-         }
-         
-         for (int j = 0; j < numberOfThreads; j++) {
-            //
-            // if the last iteration, clear the keep looping flag for the thread
-            //
-            if (lastIterationFlag ) {
-               threads[j]->setThreadKeepLoopingFlag(false);
-            }
-            
-            //
-            // wake the thread so that it executes an iteration
-            //
-            if (DebugControl::getDebugOn()) {
-               std::cout << "Allowing morphing thread " << j << " to run." << std::endl;
-            }
-            threads[j]->setThreadedIterationDoneFlag(false);
-         }
-         
-         //
-         // Wait until all of the threads finish
-         //
-         while (getNumChildThreadDone() < numberOfThreads) {
-            msleep(1);
-         }
-         if (DebugControl::getDebugOn()) {
-            std::cout << "All morphing threads completed iteration." << std::endl;
-         }
-      }
-      else {
-         //
-         // Smooth for one iteration
-         //
-         setIndicesOfNodesToMorph(0, numberOfNodes - 1);
-         run(i);
-      }
-      
       //
       // morph one iteration
       //
-      //run(i);
-      
+      QTime timer;
+      timer.start();
+      morphIteration(i);
+      const int outputBufferIndex = 1 - inputBufferIndex;
       if (DebugControl::getDebugOn()) {
-         if ((DebugControl::getDebugNodeNumber() >= 0) &&
-             (DebugControl::getDebugNodeNumber() < numberOfNodes)) {
-            const int node = DebugControl::getDebugNodeNumber();
-            std::cout << "DEBUG iter " << i << " NODE "
-                      << node << " coords: " 
-                      << outputCoords[node*3] << " "
-                      << outputCoords[node*3+1] << " "
-                      << outputCoords[node*3+2] << std::endl;
-         }
+         std::cout << "   iteration"
+                   << i
+                   << " time: " << (static_cast<float>(timer.elapsed()) / 1000.0)
+                   << std::endl;
       }
       
       bool coordFileUpdated = false;
@@ -446,17 +251,16 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
          // Update the displayed brain model
          //
          if (brainSet->isIterationUpdate(i)) {
-            for (int j = 0; j < numberOfNodes; j++) {
-               morphCoordFile->setCoordinate(j, &outputCoords[j*3]);
-            }
+            copyCoordinatesToCoordinateFile(outputBufferIndex, morphCoordFile);
+            morphingSurface->computeNormals();
             brainSet->drawBrainModel(morphingSurface, i);
             coordFileUpdated = true;
          }
 
          //
-         // swap input and output coordinate pointers
+         // swap input and output coordinates
          //
-         std::swap(inputCoords, outputCoords);
+         inputBufferIndex = outputBufferIndex;
       }
 
       //
@@ -474,6 +278,9 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
          // If not just doing forces
          //
          if (forcesOnlyFlag == false) {
+            if (coordFileUpdated == false) {
+               copyCoordinatesToCoordinateFile(outputBufferIndex, morphCoordFile);
+            }
             updateStatsFile(statsFile,
                             morphCoordFile,
                             measurementsShapeFile,
@@ -495,23 +302,29 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
    // Copy the coordinates back to the morphing surface
    //   
    if (forcesOnlyFlag == false) {
-      for (int j = 0; j < numberOfNodes; j++) {
-         morphCoordFile->setCoordinate(j, &outputCoords[j*3]);
-      }
+      copyCoordinatesToCoordinateFile(1 - inputBufferIndex, morphCoordFile);
    }
+   morphingSurface->computeNormals();
    
    //
    // Copy the force vectors
    //
    BrainSetNodeAttribute* attributes = brainSet->getNodeAttributes(0);
    for (int i = 0; i < numberOfNodes; i++) {
-      attributes[i].setMorphingForces(morphNodeInfo[i].linearForce,
-                              morphNodeInfo[i].angularForce,
-                              morphNodeInfo[i].totalForce);
+      const float linear[3] = { 
+         linearForces[0][i], linearForces[1][i], linearForces[2][i] 
+      };
+      const float angular[3] = { 
+         angularForces[0][i], angularForces[1][i], angularForces[2][i] 
+      };
+      const float total[3] = { 
+         totalForces[0][i], totalForces[1][i], totalForces[2][i] 
+      };
+      attributes[curveOrderNodeNumbers[i]].setMorphingForces(linear, angular, total);
    }
    if (DebugControl::getDebugOn()) {
       const int node = DebugControl::getDebugNodeNumber();
-      if (node >= 0) {
+      if ((node >= 0) && (node < numberOfNodes)) {
          int start = node - 5;
          int end = node + 5;
          if (start < 0) {
@@ -522,13 +335,15 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
             end = numberOfNodes - 1;
          }
          for (int j = start; j < end; j++) {
+            float linear[3], angular[3], total[3];
+            attributes[j].getMorphingForces(linear, angular, total);
             std::cout << j << ": Forces (L, A): " 
-                        << morphNodeInfo[j].linearForce[0] << " "
-                        << morphNodeInfo[j].linearForce[1] << " "
-                        << morphNodeInfo[j].linearForce[2] << "  "
-                        << morphNodeInfo[j].angularForce[0] << " "
-                        << morphNodeInfo[j].angularForce[1] << " "
-                        << morphNodeInfo[j].angularForce[2] << " "
+                        << linear[0] << " "
+                        << linear[1] << " "
+                        << linear[2] << "  "
+                        << angular[0] << " "
+                        << angular[1] << " "
+                        << angular[2] << " "
                         << std::endl;
          }
       }
@@ -536,7 +351,8 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
 }
 
 /**
- * Update the statistics file used for testing
+ * Update the statistics file used for testing.  The morphing coordinate
+ * file must already contain the coordinates that are to be measured.
  */
 void
 BrainModelSurfaceMorphing::updateStatsFile(QFile& statsFile,
@@ -553,13 +369,6 @@ BrainModelSurfaceMorphing::updateStatsFile(QFile& statsFile,
       measurementsShapeFile.setNumberOfNodesAndColumns(numberOfNodes, 2);
    }
    
-   //
-   // Update coordinates since stats taken on surface
-   //
-   for (int j = 0; j < numberOfNodes; j++) {
-      morphCoordFile->setCoordinate(j, &outputCoords[j*3]);
-   }
-   
    //
    // Determine distortion
    //
@@ -635,733 +444,402 @@ BrainModelSurfaceMorphing::updateStatsFile(QFile& statsFile,
    }
 }
 
+
 /**
- * Project nodes back to the sphere.
+ * Normalize a vector (unchanged if zero length).
  */
-void
-BrainModelSurfaceMorphing::projectNodeBackToSphere(const int nodeNumber)
+static inline void
+normalizeVector(float& x, float& y, float& z)
 {
-   //
-   // scale to sphere
-   //
-   if (morphNodeInfo[nodeNumber].numNeighbors > 0) {
-      const int i3 = nodeNumber * 3;
-      const float prad = std::sqrt(outputCoords[i3]   * outputCoords[i3] +
-                              outputCoords[i3+1] * outputCoords[i3+1] +
-                              outputCoords[i3+2] * outputCoords[i3+2]);
-      if (prad > 0.0) {
-         const float scale = sphericalSurfaceRadius / prad;
-         outputCoords[i3]   *= scale;
-         outputCoords[i3+1] *= scale;
-         outputCoords[i3+2] *= scale;
-      }
+   const float len = std::sqrt(x*x + y*y + z*z);
+   if (len > 0.0f) {
+      x /= len;
+      y /= len;
+      z /= len;
    }
 }
 
 /**
- * Calculate forces on nodes that are NOT BEING MORPHED.
- * This cannot be done inside the threaded execution since these
- * node's forces are needed by other nodes.
+ * Angle between two vectors that share an origin (same as MathUtilities::angle()).
  */
-void
-BrainModelSurfaceMorphing::setForcesOnNoMorphNodes()
+static inline float
+angleBetweenVectors(float ax, float ay, float az,
+                    float bx, float by, float bz)
 {
-   //
-   // Calculate forces on nodes that are NOT BEING MORPHED
-   // This is needed for some "inverse force" calculations needed below
-   //
-   for (int j = 0; j < numberOfNodes; j++) {
-   
-      if (nodeShouldBeMorphed[j] == false) {
-         //
-         // Info for this node and reset forces
-         //
-         NeighborInformation& nodeInfo = morphNodeInfo[j];
-         nodeInfo.resetForces();
-         
-         if (nodeInfo.numNeighbors > 1) {
-         
-            const float floatNumNeighbors = static_cast<float>(nodeInfo.numNeighbors);
-            //
-            // Determine linear forces for node
-            //
-            if (linearForce > 0.0) {
-               for (int k = 0; k < nodeInfo.numNeighbors; k++) {
-                  const int n = nodeInfo.neighbors[k];
-                  float linearForceComponents[3];
-                  computeLinearForce(inputCoords, nodeInfo, j, n, k, linearForceComponents);
-                  for (int i = 0; i < 3; i++) {
-                     nodeInfo.totalForce[i] +=
-                        linearForceComponents[i] / floatNumNeighbors;
-                     nodeInfo.linearForce [i] +=
-                        linearForceComponents[i] / floatNumNeighbors;
-                  }
-                  
-               }
-            }
-            
-            // Apply angular forces to node
-            //
-            if (angularForce > 0.0) {
-               if (nodeInfo.classification == BrainSetNodeAttribute::CLASSIFICATION_TYPE_CORNER) {
-                  float angularForceComponents[3];
-                  computeAngularForce(inputCoords, nodeInfo, 0, angularForceComponents);
-                  
-                  for (int i = 0; i < 3; i++){
-                     nodeInfo.totalForce[i] +=
-                              angularForceComponents[i] / (floatNumNeighbors - 1.0);
-                     nodeInfo.angularForce[i] +=
-                              angularForceComponents[i] / (floatNumNeighbors - 1.0);
-                  }
-               }
-               else {
-                  for (int k = 0; k < nodeInfo.numNeighbors; k++){
-                     float angularForceComponents[3];
-                     computeAngularForce(inputCoords, nodeInfo, k, angularForceComponents);
-                     for (int i = 0; i < 3; i++){
-                        nodeInfo.totalForce[i] +=
-                                 angularForceComponents[i] / floatNumNeighbors;
-                        nodeInfo.angularForce[i] +=
-                                 angularForceComponents[i] / floatNumNeighbors;
-                     }
-                  }
-               }
-            } // if (angularForce > 0.0)
-         }
-      }
+   const float aLength = std::sqrt(ax*ax + ay*ay + az*az);
+   const float bLength = std::sqrt(bx*bx + by*by + bz*bz);
+   if ((aLength <= 0.0f) || (bLength <= 0.0f)) {
+      return 0.0f;
    }
-   
+   float dot = (ax*bx + ay*by + az*bz) / (aLength * bLength);
+   if (dot > 1.0f) dot = 1.0f;
+   else if (dot < -1.0f) dot = -1.0f;
+   return std::acos(dot);
 }
 
 /**
- * Morph the surface
+ * Map a force onto the plane tangent to a sphere at a node (used in spherical morphing).
  */
-void
-BrainModelSurfaceMorphing::run(int iteration)
+static inline void
+mapForceToPlane(const float normalX, const float normalY, const float normalZ,
+                float& fx, float& fy, float& fz)
 {
-   QTime timer;
-   timer.start();
+   const float dot = normalX*fx + normalY*fy + normalZ*fz;
+   fx -= dot * normalX;
+   fy -= dot * normalY;
+   fz -= dot * normalZ;
+}
 
-   //
-   // set looping flag for non-threaded execution so that we do an iteration
-   //
-   if (getImAThread() == false) {
-      setThreadKeepLoopingFlag(true);
-   }
+/**
+ * Morph the nodes for one iteration.  The coordinates are read from the
+ * input coordinate buffer and written to the other buffer.  Nodes are
+ * split into contiguous blocks of the space filling curve order so each
+ * thread works on a spatially compact region of the surface, and the
+ * only synchronization during the pass is the barrier at the end of
+ * the parallel region (plus one after the forces on nodes that are
+ * not morphed when some nodes are not morphed).
+ */
+void
+BrainModelSurfaceMorphing::morphIteration(const int iteration) throw (BrainModelAlgorithmException)
+{
+   const int outputBufferIndex = 1 - inputBufferIndex;
+   const float* inX = &coordinateBuffers[inputBufferIndex][0][0];
+   const float* inY = &coordinateBuffers[inputBufferIndex][1][0];
+   const float* inZ = &coordinateBuffers[inputBufferIndex][2][0];
+   float* outX = &coordinateBuffers[outputBufferIndex][0][0];
+   float* outY = &coordinateBuffers[outputBufferIndex][1][0];
+   float* outZ = &coordinateBuffers[outputBufferIndex][2][0];
    
-   //
-   // The threaded execution will stay in the loop since run only gets called once
-   //
-   while (getThreadKeepLoopingFlag()) {
+   const bool sphericalFlag = (morphingSurfaceType == MORPHING_SURFACE_SPHERICAL);
+   const int numThreads = std::max(getNumberOfThreadsToRun(), 1);
    
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads)
+#endif
+   {
       //
-      // Is this a threaded instance
+      // Calculate forces on nodes that are NOT BEING MORPHED.
+      // Their linear and angular forces are needed for the 
+      // "inverse force" applied to their morphed neighbors.
       //
-      if (getImAThread()) {
-         //
-         // let parent know that this thread has started
-         //
-         getParentOfThisThread()->incrementNumChildThreadStarted();
-         
-         //
-         // Wait until parent says it is okay to go
-         //
-         while (getThreadedIterationDoneFlag()) {
-            msleep(1);
-         }
-         if (DebugControl::getDebugOn()) {
-            std::cout << "Morphing Thread " << getThreadNumber() << " now executing." << std::endl;
+      if (allNodesBeingMorphed == false) {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+         for (int j = 0; j < numberOfNodes; j++) {
+            if (nodeMorphFlags[j] == 0) {
+               computeNodeForces(j, inX, inY, inZ, false);
+            }
          }
       }
       
-      //
-      // morph each node that should be morphed
-      //
-      for (int j = startNodeIndex; j <= endNodeIndex; j++) {
-         //
-         // Save node position
-         //
-         float nodePos[3] = { inputCoords[j*3], inputCoords[j*3+1], inputCoords[j*3+2] };
-         outputCoords[j*3]   = nodePos[0];
-         outputCoords[j*3+1] = nodePos[1];
-         outputCoords[j*3+2] = nodePos[2];
-         
-         //
-         // Info for this node
-         //
-         NeighborInformation& nodeInfo = morphNodeInfo[j];
+#ifdef _OPENMP
+#pragma omp for schedule(static) nowait
+#endif
+      for (int j = 0; j < numberOfNodes; j++) {
+         float x = inX[j];
+         float y = inY[j];
+         float z = inZ[j];
+         const int numNeighbors = neighborOffsets[j+1] - neighborOffsets[j];
          
          //
          // If this node has neighbors and should be morphed
          //
-         if ((nodeInfo.numNeighbors > 1) && nodeShouldBeMorphed[j]) {
-            //
-            // Initialize forces to zero
-            //
-            nodeInfo.resetForces();
-            
-            float linearForceComponents[3];
-            float angularForceComponents[3];
-         
-            const float floatNumNeighbors = static_cast<float>(nodeInfo.numNeighbors);
-            //
-            // Apply linear forces to node
-            //
-            if (linearForce > 0.0) {
-               for (int k = 0; k < nodeInfo.numNeighbors; k++) {
-                  const int n = nodeInfo.neighbors[k];
-                  computeLinearForce(inputCoords, nodeInfo, j, n, k, linearForceComponents);
-                  for (int i = 0; i < 3; i++) {
-                     nodeInfo.totalForce[i] +=
-                        linearForceComponents[i] / floatNumNeighbors;
-                     nodeInfo.linearForce[i] +=
-                        linearForceComponents[i] / floatNumNeighbors;
-                  
-                     //
-                     // If this neighbor is not a morphable node
-                     //
-                     if (nodeShouldBeMorphed[n] == false) {
-                        //
-                        //  Add the inverse of the neighbor's linear force
-                        //
-                        nodeInfo.totalForce[i]  -= (noMorphNeighborStepSize * 
-                                                   morphNodeInfo[n].linearForce[i])
-                                                   / floatNumNeighbors;
-                        nodeInfo.linearForce[i] -= (noMorphNeighborStepSize * 
-                                                   morphNodeInfo[n].linearForce[i])
-                                                   / floatNumNeighbors;
-                     }
-                  }
-               }
-   
-               if (DebugControl::getDebugOn()) {
-                  if (DebugControl::getDebugNodeNumber() == j) {
-                     std::cout << std::endl;
-                     std::cout << "Total Linear Force for node: " << j
-                              << "(" << nodeInfo.linearForce[0]
-                              << ", " << nodeInfo.linearForce[1]
-                              << ", " << nodeInfo.linearForce[2] << ")" << std::endl;
-                     std::cout << std::endl;
-                  }
-               }
-            }
-               
-            //
-            // Apply angular forces to node
-            //
-            if (angularForce > 0.0) {
-               if (nodeInfo.classification == BrainSetNodeAttribute::CLASSIFICATION_TYPE_CORNER) {
-                  computeAngularForce(inputCoords, nodeInfo, 0, angularForceComponents);
-                  for (int i = 0; i < 3; i++){
-                     nodeInfo.totalForce[i] +=
-                              angularForceComponents[i] / (floatNumNeighbors - 1.0);
-                     nodeInfo.angularForce[i] +=
-                              angularForceComponents[i] / (floatNumNeighbors - 1.0);
-                  }
-               }
-               else {
-                  for (int k = 0; k < nodeInfo.numNeighbors; k++){
-                     const int n = nodeInfo.neighbors[k];
-                     computeAngularForce(inputCoords, nodeInfo, k, angularForceComponents);
-                     for (int i = 0; i < 3; i++){
-                        nodeInfo.totalForce[i] +=
-                                 angularForceComponents[i] / floatNumNeighbors;
-                        nodeInfo.angularForce[i] +=
-                                 angularForceComponents[i] / floatNumNeighbors;
-                  
-                        //
-                        // If this neighbor is not a morphable node
-                        //
-                        if (nodeShouldBeMorphed[n] == false) {
-                           //
-                           //  Add the inverse of the neighbor's linear force
-                           //
-                           nodeInfo.totalForce[i]   -= (noMorphNeighborStepSize * 
-                                                      morphNodeInfo[n].angularForce[i])
-                                                      / floatNumNeighbors;
-                           nodeInfo.angularForce[i] -= (noMorphNeighborStepSize * 
-                                                      morphNodeInfo[n].angularForce[i])
-                                                      / floatNumNeighbors;
-                        }
-                     }
-                  }
-               }
-            } // if (angularForce > 0.0)
+         if ((numNeighbors > 1) && nodeMorphFlags[j]) {
+            computeNodeForces(j, inX, inY, inZ, true);
             
             //
             // Adjust forces during spherical morphing
             //
-            if (morphingSurfaceType == MORPHING_SURFACE_SPHERICAL) {
-               mapForcesToPlane(nodePos, nodeInfo.totalForce);
-               mapForcesToPlane(nodePos, nodeInfo.angularForce);
-               mapForcesToPlane(nodePos, nodeInfo.linearForce);
+            if (sphericalFlag) {
+               float normalX = x, normalY = y, normalZ = z;
+               normalizeVector(normalX, normalY, normalZ);
+               mapForceToPlane(normalX, normalY, normalZ,
+                               totalForces[0][j], totalForces[1][j], totalForces[2][j]);
+               mapForceToPlane(normalX, normalY, normalZ,
+                               angularForces[0][j], angularForces[1][j], angularForces[2][j]);
+               mapForceToPlane(normalX, normalY, normalZ,
+                               linearForces[0][j], linearForces[1][j], linearForces[2][j]);
             }
             
             //
-            // Add forces and store in temporary node positions
+            // Add forces to the node's position
             //
-            outputCoords[j*3]   = nodePos[0] + stepSize * nodeInfo.totalForce[0];
-            outputCoords[j*3+1] = nodePos[1] + stepSize * nodeInfo.totalForce[1];
-            outputCoords[j*3+2] = nodePos[2] + stepSize * nodeInfo.totalForce[2];
-            
-            if (DebugControl::getDebugOn()) {
-               if (checkNaN(&outputCoords[j*3], 3)) {
-                  QString s = "PROGRAM ERROR: NaN detected for coordinate "
-                            + QString::number(j)
-                            + " iteration "
-                            + QString::number(iteration)
-                            + " in "
-                            + FileUtilities::basename(morphingSurface->getCoordinateFile()->getFileName());
-                  throw BrainModelAlgorithmException(s);
-               }
-            }            
-         }  // if (nodeInfo.numNeighbors > 1)
+            x += stepSize * totalForces[0][j];
+            y += stepSize * totalForces[1][j];
+            z += stepSize * totalForces[2][j];
+         }
          
          //
          // Project back to sphere if morphing a sphere
          //
-         switch (morphingSurfaceType) {
-            case MORPHING_SURFACE_FLAT:
-               break;
-            case MORPHING_SURFACE_SPHERICAL:
-               projectNodeBackToSphere(j);
-               break;
+         if (sphericalFlag && (numNeighbors > 0)) {
+            const float prad = std::sqrt(x*x + y*y + z*z);
+            if (prad > 0.0) {
+               const float scale = sphericalSurfaceRadius / prad;
+               x *= scale;
+               y *= scale;
+               z *= scale;
+            }
          }
          
-      } // for (j = 0...
-      
-      if (getImAThread()) {
-         if (DebugControl::getDebugOn()) {
-            std::cout << "Morphing Thread " << getThreadNumber() << " finished iteration." << std::endl;
-         }
-         //
-         // A threaded instance needs to tell that it has completed an iteration
-         //
-         setThreadedIterationDoneFlag(true);
-         getParentOfThisThread()->incrementNumChildThreadDone();
-      }
-      else {
-         //
-         // A non-threaded instance needs to return
-         //
-         setThreadKeepLoopingFlag(false);
+         outX[j] = x;
+         outY[j] = y;
+         outZ[j] = z;
       }
-   } // while (keepLooping)
-
-   if (DebugControl::getDebugOn()) {
-      std::cout << "   iteration"
-                  << iteration
-                  << " time: " << (static_cast<float>(timer.elapsed()) / 1000.0)
-             << std::endl;
    }
-}
-
-/**
- * check for not a number (true if any data are NaN).
- */
-bool 
-BrainModelSurfaceMorphing::checkNaN(float* data, int numberOfData) const
-{
-   for (int i = 0; i < numberOfData; i++) {
-      if (MathUtilities::isNaN(data[i])) {
-         return true;
+   
+   if (DebugControl::getDebugOn()) {
+      for (int j = 0; j < numberOfNodes; j++) {
+         float xyz[3] = { outX[j], outY[j], outZ[j] };
+         if (checkNaN(xyz, 3)) {
+            QString s = "PROGRAM ERROR: NaN detected for coordinate "
+                      + QString::number(curveOrderNodeNumbers[j])
+                      + " iteration "
+                      + QString::number(iteration)
+                      + " in "
+                      + FileUtilities::basename(morphingSurface->getCoordinateFile()->getFileName());
+            throw BrainModelAlgorithmException(s);
+         }
+         
+         if (curveOrderNodeNumbers[j] == DebugControl::getDebugNodeNumber()) {
+            std::cout << "DEBUG iter " << iteration << " NODE "
+                      << curveOrderNodeNumbers[j] << " coords: " 
+                      << xyz[0] << " "
+                      << xyz[1] << " "
+                      << xyz[2] << std::endl;
+            std::cout << "   Linear Force: (" << linearForces[0][j] 
+                      << ", " << linearForces[1][j]
+                      << ", " << linearForces[2][j] << ")" << std::endl;
+            std::cout << "   Angular Force: (" << angularForces[0][j] 
+                      << ", " << angularForces[1][j]
+                      << ", " << angularForces[2][j] << ")" << std::endl;
+         }
       }
    }
-   return false;
-}
-      
-/**
- * Map forces to a plane (used in spherical morphing).
- */
-void
-BrainModelSurfaceMorphing::mapForcesToPlane(const float nodeXYZ[3],
-                                            float force[3])
-{
-   //
-   // Compute the node's normal
-   //
-   float nodeNormal[3] = { nodeXYZ[0], nodeXYZ[1], nodeXYZ[2] };
-   MathUtilities::normalize(nodeNormal);
-   
-   //
-   // angle between normal and force
-   //
-   const float dot = MathUtilities::dotProduct(nodeNormal, force);
-   
-   //
-   // Adjust force
-   //
-   force[0] = force[0] - (dot * nodeNormal[0]);
-   force[1] = force[1] - (dot * nodeNormal[1]);
-   force[2] = force[2] - (dot * nodeNormal[2]);
 }
 
 /**
- * Compute the angular force on a node by its neighbor.
+ * Compute the linear, angular, and total forces on a node from its 
+ * neighbors.  The neighbor loops read the neighbor arrays contiguously
+ * and contain no branches so that the compiler can vectorize them.
+ * If "addInverseNeighborForcesFlag" is set, the scaled inverse of the
+ * forces on neighbors that are not morphed is added to the node.
  */
 void
-BrainModelSurfaceMorphing::computeAngularForce(const float* coords,
-                                                const NeighborInformation& nodeInfo,
-                                                const int neighborIndex,
-                                                float forceOut[3])
+BrainModelSurfaceMorphing::computeNodeForces(const int nodeIndex,
+                                             const float* x,
+                                             const float* y,
+                                             const float* z,
+                                             const bool addInverseNeighborForcesFlag)
 {
-   //
-   // Clear forces
-   //
-   forceOut[0] = 0.0;
-   forceOut[1] = 0.0;
-   forceOut[2] = 0.0; 
-   
-   if (nodeInfo.numNeighbors < 1) {
-      return;
-   }
+   float linear[3] = { 0.0, 0.0, 0.0 };
+   float angular[3] = { 0.0, 0.0, 0.0 };
    
-   //
-   // Indices of neighboring nodes
-   //
-   const int neighborNodeNumber = nodeInfo.neighbors[neighborIndex];
-   int nextNeighborIndex = neighborIndex + 1;
-   if (nextNeighborIndex >= nodeInfo.numNeighbors) nextNeighborIndex = 0;
-   const int nextNeighborNodeNumber = nodeInfo.neighbors[nextNeighborIndex];
-   
-   //
-   // coordinates of this node and the neighbors
-   //
-   const float* nodeCoords = &coords[nodeInfo.nodeNumber * 3];
-   const float* neighborCoords = &coords[neighborNodeNumber * 3];
-   const float* nextNeighborCoords = &coords[nextNeighborNodeNumber * 3];
-   
-   //
-   // Compute the normal for the triangle
-   //
-   float triangleNormal[3];
-   MathUtilities::computeNormal((float*)nodeCoords, (float*)neighborCoords, 
-                              (float*)nextNeighborCoords, triangleNormal);
-  
-   //
-   // Check for crossovers
-   //
-   bool crossover = false;
-   switch (morphingSurfaceType) {
-      case MORPHING_SURFACE_FLAT:
-         if (triangleNormal[2] < 0.0) {
-            crossover = true;
+   const int firstNeighbor = neighborOffsets[nodeIndex];
+   const int numNeighbors  = neighborOffsets[nodeIndex+1] - firstNeighbor;
+   if (numNeighbors > 1) {
+      const float floatNumNeighbors = static_cast<float>(numNeighbors);
+      const int* neighbors       = &neighborIndices[firstNeighbor];
+      const int* nextNeighbors   = &nextNeighborIndices[firstNeighbor];
+      const float* distances     = &neighborDistances[firstNeighbor];
+      const float* angles1       = &neighborAngles1[firstNeighbor];
+      const float* angles2       = &neighborAngles2[firstNeighbor];
+      const float* inverseSteps  = &neighborInverseForceStepSizes[firstNeighbor];
+      const float px = x[nodeIndex];
+      const float py = y[nodeIndex];
+      const float pz = z[nodeIndex];
+      
+      //
+      // Linear forces push the node so that the distance to each 
+      // neighbor matches the distance in the reference surface
+      //
+      if (linearForce > 0.0) {
+         float fx = 0.0, fy = 0.0, fz = 0.0;
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+#pragma omp simd reduction(+:fx,fy,fz)
+#endif
+         for (int k = 0; k < numNeighbors; k++) {
+            const int n = neighbors[k];
+            const float dx = px - x[n];
+            const float dy = py - y[n];
+            const float dz = pz - z[n];
+            const float neighborDistance = std::sqrt(dx*dx + dy*dy + dz*dz);
+            const float referenceDistance = distances[k];
+            
+            //
+            // If compressed, double error
+            //
+            float errorDistance = referenceDistance - neighborDistance;
+            if ((referenceDistance != 0.0f) 
+                && (neighborDistance < (0.5f * referenceDistance))) {
+               errorDistance *= 2.0f;
+            }
+            
+            //
+            // No force if neighbor is very close (would result in NaN)
+            //
+            const float scale = (neighborDistance > 0.000001f)
+                              ? (linearForce * errorDistance / neighborDistance)
+                              : 0.0f;
+            fx += scale * dx;
+            fy += scale * dy;
+            fz += scale * dz;
          }
-         break;
-      case MORPHING_SURFACE_SPHERICAL:
-         {
-            float avgNormal[3] = { 
-               (nodeCoords[0] + neighborCoords[0] + nextNeighborCoords[0]) / 3.0,
-               (nodeCoords[1] + neighborCoords[1] + nextNeighborCoords[1]) / 3.0,
-               (nodeCoords[2] + neighborCoords[2] + nextNeighborCoords[2]) / 3.0 
-            };
-            if (MathUtilities::normalize(avgNormal) > 0.0) {
-               const float dot = MathUtilities::dotProduct(avgNormal, triangleNormal);
-               if (dot < 0.0) {
-                  crossover = true;
+         
+         //
+         //  Add the inverse of the linear force of neighbors that are not morphed
+         //
+         if (addInverseNeighborForcesFlag && (allNodesBeingMorphed == false)) {
+            for (int k = 0; k < numNeighbors; k++) {
+               if (inverseSteps[k] != 0.0f) {
+                  const int n = neighbors[k];
+                  fx -= inverseSteps[k] * linearForces[0][n];
+                  fy -= inverseSteps[k] * linearForces[1][n];
+                  fz -= inverseSteps[k] * linearForces[2][n];
                }
             }
          }
-         break;
-   }
-   crossover = false; //*********************************************************
-   if (crossover) {
-      triangleNormal[0] = -triangleNormal[0];
-      triangleNormal[1] = -triangleNormal[1];
-      triangleNormal[2] = -triangleNormal[2];
-   }
-   
-   //
-   // Angle at neighbor
-   //
-   const float angle1 = MathUtilities::angle(nodeCoords, neighborCoords, nextNeighborCoords);
-   
-   //
-   // angle difference
-   //
-   float angleDiff1 = nodeInfo.angle1[neighborIndex] - angle1;
-   if (crossover) {
-      angleDiff1 = nodeInfo.angle1[neighborIndex] + angle1;
-   }
-   
-   //
-   // distance components and distance to neighbor
-   //
-   float distanceComponents1[3];
-   MathUtilities::subtractVectors(neighborCoords, nodeCoords, distanceComponents1);
-   const float distance1 = MathUtilities::vectorLength(distanceComponents1);
-   
-   //
-   // Amount (magnitude) node should be moved
-   //
-   const float mag1 = distance1 * std::sin(angleDiff1);
-   
-   //
-   // Determine vector of node movement
-   //
-   float direction1[3];
-   
-   //
-   // Determine a vector that points orthogonally from the plane defined
-   // by the tile's normal vector and the tiles edge (vector perpendicular to
-   // edge pointing outside the tringle but in the triangle's plane).
-   //
-   MathUtilities::normalizedCrossProduct(distanceComponents1, triangleNormal, direction1);
-             
-   if (MathUtilities::vectorLength(direction1) > 0.0) {
-      float force[3];
-      force[0] =  angularForce * mag1 * direction1[0];
-      force[1] =  angularForce * mag1 * direction1[1];
-      force[2] =  angularForce * mag1 * direction1[2];
-      if (DebugControl::getDebugOn()) {
-         if (checkNaN(force, 3)) {
-            QString s = "PROGRAM ERROR: NaN detected for angular force node  "
-                      + QString::number(nodeInfo.nodeNumber)
-                      + " in "
-                      + FileUtilities::basename(morphingSurface->getCoordinateFile()->getFileName());
-            throw BrainModelAlgorithmException(s);
-         }
-      }
-      if (crossover) {
-         force[0] = -force[0];
-         force[1] = -force[1];
-         force[2] = -force[2];
+         
+         linear[0] = fx / floatNumNeighbors;
+         linear[1] = fy / floatNumNeighbors;
+         linear[2] = fz / floatNumNeighbors;
       }
       
-      forceOut[0] +=  force[0];
-      forceOut[1] +=  force[1];
-      forceOut[2] +=  force[2];
-      
-      if (DebugControl::getDebugOn()) {
-         const int node = DebugControl::getDebugNodeNumber();
-         if (node == nodeInfo.nodeNumber) {
-            std::cout << "Morphing Debugging Node: " << node << std::endl;
-            std::cout << "Neighbor: " << neighborNodeNumber << std::endl;
-            std::cout << "Angle1 (Fiducial, surface): " 
-                      << (nodeInfo.angle1[neighborIndex] * MathUtilities::radiansToDegrees()) 
-                      << " " << (angle1  * MathUtilities::radiansToDegrees())
-                      << std::endl;
-            std::cout << "Force: " << force[0] << ", "
-                                   << force[1] << ", "
-                                   << force[2] << std::endl;
+      //
+      // Angular forces push the node so that the angles of the triangle
+      // formed with each pair of consecutive neighbors match the angles
+      // in the reference surface.  Only the first triangle is used for 
+      // corner nodes.
+      //
+      if (angularForce > 0.0) {
+         const bool cornerFlag = (nodeCornerFlags[nodeIndex] != 0);
+         const int numTriangles = (cornerFlag ? 1 : numNeighbors);
+         float fx = 0.0, fy = 0.0, fz = 0.0;
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+#pragma omp simd reduction(+:fx,fy,fz)
+#endif
+         for (int k = 0; k < numTriangles; k++) {
+            const int n1 = neighbors[k];
+            const int n2 = nextNeighbors[k];
+            const float ax = x[n1], ay = y[n1], az = z[n1];
+            const float bx = x[n2], by = y[n2], bz = z[n2];
+            
+            //
+            // Normal of the triangle (node, neighbor, next neighbor)
+            //
+            const float ux = bx - ax, uy = by - ay, uz = bz - az;
+            const float vx = px - ax, vy = py - ay, vz = pz - az;
+            float nx = uy*vz - uz*vy;
+            float ny = uz*vx - ux*vz;
+            float nz = ux*vy - uy*vx;
+            normalizeVector(nx, ny, nz);
+            
+            //
+            // Angle at neighbor and the magnitude the node should be moved
+            // perpendicular to the edge from the node to the neighbor
+            //
+            const float angle1 = angleBetweenVectors(px - ax, py - ay, pz - az,
+                                                     bx - ax, by - ay, bz - az);
+            float e1x = ax - px, e1y = ay - py, e1z = az - pz;
+            const float distance1 = std::sqrt(e1x*e1x + e1y*e1y + e1z*e1z);
+            const float mag1 = distance1 * std::sin(angles1[k] - angle1);
+            normalizeVector(e1x, e1y, e1z);
+            float d1x = e1y*nz - e1z*ny;
+            float d1y = e1z*nx - e1x*nz;
+            float d1z = e1x*ny - e1y*nx;
+            normalizeVector(d1x, d1y, d1z);
+            
+            //
+            // Angle at next neighbor and the magnitude the node should be moved
+            // perpendicular to the edge from the node to the next neighbor
+            //
+            const float angle2 = angleBetweenVectors(ax - bx, ay - by, az - bz,
+                                                     px - bx, py - by, pz - bz);
+            float e2x = bx - px, e2y = by - py, e2z = bz - pz;
+            const float distance2 = std::sqrt(e2x*e2x + e2y*e2y + e2z*e2z);
+            const float mag2 = distance2 * std::sin(angles2[k] - angle2);
+            normalizeVector(e2x, e2y, e2z);
+            float d2x = ny*e2z - nz*e2y;
+            float d2y = nz*e2x - nx*e2z;
+            float d2z = nx*e2y - ny*e2x;
+            normalizeVector(d2x, d2y, d2z);
+            
+            fx += angularForce * (mag1 * d1x + mag2 * d2x);
+            fy += angularForce * (mag1 * d1y + mag2 * d2y);
+            fz += angularForce * (mag1 * d1z + mag2 * d2z);
          }
-      }   
-   }
-   
-   //---------------------------------------------------------------------------------------
-  
-   //
-   // Angle at neighbor
-   //
-   const float angle2 = MathUtilities::angle(neighborCoords, nextNeighborCoords, nodeCoords);
-   
-   //
-   // angle difference
-   //
-   float angleDiff2 = nodeInfo.angle2[neighborIndex] - angle2;
-   if (crossover) {
-      angleDiff2 = nodeInfo.angle2[neighborIndex] + angle2;
-   }
-   
-   //
-   // distance components and distance to neighbor
-   //
-   float distanceComponents2[3];
-   MathUtilities::subtractVectors(nextNeighborCoords, nodeCoords, distanceComponents2);
-   const float distance2 = MathUtilities::vectorLength(distanceComponents2);
-   
-   //
-   // Amount (magnitude) node should be moved
-   //
-   const float mag2 = distance2 * std::sin(angleDiff2);
-   
-   //
-   // Determine vector of node movement
-   //
-   float direction2[3];
-   
-   //
-   // Determine a vector that points orthogonally from the plane defined
-   // by the tile's normal vector and the tiles edge (vector perpendicular to
-   // edge pointing outside the tringle but in the triangle's plane).
-   //
-   MathUtilities::normalizedCrossProduct(triangleNormal, distanceComponents2, direction2);
-             
-   if (MathUtilities::vectorLength(direction2) > 0.0) {
-      float force[3];
-      force[0] =  angularForce * mag2 * direction2[0];
-      force[1] =  angularForce * mag2 * direction2[1];
-      force[2] =  angularForce * mag2 * direction2[2];
-      if (DebugControl::getDebugOn()) {
-         if (checkNaN(force, 3)) {
-            QString s = "PROGRAM ERROR: NaN detected for angular force node  "
-                      + QString::number(nodeInfo.nodeNumber)
-                      + " in "
-                      + FileUtilities::basename(morphingSurface->getCoordinateFile()->getFileName());
-            throw BrainModelAlgorithmException(s);
+         
+         if (cornerFlag) {
+            angular[0] = fx / (floatNumNeighbors - 1.0f);
+            angular[1] = fy / (floatNumNeighbors - 1.0f);
+            angular[2] = fz / (floatNumNeighbors - 1.0f);
          }
-      }
-      if (crossover) {
-         force[0] = -force[0];
-         force[1] = -force[1];
-         force[2] = -force[2];
-      }
-      
-      forceOut[0] +=  force[0];
-      forceOut[1] +=  force[1];
-      forceOut[2] +=  force[2];
-      if (DebugControl::getDebugOn()) {
-         const int node = DebugControl::getDebugNodeNumber();
-         if (node == nodeInfo.nodeNumber) {
-            std::cout << "Morphing Debugging Node: " << node << std::endl;
-            std::cout << "Neighbor: " << nextNeighborNodeNumber << std::endl;
-            std::cout << "Angle2 (Fiducial, surface): " 
-                      << (nodeInfo.angle2[neighborIndex] * MathUtilities::radiansToDegrees())
-                      << " " << (angle2 * MathUtilities::radiansToDegrees())
-                       << std::endl;
-            std::cout << "Force: " << force[0] << ", "
-                                   << force[1] << ", "
-                                   << force[2] << std::endl;
+         else {
+            //
+            //  Add the inverse of the angular force of neighbors that are not morphed
+            //
+            if (addInverseNeighborForcesFlag && (allNodesBeingMorphed == false)) {
+               for (int k = 0; k < numNeighbors; k++) {
+                  if (inverseSteps[k] != 0.0f) {
+                     const int n = neighbors[k];
+                     fx -= inverseSteps[k] * angularForces[0][n];
+                     fy -= inverseSteps[k] * angularForces[1][n];
+                     fz -= inverseSteps[k] * angularForces[2][n];
+                  }
+               }
+            }
+            angular[0] = fx / floatNumNeighbors;
+            angular[1] = fy / floatNumNeighbors;
+            angular[2] = fz / floatNumNeighbors;
          }
       }
-   }   
-}
-
-/**
- * Compute linear force on a node from a neighbor
- */
-void
-BrainModelSurfaceMorphing::computeLinearForce(const float* coords,
-                                              const NeighborInformation& nodeInfo,
-                                              const int nodeNum,
-                                              const int neighNodeNum,
-                                              const int nodeInfoNeighIndex,
-                                              float force[3])
-{
-   //
-   // Clear forces
-   //
-   force[0] = 0.0;
-   force[1] = 0.0;
-   force[2] = 0.0;
-   
-   //
-   // positions of node and neighbor
-   //
-   const float* nodePos = &coords[nodeNum * 3];
-   const float* neighPos = &coords[neighNodeNum * 3];
-   
-   //
-   // Distance between node and its neighbor in the surface that is being morphed
-   //
-   const float neighborDistance = MathUtilities::distance3D(nodePos, neighPos);
-   
-   //
-   // If neighbor is very close do not update forces
-   // Added back, 01 April 2009 as node and neighbor had
-   // identical position resulting in NaN
-   //
-   if (neighborDistance <= 0.000001) {
-      return;
-   }
-   
-   //
-   // distance to neighbor in fiducial surface
-   //
-   const float neighborFiducialDistance = nodeInfo.neighborDistance[nodeInfoNeighIndex];   
-   
-   //
-   // Difference between node & neighbor in the fiducial and morphing surface (the "error")
-   //
-   float errorDistance = neighborFiducialDistance - neighborDistance;
-   
-   //
-   // ratio of distances in morphing and fiducial surfaces
-   //
-   float errorDistRatio = 0.0;
-   if (neighborFiducialDistance != 0.0) {
-      errorDistRatio = neighborDistance / neighborFiducialDistance;
-   }
-   
-   //
-   // if compressed, double error
-   //
-   if (errorDistRatio < 0.50) {
-      errorDistance *= 2.0;
    }
    
-   //
-   // apply linear force strength
-   //
-   errorDistance *= linearForce;
-   
-   //
-   // get distance between node and neighbor in X, Y, and Z
-   // Note: want to push "this" node in relation to its neighbor
-   //
-   float errorComponents[3];
-   MathUtilities::subtractVectors(nodePos, neighPos, errorComponents);
-   
-   //
-   // Determine the linear force components
-   //
-   force[0] = errorDistance * errorComponents[0] / neighborDistance;
-   force[1] = errorDistance * errorComponents[1] / neighborDistance;
-   force[2] = errorDistance * errorComponents[2] / neighborDistance;
-   
-   if (DebugControl::getDebugOn()) {
-      if (checkNaN(force, 3)) {
-         QString s = "PROGRAM ERROR: NaN detected for linear force node and neighbor "
-                   + QString::number(nodeNum)
-                   + " & "
-                   + QString::number(neighNodeNum)
-                   + " in "
-                   + FileUtilities::basename(morphingSurface->getCoordinateFile()->getFileName());
-         throw BrainModelAlgorithmException(s);
-      }
-   }
-   if (DebugControl::getDebugOn()) {
-      if (DebugControl::getDebugNodeNumber() == nodeNum) {
-         std::cout << std::endl;
-         std::cout << "Linear Force Calculation" << std::endl;
-         std::cout << "Node " << nodeNum
-                   << " (" << nodePos[0] << ", " << nodePos[1] << ", " << nodePos[2] << ")" 
-                   << std::endl;
-         std::cout << "Neighbor " << neighNodeNum 
-                   << " (" << neighPos[0] << ", " << neighPos[1] << ", " << neighPos[2] << ")" 
-                   << std::endl;
-         std::cout << "Fiducial Distance: " << neighborFiducialDistance << std::endl;
-         std::cout << "Distance: " << neighborDistance << std::endl;
-         std::cout << "Error Distance: " << errorDistance << std::endl;
-         std::cout << "Linear Force: (" << force[0] << ", " << force[1] << ", " << force[2] << ")"
-                   << std::endl;
-      }
+   for (int i = 0; i < 3; i++) {
+      linearForces[i][nodeIndex]  = linear[i];
+      angularForces[i][nodeIndex] = angular[i];
+      totalForces[i][nodeIndex]   = linear[i] + angular[i];
    }
 }
 
 /**
- * Set the indices of the nodes that are to be morphed (inclusive).
+ * check for not a number (true if any data are NaN).
  */
-void 
-BrainModelSurfaceMorphing::setIndicesOfNodesToMorph(const int startNodeIndexIn, 
-                                                    const int endNodeIndexIn)
+bool 
+BrainModelSurfaceMorphing::checkNaN(float* data, int numberOfData) const
 {
-   startNodeIndex = startNodeIndexIn;
-   endNodeIndex   = endNodeIndexIn;
+   for (int i = 0; i < numberOfData; i++) {
+      if (MathUtilities::isNaN(data[i])) {
+         return true;
+      }
+   }
+   return false;
 }
+      
 
 /**
- * Set the input and output coords
+ * Copy coordinates from a coordinate buffer to a coordinate file.
  */
 void
-BrainModelSurfaceMorphing::setInputAndOutputCoords(float* inCoords, float* outCoords)
+BrainModelSurfaceMorphing::copyCoordinatesToCoordinateFile(const int bufferIndex,
+                                                           CoordinateFile* cf) const
 {
-   inputCoords  = inCoords;
-   outputCoords = outCoords;
+   for (int i = 0; i < numberOfNodes; i++) {
+      const float xyz[3] = {
+         coordinateBuffers[bufferIndex][0][i],
+         coordinateBuffers[bufferIndex][1][i],
+         coordinateBuffers[bufferIndex][2][i]
+      };
+      cf->setCoordinate(curveOrderNodeNumbers[i], xyz);
+   }
 }
 
 /**
- * Generate neighbor information
+ * Generate neighbor information.  The nodes are placed in the order they 
+ * occur along a space filling curve through the morphing surface so 
+ * that a node's neighbors are usually near it in memory.  The neighbors
+ * of all nodes are stored in compressed (CSR) arrays.
  */
 void
 BrainModelSurfaceMorphing::generateNeighborInformation()
@@ -1378,10 +856,10 @@ BrainModelSurfaceMorphing::generateNeighborInformation()
    bs->classifyNodes(tf);
    
    //
-   // Get the coordinates from the reference surface
+   // Get the coordinates from the reference and morphing surfaces
    //
-   const CoordinateFile* cf = referenceSurface->getCoordinateFile();
-   const float* firstCoord = cf->getCoordinate(0);
+   const float* refCoords = referenceSurface->getCoordinateFile()->getCoordinate(0);
+   const float* morphCoords = morphingSurface->getCoordinateFile()->getCoordinate(0);
    
    //
    // Create a topology helper to get node neighbors
@@ -1399,33 +877,128 @@ BrainModelSurfaceMorphing::generateNeighborInformation()
    //
    const BrainSetNodeAttribute* allNodeAttributes = brainSet->getNodeAttributes(0);
    
+   //
+   // Order the nodes along a space filling curve
+   //
+   SpaceFillingCurve::getHilbertOrder(morphCoords, numberOfNodes, curveOrderNodeNumbers);
+   std::vector<int> nodeIndexOfNode(numberOfNodes);
+   for (int i = 0; i < numberOfNodes; i++) {
+      nodeIndexOfNode[curveOrderNodeNumbers[i]] = i;
+   }
+   
+   //
+   // Size the neighbor arrays
+   //
+   neighborOffsets.resize(numberOfNodes + 1);
+   neighborOffsets[0] = 0;
+   for (int i = 0; i < numberOfNodes; i++) {
+      int numNeighbors;
+      th->getNodeNeighbors(curveOrderNodeNumbers[i], numNeighbors);
+      neighborOffsets[i+1] = neighborOffsets[i] + numNeighbors;
+   }
+   const int totalNumberOfNeighbors = neighborOffsets[numberOfNodes];
+   neighborIndices.resize(totalNumberOfNeighbors);
+   nextNeighborIndices.resize(totalNumberOfNeighbors);
+   neighborDistances.assign(totalNumberOfNeighbors, 0.0);
+   neighborAngles1.assign(totalNumberOfNeighbors, 0.0);
+   neighborAngles2.assign(totalNumberOfNeighbors, 0.0);
+   neighborInverseForceStepSizes.assign(totalNumberOfNeighbors, 0.0);
+   nodeMorphFlags.resize(numberOfNodes);
+   nodeCornerFlags.resize(numberOfNodes);
+   
    //
    // Generate neighbors, lengths, and angles for reference surface
    //
-   morphNodeInfo = new NeighborInformation[numberOfNodes];
    for (int i = 0; i < numberOfNodes; i++) {
+      const int nodeNumber = curveOrderNodeNumbers[i];
       int numNeighbors;
-      const int* neighbors = th->getNodeNeighbors(i, numNeighbors);
+      const int* neighbors = th->getNodeNeighbors(nodeNumber, numNeighbors);
+      const int first = neighborOffsets[i];
       
-      morphNodeInfo[i].initialize(firstCoord, i, &allNodeAttributes[i], neighbors, numNeighbors);
+      nodeMorphFlags[i] = (nodeShouldBeMorphed[nodeNumber] ? 1 : 0);
+      nodeCornerFlags[i] = ((allNodeAttributes[nodeNumber].getClassification()
+                             == BrainSetNodeAttribute::CLASSIFICATION_TYPE_CORNER) ? 1 : 0);
       
-      //
-      // If fiducial sphere ratios should be used
-      //
-      if (useFiducialSphereRatios) {
-         const float myRatio = fiducialSphereRatios[i];
+      const float* myCoord = &refCoords[nodeNumber * 3];
+      for (int j = 0; j < numNeighbors; j++) {
+         int nextJ = j + 1;
+         if (nextJ >= numNeighbors) nextJ = 0;
+         
+         const int neigh = neighbors[j];
+         const int nextNeigh = neighbors[nextJ];
+         neighborIndices[first + j] = nodeIndexOfNode[neigh];
+         nextNeighborIndices[first + j] = nodeIndexOfNode[nextNeigh];
+         if (nodeShouldBeMorphed[neigh] == false) {
+            neighborInverseForceStepSizes[first + j] = noMorphNeighborStepSize;
+         }
+         
+         if (numNeighbors > 1) {
+            const float* currNeighborCoord = &refCoords[neigh * 3];
+            const float* nextNeighborCoord = &refCoords[nextNeigh * 3];
+            
+            //
+            // length to neighbor
+            //
+            neighborDistances[first + j] = MathUtilities::distance3D(myCoord, currNeighborCoord);
+            
+            //
+            // Angle at current neighbor and at next neighbor
+            // (only the first neighbor for corner nodes)
+            //
+            if ((nodeCornerFlags[i] == 0) || (j == 0)) {
+               neighborAngles1[first + j] = MathUtilities::angle(myCoord, currNeighborCoord, nextNeighborCoord);
+               neighborAngles2[first + j] = MathUtilities::angle(currNeighborCoord, nextNeighborCoord, myCoord);
+            }
+         }
+         
          //
-         // Scale neighbor distances by David's magic formula
+         // If fiducial sphere ratios should be used,
+         // scale neighbor distances by David's magic formula
          //
-         for (int j = 0; j < morphNodeInfo[i].numNeighbors; j++) {
-            const int neigh = morphNodeInfo[i].neighbors[j];
+         if (useFiducialSphereRatios) {
+            const float myRatio = fiducialSphereRatios[nodeNumber];
             const float neighRatio = fiducialSphereRatios[neigh];
-            morphNodeInfo[i].neighborDistance[j] = inverseDistortionFraction
+            neighborDistances[first + j] = inverseDistortionFraction
                                  + (sphereFiducialDistortionFraction * ((myRatio + neighRatio) * 0.5) 
-                                    * morphNodeInfo[i].neighborDistance[j]);
+                                    * neighborDistances[first + j]);
+         }
+      }
+      
+      if (DebugControl::getDebugOn()) {
+         if (nodeNumber == DebugControl::getDebugNodeNumber()) {
+            std::cout << "\nNode Number : " << nodeNumber << std::endl;
+            for (int j = 0; j < numNeighbors; j++) {
+               std::cout << "Neighbor[" << j << "] " << neighbors[j]
+                        << " angle1 (radians, degrees): " << neighborAngles1[first + j] 
+                        << " " << neighborAngles1[first + j] * MathUtilities::radiansToDegrees() << std::endl
+                        << " angle2 (radians, degrees): " << neighborAngles2[first + j] 
+                        << " " << neighborAngles2[first + j] * MathUtilities::radiansToDegrees()
+                        << std::endl;
+            }
          }
       }
    }
+   
+   //
+   // Load the morphing surface's coordinates into the input coordinate buffer
+   //
+   inputBufferIndex = 0;
+   for (int b = 0; b < 2; b++) {
+      for (int k = 0; k < 3; k++) {
+         coordinateBuffers[b][k].resize(numberOfNodes);
+      }
+   }
+   for (int i = 0; i < numberOfNodes; i++) {
+      const int nodeNumber = curveOrderNodeNumbers[i];
+      for (int k = 0; k < 3; k++) {
+         coordinateBuffers[inputBufferIndex][k][i] = morphCoords[nodeNumber * 3 + k];
+      }
+   }
+   for (int k = 0; k < 3; k++) {
+      linearForces[k].assign(numberOfNodes, 0.0);
+      angularForces[k].assign(numberOfNodes, 0.0);
+      totalForces[k].assign(numberOfNodes, 0.0);
+   }
 }
 
 /**
@@ -1459,154 +1032,4 @@ BrainModelSurfaceMorphing::setFiducialSphereDistortionCorrections(
 {
    fiducialSphereRatios = fiducialSphereRatiosIn;
    sphereFiducialDistortionFraction = sphereFiducialDistortionFractionIn;
-}                                                  
-
-//--------------------------------------------------------------------------------
-
-/**
- * Constructor.
- */
-BrainModelSurfaceMorphing::NeighborInformation::NeighborInformation()
-{
-   numNeighbors = 0;
-   neighbors = NULL;
-   neighborDistance = NULL;
-   angle1 = NULL;
-   angle2 = NULL;
-}
-
-/**
- * Destructor.
- */
-BrainModelSurfaceMorphing::NeighborInformation::~NeighborInformation()
-{
-   if (neighbors != NULL) {
-      delete neighbors;
-   }
-   if (neighborDistance != NULL) {
-      delete neighborDistance;
-   }
-   if (angle1 != NULL) {
-      delete angle1;
-   }
-   if (angle2 != NULL) {
-      delete angle2;
-   }
-}
-
-/**
- * Initialize neighbor information
- */
-void
-BrainModelSurfaceMorphing::NeighborInformation::initialize(const float* coords, 
-                                                const int nodeNumberIn,
-                                                const BrainSetNodeAttribute* nodeAttribute,
-                                                const int* neighborsIn,
-                                                const int numNeighborsIn)
-{
-   //
-   // Index of this node
-   //
-   nodeNumber = nodeNumberIn;
-   
-   //
-   // Set this nodes interior flag
-   //
-   classification = nodeAttribute->getClassification();
-   
-   //
-   // Allocate items to number of neighbors
-   //
-   numNeighbors = numNeighborsIn;
-   if (numNeighbors > 0) {
-      neighbors = new int[numNeighbors];
-      for (int i = 0; i < numNeighbors; i++) {
-         neighbors[i] = neighborsIn[i];
-      }
-      neighborDistance = new float[numNeighbors];
-      angle1 = new float[numNeighbors];
-      angle2 = new float[numNeighbors];
-   
-      const float* myCoord = &coords[nodeNumber * 3];
-      
-      if (numNeighbors > 1) {
-         //
-         // Compute distances and angles to neighbors
-         //      
-         for (int i = 0; i < numNeighbors; i++) {
-            //
-            // length to neighbor
-            //
-            neighborDistance[i] = MathUtilities::distance3D(myCoord, &coords[neighbors[i] * 3]);
-            
-            //
-            // indices for next and previous neighbors
-            //
-            int nextIndex = i + 1;
-            if (nextIndex >= numNeighbors) nextIndex = 0;
-            
-            //
-            // Coordinates of current and previous neighbor
-            //
-            const float* currNeighborCoord = &coords[neighbors[i] * 3];
-            const float* nextNeighborCoord = &coords[neighbors[nextIndex] * 3];
-            
-            //
-            // Compute angles
-            //
-            if (classification == BrainSetNodeAttribute::CLASSIFICATION_TYPE_CORNER) {
-               //
-               // Only compute for first neighbor
-               //
-               if (i == 0) {
-                  angle1[0] = MathUtilities::angle(myCoord, currNeighborCoord, nextNeighborCoord);
-                  angle2[0] = MathUtilities::angle(currNeighborCoord, nextNeighborCoord, myCoord);
-                  angle1[1] = 0.0;
-                  angle2[1] = 0.0;
-               }
-            }
-            else {
-               //
-               // Angle at current neighbor
-               //
-               angle1[i] = MathUtilities::angle(myCoord, currNeighborCoord, nextNeighborCoord);
-               
-               //
-               // Angle at next neighbor
-               //
-               angle2[i] = MathUtilities::angle(currNeighborCoord, nextNeighborCoord, myCoord);               
-            }
-         }
-         if (DebugControl::getDebugOn()) {
-            if (nodeNumber == DebugControl::getDebugNodeNumber()) {
-               std::cout << "\nNode Number : " << nodeNumber << std::endl;
-               for (int i = 0; i < numNeighbors; i++) {
-                  std::cout << "Neighbor[" << i << "] " << neighbors[i]
-                           << " angle1 (radians, degrees): " << angle1[i] 
-                           << " " << angle1[i] * MathUtilities::radiansToDegrees() << std::endl
-                           << " angle2 (radians, degrees): " << angle2[i] 
-                           << " " << angle2[i] * MathUtilities::radiansToDegrees()
-                           << std::endl;
-               }
-            }
-         }
-      }
-   }
-}
-
-/**
- * Initialize neighbor information
- */
-void
-BrainModelSurfaceMorphing::NeighborInformation::resetForces()
-{
-   totalForce[0]   = 0.0;
-   totalForce[1]   = 0.0;
-   totalForce[2]   = 0.0;
-   linearForce[0]  = 0.0;
-   linearForce[1]  = 0.0;
-   linearForce[2]  = 0.0;
-   angularForce[0] = 0.0;
-   angularForce[1] = 0.0;
-   angularForce[2] = 0.0;
 }
@@ -48,8 +48,6 @@ class BrainModelSurfaceMorphing : public BrainModelAlgorithmMultiThreaded {
          MORPHING_SURFACE_SPHERICAL
       };
       
-      //class NeighborInformation;
-      
       /// Constructor
       BrainModelSurfaceMorphing(BrainSet* brainSetIn,
                            BrainModelSurface* referenceSurfaceIn,
@@ -111,102 +109,25 @@ class BrainModelSurfaceMorphing : public BrainModelAlgorithmMultiThreaded {
             }
       };
       
-      /// This class contains information about relationships to neighboring nodes
-      class NeighborInformation {
-         public:
-            /// Constructor
-            NeighborInformation();
-            
-            /// Desstructor
-            ~NeighborInformation();
-                        
-            /// initialize the neighbor information
-            void initialize(const float* coords, const int nodeNumberIn,
-                             const BrainSetNodeAttribute* nodeAttribute,
-                             const int* neighborsIn,
-                             const int numNeighborsIn);
-            
-            /// set forces to zero
-            void resetForces();
-            
-            /// the neighbors sorted
-            int* neighbors;
-            
-            /// the distance to each neighbor
-            float* neighborDistance;
-            
-            /// the angle between neighbors
-            float* angle1;
-            
-            /// the angle between neighbors
-            float* angle2;
-            
-            /// total force on the node (3D)
-            float totalForce[3];
-            
-            /// angular force on the node (3D)
-            float angularForce[3];
-            
-            /// linear force on the node (3D)
-            float linearForce[3];
-            
-            /// number of this node
-            int nodeNumber;
-            
-            /// number of neighbors
-            int numNeighbors;
-            
-            /// node classification
-            BrainSetNodeAttribute::CLASSIFICATION_TYPE classification;
-            
-      };
-      
-      /// Constructor for a thread instance.
-      BrainModelSurfaceMorphing(BrainSet* brainSetIn,
-                                BrainModelSurface* referenceSurfaceIn,
-                                BrainModelSurface* morphingSurfaceIn,
-                                const MORPHING_SURFACE_TYPE morphingSurfaceTypeIn,
-                                NeighborInformation* morphNodeInfoIn,
-                                int* nodeShouldBeMorphedIn,
-                                const float noMorphStepSizeIn,
-                                const int startNodeIndexIn,
-                                const int endNodeIndexIn,
-                                const float sphericalSurfaceRadiusIn,
-                                BrainModelSurfaceMorphing* parentOfThisThreadIn,
-                                const int threadNumberIn);      
-                                           
-      /// morph for one iteration
-      void run(int iteration);
-      
-      /// Compute the angular force on a node by its neighbor.
-      void computeAngularForce(const float* coords,
-                               const NeighborInformation& nodeInfo,
-                               const int neighborIndex,
-                               float forcesOut[3]);
+      /// Compute the forces on a node from its neighbors
+      void computeNodeForces(const int nodeIndex,
+                             const float* x,
+                             const float* y,
+                             const float* z,
+                             const bool addInverseNeighborForcesFlag);
                                                 
-      /// compute the linear force on a node
-      void computeLinearForce(const float* coords,
-                              const NeighborInformation& nodeInfo,
-                              const int nodeNum,
-                              const int neighNodeNum,
-                              const int nodeInfoNeighIndex,
-                              float force[3]);
-      
-      /// generate the neighbor information for a node
+      /// copy coordinates from a coordinate buffer to a coordinate file
+      void copyCoordinatesToCoordinateFile(const int bufferIndex,
+                                           CoordinateFile* cf) const;
+      
+      /// generate the neighbor information for the nodes
       void generateNeighborInformation();
       
       /// initialize variables for this instance
       void initialize();
       
-      /// Map forces to a plane (used in spherical morphing).
-      void mapForcesToPlane(const float nodeXYZ[3],
-                            float force[3]);
-      
-      /// project node back to the sphere
-      void projectNodeBackToSphere(const int nodeNumber);
-
-      /// set the forces on nodes that are NOT being morphed
-      void setForcesOnNoMorphNodes();
+      /// morph the nodes for one iteration
+      void morphIteration(const int iteration) throw (BrainModelAlgorithmException);
       
       /// Update the statistics file used for testing
       void updateStatsFile(QFile& statsFile,
@@ -216,12 +137,6 @@ class BrainModelSurfaceMorphing : public BrainModelAlgorithmMultiThreaded {
                            const int iterationNumber,
                            const bool firstIterationFlag);
                                            
-      /// set the indices of the nodes that are to be morphed (inclusive)
-      void setIndicesOfNodesToMorph(const int startNodeIndexIn, const int endNodeIndexIn);
-      
-      /// set the input and output coords
-      void setInputAndOutputCoords(float* inCoords, float* outCoords);
-      
       /// check for not a number (true if any data are NaN)
       bool checkNaN(float* data, int numberOfData) const;
       
@@ -234,9 +149,6 @@ class BrainModelSurfaceMorphing : public BrainModelAlgorithmMultiThreaded {
       /// type of surface being morphed
       MORPHING_SURFACE_TYPE morphingSurfaceType;
       
-      /// neighboring node information
-      NeighborInformation* morphNodeInfo;
-      
       /// flat that denotes nodes that should be morphed (int faster than bool)
       int* nodeShouldBeMorphed;
       
@@ -261,38 +173,68 @@ class BrainModelSurfaceMorphing : public BrainModelAlgorithmMultiThreaded {
       /// number of iterations to morph
       int iterations;
       
-      /// array for holding coordinates (inputCoords and outputCoords point to this)
-      float* coordsArray1;
-      
-      /// array for holding coordinates (inputCoords and outputCoords point to this)
-      float* coordsArray2;
-      
-      /// pointers for input coordinates (do not delete)
-      float* inputCoords;
-      
-      /// pointers for output coordinates (do not delete)
-      float* outputCoords;
-      
       /// number of nodes in the surfaces
       int numberOfNodes;
 
       /// radius of the spherical surface
       float sphericalSurfaceRadius;
       
-      /// index of first node to smooth
-      int startNodeIndex;
-      
-      /// index of last node to smooth
-      int endNodeIndex;
-      
       /// do statistics each pass and save to file
       bool doStatisticsEachPass;
       
       /// all nodes being morphed flag
       bool allNodesBeingMorphed;
-
-      /// threads when running multi-threaded.
-      std::vector<BrainModelSurfaceMorphing*> threads;
+      
+      //
+      // The morphing kernel stores nodes in the order they occur along a
+      // space filling curve and all of the per node and per neighbor data
+      // in that order.  "Node index" below refers to this internal order.
+      //
+      
+      /// number of the surface node at each node index
+      std::vector<int> curveOrderNodeNumbers;
+      
+      /// offset of each node's first neighbor in the neighbor arrays (numberOfNodes + 1)
+      std::vector<int> neighborOffsets;
+      
+      /// node index of each neighbor
+      std::vector<int> neighborIndices;
+      
+      /// node index of the neighbor after each neighbor (around the node)
+      std::vector<int> nextNeighborIndices;
+      
+      /// reference surface distance to each neighbor
+      std::vector<float> neighborDistances;
+      
+      /// reference surface angle at each neighbor 
+      std::vector<float> neighborAngles1;
+      
+      /// reference surface angle at the neighbor after each neighbor
+      std::vector<float> neighborAngles2;
+      
+      /// step size for a neighbor's inverse force (zero if neighbor is morphed)
+      std::vector<float> neighborInverseForceStepSizes;
+      
+      /// node is being morphed (int faster than bool)
+      std::vector<int> nodeMorphFlags;
+      
+      /// node is a corner node (int faster than bool)
+      std::vector<int> nodeCornerFlags;
+      
+      /// two coordinate buffers, each with X, Y, and Z arrays
+      std::vector<float> coordinateBuffers[2][3];
+      
+      /// index of the coordinate buffer that is the input to an iteration
+      int inputBufferIndex;
+      
+      /// linear force X, Y, and Z arrays
+      std::vector<float> linearForces[3];
+      
+      /// angular force X, Y, and Z arrays
+      std::vector<float> angularForces[3];
+      
+      /// total force X, Y, and Z arrays
+      std::vector<float> totalForces[3];
       
 };
 #endif // __VE_BRAIN_SURFACE_MORPHING_H__
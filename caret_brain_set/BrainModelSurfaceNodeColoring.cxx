@@ -337,6 +337,7 @@ BrainModelSurfaceNodeColoring::BrainModelSurfaceNodeColoring(BrainSet* bs)
    defaultColorName = "???";
    numNodesLastTime = -1;
    numBrainModelsLastTime = -1;
+   modificationNumber = 0;
    
    probAtlasThreshPaintFile = NULL;
    
@@ -443,6 +444,7 @@ BrainModelSurfaceNodeColoring::setNodeColor(const int modelIn,
    nodeColoring[model * numNodes * 4 + index * 4 + 1] = rgb[1];
    nodeColoring[model * numNodes * 4 + index * 4 + 2] = rgb[2];
    nodeColoring[model * numNodes * 4 + index * 4 + 3] = alpha;
+   modificationNumber++;
 }
 
 /**
@@ -1302,6 +1304,26 @@ BrainModelSurfaceNodeColoring::assignSurfaceShapeColoring(const int overlayNumbe
       interpolatePaletteColor = true;
    }
    
+   //
+   // Reuse the colors from the last time if nothing used for coloring changed
+   //
+   std::vector<double> inputs;
+   inputs.push_back(ssf->getModificationSerialNumber());
+   inputs.push_back(pf->getModificationSerialNumber());
+   inputs.push_back(numNodes);
+   inputs.push_back(column);
+   inputs.push_back(dsss->getColorMap());
+   inputs.push_back(dsss->getSelectedPaletteIndex());
+   inputs.push_back(interpolatePaletteColor);
+   inputs.push_back(minValue);
+   inputs.push_back(maxValue);
+   if (getCachedOverlayColors(overlayNumber, inputs)) {
+      return;
+   }
+   
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
    for (int j = 0; j < numNodes; j++) {
       const float shape = ssf->getValue(j, column);
       const int gray = getLutIndex(shape, minValue, maxValue);
@@ -1354,6 +1376,8 @@ BrainModelSurfaceNodeColoring::assignSurfaceShapeColoring(const int overlayNumbe
             break;
       }
    }
+   
+   setCachedOverlayColors(overlayNumber, inputs);
 }   
 
 /**
@@ -1613,6 +1637,34 @@ BrainModelSurfaceNodeColoring::assignMetricColoring(const int overlayNumber)
                                             posThreshColor);
    const bool showThreshNodes = dsm->getShowSpecialColorForThresholdedNodes();
    
+   //
+   // Reuse the colors from the last time if nothing used for coloring changed
+   //
+   std::vector<double> inputs;
+   inputs.push_back(mf->getModificationSerialNumber());
+   inputs.push_back(pf->getModificationSerialNumber());
+   inputs.push_back(numNodes);
+   inputs.push_back(viewIndex);
+   inputs.push_back(thresholdIndex);
+   inputs.push_back(dsm->getSelectedPaletteIndex());
+   inputs.push_back(dsm->getDisplayMode());
+   inputs.push_back(posMinMetric);
+   inputs.push_back(posMaxMetric);
+   inputs.push_back(negMinMetric);
+   inputs.push_back(negMaxMetric);
+   inputs.push_back(userScaleFlag);
+   inputs.push_back(thresholdNegativeValue);
+   inputs.push_back(thresholdPositiveValue);
+   inputs.push_back(interpolateColor);
+   inputs.push_back(showThreshNodes);
+   for (int i = 0; i < 3; i++) {
+      inputs.push_back(negThreshColor[i]);
+      inputs.push_back(posThreshColor[i]);
+   }
+   if (getCachedOverlayColors(overlayNumber, inputs)) {
+      return;
+   }
+   
    enum DISPLAY_NODE {
       DISPLAY_NODE_NORMAL,
       DISPLAY_NODE_POS_THRESH_COLOR,
@@ -1620,6 +1672,9 @@ BrainModelSurfaceNodeColoring::assignMetricColoring(const int overlayNumber)
       DISPLAY_NODE_DO_NOT
    };
    
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
    for (int j = 0; j < numNodes; j++) {
    
       //
@@ -1758,6 +1813,8 @@ BrainModelSurfaceNodeColoring::assignMetricColoring(const int overlayNumber)
       }
    }
    
+   setCachedOverlayColors(overlayNumber, inputs);
+   
    if (DebugControl::getDebugOn()) {
       std::cout << "Time to assign metric colors: "
                 << (static_cast<float>(timer.elapsed()) / 1000.0) << std::endl;
@@ -2067,6 +2124,143 @@ BrainModelSurfaceNodeColoring::clamp0255(const float v) const
    return value;
 }
 
+/**
+ * Assign an overlay's coloring for the current model into "nodeColors".
+ */
+void
+BrainModelSurfaceNodeColoring::assignOverlayColoring(const int overlayNumber)
+{
+   const int numNodes = static_cast<int>(nodeColors.size());
+   
+   //
+   // Reset the colors
+   //
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+   for (int i = 0; i < numNodes; i++) {
+      nodeColors[i].reset();
+   }
+
+   //
+   // Get the surface overlay
+   //
+   const BrainModelSurfaceOverlay* bmsOverlay = brainSet->getSurfaceOverlay(overlayNumber);
+   
+   //
+   // Color using the overlay.  Only metric and surface shape colors, which
+   // depend only upon their files and display settings, are saved for reuse.
+   //
+   switch (bmsOverlay->getOverlay(modelNumber)) {
+      case BrainModelSurfaceOverlay::OVERLAY_NONE:
+         clearCachedOverlayColors(overlayNumber);
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_AREAL_ESTIMATION:
+         clearCachedOverlayColors(overlayNumber);
+         assignArealEstimationColoring(overlayNumber);
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_COCOMAC:
+         clearCachedOverlayColors(overlayNumber);
+         assignCocomacColoring();
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_METRIC:
+         assignMetricColoring(overlayNumber);
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_PAINT:
+         clearCachedOverlayColors(overlayNumber);
+         assignPaintColoring(overlayNumber);
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_PROBABILISTIC_ATLAS:
+         clearCachedOverlayColors(overlayNumber);
+         assignProbabilisticColoring(brainSet->getBrainModelSurface(modelNumber));
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_RGB_PAINT:
+         clearCachedOverlayColors(overlayNumber);
+         assignRgbPaintColoring(overlayNumber, false);
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_SECTIONS:
+         clearCachedOverlayColors(overlayNumber);
+         assignSectionColoring(overlayNumber);
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_SHOW_CROSSOVERS:
+         clearCachedOverlayColors(overlayNumber);
+         assignCrossoverColoring();
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_SHOW_EDGES:
+         clearCachedOverlayColors(overlayNumber);
+         assignEdgesColoring();
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_SURFACE_SHAPE:
+         assignSurfaceShapeColoring(overlayNumber);
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_TOPOGRAPHY:
+         clearCachedOverlayColors(overlayNumber);
+         assignTopographyColoring(overlayNumber);
+         break;
+      case BrainModelSurfaceOverlay::OVERLAY_GEOGRAPHY_BLENDING:
+         // handled by assignColors()
+         clearCachedOverlayColors(overlayNumber);
+         break;
+   }
+}
+
+/**
+ * Copy an overlay's saved colors for the current model into "nodeColors" if
+ * they were made from the same inputs.  Returns true if the colors were copied.
+ */
+bool
+BrainModelSurfaceNodeColoring::getCachedOverlayColors(const int overlayNumber,
+                                                      const std::vector<double>& inputs)
+{
+   const int indx = modelNumber * brainSet->getNumberOfSurfaceOverlays() + overlayNumber;
+   if ((indx < 0) || (indx >= static_cast<int>(overlayColorsCache.size()))) {
+      return false;
+   }
+   
+   const OverlayColors& oc = overlayColorsCache[indx];
+   if ((oc.inputs != inputs) ||
+       (oc.colors.size() != nodeColors.size())) {
+      return false;
+   }
+   
+   nodeColors = oc.colors;
+   return true;
+}
+
+/**
+ * Save an overlay's colors for the current model, which are in "nodeColors",
+ * and the inputs that produced them.
+ */
+void
+BrainModelSurfaceNodeColoring::setCachedOverlayColors(const int overlayNumber,
+                                                      const std::vector<double>& inputs)
+{
+   const int indx = modelNumber * brainSet->getNumberOfSurfaceOverlays() + overlayNumber;
+   if ((indx < 0) || (indx >= static_cast<int>(overlayColorsCache.size()))) {
+      return;
+   }
+   
+   OverlayColors& oc = overlayColorsCache[indx];
+   oc.inputs = inputs;
+   oc.colors = nodeColors;
+}
+
+/**
+ * Release an overlay's saved colors for the current model.
+ */
+void
+BrainModelSurfaceNodeColoring::clearCachedOverlayColors(const int overlayNumber)
+{
+   const int indx = modelNumber * brainSet->getNumberOfSurfaceOverlays() + overlayNumber;
+   if ((indx < 0) || (indx >= static_cast<int>(overlayColorsCache.size()))) {
+      return;
+   }
+   
+   OverlayColors& oc = overlayColorsCache[indx];
+   oc.inputs.clear();
+   std::vector<NodeColor>().swap(oc.colors);
+}
+
 /** 
  * Assign surface coloring to the brain surface's nodes.
  */
@@ -2079,6 +2273,7 @@ BrainModelSurfaceNodeColoring::assignColors()
    paintIndicesWithNoAreaColor.clear();
    
    brainSet->clearAllDisplayLists();
+   modificationNumber++;
    
    const int numNodes = brainSet->getNumberOfNodes();
    if (numNodes < 0) {
@@ -2101,6 +2296,16 @@ BrainModelSurfaceNodeColoring::assignColors()
       nodeColorSource.resize(numNodes * numBrainModels);
       numNodesLastTime = numNodes;
       numBrainModelsLastTime = numBrainModels;
+      overlayColorsCache.clear();
+   }
+   
+   //
+   // Saved overlay colors are indexed by model and overlay
+   //
+   const int numOverlayColors = numBrainModels * numberOfSurfaceOverlays;
+   if (static_cast<int>(overlayColorsCache.size()) != numOverlayColors) {
+      overlayColorsCache.clear();
+      overlayColorsCache.resize(numOverlayColors);
    }
    
    setDefaultColor();
@@ -2211,71 +2416,24 @@ BrainModelSurfaceNodeColoring::assignColors()
                // Loop through the overlays and assign the colors
                //
                for (int iso = 0; iso < numberOfSurfaceOverlays; iso++) {
-                  //
-                  // Reset the colors
-                  //
-                  for (int i = 0; i < numNodes; i++) {
-                     nodeColors[i].reset();
-                  }
-
-                  //
-                  // Get the surface overlay
-                  //
-                  const BrainModelSurfaceOverlay* bmsOverlay = brainSet->getSurfaceOverlay(iso);
-                  
                   //
                   // Color using the overlay
                   //
-                  switch (bmsOverlay->getOverlay(modelNumber)) {
-                     case BrainModelSurfaceOverlay::OVERLAY_NONE:
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_AREAL_ESTIMATION:
-                        assignArealEstimationColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_COCOMAC:
-                        assignCocomacColoring();
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_METRIC:
-                        assignMetricColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_PAINT:
-                        assignPaintColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_PROBABILISTIC_ATLAS:
-                        assignProbabilisticColoring(brainSet->getBrainModelSurface(modelNumber));
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_RGB_PAINT:
-                        assignRgbPaintColoring(iso, false);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_SECTIONS:
-                        assignSectionColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_SHOW_CROSSOVERS:
-                        assignCrossoverColoring();
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_SHOW_EDGES:
-                        assignEdgesColoring();
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_SURFACE_SHAPE:
-                        assignSurfaceShapeColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_TOPOGRAPHY:
-                        assignTopographyColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_GEOGRAPHY_BLENDING:
-                        // handled later in this method
-                        break;
-                  }
+                  assignOverlayColoring(iso);
 
                   //
                   // Get opacity for blending overlays
                   //         
+                  const BrainModelSurfaceOverlay* bmsOverlay = brainSet->getSurfaceOverlay(iso);
                   const float overlayOpacity = bmsOverlay->getOpacity();
                   const float oneMinusOverlayOpacity = 1.0 - overlayOpacity;
                   
                   //
                   // Apply coloring to nodes
                   //
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
                   for (int i = 0; i < numNodes; i++) {
                      //
                      // Was color applied to the node for this overlay
@@ -2332,61 +2490,10 @@ BrainModelSurfaceNodeColoring::assignColors()
                // Loop through the overlays and assign the colors
                //
                for (int iso = 0; iso < numberOfSurfaceOverlays; iso++) {
-                  //
-                  // Reset the colors
-                  //
-                  for (int i = 0; i < numNodes; i++) {
-                     nodeColors[i].reset();
-                  }
-
-                  //
-                  // Get the surface overlay
-                  //
-                  const BrainModelSurfaceOverlay* bmsOverlay = brainSet->getSurfaceOverlay(iso);
-                  
                   //
                   // Color using the overlay
                   //
-                  switch (bmsOverlay->getOverlay(modelNumber)) {
-                     case BrainModelSurfaceOverlay::OVERLAY_NONE:
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_AREAL_ESTIMATION:
-                        assignArealEstimationColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_COCOMAC:
-                        assignCocomacColoring();
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_METRIC:
-                        assignMetricColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_PAINT:
-                        assignPaintColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_PROBABILISTIC_ATLAS:
-                        assignProbabilisticColoring(brainSet->getBrainModelSurface(modelNumber));
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_RGB_PAINT:
-                        assignRgbPaintColoring(iso, false);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_SECTIONS:
-                        assignSectionColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_SHOW_CROSSOVERS:
-                        assignCrossoverColoring();
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_SHOW_EDGES:
-                        assignEdgesColoring();
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_SURFACE_SHAPE:
-                        assignSurfaceShapeColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_TOPOGRAPHY:
-                        assignTopographyColoring(iso);
-                        break;
-                     case BrainModelSurfaceOverlay::OVERLAY_GEOGRAPHY_BLENDING:
-                        // handled later in this method
-                        break;
-                  }
+                  assignOverlayColoring(iso);
                   
                   //
                   // Assign the colors to the proper underlay/overlay
@@ -2488,6 +2595,9 @@ BrainModelSurfaceNodeColoring::assignColors()
       const float contrast   = dsn->getNodeContrast();
       
       if ((brightness != 0.0) || (contrast != 1.0)) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
          for (int i = 0; i < numNodes; i++) {
             float r = nodeColoring[nodeColoringOffset + i*4];
             float g = nodeColoring[nodeColoringOffset + i*4+1];
@@ -2529,8 +2639,9 @@ BrainModelSurfaceNodeColoring::assignColors()
       // Apply opacity
       //
       const float surfaceOpacity = dsn->getOpacity();
+      const unsigned char surfaceAlpha = clamp0255(surfaceOpacity * 255.0);
       for (int i = 0; i < numNodes; i++) {
-         nodeColoring[nodeColoringOffset + i*4+3] = clamp0255(surfaceOpacity * 255.0);
+         nodeColoring[nodeColoringOffset + i*4+3] = surfaceAlpha;
       }
       
       assignMedialWallOverrideColoring(nodeColoringOffset,
@@ -76,6 +76,9 @@ class BrainModelSurfaceNodeColoring {
       
       /// get the color source for a node
       int getNodeColorSource(const int model, const int index) const;
+      
+      /// get the modification number (incremented each time node colors change)
+      unsigned long getModificationNumber() const { return modificationNumber; }
             
       /// match paint file names to node colors
       static void matchPaintNamesToNodeColorFile(BrainSet* bs, int paintsNodeColorIndex[],
@@ -109,12 +112,25 @@ class BrainModelSurfaceNodeColoring {
             void reset() { r = g = b = -1; a = 1.0; }
             inline bool isValid() const { return ((r >= 0) || (g >= 0) || (b >= 0)); }
       };
+      
+      /// colors of one overlay of one brain model and the inputs that produced them
+      class OverlayColors {
+         public:
+            /// inputs used to color (column selections, scaling, file serial numbers, etc.)
+            std::vector<double> inputs;
+            
+            /// colors of the nodes
+            std::vector<NodeColor> colors;
+      };
 
       /// the coloring mode
       COLORING_MODE coloringMode;
       
       /// used to help apply colors to nodes
       std::vector<NodeColor> nodeColors;
+      
+      /// overlay colors saved for reuse indexed by (model * number of overlays + overlay)
+      std::vector<OverlayColors> overlayColorsCache;
 
       /// brain set being colored (DO NOT "delete" IT !)
       BrainSet* brainSet;
@@ -152,6 +168,9 @@ class BrainModelSurfaceNodeColoring {
       /// number of nodes last iteration to avoid frequent resizing
       int numNodesLastTime;
       
+      /// modification number incremented each time node colors change
+      unsigned long modificationNumber;
+      
       /// brain model number for which coloring is being set
       int modelNumber;
       
@@ -162,6 +181,20 @@ class BrainModelSurfaceNodeColoring {
       void assignMedialWallOverrideColoring(const int colorOffset,
                                             const int sourceOffset);
       
+      /// Assign an overlay's coloring into "nodeColors"
+      void assignOverlayColoring(const int overlayNumber);
+      
+      /// copy an overlay's saved colors into "nodeColors" if they were made from the same inputs
+      bool getCachedOverlayColors(const int overlayNumber,
+                                  const std::vector<double>& inputs);
+      
+      /// save an overlay's colors in "nodeColors" and the inputs that produced them
+      void setCachedOverlayColors(const int overlayNumber,
+                                  const std::vector<double>& inputs);
+      
+      /// release an overlay's saved colors
+      void clearCachedOverlayColors(const int overlayNumber);
+      
       /// Assign areal estimation coloring
       void assignArealEstimationColoring(const int overlayNumber);
       
@@ -25,12 +25,36 @@
 
 
 
+#include <algorithm>
+#include <limits>
+
 #include "BrainModelSurface.h"
 #include "BrainModelSurfacePointLocator.h"
+#include "MathUtilities.h"
 #include "TopologyFile.h"
-#include "vtkIdList.h"
-#include "vtkMath.h"
-#include "vtkPointLocator.h"
+
+/**
+ * Compares points, by index, along one axis while building the tree.
+ */
+class PointLocatorAxisCompare {
+   public:
+      /// Constructor
+      PointLocatorAxisCompare(const std::vector<float>& xyzIn,
+                              const int axisIn)
+         : xyz(xyzIn), axis(axisIn) { }
+      
+      /// compare two points
+      bool operator()(const int p1, const int p2) const {
+         return (xyz[p1*3 + axis] < xyz[p2*3 + axis]);
+      }
+      
+   private:
+      /// all coordinates
+      const std::vector<float>& xyz;
+      
+      /// axis being compared
+      const int axis;
+};
 
 /**
  * Constructor.
@@ -51,21 +75,15 @@ BrainModelSurfacePointLocator::BrainModelSurfacePointLocator(const BrainModelSur
                                                        const std::vector<bool>* limitToTheseNodes)
    : coordFile(bms->getCoordinateFile())
 {
-   locator  = NULL;
-   points   = NULL;
-   polyData = NULL;
-   
-   //const CoordinateFile* coordFile = bms->getCoordinateFile();
-   const int numPoints = coordFile->getNumberOfCoordinates();
-   if (numPoints <= 0) {
-      return;
-   }
-   
    //
    // Find out if surface will have nodes added to it after this object is constructed
    //
+   const int numPoints = coordFile->getNumberOfCoordinates();
    nodesMayBeAddedToSurface = nodesMayBeAddedToSurfaceIn;
-   originalNumberOfNodes   = numPoints;
+   originalNumberOfNodes   = std::max(numPoints, 0);
+   if (numPoints <= 0) {
+      return;
+   }
    
    //
    // If necessary, keep track of which nodes are connected
@@ -100,27 +118,44 @@ BrainModelSurfacePointLocator::BrainModelSurfacePointLocator(const BrainModelSur
    }
    
    //
-   // Add the nodes to the point locator
+   // Gather the nodes that are to be searched
    //   
-   int counter = 0;
-   points = vtkPoints::New();
+   std::vector<float> allXYZ;
+   std::vector<int> pointOrder;
    for (int i = 0; i < numPoints; i++) {
       if (useThisNode[i]) {
-         float xyz[3];
-         coordFile->getCoordinate(i, xyz);
-         points->InsertPoint(counter, xyz);
-         counter++;
+         const float* xyz = coordFile->getCoordinate(i);
+         allXYZ.push_back(xyz[0]);
+         allXYZ.push_back(xyz[1]);
+         allXYZ.push_back(xyz[2]);
+         pointOrder.push_back(static_cast<int>(pointOrder.size()));
          pointIndexToNodeIndex.push_back(i);
       }
    }
+   const int numTreePoints = static_cast<int>(pointOrder.size());
+   if (numTreePoints <= 0) {
+      return;
+   }
    
-   polyData = vtkPolyData::New();
-   polyData->SetPoints(points);
+   //
+   // Arrange the points into a k-d tree
+   //
+   treeSplitAxis.resize(numTreePoints, 0);
+   buildTree(0, numTreePoints, pointOrder, allXYZ);
    
-   locator = vtkPointLocator::New();
-   locator->Initialize();
-   locator->SetDataSet(polyData);
-   locator->BuildLocator();
+   //
+   // Store the coordinates and node numbers in tree order so that
+   // searches walk through contiguous memory
+   //
+   const std::vector<int> originalNodeIndex = pointIndexToNodeIndex;
+   treeXYZ.resize(numTreePoints * 3);
+   for (int i = 0; i < numTreePoints; i++) {
+      const int p = pointOrder[i];
+      treeXYZ[i*3]     = allXYZ[p*3];
+      treeXYZ[i*3 + 1] = allXYZ[p*3 + 1];
+      treeXYZ[i*3 + 2] = allXYZ[p*3 + 2];
+      pointIndexToNodeIndex[i] = originalNodeIndex[p];
+   }
 }
 
 /*
@@ -128,17 +163,148 @@ BrainModelSurfacePointLocator::BrainModelSurfacePointLocator(const BrainModelSur
  */
 BrainModelSurfacePointLocator::~BrainModelSurfacePointLocator()
 {
-   if (locator != NULL)  {
-      locator->Delete();
-      locator = NULL;
+}
+
+/**
+ * Build the tree for the points from "first" up to (not including) "last".
+ * The point at the middle of the range is the median along the range's
+ * widest axis; points before it are not greater and points after it are
+ * not less along that axis.
+ */
+void 
+BrainModelSurfacePointLocator::buildTree(const int first, 
+                                         const int last,
+                                         std::vector<int>& pointOrder,
+                                         const std::vector<float>& allXYZ)
+{
+   if ((last - first) <= MAXIMUM_POINTS_IN_LEAF) {
+      return;
    }
-   if (polyData != NULL) {
-      polyData->Delete();
-      polyData = NULL;
+   
+   //
+   // Find the axis with the greatest extent
+   //
+   float minXYZ[3], maxXYZ[3];
+   for (int j = 0; j < 3; j++) {
+      minXYZ[j] = allXYZ[pointOrder[first]*3 + j];
+      maxXYZ[j] = minXYZ[j];
    }
-   if (points != NULL) {
-      points->Delete();
-      points = NULL;
+   for (int i = first + 1; i < last; i++) {
+      const float* xyz = &allXYZ[pointOrder[i]*3];
+      for (int j = 0; j < 3; j++) {
+         minXYZ[j] = std::min(minXYZ[j], xyz[j]);
+         maxXYZ[j] = std::max(maxXYZ[j], xyz[j]);
+      }
+   }
+   int axis = 0;
+   for (int j = 1; j < 3; j++) {
+      if ((maxXYZ[j] - minXYZ[j]) > (maxXYZ[axis] - minXYZ[axis])) {
+         axis = j;
+      }
+   }
+   
+   //
+   // Partition about the median
+   //
+   const int middle = (first + last) / 2;
+   std::nth_element(pointOrder.begin() + first,
+                    pointOrder.begin() + middle,
+                    pointOrder.begin() + last,
+                    PointLocatorAxisCompare(allXYZ, axis));
+   treeSplitAxis[middle] = static_cast<unsigned char>(axis);
+   
+   buildTree(first, middle, pointOrder, allXYZ);
+   buildTree(middle + 1, last, pointOrder, allXYZ);
+}
+
+/**
+ * Search the tree for the nearest point.
+ */
+void 
+BrainModelSurfacePointLocator::searchNearest(const int first,
+                                             const int last,
+                                             const float xyz[3],
+                                             int& nearestIndex,
+                                             float& nearestDistanceSquared) const
+{
+   if ((last - first) <= MAXIMUM_POINTS_IN_LEAF) {
+      for (int i = first; i < last; i++) {
+         const float* p = &treeXYZ[i*3];
+         const float dx = p[0] - xyz[0];
+         const float dy = p[1] - xyz[1];
+         const float dz = p[2] - xyz[2];
+         const float distSquared = dx*dx + dy*dy + dz*dz;
+         if (distSquared < nearestDistanceSquared) {
+            nearestDistanceSquared = distSquared;
+            nearestIndex = i;
+         }
+      }
+      return;
+   }
+   
+   const int middle = (first + last) / 2;
+   const float* p = &treeXYZ[middle*3];
+   const float dx = p[0] - xyz[0];
+   const float dy = p[1] - xyz[1];
+   const float dz = p[2] - xyz[2];
+   const float distSquared = dx*dx + dy*dy + dz*dz;
+   if (distSquared < nearestDistanceSquared) {
+      nearestDistanceSquared = distSquared;
+      nearestIndex = middle;
+   }
+   
+   //
+   // Search the side containing the location first, then the other
+   // side only if it may contain a closer point
+   //
+   const int axis = treeSplitAxis[middle];
+   const float planeDist = xyz[axis] - p[axis];
+   if (planeDist < 0.0) {
+      searchNearest(first, middle, xyz, nearestIndex, nearestDistanceSquared);
+      if ((planeDist * planeDist) < nearestDistanceSquared) {
+         searchNearest(middle + 1, last, xyz, nearestIndex, nearestDistanceSquared);
+      }
+   }
+   else {
+      searchNearest(middle + 1, last, xyz, nearestIndex, nearestDistanceSquared);
+      if ((planeDist * planeDist) < nearestDistanceSquared) {
+         searchNearest(first, middle, xyz, nearestIndex, nearestDistanceSquared);
+      }
+   }
+}
+
+/**
+ * Search the tree for points within a radius.
+ */
+void 
+BrainModelSurfacePointLocator::searchRadius(const int first,
+                                            const int last,
+                                            const float xyz[3],
+                                            const float radiusSquared,
+                                            std::vector<int>& nearbyPointsOut) const
+{
+   if ((last - first) <= MAXIMUM_POINTS_IN_LEAF) {
+      for (int i = first; i < last; i++) {
+         if (MathUtilities::distanceSquared3D(&treeXYZ[i*3], xyz) <= radiusSquared) {
+            nearbyPointsOut.push_back(pointIndexToNodeIndex[i]);
+         }
+      }
+      return;
+   }
+   
+   const int middle = (first + last) / 2;
+   const float* p = &treeXYZ[middle*3];
+   if (MathUtilities::distanceSquared3D(p, xyz) <= radiusSquared) {
+      nearbyPointsOut.push_back(pointIndexToNodeIndex[middle]);
+   }
+   
+   const int axis = treeSplitAxis[middle];
+   const float planeDist = xyz[axis] - p[axis];
+   if ((planeDist <= 0.0) || ((planeDist * planeDist) <= radiusSquared)) {
+      searchRadius(first, middle, xyz, radiusSquared, nearbyPointsOut);
+   }
+   if ((planeDist >= 0.0) || ((planeDist * planeDist) <= radiusSquared)) {
+      searchRadius(middle + 1, last, xyz, radiusSquared, nearbyPointsOut);
    }
 }
 
@@ -146,18 +312,16 @@ BrainModelSurfacePointLocator::~BrainModelSurfacePointLocator()
  * find point nearest to location (returns negative BrainModelSurface is empty)
  */
 int 
-BrainModelSurfacePointLocator::getNearestPoint(const float xyz[3])
+BrainModelSurfacePointLocator::getNearestPoint(const float xyz[3]) const
 {
    int closestNodeIndex = -1;
-   if (locator != NULL) {
-#ifdef HAVE_VTK5
-      double d[3] = { xyz[0], xyz[1], xyz[2] };
-      const int num = locator->FindClosestPoint(d);
-#else // HAVE_VTK5
-      const int num = locator->FindClosestPoint((float*)xyz);
-#endif // HAVE_VTK5
-      if (num >= 0) {
-         closestNodeIndex = pointIndexToNodeIndex[num];
+   const int numTreePoints = static_cast<int>(pointIndexToNodeIndex.size());
+   if (numTreePoints > 0) {
+      int nearestIndex = -1;
+      float nearestDistanceSquared = std::numeric_limits<float>::max();
+      searchNearest(0, numTreePoints, xyz, nearestIndex, nearestDistanceSquared);
+      if (nearestIndex >= 0) {
+         closestNodeIndex = pointIndexToNodeIndex[nearestIndex];
       }
    }
    
@@ -183,9 +347,9 @@ BrainModelSurfacePointLocator::getNearestPoint(const float xyz[3])
                closestNodeIndex = closestNewNodeIndex;
             }
             else {
-               const float newCoordDist = vtkMath::Distance2BetweenPoints(xyz, 
+               const float newCoordDist = MathUtilities::distanceSquared3D(xyz, 
                                                        coordFile->getCoordinate(closestNewNodeIndex));
-               const float oldCoordDist = vtkMath::Distance2BetweenPoints(xyz, 
+               const float oldCoordDist = MathUtilities::distanceSquared3D(xyz, 
                                                        coordFile->getCoordinate(closestNodeIndex));
                if (newCoordDist < oldCoordDist) {
                   closestNodeIndex = closestNewNodeIndex;
@@ -198,32 +362,42 @@ BrainModelSurfacePointLocator::getNearestPoint(const float xyz[3])
    return closestNodeIndex;
 }
 
+/**
+ * Find points nearest to many locations.  "xyz" contains three values for
+ * each location and "nearestPointsOut" receives one node number (negative
+ * if there is no node) for each location.
+ */
+void 
+BrainModelSurfacePointLocator::getNearestPoints(const float* xyz,
+                                                const int numberOfLocations,
+                                                int* nearestPointsOut,
+                                                const bool runParallelFlag) const
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 256) if (runParallelFlag)
+#endif
+   for (int i = 0; i < numberOfLocations; i++) {
+      nearestPointsOut[i] = getNearestPoint(&xyz[i*3]);
+   }
+}
+
 /**
  * Find points within a specified radius of the location.
  */
 void
 BrainModelSurfacePointLocator::getPointsWithinRadius(const float xyz[3],
                                                      const float radius,
-                                                     std::vector<int>& nearbyPointsOut)
+                                                     std::vector<int>& nearbyPointsOut) const
 {
    nearbyPointsOut.clear();
    
-   vtkIdList* idList = vtkIdList::New();
-   
    //
-   // Find nearby points with the vtk locator
+   // Find nearby points in the tree
    //
-#ifdef HAVE_VTK5
-   double xyzD[3] = { xyz[0], xyz[1], xyz[2] };
-   locator->FindPointsWithinRadius(radius, xyzD, idList);   
-#else // HAVE_VTK5
-   locator->FindPointsWithinRadius(radius, xyz, idList);   
-#endif // HAVE_VTK5
-   const int numIDs = idList->GetNumberOfIds();
-   if (numIDs > 0) {
-      for (int i = 0; i < numIDs; i++) {
-         nearbyPointsOut.push_back(pointIndexToNodeIndex[idList->GetId(i)]);
-      }
+   const float radiusSquared = radius * radius;
+   const int numTreePoints = static_cast<int>(pointIndexToNodeIndex.size());
+   if (numTreePoints > 0) {
+      searchRadius(0, numTreePoints, xyz, radiusSquared, nearbyPointsOut);
    }
    
    // Is is possible that nodes have been added to the surface
@@ -234,23 +408,16 @@ BrainModelSurfacePointLocator::getPointsWithinRadius(const float xyz[3],
       //
       const int newNumberOfNodes = coordFile->getNumberOfCoordinates();
       if (originalNumberOfNodes < newNumberOfNodes) {
-         const float radiusSquared = radius * radius;
-         
          //
          // Examine nodes that have been added to the surface
          //
          for (int i = originalNumberOfNodes; i < newNumberOfNodes; i++) {
             const float* coordXYZ = coordFile->getCoordinate(i);
-            const float distSquared = vtkMath::Distance2BetweenPoints(xyz, coordXYZ);
+            const float distSquared = MathUtilities::distanceSquared3D(xyz, coordXYZ);
             if (distSquared < radiusSquared) {
                nearbyPointsOut.push_back(i);
             }
          }
       }
    }
-   
-   if (idList != NULL) idList->Delete();
 }
-
-
-
@@ -32,12 +32,11 @@
 
 class BrainModelSurface;
 class CoordinateFile;
-class vtkPointLocator;
-class vtkPoints;
-class vtkPolyData;
 
 /// This class is used to quickly find the nearest point (node) in a BrainModelSurface.  It
-/// should be used when multiple queries will be made.
+/// should be used when multiple queries will be made.  The points are placed into a k-d tree
+/// that is stored in flat arrays.  Queries do not modify the locator so they may be made
+/// from multiple threads.
 class BrainModelSurfacePointLocator {
    public:
       /// Constructor
@@ -50,25 +49,51 @@ class BrainModelSurfacePointLocator {
       ~BrainModelSurfacePointLocator();
       
       /// find point nearest to location (returns negative BrainModelSurface is empty)
-      int getNearestPoint(const float xyz[3]);
+      int getNearestPoint(const float xyz[3]) const;
+      
+      /// find points nearest to many locations ("xyz" contains 3 * numberOfLocations values)
+      void getNearestPoints(const float* xyz,
+                            const int numberOfLocations,
+                            int* nearestPointsOut,
+                            const bool runParallelFlag = true) const;
       
       /// find points within the specified radius of the location
       void getPointsWithinRadius(const float xyz[3],
                                  const float radius,
-                                 std::vector<int>& nearbyPointsOut); 
+                                 std::vector<int>& nearbyPointsOut) const; 
                                  
    private:
-      /// the point locator
-      vtkPointLocator* locator;
+      /// build the tree for the points from "first" up to (not including) "last"
+      void buildTree(const int first, 
+                     const int last,
+                     std::vector<int>& pointOrder,
+                     const std::vector<float>& allXYZ);
+      
+      /// search the tree for the nearest point
+      void searchNearest(const int first,
+                         const int last,
+                         const float xyz[3],
+                         int& nearestIndex,
+                         float& nearestDistanceSquared) const;
+      
+      /// search the tree for points within a radius
+      void searchRadius(const int first,
+                        const int last,
+                        const float xyz[3],
+                        const float radiusSquared,
+                        std::vector<int>& nearbyPointsOut) const;
+      
+      /// ranges of at most this many points are searched linearly
+      enum { MAXIMUM_POINTS_IN_LEAF = 8 };
       
-      /// the points
-      vtkPoints* points;
+      /// coordinates of points in tree order (the median of each range splits the range)
+      std::vector<float> treeXYZ;
       
-      /// data set for the points
-      vtkPolyData* polyData;
+      /// axis along which the point at a range's median splits the range
+      std::vector<unsigned char> treeSplitAxis;
       
       /// If we are limited to connected nodes, only connected nodes will be placed into the
-      /// point locator.  "pointIndexToNodeIndex" keeps track of this relationship.
+      /// point locator.  "pointIndexToNodeIndex" keeps track of this relationship (in tree order).
       std::vector<int> pointIndexToNodeIndex;
 
       /// nodes may be added to the surface after this object is constructed
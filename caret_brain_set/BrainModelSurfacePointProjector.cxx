@@ -61,6 +61,7 @@ BrainModelSurfacePointProjector::BrainModelSurfacePointProjector(
    // Create a point locator for connected nodes
    //
    pointLocator = new BrainModelSurfacePointLocator(bmsIn, true, surfaceMayHaveNodesAddedToIt);
+   pointLocatorOwnedFlag = true;
    
    nearestNodeToleranceSquared = 0.01 * 0.01;
    tileAreaTolerance    = -0.01;
@@ -90,12 +91,34 @@ BrainModelSurfacePointProjector::BrainModelSurfacePointProjector(
    }
 }
 
+/**
+ * Constructor that shares the point locator of another projector.  The point 
+ * locator is not modified by queries so it may be shared by projectors that
+ * are used in different threads (a projector itself keeps search state and must 
+ * only be used by one thread at a time).  "shareLocatorWithProjector" must not
+ * be destroyed before this projector.
+ */
+BrainModelSurfacePointProjector::BrainModelSurfacePointProjector(
+                    const BrainModelSurfacePointProjector* shareLocatorWithProjector)
+   : coordinateFile(shareLocatorWithProjector->coordinateFile),  // initialize const members
+     topologyFile(shareLocatorWithProjector->topologyFile)
+{
+   pointLocator = shareLocatorWithProjector->pointLocator;
+   pointLocatorOwnedFlag = false;
+   
+   surfaceTypeHint = shareLocatorWithProjector->surfaceTypeHint;
+   nearestNodeToleranceSquared = shareLocatorWithProjector->nearestNodeToleranceSquared;
+   tileAreaTolerance = shareLocatorWithProjector->tileAreaTolerance;
+}
+
 /**
  * Destructor.
  */
 BrainModelSurfacePointProjector::~BrainModelSurfacePointProjector()
 {
-   if (pointLocator != NULL) delete pointLocator;
+   if (pointLocatorOwnedFlag) {
+      if (pointLocator != NULL) delete pointLocator;
+   }
    pointLocator = NULL;
 }
 
@@ -104,16 +127,34 @@ BrainModelSurfacePointProjector::~BrainModelSurfacePointProjector()
  * had no nodes.
  */
 int
-BrainModelSurfacePointProjector::projectToNearestNode(const float xyz[3])
+BrainModelSurfacePointProjector::projectToNearestNode(const float xyz[3]) const
 {
    return pointLocator->getNearestPoint(xyz);
 }
 
+/**
+ * Project many points to their nearest nodes.  "xyz" contains three values
+ * for each point.  For each point, "nearestNodesOut" receives the nearest 
+ * node number or negative if the surface had no nodes.  Unlike the barycentric
+ * projections, this method does not use the projector's search state so the
+ * points may be projected in parallel.
+ */
+void 
+BrainModelSurfacePointProjector::projectToNearestNodes(const float* xyz,
+                                                       const int numberOfPoints,
+                                                       int* nearestNodesOut,
+                                                       const bool runParallelFlag) const
+{
+   pointLocator->getNearestPoints(xyz, numberOfPoints, nearestNodesOut, runParallelFlag);
+}
+
 /**
  * Project to the nearest tile.  First, a barycentric projection is performed.  If the query
  * point projects into a tile, a positive number is returned.  If the query point does not project
  * into a tile, the tile nearest to the query point will be determined and a negative number
  * is returned.  If there are no tiles, zero is returned. 
+ * If "nearestNodeNumberIn" is not negative, it is the node nearest to the query point
+ * (as found by projectToNearestNodes()) and the search for the nearest node is skipped.
  */
 int
 BrainModelSurfacePointProjector::projectBarycentricNearestTile(const float xyz[3], 
@@ -121,7 +162,8 @@ BrainModelSurfacePointProjector::projectBarycentricNearestTile(const float xyz[3
                                                     int tileNodesOut[3], float barycentricOut[3],
                                                     float& signedDistanceOut,
                                                     float& distanceToTileOut,
-                                                    float distanceToTileComponentsOut[3])
+                                                    float distanceToTileComponentsOut[3],
+                                                    const int nearestNodeNumberIn)
 {
    int nearestNodeNumber = -1;
    nearestTileNumberOut  = -1;
@@ -129,7 +171,8 @@ BrainModelSurfacePointProjector::projectBarycentricNearestTile(const float xyz[3
    //
    // Try a normal barycentric mode projection first
    //
-   nearestTileNumberOut = projectBarycentric(xyz, nearestNodeNumber, tileNodesOut, barycentricOut, true);
+   nearestTileNumberOut = projectBarycentric(xyz, nearestNodeNumber, tileNodesOut, barycentricOut, true,
+                                             nearestNodeNumberIn);
    
    //
    // Did query point project successfully to a tile
@@ -356,12 +399,14 @@ BrainModelSurfacePointProjector::projectBarycentricBestTile2D(const float xyz[3]
 /**
  * Barycentric projection to tile (must have passed barycentricMode = true to constructor).
  * Returns the index of the tile the points projects to or negative if the point does not
- * project to a tile.
+ * project to a tile.  If "nearestNodeNumberIn" is not negative, it is the node nearest 
+ * to the query point and the search for the nearest node is skipped.
  */
 int
 BrainModelSurfacePointProjector::projectBarycentric(const float xyz[3], int& nearestNodeNumberOut,
                                                     int tileNodesOut[3], float barycentricOut[3],
-                                                    const bool checkNeighbors)
+                                                    const bool checkNeighbors,
+                                                    const int nearestNodeNumberIn)
 {
    //
    // generate topology info for node without sorting.
@@ -387,7 +432,12 @@ BrainModelSurfacePointProjector::projectBarycentric(const float xyz[3], int& nea
    //
    // Find node closest to the point
    //
-   nearestNodeNumberOut = pointLocator->getNearestPoint(xyz);
+   if (nearestNodeNumberIn >= 0) {
+      nearestNodeNumberOut = nearestNodeNumberIn;
+   }
+   else {
+      nearestNodeNumberOut = pointLocator->getNearestPoint(xyz);
+   }
    
    //
    // Reset the search status
@@ -53,22 +53,33 @@ class BrainModelSurfacePointProjector {
                                       const SURFACE_TYPE_HINT surfaceTypeHintIn,
                                       const bool surfaceMayHaveNodesAddedToIt);
                                       
+      /// Constructor that shares the point locator of another projector
+      BrainModelSurfacePointProjector(const BrainModelSurfacePointProjector* shareLocatorWithProjector);
+      
       /// Destructor
       ~BrainModelSurfacePointProjector();
       
       /// project to nearest node
-      int projectToNearestNode(const float xyz[3]);
+      int projectToNearestNode(const float xyz[3]) const;
+      
+      /// project many points to their nearest nodes ("xyz" contains 3 * numberOfPoints values)
+      void projectToNearestNodes(const float* xyz,
+                                 const int numberOfPoints,
+                                 int* nearestNodesOut,
+                                 const bool runParallelFlag = true) const;
       
       /// barycentric projection (returns tile node projects to else negative)
       int projectBarycentric(const float xyz[3], int& nearestNodeNumberOut,
                              int tileNodesOut[3], float barycentricOut[3],
-                             const bool checkNeighbors = true);
+                             const bool checkNeighbors = true,
+                             const int nearestNodeNumberIn = -1);
       
       /// barycentric projection to nearest tile but may not be within the tile
       int projectBarycentricNearestTile(const float xyz[3], int& nearestTileNumberOut,
                                         int tileNodesOut[3], float barycentricOut[3],
                                         float& signedDistanceOut, float& distanceToTile,
-                                        float distanceComponents[3]);
+                                        float distanceComponents[3],
+                                        const int nearestNodeNumberIn = -1);
       
       /// barycentric projection to the "best" tile (2D only) 
       int projectBarycentricBestTile2D(const float xyz[3], 
@@ -101,7 +112,10 @@ class BrainModelSurfacePointProjector {
                         float& area1, float& area2, float& area3);
                          
       /// point locator for BrainModelSurface
-      BrainModelSurfacePointLocator* pointLocator;
+      const BrainModelSurfacePointLocator* pointLocator;
+      
+      /// point locator was created by (and is deleted by) this projector
+      bool pointLocatorOwnedFlag;
       
       /// coordinate file
       const CoordinateFile* coordinateFile;
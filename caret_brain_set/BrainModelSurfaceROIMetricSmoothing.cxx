@@ -383,30 +383,38 @@ BrainModelSurfaceROIMetricSmoothing::determineNeighbors()
    cf = fiducialSurface->getCoordinateFile();
    QTime timer;
    timer.start();
+   
+   //
+   // Geodesic distances from all nodes, the roots are run in parallel
+   //
+   GeodesicHelper gh(cf, topologyFile);
+   std::vector<int> roots(numberOfNodes);
+   for (int i = 0; i < numberOfNodes; i++) {
+      roots[i] = i;
+   }
+   std::vector<std::vector<int> > allNeighbors;
+   std::vector<std::vector<float> > allDistances;
+   gh.getNodesToGeoDistBatch(roots, geoCutoff, allNeighbors, allDistances, true);
+   const TopologyHelper* topologyHelper = topologyFile->getTopologyHelper(false, true, false);
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
    {
-      TopologyHelper topologyHelper(topologyFile, false, true, false);
-      GeodesicHelper gh(cf, topologyFile);//need private copies of this due to mutex locking
-      std::vector<float> distance;
-
       //
       // Loop through the nodes
       //
-      std::vector<int> neighbors;
       std::vector<float> geoWeights;
 #ifdef _OPENMP
 #pragma omp for
 #endif
       for (int i = 0; i < numberOfNodes; i++) {
-         neighbors.clear();//vectors shouldn't deallocate memory on clear(), so this saves lots and lots of slow new and delete calls
-         geoWeights.clear();
-         gh.getNodesToGeoDist(i, geoCutoff, neighbors, distance, true);
+         std::vector<int>& neighbors = allNeighbors[i];
+         std::vector<float>& distance = allDistances[i];
+         geoWeights.clear();//vectors shouldn't deallocate memory on clear(), so this saves lots and lots of slow new and delete calls
          if (neighbors.size() < 7)//5 neighbor nodes may fail this unneccesarily, but better than letting 6 neighbor nodes slip through with 5
          {//in case a really small kernel is specified - do NOT test only for ROI neighbors here, this is only to make sure the geoCutoff isn't too harsh
             //maybe it should union getNodeNeighbors and getNodesToGeoDist?  Probably only useful for extreme edge cases
-            topologyHelper.getNodeNeighbors(i, neighbors);
+            topologyHelper->getNodeNeighbors(i, neighbors);
             neighbors.push_back(i);//for geogauss, we want the center node in the list
             gh.getGeoToTheseNodes(i, neighbors, distance, true);
          }
@@ -420,6 +428,8 @@ BrainModelSurfaceROIMetricSmoothing::determineNeighbors()
             geoWeights.push_back(std::exp((double)(-tempf * tempf * 0.5f)));
          }
          nodeNeighbors[i] = NeighborInfo(neighbors, distance, geoWeights, roiValues);
+         std::vector<int>().swap(neighbors);
+         std::vector<float>().swap(distance);
       }
    }
    const float elapsedTime = timer.elapsed() * 0.001;
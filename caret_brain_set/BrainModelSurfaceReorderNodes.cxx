@@ -0,0 +1,508 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+
+#include "BorderProjectionFile.h"
+#include "BrainModelSurfaceReorderNodes.h"
+#include "CellProjectionFile.h"
+#include "CoordinateFile.h"
+#include "DeformationMapFile.h"
+#include "FileUtilities.h"
+#include "GeodesicDistanceFile.h"
+#include "NodeAttributeFile.h"
+#include "SpaceFillingCurve.h"
+#include "SpecFile.h"
+#include "TopologyFile.h"
+
+/**
+ * Constructor.
+ */
+BrainModelSurfaceReorderNodes::BrainModelSurfaceReorderNodes(BrainSet* bsIn,
+                                          const QString& inputSpecFileNameIn,
+                                          const QString& outputSpecFileNameIn,
+                                          const QString& outputFilePrefixIn,
+                                          const bool restoreOriginalOrderFlagIn)
+   : BrainModelAlgorithm(bsIn),
+     inputSpecFileName(inputSpecFileNameIn),
+     outputSpecFileName(outputSpecFileNameIn),
+     outputFilePrefix(outputFilePrefixIn),
+     restoreOriginalOrderFlag(restoreOriginalOrderFlagIn)
+{
+}
+
+/**
+ * Destructor.
+ */
+BrainModelSurfaceReorderNodes::~BrainModelSurfaceReorderNodes()
+{
+}
+
+/**
+ * execute the algorithm.
+ */
+void 
+BrainModelSurfaceReorderNodes::execute() throw (BrainModelAlgorithmException)
+{
+   if (inputSpecFileName.isEmpty()) {
+      throw BrainModelAlgorithmException("Input spec file name is empty.");
+   }
+   if (outputSpecFileName.isEmpty()) {
+      throw BrainModelAlgorithmException("Output spec file name is empty.");
+   }
+   if (outputFilePrefix.isEmpty()) {
+      throw BrainModelAlgorithmException(
+         "Output file prefix is empty which would overwrite the input files.");
+   }
+   
+   SpecFile inputSpecFile;
+   try {
+      inputSpecFile.readFile(inputSpecFileName);
+   }
+   catch (FileException& e) {
+      throw BrainModelAlgorithmException(e);
+   }
+   
+   //
+   // The output spec file name is relative to the current directory
+   //
+   outputSpecFileName = QFileInfo(outputSpecFileName).absoluteFilePath();
+   
+   //
+   // Files in the spec file are relative to the spec file's directory
+   //
+   const QString savedDirectory = QDir::currentPath();
+   const QString specFileDirectory = FileUtilities::dirname(inputSpecFileName);
+   if (specFileDirectory.isEmpty() == false) {
+      QDir::setCurrent(specFileDirectory);
+   }
+   
+   try {
+      reorderFiles(inputSpecFile);
+   }
+   catch (BrainModelAlgorithmException&) {
+      QDir::setCurrent(savedDirectory);
+      throw;
+   }
+   QDir::setCurrent(savedDirectory);
+}
+
+/**
+ * execute the algorithm in the spec file's directory.
+ */
+void 
+BrainModelSurfaceReorderNodes::reorderFiles(const SpecFile& inputSpecFile) throw (BrainModelAlgorithmException)
+{
+   createNewNodeNumbers(inputSpecFile);
+   
+   SpecFile outputSpecFile(inputSpecFile);
+   
+   const int numEntries = outputSpecFile.getNumberOfEntries();
+   for (int i = 0; i < numEntries; i++) {
+      SpecFile::Entry* entry = outputSpecFile.getEntry(i);
+      if (entry->fileType != SpecFile::Entry::FILE_TYPE_SURFACE) {
+         continue;
+      }
+      
+      //
+      // Files that contain nodes but cannot be renumbered are removed
+      // from the output spec file so that it does not mix node orders
+      //
+      std::vector<SpecFile::Entry::Files> keptFiles;
+      
+      const int numFiles = entry->getNumberOfFiles();
+      for (int j = 0; j < numFiles; j++) {
+         const QString fileName = entry->getFileName(j);
+         keptFiles.push_back(entry->files[j]);
+         
+         //
+         // Only read files that contain node data
+         //
+         QString errorMessage;
+         AbstractFile* emptyFile = AbstractFile::getSubClassDataFile(fileName,
+                                                                     errorMessage);
+         if (emptyFile == NULL) {
+            continue;
+         }
+         const bool nodeFileFlag = 
+            ((dynamic_cast<TopologyFile*>(emptyFile) != NULL) ||
+             (dynamic_cast<GiftiNodeDataFile*>(emptyFile) != NULL) ||
+             (dynamic_cast<BorderProjectionFile*>(emptyFile) != NULL) ||
+             (dynamic_cast<CellProjectionFile*>(emptyFile) != NULL) ||
+             (dynamic_cast<NodeAttributeFile*>(emptyFile) != NULL) ||
+             (dynamic_cast<DeformationMapFile*>(emptyFile) != NULL));
+         delete emptyFile;
+         if (nodeFileFlag == false) {
+            continue;
+         }
+         
+         AbstractFile* af = AbstractFile::readAnySubClassDataFile(fileName,
+                                                                  false,
+                                                                  errorMessage);
+         if (af == NULL) {
+            throw BrainModelAlgorithmException(errorMessage);
+         }
+         
+         AbstractFile* renumberedFile = NULL;
+         try {
+            renumberedFile = renumberNodesInFile(af);
+         }
+         catch (BrainModelAlgorithmException&) {
+            delete af;
+            throw;
+         }
+         
+         if (renumberedFile != NULL) {
+            QString outputFileName = outputFilePrefix 
+                                   + FileUtilities::basename(fileName);
+            const QString dirName = FileUtilities::dirname(fileName);
+            if ((dirName.isEmpty() == false) &&
+                (dirName != ".")) {
+               outputFileName = dirName + "/" + outputFileName;
+            }
+            
+            try {
+               renumberedFile->writeFile(outputFileName);
+            }
+            catch (FileException& e) {
+               if (renumberedFile != af) {
+                  delete renumberedFile;
+               }
+               delete af;
+               throw BrainModelAlgorithmException(e);
+            }
+            keptFiles.back().filename = outputFileName;
+            
+            if (renumberedFile != af) {
+               delete renumberedFile;
+            }
+         }
+         else {
+            addToWarningMessages(fileName
+                                 + " removed from the output spec file.");
+            keptFiles.pop_back();
+         }
+         delete af;
+      }
+      entry->files = keptFiles;
+   }
+   
+   //
+   // Files are relative to the input spec file's directory so they are 
+   // given absolute paths if the output spec file is placed elsewhere
+   //
+   const QString outputSpecFileDirectory = FileUtilities::dirname(outputSpecFileName);
+   if (QDir(outputSpecFileDirectory).canonicalPath() != QDir::current().canonicalPath()) {
+      outputSpecFile.prependPathsToAllFiles(QDir::currentPath(), true);
+   }
+   try {
+      outputSpecFile.writeFile(outputSpecFileName);
+   }
+   catch (FileException& e) {
+      throw BrainModelAlgorithmException(e);
+   }
+}
+
+/**
+ * determine the new node numbers.
+ */
+void 
+BrainModelSurfaceReorderNodes::createNewNodeNumbers(const SpecFile& inputSpecFileIn) throw (BrainModelAlgorithmException)
+{
+   newNodeNumbers.clear();
+   originalNodeNumbers.clear();
+   
+   SpecFile& inputSpecFile = const_cast<SpecFile&>(inputSpecFileIn);
+   
+   //
+   // Find the coordinate file used for ordering (preferably fiducial) or,
+   // when restoring, the first file containing the original node numbers
+   //
+   std::vector<QString> fileNames;
+   if (restoreOriginalOrderFlag == false) {
+      for (int j = 0; j < inputSpecFile.fiducialCoordFile.getNumberOfFiles(); j++) {
+         fileNames.push_back(inputSpecFile.fiducialCoordFile.getFileName(j));
+      }
+   }
+   const int numEntries = inputSpecFile.getNumberOfEntries();
+   for (int i = 0; i < numEntries; i++) {
+      SpecFile::Entry* entry = inputSpecFile.getEntry(i);
+      if (entry->fileType == SpecFile::Entry::FILE_TYPE_SURFACE) {
+         for (int j = 0; j < entry->getNumberOfFiles(); j++) {
+            fileNames.push_back(entry->getFileName(j));
+         }
+      }
+   }
+   
+   const int numFileNames = static_cast<int>(fileNames.size());
+   for (int i = 0; i < numFileNames; i++) {
+      QString errorMessage;
+      AbstractFile* emptyFile = AbstractFile::getSubClassDataFile(fileNames[i],
+                                                                  errorMessage);
+      if (emptyFile == NULL) {
+         continue;
+      }
+      const bool coordFileFlag = (dynamic_cast<CoordinateFile*>(emptyFile) != NULL);
+      const bool topoFileFlag  = (dynamic_cast<TopologyFile*>(emptyFile) != NULL);
+      delete emptyFile;
+      
+      if (restoreOriginalOrderFlag) {
+         if ((coordFileFlag == false) &&
+             (topoFileFlag == false)) {
+            continue;
+         }
+         AbstractFile* af = AbstractFile::readAnySubClassDataFile(fileNames[i],
+                                                                  true,
+                                                                  errorMessage);
+         if (af == NULL) {
+            throw BrainModelAlgorithmException(errorMessage);
+         }
+         const bool found = getOriginalNodeNumbersFromFile(af, newNodeNumbers);
+         delete af;
+         if (found) {
+            break;
+         }
+      }
+      else if (coordFileFlag) {
+         AbstractFile* af = AbstractFile::readAnySubClassDataFile(fileNames[i],
+                                                                  false,
+                                                                  errorMessage);
+         if (af == NULL) {
+            throw BrainModelAlgorithmException(errorMessage);
+         }
+         CoordinateFile* cf = dynamic_cast<CoordinateFile*>(af);
+         const int numNodes = cf->getNumberOfNodes();
+         if (numNodes <= 0) {
+            delete af;
+            throw BrainModelAlgorithmException(fileNames[i] + " contains no nodes.");
+         }
+         
+         std::vector<int> curveOrder;
+         SpaceFillingCurve::getHilbertOrder(cf->getCoordinate(0),
+                                            numNodes,
+                                            curveOrder);
+         
+         //
+         // If the file has already been reordered, keep track of the
+         // node numbers prior to the first reordering
+         //
+         std::vector<int> previousNodeNumbers;
+         if (getOriginalNodeNumbersFromFile(af, previousNodeNumbers)) {
+            if (static_cast<int>(previousNodeNumbers.size()) != numNodes) {
+               previousNodeNumbers.clear();
+            }
+         }
+         delete af;
+         
+         newNodeNumbers.resize(numNodes);
+         originalNodeNumbers.resize(numNodes);
+         for (int j = 0; j < numNodes; j++) {
+            const int oldNode = curveOrder[j];
+            newNodeNumbers[oldNode] = j;
+            if (previousNodeNumbers.empty()) {
+               originalNodeNumbers[j] = oldNode;
+            }
+            else {
+               originalNodeNumbers[j] = previousNodeNumbers[oldNode];
+            }
+         }
+         break;
+      }
+   }
+   
+   if (newNodeNumbers.empty()) {
+      if (restoreOriginalOrderFlag) {
+         throw BrainModelAlgorithmException(
+            "No topology or coordinate file contains the original node numbers.");
+      }
+      throw BrainModelAlgorithmException("Spec file contains no coordinate files.");
+   }
+   
+   //
+   // Node numbers must be a permutation
+   //
+   const int numNodes = static_cast<int>(newNodeNumbers.size());
+   std::vector<bool> used(numNodes, false);
+   for (int i = 0; i < numNodes; i++) {
+      const int node = newNodeNumbers[i];
+      if ((node < 0) ||
+          (node >= numNodes) ||
+          used[node]) {
+         throw BrainModelAlgorithmException("Original node numbers are invalid.");
+      }
+      used[node] = true;
+   }
+}
+
+/**
+ * renumber the nodes in a file.  Returns the file that should be written
+ * which is either "af" or a new file that the caller must delete.  NULL is
+ * returned if the file does not contain nodes or its nodes cannot be
+ * renumbered.
+ */
+AbstractFile* 
+BrainModelSurfaceReorderNodes::renumberNodesInFile(AbstractFile* af) throw (BrainModelAlgorithmException)
+{
+   const int numNodes = static_cast<int>(newNodeNumbers.size());
+   
+   try {
+      TopologyFile* tf = dynamic_cast<TopologyFile*>(af);
+      GiftiNodeDataFile* gndf = dynamic_cast<GiftiNodeDataFile*>(af);
+      BorderProjectionFile* bpf = dynamic_cast<BorderProjectionFile*>(af);
+      CellProjectionFile* cpf = dynamic_cast<CellProjectionFile*>(af);
+      NodeAttributeFile* naf = dynamic_cast<NodeAttributeFile*>(af);
+      
+      if (tf != NULL) {
+         if (tf->getNumberOfNodes() > numNodes) {
+            throw BrainModelAlgorithmException(af->getFileName() 
+               + " uses more nodes than the coordinate file contains.");
+         }
+         tf->renumberNodes(newNodeNumbers);
+      }
+      else if (gndf != NULL) {
+         gndf->renumberNodes(newNodeNumbers);
+      }
+      else if (bpf != NULL) {
+         bpf->renumberNodes(newNodeNumbers);
+      }
+      else if (cpf != NULL) {
+         cpf->renumberNodes(newNodeNumbers);
+      }
+      else if (dynamic_cast<DeformationMapFile*>(af) != NULL) {
+         addToWarningMessages(af->getFileName()
+                              + " not renumbered, deformation map files are not supported.");
+         return NULL;
+      }
+      else if (naf != NULL) {
+         if (dynamic_cast<GeodesicDistanceFile*>(af) != NULL) {
+            addToWarningMessages(af->getFileName()
+                                 + " not renumbered, geodesic distance files are not supported.");
+            return NULL;
+         }
+         if (naf->getNumberOfNodes() != numNodes) {
+            throw BrainModelAlgorithmException(af->getFileName() 
+               + " has a different number of nodes than the coordinate file.");
+         }
+         
+         //
+         // A deformation map that maps each new node to its old node
+         //
+         DeformationMapFile dmf;
+         dmf.setNumberOfNodes(numNodes);
+         dmf.setDeformedColumnNamePrefix("");
+         const float areas[3] = { 1.0, 0.0, 0.0 };
+         for (int i = 0; i < numNodes; i++) {
+            const int nodes[3] = { i, i, i };
+            dmf.setDeformDataForNode(newNodeNumbers[i], nodes, areas);
+         }
+         
+         QString errorMessage;
+         AbstractFile* deformedFile = AbstractFile::getSubClassDataFile(af->getFileName(),
+                                                                        errorMessage);
+         NodeAttributeFile* deformedNAF = dynamic_cast<NodeAttributeFile*>(deformedFile);
+         if (deformedNAF == NULL) {
+            if (deformedFile != NULL) {
+               delete deformedFile;
+            }
+            throw BrainModelAlgorithmException(errorMessage);
+         }
+         
+         try {
+            naf->deform(dmf, *deformedNAF, NodeAttributeFile::DEFORM_NEAREST_NODE);
+         }
+         catch (FileException&) {
+            delete deformedFile;
+            throw;
+         }
+         
+         //
+         // Renumbering is not a deformation so keep the comments
+         //
+         for (int j = 0; j < naf->getNumberOfColumns(); j++) {
+            deformedNAF->setColumnComment(j, naf->getColumnComment(j));
+         }
+         deformedNAF->setFileTitle(naf->getFileTitle());
+         deformedNAF->setFileComment(naf->getFileComment());
+         
+         return deformedFile;
+      }
+      else {
+         return NULL;
+      }
+   }
+   catch (FileException& e) {
+      throw BrainModelAlgorithmException(e);
+   }
+   
+   //
+   // Topology and coordinate files keep track of the original node numbers
+   //
+   if ((dynamic_cast<TopologyFile*>(af) != NULL) ||
+       (dynamic_cast<CoordinateFile*>(af) != NULL)) {
+      if (restoreOriginalOrderFlag) {
+         af->removeHeaderTag(getOriginalNodeNumbersHeaderTag());
+      }
+      else {
+         QStringList sl;
+         for (int i = 0; i < numNodes; i++) {
+            sl << QString::number(originalNodeNumbers[i]);
+         }
+         af->setHeaderTag(getOriginalNodeNumbersHeaderTag(), sl.join(" "));
+      }
+   }
+   
+   return af;
+}
+
+/**
+ * get the original node numbers from a file's header (returns false if not found).
+ */
+bool 
+BrainModelSurfaceReorderNodes::getOriginalNodeNumbersFromFile(const AbstractFile* af,
+                                              std::vector<int>& originalNodeNumbersOut)
+{
+   originalNodeNumbersOut.clear();
+   
+   const QString tagValue = af->getHeaderTag(getOriginalNodeNumbersHeaderTag());
+   if (tagValue.isEmpty()) {
+      return false;
+   }
+   
+   const QStringList sl = tagValue.split(" ", QString::SkipEmptyParts);
+   for (int i = 0; i < sl.count(); i++) {
+      bool ok = false;
+      const int node = sl.at(i).toInt(&ok);
+      if (ok == false) {
+         originalNodeNumbersOut.clear();
+         return false;
+      }
+      originalNodeNumbersOut.push_back(node);
+   }
+   
+   return (originalNodeNumbersOut.empty() == false);
+}
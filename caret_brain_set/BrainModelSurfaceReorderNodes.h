@@ -0,0 +1,94 @@
+#ifndef __BRAIN_MODEL_SURFACE_REORDER_NODES_H__
+#define __BRAIN_MODEL_SURFACE_REORDER_NODES_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+#include "BrainModelAlgorithm.h"
+
+class AbstractFile;
+class CoordinateFile;
+class SpecFile;
+
+/// Class that renumbers the nodes of all surface files in a spec file so that
+/// nodes that are near each other in space are also near each other in memory.
+/// The nodes are placed in the order they are visited by a 3D Hilbert curve
+/// passing through the fiducial (or first) coordinate file.  The original 
+/// node numbers are stored in the header of the topology and coordinate files
+/// so that the original order may be restored.
+class BrainModelSurfaceReorderNodes : public BrainModelAlgorithm {
+   public:
+      /// Constructor
+      BrainModelSurfaceReorderNodes(BrainSet* bsIn,
+                                    const QString& inputSpecFileNameIn,
+                                    const QString& outputSpecFileNameIn,
+                                    const QString& outputFilePrefixIn,
+                                    const bool restoreOriginalOrderFlagIn);
+      
+      /// Destructor
+      ~BrainModelSurfaceReorderNodes();
+      
+      /// execute the algorithm
+      void execute() throw (BrainModelAlgorithmException);
+      
+      /// header tag containing the original node numbers
+      static QString getOriginalNodeNumbersHeaderTag() { return "original_node_numbers"; }
+      
+   protected:
+      /// execute the algorithm in the spec file's directory
+      void reorderFiles(const SpecFile& inputSpecFile) throw (BrainModelAlgorithmException);
+      
+      /// determine the new node numbers 
+      void createNewNodeNumbers(const SpecFile& inputSpecFile) throw (BrainModelAlgorithmException);
+      
+      /// renumber the nodes in a file (returns the file to write or NULL if not renumbered)
+      AbstractFile* renumberNodesInFile(AbstractFile* af) throw (BrainModelAlgorithmException);
+      
+      /// get the original node numbers from a file's header (returns false if not found)
+      static bool getOriginalNodeNumbersFromFile(const AbstractFile* af,
+                                                 std::vector<int>& originalNodeNumbersOut);
+      
+      /// name of input spec file
+      QString inputSpecFileName;
+      
+      /// name of output spec file
+      QString outputSpecFileName;
+      
+      /// prefix added to the names of the renumbered files
+      QString outputFilePrefix;
+      
+      /// restore the original node order
+      bool restoreOriginalOrderFlag;
+      
+      /// the new node numbers (newNodeNumbers[old] = new)
+      std::vector<int> newNodeNumbers;
+      
+      /// the original node numbers of the renumbered nodes (empty if restoring)
+      std::vector<int> originalNodeNumbers;
+};
+
+#endif // __BRAIN_MODEL_SURFACE_REORDER_NODES_H__
@@ -0,0 +1,942 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+#include <cmath>
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "BrainModelVolumeMarchingCubes.h"
+#include "CoordinateFile.h"
+#include "TopologyFile.h"
+#include "VolumeFile.h"
+
+//
+// Corners at the ends of each cube edge.  A corner's bits are its offsets
+// along X (1), Y (2), and Z (4).  Edges 0-3 are parallel to X, 4-7 to Y, and
+// 8-11 to Z, and the first corner is at the low end of the edge.
+//
+static const int cubeEdgeCorners[12][2] = {
+   { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+   { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+   { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+};
+
+std::vector<int> BrainModelVolumeMarchingCubes::caseTable[256];
+bool BrainModelVolumeMarchingCubes::caseTableValid = false;
+
+/**
+ * The isosurface crossings of the edges in one plane of the volume.  A plane
+ * holds the crossings of its X and Y edges and of the Z edges that connect
+ * it to the next plane.
+ */
+class MarchingCubesPlane {
+   public:
+      /// find the index of a crossing in this plane
+      int findCrossing(const int i, const int j, const int axis) const {
+         const int key = i * 3 + axis;
+         const std::vector<int>::const_iterator iter =
+            std::lower_bound(keys.begin() + rowStart[j], keys.begin() + rowStart[j + 1], key);
+         return (iter - keys.begin());
+      }
+      
+      /// key (i * 3 + axis) of each crossing, increasing within each row
+      std::vector<int> keys;
+      
+      /// coordinates of each crossing
+      std::vector<float> xyz;
+      
+      /// index of each row's first crossing (one more than number of rows)
+      std::vector<int> rowStart;
+};
+
+/**
+ * get the cube edge that connects two corners.
+ */
+static int
+findCubeEdge(const int c1, const int c2)
+{
+   for (int e = 0; e < 12; e++) {
+      if (((cubeEdgeCorners[e][0] == c1) && (cubeEdgeCorners[e][1] == c2)) ||
+          ((cubeEdgeCorners[e][0] == c2) && (cubeEdgeCorners[e][1] == c1))) {
+         return e;
+      }
+   }
+   return -1;
+}
+
+/**
+ * get the position of a cube corner.
+ */
+static void
+getCubeCornerPosition(const int corner, float xyz[3])
+{
+   xyz[0] = corner & 1;
+   xyz[1] = (corner >> 1) & 1;
+   xyz[2] = (corner >> 2) & 1;
+}
+
+/**
+ * get the position of the center of a cube edge.
+ */
+static void
+getCubeEdgeCenter(const int edge, float xyz[3])
+{
+   float p1[3], p2[3];
+   getCubeCornerPosition(cubeEdgeCorners[edge][0], p1);
+   getCubeCornerPosition(cubeEdgeCorners[edge][1], p2);
+   for (int i = 0; i < 3; i++) {
+      xyz[i] = (p1[i] + p2[i]) * 0.5;
+   }
+}
+
+/**
+ * Add the segment where the surface crosses a cube face.  "insideXYZ" is on
+ * the inside side of the segment and "faceNormal" points out of the cube.
+ * The segment is directed so that the loops it forms are counter clockwise
+ * when viewed from outside the surface.
+ */
+static void
+addFaceSegment(const int edge1, const int edge2,
+               const float insideXYZ[3],
+               const float faceNormal[3],
+               int nextEdge[12])
+{
+   float p1[3], p2[3];
+   getCubeEdgeCenter(edge1, p1);
+   getCubeEdgeCenter(edge2, p2);
+   
+   float toOutside[3], direction[3];
+   for (int i = 0; i < 3; i++) {
+      toOutside[i] = (p1[i] + p2[i]) * 0.5 - insideXYZ[i];
+      direction[i] = p2[i] - p1[i];
+   }
+   const float cross[3] = {
+      toOutside[1] * direction[2] - toOutside[2] * direction[1],
+      toOutside[2] * direction[0] - toOutside[0] * direction[2],
+      toOutside[0] * direction[1] - toOutside[1] * direction[0]
+   };
+   const float dot = cross[0] * faceNormal[0]
+                   + cross[1] * faceNormal[1]
+                   + cross[2] * faceNormal[2];
+   if (dot > 0.0) {
+      nextEdge[edge2] = edge1;
+   }
+   else {
+      nextEdge[edge1] = edge2;
+   }
+}
+
+/**
+ * see if two cube edges are on the same face of the cube.
+ */
+static bool
+cubeEdgesShareFace(const int edge1, const int edge2)
+{
+   const int c1 = cubeEdgeCorners[edge1][0];
+   const int c2 = cubeEdgeCorners[edge1][1];
+   const int c3 = cubeEdgeCorners[edge2][0];
+   const int c4 = cubeEdgeCorners[edge2][1];
+   for (int axis = 0; axis < 3; axis++) {
+      const int bit = 1 << axis;
+      if (((c1 & bit) == (c2 & bit)) &&
+          ((c1 & bit) == (c3 & bit)) &&
+          ((c1 & bit) == (c4 & bit))) {
+         return true;
+      }
+   }
+   return false;
+}
+
+/**
+ * Split a loop of cube edges into triangles.  A triangle side between two
+ * edges on the same cube face may also be created by the neighboring cube,
+ * so the triangulation that uses the fewest of these sides is chosen.
+ */
+static void
+triangulateLoop(const std::vector<int>& loop,
+                std::vector<int>& trianglesOut)
+{
+   const int num = loop.size();
+   
+   //
+   // cost[i][j] is the smallest number of sides on a face needed to split
+   // the loop from i to j (j > i + 1) and split[i][j] is the corner used
+   //
+   int cost[12][12];
+   int split[12][12];
+   for (int length = 2; length < num; length++) {
+      for (int i = 0; (i + length) < num; i++) {
+         const int j = i + length;
+         cost[i][j] = -1;
+         for (int k = i + 1; k < j; k++) {
+            int c = 0;
+            if (k > (i + 1)) {
+               c += cost[i][k];
+               if (cubeEdgesShareFace(loop[i], loop[k])) {
+                  c++;
+               }
+            }
+            if (j > (k + 1)) {
+               c += cost[k][j];
+               if (cubeEdgesShareFace(loop[k], loop[j])) {
+                  c++;
+               }
+            }
+            if ((cost[i][j] < 0) || (c < cost[i][j])) {
+               cost[i][j] = c;
+               split[i][j] = k;
+            }
+         }
+      }
+   }
+   
+   std::vector<int> pending;
+   pending.push_back(0);
+   pending.push_back(num - 1);
+   while (pending.empty() == false) {
+      const int j = pending.back();
+      pending.pop_back();
+      const int i = pending.back();
+      pending.pop_back();
+      const int k = split[i][j];
+      trianglesOut.push_back(loop[i]);
+      trianglesOut.push_back(loop[k]);
+      trianglesOut.push_back(loop[j]);
+      if (k > (i + 1)) {
+         pending.push_back(i);
+         pending.push_back(k);
+      }
+      if (j > (k + 1)) {
+         pending.push_back(k);
+         pending.push_back(j);
+      }
+   }
+}
+
+/**
+ * get the (area weighted) normal of a triangle.
+ */
+static void
+getTriangleNormal(const float* p1, const float* p2, const float* p3, float normal[3])
+{
+   const float a[3] = { p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2] };
+   const float b[3] = { p3[0] - p1[0], p3[1] - p1[1], p3[2] - p1[2] };
+   normal[0] = a[1] * b[2] - a[2] * b[1];
+   normal[1] = a[2] * b[0] - a[0] * b[2];
+   normal[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+/**
+ * Constructor.
+ */
+BrainModelVolumeMarchingCubes::BrainModelVolumeMarchingCubes(const VolumeFile* volumeIn,
+                                                             const float isovalueIn)
+{
+   volume = volumeIn;
+   isovalue = isovalueIn;
+}
+
+/**
+ * Destructor.
+ */
+BrainModelVolumeMarchingCubes::~BrainModelVolumeMarchingCubes()
+{
+}
+
+/**
+ * Create the table of triangles for each cube case.  The bits of a case are
+ * set for the corners that are inside.  On each cube face the crossed edges
+ * are connected by segments, keeping inside corners that are diagonal to each
+ * other apart, so neighboring cubes always agree on how a face is crossed.
+ * The segments are chained into loops that are split into triangles.
+ */
+void
+BrainModelVolumeMarchingCubes::createCaseTable()
+{
+   for (int caseIndex = 0; caseIndex < 256; caseIndex++) {
+      int nextEdge[12];
+      for (int e = 0; e < 12; e++) {
+         nextEdge[e] = -1;
+      }
+      
+      for (int face = 0; face < 6; face++) {
+         const int axis = face / 2;
+         const int side = face % 2;
+         const int u = (axis + 1) % 3;
+         const int v = (axis + 2) % 3;
+         
+         //
+         // Corners around the face and the edges between them
+         //
+         int corners[4];
+         bool inside[4];
+         for (int m = 0; m < 4; m++) {
+            const int bitU = ((m == 1) || (m == 2)) ? 1 : 0;
+            const int bitV = (m >= 2) ? 1 : 0;
+            corners[m] = (side << axis) | (bitU << u) | (bitV << v);
+            inside[m] = (((caseIndex >> corners[m]) & 1) != 0);
+         }
+         int edges[4];
+         for (int m = 0; m < 4; m++) {
+            edges[m] = findCubeEdge(corners[m], corners[(m + 1) % 4]);
+         }
+         float faceNormal[3] = { 0.0, 0.0, 0.0 };
+         faceNormal[axis] = (side == 1) ? 1.0 : -1.0;
+         
+         std::vector<int> crossings;
+         for (int m = 0; m < 4; m++) {
+            if (inside[m] != inside[(m + 1) % 4]) {
+               crossings.push_back(m);
+            }
+         }
+         
+         if (crossings.size() == 2) {
+            float insideXYZ[3] = { 0.0, 0.0, 0.0 };
+            int numInside = 0;
+            for (int m = 0; m < 4; m++) {
+               if (inside[m]) {
+                  float xyz[3];
+                  getCubeCornerPosition(corners[m], xyz);
+                  for (int i = 0; i < 3; i++) {
+                     insideXYZ[i] += xyz[i];
+                  }
+                  numInside++;
+               }
+            }
+            for (int i = 0; i < 3; i++) {
+               insideXYZ[i] /= numInside;
+            }
+            addFaceSegment(edges[crossings[0]], edges[crossings[1]],
+                           insideXYZ, faceNormal, nextEdge);
+         }
+         else if (crossings.size() == 4) {
+            //
+            // Ambiguous face, cut off each inside corner
+            //
+            for (int m = 0; m < 4; m++) {
+               if (inside[m]) {
+                  float insideXYZ[3];
+                  getCubeCornerPosition(corners[m], insideXYZ);
+                  addFaceSegment(edges[(m + 3) % 4], edges[m],
+                                 insideXYZ, faceNormal, nextEdge);
+               }
+            }
+         }
+      }
+      
+      //
+      // Chain the segments into loops and split each loop into triangles
+      //
+      std::vector<int>& caseTriangles = caseTable[caseIndex];
+      caseTriangles.clear();
+      bool used[12];
+      for (int e = 0; e < 12; e++) {
+         used[e] = false;
+      }
+      for (int e = 0; e < 12; e++) {
+         if ((nextEdge[e] >= 0) && (used[e] == false)) {
+            std::vector<int> loop;
+            int edge = e;
+            do {
+               loop.push_back(edge);
+               used[edge] = true;
+               edge = nextEdge[edge];
+            } while (edge != e);
+            
+            triangulateLoop(loop, caseTriangles);
+         }
+      }
+   }
+   
+   caseTableValid = true;
+}
+
+/**
+ * Generate the mesh.  The crossings in each plane are found in parallel and
+ * numbered in plane order, then the triangles of each layer of cubes are
+ * created in parallel and appended in layer order, so the mesh is the same
+ * for any number of threads.
+ */
+void
+BrainModelVolumeMarchingCubes::execute()
+{
+   coordinates.clear();
+   triangles.clear();
+   normals.clear();
+   
+   {
+      //
+      // The case table is shared so only one thread may create it
+      //
+      static QMutex caseTableMutex;
+      QMutexLocker locker(&caseTableMutex);
+      if (caseTableValid == false) {
+         createCaseTable();
+      }
+   }
+   
+   int dim[3];
+   volume->getDimensions(dim);
+   const int dimX = dim[0];
+   const int dimY = dim[1];
+   const int dimZ = dim[2];
+   if ((dimX < 2) || (dimY < 2) || (dimZ < 2)) {
+      return;
+   }
+   float origin[3], spacing[3];
+   volume->getOrigin(origin);
+   volume->getSpacing(spacing);
+   const float* voxels = volume->getVoxelData();
+   const int numComponents = volume->getNumberOfComponentsPerVoxel();
+   const int sliceSize = dimX * dimY;
+   const int axisStep[3] = { 1, dimX, sliceSize };
+   
+   //
+   // Find the crossings in each plane
+   //
+   std::vector<MarchingCubesPlane> planes(dimZ);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+   for (int k = 0; k < dimZ; k++) {
+      MarchingCubesPlane& plane = planes[k];
+      plane.rowStart.resize(dimY + 1);
+      for (int j = 0; j < dimY; j++) {
+         plane.rowStart[j] = plane.keys.size();
+         for (int i = 0; i < dimX; i++) {
+            const int ijk[3] = { i, j, k };
+            const int voxelIndex = i + j * dimX + k * sliceSize;
+            const float value = voxels[voxelIndex * numComponents];
+            const bool inside = (value > isovalue);
+            for (int axis = 0; axis < 3; axis++) {
+               if (ijk[axis] < (dim[axis] - 1)) {
+                  const float value2 = voxels[(voxelIndex + axisStep[axis]) * numComponents];
+                  if ((value2 > isovalue) != inside) {
+                     const float t = (isovalue - value) / (value2 - value);
+                     plane.keys.push_back(i * 3 + axis);
+                     for (int m = 0; m < 3; m++) {
+                        float index = ijk[m];
+                        if (m == axis) {
+                           index += t;
+                        }
+                        plane.xyz.push_back(origin[m] + index * spacing[m]);
+                     }
+                  }
+               }
+            }
+         }
+      }
+      plane.rowStart[dimY] = plane.keys.size();
+   }
+   
+   //
+   // Number the crossings and copy them into the coordinates
+   //
+   std::vector<int> planeOffset(dimZ + 1, 0);
+   for (int k = 0; k < dimZ; k++) {
+      planeOffset[k + 1] = planeOffset[k] + planes[k].keys.size();
+   }
+   coordinates.resize(planeOffset[dimZ] * 3);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int k = 0; k < dimZ; k++) {
+      std::copy(planes[k].xyz.begin(), planes[k].xyz.end(),
+                coordinates.begin() + planeOffset[k] * 3);
+   }
+   
+   //
+   // Create the triangles in each layer of cubes
+   //
+   int cornerOffset[8];
+   for (int c = 0; c < 8; c++) {
+      cornerOffset[c] = (c & 1) + ((c >> 1) & 1) * dimX + ((c >> 2) & 1) * sliceSize;
+   }
+   std::vector<std::vector<int> > layerTriangles(dimZ - 1);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+   for (int k = 0; k < (dimZ - 1); k++) {
+      std::vector<int>& layer = layerTriangles[k];
+      for (int j = 0; j < (dimY - 1); j++) {
+         for (int i = 0; i < (dimX - 1); i++) {
+            const int voxelIndex = i + j * dimX + k * sliceSize;
+            int caseIndex = 0;
+            for (int c = 0; c < 8; c++) {
+               if (voxels[(voxelIndex + cornerOffset[c]) * numComponents] > isovalue) {
+                  caseIndex |= (1 << c);
+               }
+            }
+            if ((caseIndex == 0) || (caseIndex == 255)) {
+               continue;
+            }
+            
+            const std::vector<int>& edges = caseTable[caseIndex];
+            for (unsigned int m = 0; m < edges.size(); m++) {
+               const int edge = edges[m];
+               const int corner = cubeEdgeCorners[edge][0];
+               const int ei = i + (corner & 1);
+               const int ej = j + ((corner >> 1) & 1);
+               const int ek = k + ((corner >> 2) & 1);
+               layer.push_back(planeOffset[ek] + planes[ek].findCrossing(ei, ej, edge / 4));
+            }
+         }
+      }
+   }
+   
+   std::vector<int> layerOffset(dimZ, 0);
+   for (int k = 0; k < (dimZ - 1); k++) {
+      layerOffset[k + 1] = layerOffset[k] + layerTriangles[k].size();
+   }
+   triangles.resize(layerOffset[dimZ - 1]);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int k = 0; k < (dimZ - 1); k++) {
+      std::copy(layerTriangles[k].begin(), layerTriangles[k].end(),
+                triangles.begin() + layerOffset[k]);
+   }
+   
+   //
+   // A mirrored voxel grid reverses the orientation of the triangles
+   //
+   if ((spacing[0] * spacing[1] * spacing[2]) < 0.0) {
+      const int numTriangles = getNumberOfTriangles();
+      for (int i = 0; i < numTriangles; i++) {
+         std::swap(triangles[i * 3 + 1], triangles[i * 3 + 2]);
+      }
+   }
+}
+
+/**
+ * Decimate the mesh.  Vertices are removed by collapsing them into one of their
+ * neighbors when the triangles around the vertex remain a single fan, the
+ * collapse does not change the mesh's topology or flip a triangle, and the
+ * vertex is within "maximumError" of the new triangles (errors accumulate as
+ * vertices are collapsed).  Decimation stops when the number of triangles has
+ * been reduced by the "targetReduction" fraction or no more vertices can be
+ * removed.
+ */
+void
+BrainModelVolumeMarchingCubes::decimate(const float targetReduction,
+                                        const float maximumError)
+{
+   const int numVertices = getNumberOfVertices();
+   int numTriangles = getNumberOfTriangles();
+   const int targetNumberOfTriangles =
+      static_cast<int>((1.0 - targetReduction) * numTriangles);
+   if ((numTriangles <= 0) ||
+       (numTriangles <= targetNumberOfTriangles)) {
+      return;
+   }
+   normals.clear();
+   
+   std::vector<std::vector<int> > vertexTriangles(numVertices);
+   for (int t = 0; t < numTriangles; t++) {
+      for (int m = 0; m < 3; m++) {
+         vertexTriangles[triangles[t * 3 + m]].push_back(t);
+      }
+   }
+   std::vector<float> vertexError(numVertices, 0.0);
+   
+   std::vector<int> ringFirst, ringSecond, ring;
+   bool collapsedFlag = true;
+   while (collapsedFlag && (numTriangles > targetNumberOfTriangles)) {
+      collapsedFlag = false;
+      for (int v = 0; v < numVertices; v++) {
+         if (numTriangles <= targetNumberOfTriangles) {
+            break;
+         }
+         std::vector<int>& vTriangles = vertexTriangles[v];
+         const int numRing = vTriangles.size();
+         if (numRing < 3) {
+            continue;
+         }
+         const float allowedError = maximumError - vertexError[v];
+         if (allowedError < 0.0) {
+            continue;
+         }
+         
+         //
+         // Order the neighbors into a ring, skip vertices whose triangles
+         // are not a single fan
+         //
+         ringFirst.resize(numRing);
+         ringSecond.resize(numRing);
+         for (int i = 0; i < numRing; i++) {
+            const int* tri = &triangles[vTriangles[i] * 3];
+            const int p = (tri[0] == v) ? 0 : ((tri[1] == v) ? 1 : 2);
+            ringFirst[i]  = tri[(p + 1) % 3];
+            ringSecond[i] = tri[(p + 2) % 3];
+         }
+         ring.clear();
+         ring.push_back(ringFirst[0]);
+         int nextVertex = ringSecond[0];
+         bool validRing = true;
+         while (nextVertex != ring[0]) {
+            const int indx = std::find(ringFirst.begin(), ringFirst.end(), nextVertex)
+                           - ringFirst.begin();
+            if ((indx >= numRing) ||
+                (static_cast<int>(ring.size()) >= numRing)) {
+               validRing = false;
+               break;
+            }
+            ring.push_back(nextVertex);
+            nextVertex = ringSecond[indx];
+         }
+         if ((validRing == false) ||
+             (static_cast<int>(ring.size()) != numRing)) {
+            continue;
+         }
+         
+         //
+         // Find the neighbor with the smallest error for the collapse
+         //
+         const float* pv = &coordinates[v * 3];
+         int bestIndex = -1;
+         float bestError = allowedError;
+         for (int m = 0; m < numRing; m++) {
+            const int u = ring[m];
+            const int previous = ring[(m + numRing - 1) % numRing];
+            const int next = ring[(m + 1) % numRing];
+            
+            //
+            // The triangles between v, u, and "previous"/"next" are removed so
+            // those vertices must keep at least three triangles
+            //
+            if ((vertexTriangles[previous].size() <= 3) ||
+                (vertexTriangles[next].size() <= 3)) {
+               continue;
+            }
+            
+            //
+            // u may not already be connected to any other vertex in the ring
+            // and when the ring is a triangle, the new triangle cannot exist
+            //
+            const std::vector<int>& uTriangles = vertexTriangles[u];
+            bool validCollapse = true;
+            for (unsigned int i = 0; i < uTriangles.size(); i++) {
+               const int* tri = &triangles[uTriangles[i] * 3];
+               int numInRing = 0;
+               for (int n = 0; n < 3; n++) {
+                  const int w = tri[n];
+                  if ((w == previous) || (w == next)) {
+                     numInRing++;
+                  }
+                  else if ((w != u) && (w != v) &&
+                           (std::find(ring.begin(), ring.end(), w) != ring.end())) {
+                     validCollapse = false;
+                  }
+               }
+               if (numInRing == 2) {
+                  validCollapse = false;
+               }
+            }
+            if (validCollapse == false) {
+               continue;
+            }
+            
+            //
+            // Check the triangles that will use u instead of v
+            //
+            const float* pu = &coordinates[u * 3];
+            float error = 0.0;
+            for (int i = 0; i < numRing; i++) {
+               const int a = ring[i];
+               const int b = ring[(i + 1) % numRing];
+               if ((a == u) || (b == u)) {
+                  continue;
+               }
+               const float* pa = &coordinates[a * 3];
+               const float* pb = &coordinates[b * 3];
+               float oldNormal[3], newNormal[3];
+               getTriangleNormal(pv, pa, pb, oldNormal);
+               getTriangleNormal(pu, pa, pb, newNormal);
+               const float length = std::sqrt(newNormal[0] * newNormal[0]
+                                            + newNormal[1] * newNormal[1]
+                                            + newNormal[2] * newNormal[2]);
+               const float dot = oldNormal[0] * newNormal[0]
+                               + oldNormal[1] * newNormal[1]
+                               + oldNormal[2] * newNormal[2];
+               if ((length <= 0.0) || (dot <= 0.0)) {
+                  validCollapse = false;
+                  break;
+               }
+               const float distance = std::fabs(newNormal[0] * (pv[0] - pu[0])
+                                              + newNormal[1] * (pv[1] - pu[1])
+                                              + newNormal[2] * (pv[2] - pu[2])) / length;
+               error = std::max(error, distance);
+            }
+            if (validCollapse && (error <= bestError)) {
+               if ((bestIndex < 0) || (error < bestError)) {
+                  bestIndex = m;
+                  bestError = error;
+               }
+            }
+         }
+         if (bestIndex < 0) {
+            continue;
+         }
+         
+         //
+         // Collapse v into u
+         //
+         const int u = ring[bestIndex];
+         for (int i = 0; i < numRing; i++) {
+            const int t = vTriangles[i];
+            int* tri = &triangles[t * 3];
+            if ((tri[0] == u) || (tri[1] == u) || (tri[2] == u)) {
+               for (int n = 0; n < 3; n++) {
+                  if (tri[n] != v) {
+                     std::vector<int>& wTriangles = vertexTriangles[tri[n]];
+                     wTriangles.erase(std::find(wTriangles.begin(), wTriangles.end(), t));
+                  }
+                  tri[n] = -1;
+               }
+               numTriangles--;
+            }
+            else {
+               for (int n = 0; n < 3; n++) {
+                  if (tri[n] == v) {
+                     tri[n] = u;
+                  }
+               }
+               vertexTriangles[u].push_back(t);
+            }
+         }
+         vTriangles.clear();
+         vertexError[u] = std::max(vertexError[u], vertexError[v] + bestError);
+         collapsedFlag = true;
+      }
+   }
+   
+   //
+   // Remove the unused vertices and the deleted triangles
+   //
+   std::vector<int> newVertexIndex(numVertices, -1);
+   std::vector<float> newCoordinates;
+   newCoordinates.reserve(numVertices * 3);
+   int numNewVertices = 0;
+   for (int v = 0; v < numVertices; v++) {
+      if (vertexTriangles[v].empty() == false) {
+         newVertexIndex[v] = numNewVertices;
+         numNewVertices++;
+         newCoordinates.insert(newCoordinates.end(),
+                               coordinates.begin() + v * 3,
+                               coordinates.begin() + v * 3 + 3);
+      }
+   }
+   std::vector<int> newTriangles;
+   newTriangles.reserve(numTriangles * 3);
+   const int oldNumTriangles = getNumberOfTriangles();
+   for (int t = 0; t < oldNumTriangles; t++) {
+      if (triangles[t * 3] >= 0) {
+         for (int m = 0; m < 3; m++) {
+            newTriangles.push_back(newVertexIndex[triangles[t * 3 + m]]);
+         }
+      }
+   }
+   coordinates.swap(newCoordinates);
+   triangles.swap(newTriangles);
+}
+
+/**
+ * Smooth the mesh.  Each iteration moves every vertex toward the average of its
+ * neighbors' positions from the previous iteration.
+ */
+void
+BrainModelVolumeMarchingCubes::smooth(const float relaxationFactor,
+                                      const int numberOfIterations)
+{
+   const int numVertices = getNumberOfVertices();
+   if ((numVertices <= 0) || (numberOfIterations <= 0)) {
+      return;
+   }
+   normals.clear();
+   
+   std::vector<int> triangleOffsets, vertexTriangles;
+   createVertexTriangles(triangleOffsets, vertexTriangles);
+   
+   //
+   // Find the neighbors of each vertex
+   //
+   std::vector<int> neighborOffsets(numVertices + 1, 0);
+   std::vector<int> neighbors;
+   for (int pass = 0; pass < 2; pass++) {
+      if (pass == 1) {
+         for (int v = 0; v < numVertices; v++) {
+            neighborOffsets[v + 1] += neighborOffsets[v];
+         }
+         neighbors.resize(neighborOffsets[numVertices]);
+      }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+      for (int v = 0; v < numVertices; v++) {
+         std::vector<int> vertexNeighbors;
+         for (int i = triangleOffsets[v]; i < triangleOffsets[v + 1]; i++) {
+            const int* tri = &triangles[vertexTriangles[i] * 3];
+            for (int m = 0; m < 3; m++) {
+               if (tri[m] != v) {
+                  vertexNeighbors.push_back(tri[m]);
+               }
+            }
+         }
+         std::sort(vertexNeighbors.begin(), vertexNeighbors.end());
+         vertexNeighbors.erase(std::unique(vertexNeighbors.begin(), vertexNeighbors.end()),
+                               vertexNeighbors.end());
+         if (pass == 0) {
+            neighborOffsets[v + 1] = vertexNeighbors.size();
+         }
+         else {
+            std::copy(vertexNeighbors.begin(), vertexNeighbors.end(),
+                      neighbors.begin() + neighborOffsets[v]);
+         }
+      }
+   }
+   
+   std::vector<float> previousCoordinates;
+   for (int iter = 0; iter < numberOfIterations; iter++) {
+      previousCoordinates = coordinates;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+      for (int v = 0; v < numVertices; v++) {
+         const int numNeighbors = neighborOffsets[v + 1] - neighborOffsets[v];
+         if (numNeighbors <= 0) {
+            continue;
+         }
+         float sum[3] = { 0.0, 0.0, 0.0 };
+         for (int i = neighborOffsets[v]; i < neighborOffsets[v + 1]; i++) {
+            const float* xyz = &previousCoordinates[neighbors[i] * 3];
+            sum[0] += xyz[0];
+            sum[1] += xyz[1];
+            sum[2] += xyz[2];
+         }
+         for (int m = 0; m < 3; m++) {
+            const float current = previousCoordinates[v * 3 + m];
+            coordinates[v * 3 + m] = current
+                                   + relaxationFactor * (sum[m] / numNeighbors - current);
+         }
+      }
+   }
+}
+
+/**
+ * Compute the vertex normals (average of the area weighted normals of the
+ * vertex's triangles).
+ */
+void
+BrainModelVolumeMarchingCubes::computeNormals()
+{
+   const int numVertices = getNumberOfVertices();
+   const int numTriangles = getNumberOfTriangles();
+   normals.resize(numVertices * 3);
+   
+   std::vector<float> triangleNormals(numTriangles * 3);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int t = 0; t < numTriangles; t++) {
+      const int* tri = &triangles[t * 3];
+      getTriangleNormal(&coordinates[tri[0] * 3],
+                        &coordinates[tri[1] * 3],
+                        &coordinates[tri[2] * 3],
+                        &triangleNormals[t * 3]);
+   }
+   
+   std::vector<int> triangleOffsets, vertexTriangles;
+   createVertexTriangles(triangleOffsets, vertexTriangles);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int v = 0; v < numVertices; v++) {
+      float sum[3] = { 0.0, 0.0, 0.0 };
+      for (int i = triangleOffsets[v]; i < triangleOffsets[v + 1]; i++) {
+         const float* n = &triangleNormals[vertexTriangles[i] * 3];
+         sum[0] += n[0];
+         sum[1] += n[1];
+         sum[2] += n[2];
+      }
+      const float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+      if (length > 0.0) {
+         sum[0] /= length;
+         sum[1] /= length;
+         sum[2] /= length;
+      }
+      normals[v * 3]     = sum[0];
+      normals[v * 3 + 1] = sum[1];
+      normals[v * 3 + 2] = sum[2];
+   }
+}
+
+/**
+ * Create the triangles used by each vertex.  The triangles of vertex "v" are
+ * vertexTriangles[offsets[v]] up to vertexTriangles[offsets[v + 1]].
+ */
+void
+BrainModelVolumeMarchingCubes::createVertexTriangles(std::vector<int>& offsets,
+                                                     std::vector<int>& vertexTriangles) const
+{
+   const int numVertices = getNumberOfVertices();
+   const int numTriangles = getNumberOfTriangles();
+   
+   offsets.assign(numVertices + 1, 0);
+   for (int i = 0; i < (numTriangles * 3); i++) {
+      offsets[triangles[i] + 1]++;
+   }
+   for (int v = 0; v < numVertices; v++) {
+      offsets[v + 1] += offsets[v];
+   }
+   
+   std::vector<int> position(offsets.begin(), offsets.end() - 1);
+   vertexTriangles.resize(numTriangles * 3);
+   for (int i = 0; i < (numTriangles * 3); i++) {
+      vertexTriangles[position[triangles[i]]++] = i / 3;
+   }
+}
+
+/**
+ * Copy the vertices into a coordinate file.
+ */
+void
+BrainModelVolumeMarchingCubes::copyToCoordinateFile(CoordinateFile* cf) const
+{
+   cf->setNumberOfCoordinates(getNumberOfVertices());
+   cf->setAllCoordinates(coordinates);
+}
+
+/**
+ * Copy the triangles into a topology file.
+ */
+void
+BrainModelVolumeMarchingCubes::copyToTopologyFile(TopologyFile* tf) const
+{
+   tf->setAllTiles(triangles);
+   tf->setNumberOfNodes(getNumberOfVertices());
+}
@@ -0,0 +1,117 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#ifndef __BRAIN_MODEL_VOLUME_MARCHING_CUBES_H__
+#define __BRAIN_MODEL_VOLUME_MARCHING_CUBES_H__
+
+#include <vector>
+
+class CoordinateFile;
+class TopologyFile;
+class VolumeFile;
+
+/// Class that builds a triangle mesh from an isosurface of a volume using
+/// marching cubes.  Each edge crossing produces exactly one vertex that is
+/// shared by all cubes containing the edge, so the mesh does not need to be
+/// cleaned.  Voxels greater than the isovalue are inside and the triangles
+/// are ordered so that their normals point out of the inside region.  If the
+/// volume's border voxels are outside, the mesh is closed.
+class BrainModelVolumeMarchingCubes {
+   public:
+      /// Constructor
+      BrainModelVolumeMarchingCubes(const VolumeFile* volumeIn,
+                                    const float isovalueIn);
+      
+      /// Destructor
+      ~BrainModelVolumeMarchingCubes();
+      
+      /// generate the mesh
+      void execute();
+      
+      /// decimate the mesh by collapsing edges in nearly planar regions
+      void decimate(const float targetReduction,
+                    const float maximumError);
+      
+      /// smooth the mesh with laplacian smoothing
+      void smooth(const float relaxationFactor,
+                  const int numberOfIterations);
+      
+      /// compute the vertex normals
+      void computeNormals();
+      
+      /// get the number of vertices
+      int getNumberOfVertices() const { return coordinates.size() / 3; }
+      
+      /// get the number of triangles
+      int getNumberOfTriangles() const { return triangles.size() / 3; }
+      
+      /// get the vertex coordinates (3 per vertex)
+      const std::vector<float>& getCoordinates() const { return coordinates; }
+      
+      /// get the triangles (3 vertices per triangle)
+      const std::vector<int>& getTriangles() const { return triangles; }
+      
+      /// get the vertex normals (3 per vertex, valid after computeNormals())
+      const std::vector<float>& getNormals() const { return normals; }
+      
+      /// copy the vertices into a coordinate file
+      void copyToCoordinateFile(CoordinateFile* cf) const;
+      
+      /// copy the triangles into a topology file
+      void copyToTopologyFile(TopologyFile* tf) const;
+      
+   protected:
+      /// create the table of triangles for each cube case (caller must hold the case table mutex)
+      static void createCaseTable();
+      
+      /// create the triangles used by each vertex (offsets has one more element than vertices)
+      void createVertexTriangles(std::vector<int>& offsets,
+                                 std::vector<int>& vertexTriangles) const;
+      
+      /// triangles (as cube edges) for each of the 256 cube cases
+      static std::vector<int> caseTable[256];
+      
+      /// case table has been created
+      static bool caseTableValid;
+      
+      /// the volume
+      const VolumeFile* volume;
+      
+      /// the isovalue
+      float isovalue;
+      
+      /// the vertex coordinates
+      std::vector<float> coordinates;
+      
+      /// the triangles
+      std::vector<int> triangles;
+      
+      /// the vertex normals
+      std::vector<float> normals;
+};
+
+#endif // __BRAIN_MODEL_VOLUME_MARCHING_CUBES_H__
+
@@ -26,8 +26,8 @@
 #include "BrainModelVolume.h"
 #include "BrainModelVolumeTFCE.h"
 #include "BrainSet.h"
+#include "TFCEUnionFind.h"
 #include "VolumeFile.h"
-#include <cmath>
 
 /**
  * Constructor.
@@ -94,83 +94,147 @@ BrainModelVolumeTFCE::execute() throw (BrainModelAlgorithmException)
             "Input and Output Volumes are of different dimensions.");
       }
    }
-   int i, j, k, ti, tj, tk, maxi, maxj, maxk, mini, minj, mink, temp, growingInd, growingCur, numVoxels = aDim[0] * aDim[1] * aDim[2];
-   float fmax = 0.0f, thresh, valToAdd;
-   float* voxels = inFuncVolume->getVoxelData(), *outData = outFuncVolume->getVoxelData();
-   bool* flagUsed = new bool[numVoxels];//bitwise saves little space, due to other arrays, so make it simple
-   int* growing = new int[numVoxels * 3];//excessive array for storing clusters, just in case (and in case indices range outside 0-255)
-   for (temp = 0; temp < numVoxels; ++temp)
+   
+   computeTFCE(inFuncVolume->getVoxelData(),
+               aDim,
+               numSteps,
+               E,
+               H,
+               outFuncVolume->getVoxelData());
+   
+   if (createdOutVolume) {
+      brainSet->addVolumeFile(VolumeFile::VOLUME_TYPE_SEGMENTATION,
+                              outFuncVolume,
+                              outFuncVolume->getFileName(),
+                              true,
+                              false);
+   }
+   outFuncVolume->setVoxelColoringInvalid();
+}
+
+/**
+ * compute TFCE for many volumes in parallel.  Output volumes must
+ * have the same dimensions as the corresponding input volumes.
+ */
+void 
+BrainModelVolumeTFCE::computeTFCEForVolumes(const std::vector<VolumeFile*>& inVolumes,
+                                            std::vector<VolumeFile*>& outVolumes,
+                                            const int numSteps,
+                                            const float E,
+                                            const float H) throw (BrainModelAlgorithmException)
+{
+   const int numVolumes = static_cast<int>(inVolumes.size());
+   if (static_cast<int>(outVolumes.size()) != numVolumes) {
+      throw BrainModelAlgorithmException(
+         "Number of input and output volumes are different.");
+   }
+   for (int m = 0; m < numVolumes; m++) {
+      if (inVolumes[m]->getNumberOfComponentsPerVoxel() != 1) {
+         throw BrainModelAlgorithmException("Volume has multiple components.");
+      }
+      int aDim[3], sDim[3];
+      inVolumes[m]->getDimensions(aDim);
+      outVolumes[m]->getDimensions(sDim);
+      for (int i = 0; i < 3; i++) {
+         if (aDim[i] != sDim[i]) {
+            throw BrainModelAlgorithmException(
+               "Input and Output Volumes are of different dimensions.");
+         }
+      }
+   }
+   
+   //
+   // Each volume is independent so volumes are divided among threads
+   //
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+   for (int m = 0; m < numVolumes; m++) {
+      int dim[3];
+      inVolumes[m]->getDimensions(dim);
+      computeTFCE(inVolumes[m]->getVoxelData(),
+                  dim,
+                  numSteps,
+                  E,
+                  H,
+                  outVolumes[m]->getVoxelData());
+   }
+   
+   for (int m = 0; m < numVolumes; m++) {
+      outVolumes[m]->setVoxelColoringInvalid();
+   }
+}
+
+/**
+ * compute TFCE of voxel data.  Thresholds are at the center of each of
+ * "numSteps" equal steps from zero to the maximum value.  Voxels are
+ * sorted once and thresholds are swept from high to low, adding voxels
+ * to a union-find forest and merging them with their 26 neighbors, so
+ * clusters are never regrown from scratch.
+ */
+void 
+BrainModelVolumeTFCE::computeTFCE(const float* voxels,
+                                  const int dim[3],
+                                  const int numSteps,
+                                  const float E,
+                                  const float H,
+                                  float* enhancedOut)
+{
+   const int numVoxels = dim[0] * dim[1] * dim[2];
+   float fmax = 0.0f;
+   for (int temp = 0; temp < numVoxels; ++temp)
    {
       if (voxels[temp] > fmax) fmax = voxels[temp];
-      outData[temp] = 0.0f;
+      enhancedOut[temp] = 0.0f;
    }
-   for (thresh = fmax / numSteps / 2.0f; thresh < fmax; thresh += fmax / numSteps)
-   {
-      for (temp = 0; temp < numVoxels; ++temp) flagUsed[temp] = false;
-      for (k = 0; k < aDim[2]; ++k)
-      {
-         for (j = 0; j < aDim[1]; ++j)
-         {
-            for (i = 0; i < aDim[0]; ++i)
-            {
-               temp = inFuncVolume->getVoxelDataIndex(i, j, k);
-               if (!flagUsed[temp] && voxels[temp] >= thresh)
-               {
-                  flagUsed[temp] = true;
-                  growingInd = 3;
-                  growingCur = 0;
-                  growing[0] = i;
-                  growing[1] = j;
-                  growing[2] = k;
-                  while (growingCur < growingInd)
-                  {
-                     maxi = min(aDim[0], growing[growingCur] + 2);
-                     maxj = min(aDim[1], growing[growingCur + 1] + 2);
-                     maxk = min(aDim[2], growing[growingCur + 2] + 2);
-                     mini = max(0, growing[growingCur] - 1);
-                     minj = max(0, growing[growingCur + 1] - 1);
-                     mink = max(0, growing[growingCur + 2] - 1);
-                     for (tk = mink; tk < maxk; ++tk)
-                     {
-                        for (tj = minj; tj < maxj; ++tj)
-                        {
-                           for (ti = mini; ti < maxi; ++ti)
-                           {
-                              temp = inFuncVolume->getVoxelDataIndex(ti, tj, tk);
-                              if (!flagUsed[temp] && voxels[temp] >= thresh)
-                              {
-                                 flagUsed[temp] = true;
-                                 growing[growingInd] = ti;
-                                 growing[growingInd + 1] = tj;
-                                 growing[growingInd + 2] = tk;
-                                 growingInd += 3;
-                              }
-                           }
-                        }
-                     }
-                     growingCur += 3;
-                  }
-                  growingCur = 0;
-                  valToAdd = std::pow(growingInd / 3.0f, E) * std::pow(thresh, H) * fmax / numSteps;// e(h)^E * h^H * dh
-                  //NOTE: integral approximation can be improved using standard weighting techniques, currently uses center of piece method
-                  while (growingCur < growingInd)
-                  {
-                     outData[outFuncVolume->getVoxelDataIndex(growing[growingCur], growing[growingCur + 1], growing[growingCur + 2])] += valToAdd;
-                     growingCur += 3;
+   if ((fmax <= 0.0f) || (numSteps < 1)) {
+      return;
+   }
+   
+   std::vector<int> sortedVoxels;
+   TFCEUnionFind::getElementsSortedByDecreasingValue(voxels, numVoxels, sortedVoxels);
+   const int numSorted = static_cast<int>(sortedVoxels.size());
+   
+   const int sliceSize = dim[0] * dim[1];
+   const float dh = fmax / numSteps;
+   TFCEUnionFind clusters(numVoxels);
+   int nextSorted = 0;
+   for (int step = numSteps - 1; step >= 0; step--) {
+      const float thresh = dh * (step + 0.5f);
+      
+      //
+      // Add voxels at or above this threshold and join their neighbors
+      //
+      while ((nextSorted < numSorted) &&
+             (voxels[sortedVoxels[nextSorted]] >= thresh)) {
+         const int voxel = sortedVoxels[nextSorted];
+         nextSorted++;
+         clusters.addElement(voxel);
+         
+         const int k = voxel / sliceSize;
+         const int j = (voxel - k * sliceSize) / dim[0];
+         const int i = voxel - k * sliceSize - j * dim[0];
+         const int mini = max(0, i - 1), maxi = min(dim[0], i + 2);
+         const int minj = max(0, j - 1), maxj = min(dim[1], j + 2);
+         const int mink = max(0, k - 1), maxk = min(dim[2], k + 2);
+         for (int tk = mink; tk < maxk; ++tk) {
+            for (int tj = minj; tj < maxj; ++tj) {
+               for (int ti = mini; ti < maxi; ++ti) {
+                  const int neighbor = ti + tj * dim[0] + tk * sliceSize;
+                  if ((neighbor != voxel) &&
+                      clusters.isElementAdded(neighbor)) {
+                     clusters.mergeElements(voxel, neighbor);
                   }
                }
             }
          }
       }
+      
+      clusters.addEnhancementForThreshold(thresh, dh, E, H);
    }
-   if (createdOutVolume) {
-      brainSet->addVolumeFile(VolumeFile::VOLUME_TYPE_SEGMENTATION,
-                              outFuncVolume,
-                              outFuncVolume->getFileName(),
-                              true,
-                              false);
+   
+   for (int m = 0; m < nextSorted; m++) {
+      const int voxel = sortedVoxels[m];
+      enhancedOut[voxel] = clusters.getElementEnhancement(voxel);
    }
-   outFuncVolume->setVoxelColoringInvalid();
-   delete[] flagUsed;
-   delete[] growing;
 }
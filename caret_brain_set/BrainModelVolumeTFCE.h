@@ -27,6 +27,8 @@
  */
 /*LICENSE_END*/
 
+#include <vector>
+
 #include "BrainModelAlgorithm.h"
 
 class VolumeFile;
@@ -50,6 +52,21 @@ class BrainModelVolumeTFCE : public BrainModelAlgorithm {
       /// execute the algorithm
       void execute() throw (BrainModelAlgorithmException);
       
+      /// compute TFCE for many volumes in parallel
+      static void computeTFCEForVolumes(const std::vector<VolumeFile*>& inVolumes,
+                                        std::vector<VolumeFile*>& outVolumes,
+                                        const int numSteps = defaultNumSteps(),
+                                        const float E = defaultE(),
+                                        const float H = defaultH()) throw (BrainModelAlgorithmException);
+      
+      /// compute TFCE of voxel data
+      static void computeTFCE(const float* voxels,
+                              const int dim[3],
+                              const int numSteps,
+                              const float E,
+                              const float H,
+                              float* enhancedOut);
+      
       ///default parameters
       static inline const int defaultNumSteps() { return 50; };
       static inline const float defaultE() { return 0.5f; };
@@ -23,25 +23,14 @@
  */
 /*LICENSE_END*/
 
-#include "vtkCellArray.h"
-#include "vtkCleanPolyData.h"
-#include "vtkClipPolyData.h"
-#include "vtkDecimatePro.h"
-#include "vtkImageGaussianSmooth.h"
-#include "vtkImageShrink3D.h"
-#include "vtkMarchingCubes.h"
-#include "vtkPlane.h"
-#include "vtkPolyDataNormals.h"
-#include "vtkPolyDataWriter.h"
-#include "vtkSmoothPolyDataFilter.h"
-#include "vtkStructuredPoints.h"
-#include "vtkTriangleFilter.h"
-
 #include "BrainModelSurface.h"
 #include "BrainModelSurfaceNodeColoring.h"
+#include "BrainModelSurfaceOverlay.h"
+#include "BrainModelVolumeMarchingCubes.h"
 #include "BrainModelVolumeToSurfaceConverter.h"
 #include "BrainSet.h"
 #include "DebugControl.h"
+#include "TopologyFile.h"
 #include "VolumeFile.h"
 #include "VtkModelFile.h"
 
@@ -208,181 +197,50 @@ BrainModelVolumeToSurfaceConverter::generateSolidStructure() throw (BrainModelAl
 void 
 BrainModelVolumeToSurfaceConverter::generateSureFitSurface(const bool maxPolygonsFlag) throw (BrainModelAlgorithmException)
 {
-   //
-   // Convert to structured points
-   //
-   vtkStructuredPoints* sp = segmentationVolumeFile->convertToVtkStructuredPoints();
-
-   double bounds[6];
-   sp->GetBounds(bounds);
-   if (DebugControl::getDebugOn()) {
-      std::cout << "Segmentation input volume bounds: "
-         << bounds[0] << " " << bounds[1] << " "
-         << bounds[2] << " " << bounds[3] << " "
-         << bounds[4] << " " << bounds[5] << std::endl;
-   }
-   
-   //
-   // Shrinker - does this actually do anything ?
-   //
-   vtkImageShrink3D* shrinker = vtkImageShrink3D::New();
-   shrinker->SetInput(sp);
-   shrinker->SetShrinkFactors(1, 1, 1);
-   shrinker->AveragingOn();
-
-   //
-   // Gaussian smooth the volume
-   //   
-   vtkImageGaussianSmooth* gaussian = vtkImageGaussianSmooth::New();
-   gaussian->SetDimensionality(3);
-   gaussian->SetStandardDeviation(0);
-   gaussian->SetInput(shrinker->GetOutput());
-   
-   gaussian->Update();
-   vtkImageData* gaussOut = gaussian->GetOutput();
-   gaussOut->GetBounds(bounds);
-   
-   if (DebugControl::getDebugOn()) {
-      std::cout << "Segmentation shrink/gauss volume bounds: "
-         << bounds[0] << " " << bounds[1] << " "
-         << bounds[2] << " " << bounds[3] << " "
-         << bounds[4] << " " << bounds[5] << std::endl;
-   }
-   
    //
    // Marching cubes converts volume to a surface
    //
-   vtkMarchingCubes* mc = vtkMarchingCubes::New();
-   mc->SetInput(gaussian->GetOutput());
-   //mc->SetValue(0, 511.5);
-   mc->SetValue(0, 127.5);
-   mc->ComputeScalarsOff();
-   mc->ComputeGradientsOff();
-   mc->ComputeNormalsOff();
-   
-   //
-   // Clean up surface created by marching cubes
-   //
-   vtkCleanPolyData* clean = vtkCleanPolyData::New();
-   clean->SetInput(mc->GetOutput());
-   
-   //
-   // Make sure mesh is only triangles
-   //
-   vtkTriangleFilter *triangleFilter = vtkTriangleFilter::New();
-   triangleFilter->SetInput(clean->GetOutput());
-   if (DebugControl::getDebugOn()) {
-      triangleFilter->Update();
-      vtkPolyDataWriter* writer = vtkPolyDataWriter::New();
-      writer->SetInput(triangleFilter->GetOutput());
-      writer->SetFileName("surface_undecimated.vtk");
-      writer->Write();
-      writer->Delete();
-   }
-   
-   triangleFilter->Update();
-   vtkPolyData* boundsPolyData = triangleFilter->GetOutput();
-   boundsPolyData->GetBounds(bounds);
+   BrainModelVolumeMarchingCubes mc(segmentationVolumeFile, 127.5);
+   mc.execute();
    if (DebugControl::getDebugOn()) {
-      std::cout << "Surface bounds: "
-         << bounds[0] << " " << bounds[1] << " "
-         << bounds[2] << " " << bounds[3] << " "
-         << bounds[4] << " " << bounds[5] << std::endl;
+      std::cout << "Marching cubes: " << mc.getNumberOfVertices() << " vertices, "
+                << mc.getNumberOfTriangles() << " triangles." << std::endl;
    }
    
    //
    // See if the surface should be decimated
    //
-   vtkDecimatePro* decimater = NULL;
    if (maxPolygonsFlag == false) {
-      decimater = vtkDecimatePro::New();
+      mc.decimate(0.90, 0.001);
       if (DebugControl::getDebugOn()) {
-         decimater->DebugOn();
-      }
-      double errorVal = 0.001;
-      //if (maxPolygonsFlag) {
-      //   errorVal = 0.0;
-      //}
-      decimater->SetInput(triangleFilter->GetOutput());
-      decimater->SetTargetReduction(0.90);
-      decimater->PreserveTopologyOn();
-      decimater->SetFeatureAngle(30.0);  //45.0); //1);   // orig == 30
-      decimater->SplittingOff();
-      decimater->PreSplitMeshOff();
-      decimater->SetMaximumError(errorVal);
-      decimater->BoundaryVertexDeletionOff();
-      decimater->SetDegree(25);
-      decimater->AccumulateErrorOn();
-      decimater->SetAbsoluteError(errorVal);
-      decimater->SetErrorIsAbsolute(1);
-      
-      if (DebugControl::getDebugOn()) {
-         decimater->PrintSelf(std::cout, static_cast<vtkIndent>(3));
-         decimater->Update();
-         decimater->PrintSelf(std::cout, static_cast<vtkIndent>(3));
-         vtkPolyDataWriter* writer = vtkPolyDataWriter::New();
-         writer->SetInput(decimater->GetOutput());
-         writer->SetFileName("surface_decimated.vtk");
-         writer->Write();
-         writer->Delete();
+         std::cout << "Decimated: " << mc.getNumberOfVertices() << " vertices, "
+                   << mc.getNumberOfTriangles() << " triangles." << std::endl;
       }
    }
-   
-   //
-   // Clean again
-   //
-   vtkCleanPolyData* clean2 = vtkCleanPolyData::New();
-   if (decimater != NULL) {
-      clean2->SetInput(decimater->GetOutput());
-   }
-   else {
-      clean2->SetInput(triangleFilter->GetOutput());
+   if (mc.getNumberOfTriangles() <= 0) {
+      throw BrainModelAlgorithmException("Reconstruction of the segmentation produced no triangles.");
    }
    
    //
    // Since reconstruction successful clear out any existing surfaces
    //
    brainSet->deleteAllBrainModelSurfaces();
-
-   //
-   // Compute normals on the surface
-   //
-   vtkPolyDataNormals* rawNormals = vtkPolyDataNormals::New();
-   rawNormals->SetInput(clean2->GetOutput());
-   rawNormals->SplittingOff();
-   rawNormals->ConsistencyOn();
-   rawNormals->ComputePointNormalsOn();
-   rawNormals->NonManifoldTraversalOn();
+   const bool noNodesFlag = (brainSet->getNumberOfNodes() == 0);
    
    //
-   // Force vtk to execute
+   // Topology is shared by the raw and fiducial surfaces
    //
-   rawNormals->Update();
+   TopologyFile* topologyFile = new TopologyFile;
+   mc.copyToTopologyFile(topologyFile);
+   topologyFile->setTopologyType(TopologyFile::TOPOLOGY_TYPE_CLOSED);
+   brainSet->addTopologyFile(topologyFile);
    
-   //
-   // Get a pointer to the poly data
-   //
-   vtkPolyData* rawPolyDataSurface = rawNormals->GetOutput();
-  
-   if (DebugControl::getDebugOn()) {
-      vtkPolyDataWriter* writer = vtkPolyDataWriter::New();
-      writer->SetInput(rawPolyDataSurface);
-      writer->SetFileName("raw.vtk");
-      writer->Write();
-      writer->Delete();
-   }
-    
-   //
-   // Convert to vtk file to a brain model surface
-   //
-   try {
-      brainSet->importVtkTypeFileHelper("raw.vtk", rawPolyDataSurface,
-                                        true, true, false,
-                                        BrainModelSurface::SURFACE_TYPE_FIDUCIAL,
-                                        TopologyFile::TOPOLOGY_TYPE_CLOSED);
-   }
-   catch (FileException& e) {
-      throw BrainModelAlgorithmException(e.whatQString());
+   addSurface(mc, topologyFile);
+   if (noNodesFlag) {
+      brainSet->getPrimarySurfaceOverlay()->setOverlay(-1, BrainModelSurfaceOverlay::OVERLAY_NONE);
+      brainSet->getSecondarySurfaceOverlay()->setOverlay(-1, BrainModelSurfaceOverlay::OVERLAY_NONE);
+      brainSet->getSurfaceUnderlay()->setOverlay(-1, BrainModelSurfaceOverlay::OVERLAY_NONE);
+      brainSet->postSpecFileReadInitializations();
    }
 
    //
@@ -468,68 +326,8 @@ BrainModelVolumeToSurfaceConverter::generateSureFitSurface(const bool maxPolygon
    //
    // Smooth the surface
    //
-   vtkSmoothPolyDataFilter* smooth = vtkSmoothPolyDataFilter::New();
-   smooth->SetInput(rawPolyDataSurface);
-   smooth->SetNumberOfIterations(10);
-   smooth->SetRelaxationFactor(0.2);
-   smooth->SetFeatureAngle(180.0);
-   smooth->FeatureEdgeSmoothingOff();
-   smooth->BoundarySmoothingOff();
-   smooth->SetConvergence(0);
-   
-   //
-   // Compute normals on the surface
-   //
-   vtkPolyDataNormals* normals = vtkPolyDataNormals::New();
-   normals->SetInput(smooth->GetOutput());
-   normals->SplittingOff();
-   normals->ConsistencyOn();
-   normals->ComputePointNormalsOn();
-   normals->NonManifoldTraversalOn();
-   
-   //
-   // Force vtk to execute
-   //
-   normals->Update();
-   
-   //
-   // Get a pointer to the poly data
-   //
-   vtkPolyData* polyDataSurface = normals->GetOutput();
-   
-   //
-   // Test to clip a surface DO NOT USE THIS AS IT CHANGES TOPOLOGY
-   //
-   bool testFlag = false;
-   if (testFlag) {
-      vtkPlane* plane = vtkPlane::New();
-      plane->SetOrigin(37.0, -42.0, 59.0);
-      plane->SetNormal(0.0, -1.0, 0.0);
-      vtkClipPolyData* clipper = vtkClipPolyData::New();
-      clipper->SetClipFunction(plane);
-      clipper->SetInput(polyDataSurface);
-      clipper->Update();
-      vtkPolyDataWriter* writer = vtkPolyDataWriter::New();
-      writer->SetInput(clipper->GetOutput());
-      writer->SetFileName("surface_cut.vtk");
-      writer->Write();
-      writer->Delete();
-      clipper->Delete();
-      plane->Delete();
-   }
-   
-   //
-   // Convert to vtk file to a brain model surface
-   //
-   try {
-      brainSet->importVtkTypeFileHelper("fiducial.vtk", polyDataSurface,
-                                        true, false, false,
-                                        BrainModelSurface::SURFACE_TYPE_FIDUCIAL,
-                                        TopologyFile::TOPOLOGY_TYPE_CLOSED);
-   }
-   catch (FileException& e) {
-      throw BrainModelAlgorithmException(e.whatQString());
-   }
+   mc.smooth(0.2, 10);
+   addSurface(mc, topologyFile);
   
    //
    // Newest brain model should be the surface
@@ -594,18 +392,6 @@ BrainModelVolumeToSurfaceConverter::generateSureFitSurface(const bool maxPolygon
    // Assign colors to the surface
    //
    //brainSet->getNodeColoring()->assignColors();
-  
-   rawNormals->Delete();
-   normals->Delete();
-   smooth->Delete();
-   if (decimater != NULL) {
-      decimater->Delete();
-   }
-   triangleFilter->Delete();
-   clean->Delete();
-   mc->Delete();
-   
-   sp->Delete();
 }
 
 /**
@@ -614,133 +400,51 @@ BrainModelVolumeToSurfaceConverter::generateSureFitSurface(const bool maxPolygon
 void 
 BrainModelVolumeToSurfaceConverter::generateVtkModel(const bool maxPolygonsFlag) throw (BrainModelAlgorithmException)
 {
-   //
-   // Convert to structured points
-   //
-   vtkStructuredPoints* sp = segmentationVolumeFile->convertToVtkStructuredPoints();
-   
-   //
-   // Shrinker - does this actually do anything ?
-   //
-   vtkImageShrink3D* shrinker = vtkImageShrink3D::New();
-   shrinker->SetInput(sp);
-   shrinker->SetShrinkFactors(1, 1, 1);
-   shrinker->AveragingOn();
-
-   //
-   // Gaussian smooth the volume
-   //   
-   vtkImageGaussianSmooth* gaussian = vtkImageGaussianSmooth::New();
-   gaussian->SetDimensionality(3);
-   gaussian->SetStandardDeviation(0);
-   gaussian->SetInput(shrinker->GetOutput());
-   
    //
    // Marching cubes converts volume to a surface
    //
-   vtkMarchingCubes* mc = vtkMarchingCubes::New();
-   mc->SetInput(gaussian->GetOutput());
-   //mc->SetValue(0, 511.5);
-   mc->SetValue(0, 127.5);
-   mc->ComputeScalarsOff();
-   mc->ComputeGradientsOff();
-   mc->ComputeNormalsOff();
+   BrainModelVolumeMarchingCubes mc(segmentationVolumeFile, 127.5);
+   mc.execute();
    
-   //
-   // Clean up surface created by marching cubes
-   //
-   vtkCleanPolyData* clean = vtkCleanPolyData::New();
-   clean->SetInput(mc->GetOutput());
-   
-   //
-   // Make sure mesh is only triangles
-   //
-   vtkTriangleFilter *triangleFilter = vtkTriangleFilter::New();
-   triangleFilter->SetInput(clean->GetOutput());
-
    //
    // See if the surface should be decimated
    //
-   vtkDecimatePro* decimater = NULL;
    if (maxPolygonsFlag == false) {
-      decimater = vtkDecimatePro::New();
-      if (DebugControl::getDebugOn()) {
-         decimater->DebugOn();
-      }
-      const double errorVal = 0.001;
-      decimater->SetInput(triangleFilter->GetOutput());
-      decimater->SetTargetReduction(0.90);
-      decimater->PreserveTopologyOn();
-      decimater->SetFeatureAngle(30);
-      decimater->SplittingOff();
-      decimater->PreSplitMeshOff();
-      decimater->SetMaximumError(errorVal);
-      decimater->BoundaryVertexDeletionOff();
-      decimater->SetDegree(25);
-      decimater->AccumulateErrorOn();
-      decimater->SetAbsoluteError(errorVal);
-      decimater->SetErrorIsAbsolute(1);
+      mc.decimate(0.90, 0.001);
    }
-   
-   //
-   // Clean again
-   //
-   vtkCleanPolyData* clean2 = vtkCleanPolyData::New();
-   if (decimater != NULL) {
-      clean2->SetInput(decimater->GetOutput());
-   }
-   else {
-      clean2->SetInput(triangleFilter->GetOutput());
+   if (mc.getNumberOfTriangles() <= 0) {
+      throw BrainModelAlgorithmException("Reconstruction of the segmentation produced no triangles.");
    }
    
    //
-   // Smooth the surface
-   //
-   vtkSmoothPolyDataFilter* smooth = vtkSmoothPolyDataFilter::New();
-   smooth->SetInput(clean2->GetOutput());
-   smooth->SetNumberOfIterations(10);
-   smooth->SetRelaxationFactor(0.2);
-   smooth->SetFeatureAngle(180.0);
-   smooth->FeatureEdgeSmoothingOff();
-   smooth->BoundarySmoothingOff();
-   smooth->SetConvergence(0);
-   
-   //
-   // Compute normals on the surface
-   //
-   vtkPolyDataNormals* rawNormals = vtkPolyDataNormals::New();
-   rawNormals->SetInput(smooth->GetOutput());
-   rawNormals->SplittingOff();
-   rawNormals->ConsistencyOn();
-   rawNormals->ComputePointNormalsOn();
-   rawNormals->NonManifoldTraversalOn();
-   
-   //
-   // Force vtk to execute
+   // Smooth the surface and compute normals
    //
-   rawNormals->Update();
-   
-   //
-   // Get a pointer to the poly data
-   //
-   vtkPolyData* rawPolyDataSurface = rawNormals->GetOutput();
+   mc.smooth(0.2, 10);
+   mc.computeNormals();
    
    //
    // Add vtk model file to brain set
    //
-   VtkModelFile* vtkModelFile = new VtkModelFile(rawPolyDataSurface);
+   VtkModelFile* vtkModelFile = new VtkModelFile(mc.getCoordinates(),
+                                                 mc.getTriangles(),
+                                                 mc.getNormals());
    brainSet->addVtkModelFile(vtkModelFile);
    vtkModelFile->setModified();
-   
-   rawNormals->Delete();
-   smooth->Delete();
-   clean2->Delete();
-   if (decimater != NULL) {
-      decimater->Delete();
-   }
-   triangleFilter->Delete();
-   clean->Delete();
-   mc->Delete();
-   
-   sp->Delete();
-}      
+}
+
+/**
+ * Add a fiducial surface using the mesh's vertices and the topology file.
+ */
+void
+BrainModelVolumeToSurfaceConverter::addSurface(const BrainModelVolumeMarchingCubes& mc,
+                                               TopologyFile* topologyFile)
+{
+   BrainModelSurface* bms = new BrainModelSurface(brainSet);
+   mc.copyToCoordinateFile(bms->getCoordinateFile());
+   bms->setTopologyFile(topologyFile);
+   bms->computeNormals();
+   bms->orientNormalsOut();
+   bms->setSurfaceType(BrainModelSurface::SURFACE_TYPE_FIDUCIAL);
+   bms->setStructure(brainSet->getStructure());
+   brainSet->addBrainModel(bms);
+}
@@ -29,6 +29,8 @@
 
 #include "BrainModelAlgorithm.h"
 
+class BrainModelVolumeMarchingCubes;
+class TopologyFile;
 class VolumeFile;
 
 /// Class that converts a segmentation volume to a surface
@@ -78,6 +80,10 @@ class BrainModelVolumeToSurfaceConverter : public BrainModelAlgorithm {
       /// generate a solid structure model
       void generateSolidStructure() throw (BrainModelAlgorithmException);
       
+      /// add a fiducial surface using the mesh's vertices and the topology file
+      void addSurface(const BrainModelVolumeMarchingCubes& mc,
+                      TopologyFile* topologyFile);
+      
       /// the segmentation volume for converting to a surface
       VolumeFile* segmentationVolumeFile;
       
@@ -25,15 +25,19 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iostream>
 #include <sstream>
 
+#include <QTime>
 
 #include "BrainModelSurface.h"
 #include "BrainModelSurfacePointLocator.h"
 #include "BrainModelVolumeToSurfaceMapper.h"
+#include "BrainModelVolumeToSurfaceMapperPlan.h"
 #include "BrainSet.h"
 #include "CaretVersion.h"
 #include "DateAndTime.h"
+#include "DebugControl.h"
 #include "FileUtilities.h"
 #include "GaussianComputation.h"
 #include "MathUtilities.h"
@@ -43,6 +47,7 @@
 #include "TopologyFile.h"
 #include "TopologyHelper.h"
 #include "VolumeFile.h"
+#include "VolumeFileSubVolumeStream.h"
 
 #include "vtkMath.h"
 
@@ -61,6 +66,8 @@ BrainModelVolumeToSurfaceMapper::BrainModelVolumeToSurfaceMapper(
 {
    metricFile = NULL;
    paintFile  = NULL;
+   mappingPlan = NULL;
+   subVolumeOnDisk = NULL;
    
    volumeMode = MODE_VOLUME_IN_MEMORY;
    surface    = surfaceIn;
@@ -86,6 +93,8 @@ BrainModelVolumeToSurfaceMapper::BrainModelVolumeToSurfaceMapper(
 {
    metricFile = NULL;
    paintFile  = NULL;
+   mappingPlan = NULL;
+   subVolumeOnDisk = NULL;
    
    volumeFile = NULL;
    volumeMode = MODE_VOLUME_ON_DISK;
@@ -102,6 +111,10 @@ BrainModelVolumeToSurfaceMapper::BrainModelVolumeToSurfaceMapper(
  */
 BrainModelVolumeToSurfaceMapper::~BrainModelVolumeToSurfaceMapper()
 {
+   if (subVolumeOnDisk != NULL) {
+      delete subVolumeOnDisk;
+      subVolumeOnDisk = NULL;
+   }
 }
 
 /**
@@ -182,6 +195,7 @@ BrainModelVolumeToSurfaceMapper::execute() throw (BrainModelAlgorithmException)
    // Mapping using a file that needs to be read
    //
    VolumeFile volumeFileOnDisk;
+   VolumeFileSubVolumeStream volumeFileStream;
    int numberOfSubVolumes = 1;
    switch (volumeMode) {
       case MODE_VOLUME_ON_DISK:
@@ -194,6 +208,11 @@ BrainModelVolumeToSurfaceMapper::execute() throw (BrainModelAlgorithmException)
                                  VolumeFile::VOLUME_READ_HEADER_ONLY);
             numberOfSubVolumes = volumeFile->getNumberOfSubVolumes();
             
+            //
+            // Sub volumes are streamed so that only a few are in memory
+            //
+            volumeFileStream.openFile(volumeFileName);
+            
             //
             // Determine the number of columns that need to be added to the metric file
             //
@@ -265,18 +284,58 @@ BrainModelVolumeToSurfaceMapper::execute() throw (BrainModelAlgorithmException)
    volumeFile->getSpacing(volumeVoxelSize);
    volumeFile->getDimensions(volumeDimensions);
    
+   //
+   // The linear algorithms map each subvolume with a plan of the voxels and 
+   // weights for each node.  The plan depends only upon the surface, volume 
+   // geometry, and algorithm parameters so it is created once (or reused
+   // from the caller) and applied to every subvolume.
+   //
+   BrainModelVolumeToSurfaceMapperPlan localPlan;
+   BrainModelVolumeToSurfaceMapperPlan* plan = NULL;
+   std::vector<float> planNodeValues;
+   if (BrainModelVolumeToSurfaceMapperPlan::getAlgorithmSupported(
+                                             algorithmParameters.getAlgorithm())) {
+      plan = ((mappingPlan != NULL) ? mappingPlan : &localPlan);
+      const QByteArray planKey = 
+         BrainModelVolumeToSurfaceMapperPlan::computeKey(surface,
+                                                         volumeFile,
+                                                         algorithmParameters);
+      if (plan->getKey() != planKey) {
+         QTime timer;
+         timer.start();
+         createMappingPlan(allCoords, planKey, *plan);
+         if (DebugControl::getDebugOn()) {
+            std::cout << "Time to create volume to surface mapping plan: "
+                      << (timer.elapsed() * 0.001) << " seconds, "
+                      << plan->getNumberOfWeights() << " weights." << std::endl;
+         }
+      }
+      planNodeValues.resize(numberOfNodes, 0.0);
+   }
+   
    for (int j = 0; j < numberOfSubVolumes; j++) {
       switch (volumeMode) {
          case MODE_VOLUME_ON_DISK:
             //
-            // Read the sub volume
+            // Read the next sub volume
             //
+            if (subVolumeOnDisk != NULL) {
+               delete subVolumeOnDisk;
+               subVolumeOnDisk = NULL;
+            }
             try {
-               volumeFile->readFile(volumeFileName, j);
+               subVolumeOnDisk = volumeFileStream.readNextSubVolume();
             }
             catch (FileException& e) {
                throw BrainModelAlgorithmException(e.whatQString());
             }
+            if (subVolumeOnDisk == NULL) {
+               throw BrainModelAlgorithmException("Unable to read sub volume "
+                                                  + QString::number(j + 1)
+                                                  + " of "
+                                                  + volumeFileName);
+            }
+            volumeFile = subVolumeOnDisk;
             break;
          case MODE_VOLUME_IN_MEMORY:
             break;
@@ -308,19 +367,15 @@ BrainModelVolumeToSurfaceMapper::execute() throw (BrainModelAlgorithmException)
       //
       switch (algorithmParameters.getAlgorithm()) {
          case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_AVERAGE_NODES:
-            algorithmMetricAverageNodes(allCoords);
-            break;
          case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_AVERAGE_VOXEL:
-            algorithmMetricAverageVoxel(allCoords);
-            break;
          case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_ENCLOSING_VOXEL:
-            algorithmMetricEnclosingVoxel(allCoords);
-            break;
          case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_GAUSSIAN:
-            algorithmMetricGaussian(allCoords);
-            break;
          case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_INTERPOLATED_VOXEL:
-            algorithmMetricInterpolatedVoxel(allCoords);
+            if (plan->mapVolume(volumeFile, &planNodeValues[0], true) == false) {
+               throw BrainModelAlgorithmException(
+                  "Volume dimensions do not match those of the mapping plan.");
+            }
+            metricFile->setColumnForAllNodes(dataFileColumnNumber, planNodeValues);
             break;
          case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_MAXIMUM_VOXEL:
             algorithmMetricMaximumVoxel(allCoords);
@@ -411,6 +466,15 @@ BrainModelVolumeToSurfaceMapper::execute() throw (BrainModelAlgorithmException)
       dataFileColumnNumber++;
    }
    
+   //
+   // Free the last sub volume read from disk
+   //
+   if (subVolumeOnDisk != NULL) {
+      volumeFile = &volumeFileOnDisk;
+      delete subVolumeOnDisk;
+      subVolumeOnDisk = NULL;
+   }
+   
    //
    // Add paint names for anything that is missing
    //
@@ -425,106 +489,6 @@ BrainModelVolumeToSurfaceMapper::execute() throw (BrainModelAlgorithmException)
    algorithmParameters.transferParametersToPreferncesFile(pf, true);
 }
 
-/**
- * Run the Metric Average Nodes algorithm.
- * The metric for each node is the average of the node and its neighbors voxel values.
- */
-void
-BrainModelVolumeToSurfaceMapper::algorithmMetricAverageNodes(const float* allCoords)
-{
-   for (int i = 0; i < numberOfNodes; i++) {
-      float value = 0.0;
-      
-      if (topologyHelper->getNodeHasNeighbors(i)) {
-            
-         int ijk[3];
-         float pcoords[3];
-         if (volumeFile->convertCoordinatesToVoxelIJK((float*)&allCoords[i*3], 
-                                                                  ijk, pcoords)) {
-            value = volumeFile->getVoxel(ijk, 0); 
-            
-            float numContribute = 1.0;
-            int numNeighbors = 0;
-            const int* neighbors = topologyHelper->getNodeNeighbors(i, numNeighbors);
-            
-            for (int j = 0; j < numNeighbors; j++) {
-               const int n = neighbors[j];
-               if (volumeFile->convertCoordinatesToVoxelIJK((float*)&allCoords[n*3],
-                                                                        ijk, pcoords)) {
-                  value += volumeFile->getVoxel(ijk, 0); 
-                  numContribute += 1.0;
-               }
-            }
-            
-            value /= numContribute;
-         }
-      }
-      
-      metricFile->setValue(i, dataFileColumnNumber, value);       
-   }
-}
-
-/**
- * Run the Metric Average Voxel algorithm
- */
-void
-BrainModelVolumeToSurfaceMapper::algorithmMetricAverageVoxel(const float* allCoords)
-{
-   float averageVoxelNeighbors = 1.0;
-   algorithmParameters.getAlgorithmMetricAverageVoxelParameters(averageVoxelNeighbors);
-   for (int i = 0; i < numberOfNodes; i++) {
-      float value = 0.0;
-      float numValueCounter = 0.0;
-      
-      if (topologyHelper->getNodeHasNeighbors(i)) {
-            
-         int iMin, iMax, jMin, jMax, kMin, kMax;
-         if (getNeighborsSubVolume(&allCoords[i*3], iMin, iMax, jMin, jMax, kMin, kMax, 
-                                   averageVoxelNeighbors)) {
-            
-            for (int ii = iMin; ii <= iMax; ii++) {
-               for (int jj = jMin; jj <= jMax; jj++) {
-                  for (int kk = kMin; kk <= kMax; kk++) {
-                     int ijk[3] = { ii, jj, kk };
-                     value += volumeFile->getVoxel(ijk, 0); 
-                     numValueCounter += 1.0;   
-                  }
-               }
-            }
-         }
-      }
-      
-      if (numValueCounter > 0.0) {
-         value /= numValueCounter;
-      }
-      
-      metricFile->setValue(i, dataFileColumnNumber, value);       
-   }
-}
-
-/**
- * Run the Metric Enclosing Voxel algorithm
- */
-void
-BrainModelVolumeToSurfaceMapper::algorithmMetricEnclosingVoxel(const float* allCoords)
-{
-   for (int i = 0; i < numberOfNodes; i++) {
-      float value = 0.0;
-      
-      if (topologyHelper->getNodeHasNeighbors(i)) {
-            
-         int ijk[3];
-         float pcoords[3];
-         if (volumeFile->convertCoordinatesToVoxelIJK((float*)&allCoords[i*3], 
-                                                                  ijk, pcoords)) {
-            value = volumeFile->getVoxel(ijk, 0);  
-         }
-      }
-      
-      metricFile->setValue(i, dataFileColumnNumber, value);       
-   }
-}
-
 /* SAVED
 void
 BrainModelVolumeToSurfaceMapper::algorithmGaussian(const float* allCoords)
@@ -587,89 +551,190 @@ BrainModelVolumeToSurfaceMapper::algorithmGaussian(const float* allCoords)
  */
  
 /**
- * Run the Metric Gaussian algorithm
+ * create the mapping plan for the linear algorithms.  Each node's voxels
+ * and weights are found in parallel and then packed into the plan.
  */
 void
-BrainModelVolumeToSurfaceMapper::algorithmMetricGaussian(const float* allCoords)
+BrainModelVolumeToSurfaceMapper::createMappingPlan(const float* allCoords,
+                                                   const QByteArray& planKey,
+                                                   BrainModelVolumeToSurfaceMapperPlan& planOut) const
 {
-   float gaussianNeighbors;
-   float gaussianSigmaNorm;
-   float gaussianSigmaTang;
-   float gaussianNormBelowCutoff;
-   float gaussianNormAboveCutoff;
-   float gaussianTangCutoff;
-   algorithmParameters.getAlgorithmMetricGaussianParameters(gaussianNeighbors,
-                                                             gaussianSigmaNorm,
-                                                             gaussianSigmaTang,
-                                                             gaussianNormBelowCutoff,
-                                                             gaussianNormAboveCutoff,
-                                                             gaussianTangCutoff);
-                                                             
-   const float halfVoxelX = volumeVoxelSize[0] * 0.5;
-   const float halfVoxelY = volumeVoxelSize[1] * 0.5;
-   const float halfVoxelZ = volumeVoxelSize[2] * 0.5;
+   std::vector<std::vector<int> > nodeVoxels(numberOfNodes);
+   std::vector<std::vector<float> > nodeWeights(numberOfNodes);
    
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
    for (int i = 0; i < numberOfNodes; i++) {
-      float value = 0.0;
-      
-      if (topologyHelper->getNodeHasNeighbors(i)) {
-            
-         
-         int iMin, iMax, jMin, jMax, kMin, kMax;
-         if (getNeighborsSubVolume(&allCoords[i*3], iMin, iMax, jMin, jMax, kMin, kMax, 
-                                  gaussianNeighbors)) {
-            
-            std::vector<GaussianComputation::Point3D> gaussPoints;
-            
-            for (int ii = iMin; ii <= iMax; ii++) {
-               for (int jj = jMin; jj <= jMax; jj++) {
-                  for (int kk = kMin; kk <= kMax; kk++) {
-                     int ijk[3] = { ii, jj, kk };
-                     
-                     //
-                     // Voxel position - probably should add 1/2 voxel to get voxel center
-                     //
-                     const float voxelPos[3] = {
-                        (ii * volumeVoxelSize[0] + volumeOrigin[0]) + halfVoxelX,
-                        (jj * volumeVoxelSize[1] + volumeOrigin[1]) + halfVoxelY,
-                        (kk * volumeVoxelSize[2] + volumeOrigin[2]) + halfVoxelZ
-                     };
-                     const float v = volumeFile->getVoxel(ijk, 0); 
-                     
-                     gaussPoints.push_back(GaussianComputation::Point3D(voxelPos, v));
-                  }
-               }
-            }
-            
-            GaussianComputation gauss(gaussianNormBelowCutoff,
-                                      gaussianNormAboveCutoff,
-                                      gaussianSigmaNorm,
-                                      gaussianSigmaTang,
-                                      gaussianTangCutoff);
-            value = gauss.evaluate(&allCoords[i*3],
-                                   surface->getNormal(i),
-                                   gaussPoints);
-         }
-      }
-
-      metricFile->setValue(i, dataFileColumnNumber, value);       
+      getNodeMappingWeights(i, allCoords, nodeVoxels[i], nodeWeights[i]);
    }
+   
+   planOut.setNodeWeights(planKey,
+                          volumeDimensions[0] * volumeDimensions[1] * volumeDimensions[2],
+                          nodeVoxels,
+                          nodeWeights);
 }
 
 /**
- * Run the Metric Interpolated Voxel algorithm
+ * get the voxels and weights that map to a node for the linear algorithms.
+ * The node's value is the sum of the voxels multiplied by their weights.
+ * Nodes without neighbors and nodes outside the volume have no voxels.
+ *
+ *   Average Nodes - the voxels containing the node and its neighbors 
+ *                   that are inside the volume, weighted equally.
+ *   Average Voxel - the voxels within a cube about the node, weighted equally.
+ *   Enclosing Voxel - the voxel containing the node.
+ *   Gaussian - the voxels within a cube about the node, weighted by a 
+ *              gaussian oriented with the node's normal.
+ *   Interpolated Voxel - the voxels trilinearly interpolated at the node.
  */
 void
-BrainModelVolumeToSurfaceMapper::algorithmMetricInterpolatedVoxel(const float* allCoords)
+BrainModelVolumeToSurfaceMapper::getNodeMappingWeights(const int nodeNumber,
+                                                       const float* allCoords,
+                                                       std::vector<int>& voxelsOut,
+                                                       std::vector<float>& weightsOut) const
 {
-   for (int i = 0; i < numberOfNodes; i++) {
-      float value = 0.0;
-      
-      if (topologyHelper->getNodeHasNeighbors(i)) {
-         volumeFile->getInterpolatedVoxel(&allCoords[i*3], value);
-      }
-      
-      metricFile->setValue(i, dataFileColumnNumber, value);       
+   voxelsOut.clear();
+   weightsOut.clear();
+   
+   if (topologyHelper->getNodeHasNeighbors(nodeNumber) == false) {
+      return;
+   }
+   
+   const float* xyz = &allCoords[nodeNumber * 3];
+   
+   switch (algorithmParameters.getAlgorithm()) {
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_AVERAGE_NODES:
+         {
+            int ijk[3];
+            if (volumeFile->convertCoordinatesToVoxelIJK(xyz, ijk)) {
+               voxelsOut.push_back(volumeFile->getVoxelNumber(ijk));
+               
+               int numNeighbors = 0;
+               const int* neighbors = topologyHelper->getNodeNeighbors(nodeNumber, numNeighbors);
+               for (int j = 0; j < numNeighbors; j++) {
+                  const int n = neighbors[j];
+                  if (volumeFile->convertCoordinatesToVoxelIJK(&allCoords[n*3], ijk)) {
+                     voxelsOut.push_back(volumeFile->getVoxelNumber(ijk));
+                  }
+               }
+               
+               weightsOut.resize(voxelsOut.size(), 
+                                 1.0 / static_cast<float>(voxelsOut.size()));
+            }
+         }
+         break;
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_AVERAGE_VOXEL:
+         {
+            float averageVoxelNeighbors = 1.0;
+            algorithmParameters.getAlgorithmMetricAverageVoxelParameters(averageVoxelNeighbors);
+            int iMin, iMax, jMin, jMax, kMin, kMax;
+            if (getNeighborsSubVolume(xyz, iMin, iMax, jMin, jMax, kMin, kMax, 
+                                      averageVoxelNeighbors)) {
+               for (int ii = iMin; ii <= iMax; ii++) {
+                  for (int jj = jMin; jj <= jMax; jj++) {
+                     for (int kk = kMin; kk <= kMax; kk++) {
+                        voxelsOut.push_back(volumeFile->getVoxelNumber(ii, jj, kk));
+                     }
+                  }
+               }
+               if (voxelsOut.empty() == false) {
+                  weightsOut.resize(voxelsOut.size(), 
+                                    1.0 / static_cast<float>(voxelsOut.size()));
+               }
+            }
+         }
+         break;
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_ENCLOSING_VOXEL:
+         {
+            int ijk[3];
+            if (volumeFile->convertCoordinatesToVoxelIJK(xyz, ijk)) {
+               voxelsOut.push_back(volumeFile->getVoxelNumber(ijk));
+               weightsOut.push_back(1.0);
+            }
+         }
+         break;
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_GAUSSIAN:
+         {
+            float gaussianNeighbors;
+            float gaussianSigmaNorm;
+            float gaussianSigmaTang;
+            float gaussianNormBelowCutoff;
+            float gaussianNormAboveCutoff;
+            float gaussianTangCutoff;
+            algorithmParameters.getAlgorithmMetricGaussianParameters(gaussianNeighbors,
+                                                                      gaussianSigmaNorm,
+                                                                      gaussianSigmaTang,
+                                                                      gaussianNormBelowCutoff,
+                                                                      gaussianNormAboveCutoff,
+                                                                      gaussianTangCutoff);
+            const float halfVoxelX = volumeVoxelSize[0] * 0.5;
+            const float halfVoxelY = volumeVoxelSize[1] * 0.5;
+            const float halfVoxelZ = volumeVoxelSize[2] * 0.5;
+            
+            int iMin, iMax, jMin, jMax, kMin, kMax;
+            if (getNeighborsSubVolume(xyz, iMin, iMax, jMin, jMax, kMin, kMax, 
+                                      gaussianNeighbors)) {
+               GaussianComputation gauss(gaussianNormBelowCutoff,
+                                         gaussianNormAboveCutoff,
+                                         gaussianSigmaNorm,
+                                         gaussianSigmaTang,
+                                         gaussianTangCutoff);
+               const float* nodeNormal = surface->getNormal(nodeNumber);
+               
+               float weightSum = 0.0;
+               for (int ii = iMin; ii <= iMax; ii++) {
+                  for (int jj = jMin; jj <= jMax; jj++) {
+                     for (int kk = kMin; kk <= kMax; kk++) {
+                        //
+                        // Voxel position - probably should add 1/2 voxel to get voxel center
+                        //
+                        const float voxelPos[3] = {
+                           (ii * volumeVoxelSize[0] + volumeOrigin[0]) + halfVoxelX,
+                           (jj * volumeVoxelSize[1] + volumeOrigin[1]) + halfVoxelY,
+                           (kk * volumeVoxelSize[2] + volumeOrigin[2]) + halfVoxelZ
+                        };
+                        const float w = gauss.evaluate(xyz, nodeNormal, voxelPos);
+                        if (w != 0.0) {
+                           voxelsOut.push_back(volumeFile->getVoxelNumber(ii, jj, kk));
+                           weightsOut.push_back(w);
+                           weightSum += w;
+                        }
+                     }
+                  }
+               }
+               
+               //
+               // Normalize the weights (the node is zero if no weights)
+               //
+               if (weightSum > 0.0) {
+                  for (unsigned int j = 0; j < weightsOut.size(); j++) {
+                     weightsOut[j] /= weightSum;
+                  }
+               }
+               else {
+                  voxelsOut.clear();
+                  weightsOut.clear();
+               }
+            }
+         }
+         break;
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_INTERPOLATED_VOXEL:
+         {
+            int voxelNumbers[8];
+            float weights[8];
+            const int numVoxels = volumeFile->getInterpolatedVoxelWeights(xyz, 
+                                                                          voxelNumbers,
+                                                                          weights);
+            voxelsOut.assign(voxelNumbers, voxelNumbers + numVoxels);
+            weightsOut.assign(weights, weights + numVoxels);
+         }
+         break;
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_MAXIMUM_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_MCW_BRAINFISH:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_STRONGEST_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_PAINT_ENCLOSING_VOXEL:
+         break;
    }
 }
 
@@ -26,13 +26,17 @@
 #ifndef __BRAIN_MODEL_VOLUME_TO_SURFACE_MAPPER_H__
 #define __BRAIN_MODEL_VOLUME_TO_SURFACE_MAPPER_H__
 
+#include <vector>
+
 #include "BrainModelAlgorithm.h"
 #include "BrainModelVolumeToSurfaceMapperAlgorithmParameters.h"
 
 class BrainModelSurface;
+class BrainModelVolumeToSurfaceMapperPlan;
 class GiftiNodeDataFile;
 class MetricFile;
 class PaintFile;
+class QByteArray;
 class TopologyHelper;
 class VolumeFile;
 
@@ -63,21 +67,20 @@ class BrainModelVolumeToSurfaceMapper : public BrainModelAlgorithm {
       /// execute the algorithm
       virtual void execute() throw (BrainModelAlgorithmException);
    
-   protected:
-      /// Run the Metric Average Nodes algorithm
-      void algorithmMetricAverageNodes(const float* allCoords);
-
-      /// Run the Metric Average Voxel algorithm
-      void algorithmMetricAverageVoxel(const float* allCoords);
+      /// set the plan used by the linear algorithms (replaced if it does not match, caller owns)
+      void setMappingPlan(BrainModelVolumeToSurfaceMapperPlan* planIn) { mappingPlan = planIn; }
       
-      /// Run the Metric Enclosing Voxel algorithm
-      void algorithmMetricEnclosingVoxel(const float* allCoords);
-
-      /// Run the Metric Gaussian algorithm
-      void algorithmMetricGaussian(const float* allCoords);
-
-      /// Run the Metric Interpolated Voxel algorithm
-      void algorithmMetricInterpolatedVoxel(const float* allCoords);
+   protected:
+      /// create the mapping plan for the linear algorithms
+      void createMappingPlan(const float* allCoords,
+                             const QByteArray& planKey,
+                             BrainModelVolumeToSurfaceMapperPlan& planOut) const;
+      
+      /// get the voxels and weights that map to a node for the linear algorithms
+      void getNodeMappingWeights(const int nodeNumber,
+                                 const float* allCoords,
+                                 std::vector<int>& voxelsOut,
+                                 std::vector<float>& weightsOut) const;
 
       /// Run the Metric Maximum Voxel algorithm
       void algorithmMetricMaximumVoxel(const float* allCoords);
@@ -137,6 +140,12 @@ class BrainModelVolumeToSurfaceMapper : public BrainModelAlgorithm {
       /// volume file name
       QString volumeFileName;
 
+      /// sub volume read from disk
+      VolumeFile* subVolumeOnDisk;
+      
+      /// plan provided by caller for the linear algorithms
+      BrainModelVolumeToSurfaceMapperPlan* mappingPlan;
+
       /// the topology helper
       TopologyHelper* topologyHelper;
       
@@ -0,0 +1,341 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+
+#include "BinaryCacheFile.h"
+#include "BrainModelSurface.h"
+#include "BrainModelVolumeToSurfaceMapperPlan.h"
+#include "CoordinateFile.h"
+#include "TopologyFile.h"
+#include "VolumeFile.h"
+
+#ifdef _OPENMP
+#include "omp.h"
+#endif
+
+/// identifies a plan file
+static const char planFileMagic[8] = { 'C', 'a', 'r', 'e', 't', 'V', '2', 'S' };
+
+/// version of the plan file (and of the key, change if the weights change)
+static const int planFileVersion = 1;
+
+/**
+ * Constructor.
+ */
+BrainModelVolumeToSurfaceMapperPlan::BrainModelVolumeToSurfaceMapperPlan()
+{
+   clear();
+}
+
+/**
+ * Destructor.
+ */
+BrainModelVolumeToSurfaceMapperPlan::~BrainModelVolumeToSurfaceMapperPlan()
+{
+}
+
+/**
+ * clear the plan.
+ */
+void 
+BrainModelVolumeToSurfaceMapperPlan::clear()
+{
+   planKey.clear();
+   numberOfNodes = 0;
+   numberOfVoxels = 0;
+   rowOffsets.clear();
+   voxelNumbers.clear();
+   weights.clear();
+}
+
+/**
+ * can the algorithm be mapped using a plan.  Only algorithms whose node
+ * values are a weighted sum of voxels, with weights that do not depend
+ * upon the voxel values, may use a plan.
+ */
+bool 
+BrainModelVolumeToSurfaceMapperPlan::getAlgorithmSupported(
+                   const BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM algorithm)
+{
+   switch (algorithm) {
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_AVERAGE_NODES:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_AVERAGE_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_ENCLOSING_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_GAUSSIAN:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_INTERPOLATED_VOXEL:
+         return true;
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_MAXIMUM_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_MCW_BRAINFISH:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_STRONGEST_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_PAINT_ENCLOSING_VOXEL:
+         break;
+   }
+   return false;
+}
+
+/**
+ * compute the key identifying the surface, volume geometry, and algorithm 
+ * parameters (hash of coordinates, topology, volume dimensions, origin,
+ * spacing, and the algorithm's parameters).
+ */
+QByteArray 
+BrainModelVolumeToSurfaceMapperPlan::computeKey(const BrainModelSurface* surface,
+                          const VolumeFile* volumeFile,
+                          const BrainModelVolumeToSurfaceMapperAlgorithmParameters& parameters)
+{
+   QCryptographicHash hash(QCryptographicHash::Md5);
+   
+   BinaryCacheFile(planFileMagic, planFileVersion).addFormatToHash(hash);
+   
+   const CoordinateFile* cf = surface->getCoordinateFile();
+   const int numNodes = cf->getNumberOfCoordinates();
+   hash.addData(reinterpret_cast<const char*>(&numNodes), sizeof(int));
+   if (numNodes > 0) {
+      hash.addData(reinterpret_cast<const char*>(cf->getCoordinate(0)), 
+                   static_cast<int>(numNodes * 3 * sizeof(float)));
+   }
+   
+   const TopologyFile* tf = surface->getTopologyFile();
+   const int numTiles = ((tf != NULL) ? tf->getNumberOfTiles() : 0);
+   hash.addData(reinterpret_cast<const char*>(&numTiles), sizeof(int));
+   for (int i = 0; i < numTiles; i++) {
+      hash.addData(reinterpret_cast<const char*>(tf->getTile(i)), 3 * sizeof(int));
+   }
+   
+   int dim[3];
+   float origin[3], spacing[3];
+   volumeFile->getDimensions(dim);
+   volumeFile->getOrigin(origin);
+   volumeFile->getSpacing(spacing);
+   hash.addData(reinterpret_cast<const char*>(dim), sizeof(dim));
+   hash.addData(reinterpret_cast<const char*>(origin), sizeof(origin));
+   hash.addData(reinterpret_cast<const char*>(spacing), sizeof(spacing));
+   
+   const int algorithm = parameters.getAlgorithm();
+   hash.addData(reinterpret_cast<const char*>(&algorithm), sizeof(int));
+   switch (parameters.getAlgorithm()) {
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_AVERAGE_VOXEL:
+         {
+            float neighbors;
+            parameters.getAlgorithmMetricAverageVoxelParameters(neighbors);
+            hash.addData(reinterpret_cast<const char*>(&neighbors), sizeof(float));
+         }
+         break;
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_GAUSSIAN:
+         {
+            float gaussParams[6];
+            parameters.getAlgorithmMetricGaussianParameters(gaussParams[0],
+                                                            gaussParams[1],
+                                                            gaussParams[2],
+                                                            gaussParams[3],
+                                                            gaussParams[4],
+                                                            gaussParams[5]);
+            hash.addData(reinterpret_cast<const char*>(gaussParams), sizeof(gaussParams));
+            
+            //
+            // Gaussian weights also depend upon the node normals
+            //
+            if (numNodes > 0) {
+               hash.addData(reinterpret_cast<const char*>(surface->getNormal(0)),
+                            static_cast<int>(numNodes * 3 * sizeof(float)));
+            }
+         }
+         break;
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_AVERAGE_NODES:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_ENCLOSING_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_INTERPOLATED_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_MAXIMUM_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_MCW_BRAINFISH:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_METRIC_STRONGEST_VOXEL:
+      case BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM_PAINT_ENCLOSING_VOXEL:
+         break;
+   }
+   
+   return hash.result();
+}
+
+/**
+ * set the plan from each node's voxels and weights.  The rows are packed
+ * into CSR format and the input vectors are cleared.
+ */
+void 
+BrainModelVolumeToSurfaceMapperPlan::setNodeWeights(const QByteArray& keyIn,
+                                                    const int numberOfVoxelsIn,
+                                                    std::vector<std::vector<int> >& nodeVoxels,
+                                                    std::vector<std::vector<float> >& nodeWeights)
+{
+   clear();
+   
+   planKey = keyIn;
+   numberOfNodes = static_cast<int>(nodeVoxels.size());
+   numberOfVoxels = numberOfVoxelsIn;
+   
+   rowOffsets.resize(numberOfNodes + 1);
+   rowOffsets[0] = 0;
+   for (int i = 0; i < numberOfNodes; i++) {
+      rowOffsets[i + 1] = rowOffsets[i] + static_cast<long long>(nodeVoxels[i].size());
+   }
+   voxelNumbers.resize(rowOffsets[numberOfNodes]);
+   weights.resize(rowOffsets[numberOfNodes]);
+   for (int i = 0; i < numberOfNodes; i++) {
+      std::copy(nodeVoxels[i].begin(), nodeVoxels[i].end(), voxelNumbers.begin() + rowOffsets[i]);
+      std::copy(nodeWeights[i].begin(), nodeWeights[i].end(), weights.begin() + rowOffsets[i]);
+      std::vector<int>().swap(nodeVoxels[i]);
+      std::vector<float>().swap(nodeWeights[i]);
+   }
+}
+
+/**
+ * map a volume's first component to the nodes.  The volume must have the
+ * number of voxels of the volume used to create the plan.  Returns true
+ * if successful.
+ */
+bool 
+BrainModelVolumeToSurfaceMapperPlan::mapVolume(const VolumeFile* volumeFile,
+                                               float* valuesOut,
+                                               const bool parallelFlag) const
+{
+   int dim[3];
+   volumeFile->getDimensions(dim);
+   const float* voxels = volumeFile->getVoxelData();
+   if ((voxels == NULL) ||
+       ((dim[0] * dim[1] * dim[2]) != numberOfVoxels)) {
+      return false;
+   }
+   const int numComponents = volumeFile->getNumberOfComponentsPerVoxel();
+   
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024) if (parallelFlag)
+#endif
+   for (int i = 0; i < numberOfNodes; i++) {
+      float value = 0.0f;
+      const long long rowEnd = rowOffsets[i + 1];
+      for (long long j = rowOffsets[i]; j < rowEnd; j++) {
+         value += weights[j] * voxels[static_cast<long long>(voxelNumbers[j]) * numComponents];
+      }
+      valuesOut[i] = value;
+   }
+   
+   return true;
+}
+
+/**
+ * read the plan from a file (returns true if successful).
+ */
+bool 
+BrainModelVolumeToSurfaceMapperPlan::readFile(const QString& fileName)
+{
+   clear();
+   
+   BinaryCacheFile file(planFileMagic, planFileVersion);
+   int numNodes = 0, numVoxels = 0;
+   long long numWeights = 0;
+   const int keySize = QCryptographicHash::hash(QByteArray(), QCryptographicHash::Md5).size();
+   QByteArray key;
+   if ((file.openForReading(fileName, keySize, key) == false) ||
+       (file.readData(&numNodes, sizeof(int)) == false) ||
+       (file.readData(&numVoxels, sizeof(int)) == false) ||
+       (file.readData(&numWeights, sizeof(long long)) == false) ||
+       (numNodes < 0) || 
+       (numVoxels < 0) ||
+       (numWeights < 0)) {
+      return false;
+   }
+   
+   const qint64 offsetsSize = static_cast<qint64>(numNodes + 1) * sizeof(long long);
+   const qint64 voxelsSize  = static_cast<qint64>(numWeights) * sizeof(int);
+   const qint64 weightsSize = static_cast<qint64>(numWeights) * sizeof(float);
+   if (file.getNumberOfBytesRemaining() != (offsetsSize + voxelsSize + weightsSize)) {
+      return false;
+   }
+   
+   rowOffsets.resize(numNodes + 1);
+   voxelNumbers.resize(numWeights);
+   weights.resize(numWeights);
+   if ((file.readData(&rowOffsets[0], offsetsSize) == false) ||
+       ((numWeights > 0) &&
+        ((file.readData(&voxelNumbers[0], voxelsSize) == false) ||
+         (file.readData(&weights[0], weightsSize) == false)))) {
+      clear();
+      return false;
+   }
+   file.closeForReading();
+   
+   //
+   // Verify the structure so that a damaged file cannot cause invalid memory access
+   //
+   bool validFlag = ((rowOffsets[0] == 0) && (rowOffsets[numNodes] == numWeights));
+   for (int i = 0; (i < numNodes) && validFlag; i++) {
+      if (rowOffsets[i + 1] < rowOffsets[i]) {
+         validFlag = false;
+      }
+   }
+   for (long long j = 0; (j < numWeights) && validFlag; j++) {
+      if ((voxelNumbers[j] < 0) || (voxelNumbers[j] >= numVoxels)) {
+         validFlag = false;
+      }
+   }
+   if (validFlag == false) {
+      clear();
+      return false;
+   }
+   
+   planKey = key;
+   numberOfNodes = numNodes;
+   numberOfVoxels = numVoxels;
+   return true;
+}
+
+/**
+ * write the plan to a file.  Other processes never see a partial
+ * file (see BinaryCacheFile).
+ */
+void 
+BrainModelVolumeToSurfaceMapperPlan::writeFile(const QString& fileName) const throw (FileException)
+{
+   if (planKey.isEmpty()) {
+      throw FileException(fileName, "The volume to surface mapping plan is empty.");
+   }
+   
+   BinaryCacheFile file(planFileMagic, planFileVersion);
+   const long long numWeights = getNumberOfWeights();
+   const bool okFlag = 
+      file.openForWriting(fileName, planKey) &&
+      file.writeData(&numberOfNodes, sizeof(int)) &&
+      file.writeData(&numberOfVoxels, sizeof(int)) &&
+      file.writeData(&numWeights, sizeof(long long)) &&
+      file.writeData(&rowOffsets[0], static_cast<qint64>(rowOffsets.size()) * sizeof(long long)) &&
+      ((numWeights <= 0) ||
+       (file.writeData(&voxelNumbers[0], static_cast<qint64>(numWeights) * sizeof(int)) &&
+        file.writeData(&weights[0], static_cast<qint64>(numWeights) * sizeof(float)))) &&
+      file.closeForWriting();
+   if (okFlag == false) {
+      throw FileException(fileName, "Unable to write mapping plan: " + file.getErrorMessage());
+   }
+}
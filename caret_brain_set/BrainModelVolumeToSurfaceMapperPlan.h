@@ -0,0 +1,118 @@
+#ifndef __BRAIN_MODEL_VOLUME_TO_SURFACE_MAPPER_PLAN_H__
+#define __BRAIN_MODEL_VOLUME_TO_SURFACE_MAPPER_PLAN_H__
+
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+#include "BrainModelVolumeToSurfaceMapperAlgorithmParameters.h"
+#include "FileException.h"
+
+class BrainModelSurface;
+class VolumeFile;
+
+/// Plan for mapping volumes to a surface with one of the linear mapping algorithms.
+/// Each node's mapped value is a weighted sum of voxels and the voxels and weights
+/// depend only upon the surface, the geometry of the volume (dimensions, origin, 
+/// and spacing), and the algorithm parameters.  The plan stores these weights as a
+/// sparse node by voxel matrix in compressed sparse row (CSR) format so that mapping
+/// each subvolume of a functional timeseries is a sparse matrix-vector product.
+/// A plan may be written to a file and reused by later mappings, such as batch runs 
+/// of many subjects' timeseries onto the same surface.
+class BrainModelVolumeToSurfaceMapperPlan {
+   public:
+      // constructor
+      BrainModelVolumeToSurfaceMapperPlan();
+      
+      // destructor
+      ~BrainModelVolumeToSurfaceMapperPlan();
+      
+      // clear the plan
+      void clear();
+      
+      // can the algorithm be mapped using a plan
+      static bool getAlgorithmSupported(
+                   const BrainModelVolumeToSurfaceMapperAlgorithmParameters::ALGORITHM algorithm);
+      
+      // compute the key identifying the surface, volume geometry, and algorithm parameters
+      static QByteArray computeKey(const BrainModelSurface* surface,
+                                   const VolumeFile* volumeFile,
+                                   const BrainModelVolumeToSurfaceMapperAlgorithmParameters& parameters);
+      
+      /// get the key of the plan (empty if plan is empty)
+      const QByteArray& getKey() const { return planKey; }
+      
+      // set the plan from each node's voxels and weights (the input vectors are cleared)
+      void setNodeWeights(const QByteArray& keyIn,
+                          const int numberOfVoxelsIn,
+                          std::vector<std::vector<int> >& nodeVoxels,
+                          std::vector<std::vector<float> >& nodeWeights);
+      
+      // map a volume's first component to the nodes ("valuesOut" has getNumberOfNodes() elements)
+      bool mapVolume(const VolumeFile* volumeFile,
+                     float* valuesOut,
+                     const bool parallelFlag) const;
+      
+      /// get the number of nodes (rows of the plan)
+      int getNumberOfNodes() const { return numberOfNodes; }
+      
+      /// get the number of voxels (columns of the plan)
+      int getNumberOfVoxels() const { return numberOfVoxels; }
+      
+      /// get the number of non-zero weights in the plan
+      long long getNumberOfWeights() const { return static_cast<long long>(weights.size()); }
+      
+      // read the plan from a file (returns true if successful)
+      bool readFile(const QString& fileName);
+      
+      // write the plan to a file
+      void writeFile(const QString& fileName) const throw (FileException);
+      
+   protected:
+      /// key identifying surface, volume geometry, and algorithm parameters
+      QByteArray planKey;
+      
+      /// number of nodes
+      int numberOfNodes;
+      
+      /// number of voxels in the volume
+      int numberOfVoxels;
+      
+      /// offset of each node's first weight (numberOfNodes + 1 elements)
+      std::vector<long long> rowOffsets;
+      
+      /// voxel (index ignoring components) of each weight
+      std::vector<int> voxelNumbers;
+      
+      /// the weights
+      std::vector<float> weights;
+};
+
+#endif // __BRAIN_MODEL_VOLUME_TO_SURFACE_MAPPER_PLAN_H__
@@ -61,6 +61,7 @@
 #include "BorderFile.h"
 #include "BorderProjectionFile.h"
 #include "BorderProjectionUnprojector.h"
+#include "BrainModelAlgorithmThreadPool.h"
 #include "BrainModelBorderSet.h"
 #include "BrainModelContours.h"
 #include "BrainModelIdentification.h"
@@ -622,6 +623,13 @@ BrainSet::initializeStaticStuff()
       //          << e.whatQString() << std::endl;
    }
 
+   //
+   // Size of the thread pool (ignored if set on the command line)
+   //
+   BrainModelAlgorithmThreadPool::setNumberOfThreadsFromPreferences(
+      std::max(getPreferencesFile()->getMaximumNumberOfThreads(),
+               getPreferencesFile()->getNumberOfFileReadingThreads()));
+   
    //
    // Random seed generator
    //
@@ -7314,12 +7322,14 @@ BrainSet::readTopologyFile(const QString& name, const TopologyFile::TOPOLOGY_TYP
 }
 
 /**
- * Add a topology file
+ * Add a topology file and update the selected topology files so that
+ * a topology file added after all surfaces were deleted is selected.
  */
 void
 BrainSet::addTopologyFile(TopologyFile* tf)
 {
    topologyFiles.push_back(tf);
+   setSelectedTopologyFiles();
 }
 
 /**
@@ -202,7 +202,7 @@ class BrainSet : public QObject {
       /// delete a brain model
       void deleteBrainModel(const BrainModel* bm);
             
-      /// add a topology file
+      /// add a topology file (updates the selected topology files)
       void addTopologyFile(TopologyFile* tf);
       
       /// delete topology file
@@ -35,9 +35,11 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include <QApplication>
 #include <QProgressDialog>
+#include <QTime>
 
 #include "vtkLine.h"
 #include "vtkMath.h"
@@ -52,6 +54,10 @@
 #include "MathUtilities.h"
 #include "TopologyFile.h"
 
+#ifdef _OPENMP
+#include "omp.h"
+#endif
+
 /**
  * Constructor.  
  */
@@ -60,9 +66,14 @@ CellFileProjector::CellFileProjector(const BrainModelSurface* bmsIn) :
    topologyFile(bmsIn->getTopologyFile()),
    bms(bmsIn)
 {
+   QTime indexTimer;
+   indexTimer.start();
    pointProjector = new BrainModelSurfacePointProjector(bmsIn,
                            BrainModelSurfacePointProjector::SURFACE_TYPE_HINT_OTHER,
                            false);
+   indexBuildTime = indexTimer.elapsed() * 0.001;
+   nearestNodeSearchTime = 0.0;
+   barycentricSolveTime = 0.0;
    hemisphere = bmsIn->getStructure();
 
    //
@@ -122,15 +133,7 @@ CellFileProjector::projectFile(CellProjectionFile* cpf,
          //
          // Set search position to projected position
          //
-         float xyz[3];
-         if (cp->getProjectedPosition(coordinateFile,
-                                      topologyFile,
-                                      true,
-                                      false,
-                                      false,
-                                      xyz)) {
-            cp->setSearchXYZ(xyz);
-         }
+         updateCellSearchPosition(*cp);
          if (progressDialog != NULL) {
             progressDialog->setValue(i + 1);
          }
@@ -172,6 +175,108 @@ CellFileProjector::projectFile(CellProjectionFile* cpf,
    }
 }
 
+/**
+ * Project cell projection file using the BrainModelSurface passed to the
+ * constructor.  The nearest node of every cell is found first with one query
+ * of the shared spatial index.  The cells are then divided among the threads, 
+ * each thread using its own point projector that shares the spatial index.
+ * Each cell's projection depends only upon the cell so the results are the 
+ * same as those produced by projectFile() and are independent of the number
+ * of threads.  Time spent in each phase is available from the get*Time() methods.
+ */
+void
+CellFileProjector::projectFileBatched(CellProjectionFile* cpf,
+                                      const int startIndex,
+                                      const PROJECTION_TYPE projectionType,
+                                      const float projectOntoSurfaceAboveDistance,
+                                      const bool projectOntoSurface,
+                                      const bool runParallelFlag)
+{
+   nearestNodeSearchTime = 0.0;
+   barycentricSolveTime = 0.0;
+   
+   const int numCells = cpf->getNumberOfCellProjections();
+   const int numToProject = numCells - startIndex;
+   if (numToProject <= 0) {
+      return;
+   }
+   
+   //
+   // Get the positions of the cells and find the nearest node to each
+   //
+   QTime searchTimer;
+   searchTimer.start();
+   std::vector<float> cellXYZ(numToProject * 3, 0.0);
+   std::vector<int> cellProjectFlag(numToProject, 0);
+   for (int i = 0; i < numToProject; i++) {
+      CellProjection* cp = cpf->getCellProjection(startIndex + i);
+      if (getCellPositionForProjection(*cp, projectionType, &cellXYZ[i*3])) {
+         cellProjectFlag[i] = 1;
+      }
+   }
+   std::vector<int> cellNearestNode(numToProject, -1);
+   pointProjector->projectToNearestNodes(&cellXYZ[0], 
+                                         numToProject, 
+                                         &cellNearestNode[0],
+                                         runParallelFlag);
+   nearestNodeSearchTime = searchTimer.elapsed() * 0.001;
+   
+   //
+   // Topology helper is created on demand, so create it before threads
+   // use it (all of the information is requested so it is not rebuilt)
+   //
+   QTime barycentricTimer;
+   barycentricTimer.start();
+   topologyFile->getTopologyHelper(true, true, true);
+   
+   //
+   // Project the cells
+   //
+#ifdef _OPENMP
+#pragma omp parallel if (runParallelFlag)
+#endif
+   {
+      //
+      // Point projector keeps search state so each thread needs its own
+      //
+      BrainModelSurfacePointProjector threadProjector(pointProjector);
+      
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+      for (int i = 0; i < numToProject; i++) {
+         CellProjection* cp = cpf->getCellProjection(startIndex + i);
+         if (cellProjectFlag[i] != 0) {
+            projectCellPosition(*cp, 
+                                &cellXYZ[i*3],
+                                projectOntoSurfaceAboveDistance, 
+                                projectOntoSurface,
+                                &threadProjector,
+                                cellNearestNode[i]);
+         }
+         updateCellSearchPosition(*cp);
+      }
+   }
+   barycentricSolveTime = barycentricTimer.elapsed() * 0.001;
+}
+
+/**
+ * Set a cell's search position to its projected position.
+ */
+void 
+CellFileProjector::updateCellSearchPosition(CellProjection& cp) const
+{
+   float xyz[3];
+   if (cp.getProjectedPosition(coordinateFile,
+                               topologyFile,
+                               true,
+                               false,
+                               false,
+                               xyz)) {
+      cp.setSearchXYZ(xyz);
+   }
+}
+
 /**
  * update a cell projection and return number of cell projection
  */
@@ -211,18 +316,38 @@ CellFileProjector::updateCellProjection(const CellFile* cf, const int cellNumber
 */
 
 /**
- * Project a cell.  Returns true if the cell was projected.
+ * Project a cell.
  */
 void 
 CellFileProjector::projectCell(CellProjection& cp, 
                                const PROJECTION_TYPE projectionType,
                                const float projectOntoSurfaceAboveDistance,
                                const bool projectOntoSurface) 
+{
+   float xyz[3];
+   if (getCellPositionForProjection(cp, projectionType, xyz)) {
+      projectCellPosition(cp, 
+                          xyz, 
+                          projectOntoSurfaceAboveDistance, 
+                          projectOntoSurface,
+                          pointProjector,
+                          -1);
+   }
+}
+
+/**
+ * Get the position of a cell for projection.  The cell is marked as not
+ * projected and its fiducial position and structure are set.  Returns false
+ * if the cell has no position or is not to be projected.
+ */
+bool 
+CellFileProjector::getCellPositionForProjection(CellProjection& cp,
+                                                const PROJECTION_TYPE projectionType,
+                                                float xyz[3]) const
 {
    //
    // Get the position of the cell
    //
-   float xyz[3];
    const bool validXYZ = cp.getProjectedPosition(coordinateFile,
                                                  topologyFile,
                                                  fiducialSurfaceFlag,
@@ -239,7 +364,7 @@ CellFileProjector::projectCell(CellProjection& cp,
    // If position is unknown, cannot project cell
    //
    if (validXYZ == false) {
-      return;
+      return false;
    }
    
    //
@@ -273,16 +398,32 @@ CellFileProjector::projectCell(CellProjection& cp,
          break;
       case PROJECTION_TYPE_HEMISPHERE_ONLY:
          if (hemisphere == Structure::STRUCTURE_TYPE_CORTEX_LEFT) {
-            if (xyz[0] > 0.0) return;
+            if (xyz[0] > 0.0) return false;
          }
          else if (hemisphere == Structure::STRUCTURE_TYPE_CORTEX_RIGHT) {
-            if (xyz[0] < 0.0) return;
+            if (xyz[0] < 0.0) return false;
          }
          break;
       case PROJECTION_TYPE_ALL:
          break;
    }
    
+   return true;
+}
+
+/**
+ * Project a cell's position using the given point projector.  If "nearestNode"
+ * is not negative, it is the node nearest to the cell's position.
+ */
+void 
+CellFileProjector::projectCellPosition(CellProjection& cp,
+                                       const float cellXYZ[3],
+                                       const float projectOntoSurfaceAboveDistance,
+                                       const bool projectOntoSurface,
+                                       BrainModelSurfacePointProjector* projector,
+                                       const int nearestNode)
+{
+   float xyz[3] = { cellXYZ[0], cellXYZ[1], cellXYZ[2] };
    
    int nearestTileNumber, tileNodes[3];
    float barycentricAreas[3], distance, distanceComponents[3], signedDistance;
@@ -290,13 +431,14 @@ CellFileProjector::projectCell(CellProjection& cp,
    //
    // Project to the surface
    //
-   const int result = pointProjector->projectBarycentricNearestTile(xyz, 
-                                                                    nearestTileNumber,
-                                                                    tileNodes,
-                                                                    barycentricAreas,
-                                                                    signedDistance,
-                                                                    distance,
-                                                                    distanceComponents);
+   const int result = projector->projectBarycentricNearestTile(xyz, 
+                                                               nearestTileNumber,
+                                                               tileNodes,
+                                                               barycentricAreas,
+                                                               signedDistance,
+                                                               distance,
+                                                               distanceComponents,
+                                                               nearestNode);
    
    //
    // Signed distance to surface
@@ -334,17 +476,20 @@ CellFileProjector::projectCell(CellProjection& cp,
    // Is cell supposed to be projected onto the surface ?
    //
    else if (projectOntoSurface) {
-      const int nearestNode = pointProjector->projectToNearestNode(xyz);
-      if (nearestNode >= 0) {
+      int ontoNode = nearestNode;
+      if (ontoNode < 0) {
+         ontoNode = projector->projectToNearestNode(xyz);
+      }
+      if (ontoNode >= 0) {
          cp.projectionType = CellProjection::PROJECTION_TYPE_INSIDE_TRIANGLE;
        
-         cp.closestTileVertices[0] = nearestNode;
-         cp.closestTileVertices[1] = nearestNode;
-         cp.closestTileVertices[2] = nearestNode;
+         cp.closestTileVertices[0] = ontoNode;
+         cp.closestTileVertices[1] = ontoNode;
+         cp.closestTileVertices[2] = ontoNode;
          cp.closestTileAreas[0] = 1.0;
          cp.closestTileAreas[1] = 1.0;
          cp.closestTileAreas[2] = 1.0;
-         const float* normal = bms->getNormal(nearestNode);
+         const float* normal = bms->getNormal(ontoNode);
          cp.cdistance[0] = normal[0] * projectOntoSurfaceAboveDistance;
          cp.cdistance[1] = normal[1] * projectOntoSurfaceAboveDistance;
          cp.cdistance[2] = normal[2] * projectOntoSurfaceAboveDistance;
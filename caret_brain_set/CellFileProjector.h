@@ -64,11 +64,28 @@ class CellFileProjector {
                        const bool projectOntoSurface,
                        QWidget* progressDialogParent);
                            
+      /// Project the cell projection file in batches that may be run in parallel
+      void projectFileBatched(CellProjectionFile* cpf,
+                              const int startWithCell,
+                              const PROJECTION_TYPE projectionType,
+                              const float projectOntoSurfaceAboveDistance,
+                              const bool projectOntoSurface,
+                              const bool runParallelFlag = true);
+                           
       /// project a single cell 
       void projectCell(CellProjection& cp, 
                        const PROJECTION_TYPE projectionType,
                        const float projectOntoSurfaceAboveDistance,
                        const bool projectOntoSurface);
+      
+      /// get time (seconds) spent building the spatial index in the constructor
+      float getIndexBuildTime() const { return indexBuildTime; }
+      
+      /// get time (seconds) spent finding nearest nodes in last batched projection
+      float getNearestNodeSearchTime() const { return nearestNodeSearchTime; }
+      
+      /// get time (seconds) spent in barycentric projection in last batched projection
+      float getBarycentricSolveTime() const { return barycentricSolveTime; }
                                
       /// update cell number if projected to the cell projection file
       //int updateCellProjection(const CellFile* cf, const int cellNumber, 
@@ -76,6 +93,22 @@ class CellFileProjector {
       //                         const PROJECTION_TYPE projectionType);
                                
    private:
+      /// get the position of a cell for projection (returns false if cell is not projected)
+      bool getCellPositionForProjection(CellProjection& cp,
+                                        const PROJECTION_TYPE projectionType,
+                                        float xyz[3]) const;
+      
+      /// project a cell's position using the given point projector
+      void projectCellPosition(CellProjection& cp,
+                               const float cellXYZ[3],
+                               const float projectOntoSurfaceAboveDistance,
+                               const bool projectOntoSurface,
+                               BrainModelSurfacePointProjector* projector,
+                               const int nearestNode);
+      
+      /// set a cell's search position to its projected position
+      void updateCellSearchPosition(CellProjection& cp) const;
+      
       /// used to project the cell points
       BrainModelSurfacePointProjector* pointProjector;
       
@@ -93,6 +126,15 @@ class CellFileProjector {
       
       /// fiducial surface flag
       bool fiducialSurfaceFlag;
+      
+      /// time (seconds) spent building the spatial index
+      float indexBuildTime;
+      
+      /// time (seconds) spent finding nearest nodes in last batched projection
+      float nearestNodeSearchTime;
+      
+      /// time (seconds) spent in barycentric projection in last batched projection
+      float barycentricSolveTime;
 };
 
 #endif // __VE_CELL_FILE_PROJECTOR_H__
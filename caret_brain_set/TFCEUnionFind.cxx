@@ -0,0 +1,180 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "TFCEUnionFind.h"
+
+/**
+ * Constructor.
+ */
+TFCEUnionFind::TFCEUnionFind(const int numberOfElementsIn,
+                             const float* elementExtentsIn)
+{
+   parent.resize(numberOfElementsIn, -1);
+   clusterCount.resize(numberOfElementsIn, 0);
+   clusterExtent.resize(numberOfElementsIn, 0.0f);
+   enhancement.resize(numberOfElementsIn, 0.0);
+   elementExtents = elementExtentsIn;
+}
+
+/**
+ * Destructor.
+ */
+TFCEUnionFind::~TFCEUnionFind()
+{
+}
+
+/**
+ * add an element as a cluster of its own.
+ */
+void 
+TFCEUnionFind::addElement(const int element)
+{
+   parent[element] = element;
+   clusterCount[element] = 1;
+   clusterExtent[element] = ((elementExtents != NULL) ? elementExtents[element] : 1.0f);
+   enhancement[element] = 0.0;
+   roots.push_back(element);
+}
+
+/**
+ * find the root of an element's cluster compressing the path.  After the
+ * compression the element's enhancement is relative to the root.
+ */
+int 
+TFCEUnionFind::findRoot(const int element)
+{
+   const int p = parent[element];
+   if (p == element) {
+      return element;
+   }
+   
+   //
+   // Union by count keeps the depth logarithmic so recursion is shallow
+   //
+   const int root = findRoot(p);
+   if (p != root) {
+      enhancement[element] += enhancement[p];
+      parent[element] = root;
+   }
+   return root;
+}
+
+/**
+ * merge the clusters containing two added elements.
+ */
+void 
+TFCEUnionFind::mergeElements(const int elementA, const int elementB)
+{
+   int rootA = findRoot(elementA);
+   int rootB = findRoot(elementB);
+   if (rootA == rootB) {
+      return;
+   }
+   
+   //
+   // Attach the smaller cluster below the larger
+   //
+   if (clusterCount[rootA] > clusterCount[rootB]) {
+      std::swap(rootA, rootB);
+   }
+   parent[rootA] = rootB;
+   enhancement[rootA] -= enhancement[rootB];
+   clusterCount[rootB] += clusterCount[rootA];
+   clusterExtent[rootB] += clusterExtent[rootA];
+}
+
+/**
+ * add enhancement for one threshold step to every cluster.
+ * Each cluster receives extent^E * threshold^H * step.
+ */
+void 
+TFCEUnionFind::addEnhancementForThreshold(const float threshold,
+                                          const float thresholdStep,
+                                          const float E,
+                                          const float H)
+{
+   const double thresholdFactor = std::pow(static_cast<double>(threshold), 
+                                           static_cast<double>(H))
+                                * thresholdStep;
+   
+   //
+   // Drop elements that were merged into other clusters
+   //
+   unsigned int numRoots = 0;
+   for (unsigned int i = 0; i < roots.size(); i++) {
+      const int r = roots[i];
+      if (parent[r] == r) {
+         roots[numRoots] = r;
+         numRoots++;
+         enhancement[r] += std::pow(static_cast<double>(clusterExtent[r]),
+                                    static_cast<double>(E))
+                         * thresholdFactor;
+      }
+   }
+   roots.resize(numRoots);
+}
+
+/**
+ * get the enhancement accumulated by an element (zero if never added).
+ */
+float 
+TFCEUnionFind::getElementEnhancement(const int element)
+{
+   if (parent[element] < 0) {
+      return 0.0f;
+   }
+   const int root = findRoot(element);
+   if (root == element) {
+      return enhancement[element];
+   }
+   return (enhancement[element] + enhancement[root]);
+}
+
+/**
+ * get elements with a positive value sorted by decreasing value.
+ */
+void 
+TFCEUnionFind::getElementsSortedByDecreasingValue(const float* values,
+                                                  const int numberOfValues,
+                                                  std::vector<int>& sortedElementsOut)
+{
+   std::vector<std::pair<float,int> > valueElements;
+   for (int i = 0; i < numberOfValues; i++) {
+      if (values[i] > 0.0f) {
+         valueElements.push_back(std::make_pair(values[i], i));
+      }
+   }
+   std::sort(valueElements.begin(), valueElements.end(),
+             std::greater<std::pair<float,int> >());
+   
+   sortedElementsOut.resize(valueElements.size());
+   for (unsigned int i = 0; i < valueElements.size(); i++) {
+      sortedElementsOut[i] = valueElements[i].second;
+   }
+}
@@ -0,0 +1,94 @@
+#ifndef __TFCE_UNION_FIND_H__
+#define __TFCE_UNION_FIND_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <cstddef>
+#include <vector>
+
+/// Disjoint set forest used to compute threshold-free cluster enhancement
+/// by sweeping thresholds from high to low.  Elements are added as the
+/// threshold drops below their value and merged with their already added
+/// neighbors so that each cluster's extent is always known at its root.
+/// Enhancement added to a cluster is stored at its root and pushed down
+/// to the members lazily, so each step costs one visit per cluster
+/// instead of one per element.
+class TFCEUnionFind {
+   public:
+      /// Constructor (extents may be NULL for an extent of one per element)
+      TFCEUnionFind(const int numberOfElementsIn,
+                    const float* elementExtentsIn = NULL);
+      
+      /// Destructor
+      ~TFCEUnionFind();
+      
+      /// add an element as a cluster of its own
+      void addElement(const int element);
+      
+      /// see if an element has been added
+      bool isElementAdded(const int element) const { return (parent[element] >= 0); }
+      
+      /// merge the clusters containing two added elements
+      void mergeElements(const int elementA, const int elementB);
+      
+      /// add enhancement for one threshold step to every cluster
+      void addEnhancementForThreshold(const float threshold,
+                                      const float thresholdStep,
+                                      const float E,
+                                      const float H);
+      
+      /// get the enhancement accumulated by an element (zero if never added)
+      float getElementEnhancement(const int element);
+      
+      /// get elements with a positive value sorted by decreasing value
+      static void getElementsSortedByDecreasingValue(const float* values,
+                                                     const int numberOfValues,
+                                                     std::vector<int>& sortedElementsOut);
+      
+   protected:
+      /// find the root of an element's cluster compressing the path
+      int findRoot(const int element);
+      
+      /// parent of each element (-1 if not added, itself if a root)
+      std::vector<int> parent;
+      
+      /// number of elements in the cluster (valid at roots)
+      std::vector<int> clusterCount;
+      
+      /// extent of the cluster (valid at roots)
+      std::vector<float> clusterExtent;
+      
+      /// enhancement relative to the parent (absolute at roots)
+      std::vector<double> enhancement;
+      
+      /// elements that were roots when last checked
+      std::vector<int> roots;
+      
+      /// extent of each element (NULL if one)
+      const float* elementExtents;
+};
+
+#endif // __TFCE_UNION_FIND_H__
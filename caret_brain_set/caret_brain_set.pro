@@ -26,6 +26,7 @@ HEADERS += BorderFileProjector.h \
       BrainModelAlgorithmMultiThreadExecutor.h \
 	   BrainModelAlgorithmMultiThreaded.h \
       BrainModelAlgorithmRunAsThread.h \
+      BrainModelAlgorithmThreadPool.h \
 	   BrainModelBorderSet.h \
        BrainModelCiftiCorrelationMatrix.h \
       BrainModelCiftiDenseConnectomeGradient.h \
@@ -36,6 +37,7 @@ HEADERS += BorderFileProjector.h \
       BrainModelIdentification.h \
       BrainModelOpenGL.h \
       BrainModelOpenGLSelectedItem.h \
+      BrainModelOpenGLSurfaceBuffers.h \
       BrainModelRunExternalProgram.h \
       BrainModelStandardSurfaceReplacement.h \
       BrainModelSurface.h \
@@ -72,6 +74,7 @@ HEADERS += BorderFileProjector.h \
       BrainModelSurfaceFociSearch.h \
       BrainModelSurfaceFociUncertaintyToRgbPaint.h \
 	   BrainModelSurfaceGeodesic.h \
+      BrainModelSurfaceGeodesicGaussianOperator.h \
       BrainModelSurfaceMetricAnovaOneWay.h \
       BrainModelSurfaceMetricAnovaTwoWay.h \
 	   BrainModelSurfaceMetricClustering.h \
@@ -89,6 +92,7 @@ HEADERS += BorderFileProjector.h \
       BrainModelSurfaceMetricTwoSampleTTest.h \
       BrainModelSurfaceMetricSmoothing.h \
       BrainModelSurfaceMetricSmoothingAll.h \
+      BrainModelSurfaceMetricTFCE.h \
 	   BrainModelSurfaceMorphing.h \
 	   BrainModelSurfaceMultiresolutionMorphing.h \
       BrainModelSurfaceNodeColoring.h \
@@ -118,6 +122,7 @@ HEADERS += BorderFileProjector.h \
       BrainModelSurfaceROIShapeCorrelationReport.h \
       BrainModelSurfaceROISurfaceXYZMeansReport.h \
       BrainModelSurfaceROITextReport.h \
+      BrainModelSurfaceReorderNodes.h \
 	   BrainModelSurfaceResection.h \
 	   BrainModelSurfaceSmoothing.h \
       BrainModelSurfaceSphericalTessellator.h \
@@ -136,6 +141,7 @@ HEADERS += BorderFileProjector.h \
       BrainModelVolumeGradient.h \
 	   BrainModelVolumeHandleFinder.h \
       BrainModelVolumeLigaseSegmentation.h \
+      BrainModelVolumeMarchingCubes.h \
       BrainModelVolumeNearToPlane.h \
       BrainModelVolumeProbAtlasToFunctional.h \
       BrainModelVolumeRegionOfInterest.h \
@@ -152,6 +158,7 @@ HEADERS += BorderFileProjector.h \
       BrainModelVolumeToSurfaceMapper.h \
       BrainModelVolumeToSurfaceMapperAlgorithmParameters.h \
       BrainModelVolumeToSurfaceMapperPALS.h \
+      BrainModelVolumeToSurfaceMapperPlan.h \
       BrainModelVolumeToVtkSurfaceMapper.h \
       BrainModelVolumeTopologicalError.h \
       BrainModelVolumeTopologyGraph.h \
@@ -199,6 +206,7 @@ HEADERS += BorderFileProjector.h \
       FociFileToPalsProjector.h \
       MapFmriAtlasSpecFileInfo.h \
 	   MetricsToRgbPaintConverter.h \
+      TFCEUnionFind.h \
       Tessellation.h 
 
 SOURCES += BorderFileProjector.cxx \
@@ -211,6 +219,7 @@ SOURCES += BorderFileProjector.cxx \
       BrainModelAlgorithmMultiThreadExecutor.cxx \
 	   BrainModelAlgorithmMultiThreaded.cxx \
       BrainModelAlgorithmRunAsThread.cxx \
+      BrainModelAlgorithmThreadPool.cxx \
 	   BrainModelBorderSet.cxx \
        BrainModelCiftiCorrelationMatrix.cxx \
       BrainModelCiftiDenseConnectomeGradient.cxx \
@@ -221,6 +230,7 @@ SOURCES += BorderFileProjector.cxx \
       BrainModelIdentification.cxx \
       BrainModelOpenGL.cxx \
       BrainModelOpenGLSelectedItem.cxx \
+      BrainModelOpenGLSurfaceBuffers.cxx \
       BrainModelRunExternalProgram.cxx \
       BrainModelStandardSurfaceReplacement.cxx \
       BrainModelSurface.cxx \
@@ -257,6 +267,7 @@ SOURCES += BorderFileProjector.cxx \
       BrainModelSurfaceFociSearch.cxx \
       BrainModelSurfaceFociUncertaintyToRgbPaint.cxx \
 	   BrainModelSurfaceGeodesic.cxx \
+      BrainModelSurfaceGeodesicGaussianOperator.cxx \
       BrainModelSurfaceMetricAnovaOneWay.cxx \
       BrainModelSurfaceMetricAnovaTwoWay.cxx \
 	   BrainModelSurfaceMetricClustering.cxx \
@@ -274,6 +285,7 @@ SOURCES += BorderFileProjector.cxx \
       BrainModelSurfaceMetricTwoSampleTTest.cxx \
       BrainModelSurfaceMetricSmoothing.cxx \
       BrainModelSurfaceMetricSmoothingAll.cxx \
+      BrainModelSurfaceMetricTFCE.cxx \
 	   BrainModelSurfaceMorphing.cxx \
 	   BrainModelSurfaceMultiresolutionMorphing.cxx \
       BrainModelSurfaceNodeColoring.cxx \
@@ -303,6 +315,7 @@ SOURCES += BorderFileProjector.cxx \
       BrainModelSurfaceROIShapeCorrelationReport.cxx \
       BrainModelSurfaceROISurfaceXYZMeansReport.cxx \
       BrainModelSurfaceROITextReport.cxx \
+      BrainModelSurfaceReorderNodes.cxx \
 	   BrainModelSurfaceResection.cxx \
       BrainModelSurfaceSphericalTessellator.cxx \
 	   BrainModelSurfaceSmoothing.cxx \
@@ -321,6 +334,7 @@ SOURCES += BorderFileProjector.cxx \
       BrainModelVolumeGradient.cxx \
 	   BrainModelVolumeHandleFinder.cxx \
       BrainModelVolumeLigaseSegmentation.cxx \
+      BrainModelVolumeMarchingCubes.cxx \
       BrainModelVolumeNearToPlane.cxx \
       BrainModelVolumeProbAtlasToFunctional.cxx \
       BrainModelVolumeRegionOfInterest.cxx \
@@ -337,6 +351,7 @@ SOURCES += BorderFileProjector.cxx \
       BrainModelVolumeToSurfaceMapper.cxx \
       BrainModelVolumeToSurfaceMapperAlgorithmParameters.cxx \
       BrainModelVolumeToSurfaceMapperPALS.cxx \
+      BrainModelVolumeToSurfaceMapperPlan.cxx \
       BrainModelVolumeToVtkSurfaceMapper.cxx \
       BrainModelVolumeTopologicalError.cxx \
       BrainModelVolumeTopologyGraph.cxx \
@@ -383,4 +398,5 @@ SOURCES += BorderFileProjector.cxx \
       FociFileToPalsProjector.cxx \
       MapFmriAtlasSpecFileInfo.cxx \
 	   MetricsToRgbPaintConverter.cxx \
+      TFCEUnionFind.cxx \
       Tessellation.cxx 
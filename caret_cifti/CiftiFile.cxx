@@ -37,7 +37,7 @@ using namespace std;
  * 
  * Default Constructor
  * @param CACHE_LEVEL specifies whether the file is loaded into memory, or kept on disk
- * currently only IN_MEMORY is supported 
+ * ON_DISK memory maps the matrix rather than reading it
  */
 CiftiFile::CiftiFile(CACHE_LEVEL clevel) throw (CiftiFileException)
 {
@@ -52,7 +52,7 @@ CiftiFile::CiftiFile(CACHE_LEVEL clevel) throw (CiftiFileException)
  * 
  * @param fileName name and path of the Cifti File
  * @param CACHE_LEVEL specifies whether the file is loaded into memory, or kept on disk
- * currently only IN_MEMORY is supported
+ * ON_DISK memory maps the matrix rather than reading it
  */
 CiftiFile::CiftiFile(const QString &fileName,CACHE_LEVEL clevel) throw (CiftiFileException) 
 {
@@ -108,7 +108,7 @@ void CiftiFile::openFile(const QString &fileName) throw (CiftiFileException)
  * 
  * @param fileName name and path of the Cifti File
  * @param CACHE_LEVEL specifies whether the file is loaded into memory, or kept on disk
- * currently only IN_MEMORY is supported 
+ * ON_DISK memory maps the matrix rather than reading it
  */
 void CiftiFile::openFile(const QString &fileName, CACHE_LEVEL clevel) throw (CiftiFileException)
 {
@@ -121,12 +121,46 @@ void CiftiFile::openFile(const QString &fileName, CACHE_LEVEL clevel) throw (Cif
  * 
  * write the Cifti File
  * 
- * @param fileName specifies the name and path of the file to write to
+ * @param fileName specifies the name and path of the file to write to, if it is 
+ * the file an ON_DISK matrix is mapped from, the file is written under a temporary 
+ * name and then replaces the mapped file, since opening it for writing would 
+ * truncate the mapped data
  */
 void CiftiFile::writeFile(const QString &fileName) const throw (CiftiFileException)
 {
+   bool replaceMappedFile = false;
+   if(m_matrix && m_matrix->getCacheLevel() == ON_DISK)
+   {
+      const QString mappedFileName = QFileInfo(m_matrix->getMappedFileName()).canonicalFilePath();
+      replaceMappedFile = (!mappedFileName.isEmpty() &&
+                           QFileInfo(fileName).canonicalFilePath() == mappedFileName);
+   }
+   
    QFile outputFile(fileName);
-   outputFile.open(QIODevice::WriteOnly);
+   if(replaceMappedFile) outputFile.setFileName(fileName + ".writing");
+   if(!outputFile.open(QIODevice::WriteOnly))
+   {
+      throw CiftiFileException(outputFile.fileName(), "Unable to open file for writing: " + outputFile.errorString());
+   }
+   writeHeaderAndExtension(outputFile);
+   const unsigned long long matrixOffset = outputFile.pos();
+   m_matrix->writeMatrix(outputFile);
+   outputFile.close();
+   
+   if(replaceMappedFile) m_matrix->replaceMappedFile(outputFile.fileName(), matrixOffset);
+}
+
+/** 
+ * 
+ * 
+ * write the Nifti2 Header and Cifti XML extension, leaving the file
+ * positioned at the start of the matrix, so that the matrix can be 
+ * appended in pieces by the caller
+ * 
+ * @param outputFile open file to write to
+ */
+void CiftiFile::writeHeaderAndExtension(QFile &outputFile) const throw (CiftiFileException)
+{
    //Get XML string and length, which is needed to calculate the vox_offset stored in the Nifti Header
    QByteArray xmlBytes;
    m_xml->writeXML(xmlBytes);
@@ -154,8 +188,6 @@ void CiftiFile::writeFile(const QString &fileName) const throw (CiftiFileExcepti
    char junk[] = "         ";//filler for 8 byte alignment
    char* junk2 = &(junk[0]);
    if (padding) outputFile.write(junk2, padding);
-   m_matrix->writeMatrix(outputFile);
-   outputFile.close();
 }
 
 /**
@@ -269,7 +301,16 @@ void CiftiFile::readCiftiMatrix() throw (CiftiFileException)
    if(m_matrix != NULL) delete m_matrix;
    std::vector <int> dimensions;
    m_nifti2Header->getCiftiDimensions(dimensions);
-   m_matrix = new CiftiMatrix(m_inputFile, dimensions,m_clevel);
+   if(m_clevel == ON_DISK)
+   {//map the matrix from where the header says it starts, rather than where the extensions left off
+      nifti_2_header header;
+      m_nifti2Header->getHeaderStruct(header);
+      m_matrix = new CiftiMatrix(m_inputFile.fileName(), dimensions, header.vox_offset, m_clevel);
+   }
+   else
+   {
+      m_matrix = new CiftiMatrix(m_inputFile, dimensions,m_clevel);
+   }
    m_matrix->setCopyData(m_copyMatrix);
    if(m_swapNeeded) m_matrix->swapByteOrder();
 }
@@ -46,6 +46,8 @@ public:
    virtual void openFile(const QString &fileName, CACHE_LEVEL clevel) throw (CiftiFileException);
    /// Write the Cifti File
    virtual void writeFile(const QString &fileName) const throw (CiftiFileException);
+   /// Write the Nifti2 Header and Cifti XML, so the matrix can be appended by the caller
+   virtual void writeHeaderAndExtension(QFile &outputFile) const throw (CiftiFileException);
    /// set Nifti2Header
    virtual void setHeader(const Nifti2Header &header) throw (CiftiFileException);
    /// get Nifti2Header
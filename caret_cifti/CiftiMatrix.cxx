@@ -85,6 +85,52 @@ CiftiMatrix::CiftiMatrix() throw (CiftiFileException)
    init();   
 }
 
+/**
+ * Copy Constructor
+ * 
+ * Copy Constructor, IN_MEMORY matrices are deep copied, ON_DISK matrices
+ * map the same region of the same file again
+ * @param matrix
+ */
+CiftiMatrix::CiftiMatrix(const CiftiMatrix &matrix) throw (CiftiFileException)
+{
+   init();
+   copyHelper(matrix);
+}
+
+/**
+ * Assignment Operator
+ * 
+ * Assignment Operator
+ * @param matrix
+ */
+CiftiMatrix &CiftiMatrix::operator=(const CiftiMatrix &matrix) throw (CiftiFileException)
+{
+   if(this != &matrix)
+   {
+      freeMatrix();
+      copyHelper(matrix);
+   }
+   return *this;
+}
+
+void CiftiMatrix::copyHelper(const CiftiMatrix &matrix) throw (CiftiFileException)
+{
+   m_clevel = matrix.m_clevel;
+   m_copyData = matrix.m_copyData;
+   setDimensions(matrix.m_dimensions);
+   if(m_clevel == ON_DISK)
+   {
+      mapMatrix(matrix.m_mappedFile.fileName(), matrix.m_mappedOffset);
+      m_mappedSwapNeeded = matrix.m_mappedSwapNeeded;
+   }
+   else if(matrix.m_matrix)
+   {
+      m_matrix = new float[m_length];
+      memcpy((char *)m_matrix,(char *)matrix.m_matrix,m_length*4);
+   }
+}
+
 /**
  * Destructor
  * 
@@ -102,6 +148,11 @@ CiftiMatrix::~CiftiMatrix()
  */
 void CiftiMatrix::swapByteOrder()
 {
+   if(m_clevel == ON_DISK)
+   {
+      m_mappedSwapNeeded = !m_mappedSwapNeeded;//the mapping is read only, values are swapped as they are read
+      return;
+   }
    CiftiByteSwap::swapBytes(m_matrix,m_length);   
 }
 
@@ -117,6 +168,15 @@ void CiftiMatrix::swapByteOrder()
 void CiftiMatrix::getMatrixData(float *&matrix, std::vector <int> &dimensions)
 {   
    dimensions = m_dimensions;
+   if(m_clevel == ON_DISK)
+   {//caller wants the whole thing, so bring it into memory and stop using the mapping
+      float * data = new float [m_length];
+      readMappedValues(data, 0, m_length);
+      freeMatrix();
+      setDimensions(dimensions);
+      m_clevel = IN_MEMORY;
+      m_matrix = data;
+   }
    if(m_copyData)
    {
       matrix = new float [m_length];
@@ -141,6 +201,7 @@ void CiftiMatrix::setMatrixData(float *data, std::vector <int> &dimensions)
 {
    freeMatrix();
    setDimensions(dimensions);
+   m_clevel = IN_MEMORY;
    
    if(m_copyData)
    {
@@ -174,6 +235,129 @@ void CiftiMatrix::getDimensions(std::vector <int>& dimensions)
    dimensions = m_dimensions;
 }
 
+/**
+ * get Number Of Rows
+ * 
+ * get Number of Rows, the first dimension of the matrix
+ * @return number of rows
+ */
+long long CiftiMatrix::getNumberOfRows() const
+{
+   if(m_dimensions.size() == 0) return 0;
+   return m_dimensions[0];
+}
+
+/**
+ * get Number Of Columns
+ * 
+ * get Number of Columns, the product of all remaining dimensions
+ * @return number of columns
+ */
+long long CiftiMatrix::getNumberOfColumns() const
+{
+   long long rows = getNumberOfRows();
+   if(rows == 0) return 0;
+   return m_length / rows;
+}
+
+/**
+ * get Cache Level
+ * 
+ * get Cache Level, note that getMatrixData and setMatrixData change an
+ * ON_DISK matrix to IN_MEMORY
+ * @return cache level
+ */
+CACHE_LEVEL CiftiMatrix::getCacheLevel() const
+{
+   return m_clevel;
+}
+
+/**
+ * get Row
+ * 
+ * copies one row of the matrix, works for either cache level
+ * @param rowOut must be allocated to hold getNumberOfColumns() floats
+ * @param row index of row to get
+ */
+void CiftiMatrix::getRow(float *rowOut, long long row) const throw (CiftiFileException)
+{
+   getRowRange(rowOut, row, 1);
+}
+
+/**
+ * get Row Range
+ * 
+ * copies consecutive rows of the matrix, works for either cache level
+ * @param rowsOut must be allocated to hold numRows * getNumberOfColumns() floats
+ * @param firstRow index of first row to get
+ * @param numRows number of rows to get
+ */
+void CiftiMatrix::getRowRange(float *rowsOut, long long firstRow, long long numRows) const throw (CiftiFileException)
+{
+   if(firstRow < 0 || numRows < 0 || firstRow + numRows > getNumberOfRows())
+   {
+      throw CiftiFileException("Requested rows are outside of the Cifti Matrix.");
+   }
+   long long cols = getNumberOfColumns();
+   if(m_clevel == ON_DISK)
+   {
+      readMappedValues(rowsOut, firstRow * cols, numRows * cols);
+   }
+   else
+   {
+      if(!m_matrix) throw CiftiFileException("Cifti Matrix has no data.");
+      memcpy((char *)rowsOut, (char *)(m_matrix + firstRow * cols), numRows * cols * 4);
+   }
+}
+
+/**
+ * get Column
+ * 
+ * copies one column of the matrix, works for either cache level, for
+ * ON_DISK matrices this touches one page per row, so prefer getRow
+ * @param columnOut must be allocated to hold getNumberOfRows() floats
+ * @param column index of column to get
+ */
+void CiftiMatrix::getColumn(float *columnOut, long long column) const throw (CiftiFileException)
+{
+   long long cols = getNumberOfColumns();
+   if(column < 0 || column >= cols)
+   {
+      throw CiftiFileException("Requested column is outside of the Cifti Matrix.");
+   }
+   long long rows = getNumberOfRows();
+   if(m_clevel == ON_DISK)
+   {
+      for(long long i = 0;i<rows;i++)
+      {
+         readMappedValues(columnOut + i, i * cols + column, 1);
+      }
+   }
+   else
+   {
+      if(!m_matrix) throw CiftiFileException("Cifti Matrix has no data.");
+      for(long long i = 0;i<rows;i++)
+      {
+         columnOut[i] = m_matrix[i * cols + column];
+      }
+   }
+}
+
+/**
+ * read Mapped Values
+ * 
+ * copies values out of the mapped file, and swaps them if needed,
+ * the mapping itself is never written to
+ * @param dataOut
+ * @param firstValue index of the first value, in floats from the start of the matrix
+ * @param numValues
+ */
+void CiftiMatrix::readMappedValues(float *dataOut, long long firstValue, long long numValues) const
+{
+   memcpy((char *)dataOut, (char *)(m_mappedMatrix + firstValue * 4), numValues * 4);
+   if(m_mappedSwapNeeded) CiftiByteSwap::swapBytes(dataOut, numValues);
+}
+
 /**
  * set Copy Data
  * 
@@ -213,14 +397,79 @@ void CiftiMatrix::initMatrix()
    m_dimensions.clear();
    m_matrix = NULL;
    m_length = 0;
+   m_mappedMatrix = NULL;
+   m_mappedOffset = 0;
+   m_mappedSwapNeeded = false;
 }
 
 void CiftiMatrix::freeMatrix()
 {
-   if(m_matrix) delete m_matrix;
+   if(m_matrix) delete [] m_matrix;
+   if(m_mappedMatrix) m_mappedFile.unmap(m_mappedMatrix);
+   if(m_mappedFile.isOpen()) m_mappedFile.close();
    initMatrix();
 }
 
+/**
+ * map Matrix
+ * 
+ * memory maps the matrix from the file, read only, m_length must already be set
+ * @param fileName
+ * @param offset the position of the beginning of the CiftiMatrix within the file
+ */
+void CiftiMatrix::mapMatrix(const QString &fileName, unsigned long long offset) throw (CiftiFileException)
+{
+   m_mappedFile.setFileName(fileName);
+   if(!m_mappedFile.open(QIODevice::ReadOnly))
+   {
+      throw CiftiFileException(fileName, "Unable to open file for ON_DISK Cifti Matrix.");
+   }
+   if((unsigned long long)m_mappedFile.size() < offset + m_length * 4)
+   {
+      throw CiftiFileException(fileName, "File is too small to contain the Cifti Matrix.");
+   }
+   m_mappedMatrix = m_mappedFile.map(offset, m_length * 4);//QFile takes care of page alignment
+   if(!m_mappedMatrix)
+   {
+      throw CiftiFileException(fileName, "Error memory mapping Cifti Matrix: " + m_mappedFile.errorString());
+   }
+   m_mappedOffset = offset;
+}
+
+/**
+ * get Mapped File Name
+ * 
+ * @return name of the file the ON_DISK matrix is mapped from, empty if IN_MEMORY
+ */
+QString CiftiMatrix::getMappedFileName() const
+{
+   if(m_mappedMatrix == NULL) return "";
+   return m_mappedFile.fileName();
+}
+
+/**
+ * replace Mapped File
+ * 
+ * replaces the file the matrix is mapped from with a file holding the same matrix
+ * in native byte order, the replacement file is renamed to the mapped file's name
+ * and the matrix is mapped from it
+ * @param replacementFileName
+ * @param replacementOffset the position of the beginning of the CiftiMatrix within the replacement file
+ */
+void CiftiMatrix::replaceMappedFile(const QString &replacementFileName, unsigned long long replacementOffset) throw (CiftiFileException)
+{
+   const QString fileName = m_mappedFile.fileName();
+   std::vector <int> dimensions = m_dimensions;
+   freeMatrix();//a mapped file cannot be removed on all platforms
+   QFile::remove(fileName);
+   if(!QFile::rename(replacementFileName, fileName))
+   {
+      throw CiftiFileException(fileName, "Unable to rename " + replacementFileName + " to replace the file.");
+   }
+   setDimensions(dimensions);
+   mapMatrix(fileName, replacementOffset);
+}
+
 /**
  * readMatrix
  * 
@@ -228,7 +477,7 @@ void CiftiMatrix::freeMatrix()
  * @param fileName
  * @param dimensions
  */
-void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensions)
+void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensions) throw (CiftiFileException)
 {
    readMatrix(fileName, dimensions, 0);   
 }
@@ -241,21 +490,21 @@ void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensio
  * @param dimensions
  * @param offset
  */
-void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long offset)
+void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long offset) throw (CiftiFileException)
 {
-   QFile ciftiFile;
-   ciftiFile.setFileName(fileName);   
    if(m_clevel == IN_MEMORY)
    {
+      QFile ciftiFile;
+      ciftiFile.setFileName(fileName);   
       ciftiFile.open(QIODevice::ReadOnly);
       if(offset) ciftiFile.seek(offset);
       readMatrix(ciftiFile,dimensions);
    }
    else if(m_clevel == ON_DISK)
    {
-      CiftiFileException("ON_DISK file IO mode not yet implemented.");
-      ciftiFile.open(QIODevice::ReadOnly);
-      if(offset) ciftiFile.seek(offset);
+      freeMatrix();
+      setDimensions(dimensions);
+      mapMatrix(fileName, offset);
    }
 }
 
@@ -266,7 +515,7 @@ void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensio
  * @param file
  * @param dimensions
  */
-void CiftiMatrix::readMatrix(QFile &file, std::vector<int> &dimensions)
+void CiftiMatrix::readMatrix(QFile &file, std::vector<int> &dimensions) throw (CiftiFileException)
 {
    freeMatrix();
    setDimensions(dimensions);
@@ -290,7 +539,7 @@ void CiftiMatrix::readMatrix(QFile &file, std::vector<int> &dimensions)
    }
    else if(m_clevel == ON_DISK)
    {
-      CiftiFileException("ON_DISK file IO mode not yet implemented.");
+      mapMatrix(file.fileName(), file.pos());
    }   
 }
 
@@ -300,7 +549,26 @@ void CiftiMatrix::readMatrix(QFile &file, std::vector<int> &dimensions)
  * write Matrix to specified file handle
  * @param file handle to file for writing matrix data
  */
-void CiftiMatrix::writeMatrix(QFile &file)
+void CiftiMatrix::writeMatrix(QFile &file) throw (CiftiFileException)
 {   
+   if(m_clevel == ON_DISK)
+   {//write in blocks of rows so that we never hold the whole matrix
+      long long rows = getNumberOfRows();
+      long long cols = getNumberOfColumns();
+      long long blockRows = 1;
+      if(cols > 0 && cols < 4194304) blockRows = 4194304 / cols;//roughly 16MB per block
+      std::vector<float> block(blockRows * cols);
+      for(long long i = 0;i<rows;i+=blockRows)
+      {
+         long long numRows = blockRows;
+         if(i + numRows > rows) numRows = rows - i;
+         getRowRange(&(block[0]), i, numRows);
+         if(file.write((char *)&(block[0]),numRows*cols*4) != numRows*cols*4)
+         {
+            throw CiftiFileException(file.fileName(), "Error writing Cifti Matrix.");
+         }
+      }
+      return;
+   }
    file.write((char *)m_matrix,m_length*4);
 }
@@ -35,19 +35,31 @@ enum  CACHE_LEVEL {
 };
 /// Class for reading and writing Cifti Matrix Data
 //warning!!! when using ON_DISK cache level, don't plan on using the file handle again, consider it gone, once handing it to a CiftiMatrix object.
+//ON_DISK matrices are memory mapped read only, use getRow/getRowRange/getColumn to access them, getMatrixData will
+//have to copy the entire matrix into memory
 class CiftiMatrix
 { 
 public:
    CiftiMatrix(QFile &file, std::vector<int> &dimensions,CACHE_LEVEL clevel=IN_MEMORY) throw (CiftiFileException);
    CiftiMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long int offset, CACHE_LEVEL clevel=IN_MEMORY) throw (CiftiFileException);
    CiftiMatrix(const QString &fileName, std::vector<int> &dimensions, CACHE_LEVEL clevel=IN_MEMORY) throw (CiftiFileException);
+   CiftiMatrix(const CiftiMatrix &matrix) throw (CiftiFileException);
    CiftiMatrix() throw (CiftiFileException);
    ~CiftiMatrix();
+   CiftiMatrix &operator=(const CiftiMatrix &matrix) throw (CiftiFileException);
    void swapByteOrder();
-   void readMatrix(QFile &file, std::vector<int> &dimensions);
-   void readMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long offset);
-   void readMatrix(const QString &fileName, std::vector<int> &dimensions);
-   void writeMatrix(QFile &file);
+   void readMatrix(QFile &file, std::vector<int> &dimensions) throw (CiftiFileException);
+   void readMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long offset) throw (CiftiFileException);
+   void readMatrix(const QString &fileName, std::vector<int> &dimensions) throw (CiftiFileException);
+   void writeMatrix(QFile &file) throw (CiftiFileException);
+   void getRow(float *rowOut, long long row) const throw (CiftiFileException);//rowOut must hold getNumberOfColumns() floats
+   void getRowRange(float *rowsOut, long long firstRow, long long numRows) const throw (CiftiFileException);//rows are contiguous in rowsOut
+   void getColumn(float *columnOut, long long column) const throw (CiftiFileException);//columnOut must hold getNumberOfRows() floats
+   long long getNumberOfRows() const;
+   long long getNumberOfColumns() const;
+   CACHE_LEVEL getCacheLevel() const;
+   QString getMappedFileName() const;//empty unless the matrix is ON_DISK
+   void replaceMappedFile(const QString &replacementFileName, unsigned long long replacementOffset) throw (CiftiFileException);
    void getMatrixData(float *&data, std::vector <int> &dimensions);//gets the entire matrix, depending on the copy data preferences,
                            //either copies all of the data
    void setMatrixData(float *data, std::vector <int> &dimensions);   
@@ -58,12 +70,20 @@ protected:
    void freeMatrix();
    void initMatrix();
    void init();
+   void copyHelper(const CiftiMatrix &matrix) throw (CiftiFileException);
+   void mapMatrix(const QString &fileName, unsigned long long offset) throw (CiftiFileException);
+   void readMappedValues(float *dataOut, long long firstValue, long long numValues) const;
    void setDimensions(std::vector <int> dimensions);
    float * m_matrix;
    unsigned long long m_length;
    std::vector <int> m_dimensions;
    CACHE_LEVEL m_clevel;
    bool m_copyData;
+   //ON_DISK state, m_mappedMatrix points into m_mappedFile's mapping, the mapped bytes are never modified
+   QFile m_mappedFile;
+   uchar * m_mappedMatrix;
+   unsigned long long m_mappedOffset;
+   bool m_mappedSwapNeeded;//values are swapped as they are copied out of the mapping, so only touched pages are ever swapped
 };
 
 #endif //__CIFTI_MATRIX
@@ -107,6 +107,8 @@
 #include "CommandMetricStatisticsTMap.h"
 #include "CommandMetricStatisticsTwoSampleTTest.h"
 #include "CommandMetricStatisticsZMap.h"
+#include "CommandMetricTFCE.h"
+#include "CommandMetricTFCEUnitTesting.h"
 #include "CommandMetricTranspose.h"
 #include "CommandMetricTwinComparison.h"
 #include "CommandMetricTwinPairedDataDiffs.h"
@@ -135,6 +137,7 @@
 #include "CommandSpecFileCopy.h"
 #include "CommandSpecFileCreate.h"
 #include "CommandSpecFileDirectoryClean.h"
+#include "CommandSpecFileReorderNodes.h"
 #include "CommandSpecFileZip.h"
 #include "CommandStatisticSetRandomSeed.h"
 #include "CommandStatisticalUnitTesting.h"
@@ -229,6 +232,7 @@
 #include "CommandVolumeBiasCorrection.h"
 #include "CommandVolumeBlur.h"
 #include "CommandVolumeClassifyIntensities.h"
+#include "CommandVolumeConnectedComponentsUnitTesting.h"
 #include "CommandVolumeConvertVectorToVolume.h"
 #include "CommandVolumeCreate.h"
 #include "CommandVolumeCreateCorpusCallosumSlice.h"
@@ -245,6 +249,7 @@
 #include "CommandVolumeFillSlice.h"
 #include "CommandVolumeFindLimits.h"
 #include "CommandVolumeFloodFill.h"
+#include "CommandVolumeGaussianBlur.h"
 #include "CommandVolumeGradient.h"
 #include "CommandVolumeSegmentationToCerebralHull.h"
 #include "CommandVolumeHistogram.h"
@@ -259,6 +264,7 @@
 #include "CommandVolumeMapToSurfacePALS.h"
 #include "CommandVolumeMapToSurfaceROIFile.h"
 #include "CommandVolumeMapToVtkModel.h"
+#include "CommandVolumeMarchingCubesUnitTesting.h"
 #include "CommandVolumeMaskVolume.h"
 #include "CommandVolumeMaskWithVolume.h"
 #include "CommandVolumeNearToPlane.h"
@@ -391,6 +397,8 @@ CommandBase::getAllCommandsUnsorted(std::vector<CommandBase*>& commandsOut)
    commandsOut.push_back(new CommandMetricStatisticsTMap);
    commandsOut.push_back(new CommandMetricStatisticsTwoSampleTTest);
    commandsOut.push_back(new CommandMetricStatisticsZMap);
+   commandsOut.push_back(new CommandMetricTFCE);
+   commandsOut.push_back(new CommandMetricTFCEUnitTesting);
    commandsOut.push_back(new CommandMetricTranspose);
    commandsOut.push_back(new CommandMetricTwinComparison);
    commandsOut.push_back(new CommandMetricTwinPairedDataDiffs);
@@ -419,6 +427,7 @@ CommandBase::getAllCommandsUnsorted(std::vector<CommandBase*>& commandsOut)
    commandsOut.push_back(new CommandSpecFileCopy);
    commandsOut.push_back(new CommandSpecFileCreate);
    commandsOut.push_back(new CommandSpecFileDirectoryClean);
+   commandsOut.push_back(new CommandSpecFileReorderNodes);
    commandsOut.push_back(new CommandSpecFileZip);
    commandsOut.push_back(new CommandStatisticSetRandomSeed);
    commandsOut.push_back(new CommandStatisticalUnitTesting);
@@ -513,6 +522,7 @@ CommandBase::getAllCommandsUnsorted(std::vector<CommandBase*>& commandsOut)
    commandsOut.push_back(new CommandVolumeBiasCorrection);
    commandsOut.push_back(new CommandVolumeBlur);
    commandsOut.push_back(new CommandVolumeClassifyIntensities);
+   commandsOut.push_back(new CommandVolumeConnectedComponentsUnitTesting);
    commandsOut.push_back(new CommandVolumeConvertVectorToVolume);
    commandsOut.push_back(new CommandVolumeCreate);
    commandsOut.push_back(new CommandVolumeCreateCorpusCallosumSlice);
@@ -529,6 +539,7 @@ CommandBase::getAllCommandsUnsorted(std::vector<CommandBase*>& commandsOut)
    commandsOut.push_back(new CommandVolumeFillSlice);
    commandsOut.push_back(new CommandVolumeFindLimits);
    commandsOut.push_back(new CommandVolumeFloodFill);
+   commandsOut.push_back(new CommandVolumeGaussianBlur);
    commandsOut.push_back(new CommandVolumeGradient);
    commandsOut.push_back(new CommandVolumeHistogram);
    commandsOut.push_back(new CommandVolumeSegmentationToCerebralHull);
@@ -539,6 +550,7 @@ CommandBase::getAllCommandsUnsorted(std::vector<CommandBase*>& commandsOut)
    commandsOut.push_back(new CommandVolumeMapToSurfacePALS);
    commandsOut.push_back(new CommandVolumeMapToSurfaceROIFile);
    commandsOut.push_back(new CommandVolumeMapToVtkModel);
+   commandsOut.push_back(new CommandVolumeMarchingCubesUnitTesting);
    commandsOut.push_back(new CommandVolumeMakePlane);
    commandsOut.push_back(new CommandVolumeMakeRectangle);
    commandsOut.push_back(new CommandVolumeMakeShell);
@@ -76,6 +76,7 @@ CommandCiftiCorrelationMatrix::getHelpInformation() const
        + indent9 + "[-output-gifti-external-binary filename]\n"//specified in .gii, .dat is created automatically
        + indent9 + "[-apply-fisher-z-transform]\n"
        + indent9 + "[-parallel]\n"
+       + indent9 + "[-row-block-size  number-of-rows]\n"
        + indent9 + "\n"
        + indent9 + "Compute a correlation matrix using the input cifti file.\n"
        + indent9 + "Each row (node) in the cifti file is correlated with all\n"
@@ -106,6 +107,13 @@ CommandCiftiCorrelationMatrix::getHelpInformation() const
        + indent9 + "If the \"-parallel\" option is specified, the algorithm\n"
        + indent9 + "will run its operations with multiple threads to reduce\n"
        + indent9 + "execution time.\n"
+       + indent9 + "\n"
+       + indent9 + "If the \"-row-block-size\" option is specified, the output\n"
+       + indent9 + "is computed that many rows at a time (1024 is a good choice)\n"
+       + indent9 + "and each block of rows is written to the output file as\n"
+       + indent9 + "soon as it is computed, so the entire output matrix is\n"
+       + indent9 + "never held in memory.  The input file is memory mapped.\n"
+       + indent9 + "This option may not be used with \"-output-gifti-external-binary\".\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -130,6 +138,7 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
       parameters->getNextParameterAsString("Output Cifti File Name");
    bool applyFisherZTransformFlag = false;
    bool parallelFlag = false;
+   long rowBlockSize = 0;
    QString outputGiftiFileName;
       
    //
@@ -147,6 +156,12 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
       else if (paramName == "-parallel") {
          parallelFlag = true;
       }
+      else if (paramName == "-row-block-size") {
+         rowBlockSize = parameters->getNextParameterAsInt("Row Block Size");
+         if (rowBlockSize <= 0) {
+            throw CommandException("Row block size must be greater than zero.");
+         }
+      }
       else if (paramName == "-output-gifti-external-binary") {
          outputGiftiFileName = parameters->getNextParameterAsString("Output Gifti File Name");
       }
@@ -154,6 +169,10 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
          throw CommandException("Unrecognized parameter: " + paramName);
       }
    }      
+   if ((rowBlockSize > 0) && (outputGiftiFileName.isEmpty() == false)) {
+      throw CommandException("-row-block-size and -output-gifti-external-binary "
+                             "may not be used together.");
+   }
 
    //
    // Read the cifti file
@@ -162,7 +181,12 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
  
    QTime readTimer;
    readTimer.start();
-   cf.openFile(inputCiftiFileName);
+   if (rowBlockSize > 0) {
+      cf.openFile(inputCiftiFileName, ON_DISK);
+   }
+   else {
+      cf.openFile(inputCiftiFileName);
+   }
    if(DebugControl::getDebugOn()) 
       std::cout << "Time to read file "
                 << (readTimer.elapsed() * 0.001)
@@ -175,6 +199,26 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
    BrainModelCiftiCorrelationMatrix* alg = NULL;
 
    BrainSet brainSet;
+   if (rowBlockSize > 0) {
+      //
+      // Output is written as it is computed
+      //
+      alg = new BrainModelCiftiCorrelationMatrix(&brainSet,
+                                                   &cf,
+                                                   outputCiftiFileName,
+                                                   rowBlockSize,
+                                                   applyFisherZTransformFlag,
+                                                   parallelFlag);
+      alg->execute();
+      delete alg;
+      if(DebugControl::getDebugOn()) 
+         std::cout << "Time to run algorithm and write file "
+                   << (algTimer.elapsed() * 0.001)
+                   << " seconds."
+                   << std::endl;
+      return;
+   }
+   
    alg = new BrainModelCiftiCorrelationMatrix(&brainSet,
                                                 &cf,
                                                 applyFisherZTransformFlag,
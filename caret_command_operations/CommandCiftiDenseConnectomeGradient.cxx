@@ -170,7 +170,12 @@ CommandCiftiDenseConnectomeGradient::executeCommand() throw (BrainModelAlgorithm
  
    QTime readTimer;
    readTimer.start();
-   cf.openFile(inputCiftiFileName);
+   if (overrideMode)
+   {
+      cf.openFile(inputCiftiFileName);
+   } else {
+      cf.openFile(inputCiftiFileName, ON_DISK);//only reads rows as it needs them
+   }
    BrainSet leftSet(leftTopoName, leftCoordName);
    BrainSet rightSet(rightTopoName, rightCoordName);
    if(DebugControl::getDebugOn()) 
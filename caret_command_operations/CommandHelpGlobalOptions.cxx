@@ -29,6 +29,7 @@
 #include <QDir>
 
 #include "AbstractFile.h"
+#include "BrainModelAlgorithmThreadPool.h"
 #include "BrainSet.h"
 #include "CommandHelpGlobalOptions.h"
 #include "FileFilters.h"
@@ -104,6 +105,13 @@ CommandHelpGlobalOptions::getHelpInformation() const
        + indent9 + "the command will result in the random number generator's \n"
        + indent9 + "seed value being set to the provided value. \n"
        + indent9 + "\n"
+       + indent9 + "Adding the parameter \"-THREADS <number-of-threads>\" to \n"
+       + indent9 + "the command sets the number of threads in the pool that\n"
+       + indent9 + "runs algorithms in parallel, overriding the preferences \n"
+       + indent9 + "file.  If neither sets it, there is one thread per \n"
+       + indent9 + "processor.  An algorithm asked to use more threads than\n"
+       + indent9 + "the pool has adds threads to the pool.\n"
+       + indent9 + "\n"
        + indent9 + "Adding the parameter \"-WRITE-FILE-FORMAT  <format-type(s)>\"\n"
        + indent9 + "to the command will set the format(s) for writing data\n"
        + indent9 + "files.  \"format-types\" are any of the file format types\n"
@@ -147,6 +155,7 @@ CommandHelpGlobalOptions::processGlobalOptions(ProgramParameters& params) throw
    processChangeDirectoryCommand(params);
    processSetPermissionsCommand(params);
    processSetRandomSeedCommand(params);
+   processNumberOfThreadsCommand(params);
    processFileWritingFormat(params);
    processMetricFileWritingFormat(params);
 }
@@ -304,6 +313,43 @@ CommandHelpGlobalOptions::processSetRandomSeedCommand(ProgramParameters& params)
    }
 }
 
+/**
+ * process the number of threads command.
+ */
+void 
+CommandHelpGlobalOptions::processNumberOfThreadsCommand(ProgramParameters& params) throw (CommandException)
+{
+   //
+   // See if number of threads should be set
+   //
+   const int threadsIndex = params.getIndexOfParameterWithValue("-THREADS");
+   if (threadsIndex >= 0) {
+      const int numberIndex = threadsIndex + 1;
+      if (numberIndex < params.getNumberOfParameters()) {
+         const QString numberString = params.getParameterAtIndex(numberIndex);
+         bool ok = false;
+         const int numberOfThreads = numberString.toInt(&ok);
+         if ((ok == false) || (numberOfThreads < 1)) {
+            throw CommandException("Invalid number of threads ("
+                                   + numberString
+                                   + ")");
+         }
+         
+         BrainModelAlgorithmThreadPool::setNumberOfThreads(numberOfThreads);
+         
+         //
+         // Remove the "-THREADS" and number parameters
+         // Remember, remove largest index first since array shrinks
+         //
+         params.removeParameterAtIndex(numberIndex);
+         params.removeParameterAtIndex(threadsIndex);
+      }
+      else {
+         throw CommandException("ERROR: Value missing for \"-THREADS\" option.");
+      }
+   }
+}
+
 /**
  * process the file writing format preference.
  */
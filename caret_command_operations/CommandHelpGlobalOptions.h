@@ -60,6 +60,9 @@ class CommandHelpGlobalOptions : public CommandBase {
       // process the set random seed
       static void processSetRandomSeedCommand(ProgramParameters& params) throw (CommandException);
       
+      // process the number of threads
+      static void processNumberOfThreadsCommand(ProgramParameters& params) throw (CommandException);
+      
       // process the file writing format preference
       static void processFileWritingFormat(ProgramParameters& params) throw (CommandException);
       
@@ -23,6 +23,7 @@
  */
 /*LICENSE_END*/
 
+#include "BrainModelSurfaceGeodesicGaussianOperator.h"
 #include "BrainModelSurfaceMetricSmoothing.h"
 #include "BrainModelSurfaceMetricSmoothingAll.h"
 #include "BrainSet.h"
@@ -94,6 +95,8 @@ CommandMetricSmoothing::getHelpInformation() const
        + indent9 + " \n"
        + indent9 + "[-geo-gauss sigma] \n"
        + indent9 + " \n"
+       + indent9 + "[-geo-gauss-cache-dir  directory-name] \n"
+       + indent9 + " \n"
        + indent9 + "[-fwhm  desired-full-width-half-maximum] \n"
        + indent9 + " \n"
        + indent9 + "[-gauss   spherical-coordinate-file-name\n"
@@ -120,6 +123,15 @@ CommandMetricSmoothing::getHelpInformation() const
        + indent9 + "      iterations.  The intent is to do one iteration of\n"
        + indent9 + "      smoothing, with the sigma specifying how much smoother\n"
        + indent9 + "      the metric is desired to be.\n"
+       + indent9 + "\n"
+       + indent9 + "   Geodesic Gaussian weights are computed once for each\n"
+       + indent9 + "      surface and sigma and saved in a cache directory so\n"
+       + indent9 + "      that later smoothing with the same surface and sigma\n"
+       + indent9 + "      does not need to compute geodesic distances.  The\n"
+       + indent9 + "      default cache directory is \"caret_geodesic_gaussian_cache\"\n"
+       + indent9 + "      in the system's temporary directory.  Use\n"
+       + indent9 + "      \"-geo-gauss-cache-dir\" to change the cache directory,\n"
+       + indent9 + "      an empty directory name (\"\") disables the cache.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -183,6 +195,10 @@ CommandMetricSmoothing::executeCommand() throw (BrainModelAlgorithmException,
          geoGaussSigma = 
             parameters->getNextParameterAsFloat("Geodesic Gaussian Sigma");
       }
+      else if (paramValue == "-geo-gauss-cache-dir") {
+         BrainModelSurfaceGeodesicGaussianOperator::setCacheDirectory(
+            parameters->getNextParameterAsString("Geodesic Gaussian Cache Directory"));
+      }
       else if (paramValue == "-parallel") {
          parallelFlag = true;
       }
@@ -85,6 +85,7 @@ CommandMetricStatisticsTwoSampleTTest::getScriptBuilderParameters(ScriptBuilderP
    paramsOut.addBoolean("Do TMap Degrees of Freedom");
    paramsOut.addBoolean("Do TMap P-Values");
    paramsOut.addInt("Number of Threads", 1);
+   paramsOut.addInt("Number of Shuffled T-Maps to Save", 10, 0);
 }
 
 /**
@@ -114,6 +115,7 @@ CommandMetricStatisticsTwoSampleTTest::getHelpInformation() const
        + indent9 + "        <b-do-tmap-DOF>   \n"
        + indent9 + "        <b-do-tmap-pvalue>  \n"
        + indent9 + "        <number-of-threads>  \n"
+       + indent9 + "        [number-of-shuffled-t-maps-to-save = 10]  \n"
        + indent9 + "         \n"
        + indent9 + "     Perform a two-sample T-Test or perform a Wilcoxon Rank-Sum of the  \n"
        + indent9 + "     data and then perform the T-Test. \n"
@@ -135,6 +137,12 @@ CommandMetricStatisticsTwoSampleTTest::getHelpInformation() const
        + indent9 + "     Users on systems with multiple processors or multi-core systems \n"
        + indent9 + "     should set the number of threads to the number of processors \n"
        + indent9 + "     and/or cores to reduce execution time. \n"
+       + indent9 + "      \n"
+       + indent9 + "     With POOLED or UNPOOLED variance, each shuffled T-Map is reduced \n"
+       + indent9 + "     to its largest cluster as it is computed.  Only the first \n"
+       + indent9 + "     \"number-of-shuffled-t-maps-to-save\" shuffled T-Maps are written \n"
+       + indent9 + "     to the shuffled T-Map file.  The cluster significance uses all \n"
+       + indent9 + "     of the iterations. \n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -186,6 +194,14 @@ CommandMetricStatisticsTwoSampleTTest::executeCommand() throw (BrainModelAlgorit
       parameters->getNextParameterAsBoolean("Do T-MAP P-Value");
    const int numberOfThreads = 
       parameters->getNextParameterAsInt("Number of Threads");
+   int numberOfShuffledTMapsToSave = 10;
+   if (parameters->getParametersAvailable()) {
+      numberOfShuffledTMapsToSave =
+         parameters->getNextParameterAsInt("Number of Shuffled T-Maps to Save (optional)");
+      if (numberOfShuffledTMapsToSave < 0) {
+         throw CommandException("Number of shuffled T-Maps to save must be >= 0.");
+      }
+   }
    checkForExcessiveParameters();
 
    BrainModelSurfaceMetricTwoSampleTTest::DATA_TRANSFORM_MODE dataTransformMode;
@@ -255,6 +271,7 @@ CommandMetricStatisticsTwoSampleTTest::executeCommand() throw (BrainModelAlgorit
                 doTMapDOF,
                 doTMapPValue,
                 numberOfThreads);
+   twoSample.setNumberOfShuffledTMapsToSave(numberOfShuffledTMapsToSave);
 
    twoSample.execute();
 }
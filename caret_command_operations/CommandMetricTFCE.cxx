@@ -0,0 +1,176 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include "BrainModelSurface.h"
+#include "BrainModelSurfaceMetricTFCE.h"
+#include "BrainSet.h"
+#include "CommandMetricTFCE.h"
+#include "FileFilters.h"
+#include "MetricFile.h"
+#include "ProgramParameters.h"
+#include "ScriptBuilderParameters.h"
+#include "StringUtilities.h"
+
+/**
+ * constructor.
+ */
+CommandMetricTFCE::CommandMetricTFCE()
+   : CommandBase("-metric-TFCE",
+                 "METRIC THRESHHOLD FREE CLUSTER ENHANCEMENT")
+{
+}
+
+/**
+ * destructor.
+ */
+CommandMetricTFCE::~CommandMetricTFCE()
+{
+}
+
+/**
+ * get the script builder parameters.
+ */
+void 
+CommandMetricTFCE::getScriptBuilderParameters(ScriptBuilderParameters& paramsOut) const
+{
+   paramsOut.clear();
+   paramsOut.addFile("Input Coordinate File", FileFilters::getCoordinateGenericFileFilter());
+   paramsOut.addFile("Input Topology File", FileFilters::getTopologyGenericFileFilter());
+   paramsOut.addFile("Input Metric File", FileFilters::getMetricFileFilter());
+   paramsOut.addFile("Output Metric File", FileFilters::getMetricFileFilter());
+   paramsOut.addInt("Number of steps to approximate integral", BrainModelSurfaceMetricTFCE::defaultNumSteps(), 1);
+   paramsOut.addFloat("E (power to raise cluster area to)", BrainModelSurfaceMetricTFCE::defaultE());
+   paramsOut.addFloat("H (power to raise threshhold to)", BrainModelSurfaceMetricTFCE::defaultH());
+}
+
+/**
+ * get full help information.
+ */
+QString 
+CommandMetricTFCE::getHelpInformation() const
+{
+   QString helpInfo =
+      (indent3 + getShortDescription() + "\n"
+       + indent6 + parameters->getProgramNameWithoutPath() + " " + getOperationSwitch() + "  \n"
+       + indent9 + "<input-coordinate-file-name>\n"
+       + indent9 + "<input-topology-file-name>\n"
+       + indent9 + "<input-metric-file-name>\n"
+       + indent9 + "<output-metric-file-name>\n"
+       + indent9 + "[number-of-steps = " + StringUtilities::fromNumber(BrainModelSurfaceMetricTFCE::defaultNumSteps()) + "]\n"
+       + indent9 + "[E = " + StringUtilities::fromNumber(BrainModelSurfaceMetricTFCE::defaultE()) + "]\n"
+       + indent9 + "[H = " + StringUtilities::fromNumber(BrainModelSurfaceMetricTFCE::defaultH()) + "]\n"
+       + indent9 + "\n"
+       + indent9 + "Enhance clusterlike signal on a surface using Threshhold Free\n"
+       + indent9 + "Cluster Enhancement.  Nodes are connected through the topology\n"
+       + indent9 + "and the extent of a cluster is the surface area of its nodes.\n"
+       + indent9 + "\n"
+       + indent9 + "All columns in the input metric file are enhanced, in parallel when\n"
+       + indent9 + "multiple processors are available.\n"
+       + indent9 + "\n"
+       + indent9 + "   Optional parameters: (default value specified above)\n"
+       + indent9 + "      number-of-steps  number of pieces used to approximate the integral\n"
+       + indent9 + "                        using the value at the center of a piece as the\n"
+       + indent9 + "                        height of the piece.\n"
+       + indent9 + "\n"
+       + indent9 + "      E  the power to raise the cluster area to in the integral.\n"
+       + indent9 + "\n"
+       + indent9 + "      H  the power to raise the threshhold to in the integral.\n"
+       + indent9 + "\n");
+      
+   return helpInfo;
+}
+
+/**
+ * execute the command.
+ */
+void 
+CommandMetricTFCE::executeCommand() throw (BrainModelAlgorithmException,
+                                     CommandException,
+                                     FileException,
+                                     ProgramParametersException,
+                                     StatisticException)
+{
+   const QString coordinateFileName =
+      parameters->getNextParameterAsString("Input Coordinate File Name");
+   const QString topologyFileName =
+      parameters->getNextParameterAsString("Input Topology File Name");
+   const QString inputMetricFileName =
+      parameters->getNextParameterAsString("Input Metric File Name");
+   const QString outputMetricFileName =
+      parameters->getNextParameterAsString("Output Metric File Name");
+   int numSteps = BrainModelSurfaceMetricTFCE::defaultNumSteps();
+   float E = BrainModelSurfaceMetricTFCE::defaultE(),
+         H = BrainModelSurfaceMetricTFCE::defaultH();
+   if (parameters->getParametersAvailable())
+   {
+      numSteps =
+         parameters->getNextParameterAsInt("Number Of Steps (optional)");
+   }
+   if (parameters->getParametersAvailable())
+   {
+      E =
+         parameters->getNextParameterAsFloat("E (optional)");
+   }
+   if (parameters->getParametersAvailable())
+   {
+      H =
+         parameters->getNextParameterAsFloat("H (optional)");
+   }
+   checkForExcessiveParameters();
+   
+   //
+   // Read the surface
+   //
+   BrainSet brainSet(topologyFileName, coordinateFileName);
+   BrainModelSurface* surface = brainSet.getBrainModelSurface(0);
+   if (surface == NULL) {
+      throw CommandException("Unable to find surface after reading files.");
+   }
+   
+   //
+   // Read the input metric
+   //
+   MetricFile inputMetric;
+   inputMetric.readFile(inputMetricFileName);
+   
+   //
+   // Enhance all columns
+   //
+   MetricFile outputMetric;
+   BrainModelSurfaceMetricTFCE tfce(&brainSet,
+                                    surface,
+                                    &inputMetric,
+                                    &outputMetric,
+                                    numSteps,
+                                    E,
+                                    H);
+   tfce.execute();
+   
+   //
+   // Write the file
+   //
+   outputMetric.writeFile(outputMetricFileName);
+}
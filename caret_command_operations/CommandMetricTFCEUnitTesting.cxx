@@ -0,0 +1,203 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "BrainModelSurfaceMetricTFCE.h"
+#include "BrainModelVolumeTFCE.h"
+#include "CommandMetricTFCEUnitTesting.h"
+#include "ProgramParameters.h"
+#include "ScriptBuilderParameters.h"
+#include "StatisticRandomNumberStream.h"
+#include "TopologyFile.h"
+#include "TopologyHelper.h"
+
+/**
+ * constructor.
+ */
+CommandMetricTFCEUnitTesting::CommandMetricTFCEUnitTesting()
+   : CommandBase("-metric-TFCE-unit-test",
+                 "METRIC TFCE UNIT TESTING")
+{
+}
+
+/**
+ * destructor.
+ */
+CommandMetricTFCEUnitTesting::~CommandMetricTFCEUnitTesting()
+{
+}
+
+/**
+ * get the script builder parameters.
+ */
+void 
+CommandMetricTFCEUnitTesting::getScriptBuilderParameters(ScriptBuilderParameters& paramsOut) const
+{
+   paramsOut.clear();
+   paramsOut.addBoolean("Show Values", false);
+}
+
+/**
+ * get full help information.
+ */
+QString 
+CommandMetricTFCEUnitTesting::getHelpInformation() const
+{
+   QString helpInfo =
+      (indent3 + getShortDescription() + "\n"
+       + indent6 + parameters->getProgramNameWithoutPath() + " " + getOperationSwitch() + "  \n"
+       + indent9 + "<show-values-flag>\n"
+       + indent9 + "\n"
+       + indent9 + "Compare surface TFCE with volume TFCE on equivalent input.  A\n"
+       + indent9 + "grid of nodes is triangulated so that each node neighbors the\n"
+       + indent9 + "same nodes as the voxel at its position in a single slice volume.\n"
+       + indent9 + "Random grids are enhanced as a metric and as a volume and the\n"
+       + indent9 + "results must match.\n"
+       + indent9 + "\n"
+       + indent9 + "\"show-values-flag\" is either \"true\"or \"false\".  If true,\n"
+       + indent9 + "the result of each case is displayed, else only errors are\n"
+       + indent9 + "displayed.\n"
+       + indent9 + "\n");
+      
+   return helpInfo;
+}
+
+/**
+ * execute the command.
+ */
+void 
+CommandMetricTFCEUnitTesting::executeCommand() throw (BrainModelAlgorithmException,
+                                     CommandException,
+                                     FileException,
+                                     ProgramParametersException,
+                                     StatisticException)
+{
+   const bool showValuesFlag =
+      parameters->getNextParameterAsBoolean("Show Values Flag");
+   checkForExcessiveParameters();
+   
+   const float E = BrainModelSurfaceMetricTFCE::defaultE();
+   const float H = BrainModelSurfaceMetricTFCE::defaultH();
+   const float nodeArea = 2.0f;
+   const float areaScale = std::pow(nodeArea, E);
+   
+   const int numCases = 200;
+   int numFailedCases = 0;
+   for (int caseNum = 0; caseNum < numCases; caseNum++) {
+      StatisticRandomNumberStream randomStream(1001, caseNum);
+      const int dimX = randomStream.randomInteger(2, 32);
+      const int dimY = randomStream.randomInteger(2, 32);
+      const int numSteps = randomStream.randomInteger(1, 60);
+      const int numNodes = dimX * dimY;
+      
+      //
+      // Node values (some cases use few distinct values so there are ties)
+      //
+      std::vector<float> values(numNodes);
+      for (int i = 0; i < numNodes; i++) {
+         if ((caseNum % 3) == 0) {
+            values[i] = randomStream.randomInteger(-1, 3);
+         }
+         else {
+            values[i] = randomStream.randomFloat(-1.0f, 3.0f);
+         }
+      }
+      
+      //
+      // Split each grid square into the four triangles formed by both
+      // of its diagonals so that a node's neighbors are the eight nodes
+      // around it, the same as a voxel's 26 neighbors in a single slice
+      //
+      std::vector<int> tiles;
+      for (int j = 0; j < (dimY - 1); j++) {
+         for (int i = 0; i < (dimX - 1); i++) {
+            const int a = i + j * dimX;
+            const int b = a + 1;
+            const int c = a + 1 + dimX;
+            const int d = a + dimX;
+            const int squareTiles[12] = { a, b, c,   a, c, d,   a, b, d,   b, c, d };
+            tiles.insert(tiles.end(), squareTiles, squareTiles + 12);
+         }
+      }
+      TopologyFile tf;
+      tf.setNumberOfNodes(numNodes);
+      tf.setAllTiles(tiles);
+      const TopologyHelper th(&tf, false, true, false);
+      
+      //
+      // Enhance as a volume, as a surface with unit extent per node,
+      // and as a surface with a constant node area
+      //
+      const int dim[3] = { dimX, dimY, 1 };
+      std::vector<float> volumeTFCE(numNodes), surfaceTFCE(numNodes), areaTFCE(numNodes);
+      std::vector<float> nodeAreas(numNodes, nodeArea);
+      BrainModelVolumeTFCE::computeTFCE(&values[0], dim, numSteps, E, H, &volumeTFCE[0]);
+      BrainModelSurfaceMetricTFCE::computeTFCE(&values[0], numNodes, &th, NULL,
+                                               numSteps, E, H, &surfaceTFCE[0]);
+      BrainModelSurfaceMetricTFCE::computeTFCE(&values[0], numNodes, &th, &nodeAreas[0],
+                                               numSteps, E, H, &areaTFCE[0]);
+      
+      int numErrors = 0;
+      for (int i = 0; i < numNodes; i++) {
+         const float tolerance = 1.0e-4 * std::max(1.0f, std::fabs(volumeTFCE[i]));
+         if ((std::fabs(surfaceTFCE[i] - volumeTFCE[i]) > tolerance) ||
+             (std::fabs(areaTFCE[i] - volumeTFCE[i] * areaScale) > (tolerance * areaScale))) {
+            if (numErrors == 0) {
+               std::cout << "TFCE case " << caseNum 
+                         << " (" << dimX << "x" << dimY << ", " << numSteps << " steps)"
+                         << " node " << i 
+                         << " volume " << volumeTFCE[i]
+                         << " surface " << surfaceTFCE[i]
+                         << " area weighted " << areaTFCE[i] 
+                         << " (expected " << (volumeTFCE[i] * areaScale) << ")"
+                         << std::endl;
+            }
+            numErrors++;
+         }
+      }
+      if (numErrors > 0) {
+         numFailedCases++;
+      }
+      else if (showValuesFlag) {
+         std::cout << "TFCE case " << caseNum 
+                   << " (" << dimX << "x" << dimY << ", " << numSteps << " steps)"
+                   << " matches." << std::endl;
+      }
+   }
+   
+   if (numFailedCases > 0) {
+      throw CommandException("Metric TFCE unit testing failed for "
+                             + QString::number(numFailedCases)
+                             + " of "
+                             + QString::number(numCases)
+                             + " cases.");
+   }
+   std::cout << "All metric TFCE tests passed." << std::endl;
+}
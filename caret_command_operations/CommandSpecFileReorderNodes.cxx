@@ -0,0 +1,150 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <iostream>
+
+#include "BrainModelSurfaceReorderNodes.h"
+#include "BrainSet.h"
+#include "CommandSpecFileReorderNodes.h"
+#include "FileFilters.h"
+#include "ProgramParameters.h"
+#include "ScriptBuilderParameters.h"
+
+/**
+ * constructor.
+ */
+CommandSpecFileReorderNodes::CommandSpecFileReorderNodes()
+   : CommandBase("-spec-file-reorder-nodes",
+                 "SPEC FILE REORDER NODES")
+{
+}
+
+/**
+ * destructor.
+ */
+CommandSpecFileReorderNodes::~CommandSpecFileReorderNodes()
+{
+}
+
+/**
+ * get the script builder parameters.
+ */
+void 
+CommandSpecFileReorderNodes::getScriptBuilderParameters(ScriptBuilderParameters& paramsOut) const
+{
+   paramsOut.clear();
+   paramsOut.addFile("Input Spec File Name", FileFilters::getSpecFileFilter());
+   paramsOut.addFile("Output Spec File Name", FileFilters::getSpecFileFilter());
+   paramsOut.addString("Output File Prefix", "Reordered_");
+   paramsOut.addVariableListOfParameters("Optional Parameters");
+}
+
+/**
+ * get full help information.
+ */
+QString 
+CommandSpecFileReorderNodes::getHelpInformation() const
+{
+   QString helpInfo =
+      (indent3 + getShortDescription() + "\n"
+       + indent6 + parameters->getProgramNameWithoutPath() + " " + getOperationSwitch() + "  \n"
+       + indent9 + "<input-spec-file-name>\n"
+       + indent9 + "<output-spec-file-name>\n"
+       + indent9 + "<output-file-prefix>\n"
+       + indent9 + "[-restore-original-order]\n"
+       + indent9 + "\n"
+       + indent9 + "Renumber the nodes of the surface files in the spec file\n"
+       + indent9 + "so that nodes that are near each other on the surface are\n"
+       + indent9 + "also near each other in memory.  This makes operations\n"
+       + indent9 + "that visit a node's neighbors (smoothing, morphing,\n"
+       + indent9 + "geodesic distances) faster on large surfaces.\n"
+       + indent9 + "\n"
+       + indent9 + "Nodes are ordered along a 3D Hilbert curve passing through\n"
+       + indent9 + "the fiducial coordinate file (or the first coordinate file\n"
+       + indent9 + "if there is no fiducial coordinate file).  Topology,\n"
+       + indent9 + "coordinate, metric, shape, paint, node attribute, border\n"
+       + indent9 + "projection, and cell/foci projection files are renumbered.\n"
+       + indent9 + "Geodesic distance and deformation map files are not\n"
+       + indent9 + "renumbered and are removed from the output spec file.\n"
+       + indent9 + "Other files are not changed.\n"
+       + indent9 + "\n"
+       + indent9 + "Each renumbered file is written to the directory of the \n"
+       + indent9 + "input spec file with \"output-file-prefix\" prepended to\n"
+       + indent9 + "its name.  If the output spec file is not placed in the\n"
+       + indent9 + "directory of the input spec file, it lists its files with\n"
+       + indent9 + "absolute paths.\n"
+       + indent9 + "\n"
+       + indent9 + "The original node numbers are stored in the header of the\n"
+       + indent9 + "topology and coordinate files.  Use the\n"
+       + indent9 + "\"-restore-original-order\" option to return the nodes of\n"
+       + indent9 + "a reordered spec file to their original order.\n"
+       + indent9 + "\n");
+      
+   return helpInfo;
+}
+
+/**
+ * execute the command.
+ */
+void 
+CommandSpecFileReorderNodes::executeCommand() throw (BrainModelAlgorithmException,
+                                     CommandException,
+                                     FileException,
+                                     ProgramParametersException,
+                                     StatisticException)
+{
+   const QString inputSpecFileName =
+      parameters->getNextParameterAsString("Input Spec File Name");
+   const QString outputSpecFileName =
+      parameters->getNextParameterAsString("Output Spec File Name");
+   const QString outputFilePrefix =
+      parameters->getNextParameterAsString("Output File Prefix");
+   
+   bool restoreOriginalOrderFlag = false;
+   while (parameters->getParametersAvailable()) {
+      const QString paramName = parameters->getNextParameterAsString("Optional Parameter");
+      if (paramName == "-restore-original-order") {
+         restoreOriginalOrderFlag = true;
+      }
+      else {
+         throw CommandException("Unrecognized parameter: " + paramName);
+      }
+   }
+   
+   BrainSet brainSet;
+   BrainModelSurfaceReorderNodes reorderNodes(&brainSet,
+                                              inputSpecFileName,
+                                              outputSpecFileName,
+                                              outputFilePrefix,
+                                              restoreOriginalOrderFlag);
+   reorderNodes.execute();
+   
+   const QString warningMessages = reorderNodes.getWarningMessages();
+   if (warningMessages.isEmpty() == false) {
+      std::cout << "Reorder Nodes Warnings: " << warningMessages.toAscii().constData() << std::endl;
+   }
+}
+
@@ -23,6 +23,10 @@
  */
 /*LICENSE_END*/
 
+#include <iostream>
+
+#include <QTime>
+
 #include "BrainModelSurface.h"
 #include "BrainSet.h"
 #include "CellFile.h"
@@ -96,12 +100,19 @@ CommandSurfaceCellProjection::getHelpInformation() const
        + indent9 + "<input-" + s + "-file-name>\n"
        + indent9 + "<output-" + s + "-projection-file-name>\n"
        + indent9 + "[-project-onto-surface  onto-surface-above-distance]\n"
+       + indent9 + "[-batch]\n"
        + indent9 + "\n"
        + indent9 + "Project the " + s + " to the surface and save into the " + s + "\n"
        + indent9 + "projection file.\n"
        + indent9 + "\n"
        + indent9 + "\"-project-onto-surface\" is used to project the " + s + " so that\n"
        + indent9 + "they are a specified distance above the surface.\n"
+       + indent9 + "\n"
+       + indent9 + "\"-batch\" projects the " + s + " in batches using multiple\n"
+       + indent9 + "threads and prints the time spent building the spatial index,\n"
+       + indent9 + "searching for nearest nodes, projecting to tiles, and writing\n"
+       + indent9 + "the file.  The projections are identical to those produced\n"
+       + indent9 + "without this option.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -134,6 +145,7 @@ CommandSurfaceCellProjection::executeCommand() throw (BrainModelAlgorithmExcepti
    //
    bool projectToSurfaceFlag = false;
    float surfaceAboveDistance = 0.0;
+   bool batchFlag = false;
    while (parameters->getParametersAvailable()) {
       const QString paramName =
          parameters->getNextParameterAsString(s + " Projection Parameter");
@@ -142,6 +154,9 @@ CommandSurfaceCellProjection::executeCommand() throw (BrainModelAlgorithmExcepti
          surfaceAboveDistance = 
             parameters->getNextParameterAsFloat(s + " Projection Parameter: Above surface distance");
       }
+      else if (paramName == "-batch") {
+         batchFlag = true;
+      }
       else {
          throw CommandException("unrecognized option");
       }
@@ -190,17 +205,43 @@ CommandSurfaceCellProjection::executeCommand() throw (BrainModelAlgorithmExcepti
    }
    cellProjectionFile->appendFiducialCellFile(*cellFile);
    CellFileProjector projector(bms);
-   projector.projectFile(cellProjectionFile, 
-                         0,
-                         CellFileProjector::PROJECTION_TYPE_ALL,
-                         surfaceAboveDistance,
-                         projectToSurfaceFlag,
-                         NULL);
+   if (batchFlag) {
+      projector.projectFileBatched(cellProjectionFile, 
+                                   0,
+                                   CellFileProjector::PROJECTION_TYPE_ALL,
+                                   surfaceAboveDistance,
+                                   projectToSurfaceFlag,
+                                   true);
+   }
+   else {
+      projector.projectFile(cellProjectionFile, 
+                            0,
+                            CellFileProjector::PROJECTION_TYPE_ALL,
+                            surfaceAboveDistance,
+                            projectToSurfaceFlag,
+                            NULL);
+   }
    
    //
    // Write the cell projection file
    //
+   QTime writeTimer;
+   writeTimer.start();
    cellProjectionFile->writeFile(cellProjectionFileName);
+   
+   if (batchFlag) {
+      std::cout << "Projected "
+                << cellProjectionFile->getNumberOfCellProjections()
+                << " " << s.toLower().toAscii().constData() << std::endl;
+      std::cout << "   Index build:          " << projector.getIndexBuildTime() 
+                << " seconds." << std::endl;
+      std::cout << "   Nearest node search:  " << projector.getNearestNodeSearchTime() 
+                << " seconds." << std::endl;
+      std::cout << "   Barycentric solve:    " << projector.getBarycentricSolveTime() 
+                << " seconds." << std::endl;
+      std::cout << "   Write:                " << (writeTimer.elapsed() * 0.001)
+                << " seconds." << std::endl;
+   }
 }
 
       
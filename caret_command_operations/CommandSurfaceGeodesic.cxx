@@ -36,7 +36,9 @@
 #include "MetricFile.h"
 #include "CoordinateFile.h"
 #include "TopologyFile.h"
+#include "GeodesicDistanceFile.h"
 #include "GeodesicHelper.h"
+#include "SpecFile.h"
 
 /**
  * constructor.
@@ -85,7 +87,15 @@ CommandSurfaceGeodesic::getHelpInformation() const
        + indent9 + "\n"
        + indent9 + "Generate the geodesic distance from all nodes to all other nodes\n"
        + indent9 + "unless a node number is specified in which case the distances are\n"
-       + indent9 + "output for the specified node to all nodes.\n"
+       + indent9 + "output for the specified node to all nodes.  If \"-node\" is given\n"
+       + indent9 + "more than once, the distance from each node to the nearest of the\n"
+       + indent9 + "specified nodes is output.\n"
+       + indent9 + "\n"
+       + indent9 + "If the output file name ends with \"" 
+                 + SpecFile::getGeodesicDistanceFileExtension() + "\", all to all\n"
+       + indent9 + "distances are written to a geodesic distance file as they are\n"
+       + indent9 + "computed (in parallel, a block of nodes at a time), so that the\n"
+       + indent9 + "distances between all pairs of nodes are never held in memory.\n"
        + indent9 + "Uses dijkstra's algorithm with reuse of information from previous\n"
        + indent9 + "root nodes.  If smoothed is 'true', it traces paths over adjacent\n"
        + indent9 + "triangles in order to generate distances for some 2hop neighbors.\n"
@@ -97,7 +107,8 @@ CommandSurfaceGeodesic::getHelpInformation() const
        + indent9 + "\n"
        + indent9 + "      surface-topo       the surface topo file\n"
        + indent9 + "\n"
-       + indent9 + "      output-metric      output metric file for geodesic distance\n"
+       + indent9 + "      output-metric      output metric (or geodesic distance) file for\n"
+       + indent9 + "                         geodesic distance\n"
        + indent9 + "\n"
        + indent9 + "      smoothed           output smoothed distances by using 2hop neighbors\n"
        + indent9 + "\n"
@@ -125,10 +136,12 @@ CommandSurfaceGeodesic::executeCommand() throw (BrainModelAlgorithmException,
    const bool smooth =
       parameters->getNextParameterAsBoolean("Smoothing");
    int nodeNumber = -1;
+   std::vector<int> seedNodes;
    while (parameters->getParametersAvailable()) {
       QString paramName = parameters->getNextParameterAsString("Geodesic Parameter");
       if (paramName == "-node") {
          nodeNumber = parameters->getNextParameterAsInt("Node Number");
+         seedNodes.push_back(nodeNumber);
       }
       else {
          throw CommandException("Invalid Parameter: " + paramName);
@@ -138,7 +151,27 @@ CommandSurfaceGeodesic::executeCommand() throw (BrainModelAlgorithmException,
    BrainModelSurface* mysurf = mybs.getBrainModelSurface(0);
    int numNodes = mysurf->getCoordinateFile()->getNumberOfNodes();
    GeodesicHelper gh(mysurf->getCoordinateFile(), mysurf->getTopologyFile());
-   if (nodeNumber >= 0) {
+   if (seedNodes.size() > 1) {
+      //
+      // One multi-source search gives the distance to the nearest node
+      //
+      QString columnName("Nearest of nodes");
+      for (unsigned int i = 0; i < seedNodes.size(); i++) {
+         if ((seedNodes[i] < 0) || (seedNodes[i] >= numNodes)) {
+            throw CommandException("Invalid node number: " + QString::number(seedNodes[i]));
+         }
+         columnName += (" " + QString::number(seedNodes[i]));
+      }
+      std::vector<float> distances;
+      std::vector<int> nearestNodes;
+      gh.getGeoToNearestSeed(seedNodes, distances, nearestNodes, smooth);
+      MetricFile mymetric;
+      mymetric.setNumberOfNodesAndColumns(numNodes, 1);
+      mymetric.setColumnForAllNodes(0, distances);
+      mymetric.setColumnName(0, columnName);
+      mymetric.writeFile(metricName);
+   }
+   else if (nodeNumber >= 0) {
 #ifdef _USE_STL_FOR_DATA_
       std::vector<int> allNodeIndices;
       allNodeIndices.reserve(numNodes);
@@ -167,6 +200,11 @@ CommandSurfaceGeodesic::executeCommand() throw (BrainModelAlgorithmException,
       mymetric.writeFile(metricName);
 #endif
    }
+   else if (metricName.endsWith(SpecFile::getGeodesicDistanceFileExtension())) {
+      GeodesicDistanceFile geodesicFile;
+      std::cout << "saving to " << metricName.toLocal8Bit().constData() << "..." << std::endl;
+      geodesicFile.writeAllToAllFile(metricName, gh, smooth);
+   }
    else {
       float** result = gh.getGeoAllToAll(smooth);//PASSES BACK ALLOCATED MEMORY, we must delete[] all of it
       //was more convinient to write the code to catch malloc failures into that function, does not crash if failed, merely deallocates
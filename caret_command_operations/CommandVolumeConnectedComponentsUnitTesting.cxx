@@ -0,0 +1,577 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "CommandVolumeConnectedComponentsUnitTesting.h"
+#include "ProgramParameters.h"
+#include "ScriptBuilderParameters.h"
+#include "StatisticRandomNumberStream.h"
+#include "VolumeFile.h"
+
+/**
+ * constructor.
+ */
+CommandVolumeConnectedComponentsUnitTesting::CommandVolumeConnectedComponentsUnitTesting()
+   : CommandBase("-volume-connected-components-unit-test",
+                 "VOLUME CONNECTED COMPONENTS UNIT TESTING")
+{
+}
+
+/**
+ * destructor.
+ */
+CommandVolumeConnectedComponentsUnitTesting::~CommandVolumeConnectedComponentsUnitTesting()
+{
+}
+
+/**
+ * get the script builder parameters.
+ */
+void 
+CommandVolumeConnectedComponentsUnitTesting::getScriptBuilderParameters(ScriptBuilderParameters& paramsOut) const
+{
+   paramsOut.clear();
+   paramsOut.addBoolean("Show Values", false);
+}
+
+/**
+ * get full help information.
+ */
+QString 
+CommandVolumeConnectedComponentsUnitTesting::getHelpInformation() const
+{
+   QString helpInfo =
+      (indent3 + getShortDescription() + "\n"
+       + indent6 + parameters->getProgramNameWithoutPath() + " " + getOperationSwitch() + "  \n"
+       + indent9 + "<show-values-flag>\n"
+       + indent9 + "\n"
+       + indent9 + "Compare the labeling of connected components in volumes with\n"
+       + indent9 + "a breadth first search.  Random volumes with random\n"
+       + indent9 + "dimensions, value ranges, extents, exclusion masks, 6, 18,\n"
+       + indent9 + "and 26 connectivity, and 1 to 9 threads are labeled.  The\n"
+       + indent9 + "labels, component statistics, segmentation object and cavity\n"
+       + indent9 + "counts, island removal, and cavity filling must match the\n"
+       + indent9 + "search.\n"
+       + indent9 + "\n"
+       + indent9 + "\"show-values-flag\" is either \"true\"or \"false\".  If true,\n"
+       + indent9 + "the result of each case is displayed, else only errors are\n"
+       + indent9 + "displayed.\n"
+       + indent9 + "\n");
+      
+   return helpInfo;
+}
+
+/**
+ * Label the connected components with a breadth first search from each
+ * unlabeled voxel in storage order.  Arguments and results are the same as
+ * VolumeFile::labelConnectedComponents().  Returns the number of components.
+ */
+static int
+labelComponentsWithSearch(const VolumeFile& volume,
+                          const float minValue,
+                          const float maxValue,
+                          const VolumeFile::CONNECTIVITY connectivity,
+                          const int* extent,
+                          const VolumeFile* excludeMaskVolume,
+                          std::vector<int>& labelsOut)
+{
+   int dim[3];
+   volume.getDimensions(dim);
+   const int sliceSize = dim[0] * dim[1];
+   const int numVoxels = sliceSize * dim[2];
+   labelsOut.clear();
+   labelsOut.resize(numVoxels, 0);
+   
+   int region[6] = { 0, dim[0], 0, dim[1], 0, dim[2] };
+   if (extent != NULL) {
+      for (int i = 0; i < 6; i++) {
+         region[i] = std::max(0, std::min(extent[i], dim[i / 2]));
+      }
+   }
+   
+   std::vector<bool> labelFlags(numVoxels, false);
+   for (int k = region[4]; k < region[5]; k++) {
+      for (int j = region[2]; j < region[3]; j++) {
+         for (int i = region[0]; i < region[1]; i++) {
+            const float value = volume.getVoxel(i, j, k);
+            if ((value >= minValue) && (value <= maxValue)) {
+               if ((excludeMaskVolume == NULL) ||
+                   (excludeMaskVolume->getVoxel(i, j, k) == 0.0)) {
+                  labelFlags[i + j * dim[0] + k * sliceSize] = true;
+               }
+            }
+         }
+      }
+   }
+   
+   int maxNonZeroOffsets = 1;
+   if (connectivity == VolumeFile::CONNECTIVITY_18) {
+      maxNonZeroOffsets = 2;
+   }
+   else if (connectivity == VolumeFile::CONNECTIVITY_26) {
+      maxNonZeroOffsets = 3;
+   }
+   
+   int numComponents = 0;
+   for (int indx = 0; indx < numVoxels; indx++) {
+      if ((labelFlags[indx] == false) || (labelsOut[indx] != 0)) {
+         continue;
+      }
+      numComponents++;
+      labelsOut[indx] = numComponents;
+      std::deque<int> queue;
+      queue.push_back(indx);
+      while (queue.empty() == false) {
+         const int voxel = queue.front();
+         queue.pop_front();
+         const int i = voxel % dim[0];
+         const int j = (voxel / dim[0]) % dim[1];
+         const int k = voxel / sliceSize;
+         for (int dk = -1; dk <= 1; dk++) {
+            for (int dj = -1; dj <= 1; dj++) {
+               for (int di = -1; di <= 1; di++) {
+                  const int numNonZero = ((di != 0) ? 1 : 0)
+                                       + ((dj != 0) ? 1 : 0)
+                                       + ((dk != 0) ? 1 : 0);
+                  if ((numNonZero == 0) || (numNonZero > maxNonZeroOffsets)) {
+                     continue;
+                  }
+                  const int ni = i + di;
+                  const int nj = j + dj;
+                  const int nk = k + dk;
+                  if ((ni < 0) || (ni >= dim[0]) ||
+                      (nj < 0) || (nj >= dim[1]) ||
+                      (nk < 0) || (nk >= dim[2])) {
+                     continue;
+                  }
+                  const int neighbor = ni + nj * dim[0] + nk * sliceSize;
+                  if (labelFlags[neighbor] && (labelsOut[neighbor] == 0)) {
+                     labelsOut[neighbor] = numComponents;
+                     queue.push_back(neighbor);
+                  }
+               }
+            }
+         }
+      }
+   }
+   
+   return numComponents;
+}
+
+/**
+ * Compare the components found by VolumeFile::labelConnectedComponents()
+ * with the labels from the search.  Returns an empty string if they match,
+ * else a description of the difference.
+ */
+static QString
+compareComponents(const int dim[3],
+                  const std::vector<int>& labels,
+                  const std::vector<VolumeFile::ConnectedComponent>& components,
+                  const std::vector<int>& searchLabels,
+                  const int numSearchComponents)
+{
+   const int numComponents = components.size();
+   if (numComponents != numSearchComponents) {
+      return ("found " + QString::number(numComponents) + " components, search found "
+              + QString::number(numSearchComponents));
+   }
+   if (labels != searchLabels) {
+      return "voxel labels differ";
+   }
+   
+   //
+   // Statistics of each component from the search's labels
+   //
+   std::vector<int> counts(numComponents, 0);
+   std::vector<int> extents(numComponents * 6, 0);
+   std::vector<double> sums(numComponents * 3, 0.0);
+   std::vector<int> firstVoxels(numComponents, -1);
+   const int numVoxels = searchLabels.size();
+   for (int indx = 0; indx < numVoxels; indx++) {
+      const int label = searchLabels[indx];
+      if (label == 0) {
+         continue;
+      }
+      const int m = label - 1;
+      const int ijk[3] = {
+         indx % dim[0],
+         (indx / dim[0]) % dim[1],
+         indx / (dim[0] * dim[1])
+      };
+      if (counts[m] == 0) {
+         firstVoxels[m] = indx;
+         for (int a = 0; a < 3; a++) {
+            extents[m * 6 + a * 2]     = ijk[a];
+            extents[m * 6 + a * 2 + 1] = ijk[a];
+         }
+      }
+      counts[m]++;
+      for (int a = 0; a < 3; a++) {
+         extents[m * 6 + a * 2]     = std::min(extents[m * 6 + a * 2], ijk[a]);
+         extents[m * 6 + a * 2 + 1] = std::max(extents[m * 6 + a * 2 + 1], ijk[a]);
+         sums[m * 3 + a] += ijk[a];
+      }
+   }
+   
+   for (int m = 0; m < numComponents; m++) {
+      const VolumeFile::ConnectedComponent& component = components[m];
+      const QString name = "component " + QString::number(m + 1) + " ";
+      if (component.getNumberOfVoxels() != counts[m]) {
+         return (name + "has " + QString::number(component.getNumberOfVoxels())
+                 + " voxels, expected " + QString::number(counts[m]));
+      }
+      int i, j, k;
+      component.getFirstVoxel().getIJK(i, j, k);
+      if ((i + j * dim[0] + k * dim[0] * dim[1]) != firstVoxels[m]) {
+         return (name + "has the wrong first voxel");
+      }
+      int extent[6];
+      component.getExtent(extent);
+      for (int a = 0; a < 6; a++) {
+         if (extent[a] != extents[m * 6 + a]) {
+            return (name + "has the wrong extent");
+         }
+      }
+      float centroid[3];
+      component.getCentroid(centroid);
+      for (int a = 0; a < 3; a++) {
+         if (std::fabs(centroid[a] - sums[m * 3 + a] / counts[m]) > 1.0e-4) {
+            return (name + "has the wrong centroid");
+         }
+      }
+   }
+   
+   return "";
+}
+
+/**
+ * Count the segmentation objects and cavities in an extent with the search.
+ * A cavity is a 6-connected set of unset voxels that does not reach the
+ * edges of the (clamped) extent.
+ */
+static void
+countObjectsAndCavitiesWithSearch(const VolumeFile& volume,
+                                  const int extentIn[6],
+                                  int& numberOfObjectsOut,
+                                  int& numberOfCavitiesOut)
+{
+   int dim[3];
+   volume.getDimensions(dim);
+   int extent[6];
+   for (int i = 0; i < 6; i++) {
+      extent[i] = std::max(0, std::min(extentIn[i], dim[i / 2]));
+   }
+   
+   std::vector<int> labels;
+   numberOfObjectsOut = labelComponentsWithSearch(volume, 255.0, 255.0,
+                                                  VolumeFile::CONNECTIVITY_6,
+                                                  extent, NULL, labels);
+   
+   const int numUnset = labelComponentsWithSearch(volume, 0.0, 0.0,
+                                                  VolumeFile::CONNECTIVITY_6,
+                                                  extent, NULL, labels);
+   std::vector<bool> reachesEdge(numUnset + 1, false);
+   for (int k = extent[4]; k < extent[5]; k++) {
+      for (int j = extent[2]; j < extent[3]; j++) {
+         for (int i = extent[0]; i < extent[1]; i++) {
+            if ((i == extent[0]) || (i == (extent[1] - 1)) ||
+                (j == extent[2]) || (j == (extent[3] - 1)) ||
+                (k == extent[4]) || (k == (extent[5] - 1))) {
+               reachesEdge[labels[i + j * dim[0] + k * dim[0] * dim[1]]] = true;
+            }
+         }
+      }
+   }
+   numberOfCavitiesOut = 0;
+   for (int m = 1; m <= numUnset; m++) {
+      if (reachesEdge[m] == false) {
+         numberOfCavitiesOut++;
+      }
+   }
+}
+
+/**
+ * execute the command.
+ */
+void 
+CommandVolumeConnectedComponentsUnitTesting::executeCommand() throw (BrainModelAlgorithmException,
+                                     CommandException,
+                                     FileException,
+                                     ProgramParametersException,
+                                     StatisticException)
+{
+   const bool showValuesFlag =
+      parameters->getNextParameterAsBoolean("Show Values Flag");
+   checkForExcessiveParameters();
+   
+#ifdef _OPENMP
+   const int savedNumberOfThreads = omp_get_max_threads();
+#endif
+   
+   const VolumeFile::CONNECTIVITY connectivities[3] = {
+      VolumeFile::CONNECTIVITY_6,
+      VolumeFile::CONNECTIVITY_18,
+      VolumeFile::CONNECTIVITY_26
+   };
+   const int connectivityNumbers[3] = { 6, 18, 26 };
+   const float segmentationValues[3] = { 0.0, 128.0, 255.0 };
+   
+   const int numCases = 1000;
+   int numFailedCases = 0;
+   for (int caseNum = 0; caseNum < numCases; caseNum++) {
+      StatisticRandomNumberStream randomStream(2501, caseNum);
+      
+      //
+      // Volume with random dimensions whose voxels are mostly unset or
+      // set with some voxels in between
+      //
+      int dim[3];
+      for (int i = 0; i < 3; i++) {
+         dim[i] = randomStream.randomInteger(1, 16);
+      }
+      const VolumeFile::ORIENTATION orientation[3] = {
+         VolumeFile::ORIENTATION_LEFT_TO_RIGHT,
+         VolumeFile::ORIENTATION_POSTERIOR_TO_ANTERIOR,
+         VolumeFile::ORIENTATION_INFERIOR_TO_SUPERIOR
+      };
+      const float origin[3] = { 0.0, 0.0, 0.0 };
+      const float spacing[3] = { 1.0, 1.0, 1.0 };
+      VolumeFile volume;
+      volume.initialize(VolumeFile::VOXEL_DATA_TYPE_FLOAT, dim, orientation,
+                        origin, spacing, true);
+      VolumeFile maskVolume;
+      maskVolume.initialize(VolumeFile::VOXEL_DATA_TYPE_FLOAT, dim, orientation,
+                            origin, spacing, true);
+      const int density = randomStream.randomInteger(0, 100);
+      for (int k = 0; k < dim[2]; k++) {
+         for (int j = 0; j < dim[1]; j++) {
+            for (int i = 0; i < dim[0]; i++) {
+               float value = 0.0;
+               if (randomStream.randomInteger(1, 100) <= density) {
+                  value = 255.0;
+               }
+               else if (randomStream.randomInteger(1, 20) == 1) {
+                  value = 128.0;
+               }
+               volume.setVoxel(i, j, k, 0, value);
+               if (randomStream.randomInteger(1, 10) == 1) {
+                  maskVolume.setVoxel(i, j, k, 0, 1.0);
+               }
+            }
+         }
+      }
+      
+      //
+      // Extent that may extend beyond the volume
+      //
+      int extent[6];
+      for (int i = 0; i < 3; i++) {
+         extent[i * 2] = randomStream.randomInteger(-1, dim[i] - 1);
+         extent[i * 2 + 1] = extent[i * 2] + randomStream.randomInteger(1, dim[i] + 1);
+      }
+      const bool useExtentFlag = (randomStream.randomInteger(0, 1) == 1);
+      const bool useMaskFlag = (randomStream.randomInteger(0, 2) == 0);
+      const int connectivityIndex = randomStream.randomInteger(0, 2);
+      const VolumeFile::CONNECTIVITY connectivity = connectivities[connectivityIndex];
+      const float minValue = segmentationValues[randomStream.randomInteger(0, 2)];
+      const float maxValue = std::max(minValue, 
+                                      segmentationValues[randomStream.randomInteger(0, 2)]);
+      const int numThreads = randomStream.randomInteger(1, 9);
+#ifdef _OPENMP
+      omp_set_num_threads(numThreads);
+#endif
+      
+      QString errorMessage;
+      
+      //
+      // Labels and component statistics
+      //
+      std::vector<int> labels, searchLabels;
+      std::vector<VolumeFile::ConnectedComponent> components;
+      volume.labelConnectedComponents(minValue, maxValue, connectivity,
+                                      labels, components,
+                                      (useExtentFlag ? extent : NULL),
+                                      (useMaskFlag ? &maskVolume : NULL));
+      const int numSearchComponents = 
+         labelComponentsWithSearch(volume, minValue, maxValue, connectivity,
+                                   (useExtentFlag ? extent : NULL),
+                                   (useMaskFlag ? &maskVolume : NULL),
+                                   searchLabels);
+      errorMessage = compareComponents(dim, labels, components, 
+                                       searchLabels, numSearchComponents);
+      
+      //
+      // Objects and cavities in the extent
+      //
+      if (errorMessage.isEmpty()) {
+         int searchObjects = 0, searchCavities = 0;
+         countObjectsAndCavitiesWithSearch(volume, extent, searchObjects, searchCavities);
+         int numObjects = 0, numCavities = 0, numHoles = 0, eulerCount = 0;
+         volume.getEulerCountsForSegmentationSubVolume(numObjects, numCavities,
+                                                       numHoles, eulerCount, extent);
+         if ((volume.getNumberOfSegmentationObjectsSubVolume(extent) != searchObjects) ||
+             (numObjects != searchObjects)) {
+            errorMessage = "number of objects in extent is wrong, expected "
+                         + QString::number(searchObjects);
+         }
+         else if ((volume.getNumberOfSegmentationCavitiesSubVolume(extent) != searchCavities) ||
+                  (numCavities != searchCavities)) {
+            errorMessage = "number of cavities in extent is wrong, expected "
+                         + QString::number(searchCavities);
+         }
+      }
+      
+      //
+      // Island removal keeps only the first of the largest objects
+      //
+      if (errorMessage.isEmpty()) {
+         const int numObjects = labelComponentsWithSearch(volume, 255.0, 255.0,
+                                                          VolumeFile::CONNECTIVITY_6,
+                                                          NULL, NULL, searchLabels);
+         std::vector<int> counts(numObjects + 1, 0);
+         for (unsigned int i = 0; i < searchLabels.size(); i++) {
+            counts[searchLabels[i]]++;
+         }
+         int biggestLabel = 0;
+         for (int m = 1; m <= numObjects; m++) {
+            if ((biggestLabel == 0) || (counts[m] > counts[biggestLabel])) {
+               biggestLabel = m;
+            }
+         }
+         
+         VolumeFile islandVolume(volume);
+         const bool removedFlag = islandVolume.removeIslandsFromSegmentation();
+         if (removedFlag != (numObjects > 1)) {
+            errorMessage = "island removal returned the wrong status";
+         }
+         for (int k = 0; (k < dim[2]) && errorMessage.isEmpty(); k++) {
+            for (int j = 0; j < dim[1]; j++) {
+               for (int i = 0; i < dim[0]; i++) {
+                  float expectedValue = volume.getVoxel(i, j, k);
+                  if (numObjects > 1) {
+                     const int label = searchLabels[i + j * dim[0] + k * dim[0] * dim[1]];
+                     expectedValue = ((label == biggestLabel) ? 255.0 : 0.0);
+                  }
+                  if (islandVolume.getVoxel(i, j, k) != expectedValue) {
+                     errorMessage = "island removal set the wrong voxels";
+                  }
+               }
+            }
+         }
+      }
+      
+      //
+      // Filling the cavities sets every voxel of a cavity
+      //
+      if (errorMessage.isEmpty()) {
+         const int wholeVolume[6] = { 0, dim[0], 0, dim[1], 0, dim[2] };
+         VolumeFile filledVolume(volume);
+         filledVolume.fillSegmentationCavities();
+         int numObjects = 0, numCavities = 0;
+         countObjectsAndCavitiesWithSearch(filledVolume, wholeVolume, numObjects, numCavities);
+         int numFilled = 0, numExpectedFilled = 0;
+         for (int k = 0; k < dim[2]; k++) {
+            for (int j = 0; j < dim[1]; j++) {
+               for (int i = 0; i < dim[0]; i++) {
+                  if (volume.getVoxel(i, j, k) != filledVolume.getVoxel(i, j, k)) {
+                     numFilled++;
+                  }
+               }
+            }
+         }
+         
+         //
+         // The voxels of the cavities are the unset voxels that are not
+         // connected to an unset voxel on the edge of the volume
+         //
+         const int numUnset = labelComponentsWithSearch(volume, 0.0, 0.0,
+                                                        VolumeFile::CONNECTIVITY_6,
+                                                        NULL, NULL, searchLabels);
+         std::vector<bool> reachesEdge(numUnset + 1, false);
+         for (int k = 0; k < dim[2]; k++) {
+            for (int j = 0; j < dim[1]; j++) {
+               for (int i = 0; i < dim[0]; i++) {
+                  if ((i == 0) || (i == (dim[0] - 1)) ||
+                      (j == 0) || (j == (dim[1] - 1)) ||
+                      (k == 0) || (k == (dim[2] - 1))) {
+                     reachesEdge[searchLabels[i + j * dim[0] + k * dim[0] * dim[1]]] = true;
+                  }
+               }
+            }
+         }
+         for (unsigned int i = 0; i < searchLabels.size(); i++) {
+            if ((searchLabels[i] > 0) && (reachesEdge[searchLabels[i]] == false)) {
+               numExpectedFilled++;
+            }
+         }
+         if ((numCavities != 0) || (numFilled != numExpectedFilled)) {
+            errorMessage = "cavity filling changed " + QString::number(numFilled)
+                         + " voxels, expected " + QString::number(numExpectedFilled);
+         }
+      }
+      
+      const QString caseDescription = 
+         "Connected components case " + QString::number(caseNum)
+         + " (" + QString::number(dim[0]) + "x" + QString::number(dim[1])
+         + "x" + QString::number(dim[2]) + ", "
+         + QString::number(connectivityNumbers[connectivityIndex]) + " connectivity, "
+         + QString::number(numThreads) + " threads)";
+      if (errorMessage.isEmpty() == false) {
+         std::cout << caseDescription.toAscii().constData() << ": "
+                   << errorMessage.toAscii().constData() << std::endl;
+         numFailedCases++;
+      }
+      else if (showValuesFlag) {
+         std::cout << caseDescription.toAscii().constData() << ": "
+                   << numSearchComponents << " components match." << std::endl;
+      }
+   }
+   
+#ifdef _OPENMP
+   omp_set_num_threads(savedNumberOfThreads);
+#endif
+   
+   if (numFailedCases > 0) {
+      throw CommandException("Connected components unit testing failed for "
+                             + QString::number(numFailedCases)
+                             + " of "
+                             + QString::number(numCases)
+                             + " cases.");
+   }
+   std::cout << "All connected components tests passed." << std::endl;
+}
+
+      
+
@@ -0,0 +1,122 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include "CommandVolumeGaussianBlur.h"
+#include "FileFilters.h"
+#include "ProgramParameters.h"
+#include "ScriptBuilderParameters.h"
+#include "VolumeFile.h"
+
+/**
+ * constructor.
+ */
+CommandVolumeGaussianBlur::CommandVolumeGaussianBlur()
+   : CommandBase("-volume-gaussian-blur",
+                 "VOLUME GAUSSIAN BLUR")
+{
+}
+
+/**
+ * destructor.
+ */
+CommandVolumeGaussianBlur::~CommandVolumeGaussianBlur()
+{
+}
+
+/**
+ * get the script builder parameters.
+ */
+void 
+CommandVolumeGaussianBlur::getScriptBuilderParameters(ScriptBuilderParameters& paramsOut) const
+{
+   paramsOut.clear();
+   paramsOut.addFile("Input Volume File", FileFilters::getVolumeGenericFileFilter());
+   paramsOut.addFile("Output Volume File", FileFilters::getVolumeGenericFileFilter());
+   paramsOut.addFloat("X-Axis Standard Deviation (mm)", 1.0, 0.0, 1000000.0);
+   paramsOut.addFloat("Y-Axis Standard Deviation (mm)", 1.0, 0.0, 1000000.0);
+   paramsOut.addFloat("Z-Axis Standard Deviation (mm)", 1.0, 0.0, 1000000.0);
+}
+
+/**
+ * get full help information.
+ */
+QString 
+CommandVolumeGaussianBlur::getHelpInformation() const
+{
+   QString helpInfo =
+      (indent3 + getShortDescription() + "\n"
+       + indent6 + parameters->getProgramNameWithoutPath() + " " + getOperationSwitch() + "  \n"
+       + indent9 + "<input-volume-file-name>\n"
+       + indent9 + "<output-volume-file-name>\n"
+       + indent9 + "<x-axis-standard-deviation>\n"
+       + indent9 + "<y-axis-standard-deviation>\n"
+       + indent9 + "<z-axis-standard-deviation>\n"
+       + indent9 + "\n"
+       + indent9 + "Smooth the volume with a Gaussian kernel.  The standard\n"
+       + indent9 + "deviations are in millimeters.  The kernel extends three\n"
+       + indent9 + "standard deviations on each side of a voxel and a standard\n"
+       + indent9 + "deviation of zero leaves that axis unsmoothed.\n"
+       + indent9 + "\n");
+      
+   return helpInfo;
+}
+
+/**
+ * execute the command.
+ */
+void 
+CommandVolumeGaussianBlur::executeCommand() throw (BrainModelAlgorithmException,
+                                     CommandException,
+                                     FileException,
+                                     ProgramParametersException,
+                                     StatisticException)
+{
+   const QString inputVolumeFileName =
+      parameters->getNextParameterAsString("Input Volume File Name");
+   QString outputVolumeFileName, outputVolumeFileLabel;
+   parameters->getNextParameterAsVolumeFileNameAndLabel("Output Volume File Name/Label",
+                                                        outputVolumeFileName, 
+                                                        outputVolumeFileLabel);
+   const float sigmaX = parameters->getNextParameterAsFloat("X-Axis Standard Deviation");
+   const float sigmaY = parameters->getNextParameterAsFloat("Y-Axis Standard Deviation");
+   const float sigmaZ = parameters->getNextParameterAsFloat("Z-Axis Standard Deviation");
+   checkForExcessiveParameters();
+   
+   if ((sigmaX < 0.0) || (sigmaY < 0.0) || (sigmaZ < 0.0)) {
+      throw CommandException("Standard deviations must not be negative.");
+   }
+   
+   VolumeFile volumeFile;
+   volumeFile.readFile(inputVolumeFileName);
+   
+   volumeFile.gaussianBlur(sigmaX, sigmaY, sigmaZ);
+                                 
+   writeVolumeFile(volumeFile, 
+                   outputVolumeFileName,
+                   outputVolumeFileLabel);
+}
+
+      
+
@@ -28,6 +28,7 @@
 #include "BrainSet.h"
 #include "BrainModelVolumeToSurfaceMapperAlgorithmParameters.h"
 #include "BrainModelVolumeToSurfaceMapper.h"
+#include "BrainModelVolumeToSurfaceMapperPlan.h"
 #include "CommandVolumeMapToSurface.h"
 #include "FileFilters.h"
 #include "FileUtilities.h"
@@ -36,6 +37,8 @@
 #include "ProgramParameters.h"
 #include "ScriptBuilderParameters.h"
 #include "SpecFile.h"
+#include "VolumeFile.h"
+#include "VolumeFileSubVolumeStream.h"
 
 /**
  * constructor.
@@ -116,6 +119,7 @@ CommandVolumeMapToSurface::getHelpInformation() const
        + indent9 + "      norm above cutoff (mm)\n"
        + indent9 + "      tang-cutoff (mm)]\n"
        + indent9 + "[-mv  maximum-voxel-neighbor-cube-size (mm)]\n"
+       + indent9 + "[-plan  mapping-plan-file-name]\n"
        + indent9 + "[-sv  strongest-voxel-neighbor-cube-size (mm)]\n"
        + indent9 + "\n"
        + indent9 + "Map volume(s) to a surface metric or paint file.\n"
@@ -133,6 +137,15 @@ CommandVolumeMapToSurface::getHelpInformation() const
        + indent9 + " (\"\"), the newly create metric or paint columns will be \n"
        + indent9 + "appended to the file and then written with the output file \n"
        + indent9 + "name.\n"
+       + indent9 + "\n"
+       + indent9 + "The average nodes, average voxel, enclosing voxel, gaussian,\n"
+       + indent9 + "and interpolated voxel algorithms map each volume using a\n"
+       + indent9 + "plan of the voxels and weights for each node.  If a mapping\n"
+       + indent9 + "plan file is specified and it matches the surface, volume\n"
+       + indent9 + "dimensions, origin, and spacing, and algorithm parameters, the\n"
+       + indent9 + "plan is read from the file.  Otherwise, the plan is created\n"
+       + indent9 + "and written to the mapping plan file so that later mappings,\n"
+       + indent9 + "such as other subjects' timeseries, may reuse it.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -184,6 +197,7 @@ CommandVolumeMapToSurface::executeCommand() throw (BrainModelAlgorithmException,
    }
       
    std::vector<QString> inputVolumeFileNames;
+   QString mappingPlanFileName;
    bool readingVolumeFileNamesFlag = true;
    while (parameters->getParametersAvailable()) {
       const QString paramValue = parameters->getNextParameterAsString("Map Volume Parameter");
@@ -212,6 +226,10 @@ CommandVolumeMapToSurface::executeCommand() throw (BrainModelAlgorithmException,
                mappingParameters.setAlgorithmMetricMaximumVoxelParameters(
                   parameters->getNextParameterAsFloat("Maximum Voxel Neighbors (mm)"));
             }
+            else if (paramValue == "-plan") {
+               mappingPlanFileName = 
+                  parameters->getNextParameterAsString("Mapping Plan File Name");
+            }
             else if (paramValue == "-sv") {
                mappingParameters.setAlgorithmMetricStrongestVoxelParameters(
                   parameters->getNextParameterAsFloat("Strongest Voxel Neighbors (mm)"));
@@ -302,26 +320,41 @@ CommandVolumeMapToSurface::executeCommand() throw (BrainModelAlgorithmException,
       }
    }
    
+   //
+   // Read the mapping plan, it is replaced by the mapper if it does not match
+   //
+   BrainModelVolumeToSurfaceMapperPlan mappingPlan;
+   if (mappingPlanFileName.isEmpty() == false) {
+      if (QFile::exists(mappingPlanFileName)) {
+         mappingPlan.readFile(mappingPlanFileName);
+      }
+   }
+   const QByteArray mappingPlanKeyRead = mappingPlan.getKey();
+   
    //
    // Map all of the volume files
    //
    for (int j = 0; j < numberOfVolumeFiles; j++) {
       //
-      // Read the volume file - all of its subvolumes
+      // Stream the volume file's subvolumes so that only a few are in memory
       //
-      std::vector<VolumeFile*> volumes;
-      VolumeFile::readFile(inputVolumeFileNames[j],
-                           VolumeFile::VOLUME_READ_SELECTION_ALL,
-                           volumes,
-                           false);
-      for (unsigned int i = 0; i < volumes.size(); i++) {
-         VolumeFile* vf = volumes[i];
+      VolumeFileSubVolumeStream volumeStream;
+      volumeStream.openFile(inputVolumeFileNames[j]);
+      const int numSubVolumes = volumeStream.getNumberOfSubVolumes();
+      for (int i = 0; i < numSubVolumes; i++) {
+         VolumeFile* vf = volumeStream.readNextSubVolume();
+         if (vf == NULL) {
+            throw CommandException("Unable to read subvolume "
+                                   + QString::number(i + 1)
+                                   + " of "
+                                   + inputVolumeFileNames[j]);
+         }
          
          //
          // Name for output column
          //
          QString columnName(FileUtilities::basename(inputVolumeFileNames[j]));
-         if (volumes.size() > 0) {
+         if (numSubVolumes > 0) {
             columnName += ("["
                            + QString::number(i + 1)
                            + "]");
@@ -336,6 +369,7 @@ CommandVolumeMapToSurface::executeCommand() throw (BrainModelAlgorithmException,
                                                 mappingParameters,
                                                 -1,
                                                 columnName);
+         mapper.setMappingPlan(&mappingPlan);
                
          //
          // Run the mapper
@@ -349,6 +383,16 @@ CommandVolumeMapToSurface::executeCommand() throw (BrainModelAlgorithmException,
       }
    }
    
+   //
+   // Save the mapping plan if it was created
+   //
+   if (mappingPlanFileName.isEmpty() == false) {
+      if ((mappingPlan.getKey().isEmpty() == false) &&
+          (mappingPlan.getKey() != mappingPlanKeyRead)) {
+         mappingPlan.writeFile(mappingPlanFileName);
+      }
+   }
+   
    //
    // Save the metric file
    //
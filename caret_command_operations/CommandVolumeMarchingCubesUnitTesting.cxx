@@ -0,0 +1,482 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <QGlobalStatic>  // needed for Q_OS_WIN32
+#ifdef Q_OS_WIN32     // required for M_PI in <cmath>
+#define _USE_MATH_DEFINES
+#define NOMINMAX
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "BrainModelVolumeMarchingCubes.h"
+#include "CommandVolumeMarchingCubesUnitTesting.h"
+#include "ProgramParameters.h"
+#include "ScriptBuilderParameters.h"
+#include "StatisticRandomNumberStream.h"
+#include "VolumeFile.h"
+
+/**
+ * constructor.
+ */
+CommandVolumeMarchingCubesUnitTesting::CommandVolumeMarchingCubesUnitTesting()
+   : CommandBase("-volume-marching-cubes-unit-test",
+                 "VOLUME MARCHING CUBES UNIT TESTING")
+{
+}
+
+/**
+ * destructor.
+ */
+CommandVolumeMarchingCubesUnitTesting::~CommandVolumeMarchingCubesUnitTesting()
+{
+}
+
+/**
+ * get the script builder parameters.
+ */
+void 
+CommandVolumeMarchingCubesUnitTesting::getScriptBuilderParameters(ScriptBuilderParameters& paramsOut) const
+{
+   paramsOut.clear();
+   paramsOut.addBoolean("Show Values", false);
+}
+
+/**
+ * get full help information.
+ */
+QString 
+CommandVolumeMarchingCubesUnitTesting::getHelpInformation() const
+{
+   QString helpInfo =
+      (indent3 + getShortDescription() + "\n"
+       + indent6 + parameters->getProgramNameWithoutPath() + " " + getOperationSwitch() + "  \n"
+       + indent9 + "<show-values-flag>\n"
+       + indent9 + "\n"
+       + indent9 + "Test the marching cubes surface reconstruction.  Spheres and\n"
+       + indent9 + "random segmentations in volumes with random dimensions,\n"
+       + indent9 + "origins, and (possibly mirrored) spacing are reconstructed.\n"
+       + indent9 + "Each mesh must be closed with every edge used by two\n"
+       + indent9 + "triangles in opposite directions, must enclose a positive\n"
+       + indent9 + "volume, and must stay closed after decimation.  Spheres must\n"
+       + indent9 + "have an Euler characteristic of two, the expected volume, and\n"
+       + indent9 + "outward normals.  The mesh must not depend upon the number of\n"
+       + indent9 + "threads.\n"
+       + indent9 + "\n"
+       + indent9 + "\"show-values-flag\" is either \"true\"or \"false\".  If true,\n"
+       + indent9 + "the result of each case is displayed, else only errors are\n"
+       + indent9 + "displayed.\n"
+       + indent9 + "\n");
+      
+   return helpInfo;
+}
+
+/**
+ * Check that a mesh is closed and consistently oriented.  Every edge must be
+ * used by exactly two triangles that traverse it in opposite directions and
+ * every vertex must be used by a triangle.  Returns an empty string if the
+ * mesh is valid, else a description of the problem.
+ */
+static QString
+checkClosedMesh(const BrainModelVolumeMarchingCubes& mc)
+{
+   const int numVertices = mc.getNumberOfVertices();
+   const int numTriangles = mc.getNumberOfTriangles();
+   const std::vector<int>& triangles = mc.getTriangles();
+   
+   std::set<std::pair<int, int> > directedEdges;
+   std::vector<bool> vertexUsed(numVertices, false);
+   for (int i = 0; i < numTriangles; i++) {
+      for (int m = 0; m < 3; m++) {
+         const int v1 = triangles[i * 3 + m];
+         const int v2 = triangles[i * 3 + ((m + 1) % 3)];
+         if ((v1 < 0) || (v1 >= numVertices)) {
+            return ("triangle " + QString::number(i) + " uses an invalid vertex");
+         }
+         if (v1 == v2) {
+            return ("triangle " + QString::number(i) + " is degenerate");
+         }
+         if (directedEdges.insert(std::make_pair(v1, v2)).second == false) {
+            return ("edge " + QString::number(v1) + "-" + QString::number(v2)
+                    + " is traversed twice in the same direction");
+         }
+         vertexUsed[v1] = true;
+      }
+   }
+   
+   for (std::set<std::pair<int, int> >::const_iterator iter = directedEdges.begin();
+        iter != directedEdges.end();
+        iter++) {
+      if (directedEdges.find(std::make_pair(iter->second, iter->first)) == directedEdges.end()) {
+         return ("edge " + QString::number(iter->first) + "-" + QString::number(iter->second)
+                 + " is used by only one triangle");
+      }
+   }
+   
+   for (int i = 0; i < numVertices; i++) {
+      if (vertexUsed[i] == false) {
+         return ("vertex " + QString::number(i) + " is not used by any triangle");
+      }
+   }
+   
+   return "";
+}
+
+/**
+ * Get the Euler characteristic of a closed mesh.
+ */
+static int
+getEulerCharacteristic(const BrainModelVolumeMarchingCubes& mc)
+{
+   const int numTriangles = mc.getNumberOfTriangles();
+   const int numEdges = (numTriangles * 3) / 2;
+   return (mc.getNumberOfVertices() - numEdges + numTriangles);
+}
+
+/**
+ * Get the volume enclosed by a closed mesh (positive if the triangles' normals
+ * point out).
+ */
+static double
+getEnclosedVolume(const BrainModelVolumeMarchingCubes& mc)
+{
+   const std::vector<float>& xyz = mc.getCoordinates();
+   const std::vector<int>& triangles = mc.getTriangles();
+   double volume = 0.0;
+   for (int i = 0; i < mc.getNumberOfTriangles(); i++) {
+      const float* p1 = &xyz[triangles[i * 3] * 3];
+      const float* p2 = &xyz[triangles[i * 3 + 1] * 3];
+      const float* p3 = &xyz[triangles[i * 3 + 2] * 3];
+      volume += (p1[0] * (p2[1] * p3[2] - p2[2] * p3[1])
+               - p1[1] * (p2[0] * p3[2] - p2[2] * p3[0])
+               + p1[2] * (p2[0] * p3[1] - p2[1] * p3[0]));
+   }
+   return (volume / 6.0);
+}
+
+/**
+ * Create a volume with random dimensions, origin, and spacing.  Each axis'
+ * spacing may be negative.
+ */
+static void
+createRandomVolume(StatisticRandomNumberStream& randomStream,
+                   const int minDim,
+                   const int maxDim,
+                   VolumeFile& volumeOut)
+{
+   int dim[3];
+   float origin[3], spacing[3];
+   for (int i = 0; i < 3; i++) {
+      dim[i] = randomStream.randomInteger(minDim, maxDim);
+      origin[i] = randomStream.randomFloat(-50.0, 50.0);
+      spacing[i] = randomStream.randomFloat(0.5, 2.0);
+      if (randomStream.randomInteger(0, 3) == 0) {
+         spacing[i] = -spacing[i];
+      }
+   }
+   const VolumeFile::ORIENTATION orientation[3] = {
+      VolumeFile::ORIENTATION_LEFT_TO_RIGHT,
+      VolumeFile::ORIENTATION_POSTERIOR_TO_ANTERIOR,
+      VolumeFile::ORIENTATION_INFERIOR_TO_SUPERIOR
+   };
+   volumeOut.initialize(VolumeFile::VOXEL_DATA_TYPE_FLOAT,
+                        dim,
+                        orientation,
+                        origin,
+                        spacing,
+                        true);
+}
+
+/**
+ * execute the command.
+ */
+void 
+CommandVolumeMarchingCubesUnitTesting::executeCommand() throw (BrainModelAlgorithmException,
+                                     CommandException,
+                                     FileException,
+                                     ProgramParametersException,
+                                     StatisticException)
+{
+   const bool showValuesFlag =
+      parameters->getNextParameterAsBoolean("Show Values Flag");
+   checkForExcessiveParameters();
+   
+   const float isovalue = 127.5;
+   int numFailedCases = 0;
+   int numCases = 0;
+   
+   //
+   // Spheres whose voxel values increase linearly toward the center so
+   // that the isosurface is a sphere of the chosen radius in voxels
+   //
+   const int numSphereCases = 40;
+   for (int caseNum = 0; caseNum < numSphereCases; caseNum++) {
+      numCases++;
+      StatisticRandomNumberStream randomStream(2401, caseNum);
+      VolumeFile volume;
+      createRandomVolume(randomStream, 12, 32, volume);
+      int dim[3];
+      float origin[3], spacing[3];
+      volume.getDimensions(dim);
+      volume.getOrigin(origin);
+      volume.getSpacing(spacing);
+      
+      const int minDim = std::min(dim[0], std::min(dim[1], dim[2]));
+      const float radius = randomStream.randomFloat(4.0, minDim * 0.5 - 1.5);
+      float center[3];
+      for (int m = 0; m < 3; m++) {
+         center[m] = randomStream.randomFloat(radius + 1.0, dim[m] - 2.0 - radius);
+      }
+      for (int k = 0; k < dim[2]; k++) {
+         for (int j = 0; j < dim[1]; j++) {
+            for (int i = 0; i < dim[0]; i++) {
+               const float dx = i - center[0];
+               const float dy = j - center[1];
+               const float dz = k - center[2];
+               const float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+               const float value = isovalue + 50.0 * (radius - dist);
+               volume.setVoxel(i, j, k, 0, std::max(0.0f, std::min(255.0f, value)));
+            }
+         }
+      }
+      
+      BrainModelVolumeMarchingCubes mc(&volume, isovalue);
+      mc.execute();
+      
+      QString errorMessage = checkClosedMesh(mc);
+      const double expectedVolume = (4.0 / 3.0) * M_PI * radius * radius * radius
+                                  * std::fabs(spacing[0] * spacing[1] * spacing[2]);
+      const double volumeEnclosed = getEnclosedVolume(mc);
+      if (errorMessage.isEmpty()) {
+         if (getEulerCharacteristic(mc) != 2) {
+            errorMessage = "Euler characteristic is "
+                         + QString::number(getEulerCharacteristic(mc));
+         }
+         else if (std::fabs(volumeEnclosed - expectedVolume) > (0.05 * expectedVolume)) {
+            errorMessage = "enclosed volume is " + QString::number(volumeEnclosed)
+                         + " expected " + QString::number(expectedVolume);
+         }
+      }
+      
+      //
+      // Each vertex normal must point away from the sphere's center
+      //
+      if (errorMessage.isEmpty()) {
+         mc.computeNormals();
+         const std::vector<float>& xyz = mc.getCoordinates();
+         const std::vector<float>& normals = mc.getNormals();
+         float centerXYZ[3];
+         for (int m = 0; m < 3; m++) {
+            centerXYZ[m] = origin[m] + center[m] * spacing[m];
+         }
+         for (int i = 0; i < mc.getNumberOfVertices(); i++) {
+            float dot = 0.0;
+            for (int m = 0; m < 3; m++) {
+               dot += normals[i * 3 + m] * (xyz[i * 3 + m] - centerXYZ[m]);
+            }
+            if (dot <= 0.0) {
+               errorMessage = "normal of vertex " + QString::number(i)
+                            + " points toward the center";
+               break;
+            }
+         }
+      }
+      
+      //
+      // Decimation must keep the mesh closed and its topology
+      //
+      if (errorMessage.isEmpty()) {
+         mc.decimate(0.9, 0.001);
+         errorMessage = checkClosedMesh(mc);
+         if (errorMessage.isEmpty() == false) {
+            errorMessage = "after decimation " + errorMessage;
+         }
+         else if (getEulerCharacteristic(mc) != 2) {
+            errorMessage = "after decimation Euler characteristic is "
+                         + QString::number(getEulerCharacteristic(mc));
+         }
+      }
+      
+      if (errorMessage.isEmpty() == false) {
+         std::cout << "Marching cubes sphere case " << caseNum
+                   << " (" << dim[0] << "x" << dim[1] << "x" << dim[2]
+                   << ", radius " << radius << "): "
+                   << errorMessage.toAscii().constData() << std::endl;
+         numFailedCases++;
+      }
+      else if (showValuesFlag) {
+         std::cout << "Marching cubes sphere case " << caseNum
+                   << " (" << dim[0] << "x" << dim[1] << "x" << dim[2]
+                   << ", radius " << radius << "): "
+                   << mc.getNumberOfTriangles() << " triangles after decimation, "
+                   << "volume " << volumeEnclosed
+                   << " expected " << expectedVolume << std::endl;
+      }
+   }
+   
+   //
+   // Random segmentations exercise all of the cube cases.  Voxels on the
+   // border of the volume are outside so that the mesh is closed.
+   //
+   const int numRandomCases = 300;
+   for (int caseNum = 0; caseNum < numRandomCases; caseNum++) {
+      numCases++;
+      StatisticRandomNumberStream randomStream(2402, caseNum);
+      VolumeFile volume;
+      createRandomVolume(randomStream, 3, 12, volume);
+      int dim[3];
+      float spacing[3];
+      volume.getDimensions(dim);
+      volume.getSpacing(spacing);
+      
+      const int density = randomStream.randomInteger(0, 100);
+      const bool binaryFlag = ((caseNum % 2) == 0);
+      for (int k = 1; k < (dim[2] - 1); k++) {
+         for (int j = 1; j < (dim[1] - 1); j++) {
+            for (int i = 1; i < (dim[0] - 1); i++) {
+               if (randomStream.randomInteger(1, 100) <= density) {
+                  volume.setVoxel(i, j, k, 0, 
+                                  binaryFlag ? 255.0 : randomStream.randomFloat(0.0, 255.0));
+               }
+            }
+         }
+      }
+      
+      BrainModelVolumeMarchingCubes mc(&volume, isovalue);
+      mc.execute();
+      
+      QString errorMessage = checkClosedMesh(mc);
+      int eulerCharacteristic = 0;
+      double volumeEnclosed = 0.0;
+      if (errorMessage.isEmpty()) {
+         eulerCharacteristic = getEulerCharacteristic(mc);
+         volumeEnclosed = getEnclosedVolume(mc);
+         if ((mc.getNumberOfTriangles() > 0) &&
+             (volumeEnclosed <= 0.0)) {
+            errorMessage = "enclosed volume is " + QString::number(volumeEnclosed);
+         }
+      }
+      if (errorMessage.isEmpty()) {
+         mc.decimate(0.9, 0.001);
+         errorMessage = checkClosedMesh(mc);
+         if (errorMessage.isEmpty() == false) {
+            errorMessage = "after decimation " + errorMessage;
+         }
+         else if (getEulerCharacteristic(mc) != eulerCharacteristic) {
+            errorMessage = "decimation changed the Euler characteristic from "
+                         + QString::number(eulerCharacteristic) + " to "
+                         + QString::number(getEulerCharacteristic(mc));
+         }
+         else if (std::fabs(getEnclosedVolume(mc) - volumeEnclosed) 
+                  > (0.001 * (1.0 + std::fabs(volumeEnclosed)))) {
+            errorMessage = "decimation changed the enclosed volume from "
+                         + QString::number(volumeEnclosed) + " to "
+                         + QString::number(getEnclosedVolume(mc));
+         }
+      }
+      
+      if (errorMessage.isEmpty() == false) {
+         std::cout << "Marching cubes random case " << caseNum
+                   << " (" << dim[0] << "x" << dim[1] << "x" << dim[2] << "): "
+                   << errorMessage.toAscii().constData() << std::endl;
+         numFailedCases++;
+      }
+      else if (showValuesFlag) {
+         std::cout << "Marching cubes random case " << caseNum
+                   << " (" << dim[0] << "x" << dim[1] << "x" << dim[2] << "): "
+                   << mc.getNumberOfTriangles() << " triangles after decimation, "
+                   << "Euler characteristic " << eulerCharacteristic << std::endl;
+      }
+   }
+   
+#ifdef _OPENMP
+   //
+   // The mesh must be identical for any number of threads
+   //
+   const int numThreadCases = 20;
+   const int savedNumberOfThreads = omp_get_max_threads();
+   for (int caseNum = 0; caseNum < numThreadCases; caseNum++) {
+      numCases++;
+      StatisticRandomNumberStream randomStream(2403, caseNum);
+      VolumeFile volume;
+      createRandomVolume(randomStream, 8, 24, volume);
+      int dim[3];
+      volume.getDimensions(dim);
+      for (int k = 0; k < dim[2]; k++) {
+         for (int j = 0; j < dim[1]; j++) {
+            for (int i = 0; i < dim[0]; i++) {
+               volume.setVoxel(i, j, k, 0, randomStream.randomFloat(0.0, 255.0));
+            }
+         }
+      }
+      
+      omp_set_num_threads(1);
+      BrainModelVolumeMarchingCubes serialMC(&volume, isovalue);
+      serialMC.execute();
+      
+      const int numThreads = randomStream.randomInteger(2, 9);
+      omp_set_num_threads(numThreads);
+      BrainModelVolumeMarchingCubes parallelMC(&volume, isovalue);
+      parallelMC.execute();
+      
+      if ((serialMC.getCoordinates() != parallelMC.getCoordinates()) ||
+          (serialMC.getTriangles() != parallelMC.getTriangles())) {
+         std::cout << "Marching cubes thread case " << caseNum
+                   << " (" << dim[0] << "x" << dim[1] << "x" << dim[2] << "): "
+                   << "mesh with " << numThreads << " threads differs from "
+                   << "mesh with one thread." << std::endl;
+         numFailedCases++;
+      }
+      else if (showValuesFlag) {
+         std::cout << "Marching cubes thread case " << caseNum
+                   << " (" << dim[0] << "x" << dim[1] << "x" << dim[2] << "): "
+                   << numThreads << " threads match one thread." << std::endl;
+      }
+   }
+   omp_set_num_threads(savedNumberOfThreads);
+#endif // _OPENMP
+   
+   if (numFailedCases > 0) {
+      throw CommandException("Marching cubes unit testing failed for "
+                             + QString::number(numFailedCases)
+                             + " of "
+                             + QString::number(numCases)
+                             + " cases.");
+   }
+   std::cout << "All marching cubes tests passed." << std::endl;
+}
+
+      
+
@@ -30,8 +30,8 @@
 #include "ProgramParameters.h"
 #include "ScriptBuilderParameters.h"
 #include "BrainModelVolumeTFCE.h"
-#include "BrainSet.h"
 #include "StringUtilities.h"
+#include "VolumeFile.h"
 
 /**
  * constructor.
@@ -82,6 +82,9 @@ CommandVolumeTFCE::getHelpInformation() const
        + indent9 + "\n"
        + indent9 + "Enhance clusterlike signal using Threshhold Free Cluster Enhancement\n"
        + indent9 + "\n"
+       + indent9 + "All sub-volumes in the input file are enhanced, in parallel when\n"
+       + indent9 + "multiple processors are available.\n"
+       + indent9 + "\n"
        + indent9 + "   Optional parameters: (default value specified above)\n"
        + indent9 + "      number-of-steps  number of pieces used to approximate the integral\n"
        + indent9 + "                        using the value at the center of a piece as the\n"
@@ -133,46 +136,50 @@ CommandVolumeTFCE::executeCommand() throw (BrainModelAlgorithmException,
    checkForExcessiveParameters();
    
    //
-   // Create a brain set
+   // Read all sub-volumes of the volume file
    //
-   BrainSet brainSet;
+   std::vector<VolumeFile*> inputVolumes;
+   VolumeFile::readFile(inputVolumeFileName,
+                        VolumeFile::VOLUME_READ_SELECTION_ALL,
+                        inputVolumes);
+   if (inputVolumes.empty()) {
+      throw CommandException("No volumes in " + inputVolumeFileName);
+   }
    
    //
-   // Read the volume file
+   // Create output volumes
    //
-   VolumeFile inputVolume;
-   inputVolume.readFile(inputVolumeFileName);
+   std::vector<VolumeFile*> outVolumes;
+   for (unsigned int i = 0; i < inputVolumes.size(); i++) {
+      VolumeFile* vf = new VolumeFile(*inputVolumes[i]);
+      vf->setFileName(outputVolumeFileName);
+      vf->setDescriptiveLabel(outputVolumeLabel);
+      outVolumes.push_back(vf);
+   }
    
    //
-   // Create output volume file
-   //
-   VolumeFile outVolume(inputVolume);
-
+   // Enhance the volumes
    //
-   // Create the Ligase object
-   //
-   BrainModelVolumeTFCE TFCEObject(&brainSet,
-                                                   &inputVolume,
-                                                   &outVolume,
-                                                   outputVolumeFileName,
-                                                   outputVolumeLabel,
-                                                   numSteps,
-                                                   E,
-                                                   H);
+   BrainModelVolumeTFCE::computeTFCEForVolumes(inputVolumes,
+                                               outVolumes,
+                                               numSteps,
+                                               E,
+                                               H);
    
    //
-   // Execute Ligase
+   // Write the file
    //
-   TFCEObject.execute();
+   VolumeFile::writeFile(outputVolumeFileName,
+                         outVolumes[0]->getVolumeType(),
+                         outVolumes[0]->getVoxelDataType(),
+                         outVolumes);
    
    //
-   // Write the file
+   // Free memory
    //
-   outVolume.writeFile(outputVolumeFileName);
-   
-   const QString warningMessages = TFCEObject.getWarningMessages();
-   if (warningMessages.isEmpty() == false) {
-      std::cout << "TFCE Warnings: " << warningMessages.toAscii().constData() << std::endl;
+   for (unsigned int i = 0; i < inputVolumes.size(); i++) {
+      delete inputVolumes[i];
+      delete outVolumes[i];
    }
 }
 
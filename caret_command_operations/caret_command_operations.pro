@@ -88,6 +88,8 @@ HEADERS += CommandBase.h \
            CommandMetricStatisticsTMap.h \
            CommandMetricStatisticsTwoSampleTTest.h \
            CommandMetricStatisticsZMap.h \
+           CommandMetricTFCE.h \
+           CommandMetricTFCEUnitTesting.h \
            CommandMetricTranspose.h \
            CommandMetricTwinComparison.h \
            CommandMetricTwinPairedDataDiffs.h \
@@ -116,6 +118,7 @@ HEADERS += CommandBase.h \
            CommandSpecFileCopy.h \
            CommandSpecFileCreate.h \
            CommandSpecFileDirectoryClean.h \
+           CommandSpecFileReorderNodes.h \
            CommandSpecFileZip.h \
            CommandStatisticSetRandomSeed.h \
            CommandStatisticalUnitTesting.h \
@@ -209,6 +212,7 @@ HEADERS += CommandBase.h \
            CommandVolumeBiasCorrection.h \
            CommandVolumeBlur.h \
            CommandVolumeClassifyIntensities.h \
+           CommandVolumeConnectedComponentsUnitTesting.h \
            CommandVolumeConvertVectorToVolume.h \
            CommandVolumeCreate.h \
            CommandVolumeCreateCorpusCallosumSlice.h \
@@ -225,6 +229,7 @@ HEADERS += CommandBase.h \
            CommandVolumeFillSlice.h \
            CommandVolumeFindLimits.h \
            CommandVolumeFloodFill.h \
+           CommandVolumeGaussianBlur.h \
            CommandVolumeGradient.h \
            CommandVolumeHistogram.h \
            CommandVolumeImportRawFile.h \
@@ -238,6 +243,7 @@ HEADERS += CommandBase.h \
            CommandVolumeMapToSurfacePALS.h \
            CommandVolumeMapToSurfaceROIFile.h \
            CommandVolumeMapToVtkModel.h \
+           CommandVolumeMarchingCubesUnitTesting.h \
            CommandVolumeMaskVolume.h \
            CommandVolumeMaskWithVolume.h \
            CommandVolumeNearToPlane.h \
@@ -350,6 +356,8 @@ SOURCES += CommandBase.cxx \
            CommandMetricStatisticsTMap.cxx \
            CommandMetricStatisticsTwoSampleTTest.cxx \
            CommandMetricStatisticsZMap.cxx \
+           CommandMetricTFCE.cxx \
+           CommandMetricTFCEUnitTesting.cxx \
            CommandMetricTranspose.cxx \
            CommandMetricTwinComparison.cxx \
            CommandMetricTwinPairedDataDiffs.cxx \
@@ -378,6 +386,7 @@ SOURCES += CommandBase.cxx \
            CommandSpecFileCopy.cxx \
            CommandSpecFileCreate.cxx \
            CommandSpecFileDirectoryClean.cxx \
+           CommandSpecFileReorderNodes.cxx \
            CommandSpecFileZip.cxx \
            CommandStatisticSetRandomSeed.cxx \
            CommandStatisticalUnitTesting.cxx \
@@ -471,6 +480,7 @@ SOURCES += CommandBase.cxx \
            CommandVolumeBiasCorrection.cxx \
            CommandVolumeBlur.cxx \
            CommandVolumeClassifyIntensities.cxx \
+           CommandVolumeConnectedComponentsUnitTesting.cxx \
            CommandVolumeConvertVectorToVolume.cxx \
            CommandVolumeCreate.cxx \
            CommandVolumeCreateCorpusCallosumSlice.cxx \
@@ -487,6 +497,7 @@ SOURCES += CommandBase.cxx \
            CommandVolumeFillSlice.cxx \
            CommandVolumeFindLimits.cxx \
            CommandVolumeFloodFill.cxx \
+           CommandVolumeGaussianBlur.cxx \
            CommandVolumeGradient.cxx \
            CommandVolumeHistogram.cxx \
            CommandVolumeImportRawFile.cxx \
@@ -500,6 +511,7 @@ SOURCES += CommandBase.cxx \
            CommandVolumeMapToSurfacePALS.cxx \
            CommandVolumeMapToSurfaceROIFile.cxx \
            CommandVolumeMapToVtkModel.cxx \
+           CommandVolumeMarchingCubesUnitTesting.cxx \
            CommandVolumeMaskVolume.cxx \
            CommandVolumeMaskWithVolume.cxx \
            CommandVolumeNearToPlane.cxx \
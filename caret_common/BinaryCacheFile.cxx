@@ -0,0 +1,235 @@
+
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+
+#include "BinaryCacheFile.h"
+
+/// used to detect a file written on a machine with another byte order
+static const int cacheFileByteOrder = 0x01020304;
+
+/**
+ * constructor.
+ */
+BinaryCacheFile::BinaryCacheFile(const char magicIn[8],
+                                 const int versionIn)
+{
+   std::copy(magicIn, magicIn + sizeof(magic), magic);
+   version = versionIn;
+   writeFailedFlag = false;
+}
+
+/**
+ * destructor (a file being written that was not closed is removed).
+ */
+BinaryCacheFile::~BinaryCacheFile()
+{
+   if (file.isOpen()) {
+      const bool writingFlag = file.isWritable();
+      file.close();
+      if (writingFlag) {
+         QFile::remove(file.fileName());
+      }
+   }
+}
+
+/**
+ * add the magic characters and version to a hash used as a key so that
+ * keys change when the format changes.
+ */
+void 
+BinaryCacheFile::addFormatToHash(QCryptographicHash& hash) const
+{
+   hash.addData(magic, sizeof(magic));
+   hash.addData(reinterpret_cast<const char*>(&version), sizeof(int));
+}
+
+/**
+ * open a file for reading and read its header.  Returns true if the file
+ * has this format's magic characters and version, was written with this
+ * machine's byte order, and contains a key of "keySize" bytes.
+ */
+bool 
+BinaryCacheFile::openForReading(const QString& fileNameIn,
+                                const int keySize,
+                                QByteArray& keyOut)
+{
+   fileName = fileNameIn;
+   errorMessage = "";
+   keyOut.clear();
+   
+   file.setFileName(fileName);
+   if (file.open(QIODevice::ReadOnly) == false) {
+      errorMessage = file.errorString();
+      return false;
+   }
+   
+   char fileMagic[sizeof(magic)];
+   int fileVersion = 0, byteOrder = 0;
+   if ((file.read(fileMagic, sizeof(fileMagic)) != sizeof(fileMagic)) ||
+       (std::equal(fileMagic, fileMagic + sizeof(fileMagic), magic) == false) ||
+       (file.read(reinterpret_cast<char*>(&fileVersion), sizeof(int)) != sizeof(int)) ||
+       (fileVersion != version) ||
+       (file.read(reinterpret_cast<char*>(&byteOrder), sizeof(int)) != sizeof(int)) ||
+       (byteOrder != cacheFileByteOrder) ||
+       ((keyOut = file.read(keySize)).size() != keySize)) {
+      errorMessage = "Invalid header, the file has another format or version.";
+      file.close();
+      keyOut.clear();
+      return false;
+   }
+   
+   return true;
+}
+
+/**
+ * open a temporary file for writing and write the header.  The 
+ * directory containing the file is created if needed.
+ */
+bool 
+BinaryCacheFile::openForWriting(const QString& fileNameIn,
+                                const QByteArray& key)
+{
+   fileName = fileNameIn;
+   errorMessage = "";
+   writeFailedFlag = false;
+   
+   const QFileInfo fileInfo(fileName);
+   if (QDir().mkpath(fileInfo.absolutePath()) == false) {
+      errorMessage = "Unable to create directory " + fileInfo.absolutePath();
+      return false;
+   }
+   
+   const QString tempFileName = fileName 
+                              + "." 
+                              + QString::number(QCoreApplication::applicationPid())
+                              + ".tmp";
+   file.setFileName(tempFileName);
+   if (file.open(QIODevice::WriteOnly) == false) {
+      errorMessage = file.errorString();
+      return false;
+   }
+   
+   return (writeData(magic, sizeof(magic)) &&
+           writeData(&version, sizeof(int)) &&
+           writeData(&cacheFileByteOrder, sizeof(int)) &&
+           writeData(key.constData(), key.size()));
+}
+
+/**
+ * read data (returns true if all bytes were read).
+ */
+bool 
+BinaryCacheFile::readData(void* dataOut,
+                          const qint64 numberOfBytes)
+{
+   if (numberOfBytes <= 0) {
+      return true;
+   }
+   if (file.read(reinterpret_cast<char*>(dataOut), numberOfBytes) != numberOfBytes) {
+      errorMessage = "Premature end of file.";
+      return false;
+   }
+   return true;
+}
+
+/**
+ * write data (returns true if all bytes were written).
+ */
+bool 
+BinaryCacheFile::writeData(const void* data,
+                           const qint64 numberOfBytes)
+{
+   if (writeFailedFlag) {
+      return false;
+   }
+   if (numberOfBytes <= 0) {
+      return true;
+   }
+   if (file.write(reinterpret_cast<const char*>(data), numberOfBytes) != numberOfBytes) {
+      errorMessage = file.errorString();
+      writeFailedFlag = true;
+      return false;
+   }
+   return true;
+}
+
+/**
+ * get the number of bytes not yet read.
+ */
+qint64 
+BinaryCacheFile::getNumberOfBytesRemaining() const
+{
+   return (file.size() - file.pos());
+}
+
+/**
+ * close a file being read.
+ */
+void 
+BinaryCacheFile::closeForReading()
+{
+   file.close();
+}
+
+/**
+ * close the temporary file and, if all writes succeeded, rename it to 
+ * the file's name replacing any existing file.  The temporary file is 
+ * removed if writing failed.
+ */
+bool 
+BinaryCacheFile::closeForWriting()
+{
+   const QString tempFileName = file.fileName();
+   if (file.isOpen() == false) {
+      return false;
+   }
+   if ((writeFailedFlag == false) &&
+       (file.flush() == false)) {
+      errorMessage = file.errorString();
+      writeFailedFlag = true;
+   }
+   file.close();
+   
+   bool okFlag = (writeFailedFlag == false);
+   if (okFlag) {
+      QFile::remove(fileName);
+      okFlag = QFile::rename(tempFileName, fileName);
+      if (okFlag == false) {
+         errorMessage = "Unable to rename " + tempFileName + " to " + fileName;
+      }
+   }
+   if (okFlag == false) {
+      QFile::remove(tempFileName);
+   }
+   return okFlag;
+}
@@ -0,0 +1,105 @@
+#ifndef __BINARY_CACHE_FILE_H__
+#define __BINARY_CACHE_FILE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+class QCryptographicHash;
+
+/// Reads and writes binary cache files.  A cache file starts with a header
+/// containing the format's magic characters, its version, a byte order 
+/// marker, and the key identifying the cached data.  A file is written 
+/// under a temporary name and renamed when complete so that other 
+/// processes never see a partial file.
+class BinaryCacheFile {
+   public:
+      // constructor
+      BinaryCacheFile(const char magicIn[8],
+                      const int versionIn);
+      
+      // destructor
+      ~BinaryCacheFile();
+      
+      // add the magic characters and version to a hash used as a key
+      void addFormatToHash(QCryptographicHash& hash) const;
+      
+      // open a file for reading and read its header (returns true if the header is valid)
+      bool openForReading(const QString& fileName,
+                          const int keySize,
+                          QByteArray& keyOut);
+                          
+      // open a temporary file for writing and write the header (returns true if successful)
+      bool openForWriting(const QString& fileName,
+                          const QByteArray& key);
+                          
+      // read data (returns true if all bytes were read)
+      bool readData(void* dataOut,
+                    const qint64 numberOfBytes);
+                    
+      // write data (returns true if all bytes were written)
+      bool writeData(const void* data,
+                     const qint64 numberOfBytes);
+      
+      // get the number of bytes not yet read
+      qint64 getNumberOfBytesRemaining() const;
+      
+      // close a file being read
+      void closeForReading();
+      
+      // close the temporary file and rename it to the file's name (returns true if successful)
+      bool closeForWriting();
+      
+      /// get the name of the file
+      QString getFileName() const { return fileName; }
+      
+      /// get a description of the last error
+      QString getErrorMessage() const { return errorMessage; }
+      
+   protected:
+      /// the file being read or the temporary file being written
+      QFile file;
+      
+      /// name of the file
+      QString fileName;
+      
+      /// description of the last error
+      QString errorMessage;
+      
+      /// the magic characters identifying the format
+      char magic[8];
+      
+      /// version of the format
+      int version;
+      
+      /// writing failed
+      bool writeFailedFlag;
+};
+
+#endif // __BINARY_CACHE_FILE_H__
+
@@ -0,0 +1,143 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+
+#include "SpaceFillingCurve.h"
+
+/**
+ * Get the order of points along a 3D Hilbert curve.  The points are 
+ * quantized into a grid covering their bounding box and sorted by
+ * their position along the curve.  "orderOut[i]" is the index of the
+ * point that is "i"th along the curve.
+ */
+void 
+SpaceFillingCurve::getHilbertOrder(const float* xyz,
+                                   const int numberOfPoints,
+                                   std::vector<int>& orderOut)
+{
+   orderOut.clear();
+   if (numberOfPoints <= 0) {
+      return;
+   }
+   
+   //
+   // Bounding box of the points
+   //
+   float minXYZ[3] = { xyz[0], xyz[1], xyz[2] };
+   float maxXYZ[3] = { xyz[0], xyz[1], xyz[2] };
+   for (int i = 1; i < numberOfPoints; i++) {
+      for (int j = 0; j < 3; j++) {
+         minXYZ[j] = std::min(minXYZ[j], xyz[i*3+j]);
+         maxXYZ[j] = std::max(maxXYZ[j], xyz[i*3+j]);
+      }
+   }
+   
+   //
+   // Use the same scale on all axes so the cells of the grid are cubes
+   //
+   const unsigned int maxCell = (1 << BITS_PER_AXIS) - 1;
+   float extent = std::max(maxXYZ[0] - minXYZ[0],
+                           std::max(maxXYZ[1] - minXYZ[1], maxXYZ[2] - minXYZ[2]));
+   float scale = 0.0;
+   if (extent > 0.0) {
+      scale = static_cast<float>(maxCell) / extent;
+   }
+   
+   std::vector<CurvePoint> curvePoints;
+   curvePoints.reserve(numberOfPoints);
+   for (int i = 0; i < numberOfPoints; i++) {
+      unsigned int cell[3];
+      for (int j = 0; j < 3; j++) {
+         const float f = (xyz[i*3+j] - minXYZ[j]) * scale;
+         cell[j] = std::min(static_cast<unsigned int>(std::max(f, 0.0f)), maxCell);
+      }
+      curvePoints.push_back(CurvePoint(getHilbertIndex(cell[0], cell[1], cell[2]), i));
+   }
+   std::sort(curvePoints.begin(), curvePoints.end());
+   
+   orderOut.resize(numberOfPoints);
+   for (int i = 0; i < numberOfPoints; i++) {
+      orderOut[i] = curvePoints[i].point;
+   }
+}
+
+/**
+ * Get the index of a point along a 3D Hilbert curve.  Uses the
+ * "transpose" algorithm from J. Skilling, "Programming the Hilbert
+ * curve", AIP Conf. Proc. 707, 381 (2004).
+ */
+unsigned int 
+SpaceFillingCurve::getHilbertIndex(const unsigned int x,
+                                   const unsigned int y,
+                                   const unsigned int z)
+{
+   unsigned int X[3] = { x, y, z };
+   const unsigned int M = 1 << (BITS_PER_AXIS - 1);
+   
+   //
+   // Inverse undo excess work
+   //
+   for (unsigned int Q = M; Q > 1; Q >>= 1) {
+      const unsigned int P = Q - 1;
+      for (int i = 0; i < 3; i++) {
+         if (X[i] & Q) {
+            X[0] ^= P;
+         }
+         else {
+            const unsigned int t = (X[0] ^ X[i]) & P;
+            X[0] ^= t;
+            X[i] ^= t;
+         }
+      }
+   }
+   
+   //
+   // Gray encode
+   //
+   X[1] ^= X[0];
+   X[2] ^= X[1];
+   unsigned int t = 0;
+   for (unsigned int Q = M; Q > 1; Q >>= 1) {
+      if (X[2] & Q) {
+         t ^= Q - 1;
+      }
+   }
+   for (int i = 0; i < 3; i++) {
+      X[i] ^= t;
+   }
+   
+   //
+   // Interleave the transposed bits into the index
+   //
+   unsigned int index = 0;
+   for (int b = BITS_PER_AXIS - 1; b >= 0; b--) {
+      for (int i = 0; i < 3; i++) {
+         index = (index << 1) | ((X[i] >> b) & 1);
+      }
+   }
+   return index;
+}
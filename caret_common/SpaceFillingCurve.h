@@ -0,0 +1,73 @@
+
+#ifndef __SPACE_FILLING_CURVE_H__
+#define __SPACE_FILLING_CURVE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+/// Orders points along a space filling curve so that points that are near
+/// each other in space are also near each other in memory.
+class SpaceFillingCurve {
+   public:
+      /// get the order of points along a 3D Hilbert curve
+      static void getHilbertOrder(const float* xyz,
+                                  const int numberOfPoints,
+                                  std::vector<int>& orderOut);
+      
+      /// get the index of a point along a 3D Hilbert curve (coordinates 0 to 1023)
+      static unsigned int getHilbertIndex(const unsigned int x,
+                                          const unsigned int y,
+                                          const unsigned int z);
+      
+      /// number of bits used for each axis
+      static const int BITS_PER_AXIS = 10;
+      
+   protected:
+      /// used to sort points by their curve index
+      class CurvePoint {
+         public:
+            /// constructor
+            CurvePoint(const unsigned int curveIndexIn, const int pointIn)
+               : curveIndex(curveIndexIn), point(pointIn) { }
+            
+            /// less than operator (ties are kept in point order)
+            bool operator<(const CurvePoint& cp) const {
+               if (curveIndex == cp.curveIndex) {
+                  return (point < cp.point);
+               }
+               return (curveIndex < cp.curveIndex);
+            }
+            
+            /// index along the curve
+            unsigned int curveIndex;
+            
+            /// the point
+            int point;
+      };
+};
+
+#endif // __SPACE_FILLING_CURVE_H__
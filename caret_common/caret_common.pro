@@ -28,6 +28,7 @@ dll {
 
 # Input
 HEADERS += Basename.h \
+      BinaryCacheFile.h \
       CaretException.h \
       CaretLinkedList.h \
       CaretTips.h \
@@ -48,6 +49,7 @@ HEADERS += Basename.h \
       StatisticsUtilities.h \
       StringTable.h \
       Species.h \
+      SpaceFillingCurve.h \
       StereotaxicSpace.h \
 	   StringUtilities.h \
       Structure.h \
@@ -57,6 +59,7 @@ HEADERS += Basename.h \
     CaretVersion.h
 
 SOURCES += Basename.cxx \
+      BinaryCacheFile.cxx \
       CaretLinkedList.cxx \
       CaretTips.cxx \
       Category.cxx \
@@ -75,6 +78,7 @@ SOURCES += Basename.cxx \
       StatisticsUtilities.cxx \
       StringTable.cxx \
       Species.cxx \
+      SpaceFillingCurve.cxx \
       StereotaxicSpace.cxx \
 	   StringUtilities.cxx \
       Structure.cxx \
@@ -783,6 +783,9 @@ ArealEstimationFile::readFileDataVersion2(QFile& file, QTextStream& stream, QDat
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Reading Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -980,6 +983,9 @@ ArealEstimationFile::writeFileData(QTextStream& stream,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Writing Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -1215,6 +1215,30 @@ BorderProjectionFile::reverseOrderOfAllBorderProjections()
    setModified();
 }
       
+/**
+ * renumber the nodes used by the links (newNodeNumbers[old] = new).
+ */
+void 
+BorderProjectionFile::renumberNodes(const std::vector<int>& newNodeNumbers)
+{
+   const int numNewNodeNumbers = static_cast<int>(newNodeNumbers.size());
+   const int num = getNumberOfBorderProjections();
+   for (int i = 0; i < num; i++) {
+      BorderProjection* bp = getBorderProjection(i);
+      const int numLinks = bp->getNumberOfLinks();
+      for (int j = 0; j < numLinks; j++) {
+         BorderProjectionLink* bpl = bp->getBorderProjectionLink(j);
+         for (int k = 0; k < 3; k++) {
+            const int node = bpl->vertices[k];
+            if ((node >= 0) && (node < numNewNodeNumbers)) {
+               bpl->vertices[k] = newNodeNumbers[node];
+            }
+         }
+      }
+   }
+   setModified();
+}
+      
 /**
  * remove borders with the specified name.
  */
@@ -353,6 +353,9 @@ class BorderProjectionFile : public AbstractFile {
       /// reverse order of links in all border projections
       void reverseOrderOfAllBorderProjections();
       
+      /// renumber the nodes used by the links (newNodeNumbers[old] = new)
+      void renumberNodes(const std::vector<int>& newNodeNumbers);
+      
       /// read the file's data
       void readFileData(QFile& file, QTextStream& stream, QDataStream&,
                         QDomElement& /* rootElement */) throw (FileException);
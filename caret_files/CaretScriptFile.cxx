@@ -527,6 +527,9 @@ CaretScriptFile::readFileData(QFile& /*file*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:         
          throw FileException(filename, "Reading in Comma Separated Value File format not supported.");
          break;     
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -570,6 +573,9 @@ CaretScriptFile::writeFileData(QTextStream& /*stream*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Writing in Comma Separated Value File format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -1541,6 +1541,9 @@ CellFile::readFileData(QFile& file,
             readDataFromCommaSeparatedValuesTable(csvf);
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
    
    const int numCells = getNumberOfCells();
@@ -1607,6 +1610,9 @@ CellFile::writeFileData(QTextStream& stream,
             csvf.writeToTextStream(stream);
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
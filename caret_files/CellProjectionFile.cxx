@@ -1680,6 +1680,39 @@ CellProjectionFile::applyTransformationMatrix(const CoordinateFile* cf,
    setModified();
 }
 
+/**
+ * Renumber the nodes used by the projections (newNodeNumbers[old] = new).
+ */
+void 
+CellProjectionFile::renumberNodes(const std::vector<int>& newNodeNumbers)
+{
+   const int numNewNodeNumbers = static_cast<int>(newNodeNumbers.size());
+   const int num = getNumberOfCellProjections();
+   
+   for (int i = 0; i < num; i++) {
+      CellProjection* cp = getCellProjection(i);
+      for (int j = 0; j < 3; j++) {
+         const int node = cp->closestTileVertices[j];
+         if ((node >= 0) && (node < numNewNodeNumbers)) {
+            cp->closestTileVertices[j] = newNodeNumbers[node];
+         }
+      }
+      for (int k = 0; k < 2; k++) {
+         for (int j = 0; j < 3; j++) {
+            const int node = cp->triVertices[k][j];
+            if ((node >= 0) && (node < numNewNodeNumbers)) {
+               cp->triVertices[k][j] = newNodeNumbers[node];
+            }
+         }
+         const int node = cp->vertex[k];
+         if ((node >= 0) && (node < numNewNodeNumbers)) {
+            cp->vertex[k] = newNodeNumbers[node];
+         }
+      }
+   }
+   setModified();
+}
+
 
 /**
  * Add a cell projection to the file.
@@ -3853,6 +3886,9 @@ CellProjectionFile::readFileData(QFile& file, QTextStream& stream, QDataStream&,
             readDataFromCommaSeparatedValuesTable(csvf);
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
    
    const int numProj = getNumberOfCellProjections();
@@ -3925,6 +3961,9 @@ CellProjectionFile::writeFileData(QTextStream& stream, QDataStream&,
             csvf.writeToTextStream(stream);
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -402,6 +402,9 @@ class CellProjectionFile : public AbstractFile {
       //void applyTransformationMatrix(const TransformationMatrix& matrix,
       //                               const bool onlySpecialCells = false);
 
+      /// renumber the nodes used by the projections (newNodeNumbers[old] = new)
+      void renumberNodes(const std::vector<int>& newNodeNumbers);
+
       /// clear the file in memory
       void clear();
       
@@ -970,6 +970,9 @@ ColorFile::readFileData(QFile& file, QTextStream& stream, QDataStream&,
             readDataFromCommaSeparatedValuesTable(csvf);
          }  
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -1031,6 +1034,9 @@ ColorFile::writeFileData(QTextStream& stream, QDataStream&,
             csvf.writeToTextStream(stream);
          }  
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
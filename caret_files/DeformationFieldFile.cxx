@@ -594,6 +594,9 @@ DeformationFieldFile::readFileData(QFile& /*file*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Reading Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }         
 }
 
@@ -692,6 +695,9 @@ DeformationFieldFile::writeFileData(QTextStream& stream,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Writing Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
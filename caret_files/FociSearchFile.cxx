@@ -364,6 +364,9 @@ FociSearchFile::readFileData(QFile& /*file*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Reading in CSV format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -410,6 +413,9 @@ FociSearchFile::writeFileData(QTextStream& /*stream*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Writing in CSV format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
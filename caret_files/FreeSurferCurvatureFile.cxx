@@ -231,6 +231,9 @@ FreeSurferCurvatureFile::readFileData(QFile& file,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 
    //
@@ -204,6 +204,9 @@ FreeSurferFunctionalFile::readFileData(QFile& /*file*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Reading Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
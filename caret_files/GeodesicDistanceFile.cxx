@@ -24,9 +24,11 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <iostream>
 
 #include "GeodesicDistanceFile.h"
+#include "GeodesicHelper.h"
 #include "SpecFile.h"
 #include "StringUtilities.h"
 
@@ -42,6 +44,8 @@ GeodesicDistanceFile::GeodesicDistanceFile() :
                      FILE_IO_NONE, 
                      FILE_IO_NONE)
 {
+   allToAllGeodesicHelper = NULL;
+   allToAllSmoothFlag = false;
    clear();
 }
 
@@ -512,6 +516,9 @@ GeodesicDistanceFile::readFileData(QFile& /*file*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -538,6 +545,11 @@ GeodesicDistanceFile::writeFileData(QTextStream& stream,
    }
    stream << tagBeginData << "\n";
    
+   if (allToAllGeodesicHelper != NULL) {
+      writeAllToAllFileData(stream, binStream);
+      return;
+   }
+   
    switch (getFileWriteType()) {
       case FILE_FORMAT_ASCII:
          for (int j = 0; j < numCols; j++) {
@@ -596,5 +608,170 @@ GeodesicDistanceFile::writeFileData(QTextStream& stream,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
+   }
+}
+
+/**
+ * Receives rows of all to all geodesic distances and writes them to a 
+ * geodesic distance file.  Row "i" holds, for each root node (column), node 
+ * "i"'s parent toward the root and its distance to the root.
+ */
+class GeodesicDistanceFileRowWriter : public GeodesicHelper::RowConsumer {
+   public:
+      /// Constructor
+      GeodesicDistanceFileRowWriter(QTextStream& streamIn,
+                                    QDataStream& binStreamIn,
+                                    const bool binaryFlagIn,
+                                    const int numNodesIn)
+         : stream(streamIn), binStream(binStreamIn)
+      {
+         binaryFlag = binaryFlagIn;
+         numNodes = numNodesIn;
+      }
+      
+      /// write a block of rows
+      void processRows(const int firstRow, 
+                       const int numRows,
+                       const float* distsIn,
+                       const int* parentsIn)
+      {
+         for (int r = 0; r < numRows; r++) {
+            const float* dists = distsIn + static_cast<long long>(r) * numNodes;
+            const int* parents = parentsIn + static_cast<long long>(r) * numNodes;
+            if (binaryFlag) {
+               for (int j = 0; j < numNodes; j++) {
+                  binStream << parents[j]
+                            << dists[j];
+               }
+            }
+            else {
+               stream << (firstRow + r);
+               for (int j = 0; j < numNodes; j++) {
+                  stream << " "
+                         << parents[j] << " "
+                         << dists[j];
+               }
+               stream << "\n";
+            }
+         }
+      }
+      
+   protected:
+      /// text stream for ascii files
+      QTextStream& stream;
+      
+      /// data stream for binary files
+      QDataStream& binStream;
+      
+      /// writing binary file
+      bool binaryFlag;
+      
+      /// number of nodes
+      int numNodes;
+};
+
+/**
+ * write the geodesic distances from all nodes to all nodes to a file.  Column
+ * "j" has node "j" as its root.  Rows are computed a block of nodes at a time 
+ * and written as they are computed, so the N x N distances are never in 
+ * memory.  The file's data is cleared after writing.
+ */
+void 
+GeodesicDistanceFile::writeAllToAllFile(const QString& fileNameIn,
+                                        const GeodesicHelper& geodesicHelper,
+                                        const bool smoothFlag) throw (FileException)
+{
+   const int numNodes = geodesicHelper.getNumberOfNodes();
+   if (numNodes <= 0) {
+      throw FileException(fileNameIn, "Surface for geodesic distances contains no nodes.");
+   }
+   
+   //
+   // Only the columns' names and root nodes are stored
+   //
+   clear();
+   numberOfNodes = numNodes;
+   numberOfColumns = numNodes;
+   numberOfNodesColumnsChanged();
+   rootNode.resize(numberOfColumns);
+   for (int j = 0; j < numberOfColumns; j++) {
+      rootNode[j] = j;
+      columnNames[j] = "Node " + QString::number(j);
+   }
+   
+   allToAllGeodesicHelper = &geodesicHelper;
+   allToAllSmoothFlag = smoothFlag;
+   try {
+      writeFile(fileNameIn);
+   }
+   catch (FileException& e) {
+      allToAllGeodesicHelper = NULL;
+      clear();
+      throw e;
+   }
+   allToAllGeodesicHelper = NULL;
+   clear();
+}
+
+/**
+ * write the rows of an all to all file as they are computed.
+ */
+void 
+GeodesicDistanceFile::writeAllToAllFileData(QTextStream& stream,
+                                            QDataStream& binStream) throw (FileException)
+{
+   const int numNodes = getNumberOfNodes();
+   
+   bool binaryFlag = false;
+   switch (getFileWriteType()) {
+      case FILE_FORMAT_ASCII:
+         for (int j = 0; j < numNodes; j++) {
+            if (j > 0) {
+               stream << " ";
+            }
+            stream << rootNode[j];
+         }
+         stream << "\n";
+         break;
+      case FILE_FORMAT_BINARY:
+         setBinaryFilePosQT4Bug();
+         for (int j = 0; j < numNodes; j++) {
+            binStream << rootNode[j];
+         }
+         binaryFlag = true;
+         break;
+      case FILE_FORMAT_XML:
+      case FILE_FORMAT_XML_BASE64:
+      case FILE_FORMAT_XML_GZIP_BASE64:
+      case FILE_FORMAT_XML_EXTERNAL_BINARY:
+      case FILE_FORMAT_OTHER:
+      case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
+         throw FileException(filename, "All to all geodesic distances may only "
+                                       "be written in Ascii or Binary format.");
+         break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
+   }
+   
+   //
+   // About 64 megabytes of rows are computed at a time
+   //
+   const int rowsPerBlock = std::max(1, (8 * 1024 * 1024) / numNodes);
+   GeodesicDistanceFileRowWriter rowWriter(stream, binStream, binaryFlag, numNodes);
+   allToAllGeodesicHelper->getGeoAllToAllStreaming(&rowWriter, rowsPerBlock, allToAllSmoothFlag);
+   
+   if (binaryFlag) {
+      if (binStream.status() != QDataStream::Ok) {
+         throw FileException(filename, "Error writing geodesic distances.");
+      }
+   }
+   else {
+      if (stream.status() != QTextStream::Ok) {
+         throw FileException(filename, "Error writing geodesic distances.");
+      }
    }
 }
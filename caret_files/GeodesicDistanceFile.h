@@ -29,6 +29,8 @@
 
 #include "NodeAttributeFile.h"
 
+class GeodesicHelper;
+
 /// class for storing geodesic distance file
 class GeodesicDistanceFile : public NodeAttributeFile {
    public:
@@ -90,7 +92,17 @@ class GeodesicDistanceFile : public NodeAttributeFile {
       /// set the root node
       void setRootNode(const int columnNumber, const int node);
       
+      // write the geodesic distances from all nodes to all nodes to a file,
+      // computing them a block of nodes at a time instead of holding them in memory
+      void writeAllToAllFile(const QString& fileNameIn,
+                             const GeodesicHelper& geodesicHelper,
+                             const bool smoothFlag) throw (FileException);
+      
    protected:
+      // write the rows of an all to all file as they are computed
+      void writeAllToAllFileData(QTextStream& stream,
+                                 QDataStream& binStream) throw (FileException);
+      
       /// Read the contents of the file (header has already been read)
       void readFileData(QFile& file, 
                                 QTextStream& stream,
@@ -111,6 +123,12 @@ class GeodesicDistanceFile : public NodeAttributeFile {
       
       // distance to parent in path that leads to root node
       std::vector<float> nodeParentDistance;
+      
+      /// geodesic helper used while writing an all to all file (otherwise NULL)
+      const GeodesicHelper* allToAllGeodesicHelper;
+      
+      /// smooth flag used while writing an all to all file
+      bool allToAllSmoothFlag;
 };
 
 #endif // __GEODESIC_DISTANCE_FILE_H__
@@ -27,6 +27,7 @@
 #include "GeodesicHelper.h"
 #include "TopologyFile.h"
 #include "TopologyHelper.h"
+#include <algorithm>
 #include <iostream>
 #include <QMutexLocker>
 
@@ -778,3 +779,190 @@ void GeodesicHelper::getGeoToTheseNodes(const int root, const std::vector<int>&
       distsOut[i] = output[ofInterest[i]];
    }
 }
+
+void GeodesicHelper::dijkstra(Workspace& ws, const int* roots, const int numRoots, const float maxdist, bool smooth) const
+{//same as the cutoff dijkstra, but all scratch is in the workspace, so it can run in many threads at once
+   int i, j, k, whichnode, whichneigh, numNeigh;
+   int* neighbors;
+   float tempf, *mydists;
+   for (i = 0; i < numRoots; ++i)
+   {
+      whichnode = roots[i];
+      if (!(ws.marked[whichnode] & 4))
+      {
+         ws.output[whichnode] = 0.0f;
+         ws.marked[whichnode] |= 4;
+         ws.parent[whichnode] = whichnode;//idiom for end of path
+         ws.changed.push_back(whichnode);
+         ws.active.push(whichnode, 0.0f);
+      }
+   }
+   while (!ws.active.isEmpty())
+   {
+      whichnode = ws.active.pop();
+      if (!(ws.marked[whichnode] & 1))
+      {
+         ws.order.push_back(whichnode);
+         ws.marked[whichnode] |= 1;
+         for (k = 0; k < (smooth ? 2 : 1); ++k)
+         {//second pass is numNeighbors2, nodeNeighbors2, distance2
+            if (k == 0)
+            {
+               neighbors = nodeNeighbors[whichnode];
+               numNeigh = numNeighbors[whichnode];
+               mydists = distances[whichnode];
+            } else {
+               neighbors = nodeNeighbors2[whichnode];
+               numNeigh = numNeighbors2[whichnode];
+               mydists = distances2[whichnode];
+            }
+            for (j = 0; j < numNeigh; ++j)
+            {
+               whichneigh = neighbors[j];
+               if (!(ws.marked[whichneigh] & 1))
+               {//skip floating point math if marked
+                  tempf = ws.output[whichnode] + mydists[j];
+                  if (maxdist < 0.0f || tempf <= maxdist)
+                  {//keep it off the heap if it is too far
+                     if (!(ws.marked[whichneigh] & 4))
+                     {
+                        ws.parent[whichneigh] = whichnode;
+                        ws.marked[whichneigh] |= 4;
+                        ws.changed.push_back(whichneigh);
+                        ws.output[whichneigh] = tempf;
+                        ws.active.push(whichneigh, tempf);
+                     } else if (tempf < ws.output[whichneigh]) {
+                        ws.parent[whichneigh] = whichnode;
+                        ws.output[whichneigh] = tempf;
+                        ws.active.push(whichneigh, tempf);
+                     }
+                  }
+               }
+            }
+         }
+      }
+   }
+}
+
+void GeodesicHelper::getNodesToGeoDistBatch(const std::vector<int>& roots, const float maxdist, std::vector<std::vector<int> >& neighborsOut, std::vector<std::vector<float> >& distsOut, const bool smoothflag) const
+{
+   const int numRoots = (int)roots.size();
+   neighborsOut.resize(numRoots);
+   distsOut.resize(numRoots);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+   {
+      Workspace ws(numNodes);//each thread gets its own scratch space, the surface data is shared and read only
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+      for (int i = 0; i < numRoots; ++i)
+      {
+         std::vector<int>& nodes = neighborsOut[i];
+         std::vector<float>& dists = distsOut[i];
+         nodes.clear();
+         dists.clear();
+         const int root = roots[i];
+         if (root < 0 || root >= numNodes || maxdist < 0.0f) continue;//empty list is error condition
+         dijkstra(ws, &root, 1, maxdist, smoothflag);
+         const int numFound = (int)ws.order.size();
+         nodes.resize(numFound);
+         dists.resize(numFound);
+         for (int j = 0; j < numFound; ++j)
+         {
+            nodes[j] = ws.order[j];
+            dists[j] = ws.output[ws.order[j]];
+         }
+         ws.reset();
+      }
+   }
+}
+
+void GeodesicHelper::getGeoToNearestSeed(const std::vector<int>& seeds, float* valuesOut, int* nearestSeedOut, const bool smoothflag) const
+{
+   if (!valuesOut) return;
+   int i;
+   std::vector<int> validSeeds;
+   for (i = 0; i < (int)seeds.size(); ++i)
+   {
+      if (seeds[i] >= 0 && seeds[i] < numNodes) validSeeds.push_back(seeds[i]);
+   }
+   for (i = 0; i < numNodes; ++i)
+   {
+      valuesOut[i] = -1.0f;
+      if (nearestSeedOut) nearestSeedOut[i] = -1;
+   }
+   if (validSeeds.empty()) return;
+   Workspace ws(numNodes);
+   dijkstra(ws, &validSeeds[0], (int)validSeeds.size(), -1.0f, smoothflag);
+   const int numFound = (int)ws.order.size();
+   for (i = 0; i < numFound; ++i)
+   {//nodes are finalized after their parents, so the parent's seed is already known
+      const int node = ws.order[i];
+      valuesOut[node] = ws.output[node];
+      if (nearestSeedOut)
+      {
+         const int myparent = ws.parent[node];
+         nearestSeedOut[node] = (myparent == node) ? node : nearestSeedOut[myparent];
+      }
+   }
+}
+
+void GeodesicHelper::getGeoToNearestSeed(const std::vector<int>& seeds, std::vector<float>& valuesOut, std::vector<int>& nearestSeedOut, const bool smoothflag) const
+{
+   valuesOut.resize(numNodes);
+   nearestSeedOut.resize(numNodes);
+   if (numNodes == 0) return;
+   getGeoToNearestSeed(seeds, &valuesOut[0], &nearestSeedOut[0], smoothflag);
+}
+
+void GeodesicHelper::getGeoAllToAllStreaming(RowConsumer* consumer, const int rowsPerBlock, const bool smoothflag) const
+{//geodesic distance is symmetric, so the search from a root gives the row for that node, and only one block of rows is ever in memory
+   if (!consumer || numNodes == 0) return;
+   const int blockRows = (rowsPerBlock > 0) ? std::min(rowsPerBlock, numNodes) : 1;
+   std::vector<float> blockDists((long long)blockRows * numNodes);
+   std::vector<int> blockParents((long long)blockRows * numNodes);
+   for (int firstRow = 0; firstRow < numNodes; firstRow += blockRows)
+   {
+      const int numRows = std::min(blockRows, numNodes - firstRow);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+      {
+         Workspace ws(numNodes);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+         for (int r = 0; r < numRows; ++r)
+         {
+            const int root = firstRow + r;
+            float* rowDists = &blockDists[(long long)r * numNodes];
+            int* rowParents = &blockParents[(long long)r * numNodes];
+            for (int i = 0; i < numNodes; ++i)
+            {
+               rowDists[i] = -1.0f;
+               rowParents[i] = -1;
+            }
+            dijkstra(ws, &root, 1, -1.0f, smoothflag);
+            const int numFound = (int)ws.order.size();
+            for (int i = 0; i < numFound; ++i)
+            {//the first step from the root toward a node is inherited from the node's parent, which is finalized first
+               const int node = ws.order[i];
+               const int myparent = ws.parent[node];
+               rowDists[node] = ws.output[node];
+               if (node == root)
+               {
+                  rowParents[node] = root;
+               } else if (myparent == root) {
+                  rowParents[node] = node;
+               } else {
+                  rowParents[node] = rowParents[myparent];
+               }
+            }
+            ws.reset();
+         }
+      }
+      consumer->processRows(firstRow, numRows, &blockDists[0], &blockParents[0]);
+   }
+}
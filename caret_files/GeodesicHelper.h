@@ -89,6 +89,21 @@ class GeodesicHelper
       };
       inline void clear() { store.clear(); };
    };
+   /// scratch space for one run of dijkstra, the thread safe methods give each thread its own
+   struct Workspace
+   {
+      std::vector<float> output;
+      std::vector<int> marked, parent, changed, order;//order is the nodes in the order they were finalized
+      myheap active;
+      Workspace(const int numNodes) : output(numNodes), marked(numNodes, 0), parent(numNodes) { };
+      inline void reset()
+      {
+         for (int i = 0; i < (int)changed.size(); ++i) marked[changed[i]] = 0;//minimize reinitialization of arrays
+         changed.clear();
+         order.clear();
+         active.clear();
+      };
+   };
    float* output, **distances, **distances2;//use primitives for speed, and they don't need to change size
    int** nodeNeighbors, **nodeNeighbors2;//copy neighbors at constructor, because I don't want to mess with inheritance, and I want speed of repeated calls
    int* numNeighbors, *numNeighbors2, *marked, *changed, *parent;
@@ -98,13 +113,29 @@ class GeodesicHelper
    void dijkstra(const int root, bool smooth);//full surface
    void alltoall(float** out, int** parents, bool smooth);//must be fully allocated
    void dijkstra(const int root, const std::vector<int>& interested, bool smooth);//partial surface
+   void dijkstra(Workspace& ws, const int* roots, const int numRoots, const float maxdist, bool smooth) const;//multiple roots, maxdist < 0 for no cutoff, uses no member scratch
    QMutex inUse;
    static void crossProd(const float in1[3], const float in2[3], float out[3]);//DO NOT PASS AN INPUT AS OUT
    static float dotProd(const float in1[3], const float in2[3]);
    static float normalize(float in[3]);
    static void coordDiff(const float* coord1, const float* coord2, float out[3]);
 public:
+   /// Receives blocks of rows from getGeoAllToAllStreaming, rows are delivered in order, one block at a time
+   class RowConsumer
+   {
+   public:
+      virtual ~RowConsumer() { };
+      
+      /// row r of the block is the node firstRow + r, its values start at r * number of nodes
+      /// parents are the node next to the row's node on the path to each node (row's node for itself, -1 if unreachable)
+      virtual void processRows(const int firstRow, const int numRows, const float* distsIn, const int* parentsIn) = 0;
+   };
+   
    GeodesicHelper(const CoordinateFile* coordsIn, const TopologyFile* topoFileIn);
+   
+   /// Get the number of nodes in the surface
+   int getNumberOfNodes() const { return numNodes; }
+   
    ~GeodesicHelper() {
       if (marked) {
          delete[] output;
@@ -149,6 +180,18 @@ public:
    
    /// Get distances to a restricted set of nodes - output vector is in the SAME ORDER and same size as the input vector ofInterest
    void getGeoToTheseNodes(const int root, const std::vector<int>& ofInterest, std::vector<float>& distsOut, bool smoothflag = true);
+   
+   /// Get distances from many root nodes, up to a geodesic distance cutoff - roots are run in parallel, and this is safe to call from multiple threads
+   void getNodesToGeoDistBatch(const std::vector<int>& roots, const float maxdist, std::vector<std::vector<int> >& neighborsOut, std::vector<std::vector<float> >& distsOut, const bool smoothflag = true) const;
+   
+   /// Get distance from each node to the nearest seed node, with one multi-source search (thread safe), unreachable nodes get -1, allocate arrays first
+   void getGeoToNearestSeed(const std::vector<int>& seeds, float* valuesOut, int* nearestSeedOut = NULL, const bool smoothflag = true) const;
+   
+   /// Get distance from each node to the nearest seed node, vector method (thread safe)
+   void getGeoToNearestSeed(const std::vector<int>& seeds, std::vector<float>& valuesOut, std::vector<int>& nearestSeedOut, const bool smoothflag = true) const;
+   
+   /// Get distances from all nodes to all nodes without holding them all in memory, blocks of rows are computed in parallel and passed to the consumer
+   void getGeoAllToAllStreaming(RowConsumer* consumer, const int rowsPerBlock = 64, const bool smoothflag = true) const;
 };
 
 inline void GeodesicHelper::crossProd(const float in1[3], const float in2[3], float out[3])
@@ -55,6 +55,7 @@
 #include "StatisticNormalizeDistribution.h"
 #include "StatisticPermutation.h"
 #include "StatisticRandomNumber.h"
+#include "StatisticRandomNumberStream.h"
 #include "StringUtilities.h"
 #include "TopologyFile.h"
 #include "TopologyHelper.h"
@@ -76,6 +77,7 @@ MetricFile::MetricFile(const QString& descriptiveName,
                        FILE_IO_NONE,
                        FILE_IO_READ_AND_WRITE)
 {
+   setFileReadWriteType(FILE_FORMAT_COLUMNAR_BINARY, FILE_IO_READ_AND_WRITE);
    clear();
 }
 
@@ -98,6 +100,7 @@ MetricFile::MetricFile(const int initialNumberOfNodes,
                        FILE_IO_NONE,
                        FILE_IO_READ_AND_WRITE)
 {
+   setFileReadWriteType(FILE_FORMAT_COLUMNAR_BINARY, FILE_IO_READ_AND_WRITE);
    setNumberOfNodesAndColumns(initialNumberOfNodes, initialNumberOfColumns);
    for (int j = 0; j < initialNumberOfColumns; j++) {
       setColumnAllNodesToScalar(j, 0.0);
@@ -1335,6 +1338,9 @@ MetricFile::readMetricNodeData(QTextStream& stream, QDataStream& binStream) thro
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }         
    
    delete[] dataPtr;
@@ -2141,8 +2147,8 @@ MetricFile::getColumnForAllNodes(const int columnNumber,
       return;
    }
    values.resize(numberOfNodes);
-   for (int i = 0; i < numberOfNodes; i++) {
-      values[i] = getValue(i, columnNumber);
+   if (numberOfNodes > 0) {
+      getColumnForAllNodes(columnNumber, &values[0]);
    }
 }
 
@@ -2203,9 +2209,13 @@ MetricFile::getColumnForAllNodes(const int columnNumber,
                 << std::endl;
       return;
    }
-   for (int i = 0; i < numberOfNodes; i++) {
-      values[i] = getValue(i, columnNumber);
-   }
+   
+   //
+   // Copy directly from the column (touches only this column's
+   // pages when the file is memory mapped)
+   //
+   const float* data = dataArrays[columnNumber]->getDataPointerFloat();
+   std::copy(data, data + numberOfNodes, values);
 }
 
 /**
@@ -2720,6 +2730,9 @@ MetricFile::writeLegacyNodeFileData(QTextStream& stream, QDataStream& binStream)
          case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
             throw FileException(filename, "Comma Separated Value File Format not supported.");
             break;
+         case FILE_FORMAT_COLUMNAR_BINARY:
+            throw FileException(filename, "Columnar Binary File Format not supported.");
+            break;
       }
       delete[] dataPtr;
    }
@@ -3067,6 +3080,12 @@ MetricFile::computePermutedTValues(const float constant,
    float* values    = new float[numCols];
    float* oneColumn = new float[numNodes];
    
+   //
+   // Each iteration has its own random stream so its sign flips
+   // depend only upon the seed and the iteration
+   //
+   const unsigned int streamKey = StatisticRandomNumber::getStreamKey();
+   
    //
    // For the specified number of iterations
    //
@@ -3077,8 +3096,10 @@ MetricFile::computePermutedTValues(const float constant,
       for (int j = 0; j < numCols; j++) {
          signFlips[j] = 1.0;
       }
+      StatisticRandomNumberStream randomStream(streamKey, iter);
       StatisticDataGroup sdg(signFlips, numCols, StatisticDataGroup::DATA_STORAGE_MODE_POINT);
       StatisticPermutation permuteSigns(StatisticPermutation::PERMUTATION_METHOD_RANDOM_SIGN_FLIP);
+      permuteSigns.setRandomNumberStream(&randomStream);
       permuteSigns.addDataGroup(&sdg);
       try {
          permuteSigns.execute();
@@ -4075,6 +4096,12 @@ MetricFile::computeShuffledCrossCorrelationsMap(const int numberOfRepetitions) c
    metricOut->appendToFileComment("Shuffled cross-correlation maps of: ");
    metricOut->appendToFileComment(getFileComment());
    
+   //
+   // Each repetition has its own random stream so its columns
+   // depend only upon the seed and the repetition
+   //
+   const unsigned int streamKey = StatisticRandomNumber::getStreamKey();
+   
    //
    // Each column is the multiplication of two randomly selected columns of the input metric
    //
@@ -4087,10 +4114,11 @@ MetricFile::computeShuffledCrossCorrelationsMap(const int numberOfRepetitions) c
       //
       // Randomly select the columns
       //
-      const int col1 = StatisticRandomNumber::randomInteger(0, numberOfColumns - 1);
+      StatisticRandomNumberStream randomStream(streamKey, j);
+      const int col1 = randomStream.randomInteger(0, numberOfColumns - 1);
       int col2 = col1;
       while (col1 == col2) {
-         col2 = StatisticRandomNumber::randomInteger(0, numberOfColumns - 1);
+         col2 = randomStream.randomInteger(0, numberOfColumns - 1);
       }
       
       //
@@ -4289,6 +4317,12 @@ MetricFile::computeStatisticalShuffledTMap(const int numberOfRepetitions,
    file1.setNumberOfNodesAndColumns(numberOfNodes, numColumnsFile1);
    file2.setNumberOfNodesAndColumns(numberOfNodes, numColumnsFile2);
    
+   //
+   // Each repetition has its own random stream so its shuffle
+   // depends only upon the seed and the repetition
+   //
+   const unsigned int streamKey = StatisticRandomNumber::getStreamKey();
+   
    //
    // Do for the number of repetitions
    //
@@ -4314,7 +4348,9 @@ MetricFile::computeStatisticalShuffledTMap(const int numberOfRepetitions,
       //      
       StatisticDataGroup sdg(&columnsShuffledFloat, 
                              StatisticDataGroup::DATA_STORAGE_MODE_POINT);
+      StatisticRandomNumberStream randomStream(streamKey, nr);
       StatisticPermutation perm(StatisticPermutation::PERMUTATION_METHOD_RANDOM_ORDER);
+      perm.setRandomNumberStream(&randomStream);
       perm.addDataGroup(&sdg);
       try {
          perm.execute();
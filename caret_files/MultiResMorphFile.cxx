@@ -363,6 +363,9 @@ MultiResMorphFile::readFileData(QFile& file,
        case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
            throw FileException(filename, "Writing in CSV format not supported.");
           break;
+       case FILE_FORMAT_COLUMNAR_BINARY:
+          throw FileException(filename, "Columnar Binary File Format not supported.");
+          break;
     }
 }
 
@@ -427,6 +430,9 @@ MultiResMorphFile::writeFileData(QTextStream& stream,
        case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
            throw FileException(filename, "Writing in CSV format not supported.");
           break;
+       case FILE_FORMAT_COLUMNAR_BINARY:
+          throw FileException(filename, "Columnar Binary File Format not supported.");
+          break;
     }
 }
 
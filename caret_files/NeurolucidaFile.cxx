@@ -464,6 +464,9 @@ NeurolucidaFile::readFileData(QFile& /* file */,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException("Reading of Comma Separated Value File format Neurolucida files not supported..");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException("Columnar Binary File Format not supported.");
+         break;
    }
 }
 
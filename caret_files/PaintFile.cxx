@@ -24,6 +24,7 @@
 /*LICENSE_END*/
 
 #include <QDir>
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <sstream>
@@ -720,8 +721,7 @@ void PaintFile::getPaints(const int nodeNumber, int* paints) const
 {
    const int numberOfColumns = getNumberOfColumns();
    for (int i = 0; i < numberOfColumns; i++) {
-      int32_t* nodePaints = dataArrays[i]->getDataPointerInt();
-      paints[i] = nodePaints[nodeNumber];
+      paints[i] = dataArrays[i]->getDataInt32Element(nodeNumber);
    }
 }
 
@@ -732,12 +732,24 @@ int PaintFile::getPaint(const int nodeNumber, const int columnNumber) const
 {
    if ((columnNumber >= 0) &&
        (columnNumber < getNumberOfDataArrays())) {
-      int32_t* nodePaints = dataArrays[columnNumber]->getDataPointerInt();
-      return nodePaints[nodeNumber];
+      return dataArrays[columnNumber]->getDataInt32Element(nodeNumber);
    }
    return 0;
 }
 
+/**
+ * Get the paints for all nodes in a column.  User must allocate 
+ * "getNumberOfNodes" number of ints for second parameter.
+ */
+void 
+PaintFile::getPaintsForColumn(const int columnNumber, int* paints) const
+{
+   if ((columnNumber >= 0) &&
+       (columnNumber < getNumberOfDataArrays())) {
+      dataArrays[columnNumber]->getDataInt32Elements(paints);
+   }
+}
+
 /**
  * Set all of the paints for a node.
  */
@@ -746,8 +758,7 @@ PaintFile::setPaints(const int nodeNumber, const int* paints)
 {
    const int numberOfColumns = getNumberOfColumns();
    for (int i = 0; i < numberOfColumns; i++) {
-      int32_t* nodePaints = dataArrays[i]->getDataPointerInt();
-      nodePaints[nodeNumber] = paints[i];
+      dataArrays[i]->setDataInt32Element(nodeNumber, paints[i]);
    }
    setModified();
 }
@@ -761,12 +772,40 @@ PaintFile::setPaint(const int nodeNumber, const int columnNumber,
 {
    if ((columnNumber >= 0) &&
        (columnNumber < getNumberOfDataArrays())) {
-      int32_t* nodePaints = dataArrays[columnNumber]->getDataPointerInt();
-      nodePaints[nodeNumber] = paint;
+      dataArrays[columnNumber]->setDataInt32Element(nodeNumber, paint);
       setModified();
    }
 }
 
+/**
+ * Set the paints for all nodes in a column ("paints" contains 
+ * "getNumberOfNodes" ints).  The column is run length encoded
+ * if that uses much less memory.
+ */
+void 
+PaintFile::setPaintsForColumn(const int columnNumber, const int* paints)
+{
+   if ((columnNumber >= 0) &&
+       (columnNumber < getNumberOfDataArrays())) {
+      dataArrays[columnNumber]->setDataInt32Elements(paints);
+      dataArrays[columnNumber]->compressDataWithRunLengthEncoding();
+      setModified();
+   }
+}
+
+/**
+ * Run length encode the columns that are mostly the same paint
+ * (columns are expanded when a node's paint is changed).
+ */
+void 
+PaintFile::compressColumns()
+{
+   const int numberOfColumns = getNumberOfColumns();
+   for (int i = 0; i < numberOfColumns; i++) {
+      dataArrays[i]->compressDataWithRunLengthEncoding();
+   }
+}
+
 /**
  * copy one paint column to another.
  */
@@ -860,10 +899,13 @@ PaintFile::dilateColumn(const TopologyFile* tf,
    const TopologyHelper* th = tf->getTopologyHelper(false, true, false);
 
    //
-   // temporary and used to during dilation
+   // temporary and used to during dilation (the column is expanded
+   // only once so a run length encoded column stays compressed)
    //
    const int numNodes = getNumberOfNodes();
+   int* inputPaints = new int[numNodes];
    int* outputPaints = new int[numNodes];
+   getPaintsForColumn(columnNumber, outputPaints);
 
    //
    // Do for specified number of iterations
@@ -872,9 +914,7 @@ PaintFile::dilateColumn(const TopologyFile* tf,
       //
       // Copy current paints
       //
-      for (int i = 0; i < numNodes; i++) {
-         outputPaints[i] = getPaint(i, columnNumber);
-      }
+      std::copy(outputPaints, outputPaints + numNodes, inputPaints);
 
       //
       // Check each node
@@ -883,7 +923,7 @@ PaintFile::dilateColumn(const TopologyFile* tf,
          //
          // Dilate into neighboring nodes
          //
-         const int paintIndex = getPaint(i, columnNumber);
+         const int paintIndex = inputPaints[i];
          if (paintIndex != unassignedPaintIndex) {
             int numNeighbors;
             const int* neighbors = th->getNodeNeighbors(i, numNeighbors);
@@ -895,18 +935,19 @@ PaintFile::dilateColumn(const TopologyFile* tf,
             }
          }
       }
+   }
 
-      //
-      // Set current paints
-      //
-      for (int i = 0; i < numNodes; i++) {
-         setPaint(i, columnNumber, outputPaints[i]);
-      }
+   //
+   // Set the dilated paints
+   //
+   if (iterations > 0) {
+      setPaintsForColumn(columnNumber, outputPaints);
    }
 
    //
    // Free memory
    //
+   delete[] inputPaints;
    delete[] outputPaints;
 }
 
@@ -1516,6 +1557,9 @@ PaintFile::readPaintDataForNodes(const std::vector<int>& paintToPaintNameIndex,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
          
    delete[] cols;
@@ -1607,6 +1651,9 @@ PaintFile::writeLegacyNodeFileData(QTextStream& stream, QDataStream& binStream)
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 
    delete[] pti;
@@ -1908,5 +1955,10 @@ PaintFile::validateDataArrays() throw (FileException)
        }
    }
 
+   //
+   // Columns that are mostly one paint use less memory when run length encoded
+   //
+   this->compressColumns();
+   
    this->clearModified();
 }
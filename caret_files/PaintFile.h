@@ -93,6 +93,9 @@ class PaintFile : public GiftiNodeDataFile {
       // Clean up paint names (eliminate unused ones)
       void cleanUpPaintNames();
       
+      // run length encode the columns that are mostly the same paint
+      void compressColumns();
+      
       // clear contents of the current paint file
       void clear();
       
@@ -122,6 +125,9 @@ class PaintFile : public GiftiNodeDataFile {
       // get paint for a node and column
       int getPaint(const int nodeNumber, const int columnNumber) const;
       
+      // get the paints for all nodes in a column
+      void getPaintsForColumn(const int columnNumber, int* paints) const;
+      
       // find the column of the paint file containing geography
       int getGeographyColumnNumber() const;
                     
@@ -165,6 +171,9 @@ class PaintFile : public GiftiNodeDataFile {
       void setPaint(const int nodeNumber, const int columnNumber,
                     const int value);
                     
+      // set the paints for all nodes in a column
+      void setPaintsForColumn(const int columnNumber, const int* paints);
+                    
       // set the name of a paint at an index.
       void setPaintName(const int indexIn, const QString& name);
       
@@ -243,6 +243,9 @@ SegmentationMaskListFile::readFileData(QFile& file,
             readDataFromCommaSeparatedValuesTable(csvf);
          }     
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }      
    
    std::sort(masks.begin(), masks.end());
@@ -1688,6 +1688,9 @@ SpecFile::readFileData(QFile& /*file*/, QTextStream& stream, QDataStream&,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
    
    switch (sorting) {
@@ -1771,6 +1774,9 @@ SpecFile::writeFileData(QTextStream& stream, QDataStream&,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
    
    if (streamValid) stream << "\n";
@@ -1955,6 +1961,9 @@ SpecFile::writeFiles(QTextStream& stream,
                case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
                   throw FileException(filename, "Comma Separated Value File Format not supported.");
                   break;
+               case FILE_FORMAT_COLUMNAR_BINARY:
+                  throw FileException(filename, "Columnar Binary File Format not supported.");
+                  break;
             }
          }
       }
@@ -2027,6 +2036,9 @@ SpecFile::writeFiles(QTextStream& stream,
                case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
                   throw FileException(filename, "Comma Separated Value File Format not supported.");
                   break;
+               case FILE_FORMAT_COLUMNAR_BINARY:
+                  throw FileException(filename, "Columnar Binary File Format not supported.");
+                  break;
             }
          }
       }
@@ -2086,6 +2098,9 @@ SpecFile::writeFiles(QTextStream& stream,
                case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
                   throw FileException(filename, "Comma Separated Value File Format not supported.");
                   break;
+               case FILE_FORMAT_COLUMNAR_BINARY:
+                  throw FileException(filename, "Columnar Binary File Format not supported.");
+                  break;
             }
          }
       }
@@ -2143,6 +2158,9 @@ SpecFile::writeFiles(QTextStream& stream,
             case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
                throw FileException(filename, "Comma Separated Value File Format not supported.");
                break;
+            case FILE_FORMAT_COLUMNAR_BINARY:
+               throw FileException(filename, "Columnar Binary File Format not supported.");
+               break;
          }
       }
    }
@@ -3181,6 +3199,9 @@ SpecFile::Entry::writeFiles(QTextStream& stream,
             case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
                throw FileException("", "Comma Separated Value File Format not supported.");
                break;
+            case FILE_FORMAT_COLUMNAR_BINARY:
+               throw FileException(files[i].filename, "Columnar Binary File Format not supported.");
+               break;
          }
       }
    }
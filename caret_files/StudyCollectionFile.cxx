@@ -444,6 +444,9 @@ StudyCollectionFile::readFileData(QFile& file,
             readDataFromCommaSeparatedValuesTable(csvf);
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -549,6 +552,9 @@ StudyCollectionFile::writeFileData(QTextStream& /*stream*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Writing in CSVF format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
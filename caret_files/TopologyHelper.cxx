@@ -22,9 +22,6 @@
  *
  */
 /*LICENSE_END*/
-
-
-
 #include <QGlobalStatic>
 #ifdef Q_OS_WIN32
 #define NOMINMAX
@@ -62,6 +59,7 @@ TopologyHelper::TopologyHelper(const TopologyFile* tf,
                                const bool buildNodeInfo,
                                const bool sortNodeInfo)
 {
+   numberOfNodes = 0;
    nodeSortedInfoBuilt = false;
    nodeInfoBuilt       = false;
    edgeInfoBuilt = false;
@@ -70,19 +68,17 @@ TopologyHelper::TopologyHelper(const TopologyFile* tf,
    if (numTiles <= 0) {
       return;
    }
+   const int* tileNodes = tf->getTile(0);
    
    if (buildNodeInfo) {
       int maxNodeNum = -1;
    
-         //
+      //
       // Get the number of nodes
       //
-      for (int j = 0; j < numTiles; j++) {
-         int n1, n2, n3;
-         tf->getTile(j, n1, n2, n3);
-         if (n1 > maxNodeNum) maxNodeNum = n1;
-         if (n2 > maxNodeNum) maxNodeNum = n2;
-         if (n3 > maxNodeNum) maxNodeNum = n3;
+      const int numTileNodes = numTiles * 3;
+      for (int j = 0; j < numTileNodes; j++) {
+         if (tileNodes[j] > maxNodeNum) maxNodeNum = tileNodes[j];
       }
       
       //
@@ -93,62 +89,10 @@ TopologyHelper::TopologyHelper(const TopologyFile* tf,
       //
       // There may be nodes that have been disconnected and not associated with any tiles
       //
-      maxNodeNum = std::max(maxNodeNum, tf->getNumberOfNodes());
-      
-      //
-      // Initialize the node structures
-      //
-      nodes.reserve(maxNodeNum);
-      for (int i = 0; i < maxNodeNum; i++) {
-         nodes.push_back(NodeInfo(i));
-      }
+      numberOfNodes = std::max(maxNodeNum, tf->getNumberOfNodes());
    }
    
-   //
-   // Keep track of the tiles
-   //
-   for (int j = 0; j < numTiles; j++) {
-      int n1, n2, n3;
-      tf->getTile(j, n1, n2, n3);
-      if (buildNodeInfo) {
-         if (sortNodeInfo) {
-            nodes[n1].addNeighbors(j, n2, n3);
-            nodes[n2].addNeighbors(j, n3, n1);
-            nodes[n3].addNeighbors(j, n1, n2);
-         }
-         else {
-            nodes[n1].addNeighbor(n2);
-            nodes[n1].addNeighbor(n3);
-            nodes[n2].addNeighbor(n1);
-            nodes[n2].addNeighbor(n3);
-            nodes[n3].addNeighbor(n1);
-            nodes[n3].addNeighbor(n2);
-            nodes[n1].addTile(j);
-            nodes[n2].addTile(j);
-            nodes[n3].addTile(j);
-         }
-      }
-      
-      if (buildEdgeInfo) {
-         addEdgeInfo(j, n1, n2);
-         addEdgeInfo(j, n2, n3);
-         addEdgeInfo(j, n3, n1);
-      }
-   }
-
-   if (buildEdgeInfo) {
-      edgeInfoBuilt = true;
-   }
-   
-   if (buildNodeInfo) {
-      nodeInfoBuilt = true;
-      if (sortNodeInfo) {
-         nodeSortedInfoBuilt = true;
-         for (unsigned int k = 0; k < nodes.size(); k++) {
-            nodes[k].sortNeighbors();
-         }
-      }
-   }
+   buildTopology(tileNodes, numTiles, buildEdgeInfo, buildNodeInfo, sortNodeInfo);
 }
 
 /**
@@ -176,98 +120,47 @@ TopologyHelper::TopologyHelper(vtkPolyData* vtkIn,
       vtk = triangleFilter->GetOutput();
    }
 
+   numberOfNodes = 0;
    nodeSortedInfoBuilt = false;
    nodeInfoBuilt       = false;
    edgeInfoBuilt = false;
    
-   //const int numTiles = tf->getNumberOfTiles();
-   //if (numTiles <= 0) {
-   //   return;
-  // }
-   
-   if (buildNodeInfo) {
-      vtkCellArray* polys = vtk->GetPolys();
-      vtkIdType npts;
-      vtkIdType* pts;
-      const int maxNodeNum = vtk->GetNumberOfPoints();  //-1;
-      for (polys->InitTraversal(); polys->GetNextCell(npts,pts); ) {
-         if (npts != 3) {
-            std::cerr << " Polygon is not a triangle in TopologyHelper, ignored"      
-                      << std::endl;
-         }
-         //maxNodeNum = std::max(pts[0], maxNodeNum);
-         //maxNodeNum = std::max(pts[1], maxNodeNum);
-         //maxNodeNum = std::max(pts[2], maxNodeNum);
-      }
-      
-      //
-      // Node indices start at zero so need to increment
-      //
-      //maxNodeNum++; 
-      
-      //
-      // Initialize the node structures
-      //
-      for (int i = 0; i < maxNodeNum; i++) {
-         nodes.push_back(NodeInfo(i));
-      }
-   }
-   
    //
-   // Keep track of the tiles
+   // Get the nodes of the tiles
    //
+   std::vector<int> tileNodes;
    vtkCellArray* polys = vtk->GetPolys();
-   int cellId = 0;
+   tileNodes.reserve(polys->GetNumberOfCells() * 3);
    vtkIdType npts;
    vtkIdType* pts;
-   for (polys->InitTraversal(); polys->GetNextCell(npts,pts); cellId++) {
+   for (polys->InitTraversal(); polys->GetNextCell(npts,pts); ) {
       if (npts != 3) {
          std::cerr << " Polygon is not a triangle in TopologyHelper"      
                      << std::endl;
-         return;
-      }
-      int n1 = pts[0];
-      int n2 = pts[1];
-      int n3 = pts[2];
-      if (buildNodeInfo) {
-         if (sortNodeInfo) {
-            nodes[n1].addNeighbors(cellId, n2, n3);
-            nodes[n2].addNeighbors(cellId, n3, n1);
-            nodes[n3].addNeighbors(cellId, n1, n2);
+         if (triangleFilter != NULL) {
+            triangleFilter->Delete();
          }
-         else {
-            nodes[n1].addNeighbor(n2);
-            nodes[n1].addNeighbor(n3);
-            nodes[n2].addNeighbor(n1);
-            nodes[n2].addNeighbor(n3);
-            nodes[n3].addNeighbor(n1);
-            nodes[n3].addNeighbor(n2);
-            nodes[n1].addTile(cellId);
-            nodes[n2].addTile(cellId);
-            nodes[n3].addTile(cellId);
-         }
-      }
-      
-      if (buildEdgeInfo) {
-         addEdgeInfo(cellId, n1, n2);
-         addEdgeInfo(cellId, n2, n3);
-         addEdgeInfo(cellId, n3, n1);
+         return;
       }
-   }
-
-   if (buildEdgeInfo) {
-      edgeInfoBuilt = true;
+      tileNodes.push_back(pts[0]);
+      tileNodes.push_back(pts[1]);
+      tileNodes.push_back(pts[2]);
    }
    
    if (buildNodeInfo) {
-      nodeInfoBuilt = true;
-      if (sortNodeInfo) {
-         nodeSortedInfoBuilt = true;
-         for (unsigned int k = 0; k < nodes.size(); k++) {
-            nodes[k].sortNeighbors();
-         }
-      }
+      numberOfNodes = vtk->GetNumberOfPoints();
+   }
+   
+   if (triangleFilter != NULL) {
+      triangleFilter->Delete();
    }
+   
+   const int numTiles = static_cast<int>(tileNodes.size() / 3);
+   buildTopology((numTiles > 0) ? &tileNodes[0] : NULL, 
+                 numTiles, 
+                 buildEdgeInfo, 
+                 buildNodeInfo, 
+                 sortNodeInfo);
 }
 
 /**
@@ -275,128 +168,353 @@ TopologyHelper::TopologyHelper(vtkPolyData* vtkIn,
  */
 TopologyHelper::~TopologyHelper()
 {
-   nodes.clear();
+   for (unsigned int i = 0; i < depthSearchScratchPool.size(); i++) {
+      delete depthSearchScratchPool[i];
+   }
+   depthSearchScratchPool.clear();
    topologyEdges.clear();
 }
 
 /**
- * Keep track of edges
+ * build the node and edge information from the tiles' nodes.
  */
-void
-TopologyHelper::addEdgeInfo(const int tileNum, const int node1, const int node2)
+void 
+TopologyHelper::buildTopology(const int* tileNodes,
+                              const int numTiles,
+                              const bool buildEdgeInfoFlag,
+                              const bool buildNodeInfoFlag,
+                              const bool sortNodeInfo)
 {
-   TopologyEdgeInfo edge(tileNum, node1, node2);
-   
-   std::set<TopologyEdgeInfo>::iterator iter = topologyEdges.find(edge);
-   if (iter == topologyEdges.end()) {
-      topologyEdges.insert(edge);
+   if (buildNodeInfoFlag) {
+      buildNodeInfo(tileNodes, numTiles, sortNodeInfo);
+      nodeInfoBuilt = true;
+      nodeSortedInfoBuilt = sortNodeInfo;
    }
-   else {
-      TopologyEdgeInfo& e = (TopologyEdgeInfo&)(*iter);
-      e.addTile(tileNum);
-      //iter->addTile(tileNum);
+   
+   if (buildEdgeInfoFlag) {
+      buildEdgeInfo(tileNodes, numTiles);
+      edgeInfoBuilt = true;
    }
 }
 
 /**
- * Sort a nodes neighbors
+ * build the neighbors and tiles of each node.  Each tile contributes a 
+ * "corner" (tile number * 3 + index of node in tile) to each of its nodes.
+ * The neighbors and tiles of each node are then found from its corners
+ * independently of all other nodes.
  */
 void 
-TopologyHelper::NodeInfo::sortNeighbors() 
+TopologyHelper::buildNodeInfo(const int* tileNodes,
+                              const int numTiles,
+                              const bool sortNodeInfo)
 {
-   if ((edges.size() > 0) && sortMe) {
+   const int numNodes = numberOfNodes;
+   const int numCorners = numTiles * 3;
+   
+   //
+   // Group the corners by node keeping them in tile order
+   //
+   std::vector<int> cornerOffsets(numNodes + 1, 0);
+   for (int c = 0; c < numCorners; c++) {
+      cornerOffsets[tileNodes[c] + 1]++;
+   }
+   for (int i = 0; i < numNodes; i++) {
+      cornerOffsets[i + 1] += cornerOffsets[i];
+   }
+   std::vector<int> nodeCorners(std::max(numCorners, 1));
+   {
+      std::vector<int> cornerPosition(cornerOffsets.begin(), cornerOffsets.end() - 1);
+      for (int c = 0; c < numCorners; c++) {
+         nodeCorners[cornerPosition[tileNodes[c]]++] = c;
+      }
+   }
+   
+   neighborOffsets.resize(numNodes + 1);
+   neighborOffsets[0] = 0;
+   
+   if (sortNodeInfo == false) {
       //
-      // Nodes that are on the edge (boundary) of a cut surface must be treated specially when sorting.
-      // In this case the sorting needs to start with the link whose first node is not used
-      // in any other link.  This is true if all tiles are consistently oriented (and they
-      // must be).
+      // Tiles are all of the node's corners in tile order
       //
-      int startEdge = -1;
-      for (unsigned int k = 0; k < edges.size(); k++) {
-         const int nodeNum = edges[k].node1;
-         bool foundNode = false;
-         
-         //
-         // See if nodeNum is used in any other edges
-         //
-         for (unsigned int m = 0; m < edges.size(); m++) {
-            if (m != k) {
-               if (edges[m].containsNode(nodeNum) == true) {
-                  foundNode = true;
-                  break;
+      tileOffsets = cornerOffsets;
+      tileIndices.resize(numCorners);
+      for (int c = 0; c < numCorners; c++) {
+         tileIndices[c] = nodeCorners[c] / 3;
+      }
+      
+      //
+      // Unique neighbors in the order first found.  A node has at most
+      // two neighbors for each of its corners.
+      //
+      std::vector<int> neighborsScratch(std::max(numCorners * 2, 1));
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+      for (int i = 0; i < numNodes; i++) {
+         int* neighbors = &neighborsScratch[0] + cornerOffsets[i] * 2;
+         int numNeighbors = 0;
+         for (int k = cornerOffsets[i]; k < cornerOffsets[i + 1]; k++) {
+            const int c = nodeCorners[k];
+            const int* tile = &tileNodes[c - (c % 3)];
+            for (int m = 0; m < 3; m++) {
+               if (m != (c % 3)) {
+                  const int n = tile[m];
+                  bool found = false;
+                  for (int j = 0; j < numNeighbors; j++) {
+                     if (neighbors[j] == n) {
+                        found = true;
+                        break;
+                     }
+                  }
+                  if (found == false) {
+                     neighbors[numNeighbors] = n;
+                     numNeighbors++;
+                  }
                }
             }
          }
-         
-         if (foundNode == false) {
-            if (startEdge >= 0) {
-               //std::cerr << "INFO: multiple starting edges for node " << nodeNumber << std::endl;
-            }
-            else {
-               startEdge = k;
-            }
-         }
+         neighborOffsets[i + 1] = numNeighbors;
       }
       
-      bool flag = false;
-      if ((nodeNumber >= 44508) && (nodeNumber <= 44507)) { // modify for debugging
-         std::cerr << "Start Edge for node " << nodeNumber << " is " << startEdge << std::endl;
-         for (unsigned int k = 0; k < edges.size(); k++) {
-            std::cerr << "   " << edges[k].node1 << " " << edges[k].node2 << std::endl;
-         }
-         flag = true;
+      for (int i = 0; i < numNodes; i++) {
+         neighborOffsets[i + 1] += neighborOffsets[i];
       }
-
-      // startEdge is less than zero if the node's links are all interior links 
-      if (startEdge < 0) {
-         startEdge = 0;
+      neighborIndices.resize(neighborOffsets[numNodes]);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+      for (int i = 0; i < numNodes; i++) {
+         const int* neighbors = &neighborsScratch[0] + cornerOffsets[i] * 2;
+         std::copy(neighbors,
+                   neighbors + (neighborOffsets[i + 1] - neighborOffsets[i]),
+                   neighborIndices.begin() + neighborOffsets[i]);
+      }
+   }
+   else {
+      //
+      // Neighbors and tiles sorted around each node.  A node has at most
+      // one more neighbor than corners and at most one tile per corner.
+      //
+      std::vector<int> neighborsScratch(std::max(numCorners + numNodes, 1));
+      std::vector<int> tilesScratch(std::max(numCorners, 1));
+      tileOffsets.resize(numNodes + 1);
+      tileOffsets[0] = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+      for (int i = 0; i < numNodes; i++) {
+         int numTilesForNode = 0;
+         neighborOffsets[i + 1] = 
+            sortNodeNeighbors(tileNodes,
+                              &nodeCorners[0] + cornerOffsets[i],
+                              cornerOffsets[i + 1] - cornerOffsets[i],
+                              &neighborsScratch[0] + cornerOffsets[i] + i,
+                              &tilesScratch[0] + cornerOffsets[i],
+                              numTilesForNode);
+         tileOffsets[i + 1] = numTilesForNode;
       }
       
-      int currentNode  = edges[startEdge].node1;
-      int nextNeighbor = edges[startEdge].node2;
-      neighbors.push_back(currentNode);
-      tiles.push_back(edges[startEdge].tileNumber);
-      const int firstNode = currentNode;
+      for (int i = 0; i < numNodes; i++) {
+         neighborOffsets[i + 1] += neighborOffsets[i];
+         tileOffsets[i + 1] += tileOffsets[i];
+      }
+      neighborIndices.resize(neighborOffsets[numNodes]);
+      tileIndices.resize(tileOffsets[numNodes]);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+      for (int i = 0; i < numNodes; i++) {
+         const int* neighbors = &neighborsScratch[0] + cornerOffsets[i] + i;
+         std::copy(neighbors,
+                   neighbors + (neighborOffsets[i + 1] - neighborOffsets[i]),
+                   neighborIndices.begin() + neighborOffsets[i]);
+         const int* tiles = &tilesScratch[0] + cornerOffsets[i];
+         std::copy(tiles,
+                   tiles + (tileOffsets[i + 1] - tileOffsets[i]),
+                   tileIndices.begin() + tileOffsets[i]);
+      }
+   }
+}
+
+/**
+ * Sort a node's neighbors and tiles around the node.  Each of the node's corners
+ * forms an edge with the other two nodes in the tile that are in the same 
+ * orientation as the tile.
+ */
+int 
+TopologyHelper::sortNodeNeighbors(const int* tileNodes,
+                                  const int* nodeCorners,
+                                  const int numCorners,
+                                  int* neighborsOut,
+                                  int* tilesOut,
+                                  int& numTilesOut)
+{
+   numTilesOut = 0;
+   if (numCorners <= 0) {
+      return 0;
+   }
+   
+#define EDGE_NODE1(k) (tileNodes[nodeCorners[k] - (nodeCorners[k] % 3) + ((nodeCorners[k] + 1) % 3)])
+#define EDGE_NODE2(k) (tileNodes[nodeCorners[k] - (nodeCorners[k] % 3) + ((nodeCorners[k] + 2) % 3)])
+#define EDGE_TILE(k)  (nodeCorners[k] / 3)
+   
+   //
+   // Nodes that are on the edge (boundary) of a cut surface must be treated specially when sorting.
+   // In this case the sorting needs to start with the link whose first node is not used
+   // in any other link.  This is true if all tiles are consistently oriented (and they
+   // must be).
+   //
+   int startEdge = -1;
+   for (int k = 0; k < numCorners; k++) {
+      const int nodeNum = EDGE_NODE1(k);
+      bool foundNode = false;
       
-      for (unsigned int i = 1; i < edges.size(); i++) {
-         neighbors.push_back(nextNeighbor);
-         // find edge with node "nextNeighbor" but without node "currentNode"
-         const NodeEdgeInfo* e = findEdgeWithPoint(nextNeighbor, currentNode);
-         if (e != NULL) {
-            tiles.push_back(e->tileNumber);
-            currentNode = nextNeighbor;
-            nextNeighbor = e->getOtherNode(nextNeighbor);
-            if (nextNeighbor < 0) {
-               //std::cerr << "INFO: Unable to find neighbor of"
-               //            <<  nextNeighbor << std::endl;
+      //
+      // See if nodeNum is used in any other edges
+      //
+      for (int m = 0; m < numCorners; m++) {
+         if (m != k) {
+            if ((EDGE_NODE1(m) == nodeNum) ||
+                (EDGE_NODE2(m) == nodeNum)) {
+               foundNode = true;
+               break;
             }
          }
-         else {
-            nextNeighbor = -1;
-            //std::cerr << "INFO: Unable to find edge for for node " 
-            //            << nodeNumber << std::endl;
-            break;
-         }
       }
       
-      if ((nextNeighbor != firstNode) && (nextNeighbor >= 0)) {
-         neighbors.push_back(nextNeighbor);
+      if (foundNode == false) {
+         startEdge = k;
+         break;
       }
+   }
+   
+   // startEdge is less than zero if the node's links are all interior links 
+   if (startEdge < 0) {
+      startEdge = 0;
+   }
+   
+   int numNeighbors = 0;
+   int currentNode  = EDGE_NODE1(startEdge);
+   int nextNeighbor = EDGE_NODE2(startEdge);
+   neighborsOut[numNeighbors++] = currentNode;
+   tilesOut[numTilesOut++] = EDGE_TILE(startEdge);
+   const int firstNode = currentNode;
+   
+   for (int i = 1; i < numCorners; i++) {
+      neighborsOut[numNeighbors++] = nextNeighbor;
       
-      if (flag) {
-         std::cerr << "Node " << nodeNumber << " neighbors: ";
-         for (unsigned int n = 0; n < neighbors.size(); n++) {
-            std::cerr << "  " << neighbors[n];
+      // find edge with node "nextNeighbor" but without node "currentNode"
+      int edgeFound = -1;
+      for (int m = 0; m < numCorners; m++) {
+         const int n1 = EDGE_NODE1(m);
+         const int n2 = EDGE_NODE2(m);
+         if (((n1 == nextNeighbor) && (n2 != currentNode)) ||
+             ((n2 == nextNeighbor) && (n1 != currentNode))) {
+            edgeFound = m;
+            break;
          }
-         std::cerr << std::endl;
-         std::cerr << "Node " << nodeNumber << " tiles: ";
-         for (unsigned int n = 0; n < tiles.size(); n++) {
-            std::cerr << "  " << tiles[n];
+      }
+      
+      if (edgeFound >= 0) {
+         tilesOut[numTilesOut++] = EDGE_TILE(edgeFound);
+         currentNode = nextNeighbor;
+         if (EDGE_NODE1(edgeFound) == nextNeighbor) {
+            nextNeighbor = EDGE_NODE2(edgeFound);
          }
-         std::cerr << std::endl;
+         else {
+            nextNeighbor = EDGE_NODE1(edgeFound);
+         }
+      }
+      else {
+         nextNeighbor = -1;
+         break;
+      }
+   }
+   
+   if ((nextNeighbor != firstNode) && (nextNeighbor >= 0)) {
+      neighborsOut[numNeighbors++] = nextNeighbor;
+   }
+   
+#undef EDGE_NODE1
+#undef EDGE_NODE2
+#undef EDGE_TILE
+
+   return numNeighbors;
+}
+
+/**
+ * build the edge information.  All edges are sorted so that each
+ * edge is inserted at the end of the edge set.
+ */
+void 
+TopologyHelper::buildEdgeInfo(const int* tileNodes,
+                              const int numTiles)
+{
+   //
+   // Each of a tile's edges is (larger node, smaller node, tile edge index)
+   // and sorting keeps the tiles using an edge in tile order
+   //
+   const int numTileEdges = numTiles * 3;
+   std::vector<std::pair<std::pair<int, int>, int> > tileEdges(numTileEdges);
+   for (int j = 0; j < numTiles; j++) {
+      for (int k = 0; k < 3; k++) {
+         const int n1 = tileNodes[j * 3 + k];
+         const int n2 = tileNodes[j * 3 + ((k + 1) % 3)];
+         tileEdges[j * 3 + k] = std::make_pair(std::make_pair(std::max(n1, n2), 
+                                                              std::min(n1, n2)),
+                                               j * 3 + k);
+      }
+   }
+   std::sort(tileEdges.begin(), tileEdges.end());
+   
+   int i = 0;
+   while (i < numTileEdges) {
+      const std::pair<int, int>& nodes = tileEdges[i].first;
+      TopologyEdgeInfo edge(tileEdges[i].second / 3, nodes.first, nodes.second);
+      i++;
+      while ((i < numTileEdges) &&
+             (tileEdges[i].first == nodes)) {
+         edge.addTile(tileEdges[i].second / 3);
+         i++;
+      }
+      topologyEdges.insert(topologyEdges.end(), edge);
+   }
+}
+
+/**
+ * get scratch space for a search to depth.  The scratch space is not shared
+ * so that threads may search at the same time.
+ */
+TopologyHelper::DepthSearchScratch* 
+TopologyHelper::acquireDepthSearchScratch() const
+{
+   DepthSearchScratch* scratch = NULL;
+   {
+      QMutexLocker locked(&depthSearchScratchPoolMutex);
+      if (depthSearchScratchPool.empty() == false) {
+         scratch = depthSearchScratchPool.back();
+         depthSearchScratchPool.pop_back();
       }
    }
-   edges.clear();
+   if (scratch == NULL) {
+      scratch = new DepthSearchScratch;
+   }
+   
+   const int numNodes = getNumberOfNodes();
+   if (static_cast<int>(scratch->markNodes.size()) != numNodes) {
+      scratch->markNodes.assign(numNodes, 0);
+   }
+   return scratch;
+}
+
+/**
+ * return scratch space for a search to depth.
+ */
+void 
+TopologyHelper::releaseDepthSearchScratch(DepthSearchScratch* scratch) const
+{
+   QMutexLocker locked(&depthSearchScratchPoolMutex);
+   depthSearchScratchPool.push_back(scratch);
 }
 
 /**
@@ -405,8 +523,8 @@ TopologyHelper::NodeInfo::sortNeighbors()
 bool
 TopologyHelper::getNodeHasNeighbors(const int nodeNum) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      return (nodes[nodeNum].neighbors.empty() == false);
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      return (neighborOffsets[nodeNum + 1] > neighborOffsets[nodeNum]);
    }
    return false;
 }
@@ -417,8 +535,8 @@ TopologyHelper::getNodeHasNeighbors(const int nodeNum) const
 int 
 TopologyHelper::getNodeNumberOfNeighbors(const int nodeNum) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      return nodes[nodeNum].neighbors.size();
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      return (neighborOffsets[nodeNum + 1] - neighborOffsets[nodeNum]);
    }
    return 0;
 }
@@ -470,10 +588,10 @@ TopologyHelper::getNumberOfBoundaryEdgesForAllNodes(std::vector<int>& numBoundar
 int
 TopologyHelper::getMaximumNumberOfNeighbors() const
 {
-   unsigned int maxNeighbors = 0;
+   int maxNeighbors = 0;
    int numNodes = getNumberOfNodes();
    for (int i = 0; i < numNodes; i++) {
-      const unsigned int num = nodes[i].neighbors.size();
+      const int num = neighborOffsets[i + 1] - neighborOffsets[i];
       if (num > maxNeighbors) {
          maxNeighbors = num;
       }
@@ -488,8 +606,9 @@ void
 TopologyHelper::getNodeNeighbors(const int nodeNum,
                                  std::vector<int>& neighborsOut) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      neighborsOut = nodes[nodeNum].neighbors;
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      neighborsOut.assign(neighborIndices.begin() + neighborOffsets[nodeNum],
+                          neighborIndices.begin() + neighborOffsets[nodeNum + 1]);
    }
    else {
       neighborsOut.clear();
@@ -503,45 +622,15 @@ void
 TopologyHelper::getNodeNeighborsInROI(const int nodeNum,
                                  std::vector<int>& neighborsOut, const float *roiValues) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      //Since we are restricting to an roi, we need to make sure that the neighbors are within the ROI, and
-      //if not, build a new neighbor list
-      std::vector<int> neighbors = nodes[nodeNum].neighbors;
-      //optimization, first, loop through and see any neighbors are outside the roi
-      bool neighborOutsideOfRoi = false;
-      for(int i = 0;i<neighbors.size();i++)
-      {
-         if(roiValues[neighbors[i]] == 0.0)
-         {
-            neighborOutsideOfRoi = true;
-            break;
-         }
-      }
-
-      if(!neighborOutsideOfRoi)
-      {
-         neighborsOut = nodes[nodeNum].neighbors;
-      }
-      else
-      {
-         neighborsOut.clear();
-
-         for(int i = 0;i<neighbors.size();i++)
-         {
-            if(roiValues[neighbors[i]] == 0.0)//filter out neighbors that are outside of ROI
-            {
-               continue;
-            }
-            else
-            {
-               neighborsOut.push_back(neighbors[i]);
-            }
-         }
+   neighborsOut.clear();
+   
+   int numNeighbors = 0;
+   const int* neighbors = getNodeNeighbors(nodeNum, numNeighbors);
+   for (int i = 0; i < numNeighbors; i++) {
+      if (roiValues[neighbors[i]] != 0.0) {//filter out neighbors that are outside of ROI
+         neighborsOut.push_back(neighbors[i]);
       }
    }
-   else {
-      neighborsOut.clear();
-   }
 }
 
 /**
@@ -557,21 +646,15 @@ TopologyHelper::getNodeNeighborsToDepthIter(const int rootNode,
       getNodeNeighbors(rootNode, neighborsOut);
       return;
    }
-   QMutexLocker locked(&usingMarkNodes);//lock after choosing which version to use, because they are both public
+   DepthSearchScratch* scratch = acquireDepthSearchScratch();//each concurrent search uses its own scratch space
+   std::vector<int>& markNodes = scratch->markNodes;
+   std::vector<int>* nodelist = scratch->nodelist;
    int i, j, k;
    neighborsOut.clear();
    int numNodes = getNumberOfNodes();
    int expected = (7 * (depth + 1) * depth) >> 1;//uses bitshift for cheap divide, equals 7 * depth * (depth + 1) / 2
    if (expected > numNodes) expected = numNodes;
    neighborsOut.reserve(expected);//reserve means make space, but don't change size()
-   if ((int)markNodes.size() != numNodes)
-   {
-      markNodes.resize(numNodes);
-      for (i = 0; i < numNodes; ++i)
-      {
-         markNodes[i] = 0;
-      }
-   }
    if ((int)nodelist[0].size() != numNodes)
    {//WAY overkill in basically all cases, but no way to know max needed for sure, and branching or clear() would be slow
       nodelist[0].resize(numNodes);
@@ -590,8 +673,7 @@ TopologyHelper::getNodeNeighborsToDepthIter(const int rootNode,
       newlist = nodelist + newind;
       for (j = 0; j < oldused; ++j)
       {
-         const std::vector<int>& neighbors = nodes[(*oldlist)[j]].neighbors;
-         numNeigh = neighbors.size();
+         const int* neighbors = getNodeNeighbors((*oldlist)[j], numNeigh);
          for (k = 0; k < numNeigh; ++k)
          {
             whichneigh = neighbors[k];
@@ -610,6 +692,7 @@ TopologyHelper::getNodeNeighborsToDepthIter(const int rootNode,
    for (i = 0; i < numNeigh; ++i)
       markNodes[neighborsOut[i]] = 0;
    markNodes[rootNode] = 0;//only zero the nodes that were marked: after completion of call, array will be entirely zeroed
+   releaseDepthSearchScratch(scratch);
 }
 
 /**
@@ -630,33 +713,27 @@ TopologyHelper::getNodeNeighborsToDepth(const int rootNode,
       getNodeNeighborsToDepthIter(rootNode, depth, neighborsOut);
       return;
    }
-   QMutexLocker locked(&usingMarkNodes);//lock after choosing which version to use, because they are both public
+   DepthSearchScratch* scratch = acquireDepthSearchScratch();//each concurrent search uses its own scratch space
+   std::vector<int>& markNodes = scratch->markNodes;
    int i;//otherwise, a quick recursive method
    neighborsOut.clear();
    int numNodes = getNumberOfNodes();
    int expected = (7 * (depth + 1) * depth) >> 1;//uses bitshift for cheap divide, equals 7 * depth * (depth + 1) / 2
    if (expected > numNodes) expected = numNodes;
    neighborsOut.reserve(expected);//reserve means make space, but don't change size()
-   if ((int)markNodes.size() != numNodes)
-   {
-      markNodes.resize(numNodes);
-      for (i = 0; i < numNodes; ++i)
-      {
-         markNodes[i] = 0;
-      }
-   }
    markNodes[rootNode] = depth + 1;
-   depthNeighHelper(rootNode, depth, neighborsOut);//uses depth first graph search: fast, but very unordered, if sorted is desired, sort afterwards
+   depthNeighHelper(rootNode, depth, markNodes, neighborsOut);//uses depth first graph search: fast, but very unordered, if sorted is desired, sort afterwards
    int numNeigh = neighborsOut.size();//NOTE: depth first technically "wastes" some effort by searching nodes to a lesser depth then required
    for (i = 0; i < numNeigh; ++i)
       markNodes[neighborsOut[i]] = 0;
    markNodes[rootNode] = 0;//only zero the nodes that were marked: after completion of call, array will be entirely zeroed
+   releaseDepthSearchScratch(scratch);
 }
 
-void TopologyHelper::depthNeighHelper(int node, int depthrem, std::vector<int>& neighborsOut) const
+void TopologyHelper::depthNeighHelper(int node, int depthrem, std::vector<int>& markNodes, std::vector<int>& neighborsOut) const
 {
-   const std::vector<int>& neighbors = nodes[node].neighbors;
-   int i, nextdepth = depthrem - 1, numNeigh = neighbors.size(), thisNeigh, mark;
+   int i, nextdepth = depthrem - 1, numNeigh, thisNeigh, mark;
+   const int* neighbors = getNodeNeighbors(node, numNeigh);
    if (nextdepth)
    {//splitting here removes a large number of recursive calls and compares
       for (i = 0; i < numNeigh; ++i)
@@ -670,7 +747,7 @@ void TopologyHelper::depthNeighHelper(int node, int depthrem, std::vector<int>&
                neighborsOut.push_back(thisNeigh);
             }
             markNodes[thisNeigh] = depthrem;
-            depthNeighHelper(thisNeigh, nextdepth, neighborsOut);
+            depthNeighHelper(thisNeigh, nextdepth, markNodes, neighborsOut);
          }
       }
    } else {//same, but don't recurse
@@ -714,10 +791,10 @@ TopologyHelper::getNodeNeighborsToDepthOld(const int rootNode,
             //
             // Get all of the nodes neighbors
             //
-            const std::vector<int>& neighbors = nodes[node].neighbors;
-            const unsigned int numNeighs = neighbors.size();
+            int numNeighs = 0;
+            const int* neighbors = getNodeNeighbors(node, numNeighs);
             
-            for (unsigned int j = 0; j < numNeighs; j++) {
+            for (int j = 0; j < numNeighs; j++) {
                const int n = neighbors[j];
                if (nodeVisited[n] == 0) {
                   newNodes.insert(n);
@@ -890,28 +967,46 @@ TopologyHelper::getNodeNeighborsToDepthOld(const int rootNode,
 const int*
 TopologyHelper::getNodeNeighbors(const int nodeNum, int& numNeighborsOut) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      numNeighborsOut = static_cast<int>(nodes[nodeNum].neighbors.size());
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      numNeighborsOut = neighborOffsets[nodeNum + 1] - neighborOffsets[nodeNum];
       if (numNeighborsOut <= 0) {
          return NULL;
       }
-      return &nodes[nodeNum].neighbors[0];
+      return &neighborIndices[neighborOffsets[nodeNum]];
    }
    numNeighborsOut = 0;
    return NULL;
 }
 
+/**
+ * Get the tiles used by a node.  Returns a pointer to an array
+ * containing the tiles.
+ */
+const int*
+TopologyHelper::getNodeTiles(const int nodeNum, int& numTilesOut) const
+{
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      numTilesOut = tileOffsets[nodeNum + 1] - tileOffsets[nodeNum];
+      if (numTilesOut <= 0) {
+         return NULL;
+      }
+      return &tileIndices[tileOffsets[nodeNum]];
+   }
+   numTilesOut = 0;
+   return NULL;
+}
+
 /**
  * Get the tiles that use this node.
  */
 void
 TopologyHelper::getNodeTiles(const int nodeNum, std::vector<int>& tilesOut) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      tilesOut = nodes[nodeNum].tiles;
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      tilesOut.assign(tileIndices.begin() + tileOffsets[nodeNum],
+                      tileIndices.begin() + tileOffsets[nodeNum + 1]);
    }
    else {
       tilesOut.clear();
    }
 }
-
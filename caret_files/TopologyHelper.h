@@ -114,6 +114,8 @@ class TopologyEdgeInfo {
       
       
 /// This class is used to determine the node neighbors and edges for a Topology File.
+/// The neighbors and tiles of all nodes are stored in compressed sparse row
+/// arrays so that the neighbors of a node may be accessed without copying.
 class TopologyHelper {
    public:
       /// Constructor for use with a Caret Topology File
@@ -132,7 +134,7 @@ class TopologyHelper {
       ~TopologyHelper();
       
       /// Get the number of nodes
-      int getNumberOfNodes() const { return nodes.size(); }
+      int getNumberOfNodes() const { return numberOfNodes; }
       
       /// See if a node has neighbors
       bool getNodeHasNeighbors(const int nodeNum) const;
@@ -162,16 +164,40 @@ class TopologyHelper {
                                    std::vector<int>& neighborsOut) const;
 
    private:
-      void depthNeighHelper(int root, int remdepth, std::vector<int>& neighborsOut) const;
-      mutable std::vector<int> markNodes, nodelist[2];//persistent, never cleared, only initialized once, saving bazillions of nanoseconds
-      //could be templated over bool, which stores bitwise, but we already have three times that many floats and six times the ints in memory
-      mutable QMutex usingMarkNodes;//do not let threads clobber markNodes
+      /// scratch space for the searches to depth
+      class DepthSearchScratch {
+         public:
+            /// marks nodes found by search, entirely zero between searches
+            std::vector<int> markNodes;
+            
+            /// node lists for iterative search
+            std::vector<int> nodelist[2];
+      };
+      
+      /// get scratch space for a search to depth (may be used without locking)
+      DepthSearchScratch* acquireDepthSearchScratch() const;
+      
+      /// return scratch space for a search to depth
+      void releaseDepthSearchScratch(DepthSearchScratch* scratch) const;
+      
+      void depthNeighHelper(int root, int remdepth, std::vector<int>& markNodes, std::vector<int>& neighborsOut) const;
+      
+      /// scratch space not in use, one is created for each thread searching at the same time
+      mutable std::vector<DepthSearchScratch*> depthSearchScratchPool;
+      
+      /// protects the scratch space pool
+      mutable QMutex depthSearchScratchPoolMutex;
+      
    public:
       
       /// Get the neighboring nodes for a node.  Returns a pointer to an array
       /// containing the neighbors.
       const int* getNodeNeighbors(const int nodeNum, int& numNeighborsOut) const;
       
+      /// Get the tiles used by a node.  Returns a pointer to an array
+      /// containing the tiles.
+      const int* getNodeTiles(const int nodeNum, int& numTilesOut) const;
+      
       /// Get the number of boundary edges used by node
       void getNumberOfBoundaryEdgesForAllNodes(std::vector<int>& numBoundaryEdges) const;
       
@@ -198,107 +224,48 @@ class TopologyHelper {
 
    private:
       
-      /// Stores tiles and vertices of an edge (link) for use when sorting nodes by NodeInfo.
-      /// These edges are those opposite of a NodeInfo node, this is, given a tile with
-      /// nodes A, B, and C, the nodes B and C would be stored in an NodeEdgeInfo for node A. 
-      class NodeEdgeInfo {
-         public:
-            /// nodes in the edge
-            int node1, node2;
-            
-            /// tile used by this edge
-            int tileNumber;
-            
-            /// constructor
-            NodeEdgeInfo(const int tileNum, const int node1In, const int node2In) {
-               tileNumber = tileNum;
-               node1 = node1In;
-               node2 = node2In;
-            }
-            
-            /// get the other node in the edge
-            int getOtherNode(const int node) const {
-               if (node1 == node) return node2;
-               else               return node1;
-            }
-            
-            /// see if a node is in the edge
-            bool containsNode(const int node) const {
-               return ((node1 == node) || (node2 == node));
-            }
-      };
+      /// build the node and edge information from the tiles' nodes
+      void buildTopology(const int* tileNodes,
+                         const int numTiles,
+                         const bool buildEdgeInfo,
+                         const bool buildNodeInfo,
+                         const bool sortNodeInfo);
       
-      /// Stores information about a node for sorting
-      class NodeInfo {
-         public:
-            /// this node's number
-            int nodeNumber;
-            
-            /// tile's used by this node
-            std::vector<int> tiles;
-            
-            /// the neighboring nodes of this edge
-            std::vector<int> neighbors;
-            
-            /// the edges used to form tiles with this node
-            std::vector<NodeEdgeInfo> edges;
-            
-            /// allow sorting flag
-            bool  sortMe;
-            
-            /// constructor
-            NodeInfo(const int nodeNumberIn) {
-               nodeNumber = nodeNumberIn;
-               sortMe = true;
-            }
-            
-            /// add a neighbor to this node without edge information
-            void addNeighbor(const int newNeighbor1) {
-               for (unsigned int i = 0; i < neighbors.size(); i++) {
-                  if (neighbors[i] == newNeighbor1) {
-                     return;
-                  }
-               }
-               neighbors.push_back(newNeighbor1);
-               sortMe = false;
-            }
-            
-            /// add two neighbors that form a tile using this node
-            void addNeighbors(const int tileNum, const int newNeighbor1, const int newNeighbor2) {
-               edges.push_back(NodeEdgeInfo(tileNum, newNeighbor1, newNeighbor2));
-            }
-
-            /// add a tile to the node
-            void addTile(const int tileNum) { tiles.push_back(tileNum); }
-            
-            /// find an edge that has one endpoint equal to "seekingNode" but
-            /// does not contain the node "notNode".
-            const NodeEdgeInfo* findEdgeWithPoint(const int seekingNode, 
-                                              const int notNode) {
-               for (unsigned int i = 0; i < edges.size(); i++) {
-                  if ( ((edges[i].node1 == seekingNode) &&
-                        (edges[i].node2 != notNode)) ||
-                       ((edges[i].node2 == seekingNode) &&
-                        (edges[i].node1 != notNode)) ) {
-                     return &edges[i];
-                  }
-               }
-               return NULL;
-            }
-
-            /// sort the neighbors for this node
-            void sortNeighbors();
-      };
+      /// build the neighbors and tiles of each node
+      void buildNodeInfo(const int* tileNodes,
+                         const int numTiles,
+                         const bool sortNodeInfo);
+      
+      /// build the edge information
+      void buildEdgeInfo(const int* tileNodes,
+                         const int numTiles);
+      
+      /// sort a node's neighbors and tiles around the node, returns number of neighbors
+      static int sortNodeNeighbors(const int* tileNodes,
+                                   const int* nodeCorners,
+                                   const int numCorners,
+                                   int* neighborsOut,
+                                   int* tilesOut,
+                                   int& numTilesOut);
       
-      /// Node storage
-      std::vector<NodeInfo> nodes;
+      /// number of nodes
+      int numberOfNodes;
+      
+      /// offset of each node's neighbors in "neighborIndices" (one more than number of nodes)
+      std::vector<int> neighborOffsets;
+      
+      /// neighbors of all nodes
+      std::vector<int> neighborIndices;
+      
+      /// offset of each node's tiles in "tileIndices" (one more than number of nodes)
+      std::vector<int> tileOffsets;
+      
+      /// tiles of all nodes
+      std::vector<int> tileIndices;
       
       /// edge storage
       std::set<TopologyEdgeInfo> topologyEdges;
       
-      /// add information about an edge
-      void addEdgeInfo(const int tileNum, const int node1, const int node2);
-      
       /// edge info was built
       bool edgeInfoBuilt;
 
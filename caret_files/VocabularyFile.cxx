@@ -221,6 +221,9 @@ VocabularyFile::readFileData(QFile& file,
             readDataFromCommaSeparatedValuesTable(csvf);
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -280,6 +283,9 @@ VocabularyFile::writeFileData(QTextStream& stream,
             csvf.writeToTextStream(stream);
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -53,6 +53,10 @@
 #include <sstream>
 #include <stack>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <QProcess>
 
 #define __VOLUME_FILE_MAIN_H__
@@ -89,9 +93,6 @@
 #include "vtkImageCast.h"
 #include "vtkImageFlip.h"
 #include "vtkImageGaussianSmooth.h"
-#include "vtkImageResample.h"
-#include "vtkImageReslice.h"
-#include "vtkImageSeedConnectivity.h"
 #include "vtkImageShrink3D.h"
 #include "vtkMarchingCubes.h"
 #include "vtkMath.h"
@@ -3568,6 +3569,31 @@ VolumeFile::convertCoordinatesToVoxelIJK(const float* xyz,
  */
 bool
 VolumeFile::getInterpolatedVoxel(const float xyzIn[3], float& voxelValue)
+{
+   voxelValue = 0.0;
+   
+   int voxelNumbers[8];
+   float weights[8];
+   const int numVoxels = getInterpolatedVoxelWeights(xyzIn, voxelNumbers, weights);
+   for (int j = 0; j < numVoxels; j++) {
+      voxelValue += voxels[voxelNumbers[j] * numberOfComponentsPerVoxel] * weights[j];
+   }
+   
+   return (numVoxels > 0);
+}
+
+/**
+ * Get the voxels and weights that produce an "interpolated" voxel at a
+ * coordinate.  The interpolated value is the sum of each voxel's first
+ * component multiplied by its weight.  Since the voxels and weights depend
+ * only upon the volume's geometry, they may be reused for other volumes with
+ * the same dimensions, origin, and spacing.  Returns the number of voxels
+ * (at most 8), zero if the coordinate is not in the volume.
+ */
+int
+VolumeFile::getInterpolatedVoxelWeights(const float xyzIn[3],
+                                        int voxelNumbersOut[8],
+                                        float weightsOut[8]) const
 {
    //
    // Because of the weighting system used, we need to offset
@@ -3582,8 +3608,6 @@ VolumeFile::getInterpolatedVoxel(const float xyzIn[3], float& voxelValue)
       xyzIn[2] - (spacing[2] * 0.5)
    };
    
-   voxelValue = 0.0;
-
    //
    // Get the voxel coordinates
    //
@@ -3591,7 +3615,7 @@ VolumeFile::getInterpolatedVoxel(const float xyzIn[3], float& voxelValue)
    float pcoords[3];
    const int insideVolume = convertCoordinatesToVoxelIJK((float*)xyz, ijk, pcoords);
    if (insideVolume == false) {
-      return false;
+      return 0;
    }   
 
    //
@@ -3600,74 +3624,69 @@ VolumeFile::getInterpolatedVoxel(const float xyzIn[3], float& voxelValue)
    if ((ijk[0] == 0) || (ijk[0] == (dimensions[0] - 1)) ||
        (ijk[1] == 0) || (ijk[1] == (dimensions[1] - 1)) ||
        (ijk[2] == 0) || (ijk[2] == (dimensions[2] - 1))) {
-      voxelValue = getVoxel(ijk);
+      voxelNumbersOut[0] = getVoxelNumber(ijk);
+      weightsOut[0] = 1.0;
+      return 1;
    }
-   else {
-      convertCoordinatesToVoxelIJK(xyz, ijk, pcoords);
-      const float r = pcoords[0];
-      const float s = pcoords[1];
-      const float t = pcoords[2];
-      
+   
+   const float r = pcoords[0];
+   const float s = pcoords[1];
+   const float t = pcoords[2];
+   
+   //
+   // Weighting from book Visualization Toolkit, 2nd Ed, page 316
+   // 
+   for (int j = 0; j < 8; j++) {
+      int dijk[3] = { 0, 0, 0 };
+      float weight = 0.0;
+      switch(j) {
+         case 0:
+            weight = (1.0 - r) * (1.0 - s) * (1.0 - t);
+            break;
+         case 1:
+            weight = r * (1.0 - s) * (1.0 - t);
+            dijk[0] = 1;
+            break;
+         case 2:
+            weight = (1.0 - r) * s * (1.0 - t);
+            dijk[1] = 1;
+            break;
+         case 3:
+            weight = r * s * (1.0 - t);
+            dijk[0] = 1;
+            dijk[1] = 1;
+            break;
+         case 4:
+            weight = (1.0 - r) * (1.0 - s) * t;
+            dijk[2] = 1;
+            break;
+         case 5:
+            weight = r * (1.0 - s) * t;
+            dijk[0] = 1;
+            dijk[2] = 1;
+            break;
+         case 6:
+            weight = (1.0 - r) * s * t;
+            dijk[1] = 1;
+            dijk[2] = 1;
+            break;
+         case 7:
+            weight = r * s * t;
+            dijk[0] = 1;
+            dijk[1] = 1;
+            dijk[2] = 1;
+            break;
+      }
       
       //
-      // Weighting from book Visualization Toolkit, 2nd Ed, page 316
-      // 
-      for (int j = 0; j < 8; j++) {
-         int dijk[3] = { 0, 0, 0 };
-         float weight = 0.0;
-         switch(j) {
-            case 0:
-               weight = (1.0 - r) * (1.0 - s) * (1.0 - t);
-               break;
-            case 1:
-               weight = r * (1.0 - s) * (1.0 - t);
-               dijk[0] = 1;
-               break;
-            case 2:
-               weight = (1.0 - r) * s * (1.0 - t);
-               dijk[1] = 1;
-               break;
-            case 3:
-               weight = r * s * (1.0 - t);
-               dijk[0] = 1;
-               dijk[1] = 1;
-               break;
-            case 4:
-               weight = (1.0 - r) * (1.0 - s) * t;
-               dijk[2] = 1;
-               break;
-            case 5:
-               weight = r * (1.0 - s) * t;
-               dijk[0] = 1;
-               dijk[2] = 1;
-               break;
-            case 6:
-               weight = (1.0 - r) * s * t;
-               dijk[1] = 1;
-               dijk[2] = 1;
-               break;
-            case 7:
-               weight = r * s * t;
-               dijk[0] = 1;
-               dijk[1] = 1;
-               dijk[2] = 1;
-               break;
-         }
-         
-         //
-         // adjust the voxel indices
-         //
-         int vijk[3] = { ijk[0] + dijk[0], ijk[1] + dijk[1], ijk[2] + dijk[2] };
-         
-         //
-         // Add into the voxel
-         //
-         const float vv = getVoxel(vijk, 0);
-         voxelValue += vv * weight;
-      }
+      // adjust the voxel indices
+      //
+      const int vijk[3] = { ijk[0] + dijk[0], ijk[1] + dijk[1], ijk[2] + dijk[2] };
+      voxelNumbersOut[j] = getVoxelNumber(vijk);
+      weightsOut[j] = weight;
    }
    
-   return true;
+   return 8;
 }
 
 /**
@@ -3895,60 +3914,105 @@ VolumeFile::applyTransformationMatrix(const TransformationMatrix& tmIn)
 
 
 /**
- * Apply transformation matrix to a volume.
+ * Apply transformation matrix to a volume.  The transform maps coordinates
+ * in the output volume to coordinates in the input volume.  The output
+ * keeps the input's spacing and is sized to hold all of the transformed
+ * input volume.
  */
 void
 VolumeFile::applyTransformationMatrix(vtkTransform* transform)
 {
-   vtkStructuredPoints* spInput = convertToVtkStructuredPoints();
+   if (voxels == NULL) {
+      return;
+   }
    
-   vtkImageReslice* reslice = vtkImageReslice::New();   
-   reslice->SetNumberOfThreads(1);
-   reslice->SetInput(spInput);
-   reslice->SetInformationInput(spInput);
-   reslice->SetResliceTransform(transform);
-   reslice->SetAutoCropOutput(1);
- 
+   //
+   // Bounds of the input volume after it is transformed
+   //
+   vtkLinearTransform* inverse = transform->GetLinearInverse();
+   double bounds[6] = { 
+      std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+      std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+      std::numeric_limits<double>::max(), -std::numeric_limits<double>::max()
+   };
+   for (int corner = 0; corner < 8; corner++) {
+      double xyz[3];
+      for (int i = 0; i < 3; i++) {
+         const int ijk = ((corner >> i) & 1) ? (dimensions[i] - 1) : 0;
+         xyz[i] = origin[i] + ijk * spacing[i];
+      }
+      double outXYZ[3];
+      inverse->TransformPoint(xyz, outXYZ);
+      for (int i = 0; i < 3; i++) {
+         bounds[i*2]   = std::min(bounds[i*2], outXYZ[i]);
+         bounds[i*2+1] = std::max(bounds[i*2+1], outXYZ[i]);
+      }
+   }
+   
+   //
+   // Output volume geometry
+   //
+   int outputDimensions[3];
+   float outputOrigin[3];
+   for (int i = 0; i < 3; i++) {
+      const double d = bounds[i*2+1] - bounds[i*2];
+      outputDimensions[i] = static_cast<int>(std::floor(d / std::fabs(spacing[i]) + 0.5)) + 1;
+      outputOrigin[i] = (spacing[i] < 0.0) ? bounds[i*2+1] : bounds[i*2];
+   }
+   
+   //
+   // Affine mapping from output voxel indices to input voxel indices
+   //
+   double p0[3];
+   const double o[3] = { outputOrigin[0], outputOrigin[1], outputOrigin[2] };
+   transform->TransformPoint(o, p0);
+   double outputToInput[3][4];
+   for (int j = 0; j < 3; j++) {
+      double step[3] = { o[0], o[1], o[2] };
+      step[j] += spacing[j];
+      double p[3];
+      transform->TransformPoint(step, p);
+      for (int i = 0; i < 3; i++) {
+         outputToInput[i][j] = (p[i] - p0[i]) / spacing[i];
+      }
+   }
+   for (int i = 0; i < 3; i++) {
+      outputToInput[i][3] = (p0[i] - origin[i]) / spacing[i];
+   }
+   
+   INTERPOLATION_TYPE interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
    switch (volumeType) {
       case VOLUME_TYPE_ANATOMY:
-         reslice->SetInterpolationModeToCubic();
+         interpolationType = INTERPOLATION_TYPE_CUBIC;
          break;
       case VOLUME_TYPE_FUNCTIONAL:
-         reslice->SetInterpolationModeToCubic();
+         interpolationType = INTERPOLATION_TYPE_CUBIC;
          break;
       case VOLUME_TYPE_PAINT:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_PROB_ATLAS:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_RGB:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_ROI:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_SEGMENTATION:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_VECTOR:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_UNKNOWN:
-         reslice->SetInterpolationModeToCubic();
+         interpolationType = INTERPOLATION_TYPE_CUBIC;
          break;
    }
-   reslice->Update();
-
-   convertFromVtkImageData(reslice->GetOutput());
-
-   reslice->Delete();
-   spInput->Delete();
    
-   allocateVoxelColoring();
-   setModified();
-   minMaxVoxelValuesValid = false;
-   minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
+   resliceVoxels(outputDimensions, outputToInput, interpolationType);
+   setOrigin(outputOrigin);
 }
 
 /**
@@ -3958,39 +4022,221 @@ void
 VolumeFile::resampleToSpacing(const float newSpacing[3],
                               const INTERPOLATION_TYPE interpolationType)
 {  
-   vtkStructuredPoints* spInput = convertToVtkStructuredPoints();
-
-   vtkImageResample* resample = vtkImageResample::New();   
-   resample->SetNumberOfThreads(1);
-   resample->SetInput(spInput);
-   resample->SetAxisOutputSpacing(0, newSpacing[0]);
-   resample->SetAxisOutputSpacing(1, newSpacing[1]);
-   resample->SetAxisOutputSpacing(2, newSpacing[2]);
-   resample->SetDimensionality(3);
-   resample->SetInterpolationModeToCubic();
+   if (voxels == NULL) {
+      return;
+   }
+   
+   //
+   // The origin and axis directions are unchanged and the output covers
+   // the input's extent
+   //
+   int outputDimensions[3];
+   double outputToInput[3][4];
+   float outputSpacing[3];
+   for (int i = 0; i < 3; i++) {
+      outputSpacing[i] = (spacing[i] < 0.0) ? -std::fabs(newSpacing[i]) 
+                                            : std::fabs(newSpacing[i]);
+      const double factor = std::fabs(spacing[i] / newSpacing[i]);
+      outputDimensions[i] = static_cast<int>(std::floor((dimensions[i] - 1) * factor)) + 1;
+      for (int j = 0; j < 4; j++) {
+         outputToInput[i][j] = 0.0;
+      }
+      outputToInput[i][i] = 1.0 / factor;
+   }
+   
+   resliceVoxels(outputDimensions, outputToInput, interpolationType);
+   setSpacing(outputSpacing);
+}      
+
+/**
+ * Interpolation taps along one axis of a volume being resliced.
+ */
+class ResliceAxisTaps {
+   public:
+      /// input voxel index of each tap
+      int index[4];
+      
+      /// weight of each tap
+      float weight[4];
+      
+      /// number of taps (zero if outside of the input volume)
+      int numTaps;
+};
+
+/**
+ * Find the input voxels and weights used to interpolate at the continuous
+ * index "x" along an axis with "dim" voxels.  Cubic interpolation uses the
+ * Catmull-Rom spline with the edge voxels repeated beyond the volume.
+ */
+static void
+computeResliceAxisTaps(const double x, const int dim,
+                       const VolumeFile::INTERPOLATION_TYPE interpolationType,
+                       ResliceAxisTaps& taps)
+{
+   const double tolerance = 0.001;
+   if ((x < -tolerance) || (x > (dim - 1 + tolerance))) {
+      taps.numTaps = 0;
+      return;
+   }
+   const double xc = std::min(std::max(x, 0.0), static_cast<double>(dim - 1));
+   
+   int i0 = static_cast<int>(std::floor(xc));
+   const float t = xc - i0;
    switch (interpolationType) {
-      case INTERPOLATION_TYPE_CUBIC:
-         resample->SetInterpolationModeToCubic();
-         break;
-      case INTERPOLATION_TYPE_LINEAR:
-         resample->SetInterpolationModeToLinear();
-         break;
-      case INTERPOLATION_TYPE_NEAREST_NEIGHBOR:
-         resample->SetInterpolationModeToNearestNeighbor();
+      case VolumeFile::INTERPOLATION_TYPE_NEAREST_NEIGHBOR:
+         taps.numTaps = 1;
+         taps.index[0] = std::min(static_cast<int>(std::floor(xc + 0.5)), dim - 1);
+         taps.weight[0] = 1.0;
+         break;
+      case VolumeFile::INTERPOLATION_TYPE_LINEAR:
+         taps.numTaps = 2;
+         taps.index[0] = i0;
+         taps.index[1] = std::min(i0 + 1, dim - 1);
+         taps.weight[0] = 1.0 - t;
+         taps.weight[1] = t;
+         break;
+      case VolumeFile::INTERPOLATION_TYPE_CUBIC:
+         {
+            taps.numTaps = 4;
+            for (int i = 0; i < 4; i++) {
+               taps.index[i] = std::min(std::max(i0 - 1 + i, 0), dim - 1);
+            }
+            const float t2 = t * t;
+            const float t3 = t2 * t;
+            taps.weight[0] = 0.5 * (-t3 + 2.0 * t2 - t);
+            taps.weight[1] = 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0);
+            taps.weight[2] = 0.5 * (-3.0 * t3 + 4.0 * t2 + t);
+            taps.weight[3] = 0.5 * (t3 - t2);
+         }
          break;
    }
-   resample->Update();
+}
+
+/**
+ * Replace the voxels with the input volume sampled at each voxel of a
+ * volume with the given dimensions.  "outputToInput" is the affine mapping
+ * from an output voxel index (i, j, k) to a continuous input voxel index.
+ * Output voxels that map outside of the input volume are set to zero.
+ * Each component of multi-component voxels is interpolated separately.
+ *
+ * When the mapping only scales and translates each axis, the taps for each
+ * output row, column, and slice are computed once and reused; otherwise the
+ * contribution of each output index to the input position is tabulated per
+ * axis so that only the taps are computed for each voxel.  Slices of the
+ * output are processed in parallel.
+ */
+void
+VolumeFile::resliceVoxels(const int outputDimensions[3],
+                          const double outputToInput[3][4],
+                          const INTERPOLATION_TYPE interpolationType)
+{
+   const int dimX = dimensions[0];
+   const int dimY = dimensions[1];
+   const int dimXY = dimX * dimY;
+   const int numComponents = numberOfComponentsPerVoxel;
+   const float* input = voxels;
+   
+   const int outDimX = std::max(outputDimensions[0], 1);
+   const int outDimY = std::max(outputDimensions[1], 1);
+   const int outDimZ = std::max(outputDimensions[2], 1);
+   const long numOutput = static_cast<long>(outDimX) * outDimY * outDimZ * numComponents;
+   float* output = new float[numOutput];
+   
+   bool axisAligned = true;
+   for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+         if ((i != j) && (outputToInput[i][j] != 0.0)) {
+            axisAligned = false;
+         }
+      }
+   }
+   
+   //
+   // With no rotation or shear, the taps along each axis depend on only
+   // that axis' output index.  Otherwise, tabulate the input position
+   // contributed by each output index along each axis.
+   //
+   const int outDims[3] = { outDimX, outDimY, outDimZ };
+   std::vector<ResliceAxisTaps> axisTaps[3];
+   std::vector<double> axisOffsets[3];
+   for (int j = 0; j < 3; j++) {
+      if (axisAligned) {
+         axisTaps[j].resize(outDims[j]);
+         for (int n = 0; n < outDims[j]; n++) {
+            computeResliceAxisTaps(outputToInput[j][j] * n + outputToInput[j][3],
+                                   dimensions[j], interpolationType, axisTaps[j][n]);
+         }
+      }
+      else {
+         axisOffsets[j].resize(outDims[j] * 3);
+         for (int n = 0; n < outDims[j]; n++) {
+            for (int i = 0; i < 3; i++) {
+               axisOffsets[j][n*3+i] = outputToInput[i][j] * n
+                                     + ((j == 2) ? outputToInput[i][3] : 0.0);
+            }
+         }
+      }
+   }
    
-   convertFromVtkImageData(resample->GetOutput());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+   for (int k = 0; k < outDimZ; k++) {
+      ResliceAxisTaps tx, ty, tz;
+      for (int j = 0; j < outDimY; j++) {
+         for (int i = 0; i < outDimX; i++) {
+            const ResliceAxisTaps* px = &tx;
+            const ResliceAxisTaps* py = &ty;
+            const ResliceAxisTaps* pz = &tz;
+            if (axisAligned) {
+               px = &axisTaps[0][i];
+               py = &axisTaps[1][j];
+               pz = &axisTaps[2][k];
+            }
+            else {
+               double xyz[3];
+               for (int m = 0; m < 3; m++) {
+                  xyz[m] = axisOffsets[0][i*3+m] 
+                         + axisOffsets[1][j*3+m] 
+                         + axisOffsets[2][k*3+m];
+               }
+               computeResliceAxisTaps(xyz[0], dimensions[0], interpolationType, tx);
+               computeResliceAxisTaps(xyz[1], dimensions[1], interpolationType, ty);
+               computeResliceAxisTaps(xyz[2], dimensions[2], interpolationType, tz);
+            }
+            
+            float* out = &output[((static_cast<long>(k) * outDimY + j) * outDimX + i) 
+                                 * numComponents];
+            for (int m = 0; m < numComponents; m++) {
+               float sum = 0.0;
+               for (int c = 0; c < pz->numTaps; c++) {
+                  for (int b = 0; b < py->numTaps; b++) {
+                     const float wzy = pz->weight[c] * py->weight[b];
+                     const long rowOffset = static_cast<long>(pz->index[c]) * dimXY 
+                                          + py->index[b] * dimX;
+                     for (int a = 0; a < px->numTaps; a++) {
+                        sum += wzy * px->weight[a] 
+                             * input[(rowOffset + px->index[a]) * numComponents + m];
+                     }
+                  }
+               }
+               out[m] = sum;
+            }
+         }
+      }
+   }
    
-   resample->Delete();
-   spInput->Delete();
+   delete[] voxels;
+   voxels = output;
+   dimensions[0] = outDimX;
+   dimensions[1] = outDimY;
+   dimensions[2] = outDimZ;
    
    allocateVoxelColoring();
    setModified();
    minMaxVoxelValuesValid = false;
    minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
-}      
+}
 
 /**
  * make all voxels in a segmentation volume 0 or 255.
@@ -6477,35 +6723,19 @@ VolumeFile::findBiggestObjectWithinMask(const int iminIn,
    }
 	else {
       //
-      // Create a flag for noting which voxels have been searched.
-      // Mark those within region and within min and max values NOT SEARCHED
-      // and all others SEARCHED.
-      //
-		VOXEL_SEARCH_STATUS* voxelSearched = new VOXEL_SEARCH_STATUS[numVoxels];
-		for (int k = 0; k < dimensions[2]; k++) {
-			for (int j = 0; j < dimensions[1]; j++) {
-				for (int i = 0; i < dimensions[0]; i++) {
-               const int idx = getVoxelDataIndex(i, j, k);
-               voxelSearched[idx] = VOXEL_SEARCHED;
-               if ((i >= imin) && (i < imax) &&
-                   (j >= jmin) && (j < jmax) &&
-                   (k >= kmin) && (k < kmax)) {
-                  if ((voxels[idx] >= minValue) &&
-                      (voxels[idx] <= maxValue)) {
-                     voxelSearched[idx] = VOXEL_NOT_SEARCHED;
-                  }
-               }
-				}
-			}
-		}
-	
-      //
-      // Find a voxel within value range that has not been searched
-      //
-      VoxelIJK seedVoxel;
-      bool voxelFound = findUnsearchedVoxel(minValue, maxValue, voxelSearched, seedVoxel);
+      // Label the objects within the region
+      //
+      const int extent[6] = { imin, imax, jmin, jmax, kmin, kmax };
+      std::vector<int> labels;
+      std::vector<ConnectedComponent> components;
+      numberOfObjectsFound = labelConnectedComponents(minValue,
+                                                      maxValue,
+                                                      CONNECTIVITY_6,
+                                                      labels,
+                                                      components,
+                                                      extent);
       
-      if (voxelFound == false) {
+      if (numberOfObjectsFound == 0) {
          if (DebugControl::getDebugOn()) {
             std::cout << "FindBiggestObjectWithinMask no initial voxel found with values: "
                       << minValue << " " << maxValue << std::endl;
@@ -6513,74 +6743,22 @@ VolumeFile::findBiggestObjectWithinMask(const int iminIn,
       }
       
       //
-      // Loop through all objects
+      // Find the biggest object
       //
-      while (voxelFound) {
-         //
-         // Create a stack 
-         //
-         std::stack<VoxelIJK> stack;
-         stack.push(seedVoxel);
-         
-         //
-         // Number of voxels in this connected piece
-         //
-         int numConnectedVoxels = 0;
-         
-         //
-         // While there are voxels to search
-         //
-         while (stack.empty() == false) {
-            //
-            // Get the next voxel to search
-            //
-            const VoxelIJK v = stack.top();
-            stack.pop();
-          
-            const int idx = getVoxelDataIndex(v.getIJK());
-            if (voxelSearched[idx] == VOXEL_NOT_SEARCHED) {
-               voxelSearched[idx] = VOXEL_SEARCHED;
-               
-               //
-               // Increase connected count
-               //
-               numConnectedVoxels++;
-            
-               //
-               // Get the neighboring voxels
-               //
-               std::vector<VoxelIJK> neighbors;
-               getNeighbors(v, neighbors);
-               
-               //
-               // Add neighbors to stack
-               //
-               for (unsigned int i = 0; i < neighbors.size(); i++) {
-                  VoxelIJK& v = neighbors[i];
-                  const int idx = getVoxelDataIndex(v.getIJK());
-                  if (voxelSearched[idx] == VOXEL_NOT_SEARCHED) {
-                     stack.push(v);
-                  }
-               }
-            }
-         }  // while (stack.isEmpty() == false)
-         
-         //
-         // Was an object found
-         //
-         if (numConnectedVoxels > 0) {
-            numberOfObjectsFound++;
-            if (DebugControl::getDebugOn()) {
-               int i, j, k;
-               seedVoxel.getIJK(i, j, k);
-               std::cout << "\t"
-                         << "seed : "
-                         << i << ", "
-                         << j << ", "
-                         << k << ": size "
-                         << numConnectedVoxels 
-                         << std::endl;
-            }
+      for (int m = 0; m < numberOfObjectsFound; m++) {
+         const ConnectedComponent& object = components[m];
+         const int numConnectedVoxels = object.getNumberOfVoxels();
+         const VoxelIJK seedVoxel = object.getFirstVoxel();
+         if (DebugControl::getDebugOn()) {
+            int i, j, k;
+            seedVoxel.getIJK(i, j, k);
+            std::cout << "\t"
+                      << "seed : "
+                      << i << ", "
+                      << j << ", "
+                      << k << ": size "
+                      << numConnectedVoxels 
+                      << std::endl;
          }
          
          //
@@ -6590,13 +6768,7 @@ VolumeFile::findBiggestObjectWithinMask(const int iminIn,
             largestObjectCount = numConnectedVoxels;
             bigSeed = seedVoxel;
          }
-         
-         //
-         // Find another voxel to search
-         //
-         voxelFound = findUnsearchedVoxel(minValue, maxValue, voxelSearched, seedVoxel);
-      } // while (voxelFound)
-      
+      }
       
 		if (largestObjectCount > 0) {
          if (DebugControl::getDebugOn()) {
@@ -6611,7 +6783,6 @@ VolumeFile::findBiggestObjectWithinMask(const int iminIn,
                          << std::endl;
          }
       }
-		delete[] voxelSearched;
 	}	
    
 	if (largestObjectCount == 0) {
@@ -6627,76 +6798,405 @@ VolumeFile::findBiggestObjectWithinMask(const int iminIn,
 }
 
 /**
- * Find voxel within value range that has not been searched.
- * Returns true if found else false.
+ * Find the root of a set of voxels (the set's first voxel in storage order)
+ * and shorten the path to the root.
  */
-bool	
-VolumeFile::findUnsearchedVoxel(const float minValue,
-                                   const float maxValue, 
-                                   VOXEL_SEARCH_STATUS searchStatus[],
-                                   VoxelIJK& seedOut) const
+static inline int
+findConnectedComponentRoot(std::vector<int>& parent, int indx)
 {
-   //
-   // Loop through region
-   //
-   for (int k = 0; k < dimensions[2]; k++) {
-      for (int j = 0; j < dimensions[1]; j++) {
-         for (int i = 0; i < dimensions[0]; i++) {
-            const int idx = getVoxelDataIndex(i, j, k);
-            if (searchStatus[idx] == VOXEL_NOT_SEARCHED) {
-               if ((voxels[idx] >= minValue) && (voxels[idx] <= maxValue)) {
-                  seedOut.setIJK(i, j, k);
-                  return true;
-               }
-            }
-         }
-      }
+   while (parent[indx] != indx) {
+      parent[indx] = parent[parent[indx]];
+      indx = parent[indx];
    }
-   return false;
+   return indx;
 }
 
 /**
- * remove islands (all but the largest connected piece of surface).
- * returns true if islands were removed
+ * Merge the sets containing two voxels.
  */
-bool 
-VolumeFile::removeIslandsFromSegmentation()
+static inline void
+mergeConnectedComponents(std::vector<int>& parent, const int indx1, const int indx2)
 {
-   //
-   // Find the biggest piece of surface
-   //
-   VoxelIJK biggestPiece;
-   if (findBiggestObject(255.0, 255.0, biggestPiece) > 1) {
-      //
-      // Keep only the biggest piece of surface
-      //
-      floodFillWithVTK(biggestPiece, 255, 255, 0);
-      return true;
+   const int root1 = findConnectedComponentRoot(parent, indx1);
+   const int root2 = findConnectedComponentRoot(parent, indx2);
+   if (root1 < root2) {
+      parent[root2] = root1;
+   }
+   else if (root2 < root1) {
+      parent[root1] = root2;
    }
-   
-   return false;
 }
 
 /**
- * flood fill slice with VTK.
+ * Label the connected components of the voxels with values in [minValue, maxValue].
+ *
+ * "labelsOut" contains one element for each voxel (in the voxels' storage
+ * order) that is the voxel's component number (1..N) or zero if the voxel
+ * is not in a component.  componentsOut[n - 1] contains the statistics for
+ * component "n".  Components are numbered in the storage order of their first
+ * voxel.  If "extent" is not NULL, only voxels with indices in
+ * [extent[0], extent[1]), [extent[2], extent[3]), [extent[4], extent[5])
+ * are labeled.  Voxels that are nonzero in "excludeMaskVolume" (same
+ * dimensions as this volume) are not labeled.
+ *
+ * Returns the number of components.
  */
-void 
-VolumeFile::floodFillSliceWithVTK(const VolumeFile::VOLUME_AXIS axis,
-                             const int seed[3],
-                             const int connectedValueIn,
-                             const int connectedValueOut,
-                             const int unconnectedValueOut,
-                             VolumeModification* modifiedVoxels)
-{
-   int sliceNum = 0;
-   switch (axis) {
-      case VOLUME_AXIS_X:
-         sliceNum = seed[0];
+int
+VolumeFile::labelConnectedComponents(const float minValue,
+                                     const float maxValue,
+                                     const CONNECTIVITY connectivity,
+                                     std::vector<int>& labelsOut,
+                                     std::vector<ConnectedComponent>& componentsOut,
+                                     const int* extent,
+                                     const VolumeFile* excludeMaskVolume) const
+{
+   const std::vector<float> minValues(1, minValue);
+   const std::vector<float> maxValues(1, maxValue);
+   std::vector<int> componentRanges;
+   return labelConnectedComponentsInRanges(minValues,
+                                           maxValues,
+                                           connectivity,
+                                           labelsOut,
+                                           componentsOut,
+                                           componentRanges,
+                                           extent,
+                                           excludeMaskVolume);
+}
+
+/**
+ * Label the connected components of the voxels in several value ranges with
+ * one pass over the volume.  A voxel belongs to the first range that contains
+ * its value and is only connected to voxels in the same range.
+ * "componentRangesOut" contains the index of the range of each component.
+ * All other arguments are as in labelConnectedComponents().
+ *
+ * Slabs of slices are labeled in parallel with union-find, the slabs are
+ * merged at their boundaries, and a final pass numbers the components.
+ * Returns the number of components.
+ */
+int
+VolumeFile::labelConnectedComponentsInRanges(const std::vector<float>& minValues,
+                                             const std::vector<float>& maxValues,
+                                             const CONNECTIVITY connectivity,
+                                             std::vector<int>& labelsOut,
+                                             std::vector<ConnectedComponent>& componentsOut,
+                                             std::vector<int>& componentRangesOut,
+                                             const int* extent,
+                                             const VolumeFile* excludeMaskVolume) const
+{
+   labelsOut.clear();
+   componentsOut.clear();
+   componentRangesOut.clear();
+   
+   const int dimX = dimensions[0];
+   const int dimY = dimensions[1];
+   const int dimZ = dimensions[2];
+   const int sliceSize = dimX * dimY;
+   const int numVoxels = sliceSize * dimZ;
+   if (numVoxels <= 0) {
+      return 0;
+   }
+   labelsOut.resize(numVoxels, 0);
+   
+   int region[6] = { 0, dimX, 0, dimY, 0, dimZ };
+   if (extent != NULL) {
+      for (int i = 0; i < 6; i++) {
+         region[i] = extent[i];
+      }
+      clampVoxelDimension(VOLUME_AXIS_X, region[0]);
+      clampVoxelDimension(VOLUME_AXIS_X, region[1]);
+      clampVoxelDimension(VOLUME_AXIS_Y, region[2]);
+      clampVoxelDimension(VOLUME_AXIS_Y, region[3]);
+      clampVoxelDimension(VOLUME_AXIS_Z, region[4]);
+      clampVoxelDimension(VOLUME_AXIS_Z, region[5]);
+   }
+   if ((region[0] >= region[1]) ||
+       (region[2] >= region[3]) ||
+       (region[4] >= region[5])) {
+      return 0;
+   }
+   
+   //
+   // Neighbors that precede a voxel in storage order
+   //
+   int maxNonZeroOffsets = 1;
+   switch (connectivity) {
+      case CONNECTIVITY_6:
+         maxNonZeroOffsets = 1;
          break;
-      case VOLUME_AXIS_Y:
-         sliceNum = seed[1];
+      case CONNECTIVITY_18:
+         maxNonZeroOffsets = 2;
          break;
-      case VOLUME_AXIS_Z:
+      case CONNECTIVITY_26:
+         maxNonZeroOffsets = 3;
+         break;
+   }
+   int neighborDI[13], neighborDJ[13], neighborDK[13];
+   int numNeighbors = 0;
+   for (int dk = -1; dk <= 0; dk++) {
+      for (int dj = -1; dj <= 1; dj++) {
+         for (int di = -1; di <= 1; di++) {
+            const bool precedes = (dk < 0) ||
+                                  ((dk == 0) && ((dj < 0) || ((dj == 0) && (di < 0))));
+            const int numNonZero = ((di != 0) ? 1 : 0)
+                                 + ((dj != 0) ? 1 : 0)
+                                 + ((dk != 0) ? 1 : 0);
+            if (precedes && (numNonZero <= maxNonZeroOffsets)) {
+               neighborDI[numNeighbors] = di;
+               neighborDJ[numNeighbors] = dj;
+               neighborDK[numNeighbors] = dk;
+               numNeighbors++;
+            }
+         }
+      }
+   }
+   
+   //
+   // Voxels that are labeled start in their own set, all others are -1.
+   // The parent of a voxel never follows it in storage order.  The range
+   // of each voxel is only needed if there is more than one range.
+   //
+   const int numRanges = std::min(minValues.size(), maxValues.size());
+   std::vector<int> parent(numVoxels, -1);
+   std::vector<unsigned char> voxelRange;
+   if (numRanges > 1) {
+      voxelRange.resize(numVoxels, 0);
+   }
+   const float* maskVoxels = NULL;
+   int maskComponents = 1;
+   if (excludeMaskVolume != NULL) {
+      maskVoxels = excludeMaskVolume->voxels;
+      maskComponents = excludeMaskVolume->numberOfComponentsPerVoxel;
+   }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int k = region[4]; k < region[5]; k++) {
+      for (int j = region[2]; j < region[3]; j++) {
+         for (int i = region[0]; i < region[1]; i++) {
+            const int indx = i + j * dimX + k * sliceSize;
+            if ((maskVoxels != NULL) &&
+                (maskVoxels[indx * maskComponents] != 0.0)) {
+               continue;
+            }
+            const float value = voxels[indx * numberOfComponentsPerVoxel];
+            for (int r = 0; r < numRanges; r++) {
+               if ((value >= minValues[r]) && (value <= maxValues[r])) {
+                  parent[indx] = indx;
+                  if (numRanges > 1) {
+                     voxelRange[indx] = r;
+                  }
+                  break;
+               }
+            }
+         }
+      }
+   }
+   
+   //
+   // Label each slab of slices, skipping the connections to the slice
+   // before the slab so that a slab only modifies its own voxels
+   //
+   const int numSlices = region[5] - region[4];
+   int numSlabs = 1;
+#ifdef _OPENMP
+   numSlabs = std::min(omp_get_max_threads(), numSlices);
+#endif
+   std::vector<int> slabStart(numSlabs + 1);
+   for (int s = 0; s <= numSlabs; s++) {
+      slabStart[s] = region[4] + (numSlices * s) / numSlabs;
+   }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+   for (int s = 0; s < numSlabs; s++) {
+      for (int k = slabStart[s]; k < slabStart[s + 1]; k++) {
+         for (int j = region[2]; j < region[3]; j++) {
+            for (int i = region[0]; i < region[1]; i++) {
+               const int indx = i + j * dimX + k * sliceSize;
+               if (parent[indx] < 0) {
+                  continue;
+               }
+               for (int n = 0; n < numNeighbors; n++) {
+                  const int ni = i + neighborDI[n];
+                  const int nj = j + neighborDJ[n];
+                  const int nk = k + neighborDK[n];
+                  if ((ni < region[0]) || (ni >= region[1]) ||
+                      (nj < region[2]) || (nj >= region[3]) ||
+                      (nk < slabStart[s])) {
+                     continue;
+                  }
+                  const int neighborIndex = ni + nj * dimX + nk * sliceSize;
+                  if ((parent[neighborIndex] >= 0) &&
+                      (voxelRange.empty() ||
+                       (voxelRange[neighborIndex] == voxelRange[indx]))) {
+                     mergeConnectedComponents(parent, indx, neighborIndex);
+                  }
+               }
+            }
+         }
+      }
+   }
+   
+   //
+   // Merge the slabs
+   //
+   for (int s = 1; s < numSlabs; s++) {
+      const int k = slabStart[s];
+      for (int j = region[2]; j < region[3]; j++) {
+         for (int i = region[0]; i < region[1]; i++) {
+            const int indx = i + j * dimX + k * sliceSize;
+            if (parent[indx] < 0) {
+               continue;
+            }
+            for (int n = 0; n < numNeighbors; n++) {
+               if (neighborDK[n] == 0) {
+                  continue;
+               }
+               const int ni = i + neighborDI[n];
+               const int nj = j + neighborDJ[n];
+               if ((ni < region[0]) || (ni >= region[1]) ||
+                   (nj < region[2]) || (nj >= region[3])) {
+                  continue;
+               }
+               const int neighborIndex = ni + nj * dimX + (k - 1) * sliceSize;
+               if ((parent[neighborIndex] >= 0) &&
+                   (voxelRange.empty() ||
+                    (voxelRange[neighborIndex] == voxelRange[indx]))) {
+                  mergeConnectedComponents(parent, indx, neighborIndex);
+               }
+            }
+         }
+      }
+   }
+   
+   //
+   // Number the components and accumulate their statistics.  Voxels are
+   // visited in storage order so a voxel's parent already points to its root.
+   //
+   std::vector<double> centroidSums;
+   for (int k = region[4]; k < region[5]; k++) {
+      for (int j = region[2]; j < region[3]; j++) {
+         for (int i = region[0]; i < region[1]; i++) {
+            const int indx = i + j * dimX + k * sliceSize;
+            if (parent[indx] < 0) {
+               continue;
+            }
+            const int root = parent[parent[indx]];
+            parent[indx] = root;
+            
+            int label = 0;
+            if (root == indx) {
+               ConnectedComponent component;
+               component.firstVoxel.setIJK(i, j, k);
+               component.extent[0] = i;
+               component.extent[1] = i;
+               component.extent[2] = j;
+               component.extent[3] = j;
+               component.extent[4] = k;
+               component.extent[5] = k;
+               componentsOut.push_back(component);
+               componentRangesOut.push_back(voxelRange.empty() ? 0 : voxelRange[indx]);
+               centroidSums.push_back(0.0);
+               centroidSums.push_back(0.0);
+               centroidSums.push_back(0.0);
+               label = componentsOut.size();
+            }
+            else {
+               label = labelsOut[root];
+            }
+            labelsOut[indx] = label;
+            
+            ConnectedComponent& component = componentsOut[label - 1];
+            component.numberOfVoxels++;
+            component.extent[0] = std::min(component.extent[0], i);
+            component.extent[1] = std::max(component.extent[1], i);
+            component.extent[2] = std::min(component.extent[2], j);
+            component.extent[3] = std::max(component.extent[3], j);
+            component.extent[5] = k;
+            double* sums = &centroidSums[(label - 1) * 3];
+            sums[0] += i;
+            sums[1] += j;
+            sums[2] += k;
+         }
+      }
+   }
+   
+   const int numComponents = componentsOut.size();
+   for (int m = 0; m < numComponents; m++) {
+      ConnectedComponent& component = componentsOut[m];
+      for (int i = 0; i < 3; i++) {
+         component.centroid[i] = centroidSums[m * 3 + i] / component.numberOfVoxels;
+      }
+   }
+   
+   return numComponents;
+}
+
+/**
+ * remove islands (all but the largest connected piece of surface).
+ * returns true if islands were removed
+ */
+bool 
+VolumeFile::removeIslandsFromSegmentation()
+{
+   //
+   // Find the pieces of surface
+   //
+   std::vector<int> labels;
+   std::vector<ConnectedComponent> components;
+   const int numObjects = labelConnectedComponents(255.0, 255.0, CONNECTIVITY_6,
+                                                   labels, components);
+   if (numObjects > 1) {
+      int biggestLabel = 0;
+      int biggestCount = 0;
+      for (int m = 0; m < numObjects; m++) {
+         if (components[m].getNumberOfVoxels() > biggestCount) {
+            biggestCount = components[m].getNumberOfVoxels();
+            biggestLabel = m + 1;
+         }
+      }
+      
+      //
+      // Keep only the biggest piece of surface
+      //
+      const int numVoxels = labels.size();
+      for (int i = 0; i < numVoxels; i++) {
+         const float value = ((labels[i] == biggestLabel) ? 255.0 : 0.0);
+         for (int m = 0; m < numberOfComponentsPerVoxel; m++) {
+            voxels[i * numberOfComponentsPerVoxel + m] = value;
+         }
+      }
+      setModified();
+      minMaxVoxelValuesValid = false;
+      minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
+      setVoxelColoringInvalid();
+      return true;
+   }
+   
+   return false;
+}
+
+/**
+ * flood fill slice with VTK.
+ */
+void 
+VolumeFile::floodFillSliceWithVTK(const VolumeFile::VOLUME_AXIS axis,
+                             const int seed[3],
+                             const int connectedValueIn,
+                             const int connectedValueOut,
+                             const int unconnectedValueOut,
+                             VolumeModification* modifiedVoxels)
+{
+   int sliceNum = 0;
+   switch (axis) {
+      case VOLUME_AXIS_X:
+         sliceNum = seed[0];
+         break;
+      case VOLUME_AXIS_Y:
+         sliceNum = seed[1];
+         break;
+      case VOLUME_AXIS_Z:
          sliceNum = seed[2];
          break;
       case VOLUME_AXIS_ALL:
@@ -6728,7 +7228,7 @@ VolumeFile::floodFillSliceWithVTK(const VolumeFile::VOLUME_AXIS axis,
 }
       
 /**
- * flood fill with VTK.
+ * flood fill the voxels 6 connected to the seed.
  */
 void 
 VolumeFile::floodFillWithVTK(const int seed[3],
@@ -6746,7 +7246,9 @@ VolumeFile::floodFillWithVTK(const int seed[3],
 }
                             
 /**
- * flood fill with VTK.
+ * Flood fill.  Voxels with the value "connectedValueIn" that are 6 connected
+ * to the seed are set to "connectedValueOut" and all other voxels are set to
+ * "unconnectedValueOut".
  */
 void 
 VolumeFile::floodFillWithVTK(const VoxelIJK& seedVoxel,
@@ -6769,22 +7271,32 @@ VolumeFile::floodFillWithVTK(const VoxelIJK& seedVoxel,
    if (modifiedVoxels != NULL) {
       copyOfVolume = new VolumeFile(*this);
    }
-   vtkStructuredPoints* sp = convertToVtkStructuredPoints(true);
    
-   vtkImageSeedConnectivity* connect = vtkImageSeedConnectivity::New();
-   connect->SetInput(sp);
-   connect->SetInputConnectValue(connectedValueIn);
-   connect->SetOutputConnectedValue(connectedValueOut);
-   connect->SetOutputUnconnectedValue(unconnectedValueOut);
+   //
+   // Find the voxels connected to the seed
+   //
+   std::vector<int> labels;
+   std::vector<ConnectedComponent> components;
+   labelConnectedComponents(connectedValueIn, connectedValueIn, CONNECTIVITY_6,
+                            labels, components);
    int i, j, k;
    seedVoxel.getIJK(i, j, k);
-   connect->AddSeed(i, j, k);
-   connect->Update();
-   
-   convertFromVtkImageData(connect->GetOutput());
+   int seedLabel = 0;
+   if (getVoxelIndexValid(i, j, k)) {
+      seedLabel = labels[i + j * dimensions[0] + k * dimensions[0] * dimensions[1]];
+   }
    
-   connect->Delete();
-   sp->Delete();
+   const int numVoxels = labels.size();
+   for (int n = 0; n < numVoxels; n++) {
+      float value = unconnectedValueOut;
+      if ((seedLabel > 0) && (labels[n] == seedLabel)) {
+         value = connectedValueOut;
+      }
+      for (int m = 0; m < numberOfComponentsPerVoxel; m++) {
+         voxels[n * numberOfComponentsPerVoxel + m] = value;
+      }
+   }
+   setVoxelColoringInvalid();
    
    setModified();
    minMaxVoxelValuesValid = false;
@@ -7430,81 +7942,33 @@ VolumeFile::imposeLimits(const int limits[6])
 }
 
 /**
- *
+ * Replace the volume with the shell of voxels that are removed by
+ * eroding it or added by dilating it.
  */
 void	
 VolumeFile::makeShellVolume(const int Ndilation, 
                                const int Nerosion)
 {
    const int numVoxels = getTotalNumberOfVoxels();
-   VolumeFile vol2(*this);
-   VolumeFile vol3(*this);
-	for (int i = 0; i < numVoxels; i++) {
-	   vol2.voxels[i] = 0;
-   }
+   const std::vector<float> original(voxels, voxels + numVoxels);
+   const int region[6] = { 
+      0, dimensions[0] - 1,
+      0, dimensions[1] - 1,
+      0, dimensions[2] - 1
+   };
    
-   int localNeighsOffset[26];
-	for (int i = 0; i < 26; i++){
-	   const int ii = localNeighbors[i][0];
-	   const int jj = localNeighbors[i][1];
-	   const int kk = localNeighbors[i][2];
-	   localNeighsOffset[i] = ii + (jj * dimensions[0]) + (kk * dimensions[0] * dimensions[1]); 
-	}
-
-   for (int i = 0; i < numVoxels; i++) {
-     vol3.voxels[i] = voxels[i];
-   }
-
+   std::vector<int> shellVoxels;
    if (Nerosion > 0) {
-      for (int j = 0; j < Nerosion; j++) {
-         if ((j % 2) == 0) {
-            const int cnt = stripBorderVoxels(localNeighsOffset, 6, &vol2);
-            if (DebugControl::getDebugOn()) {
-               std::cout << "\tErode 6 neighs " << j << "; " << cnt << " voxels..."
-                         << std::endl;
-            }
-         }
-         else {
-            const int cnt = stripBorderVoxels(localNeighsOffset, 26, &vol2);
-            if (DebugControl::getDebugOn()) {
-               std::cout << "\tErode 26 neighs " << j << "; " << cnt << " voxels..."
-                         << std::endl;
-            }
-         }
-      }
+      erodeBorderVoxels(Nerosion, 255.0, 0.0, region, &shellVoxels);
+      std::copy(original.begin(), original.end(), voxels);
    }
-
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = vol3.voxels[i];
+   if (Ndilation > 0) {
+      erodeBorderVoxels(Ndilation, 0.0, 255.0, region, &shellVoxels);
    }
 
-	int cnt = 0;
-	if (Ndilation > 0){
-	   for (int i = 0; i < numVoxels; i++)
-	      voxels[i] = 255 - voxels[i];	
-           for (int i = 0; i < Ndilation; i++){
-              if ((i % 2) == 0){
-                 cnt = stripBorderVoxels(localNeighsOffset, 6, &vol2);
-                 if (DebugControl::getDebugOn()) {
-                    std::cout << "\tDilate 6 neighs " << i << "; " << cnt << " voxels..."
-                              << std::endl;
-                 }
-              }
-              else {
-                 cnt = stripBorderVoxels(localNeighsOffset, 26, &vol2);
-                 if (DebugControl::getDebugOn()) {
-                    std::cout << "\tDilate 26 neighs " << i << "; " << cnt << " voxels..."
-                              << std::endl;
-                 }
-              }
-           }
-	   for (int i = 0; i < numVoxels; i++) {
-	      voxels[i] = 255 - voxels[i];	
-      }
-	}
-
-	for (int i = 0; i < numVoxels; i++) {
-	   voxels[i] = vol2.voxels[i];	
+   std::fill(voxels, voxels + numVoxels, 0.0f);
+   for (unsigned int i = 0; i < shellVoxels.size(); i++) {
+      voxels[shellVoxels[i]] = 255.0;
    }
 
    setModified();
@@ -7512,60 +7976,6 @@ VolumeFile::makeShellVolume(const int Ndilation,
    minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
 }
 
-/**
- *
- */
-int
-VolumeFile::stripBorderVoxels(const int neighborOffsets[],
-		                           int numNeighs, 
-                                 VolumeFile *vol2)
-{
-   const int numVoxels = getTotalNumberOfVoxels();
-   int cnt = 0;
-   const int slices = dimensions[2] - 1;
-   const int rows   = dimensions[1] - 1;
-   const int columns = dimensions[0] - 1;
-   for (int k = 1; k < slices; k++) {
-	   if ((k % 50) == 0) {
-         if (DebugControl::getDebugOn()) {
-            std::cout << "\tslice " << k << std::endl;
-         }
-      }
-      for (int j = 1; j < rows; j++) {
-         for (int i = 1; i < columns; i++) {
-            int idx = getVoxelDataIndex(i, j, k);
-            if (voxels[idx] == 255) {
-               int neighs[26];
-               computeNeighbors(idx, neighborOffsets, numNeighs, neighs);
-               int n = 0;
-               bool done = false;
-               while ((n < numNeighs) && (done == false)) {
-                  if (voxels[neighs[n]] == 0) {
-                     done = true; // Found border voxel
-                     voxels[idx] = 127;
-                     cnt++; 
-                  }
-                  n++;
-               }
-	         }
-	      }
-	   }
-	}
-
- 	for (int idx = 0; idx < numVoxels; idx++){
-	   if (voxels[idx] == 127){
-	      vol2->voxels[idx] = 255;	
-	      voxels[idx] = 0;	
-	   }
-	}
-   
-   setModified();
-   minMaxVoxelValuesValid = false;
-   minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
-
-	return(cnt);
-}
-
 /**
  * Get the neighbors for a node given one-dimensional offsets.
  */
@@ -7632,13 +8042,28 @@ VolumeFile::makePlane(const float xslope,
 
 /**
  * dilation and erosion.
+ * Only voxels within the extent are changed.  The morphology is performed
+ * on the extent padded by the number of iterations since a voxel can only
+ * be affected by voxels that are within that many voxels of it.
  */
 void 
 VolumeFile::doVolMorphOpsWithinMask(const int extent[6], const int nDilation, const int nErosion) 
 {
    VolumeFile vf(*this);
    //vf.maskVolume(extent);
-   vf.doVolMorphOps(nDilation, nErosion);
+   const int pad = std::max(nDilation, 0) + std::max(nErosion, 0) + 1;
+   int region[6];
+   for (int i = 0; i < 3; i++) {
+      region[i*2]   = std::max(std::min(extent[i*2], extent[i*2+1]) - pad, 0);
+      region[i*2+1] = std::min(std::max(extent[i*2], extent[i*2+1]) + pad, 
+                               dimensions[i] - 1);
+   }
+   if (nDilation > 0) {
+      vf.erodeBorderVoxels(nDilation, 0.0, 255.0, region);
+   }
+   if (nErosion > 0) {
+      vf.erodeBorderVoxels(nErosion, 255.0, 0.0, region);
+   }
    unsigned char rgb[4];
    copySubVolume(&vf, extent, rgb, rgb);
    setModified();
@@ -7648,6 +8073,10 @@ VolumeFile::doVolMorphOpsWithinMask(const int extent[6], const int nDilation, co
 
 /**
  * dilation and erosion.
+ * Dilation grows the 255 voxels into the 0 voxels and erosion shrinks the
+ * 255 voxels; both alternate between 6 and 26 connected neighbors on 
+ * successive iterations, starting with 6.  Voxels on the edges of the
+ * volume are never changed.
  */
 void 
 VolumeFile::doVolMorphOps(const int nDilation, const int nErosion) 
@@ -7657,54 +8086,20 @@ VolumeFile::doVolMorphOps(const int nDilation, const int nErosion)
                 << nErosion << " erosion iters" << std::endl;
    }
    
-   int localNeighsOffset[26];
-	for (int i = 0; i < 26; i++) {
-	   const int ii = localNeighbors[i][0];
-	   const int jj = localNeighbors[i][1];
-	   const int kk = localNeighbors[i][2];
-	   localNeighsOffset[i] = ii + (jj * dimensions[0]) + (kk * dimensions[0] * dimensions[1]); 
-	}
-
-   const int numVoxels = getTotalNumberOfVoxels();
-	int cnt = 0;
-	if (nDilation > 0){
-	   for (int i = 0; i < numVoxels; i++) {
-	      voxels[i] = 255.0 - voxels[i];	
-      }
-      for (int i = 0; i < nDilation; i++){
-         if ((i % 2) == 0){
-            cnt = stripBorderVoxels(localNeighsOffset, 6);
-            if (DebugControl::getDebugOn()) {
-               std::cout << "\tDilate 6 neighs " << i << "; " << cnt << " voxels...\n" << std::endl;
-            }
-         }
-         else{
-            cnt = stripBorderVoxels(localNeighsOffset, 26);
-            if (DebugControl::getDebugOn()) {
-               std::cout << "\tDilate 26 neighs " << i << "; " << cnt << " voxels...\n" << std::endl;
-            }
-         }
-      }
-	   for (int i = 0; i < numVoxels; i++)
-	      voxels[i] = 255.0 - voxels[i];	
-	}
-
-	cnt = 0;
-   if (nErosion > 0){
-      for (int j = 0; j < nErosion; j++) {
-         if ((j % 2) == 0) {
-            cnt = stripBorderVoxels(localNeighsOffset, 6);
-            if (DebugControl::getDebugOn()) {
-               std::cout << "\tErode 6 neighs " << j << "; " << cnt << " voxels...\n" << std::endl;
-            }
-         }
-         else {
-            cnt = stripBorderVoxels(localNeighsOffset, 26);
-            if (DebugControl::getDebugOn()) {
-               std::cout << "\tErode 26 neighs " << j << "; " << cnt << " voxels...\n" << std::endl;
-            }
-         }
-      }
+   const int region[6] = { 
+      0, dimensions[0] - 1,
+      0, dimensions[1] - 1,
+      0, dimensions[2] - 1
+   };
+   
+   //
+   // Dilation is erosion of the 0 voxels by the 255 voxels
+   //
+   if (nDilation > 0) {
+      erodeBorderVoxels(nDilation, 0.0, 255.0, region);
+   }
+   if (nErosion > 0) {
+      erodeBorderVoxels(nErosion, 255.0, 0.0, region);
    }
    setModified();
    minMaxVoxelValuesValid = false;
@@ -7712,61 +8107,169 @@ VolumeFile::doVolMorphOps(const int nDilation, const int nErosion)
 }
 
 /**
- * ??
+ * Erode the voxels with the value "foregroundValue" that neighbor voxels 
+ * with the value "backgroundValue" for the given number of iterations.
+ * Iterations alternate between 6 and 26 connected neighbors (starting 
+ * with 6) and eroded voxels are set to the background value.  Only voxels
+ * inside (not on the faces of) the inclusive region are eroded.  Voxels in
+ * the region that already hold the value halfway between the foreground 
+ * and background (rounded toward the background) are set to the background
+ * by the first iteration.  If "changedVoxelsOut" is not NULL, the index 
+ * of each voxel that is changed is appended to it.
+ *
+ * The first two iterations scan the region.  After that, a voxel can only
+ * be eroded by a 6 connected neighbor eroded in the previous iteration or
+ * a 26 connected neighbor eroded in either of the two previous iterations
+ * (any other background neighbor would have eroded it earlier), so only
+ * the neighbors of those voxels are examined and the cost of each 
+ * iteration is proportional to the number of voxels it erodes.
  */
-int
-VolumeFile::stripBorderVoxels(const int neighborOffsets[], 
-                                 const int numNeighs)
-{
-	/* Mark border voxels */
-   if (DebugControl::getDebugOn()) {
-   	std::cout << "StripBorderVoxels ..." << std::endl;
-   }
+void 
+VolumeFile::erodeBorderVoxels(const int numIterations,
+                              const float foregroundValue,
+                              const float backgroundValue,
+                              const int region[6],
+                              std::vector<int>* changedVoxelsOut)
+{
+   const int dimX = dimensions[0];
+   const int dimY = dimensions[1];
+   const int dimXY = dimX * dimY;
+   const float pendingValue = (foregroundValue > backgroundValue) 
+                        ? std::floor((foregroundValue + backgroundValue) * 0.5)
+                        : std::ceil((foregroundValue + backgroundValue) * 0.5);
+
+   int neighborOffsets[26];
+   for (int i = 0; i < 26; i++) {
+      neighborOffsets[i] = localNeighbors[i][0] 
+                         + localNeighbors[i][1] * dimX 
+                         + localNeighbors[i][2] * dimXY;
+   }
+   
+   int numThreads = 1;
+#ifdef _OPENMP
+   numThreads = omp_get_max_threads();
+#endif
+   std::vector<std::vector<int> > threadCandidates(numThreads);
    
-   const int nslices = dimensions[2];
-   const int nrow    = dimensions[1];
-   const int ncol    = dimensions[0];
+   //
+   // Voxels eroded by the previous two iterations
+   //
+   std::vector<int> previousFrontier;
+   std::vector<int> frontier;
+   std::vector<int> candidates;
    
-   int cnt = 0;
-   for (int k = 1; k < nslices-1; k++){
-      if ((k % 20) == 0) {
-         if (DebugControl::getDebugOn()) {
-            std::cout << "\tslice " << k << std::endl;
+   for (int iter = 0; iter < numIterations; iter++) {
+      const int numNeighs = ((iter % 2) == 0) ? 6 : 26;
+      for (int t = 0; t < numThreads; t++) {
+         threadCandidates[t].clear();
+      }
+      
+      if (iter < 2) {
+         //
+         // Scan the region for foreground voxels with a background neighbor
+         //
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+         for (int k = region[4]; k <= region[5]; k++) {
+            int threadNum = 0;
+#ifdef _OPENMP
+            threadNum = omp_get_thread_num();
+#endif
+            std::vector<int>& found = threadCandidates[threadNum];
+            for (int j = region[2]; j <= region[3]; j++) {
+               for (int i = region[0]; i <= region[1]; i++) {
+                  const int idx = i + j * dimX + k * dimXY;
+                  if ((iter == 0) && (voxels[idx] == pendingValue)) {
+                     found.push_back(idx);
+                     continue;
+                  }
+                  if ((i == region[0]) || (i == region[1]) ||
+                      (j == region[2]) || (j == region[3]) ||
+                      (k == region[4]) || (k == region[5]) ||
+                      (voxels[idx] != foregroundValue)) {
+                     continue;
+                  }
+                  for (int n = 0; n < numNeighs; n++) {
+                     if (voxels[idx + neighborOffsets[n]] == backgroundValue) {
+                        found.push_back(idx);
+                        break;
+                     }
+                  }
+               }
+            }
          }
       }
-      for (int j = 1; j < nrow-1; j++) {
-         for (int i = 1; i < ncol-1; i++) {
-            const int idx = getVoxelDataIndex(i, j, k);
-	         if (voxels[idx] == 255.0) {
-               int neighs[26];
-	            computeNeighbors(idx, neighborOffsets,
-                                 numNeighs, neighs);
-	            int n = 0;
-	            bool done = false;
-	            while ((n < numNeighs) && (done == false)) {
-	               if (voxels[neighs[n]] == 0){
-                     done = true; // Found border voxel
-                     voxels[idx] = 127.0;
-                     cnt++; 
-	               }
-                  n++;
-	            }
-	         }
-	      }
-	   }
-	}
-
-   const int numVoxels = getTotalNumberOfVoxels();
- 	for (int idx = 0; idx < numVoxels; idx++) {
-	   if (voxels[idx] == 127.0) {
-	      voxels[idx] = 0.0;	
+      else {
+         //
+         // Foreground neighbors of recently eroded voxels
+         //
+         candidates = frontier;
+         if (numNeighs == 26) {
+            candidates.insert(candidates.end(), previousFrontier.begin(), 
+                              previousFrontier.end());
+         }
+         const int numCandidates = static_cast<int>(candidates.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+         for (int m = 0; m < numCandidates; m++) {
+            int threadNum = 0;
+#ifdef _OPENMP
+            threadNum = omp_get_thread_num();
+#endif
+            const int idx = candidates[m];
+            const int i = idx % dimX;
+            const int j = (idx / dimX) % dimY;
+            const int k = idx / dimXY;
+            for (int n = 0; n < numNeighs; n++) {
+               const int ni = i + localNeighbors[n][0];
+               const int nj = j + localNeighbors[n][1];
+               const int nk = k + localNeighbors[n][2];
+               if ((ni > region[0]) && (ni < region[1]) &&
+                   (nj > region[2]) && (nj < region[3]) &&
+                   (nk > region[4]) && (nk < region[5])) {
+                  const int nidx = idx + neighborOffsets[n];
+                  if (voxels[nidx] == foregroundValue) {
+                     threadCandidates[threadNum].push_back(nidx);
+                  }
+               }
+            }
+         }
+      }
+      
+      //
+      // Erode the voxels found (a voxel may be found more than once)
+      //
+      previousFrontier.swap(frontier);
+      frontier.clear();
+      for (int t = 0; t < numThreads; t++) {
+         const std::vector<int>& found = threadCandidates[t];
+         for (unsigned int m = 0; m < found.size(); m++) {
+            const int idx = found[m];
+            if (voxels[idx] != backgroundValue) {
+               voxels[idx] = backgroundValue;
+               frontier.push_back(idx);
+            }
+         }
+      }
+      if (changedVoxelsOut != NULL) {
+         changedVoxelsOut->insert(changedVoxelsOut->end(), frontier.begin(), frontier.end());
+      }
+      
+      if (DebugControl::getDebugOn()) {
+         std::cout << "\tErode " << numNeighs << " neighs " << iter << "; " 
+                   << frontier.size() << " voxels..." << std::endl;
+      }
+      
+      if (frontier.empty() && previousFrontier.empty() && (iter >= 1)) {
+         break;
       }
    }
    
    setModified();
    minMaxVoxelValuesValid = false;
    minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
-	return (cnt);
 }
 
 /**
@@ -7866,344 +8369,269 @@ VolumeFile::blur()
 }
 
 /**
- *
+ * Convolve a volume with the same kernel along each of its three axes.
+ * The kernel has five taps (this is the legacy interface used by blur()).
  */
 void	
 VolumeFile::seperableConvolve(int ncol, int nrow, int nslices, 
 	                            	float *volume, float *filter)
 {
-	int	isize = ncol*nrow;
-
-	//printf ("\tSeperableConvolve filtersize=%d\n", FSIZE); 
-	float* Result = new float[ncol*nrow*nslices];
-	float* TempSpace = new float[ncol*nrow*nslices];
-
-	float* voxel = volume; 
-	float* tempResult = Result;
-	oneDimConvolve (voxel, tempResult, filter, 0, 1, ncol, nrow, nslices);	
-	//printf ("%d %f %f\n", idx, voxel[idx], tempResult[idx]);
-
-	voxel = Result; 
-	tempResult = TempSpace;
-	oneDimConvolve (voxel, tempResult, filter, 1, ncol, ncol, nrow, nslices);	
-	//printf ("%d %f %f\n", idx, voxel[idx], tempResult[idx]);
-
-	voxel = TempSpace; 
-	tempResult = volume;
-	oneDimConvolve (voxel, tempResult, filter, 2, isize, ncol, nrow, nslices);
-	//printf ("%d %f %f\n", idx, voxel[idx], tempResult[idx]);
-
-	delete[] Result; 
-	delete[] TempSpace; 
-	return;
+   const std::vector<float> kernel(filter, filter + 5);
+   separableConvolve(ncol, nrow, nslices, volume, kernel, kernel, kernel);
 }
 
 /**
+ * Convolve a volume separably with a one-dimensional kernel for each axis.
+ * Each kernel must have an odd number of elements (otherwise an exception
+ * is thrown) and is centered on the voxel; voxels beyond the edges of the volume take the value of the
+ * nearest edge voxel.  The volume is filtered along X, then Y, then Z and
+ * the weighted sum for each voxel is accumulated in kernel order, so the
+ * result is identical to a direct evaluation of the convolution.
  *
+ * Each pass copies the data it reads (a row, a slice, or all slices of one
+ * row) into a per-thread region of a single scratch buffer and writes its
+ * output back into the volume, so inner loops run over contiguous rows.
  */
-void	
-VolumeFile::oneDimConvolve (float *voxel, float *tempResult, float *filter, 
-                const int dim, const int inc,
-		          const int ncol, const int nrow, const int nslices)
-{
-   const int FILTSIZE = 5;
-	float	p[FILTSIZE];
-
-	int cnt = 0;
-	for (int k = 0; k < nslices; k++){
-	   for (int j = 0; j < nrow; j++){
-	      for (int i = 0; i < ncol; i++){
-             float* ip = voxel;	 
-             if (dim == 0){
-                if (i == 0){
-                   p[0] = *ip;
-                   p[1] = *ip;
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                        }
-                else if (i == 1) {
-                   p[0] = *(ip-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-                else if (i == ncol-2) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc);
-                }
-                else if (i == ncol-1) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *ip;
-                   p[4] = *ip;
-                }
-                else {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-             }
-             else if (dim == 1) {
-                if (j == 0){
-                   p[0] = *ip;
-                   p[1] = *ip;
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                        }
-                else if (j == 1) {
-                   p[0] = *(ip-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-                else if (j == nrow-2) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc);
-                }
-                else if (j == nrow-1) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *ip;
-                   p[4] = *ip;
-                }
-	             else {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-             }
-             else if (dim == 2) {
-                if (k == 0){
-                   p[0] = *ip;
-                   p[1] = *ip;
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                        }
-                else if (k == 1) {
-                   p[0] = *(ip-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-                else if (k == nslices-2) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc);
-                }
-                else if (k == nslices-1) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *ip;
-                   p[4] = *ip;
-                }
-                else {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-             }
-             *tempResult = 0;
-             for (int n = 0; n < FILTSIZE; n++){
-               *tempResult += filter[n]*p[n];
-             }
-             tempResult++;
-             voxel++;
-             cnt++;
-	      }
-	   }
-	}
-}
-
-void	
-VolumeFile::breadthFirstFloodFill(const VoxelIJK& seed, 
-                                     const float valueToFind, 
-                                     VolumeFile *markVolume,
-                                     const float markValue,
-                                     const bool onlyDoUnmarkedVoxels) const
+void 
+VolumeFile::separableConvolve(const int ncol, const int nrow, const int nslices,
+                              float* volume,
+                              const std::vector<float>& filterX,
+                              const std::vector<float>& filterY,
+                              const std::vector<float>& filterZ) throw (FileException)
 {
    //
-   // See if this voxel has already been searched
+   // An even length kernel has no center voxel and would shift the volume
    //
-   if (onlyDoUnmarkedVoxels) {
-      if (markVolume->getVoxel(seed) == markValue) {
-         return;
-      }
+   if (((filterX.size() % 2) == 0) ||
+       ((filterY.size() % 2) == 0) ||
+       ((filterZ.size() % 2) == 0)) {
+      throw FileException("Convolution kernels must have an odd number of elements.");
    }
-
+   
+   if ((ncol <= 0) || (nrow <= 0) || (nslices <= 0)) {
+      return;
+   }
+   
+   const int sliceSize = ncol * nrow;
+   const int radiusX = static_cast<int>(filterX.size()) / 2;
+   
    //
-   // Initialize to the staring voxel
+   // Scratch space needed by one thread for any of the passes
    //
-   std::stack<VoxelIJK> st;
-   st.push(VoxelIJK(seed));
-    
+   const int scratchPerThread = std::max(ncol + 2 * radiusX,
+                                         std::max(sliceSize, ncol * nslices));
+   int numThreads = 1;
+#ifdef _OPENMP
+   numThreads = omp_get_max_threads();
+#endif
+   std::vector<float> scratch(static_cast<long>(scratchPerThread) * numThreads);
+   
    //
-   // Keep track of voxels that have been searched
+   // X pass: each row is copied with its edge voxels replicated so that
+   // the kernel never runs off the row
    //
-   const int numVoxels = getTotalNumberOfVoxels();
-   if (numVoxels <= 0) {
-      return;
-   }
-   int* voxelSearched = new int[numVoxels];
-   for (int i = 0; i < numVoxels; i++) {
-      if (getVoxelWithFlatIndex(i) == valueToFind) {
-         voxelSearched[i] = false;
-      }
-      else {
-         voxelSearched[i] = true;
-      }
-      if (onlyDoUnmarkedVoxels) {
-         if (markVolume->getVoxelWithFlatIndex(i) == markValue) {
-            voxelSearched[i] = true;
+   if (filterX.size() > 1) {
+      const int numTaps = static_cast<int>(filterX.size());
+      const int numRows = nrow * nslices;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+      for (int row = 0; row < numRows; row++) {
+         int threadNum = 0;
+#ifdef _OPENMP
+         threadNum = omp_get_thread_num();
+#endif
+         float* line = &scratch[static_cast<long>(scratchPerThread) * threadNum];
+         float* out = volume + static_cast<long>(row) * ncol;
+         for (int i = 0; i < radiusX; i++) {
+            line[i] = out[0];
+            line[radiusX + ncol + i] = out[ncol - 1];
          }
+         std::copy(out, out + ncol, line + radiusX);
+         convolveRow(out, line, &filterX[0], numTaps, ncol);
       }
    }
    
    //
-   // While there are voxels to process
+   // Y pass: each slice is copied and rows beyond the edges are clamped
    //
-   while (st.empty() == false) {
-      //
-      // Get the next voxel to process
-      //
-      const VoxelIJK v = st.top();
-      st.pop();
-      int i, j, k;
-      v.getIJK(i, j, k);
+   if (filterY.size() > 1) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+      for (int k = 0; k < nslices; k++) {
+         int threadNum = 0;
+#ifdef _OPENMP
+         threadNum = omp_get_thread_num();
+#endif
+         float* plane = &scratch[static_cast<long>(scratchPerThread) * threadNum];
+         float* out = volume + static_cast<long>(k) * sliceSize;
+         std::copy(out, out + sliceSize, plane);
+         convolveAxis(out, plane, ncol, ncol, nrow, filterY);
+      }
+   }
+   
+   //
+   // Z pass: tiled by row so that a thread only touches one row from each
+   // slice rather than striding through the volume one slice at a time
+   //
+   if (filterZ.size() > 1) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+      for (int j = 0; j < nrow; j++) {
+         int threadNum = 0;
+#ifdef _OPENMP
+         threadNum = omp_get_thread_num();
+#endif
+         float* tile = &scratch[static_cast<long>(scratchPerThread) * threadNum];
+         for (int k = 0; k < nslices; k++) {
+            const float* row = volume + static_cast<long>(k) * sliceSize + j * ncol;
+            std::copy(row, row + ncol, tile + k * ncol);
+         }
+         convolveAxis(volume + j * ncol, tile, sliceSize, ncol, nslices, filterZ);
+      }
+   }
+}
 
-      //
-      // If the voxel has valid indices
-      //
-      if ((i >= 0) && (i < dimensions[0]) &&
-          (j >= 0) && (j < dimensions[1]) &&
-          (k >= 0) && (k < dimensions[2])) {
-         const int ijk[3] = { i, j, k };
-         const float currentValue = getVoxel(ijk);
-         
-         //
-         // See if voxel has been searched
-         //
-         const int flatIndex = getVoxelDataIndex(ijk);
-         if (voxelSearched[flatIndex] == false) {
-            voxelSearched[flatIndex] = true;
-         
-            //
-            // See if voxel has proper value for operation
-            //
-            if (currentValue == valueToFind) {
-               //
-               // Update the voxels value
-               //
-               markVolume->setVoxel(ijk, 0, markValue);
-               
-               //
-               // Add neighboring voxels for search
-               //
-               std::vector<VoxelIJK> newVoxels;
-               newVoxels.reserve(6);
-               newVoxels.push_back(VoxelIJK(i - 1, j, k));
-               newVoxels.push_back(VoxelIJK(i + 1, j, k));
-               newVoxels.push_back(VoxelIJK(i, j - 1, k));
-               newVoxels.push_back(VoxelIJK(i, j + 1, k));
-               newVoxels.push_back(VoxelIJK(i, j, k - 1));
-               newVoxels.push_back(VoxelIJK(i, j, k + 1));
-               
-               for (unsigned int i = 0; i < 6; i++) {
-                  const VoxelIJK& v= newVoxels[i];
-                  if (getVoxelIndexValid(v)) {
-                     const int flatIndex = getVoxelDataIndex(v);
-                     if (voxelSearched[flatIndex] == false) {
-                        st.push(v);
-                     }
-                  }
-               }
-            }
+/**
+ * Convolve rows of data along the axis whose elements are "inputStride"
+ * apart in "input" and "outputStride" apart in "output".  The input
+ * holds "numRows" rows of "ncol" elements; positions beyond the first
+ * and last rows take the values of those rows.
+ */
+void 
+VolumeFile::convolveAxis(float* output, const float* input,
+                         const int outputStride, const int ncol, const int numRows,
+                         const std::vector<float>& filter)
+{
+   const int numTaps = static_cast<int>(filter.size());
+   const int radius = numTaps / 2;
+   std::vector<const float*> rows(numTaps);
+   for (int j = 0; j < numRows; j++) {
+      for (int n = 0; n < numTaps; n++) {
+         const int r = std::min(std::max(j + n - radius, 0), numRows - 1);
+         rows[n] = input + r * ncol;
+      }
+      float* out = output + static_cast<long>(j) * outputStride;
+      for (int i = 0; i < ncol; i++) {
+         out[i] = 0.0;
+      }
+      for (int n = 0; n < numTaps; n++) {
+         const float weight = filter[n];
+         const float* in = rows[n];
+         for (int i = 0; i < ncol; i++) {
+            out[i] += weight * in[i];
          }
       }
    }
-   
-   delete[] voxelSearched;
 }
 
 /**
- * Fill internal cavities in a segmentation volume.
+ * Convolve a single row that has been padded by the kernel radius on each
+ * side.  Tap "n" of output element "i" is input element "i + n".
  */
 void 
-VolumeFile::fillSegmentationCavities(const VolumeFile* markVolumeIn)
+VolumeFile::convolveRow(float* output, const float* input,
+                        const float* filter, const int numTaps, const int ncol)
 {
-   //
-   // Volume to keep track of unset voxels
-   //
-   VolumeFile* markVolume = NULL;
-   if (markVolumeIn != NULL) {
-      markVolume = new VolumeFile(*markVolumeIn);
+   for (int i = 0; i < ncol; i++) {
+      output[i] = 0.0;
    }
-   else {
-      markVolume = new VolumeFile(*this);
-      markVolume->setAllVoxels(0.0);
+   for (int n = 0; n < numTaps; n++) {
+      const float weight = filter[n];
+      const float* in = input + n;
+      for (int i = 0; i < ncol; i++) {
+         output[i] += weight * in[i];
+      }
+   }
+}
+
+/**
+ * Create a normalized one-dimensional Gaussian kernel.  The standard 
+ * deviation is in voxels and the kernel extends "cutoffInSigmas" standard
+ * deviations on each side of its center.  A non-positive standard 
+ * deviation produces the identity kernel.
+ */
+void 
+VolumeFile::createGaussianKernel(const float sigma, 
+                                 std::vector<float>& kernelOut,
+                                 const float cutoffInSigmas)
+{
+   kernelOut.clear();
+   if (sigma <= 0.0) {
+      kernelOut.push_back(1.0);
+      return;
+   }
+   
+   const int radius = std::max(1, static_cast<int>(std::ceil(sigma * cutoffInSigmas)));
+   kernelOut.resize(radius * 2 + 1);
+   double sum = 0.0;
+   for (int i = -radius; i <= radius; i++) {
+      const double w = std::exp(-(i * i) / (2.0 * sigma * sigma));
+      kernelOut[i + radius] = w;
+      sum += w;
+   }
+   for (unsigned int i = 0; i < kernelOut.size(); i++) {
+      kernelOut[i] = kernelOut[i] / sum;
+   }
+}
+
+/**
+ * Smooth the volume with a Gaussian kernel.  The standard deviations
+ * are in millimeters along each axis.
+ */
+void 
+VolumeFile::gaussianBlur(const float sigmaX, const float sigmaY, const float sigmaZ)
+                         throw (FileException)
+{
+   const float sigmas[3] = { sigmaX, sigmaY, sigmaZ };
+   std::vector<float> kernels[3];
+   for (int i = 0; i < 3; i++) {
+      const float voxelSize = std::fabs(spacing[i]);
+      createGaussianKernel((voxelSize > 0.0) ? (sigmas[i] / voxelSize) : 0.0,
+                           kernels[i]);
    }
    
+   separableConvolve(dimensions[0], dimensions[1], dimensions[2], voxels,
+                     kernels[0], kernels[1], kernels[2]);
+   setModified();
+   minMaxVoxelValuesValid = false;
+   minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
+}
+
+/**
+ * Fill internal cavities in a segmentation volume.  Voxels that are nonzero
+ * in the mark volume are neither searched nor filled.
+ */
+void 
+VolumeFile::fillSegmentationCavities(const VolumeFile* markVolumeIn)
+{
    //
-   // Find voxels along edges that are not set
+   // Find the connected sets of unset voxels
    //
-   const int imax = dimensions[0] - 1;
-   const int jmax = dimensions[1] - 1;
-   const int kmax = dimensions[2] - 1;
-   for (int k = 0; k <= kmax; k++) {
-      for (int j = 0; j <= jmax; j++) {
-         for (int i = 0; i <= imax; i++) {
-            //
-            // is this an edge voxel
-            //
-            if ((i == 0) || (i == imax) ||
-                (j == 0) || (j == jmax) ||
-                (k == 0) || (k == kmax)) {
-               if (markVolume->getVoxel(i, j, k) == 0.0) {
-                  if (getVoxel(i, j, k) == 0.0) {
-                     VoxelIJK seed(i, j, k);
-                     breadthFirstFloodFill(seed, 
-                                           0.0,
-                                           markVolume,
-                                           1.0,
-                                           true);
-                  }
-               }
-            }
-         }
-      }
-   }
+   std::vector<int> labels;
+   std::vector<ConnectedComponent> components;
+   const int numObjects = labelConnectedComponents(0.0, 0.0, CONNECTIVITY_6,
+                                                   labels, components,
+                                                   NULL, markVolumeIn);
    
    //
-   // If there are any other voxels not marked and not 255 set them because
-   // they must be cavities in the segmentation
+   // Sets of unset voxels that do not reach the edges of the volume
+   // must be cavities in the segmentation
    //
-   const int numVoxels = getTotalNumberOfVoxels();
+   std::vector<bool> cavityFlags(numObjects + 1, false);
+   for (int m = 0; m < numObjects; m++) {
+      int extent[6];
+      components[m].getExtent(extent);
+      cavityFlags[m + 1] = ((extent[0] > 0) && (extent[1] < (dimensions[0] - 1)) &&
+                            (extent[2] > 0) && (extent[3] < (dimensions[1] - 1)) &&
+                            (extent[4] > 0) && (extent[5] < (dimensions[2] - 1)));
+   }
+   const int numVoxels = labels.size();
    for (int i = 0; i < numVoxels; i++) {
-      if ((voxels[i] == 0.0) &&
-          (markVolume->voxels[i] == 0.0)) {
-         voxels[i] = 255.0;
+      if (cavityFlags[labels[i]]) {
+         voxels[i * numberOfComponentsPerVoxel] = 255.0;
       }
    }
    setModified();
@@ -8211,8 +8639,6 @@ VolumeFile::fillSegmentationCavities(const VolumeFile* markVolumeIn)
    minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
    
    setVoxelColoringInvalid();
-   
-   delete markVolume;
 }
       
 /**
@@ -8291,8 +8717,9 @@ VolumeFile::invertSegmentationVoxels()
 int 
 VolumeFile::getNumberOfSegmentationObjects() const
 {
-   VoxelIJK seed;
-   return findBiggestObject(255.0, 255.0, seed);
+   std::vector<int> labels;
+   std::vector<ConnectedComponent> components;
+   return labelConnectedComponents(255.0, 255.0, CONNECTIVITY_6, labels, components);
 }
 
 /**
@@ -8301,20 +8728,82 @@ VolumeFile::getNumberOfSegmentationObjects() const
 int 
 VolumeFile::getNumberOfSegmentationObjectsSubVolume(const int extent[6]) const
 {
-   VolumeFile volumeCopy(*this);
-   volumeCopy.maskVolume(extent);
-   return volumeCopy.getNumberOfSegmentationObjects();
+   std::vector<int> labels;
+   std::vector<ConnectedComponent> components;
+   return labelConnectedComponents(255.0, 255.0, CONNECTIVITY_6, labels, components,
+                                   extent);
 }
 
 /**
- * get the number of cavities in a segmentation volume.
+ * Count the segmentation objects and cavities in a subvolume with a single
+ * labeling of its set and unset voxels.  Voxels outside the extent are
+ * treated as unset so a cavity is a connected set of unset voxels within
+ * the extent that does not reach the edges of the extent.
+ */
+void 
+VolumeFile::countSegmentationObjectsAndCavitiesSubVolume(const int extentIn[6],
+                                                         int& numberOfObjectsOut,
+                                                         int& numberOfCavitiesOut) const
+{
+   numberOfObjectsOut = 0;
+   numberOfCavitiesOut = 0;
+   
+   int extent[6];
+   for (int i = 0; i < 6; i++) {
+      extent[i] = extentIn[i];
+   }
+   clampVoxelDimension(VOLUME_AXIS_X, extent[0]);
+   clampVoxelDimension(VOLUME_AXIS_X, extent[1]);
+   clampVoxelDimension(VOLUME_AXIS_Y, extent[2]);
+   clampVoxelDimension(VOLUME_AXIS_Y, extent[3]);
+   clampVoxelDimension(VOLUME_AXIS_Z, extent[4]);
+   clampVoxelDimension(VOLUME_AXIS_Z, extent[5]);
+   
+   //
+   // Range 0 is the objects, range 1 is the unset voxels
+   //
+   std::vector<float> minValues, maxValues;
+   minValues.push_back(255.0);
+   maxValues.push_back(255.0);
+   minValues.push_back(0.0);
+   maxValues.push_back(0.0);
+   std::vector<int> labels;
+   std::vector<ConnectedComponent> components;
+   std::vector<int> componentRanges;
+   const int numComponents = labelConnectedComponentsInRanges(minValues, maxValues,
+                                                              CONNECTIVITY_6,
+                                                              labels, components,
+                                                              componentRanges, extent);
+   
+   for (int m = 0; m < numComponents; m++) {
+      if (componentRanges[m] == 0) {
+         numberOfObjectsOut++;
+         continue;
+      }
+      int objectExtent[6];
+      components[m].getExtent(objectExtent);
+      if ((objectExtent[0] > extent[0]) && (objectExtent[1] < (extent[1] - 1)) &&
+          (objectExtent[2] > extent[2]) && (objectExtent[3] < (extent[3] - 1)) &&
+          (objectExtent[4] > extent[4]) && (objectExtent[5] < (extent[5] - 1))) {
+         numberOfCavitiesOut++;
+      }
+   }
+}
+
+/**
+ * get the number of cavities in a segmentation volume.  Voxels outside the
+ * extent are treated as unset so a cavity is a connected set of unset voxels
+ * within the extent that does not reach the edges of the extent.
  */
 int 
 VolumeFile::getNumberOfSegmentationCavitiesSubVolume(const int extent[6]) const
 {
-   VolumeFile volumeCopy(*this);
-   volumeCopy.maskVolume(extent);
-   return volumeCopy.getNumberOfSegmentationCavities();
+   int numberOfObjects = 0;
+   int numberOfCavities = 0;
+   countSegmentationObjectsAndCavitiesSubVolume(extent,
+                                                numberOfObjects,
+                                                numberOfCavities);
+   return numberOfCavities;
 }
 
 /**
@@ -8323,47 +8812,12 @@ VolumeFile::getNumberOfSegmentationCavitiesSubVolume(const int extent[6]) const
 int 
 VolumeFile::getNumberOfSegmentationCavities() const
 {
-   //
-   // Make a copy of "this" volume
-   //
-   VolumeFile volumeCopy(*this);
-   
-   //
-   // Flood fill around using all exterior voxels
-   //
-   const int maxDimX = dimensions[0] - 1;
-   const int maxDimY = dimensions[1] - 1;
-   const int maxDimZ = dimensions[2] - 1;
-   const unsigned char rgb4[4] = { 255, 0, 0, 0 };
-   for (int i = 0; i <= maxDimX; i++) {
-      for (int j = 0; j <= maxDimY; j++) {
-         for (int k = 0; k <= maxDimZ; k++) {
-            if ((i == 0) || (i == maxDimX) ||
-                (j == 0) || (j == maxDimY) ||
-                (k == 0) || (k == maxDimZ)) {
-               if (getVoxel(i, j, k, 0) == 0.0) {
-                  
-                  const int ijk[3] = { i, j, k };
-                  volumeCopy.floodFillAndRemoveConnected(SEGMENTATION_OPERATION_FLOOD_FILL_3D,
-                                              VOLUME_AXIS_Z,
-                                              ijk,
-                                              255.0,
-                                              rgb4);
-               }
-            }
-         }
-      }
-   }
-   
-   //
-   // Invert the voxels
-   //
-   volumeCopy.invertSegmentationVoxels();
-   
-   //
-   // Count the objects
-   //
-   return volumeCopy.getNumberOfSegmentationObjects();
+   const int extent[6] = {
+      0, dimensions[0],
+      0, dimensions[1],
+      0, dimensions[2]
+   };
+   return getNumberOfSegmentationCavitiesSubVolume(extent);
 }
 
 /**
@@ -8424,8 +8878,9 @@ VolumeFile::getEulerCountsForSegmentationSubVolume(int& numberOfObjects,
                                          int& eulerCount,
                                          const int extent[6]) const
 {
-   numberOfObjects  = getNumberOfSegmentationObjectsSubVolume(extent);
-   numberOfCavities = getNumberOfSegmentationCavitiesSubVolume(extent);
+   countSegmentationObjectsAndCavitiesSubVolume(extent,
+                                                numberOfObjects,
+                                                numberOfCavities);
    eulerCount       = getEulerNumberForSegmentationSubVolume(extent);
    numberOfHoles    = numberOfObjects + numberOfCavities - eulerCount;
 }                         
@@ -10628,20 +11083,27 @@ VolumeFile::readFileAnalyze(const QString& fileNameIn,
 }                          
 
 /**
- * read the specified sub-volumes in a volume file.
+ * read the header of a NIFTI volume file.  The header information is placed
+ * into "volumeRead" and "dataFile" is left open and positioned after the 
+ * header and its extensions.  If "separateImageFileFlag" is true, the voxels
+ * are in an image file (hdr/img pair) that is opened with
+ * openFileNiftiImageFile().
  */
 void 
-VolumeFile::readFileNifti(const QString& fileNameIn, 
-                          const int readSelection,
-                          std::vector<VolumeFile*>& volumesReadOut) throw (FileException)
+VolumeFile::readFileNiftiHeader(const QString& fileNameIn,
+                                VolumeFile& volumeRead,
+                                gzFile& dataFile,
+                                bool& byteSwapFlag,
+                                long& niftiReadDataOffset,
+                                bool& separateImageFileFlag,
+                                std::vector<StudyMetaDataLinkSet>& studyMetaDataLinkSets,
+                                QString& caretExtensionString) throw (FileException)
 {
-
    //
    // Open the file
    //
-   VolumeFile volumeRead;
    volumeRead.filename = fileNameIn;
-   gzFile dataFile = gzopen(fileNameIn.toAscii().constData(), "rb");
+   dataFile = gzopen(fileNameIn.toAscii().constData(), "rb");
    if (dataFile == NULL) {
       throw FileException(fileNameIn, "Unable to open with ZLIB for reading.");
    }
@@ -10659,12 +11121,19 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
    //
    // Do bytes need to be swapped ?
    //
-   bool byteSwapFlag = niftiFileHeader.doesDataNeedByteSwapping();
+   byteSwapFlag = niftiFileHeader.doesDataNeedByteSwapping();
    
    //
    // Offset of data
    //
-   const long niftiReadDataOffset = static_cast<unsigned long>(hdr.vox_offset);
+   niftiReadDataOffset = static_cast<unsigned long>(hdr.vox_offset);
+   
+   //
+   // Voxels are in a separate file for a NIFTI hdr/img volume file pair
+   //
+   separateImageFileFlag = ((hdr.magic[0] == 'n') &&
+                            (hdr.magic[1] == 'i') &&
+                            (hdr.magic[2] == '1'));
    
    //
    // Get volume dimensions
@@ -10988,7 +11457,7 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
    //
    // Storage for study meta data links
    //
-   std::vector<StudyMetaDataLinkSet> studyMetaDataLinkSets;
+   studyMetaDataLinkSets.clear();
    
    //
    // Intention string and TR
@@ -11001,7 +11470,7 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
    volumeRead.niftiIntentParameter3 = hdr.intent_p3;
    volumeRead.niftiTR = hdr.slice_duration;
 
-   QString caretExtensionString = "";
+   caretExtensionString = "";
 
    //
    // Read the extender
@@ -11165,11 +11634,74 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
    // Keep track of data files zipped status
    //   
    volumeRead.dataFileWasZippedFlag = (volumeRead.filename.right(3) == ".gz");
+}
+
+/**
+ * open the image file of a NIFTI hdr/img volume file pair.  The image
+ * file may be gzipped.
+ */
+gzFile 
+VolumeFile::openFileNiftiImageFile(const QString& fileNameIn,
+                                   VolumeFile& volumeRead) throw (FileException)
+{
+   //
+   // Create the volume data file name
+   //
+   volumeRead.dataFileName = FileUtilities::filenameWithoutExtension(volumeRead.filename);
+   volumeRead.dataFileName.append(".img");
+
+   //
+   // Data file might be gzipped
+   //
+   if (QFile::exists(volumeRead.dataFileName) == false) {
+      QString zipName(volumeRead.dataFileName);
+      zipName.append(".gz");
+      if (QFile::exists(zipName)) {
+         volumeRead.dataFileName = zipName;
+      }
+   }
+
+   gzFile dataFile = gzopen(volumeRead.dataFileName.toAscii().constData(), "rb");
+   if (dataFile == NULL) {
+      throw FileException(fileNameIn, "Unable to open with ZLIB for reading.");
+   }
+   
+   return dataFile;
+}
+
+/**
+ * read the specified sub-volumes in a volume file.
+ */
+void 
+VolumeFile::readFileNifti(const QString& fileNameIn, 
+                          const int readSelection,
+                          std::vector<VolumeFile*>& volumesReadOut) throw (FileException)
+{
+
+   //
+   // Read the header
+   //
+   VolumeFile volumeRead;
+   gzFile dataFile = NULL;
+   bool byteSwapFlag = false;
+   long niftiReadDataOffset = 0;
+   bool separateImageFileFlag = false;
+   std::vector<StudyMetaDataLinkSet> studyMetaDataLinkSets;
+   QString caretExtensionString;
+   readFileNiftiHeader(fileNameIn,
+                       volumeRead,
+                       dataFile,
+                       byteSwapFlag,
+                       niftiReadDataOffset,
+                       separateImageFileFlag,
+                       studyMetaDataLinkSets,
+                       caretExtensionString);
 
    //
    // If only reading header
    //
    if (readSelection == -2) {
+      gzclose(dataFile);
       VolumeFile* vf = new VolumeFile;
       vf->copyVolumeData(volumeRead, false);
       vf->filename = volumeRead.filename;
@@ -11181,31 +11713,9 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
    //
    // Is this a NIFTI hdr/img volume file pair
    //
-   if ((hdr.magic[0] == 'n') &&
-       (hdr.magic[1] == 'i') &&
-       (hdr.magic[2] == '1')) {
+   if (separateImageFileFlag) {
       gzclose(dataFile);
-      //
-      // Create the volume data file name
-      //
-      volumeRead.dataFileName = FileUtilities::filenameWithoutExtension(volumeRead.filename);
-      volumeRead.dataFileName.append(".img");
-
-      //
-      // Data file might be gzipped
-      //
-      if (QFile::exists(volumeRead.dataFileName) == false) {
-         QString zipName(volumeRead.dataFileName);
-         zipName.append(".gz");
-         if (QFile::exists(zipName)) {
-            volumeRead.dataFileName = zipName;
-         }
-      }
-
-      dataFile = gzopen(volumeRead.dataFileName.toAscii().constData(), "rb");
-      if (dataFile == NULL) {
-         throw FileException(fileNameIn, "Unable to open with ZLIB for reading.");
-      }
+      dataFile = openFileNiftiImageFile(fileNameIn, volumeRead);
    }
    
    try {         
@@ -14530,144 +15040,33 @@ VolumeFile::findObjectsWithinSegmentationVolume(std::vector<VoxelGroup>& objects
 {
    objectsOut.clear();
    
-   VoxelIJK bigSeed(-1, -1, -1);
-
-   int imin = 0;
-   int imax = 0;
-   int jmin = 0;
-   int jmax = 0;
-   int kmin = 0;
-   int kmax = 0;
-   getDimensions(imax, jmax, kmax);
-   
-   //
-   // Make sure search region is within the volume
-   //
-   clampVoxelDimension(VOLUME_AXIS_X, imin);
-   clampVoxelDimension(VOLUME_AXIS_X, imax);
-   clampVoxelDimension(VOLUME_AXIS_Y, jmin);
-   clampVoxelDimension(VOLUME_AXIS_Y, jmax);
-   clampVoxelDimension(VOLUME_AXIS_Z, kmin);
-   clampVoxelDimension(VOLUME_AXIS_Z, kmax);
-
-   const int numVoxels = getTotalNumberOfVoxels();
-   
-   const float minValue = 1.0;
-   const float maxValue = std::numeric_limits<float>::max();
+   std::vector<int> labels;
+   std::vector<ConnectedComponent> components;
+   const int numObjects = labelConnectedComponents(1.0,
+                                                   std::numeric_limits<float>::max(),
+                                                   CONNECTIVITY_6,
+                                                   labels,
+                                                   components);
+   if (numObjects <= 0) {
+      return;
+   }
    
    //
-   // single slice ?
+   // Place the voxels into their objects
    //
-	if ((imin == imax) || (jmin == jmax) || (kmin == kmax)) {
-      if (DebugControl::getDebugOn()) {
-         std::cout << "For x, y or z, min = max" << std::endl;
-      }
-   }
-	else {
-      //
-      // Create a flag for noting which voxels have been searched.
-      // Mark those within region and within min and max values NOT SEARCHED
-      // and all others SEARCHED.
-      //
-		VOXEL_SEARCH_STATUS* voxelSearched = new VOXEL_SEARCH_STATUS[numVoxels];
-		for (int k = 0; k < dimensions[2]; k++) {
-			for (int j = 0; j < dimensions[1]; j++) {
-				for (int i = 0; i < dimensions[0]; i++) {
-               const int idx = getVoxelDataIndex(i, j, k);
-               voxelSearched[idx] = VOXEL_SEARCHED;
-               if ((i >= imin) && (i < imax) &&
-                   (j >= jmin) && (j < jmax) &&
-                   (k >= kmin) && (k < kmax)) {
-                  if ((voxels[idx] >= minValue) &&
-                      (voxels[idx] <= maxValue)) {
-                     voxelSearched[idx] = VOXEL_NOT_SEARCHED;
-                  }
-               }
-				}
-			}
-		}
-	
-      //
-      // Find a voxel within value range that has not been searched
-      //
-      VoxelIJK seedVoxel;
-      bool voxelFound = findUnsearchedVoxel(minValue, maxValue, voxelSearched, seedVoxel);
-      
-      if (voxelFound == false) {
-         if (DebugControl::getDebugOn()) {
-            std::cout << "FindBiggestObjectWithinMask no initial voxel found with values: "
-                      << minValue << " " << maxValue << std::endl;
-         }
-      }
-      
-      //
-      // Loop through all objects
-      //
-      while (voxelFound) {
-         //
-         // Create a stack 
-         //
-         std::stack<VoxelIJK> stack;
-         stack.push(seedVoxel);
-         
-         //
-         // Stores voxels in the object
-         //
-         VoxelGroup voxelGroupObject;
-         
-         //
-         // While there are voxels to search
-         //
-         while (stack.empty() == false) {
-            //
-            // Get the next voxel to search
-            //
-            const VoxelIJK v = stack.top();
-            stack.pop();
-          
-            const int idx = getVoxelDataIndex(v.getIJK());
-            if (voxelSearched[idx] == VOXEL_NOT_SEARCHED) {
-               voxelSearched[idx] = VOXEL_SEARCHED;
-               
-               //
-               // Add voxel to group
-               //
-               voxelGroupObject.addVoxel(v);
-               
-               //
-               // Get the neighboring voxels
-               //
-               std::vector<VoxelIJK> neighbors;
-               getNeighbors(v, neighbors);
-               
-               //
-               // Add neighbors to stack
-               //
-               for (unsigned int i = 0; i < neighbors.size(); i++) {
-                  VoxelIJK& v = neighbors[i];
-                  const int idx = getVoxelDataIndex(v.getIJK());
-                  if (voxelSearched[idx] == VOXEL_NOT_SEARCHED) {
-                     stack.push(v);
-                  }
-               }
+   objectsOut.resize(numObjects);
+   int indx = 0;
+   for (int k = 0; k < dimensions[2]; k++) {
+      for (int j = 0; j < dimensions[1]; j++) {
+         for (int i = 0; i < dimensions[0]; i++) {
+            const int label = labels[indx];
+            if (label > 0) {
+               objectsOut[label - 1].addVoxel(VoxelIJK(i, j, k));
             }
-         }  // while (stack.isEmpty() == false)
-         
-         //
-         // Was an object found
-         //
-         if (voxelGroupObject.getNumberOfVoxels()) {
-            objectsOut.push_back(voxelGroupObject);
+            indx++;
          }
-         
-         //
-         // Find another voxel to search
-         //
-         voxelFound = findUnsearchedVoxel(minValue, maxValue, voxelSearched, seedVoxel);
-      } // while (voxelFound)
-
-		delete[] voxelSearched;
-	}	
+      }
+   }
 }
 
 /**
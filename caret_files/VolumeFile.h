@@ -93,6 +93,56 @@ class VolumeFile : public AbstractFile {
             std::vector<VoxelIJK> voxels;
       };
       
+      /// a connected component found by labelConnectedComponents()
+      class ConnectedComponent {
+         public:
+            /// constructor
+            ConnectedComponent() {
+               numberOfVoxels = 0;
+               for (int i = 0; i < 6; i++) {
+                  extent[i] = 0;
+               }
+               for (int i = 0; i < 3; i++) {
+                  centroid[i] = 0.0;
+               }
+            }
+            
+            /// get the number of voxels in the component
+            int getNumberOfVoxels() const { return numberOfVoxels; }
+            
+            /// get the extent (minimum and maximum I, J, K indices, inclusive)
+            void getExtent(int extentOut[6]) const {
+               for (int i = 0; i < 6; i++) {
+                  extentOut[i] = extent[i];
+               }
+            }
+            
+            /// get the centroid (in voxel indices)
+            void getCentroid(float centroidOut[3]) const {
+               for (int i = 0; i < 3; i++) {
+                  centroidOut[i] = centroid[i];
+               }
+            }
+            
+            /// get the first voxel of the component (in voxel storage order)
+            VoxelIJK getFirstVoxel() const { return firstVoxel; }
+            
+         protected:
+            /// number of voxels in the component
+            int numberOfVoxels;
+            
+            /// extent of the component
+            int extent[6];
+            
+            /// centroid of the component
+            float centroid[3];
+            
+            /// first voxel of the component
+            VoxelIJK firstVoxel;
+            
+         friend class VolumeFile;
+      };
+      
       /// type of volume
       enum VOLUME_TYPE {
          ///  anatomical volume
@@ -304,12 +354,14 @@ class VolumeFile : public AbstractFile {
          SCULPT_MODE_SEED_AND_NOT
       };
       
-      /// voxel search flags
-      enum VOXEL_SEARCH_STATUS {
-         /// voxel not searched
-         VOXEL_NOT_SEARCHED = 0,
-         /// voxel has been searched
-         VOXEL_SEARCHED = 1
+      /// voxel connectivity for labeling connected components
+      enum CONNECTIVITY {
+         /// voxels sharing a face are connected
+         CONNECTIVITY_6,
+         /// voxels sharing a face or an edge are connected
+         CONNECTIVITY_18,
+         /// voxels sharing a face, an edge, or a corner are connected
+         CONNECTIVITY_26
       };
       
       /// voxel coloring status
@@ -587,6 +639,11 @@ class VolumeFile : public AbstractFile {
       /// Get an "interpolate" voxel at the specified coordinate
       bool getInterpolatedVoxel(const float xyz[3], float& voxelValue);
       
+      /// Get the voxels and weights of an "interpolated" voxel (returns number of voxels)
+      int getInterpolatedVoxelWeights(const float xyz[3],
+                                      int voxelNumbersOut[8],
+                                      float weightsOut[8]) const;
+      
       /// get the voxel to surface distances (used by surface and volume rendering)
       float* getVoxelToSurfaceDistances();
       
@@ -981,6 +1038,15 @@ class VolumeFile : public AbstractFile {
       /// threshold volume (voxels below become 255, voxels above 0)
       void inverseThresholdVolume(const float thresholdValue);
 
+      /// label connected components of voxels in a value range (returns number of components)
+      int labelConnectedComponents(const float minValue,
+                                   const float maxValue,
+                                   const CONNECTIVITY connectivity,
+                                   std::vector<int>& labelsOut,
+                                   std::vector<ConnectedComponent>& componentsOut,
+                                   const int* extent = NULL,
+                                   const VolumeFile* excludeMaskVolume = NULL) const;
+      
       /// Find each of the disconnect objects (islands) within the volume.
       void findObjectsWithinSegmentationVolume(std::vector<VoxelGroup>& objectsOut) const;
       
@@ -1027,12 +1093,6 @@ class VolumeFile : public AbstractFile {
                              const float maxValue, 
                              VoxelIJK& bigseed) const;
                                        
-      /// find voxel with "value" that has not been searched
-      bool findUnsearchedVoxel(const float minValue,
-                              const float maxValue, 
-                              VOXEL_SEARCH_STATUS searchFlags[],
-                              VoxelIJK& seedOut) const;
-
 
       /// clamp a voxel index to within valid values (0 to dim-1)
       void clampVoxelIndex(const VOLUME_AXIS axis,
@@ -1059,14 +1119,14 @@ class VolumeFile : public AbstractFile {
                             const int unconnectedValueOut,
                             VolumeModification* modifiedVoxels = NULL);
                             
-      /// flood fill with VTK
+      /// flood fill the voxels 6 connected to the seed
       void floodFillWithVTK(const VoxelIJK& seedVoxel,
                             const int connectedValueIn,
                             const int connectedValueOut,
                             const int unconnectedValueOut,
                             VolumeModification* modifiedVoxels = NULL);
                             
-      /// flood fill with VTK
+      /// flood fill the voxels 6 connected to the seed
       void floodFillWithVTK(const int seed[3],
                             const int connectedValueIn,
                             const int connectedValueOut,
@@ -1130,16 +1190,14 @@ class VolumeFile : public AbstractFile {
       /// dilation and erosion within mask
       void doVolMorphOpsWithinMask(const int extent[6], const int nDilation, const int nErosion);
       
-      /// ??
-      int stripBorderVoxels(const int neighborOffsets[],
-                            int numNeighs, 
-                            VolumeFile *vol2);
-      
-      /// ??
-      int stripBorderVoxels(const int neighborOffsets[], 
-                            const int numNeighs);
+      /// erode foreground voxels next to background voxels (alternating 6/26 neighbors)
+      void erodeBorderVoxels(const int numIterations,
+                             const float foregroundValue,
+                             const float backgroundValue,
+                             const int region[6],
+                             std::vector<int>* changedVoxelsOut = NULL);
       
-      /// ??
+      /// replace with voxels removed by erosion or added by dilation
       void makeShellVolume(const int Ndilation, 
                            const int Nerosion);
                            
@@ -1162,22 +1220,26 @@ class VolumeFile : public AbstractFile {
       /// blue a volume
       void blur();
       
-      ///
+      /// smooth with a Gaussian (standard deviations in millimeters)
+      void gaussianBlur(const float sigmaX, const float sigmaY, const float sigmaZ)
+                                                     throw (FileException);
+      
+      /// convolve with a five tap kernel along each axis
       static void seperableConvolve(int ncol, int nrow, int nslices, 
 	                              	float *volume, float *filter);
                                     
-      ///
-      static void oneDimConvolve(float *voxel, float *tempResult, float *filter, 
-                         const int dim, const int inc,
-                         const int ncol, const int nrow, const int nslices);
-      
-      /// voxel 6 connected to seed are found in "this" volume
-      /// and set to "markValue" in the "mark" volume
-      void breadthFirstFloodFill(const VoxelIJK& seed, 
-                                 const float valueToFind, 
-                                 VolumeFile *markVolume,
-                                 const float markValue,
-                                 const bool onlyDoUnmarkedVoxels = false) const;
+      /// convolve with an odd length kernel for each axis
+      static void separableConvolve(const int ncol, const int nrow, const int nslices,
+                                    float* volume,
+                                    const std::vector<float>& filterX,
+                                    const std::vector<float>& filterY,
+                                    const std::vector<float>& filterZ)
+                                                     throw (FileException);
+      
+      /// create a normalized Gaussian kernel (standard deviation in voxels)
+      static void createGaussianKernel(const float sigma, 
+                                       std::vector<float>& kernelOut,
+                                       const float cutoffInSigmas = 3.0);
       
       /// Fill internal cavities in a segmentation volume.
       void fillSegmentationCavities(const VolumeFile* maskVolumeIn = NULL);
@@ -1287,6 +1349,35 @@ class VolumeFile : public AbstractFile {
       //************************************************************************
 
    protected:
+      /// label connected components of voxels in several value ranges with one pass (returns number of components)
+      int labelConnectedComponentsInRanges(const std::vector<float>& minValues,
+                                           const std::vector<float>& maxValues,
+                                           const CONNECTIVITY connectivity,
+                                           std::vector<int>& labelsOut,
+                                           std::vector<ConnectedComponent>& componentsOut,
+                                           std::vector<int>& componentRangesOut,
+                                           const int* extent = NULL,
+                                           const VolumeFile* excludeMaskVolume = NULL) const;
+      
+      /// count the objects and cavities in a segmentation subvolume with one labeling
+      void countSegmentationObjectsAndCavitiesSubVolume(const int extent[6],
+                                                        int& numberOfObjectsOut,
+                                                        int& numberOfCavitiesOut) const;
+      
+      /// replace the voxels by sampling through an affine index mapping
+      void resliceVoxels(const int outputDimensions[3],
+                         const double outputToInput[3][4],
+                         const INTERPOLATION_TYPE interpolationType);
+      
+      /// convolve rows of a slice or tile along one axis of a separable convolution
+      static void convolveAxis(float* output, const float* input,
+                               const int outputStride, const int ncol, const int numRows,
+                               const std::vector<float>& filter);
+      
+      /// convolve a single padded row
+      static void convolveRow(float* output, const float* input,
+                              const float* filter, const int numTaps, const int ncol);
+      
       /// read the specified sub-volumes in a volume file
       static void readFileAfni(const QString& fileNameIn, 
                            const int readSelection,
@@ -1303,6 +1394,20 @@ class VolumeFile : public AbstractFile {
                            const int readSelection,
                            std::vector<VolumeFile*>& volumesReadOut) throw (FileException);
       
+      /// read the header of a NIFTI volume file (data file left open after header)
+      static void readFileNiftiHeader(const QString& fileNameIn,
+                                      VolumeFile& volumeRead,
+                                      gzFile& dataFile,
+                                      bool& byteSwapFlag,
+                                      long& niftiReadDataOffset,
+                                      bool& separateImageFileFlag,
+                                      std::vector<StudyMetaDataLinkSet>& studyMetaDataLinkSets,
+                                      QString& caretExtensionString) throw (FileException);
+      
+      /// open the image file of a NIFTI hdr/img volume file pair
+      static gzFile openFileNiftiImageFile(const QString& fileNameIn,
+                                           VolumeFile& volumeRead) throw (FileException);
+      
       /// read the specified sub-volumes in an SPM volume file
       static void readFileSpm(const QString& fileNameIn, 
                            const int readSelection,
@@ -1591,6 +1696,8 @@ class VolumeFile : public AbstractFile {
       
       /// the euler table is valid
       static bool eulerTableValid;
+      
+   friend class VolumeFileSubVolumeStream;
 };
 
 #endif // __VE_VOLUME_FILE_NEW_H__
@@ -0,0 +1,345 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <QMutexLocker>
+
+#include "NiftiCaretExtension.h"
+#include "NiftiFileHeader.h"
+#include "SpecFile.h"
+#include "StringUtilities.h"
+#include "VolumeFile.h"
+#include "VolumeFileSubVolumeStream.h"
+
+/**
+ * Constructor.
+ */
+VolumeFileSubVolumeStream::VolumeFileSubVolumeStream()
+{
+   volumeHeader = NULL;
+   numberOfSubVolumes = 0;
+   nextSubVolumeNumber = 0;
+   maximumNumberOfSubVolumesReadAhead = 0;
+   niftiFlag = false;
+   niftiDataFile = NULL;
+   niftiByteSwapFlag = false;
+   niftiCaretExtensionOtherVolume = NULL;
+   readThread = NULL;
+   stopReadingFlag = false;
+}
+
+/**
+ * Destructor.
+ */
+VolumeFileSubVolumeStream::~VolumeFileSubVolumeStream()
+{
+   closeFile();
+}
+
+/**
+ * open a volume file for reading its sub-volumes.  The header is read
+ * immediately.  If "maximumNumberOfSubVolumesReadAheadIn" is greater than 
+ * zero, a thread reads up to that many sub-volumes ahead of the caller.
+ */
+void 
+VolumeFileSubVolumeStream::openFile(const QString& fileNameIn,
+                                    const int maximumNumberOfSubVolumesReadAheadIn) throw (FileException)
+{
+   closeFile();
+   
+   fileName = fileNameIn;
+   maximumNumberOfSubVolumesReadAhead = maximumNumberOfSubVolumesReadAheadIn;
+   
+   //
+   // hdr/image pair may be NIFTI
+   //
+   niftiFlag = (StringUtilities::endsWith(fileName, SpecFile::getNiftiVolumeFileExtension()) ||
+                StringUtilities::endsWith(fileName, SpecFile::getNiftiGzipVolumeFileExtension()));
+   if (StringUtilities::endsWith(fileName, SpecFile::getAnalyzeVolumeFileExtension())) {
+      niftiFlag = NiftiFileHeader::hdrIsNiftiFile(fileName);
+   }
+   
+   if (niftiFlag) {
+      //
+      // Read the header leaving the data stream open
+      //
+      VolumeFile volumeRead;
+      long niftiDataOffset = 0;
+      bool separateImageFileFlag = false;
+      VolumeFile::readFileNiftiHeader(fileName,
+                                      volumeRead,
+                                      niftiDataFile,
+                                      niftiByteSwapFlag,
+                                      niftiDataOffset,
+                                      separateImageFileFlag,
+                                      niftiStudyMetaDataLinkSets,
+                                      niftiCaretExtensionString);
+      try {
+         if (separateImageFileFlag) {
+            gzclose(niftiDataFile);
+            niftiDataFile = NULL;
+            niftiDataFile = VolumeFile::openFileNiftiImageFile(fileName, volumeRead);
+         }
+      }
+      catch (FileException& e) {
+         closeFile();
+         throw e;
+      }
+      
+      //
+      // Sub-volumes are read sequentially from the start of the voxel data
+      //
+      if (gzseek(niftiDataFile, niftiDataOffset, SEEK_SET) < 0) {
+         closeFile();
+         throw FileException(fileName, "Unable to seek to the voxel data.");
+      }
+      
+      volumeHeader = new VolumeFile;
+      volumeHeader->copyVolumeData(volumeRead, false);
+      volumeHeader->filename = volumeRead.filename;
+      volumeHeader->dataFileName = volumeRead.dataFileName;
+      
+      if (niftiCaretExtensionString.isEmpty() == false) {
+         niftiCaretExtensionOtherVolume = new VolumeFile;
+         niftiCaretExtensionOtherVolume->copyVolumeData(volumeRead, false);
+      }
+   }
+   else {
+      std::vector<VolumeFile*> volumes;
+      VolumeFile::readFile(fileName,
+                           VolumeFile::VOLUME_READ_HEADER_ONLY,
+                           volumes);
+      if (volumes.empty()) {
+         throw FileException(fileName, "Unable to read the volume header.");
+      }
+      volumeHeader = volumes[0];
+      for (unsigned int i = 1; i < volumes.size(); i++) {
+         delete volumes[i];
+      }
+   }
+   
+   numberOfSubVolumes = volumeHeader->getNumberOfSubVolumes();
+   
+   if ((maximumNumberOfSubVolumesReadAhead > 0) &&
+       (numberOfSubVolumes > 0)) {
+      readThread = new ReadThread(this);
+      readThread->start();
+   }
+}
+
+/**
+ * close the volume file.
+ */
+void 
+VolumeFileSubVolumeStream::closeFile()
+{
+   if (readThread != NULL) {
+      {
+         QMutexLocker locker(&readAheadMutex);
+         stopReadingFlag = true;
+         subVolumeTakenCondition.wakeAll();
+      }
+      readThread->wait();
+      delete readThread;
+      readThread = NULL;
+   }
+   
+   for (unsigned int i = 0; i < readAheadSubVolumes.size(); i++) {
+      delete readAheadSubVolumes[i];
+   }
+   readAheadSubVolumes.clear();
+   
+   if (niftiDataFile != NULL) {
+      gzclose(niftiDataFile);
+      niftiDataFile = NULL;
+   }
+   if (volumeHeader != NULL) {
+      delete volumeHeader;
+      volumeHeader = NULL;
+   }
+   if (niftiCaretExtensionOtherVolume != NULL) {
+      delete niftiCaretExtensionOtherVolume;
+      niftiCaretExtensionOtherVolume = NULL;
+   }
+   
+   fileName = "";
+   numberOfSubVolumes = 0;
+   nextSubVolumeNumber = 0;
+   niftiFlag = false;
+   niftiByteSwapFlag = false;
+   niftiStudyMetaDataLinkSets.clear();
+   niftiCaretExtensionString = "";
+   readErrorMessage = "";
+   stopReadingFlag = false;
+}
+
+/**
+ * read the next sub-volume.  Returns NULL if all sub-volumes have been
+ * read.  The caller must delete the sub-volume.
+ */
+VolumeFile* 
+VolumeFileSubVolumeStream::readNextSubVolume() throw (FileException)
+{
+   if (nextSubVolumeNumber >= numberOfSubVolumes) {
+      return NULL;
+   }
+   
+   //
+   // Read in this thread if not reading ahead
+   //
+   if (readThread == NULL) {
+      VolumeFile* vf = readSubVolume(nextSubVolumeNumber);
+      nextSubVolumeNumber++;
+      return vf;
+   }
+   
+   QMutexLocker locker(&readAheadMutex);
+   while (readAheadSubVolumes.empty() &&
+          readErrorMessage.isEmpty()) {
+      subVolumeReadCondition.wait(&readAheadMutex);
+   }
+   if (readAheadSubVolumes.empty()) {
+      throw FileException(fileName, readErrorMessage);
+   }
+   
+   VolumeFile* vf = readAheadSubVolumes.front();
+   readAheadSubVolumes.pop_front();
+   nextSubVolumeNumber++;
+   subVolumeTakenCondition.wakeAll();
+   
+   return vf;
+}
+
+/**
+ * loop run by the read thread.
+ */
+void 
+VolumeFileSubVolumeStream::readLoop()
+{
+   for (int i = 0; i < numberOfSubVolumes; i++) {
+      //
+      // Wait for space in the read ahead
+      //
+      {
+         QMutexLocker locker(&readAheadMutex);
+         while ((stopReadingFlag == false) &&
+                (static_cast<int>(readAheadSubVolumes.size()) >= maximumNumberOfSubVolumesReadAhead)) {
+            subVolumeTakenCondition.wait(&readAheadMutex);
+         }
+         if (stopReadingFlag) {
+            return;
+         }
+      }
+      
+      VolumeFile* vf = NULL;
+      QString errorMessage;
+      try {
+         vf = readSubVolume(i);
+      }
+      catch (FileException& e) {
+         errorMessage = e.whatQString();
+         if (errorMessage.isEmpty()) {
+            errorMessage = "Error reading sub-volume " + QString::number(i);
+         }
+      }
+      
+      QMutexLocker locker(&readAheadMutex);
+      if (vf != NULL) {
+         readAheadSubVolumes.push_back(vf);
+      }
+      else {
+         readErrorMessage = errorMessage;
+      }
+      subVolumeReadCondition.wakeAll();
+      if (vf == NULL) {
+         return;
+      }
+   }
+}
+
+/**
+ * read a sub-volume.  NIFTI sub-volumes are read from the data stream so
+ * they must be read in order.
+ */
+VolumeFile* 
+VolumeFileSubVolumeStream::readSubVolume(const int subVolumeNumber) throw (FileException)
+{
+   if (niftiFlag == false) {
+      std::vector<VolumeFile*> volumes;
+      VolumeFile::readFile(fileName,
+                           subVolumeNumber,
+                           volumes);
+      if (volumes.empty()) {
+         throw FileException(fileName, 
+                             "Unable to read sub-volume " + QString::number(subVolumeNumber));
+      }
+      for (unsigned int i = 1; i < volumes.size(); i++) {
+         delete volumes[i];
+      }
+      return volumes[0];
+   }
+   
+   //
+   // copy everything but voxel data from the header
+   //
+   VolumeFile* vf = new VolumeFile;
+   vf->copyVolumeData(*volumeHeader, false);
+   vf->filename = volumeHeader->filename;
+   vf->dataFileName = volumeHeader->dataFileName;
+   vf->descriptiveLabel = volumeHeader->subVolumeNames[subVolumeNumber];
+   
+   try {
+      vf->readVolumeFileData(niftiByteSwapFlag,
+                             vf->scaleSlope[subVolumeNumber],
+                             vf->scaleOffset[subVolumeNumber],
+                             niftiDataFile);
+      
+      if (subVolumeNumber < static_cast<int>(niftiStudyMetaDataLinkSets.size())) {
+         vf->setStudyMetaDataLinkSet(niftiStudyMetaDataLinkSets[subVolumeNumber]);
+      }
+      
+      //
+      // The caret extension is indexed by sub-volume
+      //
+      if (niftiCaretExtensionString.isEmpty() == false) {
+         std::vector<VolumeFile*> extensionVolumes(numberOfSubVolumes, 
+                                                   niftiCaretExtensionOtherVolume);
+         extensionVolumes[subVolumeNumber] = vf;
+         NiftiCaretExtension caretExtension(extensionVolumes, NULL, 5);
+         QString filesComment = "";
+         caretExtension.readAndApplyExtensionToVolumes(niftiCaretExtensionString,
+                                                       filesComment);
+      }
+   }
+   catch (FileException& e) {
+      delete vf;
+      throw e;
+   }
+   
+   vf->clearModified();
+   vf->setFileWriteType(VolumeFile::FILE_READ_WRITE_TYPE_NIFTI);
+   
+   return vf;
+}
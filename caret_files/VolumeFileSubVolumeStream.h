@@ -0,0 +1,155 @@
+#ifndef __VOLUME_FILE_SUB_VOLUME_STREAM_H__
+#define __VOLUME_FILE_SUB_VOLUME_STREAM_H__
+
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <deque>
+#include <vector>
+
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "FileException.h"
+#include "StudyMetaDataLinkSet.h"
+
+#include "zlib.h"
+
+class VolumeFile;
+
+/// Reads the sub-volumes of a volume file one at a time so that a long
+/// timeseries never needs to be in memory at once.  For NIFTI files (including
+/// gzipped NIFTI files), the voxels are read sequentially from one open stream by
+/// a background thread that reads and decompresses up to a fixed number of 
+/// sub-volumes ahead of the caller.  Other volume file types are read one 
+/// sub-volume at a time with VolumeFile::readFile().
+class VolumeFileSubVolumeStream {
+   public:
+      // constructor
+      VolumeFileSubVolumeStream();
+      
+      // destructor
+      ~VolumeFileSubVolumeStream();
+      
+      // open a volume file for reading its sub-volumes
+      void openFile(const QString& fileNameIn,
+                    const int maximumNumberOfSubVolumesReadAheadIn = 2) throw (FileException);
+      
+      // close the volume file
+      void closeFile();
+      
+      /// get the header of the volume file (contains no voxels)
+      const VolumeFile* getVolumeHeader() const { return volumeHeader; }
+      
+      /// get the number of sub-volumes
+      int getNumberOfSubVolumes() const { return numberOfSubVolumes; }
+      
+      /// get the number of the sub-volume returned by next call to readNextSubVolume()
+      int getNextSubVolumeNumber() const { return nextSubVolumeNumber; }
+      
+      // read the next sub-volume (returns NULL if no more sub-volumes, caller must delete)
+      VolumeFile* readNextSubVolume() throw (FileException);
+      
+   protected:
+      /// thread that reads sub-volumes ahead of the caller
+      class ReadThread : public QThread {
+         public:
+            /// constructor
+            ReadThread(VolumeFileSubVolumeStream* streamIn) 
+               : stream(streamIn) { }
+            
+         protected:
+            /// read the sub-volumes
+            void run() { stream->readLoop(); }
+            
+            /// the stream
+            VolumeFileSubVolumeStream* stream;
+      };
+      
+      // loop run by the read thread
+      void readLoop();
+      
+      // read a sub-volume (sub-volumes must be read in order)
+      VolumeFile* readSubVolume(const int subVolumeNumber) throw (FileException);
+      
+      /// name of the volume file
+      QString fileName;
+      
+      /// header of the volume file
+      VolumeFile* volumeHeader;
+      
+      /// number of sub-volumes
+      int numberOfSubVolumes;
+      
+      /// number of next sub-volume returned to caller
+      int nextSubVolumeNumber;
+      
+      /// maximum number of sub-volumes read ahead of caller
+      int maximumNumberOfSubVolumesReadAhead;
+      
+      /// volume file is a NIFTI file
+      bool niftiFlag;
+      
+      /// NIFTI voxel data stream
+      gzFile niftiDataFile;
+      
+      /// NIFTI voxel data needs byte swapping
+      bool niftiByteSwapFlag;
+      
+      /// NIFTI sub-volume study meta data links
+      std::vector<StudyMetaDataLinkSet> niftiStudyMetaDataLinkSets;
+      
+      /// NIFTI caret extension
+      QString niftiCaretExtensionString;
+      
+      /// receives caret extension of sub-volumes other than the one being read
+      VolumeFile* niftiCaretExtensionOtherVolume;
+      
+      /// the read thread
+      ReadThread* readThread;
+      
+      /// protects the sub-volumes read ahead and the read state
+      QMutex readAheadMutex;
+      
+      /// signalled when a sub-volume has been read
+      QWaitCondition subVolumeReadCondition;
+      
+      /// signalled when a sub-volume has been taken by the caller
+      QWaitCondition subVolumeTakenCondition;
+      
+      /// sub-volumes read ahead of the caller
+      std::deque<VolumeFile*> readAheadSubVolumes;
+      
+      /// error message from read thread
+      QString readErrorMessage;
+      
+      /// read thread should stop
+      bool stopReadingFlag;
+};
+
+#endif // __VOLUME_FILE_SUB_VOLUME_STREAM_H__
@@ -83,6 +83,48 @@ VtkModelFile::VtkModelFile(vtkPolyData* polyData)
    readPolyData(polyData);
 }
 
+/**
+ * Constructor (construct from a triangle mesh).
+ */
+VtkModelFile::VtkModelFile(const std::vector<float>& xyz,
+                           const std::vector<int>& trianglesIn,
+                           const std::vector<float>& normalsIn)
+   : AbstractFile("VTK Model File", 
+                  SpecFile::getVtkModelFileExtension(),
+                  false, 
+                  AbstractFile::FILE_FORMAT_ASCII,
+                  FILE_IO_READ_AND_WRITE,
+                  FILE_IO_NONE,
+                  FILE_IO_READ_AND_WRITE,
+                  FILE_IO_NONE)
+{
+   clear();
+   
+   const int numPoints = xyz.size() / 3;
+   coordinates.setNumberOfCoordinates(numPoints);
+   coordinates.setAllCoordinates(xyz);
+   coordinates.clearModified();
+   
+   if (static_cast<int>(normalsIn.size()) == (numPoints * 3)) {
+      pointNormals = normalsIn;
+   }
+   else {
+      pointNormals.resize(numPoints * 3);
+      for (int i = 0; i < numPoints; i++) {
+         pointNormals[i * 3]     = 0.0;
+         pointNormals[i * 3 + 1] = 0.0;
+         pointNormals[i * 3 + 2] = 1.0;
+      }
+   }
+   
+   triangles = trianglesIn;
+   
+   pointColors.resize(numPoints * 4, 170);
+   for (int i = 0; i < numPoints; i++) {
+      pointColors[i*4] = 255;
+   }
+}
+
 /**
  * Constructor - converts borders to VTK lines.
  */
@@ -77,6 +77,11 @@ class VtkModelFile : public AbstractFile {
       /// Constructor (construct from polydata)
       VtkModelFile(vtkPolyData* polyData);
       
+      /// Constructor (construct from a triangle mesh, 3 values per point/triangle/normal)
+      VtkModelFile(const std::vector<float>& xyz,
+                   const std::vector<int>& trianglesIn,
+                   const std::vector<float>& normalsIn);
+      
       /// Destructor
       ~VtkModelFile();
       
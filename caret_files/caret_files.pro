@@ -107,6 +107,7 @@ HEADERS += AbstractFile.h \
       VectorFile.h \
       VocabularyFile.h \
 	   VolumeFile.h \
+      VolumeFileSubVolumeStream.h \
       VolumeITKImage.h \
       VolumeModification.h \
 	   VtkModelFile.h \
@@ -211,6 +212,7 @@ SOURCES += AbstractFile.cxx \
       VectorFile.cxx \
       VocabularyFile.cxx \
 	   VolumeFile.cxx \
+      VolumeFileSubVolumeStream.cxx \
       VolumeITKImage.cxx \
       VolumeModification.cxx \
 	   VtkModelFile.cxx \
@@ -148,6 +148,7 @@ AbstractFile::AbstractFile(const QString& descriptiveNameIn,
    }
    
    writingQFile = NULL;
+   modificationSerialNumber = 0;
    
    //
    // Update copy constructor too
@@ -168,6 +169,7 @@ AbstractFile::AbstractFile(const QString& descriptiveNameIn,
    fileSupportXMLExternalBinary = FILE_IO_NONE;
    fileSupportOther    = supportsOtherFormat;
    fileSupportCommaSeparatedValueFile = supportsCsvfFormat;
+   fileSupportColumnarBinary = FILE_IO_NONE;
 
    displayListNumber = 0;
 
@@ -198,6 +200,7 @@ AbstractFile::AbstractFile(const QString& descriptiveNameIn,
  */
 AbstractFile::AbstractFile(const AbstractFile& af)
 {
+   modificationSerialNumber = 0;
    copyHelperAbstractFile(af);
 }
 
@@ -241,6 +244,7 @@ AbstractFile::copyHelperAbstractFile(const AbstractFile& af)
    fileSupportXMLExternalBinary = af.fileSupportXMLExternalBinary;
    fileSupportOther  = af.fileSupportOther;
    fileSupportCommaSeparatedValueFile = af.fileSupportCommaSeparatedValueFile;
+   fileSupportColumnarBinary = af.fileSupportColumnarBinary;
    enableAppendFileComment = af.enableAppendFileComment;
    readMetaDataOnlyFlag = af.readMetaDataOnlyFlag;
    rootXmlElementTagName = af.rootXmlElementTagName;
@@ -326,6 +330,7 @@ AbstractFile::clearAbstractFile()
    // fileSupportXMLExternalBinary
    // fileSupportOther
    // fileSupportCommaSeparatedValueFile
+   // fileSupportColumnarBinary
    // fileWriteType
    // descriptiveName
    // defaultFileName
@@ -366,6 +371,9 @@ AbstractFile::setFileReadWriteType(const FILE_FORMAT format, const FILE_IO readA
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          fileSupportCommaSeparatedValueFile = readAndOrWrite;
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         fileSupportColumnarBinary = readAndOrWrite;
+         break;
    }
 }
       
@@ -703,6 +711,9 @@ AbstractFile::getCanRead(const FILE_FORMAT ff) const
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          fio = fileSupportCommaSeparatedValueFile;
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         fio = fileSupportColumnarBinary;
+         break;
    }
    
    const bool b = ((fio == FILE_IO_READ_ONLY) || (fio == FILE_IO_READ_AND_WRITE));
@@ -742,6 +753,9 @@ AbstractFile::getCanWrite(const FILE_FORMAT ff) const
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          fio = fileSupportCommaSeparatedValueFile;
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         fio = fileSupportColumnarBinary;
+         break;
    }
    
    const bool b = ((fio == FILE_IO_WRITE_ONLY) || (fio == FILE_IO_READ_AND_WRITE));
@@ -781,6 +795,9 @@ AbstractFile::convertFormatTypeToName(const FILE_FORMAT formatIn)
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          s = getHeaderTagEncodingValueCommaSeparatedValueFile();
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         s = getHeaderTagEncodingValueColumnarBinary();
+         break;
    }
    
    return s;
@@ -822,6 +839,9 @@ AbstractFile::convertFormatNameToType(const QString& name,
    else if (name == getHeaderTagEncodingValueCommaSeparatedValueFile()) {
       format = FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE;
    }
+   else if (name == getHeaderTagEncodingValueColumnarBinary()) {
+      format = FILE_FORMAT_COLUMNAR_BINARY;
+   }
    else {
       if (validNameOut != NULL) {
          *validNameOut = false;
@@ -864,6 +884,9 @@ AbstractFile::getFileFormatTypesAndNames(std::vector<FILE_FORMAT>& typesOut,
    
    typesOut.push_back(FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE);
    namesOut.push_back(convertFormatTypeToName(FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE));
+   
+   typesOut.push_back(FILE_FORMAT_COLUMNAR_BINARY);
+   namesOut.push_back(convertFormatTypeToName(FILE_FORMAT_COLUMNAR_BINARY));
 }
                                              
 /**
@@ -906,6 +929,7 @@ void
 AbstractFile::setModified()
 {
    modified++;
+   modificationSerialNumber++;
    clearDisplayList();
 }
 
@@ -916,6 +940,7 @@ void
 AbstractFile::setModifiedCounter(const unsigned long value)
 {
    modified = value;
+   modificationSerialNumber++;
 }
 
 /**
@@ -925,6 +950,7 @@ void
 AbstractFile::clearModified()
 {
    modified = 0;
+   modificationSerialNumber++;
 }
 
 /**
@@ -953,6 +979,17 @@ AbstractFile::isCommaSeparatedValueFile(QFile& file)
    return isCSVF;
 }
 
+/**
+ * determine if the file is a columnar binary file.
+ */
+bool 
+AbstractFile::isColumnarBinaryFile(QFile& file)
+{
+   const QByteArray id(GiftiDataArrayFile::getColumnarBinaryFileIdentifier().toAscii());
+   const QByteArray bytesRead = file.peek(id.size());
+   return (bytesRead == id);
+}
+
 /**
  * determine if the file is an XML file.
  */
@@ -1080,12 +1117,22 @@ AbstractFile::readFileContents(QFile& file) throw (FileException)
    //
    const bool giftiDataArrayFileFlag = (dynamic_cast<GiftiDataArrayFile*>(this) != NULL);
 
+   //
+   // See if this is a columnar binary file
+   //
+   bool columnarFileFlag = false;
+   if (giftiDataArrayFileFlag &&
+       getCanRead(FILE_FORMAT_COLUMNAR_BINARY)) {
+      columnarFileFlag = isColumnarBinaryFile(file);
+   }
+   
    //
    // See if this is an XML file
    //
    bool csvFileFlag = false;
    bool xmlFileFlag = false;
-   if (getCanRead(FILE_FORMAT_OTHER) == false) {
+   if ((getCanRead(FILE_FORMAT_OTHER) == false) &&
+       (columnarFileFlag == false)) {
       xmlFileFlag = isFileXML(file);
       stream.seek(0);
       file.seek(0);
@@ -1175,7 +1222,10 @@ AbstractFile::readFileContents(QFile& file) throw (FileException)
       }
    }
    
-   if (giftiDataArrayFileFlag && xmlFileFlag) {
+   if (columnarFileFlag) {
+      fileReadType = FILE_FORMAT_COLUMNAR_BINARY;
+   }
+   else if (giftiDataArrayFileFlag && xmlFileFlag) {
       fileReadType = FILE_FORMAT_XML;
    }
    else if (getXmlVersionReadWithSaxParser() && xmlFileFlag) {
@@ -2370,6 +2420,7 @@ AbstractFile::writeFileContents(QTextStream& stream, QDataStream& dataStream) th
 {
    bool isXmlFile = false;
    bool isCsvFile = false;
+   bool isColumnarFile = false;
    
    switch (fileWriteType) {
       case FILE_FORMAT_ASCII:
@@ -2417,6 +2468,12 @@ AbstractFile::writeFileContents(QTextStream& stream, QDataStream& dataStream) th
          }
          isCsvFile = true;
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         if (getCanWrite(FILE_FORMAT_COLUMNAR_BINARY) == false) {
+            throw FileException(filename, "\"Columnar Binary\" type file not supported.");
+         }
+         isColumnarFile = true;
+         break;
    }
    
    //
@@ -2469,6 +2526,9 @@ AbstractFile::writeFileContents(QTextStream& stream, QDataStream& dataStream) th
          case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
             setHeaderTag(headerTagEncoding, getHeaderTagEncodingValueCommaSeparatedValueFile());
             break;
+         case FILE_FORMAT_COLUMNAR_BINARY:
+            setHeaderTag(headerTagEncoding, getHeaderTagEncodingValueColumnarBinary());
+            break;
       }
       
       //
@@ -2483,6 +2543,9 @@ AbstractFile::writeFileContents(QTextStream& stream, QDataStream& dataStream) th
       }
       else if (isCsvFile) {
       }
+      else if (isColumnarFile) {
+         // header is placed in the file's index by writeFileData()
+      }
       else {
          writeHeader(stream);
       }
@@ -2587,6 +2650,19 @@ AbstractFile::writeFile(const QString& filenameIn) throw (FileException)
             throw FileException(filename, "\"Comma Separated Value File\" type file not supported.");
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         if (getCanWrite(FILE_FORMAT_COLUMNAR_BINARY) == false) {
+            throw FileException(filename, "\"Columnar Binary\" type file not supported.");
+         }
+         break;
+   }
+   
+   //
+   // Data arrays may be mapped from the file about to be overwritten
+   //
+   GiftiDataArrayFile* giftiDataArrayFile = dynamic_cast<GiftiDataArrayFile*>(this);
+   if (giftiDataArrayFile != NULL) {
+      giftiDataArrayFile->copyMemoryMappedDataIntoMemory();
    }
 
    QTime timer;
@@ -84,7 +84,9 @@ class AbstractFile {
          /// Other file format
          FILE_FORMAT_OTHER,
          /// comma separated value file format
-         FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE
+         FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE,
+         /// column-major memory mapped binary file format
+         FILE_FORMAT_COLUMNAR_BINARY
       };
       
       /// file I/O support
@@ -140,6 +142,10 @@ class AbstractFile {
       /// returns non-zero if the file has been modified without being saved
       unsigned long getModified() const;
       
+      /// get a number that changes whenever the modification status changes
+      /// (unlike getModified() it is never reset when the file is saved or read)
+      unsigned long getModificationSerialNumber() const { return modificationSerialNumber; }
+      
       /// set file has been modified
       void setModified();
 
@@ -654,6 +660,9 @@ class AbstractFile {
       
       /// determine if the file is a comma separated value file
       bool isCommaSeparatedValueFile(QFile& file);
+      
+      /// determine if the file is a columnar binary file
+      bool isColumnarBinaryFile(QFile& file);
 #endif //CARET_FLAG      
       /// method used while reading files
       void readFileContents(QFile& file) throw (FileException);
@@ -664,6 +673,9 @@ class AbstractFile {
       /// contents modified (incremented each modification)
       unsigned long modified;
       
+      /// incremented each time the modification status changes (do not clear)
+      unsigned long modificationSerialNumber;
+      
       /// display list number (do not clear)
       unsigned int displayListNumber;
       
@@ -691,6 +703,9 @@ class AbstractFile {
       /// supports other format file (do not clear)
       FILE_IO fileSupportOther;
       
+      /// supports columnar binary format (do not clear)
+      FILE_IO fileSupportColumnarBinary;
+      
       /// data type of file for writing (do not clear)
       FILE_FORMAT fileWriteType;
       
@@ -781,6 +796,7 @@ class AbstractFile {
       static QString getHeaderTagEncodingValueXMLExternalBinary() { return "XML_EXTERNAL_BINARY"; }
       static QString getHeaderTagEncodingValueOther() { return "OTHER"; }
       static QString getHeaderTagEncodingValueCommaSeparatedValueFile() { return "COMMA_SEPARATED_VALUE_FILE"; }
+      static QString getHeaderTagEncodingValueColumnarBinary() { return "COLUMNAR_BINARY"; }
       static const QString headerTagConfigurationID;
       static const QString headerTagCoordFrameID;
       static const QString headerTagDate;
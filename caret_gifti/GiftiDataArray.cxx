@@ -30,6 +30,8 @@
 #include <limits>
 #include <sstream>
 
+#include <QMutex>
+#include <QMutexLocker>
 #include <QTextStream>
 
 #include "DebugControl.h"
@@ -37,6 +39,7 @@
 #include "GiftiCommon.h"
 #include "GiftiDataArray.h"
 #include "GiftiDataArrayFile.h"
+#include "GiftiDataArrayFileMapping.h"
 #include "StringUtilities.h"
 #ifdef HAVE_VTK
 #include "vtkBase64Utilities.h"
@@ -44,6 +47,145 @@
 #include "vtkZLibDataCompressor.h"
 #endif // HAVE_VTK
 
+#ifdef HAVE_VTK
+/// serializes creation/deletion of VTK objects when arrays are coded concurrently
+static QMutex zlibDataCompressorMutex;
+
+/**
+ * create a ZLIB compressor (safe to call from multiple threads).
+ */
+static vtkZLibDataCompressor*
+newZLibDataCompressor()
+{
+   QMutexLocker locker(&zlibDataCompressorMutex);
+   return vtkZLibDataCompressor::New();
+}
+
+/**
+ * delete a ZLIB compressor (safe to call from multiple threads).
+ */
+static void
+deleteZLibDataCompressor(vtkZLibDataCompressor* compressor)
+{
+   QMutexLocker locker(&zlibDataCompressorMutex);
+   compressor->Delete();
+}
+#endif // HAVE_VTK
+
+/// table of Base64 character values (built before main() so it is thread safe)
+class GiftiBase64DecodeTable {
+   public:
+      /// constructor
+      GiftiBase64DecodeTable() {
+         const char* alphabet = 
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+         for (int i = 0; i < 256; i++) {
+            values[i] = 0x80;
+         }
+         for (int i = 0; i < 64; i++) {
+            values[static_cast<unsigned char>(alphabet[i])] = static_cast<unsigned char>(i);
+         }
+         values[static_cast<unsigned char>(' ')]  = 0x40;
+         values[static_cast<unsigned char>('\t')] = 0x40;
+         values[static_cast<unsigned char>('\n')] = 0x40;
+         values[static_cast<unsigned char>('\r')] = 0x40;
+      }
+      
+      /// 0-63 for valid characters, 0x40 for whitespace, 0x80 for padding and invalid characters
+      unsigned char values[256];
+};
+
+static const GiftiBase64DecodeTable base64DecodeTable;
+
+/**
+ * decode Base64 text.  Whitespace is skipped and decoding stops at the
+ * end of the text, at padding ("="), at an invalid character, or when
+ * the output is full.  Complete groups of four characters are decoded 
+ * with a single table lookup per character.
+ * Returns the number of bytes decoded.
+ */
+static unsigned long
+decodeBase64(const unsigned char* text,
+             const unsigned long textLength,
+             unsigned char* output,
+             const unsigned long maximumOutputLength)
+{
+   const unsigned char* decodeTable = base64DecodeTable.values;
+   
+   unsigned long inputIndex = 0;
+   unsigned long outputIndex = 0;
+   unsigned int quad[4];
+   int numInQuad = 0;
+   
+   while (inputIndex < textLength) {
+      //
+      // Fast path for four valid characters with room for three bytes
+      //
+      if ((numInQuad == 0) &&
+          ((inputIndex + 4) <= textLength) &&
+          ((outputIndex + 3) <= maximumOutputLength)) {
+         const unsigned int a = decodeTable[text[inputIndex]];
+         const unsigned int b = decodeTable[text[inputIndex + 1]];
+         const unsigned int c = decodeTable[text[inputIndex + 2]];
+         const unsigned int d = decodeTable[text[inputIndex + 3]];
+         if (((a | b | c | d) & 0xC0) == 0) {
+            const unsigned int bits = (a << 18) | (b << 12) | (c << 6) | d;
+            output[outputIndex]     = static_cast<unsigned char>(bits >> 16);
+            output[outputIndex + 1] = static_cast<unsigned char>(bits >> 8);
+            output[outputIndex + 2] = static_cast<unsigned char>(bits);
+            outputIndex += 3;
+            inputIndex  += 4;
+            continue;
+         }
+      }
+      
+      //
+      // One character at a time
+      //
+      const unsigned int value = decodeTable[text[inputIndex]];
+      inputIndex++;
+      if (value == 0x40) {
+         continue;
+      }
+      if (value == 0x80) {
+         break;
+      }
+      quad[numInQuad] = value;
+      numInQuad++;
+      if (numInQuad == 4) {
+         const unsigned int bits = (quad[0] << 18) | (quad[1] << 12) | (quad[2] << 6) | quad[3];
+         for (int i = 0; i < 3; i++) {
+            if (outputIndex >= maximumOutputLength) {
+               return outputIndex;
+            }
+            output[outputIndex] = static_cast<unsigned char>(bits >> (16 - i * 8));
+            outputIndex++;
+         }
+         numInQuad = 0;
+      }
+   }
+   
+   //
+   // Partial group at end of text (two characters yield one byte,
+   // three characters yield two bytes)
+   //
+   if (numInQuad >= 2) {
+      for (int i = numInQuad; i < 4; i++) {
+         quad[i] = 0;
+      }
+      const unsigned int bits = (quad[0] << 18) | (quad[1] << 12) | (quad[2] << 6) | quad[3];
+      for (int i = 0; i < (numInQuad - 1); i++) {
+         if (outputIndex >= maximumOutputLength) {
+            break;
+         }
+         output[outputIndex] = static_cast<unsigned char>(bits >> (16 - i * 8));
+         outputIndex++;
+      }
+   }
+   
+   return outputIndex;
+}
+
 /**
  * constructor.
  */
@@ -59,6 +201,12 @@ GiftiDataArray::GiftiDataArray(GiftiDataArrayFile* parentGiftiDataArrayFileIn,
    dataPointerFloat = NULL;
    dataPointerInt = NULL;
    dataPointerUByte = NULL;
+   dataMapping = NULL;
+   mappedData = NULL;
+   mappedDataSizeInBytes = 0;
+   dataIsRunLengthEncoded = false;
+   deferredRequiredDataType = DATA_TYPE_FLOAT32;
+   deferredArraySubscriptingOrder = ARRAY_SUBSCRIPTING_ORDER_HIGHEST_FIRST;
    clear();
    dataType = dataTypeIn;
    setDimensions(dimensionsIn);
@@ -94,6 +242,12 @@ GiftiDataArray::GiftiDataArray(GiftiDataArrayFile* parentGiftiDataArrayFileIn,
    dataPointerFloat = NULL;
    dataPointerInt = NULL;
    dataPointerUByte = NULL;
+   dataMapping = NULL;
+   mappedData = NULL;
+   mappedDataSizeInBytes = 0;
+   dataIsRunLengthEncoded = false;
+   deferredRequiredDataType = DATA_TYPE_FLOAT32;
+   deferredArraySubscriptingOrder = ARRAY_SUBSCRIPTING_ORDER_HIGHEST_FIRST;
    clear();
    dimensions.clear();
    encoding = ENCODING_INTERNAL_ASCII;
@@ -127,6 +281,12 @@ GiftiDataArray::~GiftiDataArray()
  */
 GiftiDataArray::GiftiDataArray(const GiftiDataArray& nda)
 {
+   dataMapping = NULL;
+   mappedData = NULL;
+   mappedDataSizeInBytes = 0;
+   dataIsRunLengthEncoded = false;
+   deferredRequiredDataType = DATA_TYPE_FLOAT32;
+   deferredArraySubscriptingOrder = ARRAY_SUBSCRIPTING_ORDER_HIGHEST_FIRST;
    copyHelperGiftiDataArray(nda);
 }
 
@@ -157,8 +317,31 @@ GiftiDataArray::copyHelperGiftiDataArray(const GiftiDataArray& nda)
    endian = nda.endian;
    parentGiftiDataArrayFile = NULL;  // caused modified to be set !! nda.parentGiftiDataArrayFile;
    dimensions = nda.dimensions;
-   allocateData();
-   data = nda.data;
+   
+   //
+   // A copy never shares a mapping since the mapped data may be modified
+   //
+   releaseMappedData(false);
+   releaseRunLengthEncodedData(false);
+   if (nda.dataIsRunLengthEncoded) {
+      //
+      // A copy of run length encoded data remains run length encoded
+      //
+      std::vector<uint8_t>().swap(data);
+      runLengthEnds = nda.runLengthEnds;
+      runLengthValues = nda.runLengthValues;
+      dataIsRunLengthEncoded = true;
+   }
+   else {
+      allocateData();
+      if (nda.mappedData != NULL) {
+         data.assign(nda.mappedData, nda.mappedData + nda.mappedDataSizeInBytes);
+      }
+      else {
+         data = nda.data;
+      }
+   }
+   updateDataPointers();
    metaData = nda.metaData;
    nonWrittenMetaData = nda.nonWrittenMetaData;
    externalFileName = nda.externalFileName;
@@ -267,6 +450,8 @@ GiftiDataArray::deleteRows(const std::vector<int>& rowsToDeleteIn)
    //
    // Remove the unneeded rows
    //
+   releaseMappedData(true);
+   releaseRunLengthEncodedData(true);
    for (unsigned int i = 0; i < rowsToDelete.size(); i++) {
       const int offset = rowsToDelete[i] * numBytesInRow;
       data.erase(data.begin() + offset, data.begin() + offset + numBytesInRow);
@@ -279,6 +464,45 @@ GiftiDataArray::deleteRows(const std::vector<int>& rowsToDeleteIn)
    setModified();
 }      
 
+/**
+ * permute rows (row "i" moves to row "newRowIndices[i]").
+ */
+void 
+GiftiDataArray::permuteRows(const std::vector<int>& newRowIndices)
+{
+   if (dimensions.empty()) {
+      return;
+   }
+   const int numRows = dimensions[0];
+   if (static_cast<int>(newRowIndices.size()) != numRows) {
+      return;
+   }
+   
+   //
+   // size of row in bytes
+   //
+   long numBytesInRow = dataTypeSize;
+   for (unsigned int i = 1; i < dimensions.size(); i++) {
+      numBytesInRow *= dimensions[i];
+   }
+   
+   //
+   // Move the rows
+   //
+   releaseMappedData(true);
+   releaseRunLengthEncodedData(true);
+   std::vector<uint8_t> permutedData(data.size());
+   for (int i = 0; i < numRows; i++) {
+      const long offset = i * numBytesInRow;
+      std::copy(data.begin() + offset, 
+                data.begin() + offset + numBytesInRow,
+                permutedData.begin() + newRowIndices[i] * numBytesInRow);
+   }
+   data.swap(permutedData);
+   updateDataPointers();
+   setModified();
+}
+
 /**
  * set number of nodes which causes reallocation of data.
  */
@@ -328,6 +552,13 @@ GiftiDataArray::allocateData()
    
    dataSizeInBytes *= dataTypeSize;
    
+   //
+   // Move any memory mapped or run length encoded data into memory so 
+   // that it may be resized
+   //
+   releaseMappedData(true);
+   releaseRunLengthEncodedData(true);
+   
    //
    // Does data need to be allocated
    //
@@ -358,20 +589,261 @@ GiftiDataArray::updateDataPointers()
    dataPointerFloat = NULL;
    dataPointerInt = NULL;
    dataPointerUByte = NULL;
-   if (data.empty() == false) {
+   
+   uint8_t* dataStart = NULL;
+   if (mappedData != NULL) {
+      dataStart = mappedData;
+   }
+   else if (data.empty() == false) {
+      dataStart = &data[0];
+   }
+   
+   if (dataStart != NULL) {
       switch (dataType) {
          case DATA_TYPE_FLOAT32:
-            dataPointerFloat = (float*)&data[0];
+            dataPointerFloat = (float*)dataStart;
             break;
          case DATA_TYPE_INT32:
-            dataPointerInt   = (int32_t*)&data[0];
+            dataPointerInt   = (int32_t*)dataStart;
             break;
          case DATA_TYPE_UINT8:
-            dataPointerUByte = (uint8_t*)&data[0];
+            dataPointerUByte = (uint8_t*)dataStart;
             break;
       }
    }
 }
+
+/**
+ * stop using a memory mapped file for the data (optionally copying the data into memory).
+ */
+void 
+GiftiDataArray::releaseMappedData(const bool copyDataIntoMemoryFlag)
+{
+   if (dataMapping == NULL) {
+      return;
+   }
+   
+   if (copyDataIntoMemoryFlag) {
+      data.assign(mappedData, mappedData + mappedDataSizeInBytes);
+   }
+   else {
+      data.clear();
+   }
+   
+   dataMapping->unreference();
+   dataMapping = NULL;
+   mappedData = NULL;
+   mappedDataSizeInBytes = 0;
+   
+   updateDataPointers();
+}
+
+/**
+ * stop run length encoding the data (optionally expanding the data into memory).
+ */
+void 
+GiftiDataArray::releaseRunLengthEncodedData(const bool copyDataIntoMemoryFlag)
+{
+   if (dataIsRunLengthEncoded == false) {
+      return;
+   }
+   
+   if (copyDataIntoMemoryFlag) {
+      //
+      // Dimensions may have changed so use the number of encoded elements
+      //
+      const long numElements = (runLengthEnds.empty() ? 0 : runLengthEnds.back());
+      data.resize(numElements * sizeof(int32_t));
+      if (numElements > 0) {
+         int32_t* ptr = (int32_t*)&data[0];
+         long start = 0;
+         for (unsigned int i = 0; i < runLengthEnds.size(); i++) {
+            std::fill(ptr + start, ptr + runLengthEnds[i], runLengthValues[i]);
+            start = runLengthEnds[i];
+         }
+      }
+   }
+   else {
+      data.clear();
+   }
+   
+   std::vector<int32_t>().swap(runLengthEnds);
+   std::vector<int32_t>().swap(runLengthValues);
+   dataIsRunLengthEncoded = false;
+   
+   updateDataPointers();
+}
+
+/**
+ * expand run length encoded data into memory.  Call before const pointers
+ * to the data are used (such as by several threads).
+ */
+void 
+GiftiDataArray::expandRunLengthEncodedData()
+{
+   releaseRunLengthEncodedData(true);
+}
+
+/**
+ * Run length encode int data if it uses much less memory.  Columns of labels
+ * that are mostly one value (such as probabilistic atlas columns that are
+ * mostly zero) use a small fraction of their memory when encoded.
+ * Returns true if data is run length encoded.
+ */
+bool 
+GiftiDataArray::compressDataWithRunLengthEncoding()
+{
+   if (dataIsRunLengthEncoded) {
+      return true;
+   }
+   if ((dataType != DATA_TYPE_INT32) ||
+       (dataMapping != NULL) ||
+       data.empty()) {
+      return false;
+   }
+   const long numElements = static_cast<long>(data.size() / sizeof(int32_t));
+   if (numElements > std::numeric_limits<int32_t>::max()) {
+      return false;
+   }
+   
+   //
+   // A run uses two ints, encode only if runs use at most
+   // a quarter of the memory of the data
+   //
+   const long maximumNumberOfRuns = numElements / 8;
+   const int32_t* ptr = (const int32_t*)&data[0];
+   long numRuns = 1;
+   for (long i = 1; i < numElements; i++) {
+      if (ptr[i] != ptr[i - 1]) {
+         numRuns++;
+         if (numRuns > maximumNumberOfRuns) {
+            return false;
+         }
+      }
+   }
+   if (numRuns > maximumNumberOfRuns) {
+      return false;
+   }
+   
+   runLengthEnds.reserve(numRuns);
+   runLengthValues.reserve(numRuns);
+   for (long i = 1; i < numElements; i++) {
+      if (ptr[i] != ptr[i - 1]) {
+         runLengthEnds.push_back(static_cast<int32_t>(i));
+         runLengthValues.push_back(ptr[i - 1]);
+      }
+   }
+   runLengthEnds.push_back(static_cast<int32_t>(numElements));
+   runLengthValues.push_back(ptr[numElements - 1]);
+   
+   std::vector<uint8_t>().swap(data);
+   dataIsRunLengthEncoded = true;
+   updateDataPointers();
+   
+   return true;
+}
+
+/**
+ * current size of the data (in bytes) when in memory.
+ */
+long 
+GiftiDataArray::getDataSizeInBytes() const
+{
+   if (mappedData != NULL) {
+      return mappedDataSizeInBytes;
+   }
+   if (dataIsRunLengthEncoded) {
+      return (runLengthEnds.empty() ? 0 : (runLengthEnds.back() * sizeof(int32_t)));
+   }
+   return static_cast<long>(data.size());
+}
+
+/**
+ * get pointer for integer data (valid only if data type is INT).
+ * Run length encoded data is expanded.
+ */
+int32_t* 
+GiftiDataArray::getDataPointerInt()
+{
+   releaseRunLengthEncodedData(true);
+   return dataPointerInt;
+}
+
+/**
+ * get pointer for integer data (const method) (valid only if data type is INT).
+ * Returns NULL if the data is run length encoded, call 
+ * expandRunLengthEncodedData() first or use getDataInt32Element().
+ */
+const int32_t* 
+GiftiDataArray::getDataPointerInt() const
+{
+   return dataPointerInt;
+}
+
+/**
+ * get an int value by its element index without expanding run length encoded data.
+ */
+int32_t 
+GiftiDataArray::getDataInt32Element(const long elementIndex) const
+{
+   if (dataIsRunLengthEncoded) {
+      const std::vector<int32_t>::const_iterator iter = 
+         std::upper_bound(runLengthEnds.begin(), runLengthEnds.end(), elementIndex);
+      return runLengthValues[iter - runLengthEnds.begin()];
+   }
+   return dataPointerInt[elementIndex];
+}
+
+/**
+ * set an int value by its element index (run length encoded data is 
+ * expanded if the value changes).
+ */
+void 
+GiftiDataArray::setDataInt32Element(const long elementIndex, 
+                                    const int32_t dataValue)
+{
+   if (dataIsRunLengthEncoded) {
+      if (getDataInt32Element(elementIndex) == dataValue) {
+         return;
+      }
+      releaseRunLengthEncodedData(true);
+   }
+   dataPointerInt[elementIndex] = dataValue;
+}
+
+/**
+ * get all int values without expanding run length encoded data.
+ * "valuesOut" must contain getTotalNumberOfElements() elements.
+ */
+void 
+GiftiDataArray::getDataInt32Elements(int32_t* valuesOut) const
+{
+   if (dataIsRunLengthEncoded) {
+      long start = 0;
+      for (unsigned int i = 0; i < runLengthEnds.size(); i++) {
+         std::fill(valuesOut + start, valuesOut + runLengthEnds[i], runLengthValues[i]);
+         start = runLengthEnds[i];
+      }
+   }
+   else {
+      const long numElements = getTotalNumberOfElements();
+      std::copy(dataPointerInt, dataPointerInt + numElements, valuesOut);
+   }
+}
+
+/**
+ * set all int values ("values" contains getTotalNumberOfElements() elements).
+ */
+void 
+GiftiDataArray::setDataInt32Elements(const int32_t* values)
+{
+   if (dataIsRunLengthEncoded) {
+      releaseRunLengthEncodedData(false);
+      allocateData();
+   }
+   const long numElements = getTotalNumberOfElements();
+   std::copy(values, values + numElements, dataPointerInt);
+}
       
 /**
  * reset column.
@@ -386,6 +858,8 @@ GiftiDataArray::clear()
    dataTypeSize = sizeof(float);
    metaData.clear();
    nonWrittenMetaData.clear();
+   releaseMappedData(false);
+   releaseRunLengthEncodedData(false);
    dimensions.clear();
    setDimensions(dimensions);
    externalFileName = "";
@@ -725,6 +1199,17 @@ GiftiDataArray::remapIntValues(const std::vector<int>& remappingTable)
    if (dataType != DATA_TYPE_INT32) {
       return;
    }
+   
+   //
+   // Remap run length encoded data without expanding it
+   //
+   if (dataIsRunLengthEncoded) {
+      for (unsigned int i = 0; i < runLengthValues.size(); i++) {
+         runLengthValues[i] = remappingTable[runLengthValues[i]];
+      }
+      return;
+   }
+   
    const long num = getTotalNumberOfElements();
    for (long i = 0; i < num; i++) {
       dataPointerInt[i] = remappingTable[dataPointerInt[i]];
@@ -804,89 +1289,8 @@ GiftiDataArray::readFromText(QString& text,
             }
             break;
          case ENCODING_INTERNAL_BASE64_BINARY:
-   #ifdef HAVE_VTK
-            {
-               //
-               // Decode the Base64 data using VTK's algorithm
-               //
-               const QByteArray ba = text.toAscii();
-               const char* textChars = ba.constData();
-               // crashes const char* textChars = text.toAscii().constData();
-               const unsigned long numDecoded =
-                     vtkBase64Utilities::Decode((const unsigned char*)textChars,
-                                                data.size(),
-                                                &data[0]);
-               if (numDecoded != data.size()) {
-                  std::ostringstream str;
-                  str << "Decoding of Base64 Binary data failed.\n"
-                      << "Decoded " << numDecoded << " bytes but should be "
-                      << data.size() << " bytes.";
-                  throw FileException("", str.str().c_str());
-               }
-               
-               //
-               // Is byte swapping needed ?
-               //
-               if (endian != getSystemEndian()) {
-                  byteSwapData(getSystemEndian());
-               }
-            }
-   #else  // HAVE_VTK
-            throw FileException("No support for Base64 data since VTK not available at compile time.");
-   #endif // HAVE_VTK
-            break;
          case ENCODING_INTERNAL_COMPRESSED_BASE64_BINARY:
-   #ifdef HAVE_VTK
-            {
-               //
-               // Decode the Base64 data using VTK's algorithm
-               //
-               unsigned char* dataBuffer = new unsigned char[data.size()];
-               const QByteArray ba = text.toAscii();
-               const char* textChars = ba.constData();
-               // crashes const char* textChars = text.toAscii().constData();
-               const unsigned long numDecoded =
-                     vtkBase64Utilities::Decode((const unsigned char*)textChars,
-                                                data.size(),
-                                                dataBuffer);
-               if (numDecoded == 0) {
-                  throw FileException("", "Decoding of GZip Base64 Binary data failed.");
-               }
-               
-               
-               //
-               // Uncompress the data using VTK's algorithm
-               //
-               vtkZLibDataCompressor* compressor = vtkZLibDataCompressor::New();
-               const unsigned long uncompressedDataLength = 
-                                   compressor->Uncompress(dataBuffer,
-                                                          numDecoded,
-                                                          &data[0],
-                                                          data.size());
-               if (uncompressedDataLength != data.size()) {
-                  std::ostringstream str;
-                  str << "Decompression of Binary data failed.\n"
-                      << "Uncompressed " << uncompressedDataLength << " bytes but should be "
-                      << data.size() << " bytes.";
-                  throw FileException("", str.str().c_str());
-               }
-               
-               //
-               // Free memory
-               //
-               delete[] dataBuffer;
-               compressor->Delete();
-               
-               //
-               // Is byte swapping needed ?
-               //
-               if (endian != getSystemEndian()) {
-                  byteSwapData(getSystemEndian());
-               }
-            }
-   #else  // HAVE_VTK
-            throw FileException("No support for Base64 data since VTK not available at compile time.");
-   #endif // HAVE_VTK
+            decodeBase64Text(text.toAscii());
             break;
          case ENCODING_EXTERNAL_FILE_BINARY:
             {
@@ -970,27 +1374,239 @@ GiftiDataArray::readFromText(QString& text,
             break;
       }
    
-      //
-      // Check if data type needs to be converted
-      //
-      if (requiredDataType != dataType) {
-         if (intentName != GiftiCommon::intentNodeIndex) {
-            convertToDataType(requiredDataType);
+      finishReadingData(requiredDataType, arraySubscriptingOrderForReading);
+   } // If NOT metadata only
+   
+   setModified();
+}
+
+/**
+ * read a GIFTI data array's attributes and allocate its data but postpone
+ * decoding of its Base64 text.  This allows the text of many data arrays
+ * to be decoded concurrently with decodeBase64Text().  finishDeferredDecoding()
+ * must be called after the text is decoded.
+ */
+void 
+GiftiDataArray::readFromTextWithDeferredDecoding(const QString& dataEndianForReading,
+            const ARRAY_SUBSCRIPTING_ORDER arraySubscriptingOrderForReading,
+            const DATA_TYPE dataTypeForReading,
+            const std::vector<int>& dimensionsForReading,
+            const ENCODING encodingForReading) throw (FileException)
+{
+   switch (encodingForReading) {
+      case ENCODING_INTERNAL_ASCII:
+      case ENCODING_EXTERNAL_FILE_BINARY:
+         throw FileException("Only Base64 encoded data arrays may be decoded deferred.");
+         break;
+      case ENCODING_INTERNAL_BASE64_BINARY:
+      case ENCODING_INTERNAL_COMPRESSED_BASE64_BINARY:
+         break;
+   }
+   
+   deferredRequiredDataType = dataType;
+   deferredArraySubscriptingOrder = arraySubscriptingOrderForReading;
+   dataType = dataTypeForReading;
+   encoding = encodingForReading;
+   endian   = getEndianFromName(dataEndianForReading);
+   setDimensions(dimensionsForReading);
+   if (dimensionsForReading.size() == 0) {
+      throw FileException("Data array has no dimensions.");
+   }
+   setExternalFileInformation("", 0);
+}
+
+/**
+ * finish reading a data array after its text was decoded by decodeBase64Text().
+ */
+void 
+GiftiDataArray::finishDeferredDecoding() throw (FileException)
+{
+   finishReadingData(deferredRequiredDataType, deferredArraySubscriptingOrder);
+   setModified();
+}
+
+/**
+ * decode Base64 (or GZip Base64) text into the data which must already be
+ * allocated.  Only this data array is accessed (the parent file is not
+ * modified) so different data arrays may be decoded concurrently.
+ */
+void 
+GiftiDataArray::decodeBase64Text(const QByteArray& text) throw (FileException)
+{
+   if (data.empty()) {
+      return;
+   }
+   
+   switch (encoding) {
+      case ENCODING_INTERNAL_ASCII:
+      case ENCODING_EXTERNAL_FILE_BINARY:
+         throw FileException("Data array encoding is not Base64.");
+         break;
+      case ENCODING_INTERNAL_BASE64_BINARY:
+         {
+            const unsigned long numDecoded =
+                  decodeBase64((const unsigned char*)text.constData(),
+                               text.size(),
+                               &data[0],
+                               data.size());
+            if (numDecoded != data.size()) {
+               std::ostringstream str;
+               str << "Decoding of Base64 Binary data failed.\n"
+                   << "Decoded " << numDecoded << " bytes but should be "
+                   << data.size() << " bytes.";
+               throw FileException("", str.str().c_str());
+            }
          }
+         break;
+      case ENCODING_INTERNAL_COMPRESSED_BASE64_BINARY:
+#ifdef HAVE_VTK
+         {
+            //
+            // Decode the Base64 data (compressed data may be larger than 
+            // the uncompressed data so size buffer using the text)
+            //
+            std::vector<unsigned char> dataBuffer(((text.size() / 4) + 1) * 3);
+            const unsigned long numDecoded =
+                  decodeBase64((const unsigned char*)text.constData(),
+                               text.size(),
+                               &dataBuffer[0],
+                               dataBuffer.size());
+            if (numDecoded == 0) {
+               throw FileException("", "Decoding of GZip Base64 Binary data failed.");
+            }
+            
+            //
+            // Uncompress the data using VTK's algorithm
+            //
+            vtkZLibDataCompressor* compressor = newZLibDataCompressor();
+            const unsigned long uncompressedDataLength = 
+                                compressor->Uncompress(&dataBuffer[0],
+                                                       numDecoded,
+                                                       &data[0],
+                                                       data.size());
+            deleteZLibDataCompressor(compressor);
+            if (uncompressedDataLength != data.size()) {
+               std::ostringstream str;
+               str << "Decompression of Binary data failed.\n"
+                   << "Uncompressed " << uncompressedDataLength << " bytes but should be "
+                   << data.size() << " bytes.";
+               throw FileException("", str.str().c_str());
+            }
+         }
+#else  // HAVE_VTK
+         throw FileException("No support for GZip Base64 data since VTK not available at compile time.");
+#endif // HAVE_VTK
+         break;
+   }
+   
+   //
+   // Is byte swapping needed ?
+   //
+   if (endian != getSystemEndian()) {
+      byteSwapData(getSystemEndian());
+   }
+}
+
+/**
+ * convert data type and indexing order and update metadata after the data is read.
+ */
+void 
+GiftiDataArray::finishReadingData(const DATA_TYPE requiredDataType,
+                                  const ARRAY_SUBSCRIPTING_ORDER arraySubscriptingOrderForReading) throw (FileException)
+{
+   //
+   // Check if data type needs to be converted
+   //
+   if (requiredDataType != dataType) {
+      if (intentName != GiftiCommon::intentNodeIndex) {
+         convertToDataType(requiredDataType);
       }
-      
-      //
-      // Are array indices in opposite order
-      //
-      if (arraySubscriptingOrderForReading != arraySubscriptingOrder) {
-         convertArrayIndexingOrder();
-      }
-      
-      //
-      // Update metadata (GIFTI to Caret)
-      //
-      updateMetaDataAfterReading();
-   } // If NOT metadata only
+   }
+   
+   //
+   // Are array indices in opposite order
+   //
+   if (arraySubscriptingOrderForReading != arraySubscriptingOrder) {
+      convertArrayIndexingOrder();
+   }
+   
+   //
+   // Update metadata (GIFTI to Caret)
+   //
+   updateMetaDataAfterReading();
+}
+
+/**
+ * read a data array from a memory mapped file.  The array refers to
+ * the mapped data so none of the data is read from disk until it is used.
+ */
+void 
+GiftiDataArray::readFromMapping(GiftiDataArrayFileMapping* mappingIn,
+                                const qint64 dataOffsetInMapping,
+                                const ENDIAN dataEndianForReading,
+                                const ARRAY_SUBSCRIPTING_ORDER arraySubscriptingOrderForReading,
+                                const DATA_TYPE dataTypeForReading,
+                                const std::vector<int>& dimensionsForReading) throw (FileException)
+{
+   if (dimensionsForReading.size() == 0) {
+      throw FileException("Data array has no dimensions.");
+   }
+   
+   const DATA_TYPE requiredDataType = dataType;
+   releaseMappedData(false);
+   releaseRunLengthEncodedData(false);
+   dataType = dataTypeForReading;
+   endian   = dataEndianForReading;
+   dimensions = dimensionsForReading;
+   if (dimensions.size() == 1) {
+      dimensions.push_back(1);
+   }
+   
+   //
+   // Size of the data in the file
+   //
+   long numElements = 1;
+   for (unsigned int i = 0; i < dimensions.size(); i++) {
+      numElements *= dimensions[i];
+   }
+   switch (dataType) {
+      case DATA_TYPE_FLOAT32:
+         dataTypeSize = sizeof(float);
+         break;
+      case DATA_TYPE_INT32:
+         dataTypeSize = sizeof(int32_t);
+         break;
+      case DATA_TYPE_UINT8:
+         dataTypeSize = sizeof(uint8_t);
+         break;
+   }
+   const qint64 numBytes = static_cast<qint64>(numElements) * dataTypeSize;
+   if ((dataOffsetInMapping < 0) ||
+       ((dataOffsetInMapping + numBytes) > mappingIn->getSizeInBytes())) {
+      throw FileException(mappingIn->getFileName(),
+                          "Data array extends beyond the end of the file.");
+   }
+   
+   //
+   // Use the data where it lies in the mapped file
+   //
+   data.clear();
+   if (numBytes > 0) {
+      mappingIn->reference();
+      dataMapping = mappingIn;
+      mappedData = mappingIn->getData() + dataOffsetInMapping;
+      mappedDataSizeInBytes = numBytes;
+   }
+   updateDataPointers();
+   
+   //
+   // Is byte swapping needed ? (mapping is private so the file is not altered)
+   //
+   if (endian != getSystemEndian()) {
+      byteSwapData(getSystemEndian());
+   }
+   
+   finishReadingData(requiredDataType, arraySubscriptingOrderForReading);
    
    setModified();
 }
@@ -1024,6 +1640,8 @@ GiftiDataArray::convertArrayIndexingOrder() throw (FileException)
        if ((dimI == 1) || (dimJ == 1)) {
           return;
        }
+       
+       releaseRunLengthEncodedData(true);
 
        //
        // Is matrix square?
@@ -1075,6 +1693,7 @@ GiftiDataArray::convertArrayIndexingOrder() throw (FileException)
            //
            // Copy the data
            //
+           releaseMappedData(true);
            std::vector<uint8_t> dataCopy = data;
 
           switch (dataType) {
@@ -1128,7 +1747,8 @@ GiftiDataArray::convertArrayIndexingOrder() throw (FileException)
 void 
 GiftiDataArray::writeAsXML(QTextStream& stream, 
                            const int indentOffset,
-                           std::ofstream* externalBinaryOutputStream) 
+                           std::ofstream* externalBinaryOutputStream,
+                           const QByteArray* encodedDataText) 
                                                 throw (FileException)
 {
    //
@@ -1139,6 +1759,24 @@ GiftiDataArray::writeAsXML(QTextStream& stream,
       return;
    }
    
+   //
+   // Run length encoded data is expanded while it is written as text or
+   // to an external file (Base64 encoding uses a temporary copy)
+   //
+   bool compressAfterWritingFlag = false;
+   if (dataIsRunLengthEncoded) {
+      switch (encoding) {
+         case ENCODING_INTERNAL_ASCII:
+         case ENCODING_EXTERNAL_FILE_BINARY:
+            releaseRunLengthEncodedData(true);
+            compressAfterWritingFlag = true;
+            break;
+         case ENCODING_INTERNAL_BASE64_BINARY:
+         case ENCODING_INTERNAL_COMPRESSED_BASE64_BINARY:
+            break;
+      }
+   }
+   
    //
    // Clean up the dimensions by removing any "last" dimensions that
    // are one with the exception of the first dimension
@@ -1251,6 +1889,14 @@ GiftiDataArray::writeAsXML(QTextStream& stream,
    //
    bool addCloseTagImmediatelyAfterData = false;
    
+   //
+   // Data may be in memory or in a memory mapped file
+   //
+   const uint8_t* dataBytes = ((mappedData != NULL) 
+                               ? mappedData 
+                               : (data.empty() ? NULL : &data[0]));
+   const unsigned long dataSizeInBytes = getDataSizeInBytes();
+   
    //
    // NOTE: for the base64 and ZLIB-Base64 data, it is important that there are
    // no spaces between the <DATA> and </DATA> tags.
@@ -1300,36 +1946,101 @@ GiftiDataArray::writeAsXML(QTextStream& stream,
          }
          break;
       case ENCODING_INTERNAL_BASE64_BINARY:
-#ifdef HAVE_VTK
+      case ENCODING_INTERNAL_COMPRESSED_BASE64_BINARY:
          {
             //
-            // Encode the data with VTK's Base64 algorithm
+            // Use text that was encoded in advance or encode the data now
             //
-            const unsigned long bufferLength = static_cast<long>(data.size() * 1.5);
-            char* buffer = new char[bufferLength];
-            const unsigned long compressedLength =
-               vtkBase64Utilities::Encode(&data[0],
-                                          data.size(),
-                                          (unsigned char*)buffer);
-            if (compressedLength >= bufferLength) {
-               throw FileException(
-                     "Base64 encoding buffer length ("
-                     + QString::number(bufferLength)
-                     + ") is too small but needs to be "
-                     + compressedLength);
+            if (encodedDataText != NULL) {
+               stream << *encodedDataText;
+            }
+            else {
+               QByteArray text;
+               encodeDataAsBase64Text(text);
+               stream << text;
             }
-            buffer[compressedLength] = '\0';
-            
-            //
-            // Write the data
-            //
-            stream << buffer;
             addCloseTagImmediatelyAfterData = true;
-            
+         }
+         break;
+      case ENCODING_EXTERNAL_FILE_BINARY:
+         {
+            externalBinaryOutputStream->write((const char*)dataBytes, dataSizeInBytes);
+            if (externalBinaryOutputStream->bad()) {
+               throw FileException("Output stream for external file reports its status as bad.");
+            }
+         }
+         break;
+   }
+   
+   //
+   // Write the closing tag
+   //
+   indent--;
+   if (addCloseTagImmediatelyAfterData == false) {
+      GiftiCommon::writeIndentationXML(stream, indent);
+   }
+   stream << "</" << GiftiCommon::tagData << ">" << "\n";
+   
+   //
+   // write the closing data array tag
+   //
+   indent--;
+   GiftiCommon::writeIndentationXML(stream, indent);
+   stream << "</" << GiftiCommon::tagDataArray << ">" << "\n";
+   
+   if (compressAfterWritingFlag) {
+      compressDataWithRunLengthEncoding();
+   }
+}                      
+
+/**
+ * encode the data as Base64 (or GZip Base64) text for writing as XML.  Only
+ * this data array is accessed so different data arrays may be encoded
+ * concurrently.  The text is identical to that produced by writeAsXML().
+ */
+void 
+GiftiDataArray::encodeDataAsBase64Text(QByteArray& textOut) const throw (FileException)
+{
+   textOut.clear();
+   
+   //
+   // Data may be in memory or in a memory mapped file
+   //
+   const unsigned long dataSizeInBytes = getDataSizeInBytes();
+   if (dataSizeInBytes <= 0) {
+      return;
+   }
+   const uint8_t* dataBytes = ((mappedData != NULL) 
+                               ? mappedData 
+                               : (data.empty() ? NULL : &data[0]));
+   
+   //
+   // Run length encoded data is expanded into a temporary copy
+   //
+   std::vector<uint8_t> expandedData;
+   if (dataIsRunLengthEncoded) {
+      expandedData.resize(dataSizeInBytes);
+      getDataInt32Elements((int32_t*)&expandedData[0]);
+      dataBytes = &expandedData[0];
+   }
+   
+   switch (encoding) {
+      case ENCODING_INTERNAL_ASCII:
+      case ENCODING_EXTERNAL_FILE_BINARY:
+         throw FileException("Data array encoding is not Base64.");
+         break;
+      case ENCODING_INTERNAL_BASE64_BINARY:
+#ifdef HAVE_VTK
+         {
             //
-            // Free memory
+            // Encode the data with VTK's Base64 algorithm
             //
-            delete[] buffer;
+            textOut.resize(((dataSizeInBytes + 2) / 3) * 4);
+            const unsigned long encodedLength =
+               vtkBase64Utilities::Encode(dataBytes,
+                                          dataSizeInBytes,
+                                          (unsigned char*)textOut.data());
+            textOut.resize(encodedLength);
          }
 #else  // HAVE_VTK
          throw FileException("No support for Base64 data since VTK not available at compile time.");
@@ -1341,80 +2052,46 @@ GiftiDataArray::writeAsXML(QTextStream& stream,
             //
             // Compress the data with VTK's ZLIB algorithm
             //
-            vtkZLibDataCompressor* compressor = vtkZLibDataCompressor::New();
+            vtkZLibDataCompressor* compressor = newZLibDataCompressor();
             unsigned long compressedDataBufferLength = 
-                              compressor->GetMaximumCompressionSpace(data.size());
-            unsigned char* compressedDataBuffer = new unsigned char[compressedDataBufferLength];
+                              compressor->GetMaximumCompressionSpace(dataSizeInBytes);
+            std::vector<unsigned char> compressedDataBuffer(compressedDataBufferLength);
             unsigned long compressedDataLength =
-                          compressor->Compress(&data[0],
-                                               data.size(),
-                                               compressedDataBuffer,
+                          compressor->Compress(dataBytes,
+                                               dataSizeInBytes,
+                                               &compressedDataBuffer[0],
                                                compressedDataBufferLength);
-            compressor->Delete();
+            deleteZLibDataCompressor(compressor);
+            if (compressedDataLength == 0) {
+               throw FileException("", "Compression of Binary data failed.");
+            }
             
             //
             // Encode the data with VTK's Base64 algorithm
             //
-            char* buffer = new char[static_cast<long>(compressedDataLength * 1.5)];
-            const unsigned long compressedLength =
-               vtkBase64Utilities::Encode(compressedDataBuffer,
+            textOut.resize(((compressedDataLength + 2) / 3) * 4);
+            const unsigned long encodedLength =
+               vtkBase64Utilities::Encode(&compressedDataBuffer[0],
                                           compressedDataLength,
-                                          (unsigned char*)buffer);
-            buffer[compressedLength] = '\0';
+                                          (unsigned char*)textOut.data());
+            textOut.resize(encodedLength);
             
             if (DebugControl::getDebugOn()) {
-               if (compressedLength > 4) {
+               if (encodedLength > 4) {
                   std::cout << "Bytes: " 
-                            << (int)buffer[0] << " "
-                            << (int)buffer[1] << " "
-                            << (int)buffer[2] << " "
-                            << (int)buffer[3] << std::endl;
+                            << (int)textOut[0] << " "
+                            << (int)textOut[1] << " "
+                            << (int)textOut[2] << " "
+                            << (int)textOut[3] << std::endl;
                }
             }
-            
-            //
-            // Write the data
-            //
-            stream << buffer;
-            addCloseTagImmediatelyAfterData = true;
-            
-            //
-            // Free memory
-            //
-            delete[] buffer;
-            delete[] compressedDataBuffer;
          }
 #else  // HAVE_VTK
          throw FileException("No support for Base64 data since VTK not available at compile time.");
 #endif // HAVE_VTK
          break;
-      case ENCODING_EXTERNAL_FILE_BINARY:
-         {
-            const long dataLength = data.size();
-            externalBinaryOutputStream->write((const char*)&data[0], dataLength);
-            if (externalBinaryOutputStream->bad()) {
-               throw FileException("Output stream for external file reports its status as bad.");
-            }
-         }
-         break;
    }
-   
-   //
-   // Write the closing tag
-   //
-   indent--;
-   if (addCloseTagImmediatelyAfterData == false) {
-      GiftiCommon::writeIndentationXML(stream, indent);
-   }
-   stream << "</" << GiftiCommon::tagData << ">" << "\n";
-   
-   //
-   // write the closing data array tag
-   //
-   indent--;
-   GiftiCommon::writeIndentationXML(stream, indent);
-   stream << "</" << GiftiCommon::tagDataArray << ">" << "\n";
-}                      
+}
 
 /**
  * convert to data type.
@@ -1430,8 +2107,9 @@ GiftiDataArray::convertToDataType(const DATA_TYPE newDataType)
       }
       
       //
-      // make a copy of myself
+      // make a copy of myself (with data in memory)
       //
+      releaseRunLengthEncodedData(true);
       GiftiDataArray copyOfMe(*this);
       
       //
@@ -1509,6 +2187,7 @@ void
 GiftiDataArray::byteSwapData(const ENDIAN newEndian)
 {
 #ifdef HAVE_VTK
+   releaseRunLengthEncodedData(true);
    endian = newEndian;
    switch (dataType) {
       case DATA_TYPE_FLOAT32:
@@ -1549,10 +2228,18 @@ GiftiDataArray::getMinMaxValues(int& minValue, int& maxValue) const
       minValueInt = std::numeric_limits<int>::max();
       minValueInt = std::numeric_limits<int>::min();
       
-      long numItems = getTotalNumberOfElements();
-      for (long i = 0; i < numItems; i++) {
-         minValueInt = std::min(minValueInt, dataPointerInt[i]);
-         maxValueInt = std::max(maxValueInt, dataPointerInt[i]);
+      if (dataIsRunLengthEncoded) {
+         for (unsigned int i = 0; i < runLengthValues.size(); i++) {
+            minValueInt = std::min(minValueInt, runLengthValues[i]);
+            maxValueInt = std::max(maxValueInt, runLengthValues[i]);
+         }
+      }
+      else {
+         long numItems = getTotalNumberOfElements();
+         for (long i = 0; i < numItems; i++) {
+            minValueInt = std::min(minValueInt, dataPointerInt[i]);
+            maxValueInt = std::max(maxValueInt, dataPointerInt[i]);
+         }
       }
       minMaxIntValuesValid = true;
    }
@@ -1683,7 +2370,15 @@ GiftiDataArray::getMinMaxValuesFromPercentages(const float negMaxPctIn,
 void 
 GiftiDataArray::zeroize()
 {
-   if (data.empty() == false) {
+   if (mappedData != NULL) {
+      std::fill(mappedData, mappedData + mappedDataSizeInBytes, 0);
+   }
+   else if (dataIsRunLengthEncoded) {
+      const int32_t numElements = runLengthEnds.back();
+      runLengthEnds.assign(1, numElements);
+      runLengthValues.assign(1, 0);
+   }
+   else if (data.empty() == false) {
       std::fill(data.begin(), data.end(), 0);
    }
    metaData.clear();
@@ -1745,17 +2440,18 @@ int32_t
 GiftiDataArray::getDataInt32(const int indices[]) const
 {
    const long offset = getDataOffset(indices);
-   return dataPointerInt[offset];
+   return getDataInt32Element(offset);
 }
 
 /**
  * get an int value pointer (data type must be int and dimensionality of indices must be same as data).
+ * The data must not be run length encoded.
  */
 const int32_t* 
 GiftiDataArray::getDataInt32Pointer(const int indices[]) const
 {
    const long offset = getDataOffset(indices);
-   return &dataPointerInt[offset];
+   return &getDataPointerInt()[offset];
 }
 
 /**
@@ -1795,7 +2491,7 @@ void
 GiftiDataArray::setDataInt32(const int indices[], const int32_t dataValue) const
 {
    const long offset = getDataOffset(indices);
-   dataPointerInt[offset] = dataValue;
+   const_cast<GiftiDataArray*>(this)->setDataInt32Element(offset, dataValue);
 }
 
 /**
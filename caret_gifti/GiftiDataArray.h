@@ -39,6 +39,8 @@
 #include "GiftiMetaData.h"
 
 class GiftiDataArrayFile;
+class GiftiDataArrayFileMapping;
+class QByteArray;
 class QDomElement;
 class QTextStream;
 
@@ -119,6 +121,9 @@ class GiftiDataArray {
       // delete rows
       void deleteRows(const std::vector<int>& rowsToDelete);
       
+      // permute rows (row "i" moves to row "newRowIndices[i]")
+      void permuteRows(const std::vector<int>& newRowIndices);
+      
       // convert all data arrays to data type
       void convertToDataType(const DATA_TYPE newDataType);
       
@@ -137,8 +142,20 @@ class GiftiDataArray {
       /// get the dimensions
       std::vector<int> getDimensions() const { return dimensions; }
       
-      /// current size of the data (in bytes)
-      long getDataSizeInBytes() const { return data.size(); }
+      // current size of the data (in bytes) when in memory
+      long getDataSizeInBytes() const;
+
+      /// is the data in a memory mapped file (pages are read when first accessed)
+      bool getDataIsMemoryMapped() const { return (dataMapping != NULL); }
+
+      /// is the data run length encoded (expanded when a non-const pointer to the data is requested)
+      bool getDataIsRunLengthEncoded() const { return dataIsRunLengthEncoded; }
+      
+      // run length encode int data if it uses much less memory (returns true if data is run length encoded)
+      bool compressDataWithRunLengthEncoding();
+
+      // expand run length encoded data into memory
+      void expandRunLengthEncodedData();
 
       /// get a dimension
       int getDimension(const int dimIndex) const { return dimensions[dimIndex]; }
@@ -166,10 +183,38 @@ class GiftiDataArray {
                         const QString& externalFileNameForReading,
                         const long externalFileOffsetForReading) throw (FileException);
                                                
+      // read a data array's attributes from text but postpone decoding its 
+      // Base64 text until decodeBase64Text() and finishDeferredDecoding() are called
+      void readFromTextWithDeferredDecoding(const QString& dataEndianForReading,
+                        const ARRAY_SUBSCRIPTING_ORDER arraySubscriptingOrderForReading,
+                        const DATA_TYPE dataTypeForReading,
+                        const std::vector<int>& dimensionsForReading,
+                        const ENCODING encodingForReading) throw (FileException);
+                                               
+      // decode Base64 (or GZip Base64) text into the data (may be called  
+      // concurrently for different data arrays)
+      void decodeBase64Text(const QByteArray& text) throw (FileException);
+      
+      // finish reading a data array after its text was decoded by decodeBase64Text()
+      void finishDeferredDecoding() throw (FileException);
+      
+      // read a data array from a memory mapped file (data is not accessed until used)
+      void readFromMapping(GiftiDataArrayFileMapping* mappingIn,
+                           const qint64 dataOffsetInMapping,
+                           const ENDIAN dataEndianForReading,
+                           const ARRAY_SUBSCRIPTING_ORDER arraySubscriptingOrderForReading,
+                           const DATA_TYPE dataTypeForReading,
+                           const std::vector<int>& dimensionsForReading) throw (FileException);
+                                               
       // write the data as XML
       void writeAsXML(QTextStream& stream, 
                       const int indentOffset,
-                      std::ofstream* externalBinaryOutputStream) throw (FileException);
+                      std::ofstream* externalBinaryOutputStream,
+                      const QByteArray* encodedDataText = NULL) throw (FileException);
+               
+      // encode the data as Base64 (or GZip Base64) text for writeAsXML() (may
+      // be called concurrently for different data arrays)
+      void encodeDataAsBase64Text(QByteArray& textOut) const throw (FileException);
                
       // get the data type name
       static QString getDataTypeName(const DATA_TYPE dataType);
@@ -289,11 +334,24 @@ class GiftiDataArray {
       /// get pointer for floating point data (const method) (valid only if data type is FLOAT)
       const float* getDataPointerFloat() const { return dataPointerFloat; }
       
-      /// get pointer for integer data (valid only if data type is INT)
-      int32_t* getDataPointerInt() { return dataPointerInt; }
+      // get pointer for integer data (valid only if data type is INT)
+      int32_t* getDataPointerInt();
+      
+      // get pointer for integer data (const method) (valid only if data type is INT,
+      // NULL if run length encoded)
+      const int32_t* getDataPointerInt() const;
+      
+      // get an int value by its element index without expanding run length encoded data
+      int32_t getDataInt32Element(const long elementIndex) const;
       
-      /// get pointer for integer data (const method) (valid only if data type is INT)
-      const int32_t* getDataPointerInt() const { return dataPointerInt; }
+      // set an int value by its element index
+      void setDataInt32Element(const long elementIndex, const int32_t dataValue);
+      
+      // get all int values without expanding run length encoded data
+      void getDataInt32Elements(int32_t* valuesOut) const;
+      
+      // set all int values
+      void setDataInt32Elements(const int32_t* values);
       
       /// get pointer for unsigned byte data (valid only if data type is UBYTE)
       uint8_t* getDataPointerUByte() { return dataPointerUByte; }
@@ -375,6 +433,12 @@ class GiftiDataArray {
       // update the data pointers
       void updateDataPointers();
       
+      // stop using a memory mapped file for the data (optionally copying the data into memory)
+      void releaseMappedData(const bool copyDataIntoMemoryFlag);
+      
+      // stop run length encoding the data (optionally expanding the data into memory)
+      void releaseRunLengthEncodedData(const bool copyDataIntoMemoryFlag);
+      
       // byte swap the data (data read is different endian than this system)
       void byteSwapData(const ENDIAN newEndian);
       
@@ -387,9 +451,37 @@ class GiftiDataArray {
       /// convert array indexing order of data
       void convertArrayIndexingOrder() throw (FileException);
 
+      // convert data type and indexing order and update metadata after the data is read
+      void finishReadingData(const DATA_TYPE requiredDataType,
+                             const ARRAY_SUBSCRIPTING_ORDER arraySubscriptingOrderForReading) throw (FileException);
+
       /// the data
       std::vector<uint8_t> data;
       
+      /// memory mapped file containing the data (NULL if data is in "data")
+      GiftiDataArrayFileMapping* dataMapping;
+      
+      /// start of the data in the memory mapped file
+      uint8_t* mappedData;
+      
+      /// size of the data in the memory mapped file
+      long mappedDataSizeInBytes;
+      
+      /// data is run length encoded (in runLengthEnds/runLengthValues and not in "data")
+      bool dataIsRunLengthEncoded;
+      
+      /// element index one past the end of each run
+      std::vector<int32_t> runLengthEnds;
+      
+      /// value of each run
+      std::vector<int32_t> runLengthValues;
+      
+      /// data type required after deferred decoding
+      DATA_TYPE deferredRequiredDataType;
+      
+      /// array subscripting order of data awaiting deferred decoding
+      ARRAY_SUBSCRIPTING_ORDER deferredArraySubscriptingOrder;
+      
       /// size of one data type element
       uint32_t dataTypeSize;
       
@@ -23,11 +23,19 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <iostream>
 
 #include <set>
 #include <sstream>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif // _OPENMP
+
+#include <QDataStream>
+#include <QFile>
+#include <QMap>
 #include <QXmlSimpleReader>
 
 #include "DebugControl.h"
@@ -36,6 +44,7 @@
 #define __GIFTI_DATA_ARRAY_FILE_MAIN__
 #include "GiftiDataArrayFile.h"
 #undef __GIFTI_DATA_ARRAY_FILE_MAIN__
+#include "GiftiDataArrayFileMapping.h"
 #include "GiftiDataArrayFileStreamReader.h"
 #include "GiftiDataArrayFileSaxReader.h"
 #ifdef CARET_FLAG
@@ -276,8 +285,13 @@ GiftiDataArrayFile::compareFileForUnitTesting(const AbstractFile* af,
                   case GiftiDataArray::DATA_TYPE_INT32:
                      {
                         const int tol = static_cast<int32_t>(tolerance);
-                        const int32_t* p1 = gdf1->getDataPointerInt();
-                        const int32_t* p2 = gdf2->getDataPointerInt();
+                        std::vector<int32_t> values1(numElem), values2(numElem);
+                        if (numElem > 0) {
+                           gdf1->getDataInt32Elements(&values1[0]);
+                           gdf2->getDataInt32Elements(&values2[0]);
+                        }
+                        const int32_t* p1 = (numElem > 0) ? &values1[0] : NULL;
+                        const int32_t* p2 = (numElem > 0) ? &values2[0] : NULL;
                         for (int m = 0; m < numElem; m++) {
                            float diff = p1[m] - p2[m];
                            if (diff < 0.0) diff = -diff;
@@ -736,16 +750,18 @@ GiftiDataArrayFile::appendLabelDataHelper(const GiftiDataArrayFile& naf,
       if (nda->getDataType() == GiftiDataArray::DATA_TYPE_INT32) {
          const int numElem = nda->getTotalNumberOfElements();
          if (numElem >= 0) {
-            int32_t* dataPtr = nda->getDataPointerInt();
+            //
+            // Element access keeps run length encoded data compressed
+            //
             for (int i = 0; i < numElem; i++) {
-               const int indx = dataPtr[i];
+               const int indx = nda->getDataInt32Element(i);
                if ((indx >= 0) && (indx < numLabelsNew)) {
                   oldIndicesToNewIndicesTable[indx] = -2;
                }
                else {
                   std::cout << "WARNING Invalid label index set to zero: " << indx 
                             << " of " << numLabelsNew << " labels." << std::endl;
-                  dataPtr[i] = 0;
+                  nda->setDataInt32Element(i, 0);
                }
             }
          }
@@ -853,6 +869,9 @@ GiftiDataArrayFile::readFileData(QFile& file,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          readLegacyFileData(file, stream, binStream);
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         readFileDataColumnar(file);
+         break;
    }
    
    if (getReadMetaDataOnlyFlag() == false) {
@@ -912,6 +931,9 @@ GiftiDataArrayFile::writeFileData(QTextStream& stream,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          writeLegacyFileData(stream, binStream);
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         writeFileDataColumnar(binStream);
+         break;
    }
 }
 
@@ -1067,6 +1089,8 @@ GiftiDataArrayFile::writeFileDataXML(QTextStream& stream) throw (FileException)
          break;
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         break;
    }
    
    QString giftiFileVersionString = 
@@ -1134,17 +1158,75 @@ GiftiDataArrayFile::writeFileDataXML(QTextStream& stream) throw (FileException)
    labelTable.writeAsXML(stream, indent);
    indent--;   
    
+   //
+   // Arrays are written in batches.  Base64 (and GZip Base64) text for the
+   // arrays in a batch is encoded in parallel and then written in order.
+   //
+   const int numArrays = static_cast<int>(dataArrays.size());
+#ifdef _OPENMP
+   const int numArraysPerBatch = std::max(1, omp_get_max_threads() * 2);
+#else  // _OPENMP
+   const int numArraysPerBatch = 1;
+#endif // _OPENMP
+   
    indent++;
-   for (unsigned int i = 0; i < dataArrays.size(); i++) {
+   for (int batchStart = 0; batchStart < numArrays; batchStart += numArraysPerBatch) {
+      const int batchEnd = std::min(numArrays, batchStart + numArraysPerBatch);
+      const int numInBatch = batchEnd - batchStart;
+      
+      std::vector<bool> encodedFlags(numInBatch, false);
+      for (int i = batchStart; i < batchEnd; i++) {
 #ifdef CARET_FLAG
-      dataArrays[i]->setEncoding(encoding);
+         dataArrays[i]->setEncoding(encoding);
 #endif // CARET_FLAG
-      if (externalBinaryOutputStream != NULL) {
-          externalBinaryFileDataOffset = externalBinaryOutputStream->tellp();
+         switch (dataArrays[i]->getEncoding()) {
+            case GiftiDataArray::ENCODING_INTERNAL_ASCII:
+            case GiftiDataArray::ENCODING_EXTERNAL_FILE_BINARY:
+               break;
+            case GiftiDataArray::ENCODING_INTERNAL_BASE64_BINARY:
+            case GiftiDataArray::ENCODING_INTERNAL_COMPRESSED_BASE64_BINARY:
+               encodedFlags[i - batchStart] = true;
+               break;
+         }
+      }
+      
+      std::vector<QByteArray> encodedText(numInBatch);
+      std::vector<QString> errorMessages(numInBatch);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if (numInBatch > 1)
+#endif // _OPENMP
+      for (int j = 0; j < numInBatch; j++) {
+         if (encodedFlags[j]) {
+            try {
+               dataArrays[batchStart + j]->encodeDataAsBase64Text(encodedText[j]);
+            }
+            catch (FileException& e) {
+               errorMessages[j] = e.whatQString();
+            }
+         }
+      }
+      for (int j = 0; j < numInBatch; j++) {
+         if (errorMessages[j].isEmpty() == false) {
+            if (externalBinaryOutputStream != NULL) {
+               externalBinaryOutputStream->close();
+            }
+            throw FileException(errorMessages[j]);
+         }
+      }
+      
+      for (int i = batchStart; i < batchEnd; i++) {
+         if (externalBinaryOutputStream != NULL) {
+             externalBinaryFileDataOffset = externalBinaryOutputStream->tellp();
+         }
+         dataArrays[i]->setExternalFileInformation(externalBinaryFileName,
+                                                   externalBinaryFileDataOffset);
+         dataArrays[i]->writeAsXML(stream, 
+                                   indent, 
+                                   externalBinaryOutputStream,
+                                   (encodedFlags[i - batchStart] 
+                                       ? &encodedText[i - batchStart] 
+                                       : NULL));
       }
-      dataArrays[i]->setExternalFileInformation(externalBinaryFileName,
-                                                externalBinaryFileDataOffset);
-      dataArrays[i]->writeAsXML(stream, indent, externalBinaryOutputStream);
    }
    indent--;
    
@@ -1155,6 +1237,315 @@ GiftiDataArrayFile::writeFileDataXML(QTextStream& stream) throw (FileException)
    }
 }      
 
+/**
+ * Columnar binary files contain, in order:
+ *    a 64 byte header (identifier, version, number of data arrays,
+ *       index offset and length, endian of the array data),
+ *    an index (file metadata followed by each array's data offset, data
+ *       length, data type, subscripting order, intent, dimensions, metadata),
+ *    the data for each array starting on a 64 byte boundary.
+ * Header and index are written with QDataStream (big endian), the arrays
+ * are written in this system's byte order so that they may be used in place
+ * in a memory mapped file.
+ */
+static const int columnarBinaryHeaderSize = 64;
+static const int columnarBinaryDataAlignment = 64;
+
+/**
+ * round an offset in a columnar binary file up to the next data boundary.
+ */
+static qint64
+columnarBinaryAlignOffset(const qint64 offset)
+{
+   const qint64 remainder = offset % columnarBinaryDataAlignment;
+   if (remainder > 0) {
+      return offset + (columnarBinaryDataAlignment - remainder);
+   }
+   return offset;
+}
+
+/**
+ * convert GIFTI metadata to a map for QDataStream.
+ */
+static QMap<QString,QString>
+columnarBinaryMetaDataToMap(const GiftiMetaData& md)
+{
+   QMap<QString,QString> mapOut;
+   const GiftiMetaData::MetaDataContainer* data = md.getMetaData();
+   for (GiftiMetaData::ConstMetaDataIterator iter = data->begin(); iter != data->end(); iter++) {
+      mapOut.insert(iter->first, iter->second);
+   }
+   return mapOut;
+}
+
+/**
+ * read a columnar binary file.  Rather than reading the arrays, they are
+ * memory mapped so that the data of an array is read when it is first used.
+ */
+void 
+GiftiDataArrayFile::readFileDataColumnar(QFile& file) throw (FileException)
+{
+   //
+   // Read the header
+   //
+   file.seek(0);
+   const QByteArray headerBytes = file.read(columnarBinaryHeaderSize);
+   if (headerBytes.size() != columnarBinaryHeaderSize) {
+      throw FileException(filename, "Columnar binary file is too small to contain a header.");
+   }
+   QDataStream headerStream(headerBytes);
+   headerStream.setVersion(QDataStream::Qt_4_3);
+   headerStream.setByteOrder(QDataStream::BigEndian);
+   
+   const QByteArray id = getColumnarBinaryFileIdentifier().toAscii();
+   QByteArray idRead(id.size(), '\0');
+   headerStream.readRawData(idRead.data(), idRead.size());
+   if (idRead != id) {
+      throw FileException(filename, "Columnar binary file has an invalid identifier.");
+   }
+   qint32 version, numberOfArrays, endianValue;
+   qint64 indexOffset, indexLength;
+   headerStream >> version >> numberOfArrays >> indexOffset >> indexLength >> endianValue;
+   if (version > getCurrentColumnarBinaryFileVersion()) {
+      throw FileException(filename, 
+         "Columnar binary file version " + QString::number(version) + " is not supported.\n"
+         "Perhaps you need a newer version of Caret.");
+   }
+   if ((numberOfArrays < 0) ||
+       (indexOffset < columnarBinaryHeaderSize) ||
+       (indexLength < 0) ||
+       ((indexOffset + indexLength) > file.size())) {
+      throw FileException(filename, "Columnar binary file header is invalid.");
+   }
+   const GiftiDataArray::ENDIAN dataEndian = ((endianValue == GiftiDataArray::ENDIAN_BIG)
+                                              ? GiftiDataArray::ENDIAN_BIG
+                                              : GiftiDataArray::ENDIAN_LITTLE);
+   
+   //
+   // Read the index
+   //
+   file.seek(indexOffset);
+   const QByteArray indexBytes = file.read(indexLength);
+   if (indexBytes.size() != indexLength) {
+      throw FileException(filename, "Error reading columnar binary file index.");
+   }
+   QDataStream indexStream(indexBytes);
+   indexStream.setVersion(QDataStream::Qt_4_3);
+   indexStream.setByteOrder(QDataStream::BigEndian);
+   
+   //
+   // Transfer MetaData
+   //
+   QMap<QString,QString> fileMetaData;
+   indexStream >> fileMetaData;
+   metaData.clear();
+   for (QMap<QString,QString>::const_iterator iter = fileMetaData.constBegin();
+        iter != fileMetaData.constEnd(); iter++) {
+      metaData.set(iter.key(), iter.value());
+      setHeaderTag(iter.key(), iter.value());
+   }
+   
+   //
+   // Map the file, each array holds its own reference to the mapping 
+   //
+   GiftiDataArrayFileMapping* mapping = NULL;
+   if (getReadMetaDataOnlyFlag() == false) {
+      mapping = GiftiDataArrayFileMapping::mapFile(file.fileName());
+   }
+   
+   try {
+      for (int i = 0; i < numberOfArrays; i++) {
+         qint64 dataOffset, dataLength;
+         qint32 dataTypeValue, subscriptingOrderValue, numberOfDimensions;
+         QString intentName;
+         indexStream >> dataOffset >> dataLength 
+                     >> dataTypeValue >> subscriptingOrderValue
+                     >> intentName >> numberOfDimensions;
+         std::vector<int> dimensions;
+         for (int j = 0; j < numberOfDimensions; j++) {
+            qint32 dim;
+            indexStream >> dim;
+            dimensions.push_back(dim);
+         }
+         QMap<QString,QString> arrayMetaData;
+         indexStream >> arrayMetaData;
+         if (indexStream.status() != QDataStream::Ok) {
+            throw FileException(filename, "Columnar binary file index is truncated.");
+         }
+         if ((dataTypeValue < GiftiDataArray::DATA_TYPE_FLOAT32) ||
+             (dataTypeValue > GiftiDataArray::DATA_TYPE_UINT8)) {
+            throw FileException(filename, "Columnar binary file contains an invalid data type.");
+         }
+         
+         GiftiDataArray* gda = new GiftiDataArray(this, intentName);
+         GiftiMetaData* gmd = gda->getMetaData();
+         for (QMap<QString,QString>::const_iterator iter = arrayMetaData.constBegin();
+              iter != arrayMetaData.constEnd(); iter++) {
+            gmd->set(iter.key(), iter.value());
+         }
+         
+         if (mapping != NULL) {
+            try {
+               gda->readFromMapping(mapping,
+                                    dataOffset,
+                                    dataEndian,
+                                    static_cast<GiftiDataArray::ARRAY_SUBSCRIPTING_ORDER>(subscriptingOrderValue),
+                                    static_cast<GiftiDataArray::DATA_TYPE>(dataTypeValue),
+                                    dimensions);
+            }
+            catch (FileException&) {
+               delete gda;
+               throw;
+            }
+         }
+         addDataArray(gda);
+      }
+   }
+   catch (FileException&) {
+      if (mapping != NULL) {
+         mapping->unreference();
+      }
+      throw;
+   }
+   
+   if (mapping != NULL) {
+      mapping->unreference();
+   }
+}
+
+/**
+ * write a columnar binary file.
+ */
+void 
+GiftiDataArrayFile::writeFileDataColumnar(QDataStream& binStream) throw (FileException)
+{
+   if (dataAreIndicesIntoLabelTable) {
+      throw FileException(filename, 
+         "Columnar binary format is not supported for files containing a label table.");
+   }
+   
+#ifdef CARET_FLAG
+   //
+   // copy the Abstract File header into this file's metadata 
+   //
+   metaData.clear();
+   AbstractFileHeaderContainer::iterator headerIter;
+   for (headerIter = header.begin(); headerIter != header.end(); headerIter++) {
+      metaData.set(headerIter->first, headerIter->second);
+   }
+#endif // CARET_FLAG
+   
+   const int numArrays = getNumberOfDataArrays();
+   
+   //
+   // The index is created twice, first to get its size, which
+   // determines where the data begins, and then with the data offsets.
+   //
+   std::vector<qint64> dataOffsets(numArrays, 0);
+   QByteArray indexBytes;
+   for (int pass = 0; pass < 2; pass++) {
+      indexBytes.clear();
+      QDataStream indexStream(&indexBytes, QIODevice::WriteOnly);
+      indexStream.setVersion(QDataStream::Qt_4_3);
+      indexStream.setByteOrder(QDataStream::BigEndian);
+      indexStream << columnarBinaryMetaDataToMap(metaData);
+      
+      for (int i = 0; i < numArrays; i++) {
+         const GiftiDataArray* gda = dataArrays[i];
+         const std::vector<int> dimensions = gda->getDimensions();
+         indexStream << dataOffsets[i]
+                     << static_cast<qint64>(gda->getDataSizeInBytes())
+                     << static_cast<qint32>(gda->getDataType())
+                     << static_cast<qint32>(gda->getArraySubscriptingOrder())
+                     << gda->getIntent()
+                     << static_cast<qint32>(dimensions.size());
+         for (unsigned int j = 0; j < dimensions.size(); j++) {
+            indexStream << static_cast<qint32>(dimensions[j]);
+         }
+         indexStream << columnarBinaryMetaDataToMap(*gda->getMetaData());
+      }
+      
+      qint64 offset = columnarBinaryAlignOffset(columnarBinaryHeaderSize + indexBytes.size());
+      for (int i = 0; i < numArrays; i++) {
+         dataOffsets[i] = offset;
+         offset = columnarBinaryAlignOffset(offset + dataArrays[i]->getDataSizeInBytes());
+      }
+   }
+   
+   //
+   // Create the header
+   //
+   QByteArray headerBytes;
+   QDataStream headerStream(&headerBytes, QIODevice::WriteOnly);
+   headerStream.setVersion(QDataStream::Qt_4_3);
+   headerStream.setByteOrder(QDataStream::BigEndian);
+   const QByteArray id = getColumnarBinaryFileIdentifier().toAscii();
+   headerStream.writeRawData(id.constData(), id.size());
+   headerStream << static_cast<qint32>(getCurrentColumnarBinaryFileVersion())
+                << static_cast<qint32>(numArrays)
+                << static_cast<qint64>(columnarBinaryHeaderSize)
+                << static_cast<qint64>(indexBytes.size())
+                << static_cast<qint32>(GiftiDataArray::getSystemEndian());
+   headerBytes.append(QByteArray(columnarBinaryHeaderSize - headerBytes.size(), '\0'));
+   
+   //
+   // Write the header, the index, and the arrays 
+   //
+   binStream.writeRawData(headerBytes.constData(), headerBytes.size());
+   binStream.writeRawData(indexBytes.constData(), indexBytes.size());
+   qint64 position = columnarBinaryHeaderSize + indexBytes.size();
+   for (int i = 0; i < numArrays; i++) {
+      if (dataOffsets[i] > position) {
+         const QByteArray padding(dataOffsets[i] - position, '\0');
+         binStream.writeRawData(padding.constData(), padding.size());
+      }
+      const GiftiDataArray* gda = dataArrays[i];
+      const long numBytes = gda->getDataSizeInBytes();
+      const char* dataBytes = NULL;
+      std::vector<int32_t> expandedValues;
+      switch (gda->getDataType()) {
+         case GiftiDataArray::DATA_TYPE_FLOAT32:
+            dataBytes = (const char*)gda->getDataPointerFloat();
+            break;
+         case GiftiDataArray::DATA_TYPE_INT32:
+            if (gda->getDataIsRunLengthEncoded()) {
+               //
+               // Write from a temporary expansion of the runs
+               //
+               expandedValues.resize(numBytes / sizeof(int32_t));
+               if (expandedValues.empty() == false) {
+                  gda->getDataInt32Elements(&expandedValues[0]);
+                  dataBytes = (const char*)&expandedValues[0];
+               }
+            }
+            else {
+               dataBytes = (const char*)gda->getDataPointerInt();
+            }
+            break;
+         case GiftiDataArray::DATA_TYPE_UINT8:
+            dataBytes = (const char*)gda->getDataPointerUByte();
+            break;
+      }
+      if ((numBytes > 0) && (dataBytes != NULL)) {
+         if (binStream.writeRawData(dataBytes, numBytes) != numBytes) {
+            throw FileException(filename, "Error writing columnar binary file data.");
+         }
+      }
+      position = dataOffsets[i] + numBytes;
+   }
+}
+
+/**
+ * copy any data arrays in a memory mapped file into memory.
+ */
+void 
+GiftiDataArrayFile::copyMemoryMappedDataIntoMemory()
+{
+   for (unsigned int i = 0; i < dataArrays.size(); i++) {
+      dataArrays[i]->releaseMappedData(true);
+   }
+}
+
 /**
  * read legacy file format data.
  */
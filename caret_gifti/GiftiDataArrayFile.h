@@ -179,6 +179,15 @@ class GiftiDataArrayFile : public AbstractFile {
       /// get the current version for GiftiDataArrayFiles
       static float getCurrentFileVersion() { return 1.0; }
       
+      /// get the identifier at the start of a columnar binary file
+      static QString getColumnarBinaryFileIdentifier() { return "CaretCOL"; }
+      
+      /// get the current version for columnar binary files
+      static int getCurrentColumnarBinaryFileVersion() { return 1; }
+      
+      // copy any data arrays in a memory mapped file into memory
+      void copyMemoryMappedDataIntoMemory();
+      
       /// get the default data array intent
       QString getDefaultDataArrayIntent() const { return defaultDataArrayIntent; }
       
@@ -212,6 +221,12 @@ class GiftiDataArrayFile : public AbstractFile {
       // write the XML file
       virtual void writeFileDataXML(QTextStream& stream) throw (FileException);
       
+      // read a columnar binary file (arrays are memory mapped)
+      virtual void readFileDataColumnar(QFile& file) throw (FileException);
+      
+      // write a columnar binary file
+      virtual void writeFileDataColumnar(QDataStream& binStream) throw (FileException);
+      
       /// Read the contents of the file (header has already been read)
       virtual void readFileData(QFile& file,
                                 QTextStream& stream,
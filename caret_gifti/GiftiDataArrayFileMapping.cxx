@@ -0,0 +1,138 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <QGlobalStatic>
+#ifdef Q_OS_WIN32
+#define NOMINMAX
+#include <windows.h>
+#else  // Q_OS_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // Q_OS_WIN32
+
+#include <QFile>
+
+#include "GiftiDataArrayFileMapping.h"
+
+/**
+ * constructor.
+ */
+GiftiDataArrayFileMapping::GiftiDataArrayFileMapping(const QString& fileNameIn)
+   : referenceCount(1)
+{
+   fileName = fileNameIn;
+   mappedData = NULL;
+   mappedSizeInBytes = 0;
+}
+
+/**
+ * destructor.
+ */
+GiftiDataArrayFileMapping::~GiftiDataArrayFileMapping()
+{
+   if (mappedData != NULL) {
+#ifdef Q_OS_WIN32
+      UnmapViewOfFile(mappedData);
+#else  // Q_OS_WIN32
+      munmap(mappedData, mappedSizeInBytes);
+#endif // Q_OS_WIN32
+      mappedData = NULL;
+   }
+}
+
+/**
+ * map a file (reference count of mapping returned is one).
+ * The mapping is private so the data arrays may modify their
+ * data in place without altering the file.
+ */
+GiftiDataArrayFileMapping* 
+GiftiDataArrayFileMapping::mapFile(const QString& fileNameIn) throw (FileException)
+{
+   const qint64 fileSize = QFile(fileNameIn).size();
+   if (fileSize <= 0) {
+      throw FileException(fileNameIn, "Unable to memory map an empty file.");
+   }
+   
+   void* ptr = NULL;
+#ifdef Q_OS_WIN32
+   HANDLE fileHandle = CreateFileW((LPCWSTR)fileNameIn.utf16(),
+                                   GENERIC_READ,
+                                   FILE_SHARE_READ,
+                                   NULL,
+                                   OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL,
+                                   NULL);
+   if (fileHandle == INVALID_HANDLE_VALUE) {
+      throw FileException(fileNameIn, "Unable to open file for memory mapping.");
+   }
+   HANDLE mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+   if (mappingHandle != NULL) {
+      ptr = MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+      CloseHandle(mappingHandle);
+   }
+   CloseHandle(fileHandle);
+   if (ptr == NULL) {
+      throw FileException(fileNameIn, "Memory mapping of file failed.");
+   }
+#else  // Q_OS_WIN32
+   const int fd = open(QFile::encodeName(fileNameIn).constData(), O_RDONLY);
+   if (fd < 0) {
+      throw FileException(fileNameIn, "Unable to open file for memory mapping.");
+   }
+   ptr = mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (ptr == MAP_FAILED) {
+      throw FileException(fileNameIn, "Memory mapping of file failed.");
+   }
+#endif // Q_OS_WIN32
+
+   GiftiDataArrayFileMapping* mapping = new GiftiDataArrayFileMapping(fileNameIn);
+   mapping->mappedData = static_cast<uint8_t*>(ptr);
+   mapping->mappedSizeInBytes = fileSize;
+   return mapping;
+}
+
+/**
+ * add a reference to the mapping.
+ */
+void 
+GiftiDataArrayFileMapping::reference()
+{
+   referenceCount.ref();
+}
+
+/**
+ * remove a reference to the mapping (mapping is deleted with its last reference).
+ */
+void 
+GiftiDataArrayFileMapping::unreference()
+{
+   if (referenceCount.deref() == false) {
+      delete this;
+   }
+}
@@ -0,0 +1,87 @@
+#ifndef __GIFTI_DATA_ARRAY_FILE_MAPPING_H__
+#define __GIFTI_DATA_ARRAY_FILE_MAPPING_H__
+
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <QAtomicInt>
+#include <QString>
+
+#include <stdint.h>
+
+#include "FileException.h"
+
+/// A private (copy-on-write) memory mapping of an entire file that is shared,
+/// by reference count, among the data arrays whose data lies in the file.
+/// Pages are read from disk only when they are first touched and values
+/// written through the mapping never reach the file.
+class GiftiDataArrayFileMapping {
+   public:
+      // map a file (reference count of mapping returned is one)
+      static GiftiDataArrayFileMapping* mapFile(const QString& fileNameIn) throw (FileException);
+      
+      // add a reference to the mapping
+      void reference();
+      
+      // remove a reference to the mapping (mapping is deleted with its last reference)
+      void unreference();
+      
+      /// get the start of the mapped file
+      uint8_t* getData() const { return mappedData; }
+      
+      /// get the size of the mapped file
+      qint64 getSizeInBytes() const { return mappedSizeInBytes; }
+      
+      /// get the name of the mapped file
+      QString getFileName() const { return fileName; }
+      
+   private:
+      // constructor
+      GiftiDataArrayFileMapping(const QString& fileNameIn);
+      
+      // destructor
+      ~GiftiDataArrayFileMapping();
+      
+      // copy constructor (not implemented)
+      GiftiDataArrayFileMapping(const GiftiDataArrayFileMapping&);
+      
+      // assignment operator (not implemented)
+      GiftiDataArrayFileMapping& operator=(const GiftiDataArrayFileMapping&);
+      
+      /// name of the mapped file
+      QString fileName;
+      
+      /// start of the mapped file
+      uint8_t* mappedData;
+      
+      /// size of the mapped file
+      qint64 mappedSizeInBytes;
+      
+      /// number of data arrays using the mapping
+      QAtomicInt referenceCount;
+};
+
+#endif // __GIFTI_DATA_ARRAY_FILE_MAPPING_H__
@@ -26,6 +26,10 @@
 
 #include <iostream>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif // _OPENMP
+
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
@@ -53,6 +57,11 @@ GiftiDataArrayFileStreamReader::GiftiDataArrayFileStreamReader(QFile* file,
    this->numberOfDataArraysInFile = 0;
    this->dataArrayReadIndex = 0;
    this->giftiDataArrayReadListener = NULL;
+#ifdef _OPENMP
+   this->maximumNumberOfDeferredDataArrays = omp_get_max_threads() * 4;
+#else  // _OPENMP
+   this->maximumNumberOfDeferredDataArrays = 1;
+#endif // _OPENMP
 }
 
 /// For incrementally reading arrays
@@ -155,11 +164,70 @@ GiftiDataArrayFileStreamReader::readData() throw (FileException)
       }
    }
    
+   //
+   // Decode any arrays that are still waiting
+   //
+   if (error() == false) {
+      const QString errorMessage = decodeDeferredDataArrays();
+      if (errorMessage.isEmpty() == false) {
+         raiseError(errorMessage);
+      }
+   }
+   this->deferredDataArrays.clear();
+   this->deferredDataArraysText.clear();
+   
    if (error()) {
       throw FileException(errorString());
    }
 }
 
+/**
+ * decode the text of data arrays whose decoding was deferred.  The text
+ * of the arrays is decoded in parallel and then each array is finished
+ * in file order.  Returns an error message (empty if no errors).
+ */
+QString 
+GiftiDataArrayFileStreamReader::decodeDeferredDataArrays()
+{
+   const int numArrays = static_cast<int>(this->deferredDataArrays.size());
+   std::vector<QString> errorMessages(numArrays);
+   
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if (numArrays > 1)
+#endif // _OPENMP
+   for (int i = 0; i < numArrays; i++) {
+      try {
+         this->deferredDataArrays[i]->decodeBase64Text(this->deferredDataArraysText[i]);
+      }
+      catch (FileException& e) {
+         errorMessages[i] = e.whatQString();
+      }
+   }
+   
+   //
+   // Type conversion and metadata updates modify the file so do serially
+   //
+   QString errorMessage;
+   for (int i = 0; i < numArrays; i++) {
+      if (errorMessages[i].isEmpty()) {
+         try {
+            this->deferredDataArrays[i]->finishDeferredDecoding();
+         }
+         catch (FileException& e) {
+            errorMessages[i] = e.whatQString();
+         }
+      }
+      if (errorMessage.isEmpty()) {
+         errorMessage = errorMessages[i];
+      }
+   }
+   
+   this->deferredDataArrays.clear();
+   this->deferredDataArraysText.clear();
+   
+   return errorMessage;
+}
+
 /**
  * read GIFTI element.
  */
@@ -581,6 +649,7 @@ GiftiDataArrayFileStreamReader::readDataArray()
             readMetaData(dataArray->getMetaData());
          }
          else if (elemName == GiftiCommon::tagData) {
+            bool deferredDecodingFlag = false;
             try {
                 dataWasReadFlag = true;
                 if (this->giftiFile->getReadMetaDataOnlyFlag() == false) {
@@ -588,14 +657,32 @@ GiftiDataArrayFileStreamReader::readDataArray()
                    // Read the data
                    //
                    QString text = readElementText();
-                   dataArray->readFromText(text,
-                                           endianName,
+                   
+                   //
+                   // Base64 text is decoded later, with other arrays, in parallel
+                   //
+                   if ((this->giftiDataArrayReadListener == NULL) &&
+                       ((encodingForReadingArrayData == GiftiDataArray::ENCODING_INTERNAL_BASE64_BINARY) ||
+                        (encodingForReadingArrayData == GiftiDataArray::ENCODING_INTERNAL_COMPRESSED_BASE64_BINARY))) {
+                      dataArray->readFromTextWithDeferredDecoding(endianName,
                                            arraySubscriptingOrderForReadingArrayData,
                                            dataTypeForReadingArrayData,
                                            dimensionsForReadingArrayData,
-                                           encodingForReadingArrayData,
-                                           externalFileName,
-                                           externalFileOffsetForReadingData);
+                                           encodingForReadingArrayData);
+                      this->deferredDataArrays.push_back(dataArray);
+                      this->deferredDataArraysText.push_back(text.toAscii());
+                      deferredDecodingFlag = true;
+                   }
+                   else {
+                      dataArray->readFromText(text,
+                                              endianName,
+                                              arraySubscriptingOrderForReadingArrayData,
+                                              dataTypeForReadingArrayData,
+                                              dimensionsForReadingArrayData,
+                                              encodingForReadingArrayData,
+                                              externalFileName,
+                                              externalFileOffsetForReadingData);
+                   }
                 }
                
                 //
@@ -619,6 +706,18 @@ GiftiDataArrayFileStreamReader::readDataArray()
                raiseError(e.whatQString());
                return;
             }
+            
+            //
+            // Decode when enough arrays are waiting to keep all threads busy
+            //
+            if (deferredDecodingFlag &&
+                (static_cast<int>(this->deferredDataArrays.size()) >= this->maximumNumberOfDeferredDataArrays)) {
+               const QString errorMessage = decodeDeferredDataArrays();
+               if (errorMessage.isEmpty() == false) {
+                  raiseError(errorMessage);
+                  return;
+               }
+            }
          }
          else if (elemName == GiftiCommon::tagMatrix) {
             dataArray->addMatrix(GiftiMatrix());
@@ -27,10 +27,14 @@
  */
 /*LICENSE_END*/
 
+#include <vector>
+
+#include <QByteArray>
 #include <QXmlStreamReader>
 
 #include "FileException.h"
 
+class GiftiDataArray;
 class GiftiDataArrayFile;
 class GiftiDataArrayReadListener;
 class GiftiLabelTable;
@@ -72,6 +76,9 @@ class GiftiDataArrayFileStreamReader : QXmlStreamReader {
       // read the coordinate transform matrix
       void readCoordinateTransformMatrix(GiftiMatrix* matrix);
       
+      // decode the text of data arrays whose decoding was deferred
+      QString decodeDeferredDataArrays();
+      
       /// GIFTI Data Array File being read
       GiftiDataArrayFile* giftiFile;
 
@@ -83,6 +90,15 @@ class GiftiDataArrayFileStreamReader : QXmlStreamReader {
 
       /// increments as data arrays are read
       int dataArrayReadIndex;
+
+      /// data arrays whose Base64 text has not been decoded
+      std::vector<GiftiDataArray*> deferredDataArrays;
+      
+      /// Base64 text of data arrays whose decoding was deferred
+      std::vector<QByteArray> deferredDataArraysText;
+      
+      /// decode deferred data arrays when this many are waiting
+      int maximumNumberOfDeferredDataArrays;
 };
 
 #endif // __GIFTI_DATA_ARRAY_FILE_STREAM_READER_H__
@@ -531,6 +531,27 @@ GiftiNodeDataFile::addNodes(const int numberOfNodesToAdd)
    }
 }
 
+/**
+ * renumber the nodes (node "i" becomes node "newNodeNumbers[i]").
+ */
+void 
+GiftiNodeDataFile::renumberNodes(const std::vector<int>& newNodeNumbers) throw (FileException)
+{
+   if (static_cast<int>(newNodeNumbers.size()) != getNumberOfNodes()) {
+      throw FileException(FileUtilities::basename(getFileName())
+                          + " has "
+                          + QString::number(getNumberOfNodes())
+                          + " nodes but the node renumbering has "
+                          + QString::number(newNodeNumbers.size())
+                          + " nodes.");
+   }
+   
+   for (unsigned int i = 0; i < dataArrays.size(); i++) {
+      dataArrays[i]->permuteRows(newNodeNumbers);
+   }
+   setModified();
+}
+
 /**
  * get all of the column names.
  */
@@ -677,10 +698,10 @@ GiftiNodeDataFile::writeDataIntoCommaSeparatedValueFile(CommaSeparatedValueFile&
                break;
             case GiftiDataArray::DATA_TYPE_INT32:
                {
-                  const int32_t* data = gda->getDataPointerInt();
                   for (int i = 0; i < numNodes; i++) {
                      for (int k = 0; k < numComp; k++) {
-                        ct->setElement(i, colIndex + k, data[i*numComp+k]);
+                        ct->setElement(i, colIndex + k, 
+                                       gda->getDataInt32Element(i*numComp+k));
                      }
                   }
                }
@@ -855,6 +876,9 @@ GiftiNodeDataFile::readLegacyFileData(QFile& file,
             dataWasRead = true;
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }   
    
    if (dataWasRead == false) {
@@ -894,6 +918,9 @@ GiftiNodeDataFile::writeLegacyFileData(QTextStream& stream,
             dataWasWritten = true;
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }   
    
    if (dataWasWritten == false) {
@@ -65,6 +65,9 @@ class GiftiNodeDataFile : public GiftiDataArrayFile {
       // add nodes to this file
       void addNodes(const int numberOfNodesToAdd);
       
+      // renumber the nodes (node "i" becomes node "newNodeNumbers[i]")
+      void renumberNodes(const std::vector<int>& newNodeNumbers) throw (FileException);
+      
       // Clear the node data file.
       virtual void clear();
       
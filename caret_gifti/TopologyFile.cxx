@@ -28,9 +28,11 @@
 #define NOMINMAX
 #endif
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <stack>
+#include <utility>
 #include <QMutexLocker>
 
 #include "DebugControl.h"
@@ -1121,6 +1123,63 @@ TopologyFile::flipTileOrientation()
    topologyHelperNeedsRebuild = true;
 }
 
+/**
+ * Renumber the nodes (node "i" becomes node "newNodeNumbers[i]").  The
+ * tiles are also reordered by their lowest numbered node so that tiles
+ * sharing nodes remain near each other.
+ */
+void
+TopologyFile::renumberNodes(const std::vector<int>& newNodeNumbers) throw (FileException)
+{
+   const int numNodes = static_cast<int>(newNodeNumbers.size());
+   if (numNodes < numberOfNodes) {
+      throw FileException(FileUtilities::basename(getFileName())
+                          + " uses "
+                          + QString::number(numberOfNodes)
+                          + " nodes but the node renumbering has "
+                          + QString::number(numNodes)
+                          + " nodes.");
+   }
+   
+   const int numTiles = getNumberOfTiles();
+   if (numTiles > 0) {
+      //
+      // Change the tiles' vertices
+      //
+      dataArrays[0]->remapIntValues(newNodeNumbers);
+      
+      //
+      // Order the tiles by their lowest numbered vertex
+      //
+      std::vector<std::pair<int,int> > tileOrder(numTiles);
+      for (int i = 0; i < numTiles; i++) {
+         int v[3];
+         getTile(i, v);
+         tileOrder[i] = std::make_pair(std::min(v[0], std::min(v[1], v[2])), i);
+      }
+      std::sort(tileOrder.begin(), tileOrder.end());
+      std::vector<int> newTileIndices(numTiles);
+      for (int i = 0; i < numTiles; i++) {
+         newTileIndices[tileOrder[i].second] = i;
+      }
+      dataArrays[0]->permuteRows(newTileIndices);
+   }
+   
+   //
+   // Move the node sections
+   //
+   if (static_cast<int>(nodeSections.size()) == numNodes) {
+      std::vector<int> sections(numNodes);
+      for (int i = 0; i < numNodes; i++) {
+         sections[newNodeNumbers[i]] = nodeSections[i];
+      }
+      nodeSections = sections;
+   }
+   
+   setModified();
+   topologyHelperNeedsRebuild = true;
+}
+
 /**
  * Set the number of Topology Nodes (all zeros for data)
  */
@@ -1226,6 +1285,9 @@ TopologyFile::getTopologyHelper(const bool needEdgeInfo,
       topologyHelperNeedsRebuild = true;
    }
 
+   bool buildEdgeInfo = needEdgeInfo;
+   bool buildNodeInfo = needNodeInfo;
+   bool buildNodeInfoSorted = needNodeInfoSorted;
    if (topologyHelperNeedsRebuild == false) {
       if (needEdgeInfo) {
          if (topologyHelper->getEdgeInfoValid() == false) {
@@ -1242,13 +1304,24 @@ TopologyFile::getTopologyHelper(const bool needEdgeInfo,
             topologyHelperNeedsRebuild = true;
          }
       }
+      
+      //
+      // Topology has not changed so also keep the information already
+      // built to prevent users of different information from alternately 
+      // rebuilding the helper
+      //
+      if (topologyHelperNeedsRebuild) {
+         buildEdgeInfo = buildEdgeInfo || topologyHelper->getEdgeInfoValid();
+         buildNodeInfo = buildNodeInfo || topologyHelper->getNodeInfoValid();
+         buildNodeInfoSorted = buildNodeInfoSorted || topologyHelper->getNodeSortedInfoValid();
+      }
    }
    if (topologyHelperNeedsRebuild) {
       if (topologyHelper != NULL) {
          delete topologyHelper;
       }
-      topologyHelper = new TopologyHelper(this, needEdgeInfo, needNodeInfo, 
-                                          needNodeInfoSorted);
+      topologyHelper = new TopologyHelper(this, buildEdgeInfo, buildNodeInfo, 
+                                          buildNodeInfoSorted);
       topologyHelperNeedsRebuild = false;
    }
    
@@ -1318,6 +1391,28 @@ TopologyFile::setNumberOfTiles(const int numTiles)
    topologyHelperNeedsRebuild = true;
 }
 
+/**
+ * Set all of the tiles (3 vertices per tile).
+ */
+void
+TopologyFile::setAllTiles(const std::vector<int>& tilesIn)
+{
+   const int numTiles = tilesIn.size() / 3;
+   setNumberOfTiles(numTiles);
+   
+   int32_t* tiles = dataArrays[0]->getDataPointerInt();
+   int maxNode = -1;
+   for (int i = 0; i < (numTiles * 3); i++) {
+      tiles[i] = tilesIn[i];
+      maxNode = std::max(maxNode, tilesIn[i]);
+   }
+   // add one to node since node number range is [0..N-1]
+   numberOfNodes = std::max(maxNode + 1, numberOfNodes);
+   
+   setModified();
+   topologyHelperNeedsRebuild = true;
+}
+
 /**
  * see if the topology file is equivalent to this one (contains exact same tiles).
  */
@@ -1738,6 +1833,9 @@ TopologyFile::readFileDataVersion1(QFile& /*file*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
@@ -1852,6 +1950,9 @@ TopologyFile::writeLegacyFileData(QTextStream& stream, QDataStream& binStream)
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Comma Separated Value File Format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
    
 }
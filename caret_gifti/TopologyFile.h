@@ -161,6 +161,9 @@ class TopologyFile : public GiftiDataArrayFile {
       // flip the orientation of the tiles
       void flipTileOrientation();
       
+      // renumber the nodes (node "i" becomes node "newNodeNumbers[i]")
+      void renumberNodes(const std::vector<int>& newNodeNumbers) throw (FileException);
+      
       // get a Tile
       const int* getTile(const int indx) const;
       
@@ -188,6 +191,9 @@ class TopologyFile : public GiftiDataArrayFile {
       // set the number of tiles
       void setNumberOfTiles(const int numTiles);
       
+      // set all of the tiles (3 vertices per tile)
+      void setAllTiles(const std::vector<int>& tilesIn);
+      
       // set the number of nodes in coordinate files using this topology file
       void setNumberOfNodes(const int num);
       
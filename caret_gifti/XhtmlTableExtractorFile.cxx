@@ -443,6 +443,9 @@ XhtmlTableExtractorFile::readFileData(QFile& /*file*/,
       case FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
          throw FileException(filename, "Reading in Comma Separated Value File format not supported.");
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
    
    if (activeTableStack.empty() == false) {
@@ -488,6 +491,9 @@ XhtmlTableExtractorFile::writeFileData(QTextStream& stream,
             csvf.writeToTextStream(stream);
          }
          break;
+      case FILE_FORMAT_COLUMNAR_BINARY:
+         throw FileException(filename, "Columnar Binary File Format not supported.");
+         break;
    }
 }
 
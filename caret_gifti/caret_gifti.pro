@@ -24,6 +24,7 @@ HEADERS += AbstractFile.h \
       GiftiCommon.h \
       GiftiDataArray.h \
       GiftiDataArrayFile.h \
+      GiftiDataArrayFileMapping.h \
       GiftiDataArrayFileSaxReader.h \
       GiftiDataArrayFileStreamReader.h \
       GiftiLabelTable.h \
@@ -48,6 +49,7 @@ SOURCES += AbstractFile.cxx \
       GiftiCommon.cxx \
       GiftiDataArray.cxx \
       GiftiDataArrayFile.cxx \
+      GiftiDataArrayFileMapping.cxx \
       GiftiDataArrayFileSaxReader.cxx \
       GiftiDataArrayFileStreamReader.cxx \
       GiftiLabelTable.cxx \
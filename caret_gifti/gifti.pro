@@ -28,6 +28,7 @@ HEADERS += AbstractFile.h \
       GiftiCommon.h \
       GiftiDataArray.h \
       GiftiDataArrayFile.h \
+      GiftiDataArrayFileMapping.h \
       GiftiDataArrayFileSaxReader.h \
       GiftiDataArrayFileStreamReader.h \
       GiftiLabelTable.h \
@@ -44,6 +45,7 @@ SOURCES += AbstractFile.cxx \
       GiftiCommon.cxx \
       GiftiDataArray.cxx \
       GiftiDataArrayFile.cxx \
+      GiftiDataArrayFileMapping.cxx \
       GiftiDataArrayFileSaxReader.cxx \
       GiftiDataArrayFileStreamReader.cxx \
       GiftiLabelTable.cxx \
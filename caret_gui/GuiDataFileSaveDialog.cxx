@@ -2240,6 +2240,9 @@ GuiDataFileSaveDialog::slotLoadParametersForFileType()
          case AbstractFile::FILE_FORMAT_COMMA_SEPARATED_VALUE_FILE:
             text = "Comma Separated Value File";
             break;
+         case AbstractFile::FILE_FORMAT_COLUMNAR_BINARY:
+            text = "Columnar Binary File";
+            break;
       }
 
       if (preferredEncoding == encoding) {
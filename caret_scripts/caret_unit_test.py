@@ -86,6 +86,105 @@ def testStatistics() :
 
    return result
    
+##-----------------------------------------------------------------------------
+##
+## Test metric TFCE against volume TFCE
+##
+def testMetricTFCE() :
+   #
+   # Global variables
+   #
+   global cleanupOutputFilesFlag
+   global problemCount
+   global problemMessage
+   global progName
+   
+   #
+   # If only cleaning up output files we are done
+   #
+   if (cleanupOutputFilesFlag) :
+      return
+   
+   cmd = progName         \
+       + " -metric-TFCE-unit-test false "
+   print "cmd: %s" % (cmd)
+
+   #
+   # Run the command
+   #
+   result = os.system(cmd)
+   if (result != 0) :
+      problemCount += 1
+      problemMessage += ("Metric TFCE testing failed.\n")
+
+   return result
+   
+##-----------------------------------------------------------------------------
+##
+## Test marching cubes surface reconstruction
+##
+def testVolumeMarchingCubes() :
+   #
+   # Global variables
+   #
+   global cleanupOutputFilesFlag
+   global problemCount
+   global problemMessage
+   global progName
+   
+   #
+   # If only cleaning up output files we are done
+   #
+   if (cleanupOutputFilesFlag) :
+      return
+   
+   cmd = progName         \
+       + " -volume-marching-cubes-unit-test false "
+   print "cmd: %s" % (cmd)
+
+   #
+   # Run the command
+   #
+   result = os.system(cmd)
+   if (result != 0) :
+      problemCount += 1
+      problemMessage += ("Volume marching cubes testing failed.\n")
+
+   return result
+   
+##-----------------------------------------------------------------------------
+##
+## Test labeling connected components in volumes
+##
+def testVolumeConnectedComponents() :
+   #
+   # Global variables
+   #
+   global cleanupOutputFilesFlag
+   global problemCount
+   global problemMessage
+   global progName
+   
+   #
+   # If only cleaning up output files we are done
+   #
+   if (cleanupOutputFilesFlag) :
+      return
+   
+   cmd = progName         \
+       + " -volume-connected-components-unit-test false "
+   print "cmd: %s" % (cmd)
+
+   #
+   # Run the command
+   #
+   result = os.system(cmd)
+   if (result != 0) :
+      problemCount += 1
+      problemMessage += ("Volume connected components testing failed.\n")
+
+   return result
+   
 ##-----------------------------------------------------------------------------
 ##
 ## Test graphics rendering of surfaces and volumes
@@ -1013,6 +1112,9 @@ def printHelp() :
    print "   -segment      Test segmentation"
    print "   -stat-lib     Test statistical library"
    print "   -surf-stat    Test surface statistics"
+   print "   -tfce         Test metric TFCE against volume TFCE"
+   print "   -vol-label    Test labeling connected components in volumes"
+   print "   -vol-mc       Test marching cubes surface reconstruction"
    print "   "
    print "More than one option may be specified."
    
@@ -1041,6 +1143,9 @@ testSegmentationFlag = False
 testScenesFlag = False
 testStatsLibraryFlag = False
 testSurfaceStatisticsFlag = False
+testMetricTFCEFlag = False
+testVolumeMarchingCubesFlag = False
+testVolumeConnectedComponentsFlag = False
 
 doAllFlag = False
 
@@ -1075,6 +1180,12 @@ for i in range (1, numArgs) :
       testStatsLibraryFlag = True
    elif arg == "-surf-stat" :
       testSurfaceStatisticsFlag = True
+   elif arg == "-tfce" :
+      testMetricTFCEFlag = True
+   elif arg == "-vol-mc" :
+      testVolumeMarchingCubesFlag = True
+   elif arg == "-vol-label" :
+      testVolumeConnectedComponentsFlag = True
    else:
       print "ERROR Invalid option: ", arg
       os._exit(-1)
@@ -1089,6 +1200,9 @@ if doAllFlag :
    testSegmentationFlag = True
    testStatsLibraryFlag = True
    testSurfaceStatisticsFlag = True
+   testMetricTFCEFlag = True
+   testVolumeMarchingCubesFlag = True
+   testVolumeConnectedComponentsFlag = True
 
 print "Unit testing started"
 
@@ -1204,6 +1318,24 @@ if testSegmentationFlag :
    testSegmentation()
    os.chdir("..")
 
+#
+# Test metric TFCE against volume TFCE
+#
+if testMetricTFCEFlag :
+   testMetricTFCE()
+
+#
+# Test marching cubes surface reconstruction
+#
+if testVolumeMarchingCubesFlag :
+   testVolumeMarchingCubes()
+
+#
+# Test labeling connected components in volumes
+#
+if testVolumeConnectedComponentsFlag :
+   testVolumeConnectedComponents()
+
 print ""
 print "There were %s errors.  **************************************\n" % problemCount
 print "Unit Testing Completed."
@@ -31,6 +31,7 @@
 #include "StatisticPermutation.h"
 #include "StatisticRandomNumber.h"
 #include "StatisticRandomNumberOperator.h"
+#include "StatisticRandomNumberStream.h"
 
 /**
  * constructor.
@@ -40,6 +41,7 @@ StatisticPermutation::StatisticPermutation(const PERMUTATION_METHOD permutationM
 {
    permutationMethod = permutationMethodIn;
    outputDataGroup = NULL;
+   randomStream = NULL;
 }
 
 /**
@@ -86,10 +88,14 @@ StatisticPermutation::execute() throw (StatisticException)
       case PERMUTATION_METHOD_RANDOM_SIGN_FLIP:
          { 
             //
-            // randomly flip signs of values
+            // randomly flip signs of values (range is inclusive so
+            // zero and one are equally likely)
             //
             for (int i = 0; i < numValues; i++) {
-               if (StatisticRandomNumber::randomInteger(-1000, 1000) < 0) {
+               const int r = ((randomStream != NULL)
+                              ? randomStream->randomInteger(0, 1)
+                              : StatisticRandomNumber::randomInteger(0, 1));
+               if (r == 0) {
                   (*outputVector)[i] = -(*outputVector)[i];
                }
             }
@@ -100,10 +106,17 @@ StatisticPermutation::execute() throw (StatisticException)
             //
             // Randomly shuffle the values
             //
-            StatisticRandomNumberOperator randOp;
-            std::random_shuffle(outputVector->begin(),
-                                outputVector->end(),
-                                randOp);
+            if (randomStream != NULL) {
+               std::random_shuffle(outputVector->begin(),
+                                   outputVector->end(),
+                                   *randomStream);
+            }
+            else {
+               StatisticRandomNumberOperator randOp;
+               std::random_shuffle(outputVector->begin(),
+                                   outputVector->end(),
+                                   randOp);
+            }
          }
          break;
    }
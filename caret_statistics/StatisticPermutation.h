@@ -30,6 +30,7 @@
 #include "StatisticAlgorithm.h"
 
 class StatisticDataGroup;
+class StatisticRandomNumberStream;
 
 /// class for permuting a group of values
 class StatisticPermutation : public StatisticAlgorithm {
@@ -54,6 +55,9 @@ class StatisticPermutation : public StatisticAlgorithm {
       /// get the output
       const StatisticDataGroup* getOutputData() const { return outputDataGroup; }
       
+      /// set the stream used for random numbers (NULL uses the global stream)
+      void setRandomNumberStream(StatisticRandomNumberStream* randomStreamIn) { randomStream = randomStreamIn; }
+      
       /// generate a random integer
       static int randomInteger(const int minRandomValue,
                                const int maxRandomValue);
@@ -64,6 +68,9 @@ class StatisticPermutation : public StatisticAlgorithm {
       
       /// the permutation method
       PERMUTATION_METHOD permutationMethod;
+      
+      /// stream for random numbers (not owned, NULL if global stream used)
+      StatisticRandomNumberStream* randomStream;
 };
 
 #endif // __STATISTIC_PERMUTATION_H__
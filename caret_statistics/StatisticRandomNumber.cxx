@@ -28,28 +28,63 @@
 #include <cstdlib>
 
 #include "StatisticRandomNumber.h"
+#include "StatisticRandomNumberStream.h"
+
+/// seed of the global stream (same default as the C library)
+static unsigned int globalRandomSeed = 1;
+
+/// the global stream
+static StatisticRandomNumberStream globalRandomStream(globalRandomSeed, 0);
 
 /**
- * generate a random integer within the specified range.
+ * generate a random integer within the specified range (inclusive).
  */
 int 
 StatisticRandomNumber::randomInteger(const int minRandomValue,
                                      const int maxRandomValue)
 {
-   const double dm = maxRandomValue - minRandomValue;
-   int v = minRandomValue + static_cast<int>((dm * std::rand()/(RAND_MAX + 1.0)));  
+   int v = minRandomValue;
+#ifdef _OPENMP
+#pragma omp critical (StatisticRandomNumberGlobalStream)
+#endif
+   {
+      v = globalRandomStream.randomInteger(minRandomValue, maxRandomValue);
+   }
    return v;
 }
                          
 /**
- * generate a random unsigned integer within the specified range.
+ * generate a random unsigned integer within the specified range (inclusive).
  */
 int 
 StatisticRandomNumber::randomInteger(const unsigned int minRandomValue,
                                      const unsigned int maxRandomValue)
 {
-   const double dm = maxRandomValue - minRandomValue;
-   unsigned int v = minRandomValue + static_cast<unsigned int>((dm * std::rand()/(RAND_MAX + 1.0)));
+   const unsigned int dm = maxRandomValue - minRandomValue;
+   unsigned int offset = 0;
+#ifdef _OPENMP
+#pragma omp critical (StatisticRandomNumberGlobalStream)
+#endif
+   {
+      if (maxRandomValue > minRandomValue) {
+         if (dm == 0xFFFFFFFFU) {
+            offset = globalRandomStream.randomUnsignedInteger();
+         }
+         else {
+            //
+            // Reject values that would bias the result
+            //
+            const unsigned long long range = static_cast<unsigned long long>(dm) + 1;
+            const unsigned long long limit = (0x100000000ULL / range) * range;
+            unsigned long long r = globalRandomStream.randomUnsignedInteger();
+            while (r >= limit) {
+               r = globalRandomStream.randomUnsignedInteger();
+            }
+            offset = static_cast<unsigned int>(r % range);
+         }
+      }
+   }
+   unsigned int v = minRandomValue + offset;
    return v;
 }
 
@@ -60,18 +95,58 @@ float
 StatisticRandomNumber::randomFloat(const float minRandomValue,
                                    const float maxRandomValue)
 {
-   const double dm = maxRandomValue - minRandomValue;
-   float v = minRandomValue + ((dm * std::rand()/(RAND_MAX + 1.0)));
-   v = std::max(minRandomValue, v);
-   v = std::min(maxRandomValue, v);
+   float v = minRandomValue;
+#ifdef _OPENMP
+#pragma omp critical (StatisticRandomNumberGlobalStream)
+#endif
+   {
+      v = globalRandomStream.randomFloat(minRandomValue, maxRandomValue);
+   }
    return v;
 }
                                
 /**
- * set the seed for the random number generator.
+ * set the seed for the random number generator.  The C library generator
+ * is also seeded for code that still uses it directly.
  */
 void 
 StatisticRandomNumber::setRandomSeed(const int i)
 {
+#ifdef _OPENMP
+#pragma omp critical (StatisticRandomNumberGlobalStream)
+#endif
+   {
+      globalRandomSeed = static_cast<unsigned int>(i);
+      globalRandomStream = StatisticRandomNumberStream(globalRandomSeed, 0);
+   }
    std::srand(i);
 }
+
+/**
+ * get the seed for the random number generator.
+ */
+unsigned int 
+StatisticRandomNumber::getRandomSeed()
+{
+   return globalRandomSeed;
+}
+
+/**
+ * get a key for a family of streams.  The key is the next number from the
+ * global stream, so each permutation test started after setting the seed
+ * gets different but reproducible permutations.  Call it once, before
+ * any threads are started, and create a StatisticRandomNumberStream with
+ * the key and the index of each permutation.
+ */
+unsigned int 
+StatisticRandomNumber::getStreamKey()
+{
+   unsigned int key = 0;
+#ifdef _OPENMP
+#pragma omp critical (StatisticRandomNumberGlobalStream)
+#endif
+   {
+      key = globalRandomStream.randomUnsignedInteger();
+   }
+   return key;
+}
@@ -27,23 +27,33 @@
 #ifndef __STATISTIC_RANDOM_NUMBER_H__
 #define __STATISTIC_RANDOM_NUMBER_H__
 
-/// class for random number generation
+/// class for random number generation.  Numbers come from a single global
+/// stream shared by all callers.  Code that generates many permutations
+/// should create one StatisticRandomNumberStream per permutation, keyed by
+/// getStreamKey() and the permutation index, so results do not depend on
+/// the number of threads or the order permutations are computed.
 class StatisticRandomNumber {
    public:
       // generate a random integer within the specified range
       static float randomFloat(const float minRandomValue,
                                const float maxRandomValue);
                                
-      // generate a random integer within the specified range
+      // generate a random integer within the specified range (inclusive)
       static int randomInteger(const int minRandomValue,
                                const int maxRandomValue);
                                
-      // generate a random unsigned integer within the specified range
+      // generate a random unsigned integer within the specified range (inclusive)
       static int randomInteger(const unsigned int minRandomValue,
                                const unsigned int maxRandomValue);
                                
       // set the seed for the random number generator
       static void setRandomSeed(const int i);      
+      
+      // get the seed for the random number generator
+      static unsigned int getRandomSeed();
+      
+      // get a key for a family of streams (one number from the global stream)
+      static unsigned int getStreamKey();
 };
 
 #endif // __STATISTIC_RANDOM_NUMBER_H__
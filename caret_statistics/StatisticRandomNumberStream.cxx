@@ -0,0 +1,159 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+
+#include "StatisticRandomNumberStream.h"
+
+/**
+ * constructor.  Streams with the same key and stream index produce the
+ * same sequence of numbers.
+ */
+StatisticRandomNumberStream::StatisticRandomNumberStream(const unsigned int keyIn,
+                                                         const unsigned long long streamIndexIn)
+{
+   key = keyIn;
+   streamIndex = streamIndexIn;
+   blockCounter = 0;
+   blockIndex = 4;
+}
+
+/**
+ * destructor.
+ */
+StatisticRandomNumberStream::~StatisticRandomNumberStream()
+{
+}
+
+/**
+ * generate the next block of four random numbers (Philox4x32 with 10 rounds).
+ * The counter holds the block number and the stream index.
+ */
+void 
+StatisticRandomNumberStream::generateBlock()
+{
+   const unsigned int multiplier0 = 0xD2511F53U;
+   const unsigned int multiplier1 = 0xCD9E8D57U;
+   const unsigned int weyl0 = 0x9E3779B9U;
+   const unsigned int weyl1 = 0xBB67AE85U;
+   
+   unsigned int c[4] = {
+      static_cast<unsigned int>(blockCounter & 0xFFFFFFFFULL),
+      static_cast<unsigned int>(blockCounter >> 32),
+      static_cast<unsigned int>(streamIndex & 0xFFFFFFFFULL),
+      static_cast<unsigned int>(streamIndex >> 32)
+   };
+   unsigned int k0 = key;
+   unsigned int k1 = 0;
+   
+   for (int round = 0; round < 10; round++) {
+      const unsigned long long p0 = static_cast<unsigned long long>(multiplier0) * c[0];
+      const unsigned long long p1 = static_cast<unsigned long long>(multiplier1) * c[2];
+      const unsigned int hi0 = static_cast<unsigned int>(p0 >> 32);
+      const unsigned int lo0 = static_cast<unsigned int>(p0 & 0xFFFFFFFFULL);
+      const unsigned int hi1 = static_cast<unsigned int>(p1 >> 32);
+      const unsigned int lo1 = static_cast<unsigned int>(p1 & 0xFFFFFFFFULL);
+      c[0] = hi1 ^ c[1] ^ k0;
+      c[1] = lo1;
+      c[2] = hi0 ^ c[3] ^ k1;
+      c[3] = lo0;
+      k0 += weyl0;
+      k1 += weyl1;
+   }
+   
+   for (int i = 0; i < 4; i++) {
+      block[i] = c[i];
+   }
+   blockIndex = 0;
+   blockCounter++;
+}
+
+/**
+ * generate a random unsigned integer using all 32 bits.
+ */
+unsigned int 
+StatisticRandomNumberStream::randomUnsignedInteger()
+{
+   if (blockIndex >= 4) {
+      generateBlock();
+   }
+   const unsigned int v = block[blockIndex];
+   blockIndex++;
+   return v;
+}
+
+/**
+ * generate a random integer within the specified range (inclusive).
+ * Values that would bias the result are rejected.
+ */
+int 
+StatisticRandomNumberStream::randomInteger(const int minRandomValue,
+                                           const int maxRandomValue)
+{
+   const long long range = static_cast<long long>(maxRandomValue)
+                         - static_cast<long long>(minRandomValue) + 1;
+   if (range <= 1) {
+      return minRandomValue;
+   }
+   
+   const unsigned long long numValues = 0x100000000ULL;
+   const unsigned long long limit = (numValues / range) * range;
+   unsigned long long v = randomUnsignedInteger();
+   while (v >= limit) {
+      v = randomUnsignedInteger();
+   }
+   return static_cast<int>(minRandomValue + static_cast<long long>(v % range));
+}
+
+/**
+ * generate a random float within the specified range.
+ */
+float 
+StatisticRandomNumberStream::randomFloat(const float minRandomValue,
+                                         const float maxRandomValue)
+{
+   //
+   // Top 24 bits fill the float mantissa for a value in [0, 1)
+   //
+   const double unit = (randomUnsignedInteger() >> 8) * (1.0 / 16777216.0);
+   const double dm = maxRandomValue - minRandomValue;
+   float v = minRandomValue + dm * unit;
+   v = std::max(minRandomValue, v);
+   v = std::min(maxRandomValue, v);
+   return v;
+}
+
+/**
+ * random index in [0, maxNum) so stream can be used with std::random_shuffle.
+ */
+ptrdiff_t 
+StatisticRandomNumberStream::operator() (ptrdiff_t maxNum)
+{
+   if (maxNum <= 1) {
+      return 0;
+   }
+   return static_cast<ptrdiff_t>(randomInteger(0, static_cast<int>(maxNum - 1)));
+}
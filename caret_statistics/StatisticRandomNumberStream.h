@@ -0,0 +1,80 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#ifndef __STATISTIC_RANDOM_NUMBER_STREAM_H__
+#define __STATISTIC_RANDOM_NUMBER_STREAM_H__
+
+#include <cstddef>
+
+/// class for an independent stream of random numbers.  The generator is
+/// counter based (Philox4x32-10): the n'th number of a stream is a pure
+/// function of (key, stream index, n) so streams need no shared state,
+/// may be used concurrently by different threads, and give the same
+/// numbers no matter which thread or in which order they are created.
+class StatisticRandomNumberStream {
+   public:
+      // constructor
+      StatisticRandomNumberStream(const unsigned int keyIn,
+                                  const unsigned long long streamIndexIn);
+      
+      // destructor
+      ~StatisticRandomNumberStream();
+      
+      // generate a random unsigned integer using all 32 bits
+      unsigned int randomUnsignedInteger();
+      
+      // generate a random integer within the specified range (inclusive)
+      int randomInteger(const int minRandomValue,
+                        const int maxRandomValue);
+                        
+      // generate a random float within the specified range
+      float randomFloat(const float minRandomValue,
+                        const float maxRandomValue);
+                        
+      // random index in [0, maxNum) so stream can be used with std::random_shuffle
+      ptrdiff_t operator() (ptrdiff_t maxNum);
+      
+   protected:
+      // generate the next block of four random numbers
+      void generateBlock();
+      
+      /// key of the generator
+      unsigned int key;
+      
+      /// index of the stream
+      unsigned long long streamIndex;
+      
+      /// number of blocks generated
+      unsigned long long blockCounter;
+      
+      /// current block of random numbers
+      unsigned int block[4];
+      
+      /// index of next unused number in block
+      int blockIndex;
+};
+
+#endif // __STATISTIC_RANDOM_NUMBER_STREAM_H__
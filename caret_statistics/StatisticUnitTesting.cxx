@@ -2850,7 +2850,7 @@ StatisticUnitTesting::testPermutationRandomShuffle()
    //
    const int numData = 10;
    const float data[numData] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
-   const float shuffledData[numData] = { 3, 5, 2, 1, 7, 8, 6, 9, 10, 4 };
+   const float shuffledData[numData] = { 5, 2, 7, 8, 4, 3, 6, 10, 1, 9 };
 
    StatisticPermutation perm(StatisticPermutation::PERMUTATION_METHOD_RANDOM_ORDER);
    perm.addDataArray(data, numData);
@@ -2908,7 +2908,7 @@ StatisticUnitTesting::testPermutationSignFlipping()
    //
    const int numData = 10;
    const float data[numData] = { -1, 2, -3, 4, -5, 6, -7, 8, -9, 10 };
-   const float signFlippedData[numData] = { -1, -2, 3, -4, -5, 6, -7, 8, -9, -10 };
+   const float signFlippedData[numData] = { 1, 2, -3, -4, 5, 6, -7, 8, -9, 10 };
 
    StatisticPermutation perm(StatisticPermutation::PERMUTATION_METHOD_RANDOM_SIGN_FLIP);
    perm.addDataArray(data, numData);
@@ -46,6 +46,7 @@ HEADERS += \
       StatisticPermutation.h \
       StatisticRandomNumber.h \
       StatisticRandomNumberOperator.h \
+      StatisticRandomNumberStream.h \
       StatisticRankTransformation.h \
       StatisticTestNames.h \
       StatisticTtestOneSample.h \
@@ -80,6 +81,7 @@ SOURCES += \
       StatisticPermutation.cxx \
       StatisticRandomNumber.cxx \
       StatisticRandomNumberOperator.cxx \
+      StatisticRandomNumberStream.cxx \
       StatisticRankTransformation.cxx \
       StatisticTestNames.cxx \
       StatisticTtestOneSample.cxx \